@@ -2,11 +2,19 @@
 
 #include <Windows.h>
 #include <cstdint>
+#include <atomic>
+#include <chrono>
+#include <thread>
 #include <d3d12.h>
-#include <dxgi1_4.h>
+#include <dxgi1_5.h>
 #include <DirectXMath.h>
 #include <wrl/client.h>
 #include <d3dcompiler.h>
+#include "PipelineCache.h"
+#include "ShaderBundle.h"
+#include "GpuHeapAllocator.h"
+#include "FrameStats.h"
+#include "FramePacer.h"
 
 #pragma comment(lib, "d3d12.lib")
 #pragma comment(lib, "d3dcompiler.lib")
@@ -32,22 +40,20 @@ struct ConstantBufferView
 
 class App {
 public:
-	App(uint32_t width, uint32_t height);
-	~App();
+	// format̓obNobt@̌`(R8G8B8A8_UNORM̂ƂsRGB̃r[ŕ`)
+	App(uint32_t width, uint32_t height, DXGI_FORMAT format = DXGI_FORMAT_R8G8B8A8_UNORM, LATENCY_MODE latencyMode = LATENCY_MODE_LOW, uint32_t maxLatency = FramePacer::DefaultMaxLatency);
+	virtual ~App();
 	void Run();
 
-private:
+protected:
 	static const uint32_t FrameCount = 2;
-	HINSTANCE m_hInst;
-	HWND m_hWnd;
-	uint32_t m_Width;
-	uint32_t m_Height;
 
-	ComPtr<ID3D12Device> m_pDevice;
-	ComPtr<ID3D12CommandQueue> m_pQueue;
-	ComPtr<IDXGISwapChain3> m_pSwapChain;
+private:
+	HINSTANCE m_hInst;
+	DXGI_FORMAT m_BackBufferFormat; // obNobt@̌`
 	ComPtr<ID3D12Resource> m_pColorBuffer[FrameCount];
 	ComPtr<ID3D12Resource> m_pDepthBuffer;
+	GpuAllocation m_DepthAlloc;
 	ComPtr<ID3D12CommandAllocator> m_pCmdAllocator[FrameCount];
 	ComPtr<ID3D12GraphicsCommandList> m_pCmdList;
 	ComPtr<ID3D12DescriptorHeap> m_pHeapRTV;
@@ -55,25 +61,33 @@ private:
 
 	ComPtr<ID3D12Fence> m_pFence;
 	ComPtr<ID3D12DescriptorHeap> m_pHeapCBV;
-	ComPtr<ID3D12Resource> m_pVB;
-	ComPtr<ID3D12Resource> m_pIB;
-	ComPtr<ID3D12Resource> m_pCB[FrameCount * 2];
+	GpuBuffer m_VB;
+	GpuBuffer m_IB;
+	GpuBuffer m_CB[FrameCount * 2];
 
 	ComPtr<ID3D12RootSignature> m_pRootSignature;
 	ComPtr<ID3D12PipelineState> m_pPSO;
 
 	HANDLE m_FenceEvent = nullptr;
 	uint64_t m_FenceCounter[FrameCount];
-	uint32_t m_FrameIndex = 0;
 	D3D12_CPU_DESCRIPTOR_HANDLE m_HandleRTV[FrameCount];
 	D3D12_CPU_DESCRIPTOR_HANDLE m_HandleDSV;
 
 	D3D12_VERTEX_BUFFER_VIEW m_VBV;
 	D3D12_INDEX_BUFFER_VIEW m_IBV;
-	D3D12_VIEWPORT m_Viewport;
-	D3D12_RECT m_Scissor;
 	ConstantBufferView<Transform> m_CBV[FrameCount * 2];
 	float m_RotateAngle = 0.0f;
+	std::chrono::steady_clock::time_point m_LastFrameTime; // Õt[̏I
+	float m_FenceWaitMs = 0.0f; // ̃t[̃tFX҂[ms]
+	bool m_HasLastFrame = false; // Õt[̏I邩ǂ
+	uint64_t m_ColorBufferMemory[FrameCount] = {}; // obNobt@̃gpʂ̋L^ԍ
+	uint64_t m_ShaderBundleMemory = 0; // VF[_oh̃gpʂ̋L^ԍ
+	uint32_t m_OverBudget = 0; // \Z𒴂ĂJeS̃rbg}XN
+	HANDLE m_FrameLatencyWaitable = nullptr; // Xbv`FC̑ҋ@\IuWFNg(őxt[ƃVOi)
+	double m_FrameBeginMs = 0.0; // ̃t[̊Jn[ms](QueryPerformanceCounter)
+	FramePacer m_FramePacer; // Ԋu, eBAO, ҋ@\IuWFNg̑҂̔fƒx̏Wv
+	std::thread m_RenderThread; // `Xbh(CXbh̓EBhEbZ[W̏s)
+	std::atomic<bool> m_StopRender{ false }; // `Xbh̏Iv
 
 	
 
@@ -82,16 +96,44 @@ private:
 	bool InitWnd();
 	void TermWnd();
 	void MainLoop();
+	void RenderLoop(); // `Xbh̏
+	void StopRenderThread(); // `Xbh~߂(bZ[WȂI҂)
+	void UpdateFrameStats(std::chrono::steady_clock::time_point begin, std::chrono::steady_clock::time_point end); // t[Ԃ̋L^ƒo
+	void CheckMemoryBudgets(); // rfI̗\ZmFAVɒJeSo
+	void WaitFrameLatency(); // t[̊Jnɑҋ@\IuWFNg҂
+	void UpdateLatency(); // \ꂽ͂\܂ł̒xWv
 
 	bool InitD3D();
 	void TermD3D();
-	void Render();
 	void WaitGpu();
 
-	bool OnInit();
-	void OnTerm();
-
-	void Present(uint32_t interval); // \
-
 	static LRESULT CALLBACK WndProc(HWND hWnd, UINT msg, WPARAM wp, LPARAM lp);
+
+protected:
+	HWND m_hWnd;
+	uint32_t m_Width;
+	uint32_t m_Height;
+	ComPtr<ID3D12Device> m_pDevice;
+	ComPtr<ID3D12CommandQueue> m_pQueue;
+	ComPtr<IDXGISwapChain3> m_pSwapChain;
+	uint32_t m_FrameIndex = 0;
+	D3D12_VIEWPORT m_Viewport;
+	D3D12_RECT m_Scissor;
+	PipelineCache m_PipelineCache; // pCvCXe[gLbV
+	ShaderBundle m_ShaderBundle; // VF[_oCgR[h̃oh
+	GpuHeapAllocator m_HeapAllocator; // zu\[Xp̃q[vAP[^
+	FrameStats m_FrameStats; // t[Ԃ̓v
+	bool m_ShowFrameStats = true; // EBhẼ^Cgɓv\邩ǂ
+
+	// VF[_oCgR[h擾(ohɖ΃t@Cǂݍ, ppBlobێ)
+	bool LoadShader(const char* name, D3D12_SHADER_BYTECODE& bytecode, ID3DBlob** ppBlob);
+
+	void Present(uint32_t interval); // \(interval0ȂeBAOvł)
+	uint32_t GetSyncInterval() const; // x[hŌ܂\̓Ԋu(Presentɓn)
+
+	// hNXŏւ(͉]2̋``)
+	virtual bool OnInit(); // foCX̐ɃCXbhŌĂ΂
+	virtual void OnTerm(); // foCX̔jOɃCXbhŌĂ΂
+	virtual void OnRender(); // `XbhŖt[Ă΂(ŌPresentĂ)
+	virtual void OnMsgProc(HWND hWnd, UINT msg, WPARAM wp, LPARAM lp); // CXbhŃEBhEbZ[WƂɌĂ΂
 };
\ No newline at end of file
@@ -0,0 +1,371 @@
+﻿//-----------------------------------------------------------------------------
+// File : AsyncLogger.h
+// Desc : Asynchronous Lock-Free Logger.
+// Copyright(c) Pocol. All right reserved.
+//-----------------------------------------------------------------------------
+#pragma once
+
+//-----------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+
+///////////////////////////////////////////////////////////////////////////////
+// AsyncLogSite structure
+///////////////////////////////////////////////////////////////////////////////
+//! @note       ALOG の呼び出し箇所ごとに1つ静的に置かれ, 書式と流量制限の状態を持ちます.
+///////////////////////////////////////////////////////////////////////////////
+struct AsyncLogSite
+{
+    const char*             Format;         //!< 書式文字列です.
+    const char*             File;           //!< ファイル名です.
+    int                     Line;           //!< 行番号です.
+    std::atomic<uint64_t>   Window;         //!< 流量制限の現在の区間番号です.
+    std::atomic<uint32_t>   Count;          //!< 現在の区間で出力した数です.
+    std::atomic<uint32_t>   Suppressed;     //!< 現在の区間で捨てた数です.
+
+    //-------------------------------------------------------------------------
+    //! @brief      コンストラクタです.
+    //-------------------------------------------------------------------------
+    constexpr AsyncLogSite(const char* format, const char* file, int line)
+    : Format    (format)
+    , File      (file)
+    , Line      (line)
+    , Window    (UINT64_MAX)
+    , Count     (0)
+    , Suppressed(0)
+    { /* DO_NOTHING */ }
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// AsyncLogStats structure
+///////////////////////////////////////////////////////////////////////////////
+struct AsyncLogStats
+{
+    uint64_t    Written;        //!< 書き出したメッセージ数です.
+    uint64_t    Dropped;        //!< キューが一杯で捨てたメッセージ数です.
+    uint64_t    Suppressed;     //!< 流量制限で捨てたメッセージ数です.
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// AsyncLogger class
+///////////////////////////////////////////////////////////////////////////////
+//! @note       呼び出し側は書式文字列のポインタと引数を固定長のレコードに詰めて,
+//!             スレッドごとのリングバッファ(単一生産者・単一消費者)に積むだけです. ロックもメモリ確保もしません.
+//!             整形と書き出しはバックグラウンドスレッドが行います.
+//!             キューが一杯のときは待たずに捨てて数だけ数えます.
+//!             終了時と異常終了時(terminate, シグナル, 未処理例外)には残りを書き出します.
+///////////////////////////////////////////////////////////////////////////////
+class AsyncLogger
+{
+    //=========================================================================
+    // list of friend classes and methods.
+    //=========================================================================
+    /* NOTHING */
+
+public:
+    //=========================================================================
+    // public variables.
+    //=========================================================================
+    static const uint32_t MaxArgs           = 8;        //!< 1メッセージの引数の最大数です.
+    static const uint32_t TextSize          = 128;      //!< 文字列引数をコピーする領域のサイズです.
+    static const uint32_t RingSize          = 1024;     //!< スレッドごとのレコード数です(2のべき乗).
+    static const uint32_t DefaultRateLimit  = 32;       //!< 呼び出し箇所ごとの1秒あたりの既定の出力数です.
+    static const uint32_t FlushIntervalMs   = 5;        //!< バックグラウンドスレッドが書き出す間隔[ms]です.
+
+    //=========================================================================
+    // public methods.
+    //=========================================================================
+
+    //-------------------------------------------------------------------------
+    //! @brief      コンストラクタです.
+    //-------------------------------------------------------------------------
+    AsyncLogger();
+
+    //-------------------------------------------------------------------------
+    //! @brief      デストラクタです.
+    //-------------------------------------------------------------------------
+    ~AsyncLogger();
+
+    //-------------------------------------------------------------------------
+    //! @brief      バックグラウンドスレッドを開始します.
+    //!
+    //! @param[in]      path        書き出すファイルのパスです(nullptr可).
+    //! @param[in]      console     標準エラー出力(とデバッガ)にも書き出すかどうか.
+    //! @param[in]      handleCrash 異常終了時に書き出すハンドラを登録するかどうか.
+    //! @retval true    開始に成功.
+    //! @retval false   ファイルが開けなかった(コンソールへの出力は開始します).
+    //! @note       開始前に積んだメッセージは開始時に書き出します.
+    //-------------------------------------------------------------------------
+    bool Init(const char* path = nullptr, bool console = true, bool handleCrash = true);
+
+    //-------------------------------------------------------------------------
+    //! @brief      残りを書き出してバックグラウンドスレッドを終了します.
+    //-------------------------------------------------------------------------
+    void Term();
+
+    //-------------------------------------------------------------------------
+    //! @brief      積まれているメッセージをすべて書き出します.
+    //!
+    //! @note       呼び出したスレッドで整形と書き出しを行います.
+    //-------------------------------------------------------------------------
+    void Flush();
+
+    //-------------------------------------------------------------------------
+    //! @brief      待つ時間を限って, 積まれているメッセージをすべて書き出します.
+    //!
+    //! @param[in]      timeoutMs   他のスレッドの書き出しを待つ時間[ms]です.
+    //! @retval true    書き出した.
+    //! @retval false   他のスレッドが書き出し中で待ちきれなかった.
+    //! @note       異常終了時に, 止まったスレッドを待ち続けないために使います.
+    //-------------------------------------------------------------------------
+    bool TryFlush(uint32_t timeoutMs);
+
+    //-------------------------------------------------------------------------
+    //! @brief      呼び出し箇所ごとの1秒あたりの出力数の上限を設定します.
+    //!
+    //! @param[in]      count       上限です(0なら制限しません).
+    //-------------------------------------------------------------------------
+    void SetRateLimit(uint32_t count);
+
+    //-------------------------------------------------------------------------
+    //! @brief      統計を取得します.
+    //-------------------------------------------------------------------------
+    AsyncLogStats GetStats() const;
+
+    //-------------------------------------------------------------------------
+    //! @brief      メッセージを積みます.
+    //!
+    //! @param[in]      site        呼び出し箇所です(静的な寿命が必要です).
+    //! @param[in]      args        書式の引数です(整数, 浮動小数点数, ポインタ, 文字列).
+    //! @note       文字列引数は TextSize に収まる分だけコピーします.
+    //-------------------------------------------------------------------------
+    template<typename... Args>
+    void Write(AsyncLogSite& site, Args... args)
+    {
+        static_assert(sizeof...(Args) <= MaxArgs, "Too many arguments for AsyncLogger.");
+
+        auto pRecord = BeginRecord(site);
+        if (pRecord == nullptr)
+        { return; }
+
+        int dummy[] = { 0, (PackArg(*pRecord, args), 0)... };
+        (void)dummy;
+
+        EndRecord();
+    }
+
+private:
+    ///////////////////////////////////////////////////////////////////////////
+    // ARG_TYPE enum
+    ///////////////////////////////////////////////////////////////////////////
+    enum ARG_TYPE : uint8_t
+    {
+        ARG_TYPE_INT = 0,       //!< 符号付き整数です.
+        ARG_TYPE_UINT,          //!< 符号無し整数です.
+        ARG_TYPE_DOUBLE,        //!< 浮動小数点数です.
+        ARG_TYPE_POINTER,       //!< ポインタです.
+        ARG_TYPE_STRING,        //!< コピーした文字列です(値はテキスト領域内のオフセット).
+    };
+
+    ///////////////////////////////////////////////////////////////////////////
+    // Record structure
+    ///////////////////////////////////////////////////////////////////////////
+    struct Record
+    {
+        AsyncLogSite*   pSite;                  //!< 呼び出し箇所です.
+        uint64_t        Time;                   //!< 積んだ時刻[ns]です.
+        uint32_t        ThreadId;               //!< スレッド番号です.
+        uint32_t        Suppressed;             //!< 直前の区間で流量制限により捨てた数です.
+        uint8_t         ArgCount;               //!< 引数の数です.
+        uint8_t         TextUsed;               //!< テキスト領域の使用量です.
+        uint8_t         Types[MaxArgs];         //!< 引数の種類です.
+        uint8_t         Sizes[MaxArgs];         //!< 引数の元のサイズ[byte]です.
+        uint64_t        Args[MaxArgs];          //!< 引数の値です.
+        char            Text[TextSize];         //!< 文字列引数のコピー先です.
+    };
+
+    ///////////////////////////////////////////////////////////////////////////
+    // Ring structure
+    ///////////////////////////////////////////////////////////////////////////
+    struct Ring
+    {
+        alignas(64) std::atomic<uint32_t>   Head;       //!< 書き込み位置です(生産者のみ更新).
+        alignas(64) std::atomic<uint32_t>   Tail;       //!< 読み込み位置です(消費者のみ更新).
+        std::atomic<bool>                   Orphaned;   //!< 生産者のスレッドが終了したかどうか.
+        uint32_t                            ThreadId;   //!< 生産者のスレッド番号です.
+        Record                              Records[RingSize];  //!< レコードです.
+    };
+
+    ///////////////////////////////////////////////////////////////////////////
+    // RingOwner structure
+    ///////////////////////////////////////////////////////////////////////////
+    struct RingOwner
+    {
+        Ring*   pRing = nullptr;    //!< このスレッドのリングです.
+
+        //---------------------------------------------------------------------
+        //! @brief      スレッド終了時にリングを手放します.
+        //---------------------------------------------------------------------
+        ~RingOwner()
+        {
+            if (pRing != nullptr)
+            { pRing->Orphaned.store(true, std::memory_order_release); }
+        }
+    };
+
+    //=========================================================================
+    // private variables.
+    //=========================================================================
+    std::vector<std::unique_ptr<Ring>>  m_Rings;            //!< 全スレッドのリングです.
+    std::mutex                          m_RingMutex;        //!< リングの登録用ミューテックスです.
+    std::timed_mutex                    m_DrainMutex;       //!< 消費者を1つにするためのミューテックスです.
+    std::mutex                          m_WakeMutex;        //!< 待機用ミューテックスです.
+    std::condition_variable             m_Wake;             //!< 終了要求の通知です.
+    std::thread                         m_Thread;           //!< 書き出しスレッドです.
+    bool                                m_Stop;             //!< 終了要求フラグです.
+    bool                                m_Console;          //!< コンソールにも書き出すかどうか.
+    FILE*                               m_pFile;            //!< 出力ファイルです.
+    std::atomic<uint32_t>               m_RateLimit;        //!< 1秒あたりの出力数の上限です.
+    std::atomic<uint32_t>               m_NextThreadId;     //!< 次のスレッド番号です.
+    std::atomic<uint64_t>               m_Written;          //!< 書き出したメッセージ数です.
+    std::atomic<uint64_t>               m_Dropped;          //!< キューが一杯で捨てたメッセージ数です.
+    std::atomic<uint64_t>               m_Suppressed;       //!< 流量制限で捨てたメッセージ数です.
+    uint64_t                            m_ReportedDropped;  //!< 報告済みの捨てたメッセージ数です.
+    std::vector<Record>                 m_Batch;            //!< 書き出し用の作業領域です.
+    std::string                         m_Line;             //!< 整形用の作業領域です.
+
+    static thread_local RingOwner       s_Owner;            //!< このスレッドのリングです.
+
+    //=========================================================================
+    // private methods.
+    //=========================================================================
+
+    //-------------------------------------------------------------------------
+    //! @brief      流量制限を確認します.
+    //!
+    //! @param[in,out]  site        呼び出し箇所です.
+    //! @param[in]      time        現在時刻[ns]です.
+    //! @param[out]     suppressed  前の区間で捨てた数の格納先です.
+    //! @retval true    出力してよい.
+    //! @retval false   上限を超えたので捨てる.
+    //-------------------------------------------------------------------------
+    bool Admit(AsyncLogSite& site, uint64_t time, uint32_t& suppressed);
+
+    //-------------------------------------------------------------------------
+    //! @brief      流量制限を確認し, このスレッドのリングの書き込み先を取得します.
+    //!
+    //! @return     捨てる場合とリングが一杯の場合は nullptr を返却します.
+    //-------------------------------------------------------------------------
+    Record* BeginRecord(AsyncLogSite& site);
+
+    //-------------------------------------------------------------------------
+    //! @brief      このスレッドのリングを登録します.
+    //-------------------------------------------------------------------------
+    Ring* RegisterRing();
+
+    //-------------------------------------------------------------------------
+    //! @brief      書き込んだレコードを公開します.
+    //-------------------------------------------------------------------------
+    void EndRecord();
+
+    //-------------------------------------------------------------------------
+    //! @brief      全リングのレコードを取り出して書き出します.
+    //-------------------------------------------------------------------------
+    void Drain();
+
+    //-------------------------------------------------------------------------
+    //! @brief      レコードを1行に整形します.
+    //-------------------------------------------------------------------------
+    void Format(const Record& record, std::string& line) const;
+
+    //-------------------------------------------------------------------------
+    //! @brief      1行を書き出します.
+    //-------------------------------------------------------------------------
+    void Output(const std::string& line);
+
+    //-------------------------------------------------------------------------
+    //! @brief      バックグラウンドスレッドの処理です.
+    //-------------------------------------------------------------------------
+    void ThreadProc();
+
+    //-------------------------------------------------------------------------
+    //! @brief      文字列をテキスト領域にコピーします.
+    //-------------------------------------------------------------------------
+    static void PackString(Record& record, const char* value);
+
+    //-------------------------------------------------------------------------
+    //! @brief      ワイド文字列をテキスト領域にコピーします(ASCII以外は '?' にします).
+    //-------------------------------------------------------------------------
+    static void PackString(Record& record, const wchar_t* value);
+
+    //-------------------------------------------------------------------------
+    //! @brief      引数の種類と値を設定します.
+    //-------------------------------------------------------------------------
+    static void SetArg(Record& record, ARG_TYPE type, uint64_t value, size_t size)
+    {
+        record.Types[record.ArgCount] = type;
+        record.Sizes[record.ArgCount] = uint8_t(size);
+        record.Args [record.ArgCount] = value;
+        record.ArgCount++;
+    }
+
+    //-------------------------------------------------------------------------
+    //! @brief      引数をレコードに詰めます.
+    //-------------------------------------------------------------------------
+    template<typename T>
+    static void PackArg(Record& record, T value)
+    {
+        if constexpr (std::is_same<T, const char*>::value    || std::is_same<T, char*>::value
+                   || std::is_same<T, const wchar_t*>::value || std::is_same<T, wchar_t*>::value)
+        { PackString(record, value); }
+        else if constexpr (std::is_floating_point<T>::value)
+        {
+            double   v = double(value);
+            uint64_t bits;
+            memcpy(&bits, &v, sizeof(bits));
+            SetArg(record, ARG_TYPE_DOUBLE, bits, sizeof(v));
+        }
+        else if constexpr (std::is_pointer<T>::value)
+        { SetArg(record, ARG_TYPE_POINTER, uint64_t(reinterpret_cast<uintptr_t>(value)), sizeof(value)); }
+        else if constexpr (std::is_enum<T>::value || std::is_signed<T>::value)
+        { SetArg(record, ARG_TYPE_INT, uint64_t(int64_t(value)), sizeof(value)); }
+        else
+        {
+            static_assert(std::is_integral<T>::value, "Unsupported argument type for AsyncLogger.");
+            SetArg(record, ARG_TYPE_UINT, uint64_t(value), sizeof(value));
+        }
+    }
+
+    AsyncLogger         (const AsyncLogger&) = delete;
+    void operator =     (const AsyncLogger&) = delete;
+};
+
+//-----------------------------------------------------------------------------
+//! @brief      プロセス全体で共有する非同期ロガーを取得します.
+//-----------------------------------------------------------------------------
+AsyncLogger& GetAsyncLogger();
+
+//-----------------------------------------------------------------------------
+//! @brief      描画スレッドやワーカーから呼び出すエラーログです.
+//!
+//! @note       ELOG と同じ書式で使えます. 呼び出し側では整形も書き出しも行いません.
+//-----------------------------------------------------------------------------
+#ifndef ALOG
+#define ALOG(format, ...)                                                       \
+    do {                                                                        \
+        static AsyncLogSite s_AsyncLogSite_(format, __FILE__, __LINE__);        \
+        GetAsyncLogger().Write(s_AsyncLogSite_, ##__VA_ARGS__);                 \
+    } while(0)
+#endif//ALOG
@@ -0,0 +1,193 @@
+﻿//-----------------------------------------------------------------------------
+// File : AsyncPipelineCompiler.h
+// Desc : Asynchronous Pipeline State Compiler.
+// Copyright(c) Pocol. All right reserved.
+//-----------------------------------------------------------------------------
+#pragma once
+
+//-----------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------
+#include <d3d12.h>
+#include <wrl/client.h>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <PipelineCache.h>
+
+
+//-----------------------------------------------------------------------------
+// Type Definitions.
+//-----------------------------------------------------------------------------
+using PipelineHandle = uint32_t;
+
+//-----------------------------------------------------------------------------
+// Constant Values.
+//-----------------------------------------------------------------------------
+constexpr PipelineHandle INVALID_PIPELINE_HANDLE = UINT32_MAX;  //!< 無効なハンドルです.
+
+///////////////////////////////////////////////////////////////////////////////
+// PIPELINE_STATUS enum
+///////////////////////////////////////////////////////////////////////////////
+enum PIPELINE_STATUS
+{
+    PIPELINE_STATUS_INVALID = 0,    //!< 無効なハンドルです.
+    PIPELINE_STATUS_PENDING,        //!< コンパイル待ちまたはコンパイル中です.
+    PIPELINE_STATUS_READY,          //!< 使用可能です.
+    PIPELINE_STATUS_FAILED,         //!< 生成に失敗しました.
+};
+
+
+///////////////////////////////////////////////////////////////////////////////
+// AsyncPipelineCompiler class
+///////////////////////////////////////////////////////////////////////////////
+class AsyncPipelineCompiler
+{
+    //=========================================================================
+    // list of friend classes and methods.
+    //=========================================================================
+    /* NOTHING */
+
+public:
+    ///////////////////////////////////////////////////////////////////////////
+    // Stats structure
+    ///////////////////////////////////////////////////////////////////////////
+    struct Stats
+    {
+        uint32_t    QueueDepth;         //!< 未完了の要求数です.
+        uint32_t    Completed;          //!< 完了した要求数です.
+        uint32_t    Failed;             //!< 失敗した要求数です.
+        double      LastLatencyMs;      //!< 直近の要求から完了までの時間[ms]です.
+        double      AverageLatencyMs;   //!< 要求から完了までの平均時間[ms]です.
+        double      MaxLatencyMs;       //!< 要求から完了までの最大時間[ms]です.
+    };
+
+    //=========================================================================
+    // public variables.
+    //=========================================================================
+    /* NOTHING */
+
+    //=========================================================================
+    // public methods.
+    //=========================================================================
+
+    //-------------------------------------------------------------------------
+    //! @brief      コンストラクタです.
+    //-------------------------------------------------------------------------
+    AsyncPipelineCompiler();
+
+    //-------------------------------------------------------------------------
+    //! @brief      デストラクタです.
+    //-------------------------------------------------------------------------
+    ~AsyncPipelineCompiler();
+
+    //-------------------------------------------------------------------------
+    //! @brief      初期化処理を行います.
+    //!
+    //! @param[in]      pCache          パイプラインステートキャッシュです.
+    //! @param[in]      threadCount     ワーカースレッド数です(0なら自動).
+    //! @retval true    初期化に成功.
+    //! @retval false   初期化に失敗.
+    //-------------------------------------------------------------------------
+    bool Init(PipelineCache* pCache, uint32_t threadCount = 0);
+
+    //-------------------------------------------------------------------------
+    //! @brief      終了処理を行います. 実行中のコンパイルの完了を待ちます.
+    //-------------------------------------------------------------------------
+    void Term();
+
+    //-------------------------------------------------------------------------
+    //! @brief      グラフィックスパイプラインステートの生成を要求します.
+    //!
+    //! @param[in]      desc            パイプラインステートの設定です.
+    //! @param[in]      rootSigHash     ルートシグニチャのハッシュ値です.
+    //! @param[in]      fallback        準備完了までに代わりに使用するパイプラインです.
+    //! @return     ハンドルを直ちに返却します.
+    //! @note       設定が参照するデータ(シェーダ, 入力レイアウト等)は内部に複製されます.
+    //!             複数のスレッドから同時に呼び出せます.
+    //-------------------------------------------------------------------------
+    PipelineHandle Request(
+        const D3D12_GRAPHICS_PIPELINE_STATE_DESC&   desc,
+        uint64_t                                    rootSigHash,
+        PipelineHandle                              fallback = INVALID_PIPELINE_HANDLE);
+
+    //-------------------------------------------------------------------------
+    //! @brief      完了したコンパイルを反映します. 1フレームに1回呼び出します.
+    //!
+    //! @note       Poll(), Get(), GetStatus(), GetStats() は描画スレッドから呼び出します.
+    //-------------------------------------------------------------------------
+    void Poll();
+
+    //-------------------------------------------------------------------------
+    //! @brief      描画に使用するパイプラインステートを取得します.
+    //!
+    //! @param[in]      handle      ハンドルです.
+    //! @return     準備できていなければフォールバックを, それも無ければ nullptr を返却します.
+    //-------------------------------------------------------------------------
+    ID3D12PipelineState* Get(PipelineHandle handle) const;
+
+    //-------------------------------------------------------------------------
+    //! @brief      状態を取得します.
+    //-------------------------------------------------------------------------
+    PIPELINE_STATUS GetStatus(PipelineHandle handle) const;
+
+    //-------------------------------------------------------------------------
+    //! @brief      統計を取得します.
+    //-------------------------------------------------------------------------
+    const Stats& GetStats() const;
+
+private:
+    ///////////////////////////////////////////////////////////////////////////
+    // Entry structure
+    ///////////////////////////////////////////////////////////////////////////
+    struct Entry
+    {
+        D3D12_GRAPHICS_PIPELINE_STATE_DESC                  Desc;           //!< 複製した設定です.
+        Microsoft::WRL::ComPtr<ID3D12RootSignature>         pRootSig;       //!< ルートシグニチャです.
+        std::vector<uint8_t>                                Shaders[5];     //!< VS, PS, DS, HS, GS のバイトコードです.
+        std::vector<D3D12_INPUT_ELEMENT_DESC>               Elements;       //!< 入力要素です.
+        std::vector<D3D12_SO_DECLARATION_ENTRY>             SOEntries;      //!< ストリーム出力要素です.
+        std::vector<UINT>                                   SOStrides;      //!< ストリーム出力のストライドです.
+        std::deque<std::string>                             Names;          //!< セマンティクス名です.
+        uint64_t                                            RootSigHash;    //!< ルートシグニチャのハッシュ値です.
+        PipelineHandle                                      Fallback;       //!< フォールバックです.
+        std::chrono::steady_clock::time_point               SubmitTime;     //!< 要求時刻です.
+        double                                              LatencyMs;      //!< 要求から完了までの時間です.
+        HRESULT                                             Result;         //!< 生成結果です.
+        Microsoft::WRL::ComPtr<ID3D12PipelineState>         pCompiled;      //!< ワーカーが生成したパイプラインです.
+        Microsoft::WRL::ComPtr<ID3D12PipelineState>         pPSO;           //!< 反映済みのパイプラインです.
+        PIPELINE_STATUS                                     Status;         //!< 反映済みの状態です.
+    };
+
+    //=========================================================================
+    // private variables.
+    //=========================================================================
+    PipelineCache*                          m_pCache;       //!< パイプラインステートキャッシュです.
+    std::vector<std::unique_ptr<Entry>>     m_Entries;      //!< 要求です(m_EntryMutex で保護).
+    mutable std::mutex                      m_EntryMutex;   //!< 要求の一覧を保護するミューテックスです.
+    std::vector<std::thread>                m_Threads;      //!< ワーカースレッドです.
+    std::deque<Entry*>                      m_Queue;        //!< コンパイル待ちの要求です.
+    std::vector<Entry*>                     m_Finished;     //!< 未反映の完了済み要求です.
+    std::mutex                              m_Mutex;        //!< ミューテックスです.
+    std::condition_variable                 m_Condition;    //!< 条件変数です.
+    bool                                    m_Stop;         //!< 終了要求フラグです.
+    double                                  m_TotalLatency; //!< 完了までの時間の合計です.
+    Stats                                   m_Stats;        //!< 統計です.
+
+    //=========================================================================
+    // private methods.
+    //=========================================================================
+
+    //-------------------------------------------------------------------------
+    //! @brief      ワーカースレッドの処理です.
+    //-------------------------------------------------------------------------
+    void WorkerThread();
+
+    AsyncPipelineCompiler   (const AsyncPipelineCompiler&) = delete;
+    void operator =         (const AsyncPipelineCompiler&) = delete;
+};
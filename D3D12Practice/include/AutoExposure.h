@@ -0,0 +1,144 @@
+﻿//-----------------------------------------------------------------------------
+// File : AutoExposure.h
+// Desc : Histogram Based Auto Exposure.
+// Copyright(c) Pocol. All right reserved.
+//-----------------------------------------------------------------------------
+#pragma once
+
+//-----------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------
+#include <d3d12.h>
+#include <wrl/client.h>
+#include <AutoExposureCPU.h>
+#include <ConstantBuffer.h>
+#include <DescriptorPool.h>
+#include <PipelineCache.h>
+#include <RootSignature.h>
+
+
+///////////////////////////////////////////////////////////////////////////////
+// AutoExposure class
+///////////////////////////////////////////////////////////////////////////////
+//! @note       1パス目でシーンの輝度ヒストグラムを作り, 2パス目で露光値を求めて順応させます.
+//!             結果はGPUバッファに書き込まれ, トーンマップがそのまま参照します(CPUへの読み戻しはありません).
+///////////////////////////////////////////////////////////////////////////////
+class AutoExposure
+{
+    //=========================================================================
+    // list of friend classes and methods.
+    //=========================================================================
+    /* NOTHING */
+
+public:
+    //=========================================================================
+    // public variables.
+    //=========================================================================
+    static const uint32_t FrameCount = 2;   //!< 定数バッファのバッファリング数です.
+
+    //=========================================================================
+    // public methods.
+    //=========================================================================
+
+    //-------------------------------------------------------------------------
+    //! @brief      コンストラクタです.
+    //-------------------------------------------------------------------------
+    AutoExposure();
+
+    //-------------------------------------------------------------------------
+    //! @brief      デストラクタです.
+    //-------------------------------------------------------------------------
+    ~AutoExposure();
+
+    //-------------------------------------------------------------------------
+    //! @brief      初期化処理を行います.
+    //!
+    //! @param[in]      pDevice         デバイスです.
+    //! @param[in]      pPoolRes        リソース用ディスクリプタプールです.
+    //! @param[in]      pCache          パイプラインステートキャッシュです.
+    //! @param[in]      histogramCS     ヒストグラム作成用コンピュートシェーダです.
+    //! @param[in]      adaptCS         露光値の順応用コンピュートシェーダです.
+    //! @retval true    初期化に成功.
+    //! @retval false   初期化に失敗.
+    //-------------------------------------------------------------------------
+    bool Init(
+        ID3D12Device*                   pDevice,
+        DescriptorPool*                 pPoolRes,
+        PipelineCache*                  pCache,
+        const D3D12_SHADER_BYTECODE&    histogramCS,
+        const D3D12_SHADER_BYTECODE&    adaptCS);
+
+    //-------------------------------------------------------------------------
+    //! @brief      終了処理を行います.
+    //-------------------------------------------------------------------------
+    void Term();
+
+    //-------------------------------------------------------------------------
+    //! @brief      ヒストグラムの作成と露光値の順応を記録します.
+    //!
+    //! @param[in]      pCmd        コマンドリストです.
+    //! @param[in]      handleScene シーンカラーのSRVです(NON_PIXEL_SHADER_RESOURCE を含む状態であること).
+    //! @param[in]      width       シーンカラーの横幅です.
+    //! @param[in]      height      シーンカラーの縦幅です.
+    //! @param[in]      deltaTime   前フレームからの経過時間[s]です.
+    //! @param[in]      frameIndex  フレーム番号です.
+    //-------------------------------------------------------------------------
+    void Dispatch(
+        ID3D12GraphicsCommandList*  pCmd,
+        D3D12_GPU_DESCRIPTOR_HANDLE handleScene,
+        uint32_t                    width,
+        uint32_t                    height,
+        float                       deltaTime,
+        uint32_t                    frameIndex);
+
+    //-------------------------------------------------------------------------
+    //! @brief      次のフレームで順応せずに目標値へ合わせます.
+    //-------------------------------------------------------------------------
+    void Reset();
+
+    //-------------------------------------------------------------------------
+    //! @brief      設定を取得します.
+    //-------------------------------------------------------------------------
+    ExposureSettings& GetSettings();
+
+    //-------------------------------------------------------------------------
+    //! @brief      露光バッファ(ExposureState)のSRVを取得します.
+    //!
+    //! @note       露光バッファはピクセルシェーダとコンピュートシェーダの両方から読める状態にしてあります.
+    //-------------------------------------------------------------------------
+    D3D12_GPU_DESCRIPTOR_HANDLE GetHandleSRV() const;
+
+private:
+    //=========================================================================
+    // private variables.
+    //=========================================================================
+    ExposureSettings                                m_Settings;             //!< 設定です.
+    Microsoft::WRL::ComPtr<ID3D12Resource>          m_pHistogram;           //!< ヒストグラムバッファです.
+    Microsoft::WRL::ComPtr<ID3D12Resource>          m_pExposure;            //!< 露光バッファです.
+    uint64_t                                        m_MemoryId;             //!< メモリ使用量の記録番号です.
+    Microsoft::WRL::ComPtr<ID3D12PipelineState>     m_pHistogramPSO;        //!< ヒストグラム作成用パイプラインステートです.
+    Microsoft::WRL::ComPtr<ID3D12PipelineState>     m_pAdaptPSO;            //!< 露光値の順応用パイプラインステートです.
+    RootSignature                                   m_RootSig;              //!< ルートシグニチャです.
+    ConstantBuffer                                  m_CB[FrameCount];       //!< 定数バッファです.
+    DescriptorPool*                                 m_pPool;                //!< ディスクリプタプールです.
+    DescriptorHandle*                               m_pHandleHistogramUAV;  //!< ヒストグラムバッファのUAVです.
+    DescriptorHandle*                               m_pHandleExposureUAV;   //!< 露光バッファのUAVです.
+    DescriptorHandle*                               m_pHandleExposureSRV;   //!< 露光バッファのSRVです.
+    bool                                            m_Reset;                //!< 次のフレームで目標値へ合わせるかどうか.
+
+    //=========================================================================
+    // private methods.
+    //=========================================================================
+
+    //-------------------------------------------------------------------------
+    //! @brief      UAV用のバッファを生成します.
+    //-------------------------------------------------------------------------
+    static bool CreateBuffer(
+        ID3D12Device*           pDevice,
+        uint64_t                size,
+        D3D12_RESOURCE_STATES   state,
+        ID3D12Resource**        ppResource);
+
+    AutoExposure        (const AutoExposure&) = delete;
+    void operator =     (const AutoExposure&) = delete;
+};
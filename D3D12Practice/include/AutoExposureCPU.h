@@ -0,0 +1,137 @@
+﻿//-----------------------------------------------------------------------------
+// File : AutoExposureCPU.h
+// Desc : Histogram Based Auto Exposure (CPU Reference).
+// Copyright(c) Pocol. All right reserved.
+//-----------------------------------------------------------------------------
+#pragma once
+
+//-----------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------
+#include <cstdint>
+
+
+//-----------------------------------------------------------------------------
+// Constant Values.
+//-----------------------------------------------------------------------------
+constexpr uint32_t  EXPOSURE_BIN_COUNT          = 256;  //!< ヒストグラムのビン数です.
+constexpr uint32_t  EXPOSURE_BINS_PER_OCTAVE    = 16;   //!< 1段(2倍)あたりのビン数です.
+constexpr uint32_t  EXPOSURE_BIN_SHIFT          = 19;   //!< 輝度のビット列からビン番号への右シフト量です(23 - log2(16)).
+constexpr int32_t   EXPOSURE_EV_ONE             = 4096; //!< 露光値の固定小数の1段です.
+constexpr int32_t   EXPOSURE_RATE_SHIFT         = 12;   //!< 順応率の固定小数の小数部のビット数です.
+constexpr int32_t   EXPOSURE_RATE_ONE           = 1 << EXPOSURE_RATE_SHIFT; //!< 順応率の固定小数の1です.
+constexpr uint32_t  EXPOSURE_MAX_PIXELS         = 1u << 24; //!< 整数演算がオーバーフローしない最大ピクセル数です.
+
+
+///////////////////////////////////////////////////////////////////////////////
+// ExposureSettings structure
+///////////////////////////////////////////////////////////////////////////////
+struct ExposureSettings
+{
+    bool    Enable          = true;     //!< 自動露出を有効にするかどうか(無効時は補正値のみ).
+    int32_t MinLogLuminance = -12;      //!< ヒストグラムの最小輝度の log2 です(範囲は16段).
+    float   KeyValue        = 0.18f;    //!< 平均輝度をこの値に合わせます.
+    float   Compensation    = 0.0f;     //!< 露光補正値[EV]です.
+    float   LowPercent      = 0.5f;     //!< 平均から除外する暗い側の割合です.
+    float   HighPercent     = 0.95f;    //!< 平均に含める明るい側の上限の割合です.
+    float   MinEV           = -8.0f;    //!< 露光値の下限[EV]です.
+    float   MaxEV           = 8.0f;     //!< 露光値の上限[EV]です.
+    float   SpeedToDark     = 1.5f;     //!< 暗所への順応速度(露光を上げる側)[1/s]です.
+    float   SpeedToLight    = 3.0f;     //!< 明所への順応速度(露光を下げる側)[1/s]です.
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// CbExposure structure
+///////////////////////////////////////////////////////////////////////////////
+//! @note       シェーダの CbExposure と同じ並びです. 整数で渡して計算を一致させます.
+///////////////////////////////////////////////////////////////////////////////
+struct CbExposure
+{
+    uint32_t    Width;              //!< 入力画像の横幅です.
+    uint32_t    Height;             //!< 入力画像の縦幅です.
+    uint32_t    MinLuminanceBits;   //!< ヒストグラムの最小輝度のビット列です.
+    uint32_t    LowCount;           //!< 平均から除外する暗い側のピクセル数です.
+    uint32_t    HighCount;          //!< 平均に含める明るい側の上限のピクセル数です.
+    int32_t     MinLogLuminance;    //!< ヒストグラムの最小輝度の log2 を固定小数にしたものです.
+    int32_t     KeyLogValue;        //!< キー値と補正値の log2 を固定小数にしたものです.
+    int32_t     MinEV;              //!< 露光値の下限(固定小数)です.
+    int32_t     MaxEV;              //!< 露光値の上限(固定小数)です.
+    int32_t     RateToDark;         //!< 暗所への順応率(固定小数)です.
+    int32_t     RateToLight;        //!< 明所への順応率(固定小数)です.
+    uint32_t    Flags;              //!< EXPOSURE_FLAG の組み合わせです.
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// EXPOSURE_FLAG enum
+///////////////////////////////////////////////////////////////////////////////
+enum EXPOSURE_FLAG
+{
+    EXPOSURE_FLAG_ENABLE    = 0x1,  //!< ヒストグラムから露光値を求めます.
+    EXPOSURE_FLAG_RESET     = 0x2,  //!< 順応せずに目標値へ直ちに合わせます.
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// ExposureState structure
+///////////////////////////////////////////////////////////////////////////////
+//! @note       GPU の露光バッファと同じ並びです.
+///////////////////////////////////////////////////////////////////////////////
+struct ExposureState
+{
+    int32_t     EV;                     //!< 現在の露光値(固定小数)です.
+    int32_t     TargetEV;               //!< 目標の露光値(固定小数)です.
+    int32_t     AverageLogLuminance;    //!< 平均輝度の log2 (固定小数)です.
+    float       Exposure;               //!< トーンマップで乗算する露光です(= 2^EV).
+};
+
+//-----------------------------------------------------------------------------
+//! @brief      シェーダに渡す定数を求めます.
+//!
+//! @param[in]      settings    設定です.
+//! @param[in]      width       入力画像の横幅です.
+//! @param[in]      height      入力画像の縦幅です.
+//! @param[in]      deltaTime   前フレームからの経過時間[s]です.
+//! @param[in]      reset       順応せずに目標値へ合わせるかどうか.
+//! @return     定数を返却します.
+//! @note       浮動小数の計算はここで済ませ, シェーダ側は整数演算だけにします.
+//-----------------------------------------------------------------------------
+CbExposure MakeExposureConstants(
+    const ExposureSettings& settings,
+    uint32_t                width,
+    uint32_t                height,
+    float                   deltaTime,
+    bool                    reset);
+
+//-----------------------------------------------------------------------------
+//! @brief      ピクセルのヒストグラムのビン番号を求めます.
+//!
+//! @param[in]      constants   定数です.
+//! @param[in]      rgb         線形RGBです.
+//! @return     ビン番号を返却します.
+//! @note       浮動小数のビット列を区分線形の log2 として使います. luminance_histogram_c.hlsl と一致します.
+//-----------------------------------------------------------------------------
+uint32_t GetExposureBin(const CbExposure& constants, const float rgb[3]);
+
+//-----------------------------------------------------------------------------
+//! @brief      輝度ヒストグラムを作成します.
+//!
+//! @param[in]      constants   定数です.
+//! @param[in]      pPixels     RGBA32F のピクセルです(Width * Height).
+//! @param[out]     histogram   ヒストグラムの格納先です.
+//-----------------------------------------------------------------------------
+void BuildExposureHistogram(
+    const CbExposure&   constants,
+    const float*        pPixels,
+    uint32_t            histogram[EXPOSURE_BIN_COUNT]);
+
+//-----------------------------------------------------------------------------
+//! @brief      ヒストグラムから露光値を求め, 時間方向に順応させます.
+//!
+//! @param[in]      constants   定数です.
+//! @param[in]      histogram   ヒストグラムです.
+//! @param[in,out]  state       露光の状態です.
+//! @note       exposure_adapt_c.hlsl と同じ整数演算です. Exposure 以外はビット単位で一致します.
+//-----------------------------------------------------------------------------
+void AdaptExposure(
+    const CbExposure&   constants,
+    const uint32_t      histogram[EXPOSURE_BIN_COUNT],
+    ExposureState&      state);
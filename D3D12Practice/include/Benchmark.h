@@ -0,0 +1,217 @@
+﻿//-----------------------------------------------------------------------------
+// File : Benchmark.h
+// Desc : Deterministic Benchmark Runner.
+// Copyright(c) Pocol. All right reserved.
+//-----------------------------------------------------------------------------
+#pragma once
+
+//-----------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------
+#include <cstdint>
+#include <string>
+#include <vector>
+
+
+///////////////////////////////////////////////////////////////////////////////
+// BenchmarkSettings structure
+///////////////////////////////////////////////////////////////////////////////
+struct BenchmarkSettings
+{
+    bool        Enable          = false;            //!< ベンチマークモードで起動するかどうか.
+    uint32_t    Width           = 1920;             //!< 描画する横幅です.
+    uint32_t    Height          = 1080;             //!< 描画する縦幅です.
+    uint32_t    WarmupFrames    = 120;              //!< 計測前に捨てるフレーム数です.
+    uint32_t    MeasureFrames   = 600;              //!< 計測するフレーム数です.
+    uint32_t    GridSize        = 4;                //!< マテリアルボールを並べる1辺の数です.
+    std::string Label;                              //!< 結果に記録する任意のラベルです(ビルドの識別など).
+    std::string OutputPath      = "benchmark.json"; //!< 結果の出力先です.
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// BenchmarkCameraStep structure
+///////////////////////////////////////////////////////////////////////////////
+//! @note       Camera::Event に渡す1フレーム分の変化量です.
+///////////////////////////////////////////////////////////////////////////////
+struct BenchmarkCameraStep
+{
+    float       RotateH;        //!< 水平方向の回転量[rad]です.
+    float       RotateV;        //!< 垂直方向の回転量[rad]です.
+    float       Dolly;          //!< ドリーの量です.
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// BENCHMARK_STATE enum
+///////////////////////////////////////////////////////////////////////////////
+enum BENCHMARK_STATE
+{
+    BENCHMARK_STATE_IDLE = 0,   //!< 開始前です.
+    BENCHMARK_STATE_WARMUP,     //!< 計測前のフレームです.
+    BENCHMARK_STATE_MEASURE,    //!< 計測中です.
+    BENCHMARK_STATE_FINISHED,   //!< 完了しました.
+};
+
+//-----------------------------------------------------------------------------
+//! @brief      コマンドライン引数からベンチマークの設定を読み取ります.
+//!
+//! @param[in]      argc        引数の数です.
+//! @param[in]      argv        引数です.
+//! @param[out]     settings    設定の格納先です.
+//! @retval true    読み取りに成功.
+//! @retval false   不明な引数か不正な値があった.
+//! @note       -benchmark -width N -height N -warmup N -frames N -grid N -label S -out PATH を受け付けます.
+//-----------------------------------------------------------------------------
+bool ParseBenchmarkArgs(int argc, wchar_t** argv, BenchmarkSettings& settings);
+
+//-----------------------------------------------------------------------------
+//! @brief      コマンドライン引数の説明を取得します.
+//-----------------------------------------------------------------------------
+const char* GetBenchmarkUsage();
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Benchmark class
+///////////////////////////////////////////////////////////////////////////////
+//! @note       決められたフレーム数だけ計測を捨ててから計測し, 結果を JSON で出力します.
+//!             カメラの動きは経過時間ではなくフレーム番号だけで決まるので, 同じ設定なら毎回同じ絵になります.
+//!             デバイスに依存しません.
+///////////////////////////////////////////////////////////////////////////////
+class Benchmark
+{
+    //=========================================================================
+    // list of friend classes and methods.
+    //=========================================================================
+    /* NOTHING */
+
+public:
+    //=========================================================================
+    // public variables.
+    //=========================================================================
+    static const uint32_t MaxGridSize       = 16;   //!< マテリアルボールを並べる1辺の最大数です.
+    static const uint32_t CameraPathFrames  = 600;  //!< カメラが1周するフレーム数です.
+
+    //=========================================================================
+    // public methods.
+    //=========================================================================
+
+    //-------------------------------------------------------------------------
+    //! @brief      コンストラクタです.
+    //-------------------------------------------------------------------------
+    Benchmark();
+
+    //-------------------------------------------------------------------------
+    //! @brief      デストラクタです.
+    //-------------------------------------------------------------------------
+    ~Benchmark();
+
+    //-------------------------------------------------------------------------
+    //! @brief      ベンチマークを開始します.
+    //!
+    //! @param[in]      settings    設定です.
+    //! @note       計測フレーム分の記録領域はここで確保します.
+    //-------------------------------------------------------------------------
+    void Start(const BenchmarkSettings& settings);
+
+    //-------------------------------------------------------------------------
+    //! @brief      状態を取得します.
+    //-------------------------------------------------------------------------
+    BENCHMARK_STATE GetState() const;
+
+    //-------------------------------------------------------------------------
+    //! @brief      計測前か計測中かどうかチェックします.
+    //-------------------------------------------------------------------------
+    bool IsRunning() const;
+
+    //-------------------------------------------------------------------------
+    //! @brief      現在のフレームのカメラの変化量を取得します.
+    //-------------------------------------------------------------------------
+    BenchmarkCameraStep GetCameraStep() const;
+
+    //-------------------------------------------------------------------------
+    //! @brief      1フレーム分の時間を記録し, 次のフレームに進めます.
+    //!
+    //! @param[in]      cpuMs       前のフレームからの経過時間[ms]です.
+    //! @param[in]      gpuMs       GPUフレーム時間[ms]です(負なら計測値無し).
+    //-------------------------------------------------------------------------
+    void AddFrame(float cpuMs, float gpuMs);
+
+    //-------------------------------------------------------------------------
+    //! @brief      結果に記録する値を設定します.
+    //!
+    //! @param[in]      name        値の名前です(同じ名前なら上書きします).
+    //! @param[in]      value       値です.
+    //! @note       起動時間, 描画コール数, メモリ使用量など, フレーム時間以外の比較対象に使います.
+    //-------------------------------------------------------------------------
+    void SetMetric(const char* name, double value);
+
+    //-------------------------------------------------------------------------
+    //! @brief      設定を取得します.
+    //-------------------------------------------------------------------------
+    const BenchmarkSettings& GetSettings() const;
+
+    //-------------------------------------------------------------------------
+    //! @brief      計測結果を JSON 形式の文字列にします.
+    //-------------------------------------------------------------------------
+    std::string ExportJson() const;
+
+    //-------------------------------------------------------------------------
+    //! @brief      計測結果を JSON 形式でファイルに書き出します.
+    //!
+    //! @param[in]      path        出力ファイルパスです.
+    //! @retval true    書き出しに成功.
+    //! @retval false   書き出しに失敗.
+    //-------------------------------------------------------------------------
+    bool WriteJson(const char* path) const;
+
+    //-------------------------------------------------------------------------
+    //! @brief      計測結果の要約を文字列にします.
+    //-------------------------------------------------------------------------
+    std::string FormatReport() const;
+
+private:
+    ///////////////////////////////////////////////////////////////////////////
+    // Summary structure
+    ///////////////////////////////////////////////////////////////////////////
+    struct Summary
+    {
+        uint32_t    Count;      //!< 計測値の数です.
+        double      MinMs;      //!< 最小値[ms]です.
+        double      MaxMs;      //!< 最大値[ms]です.
+        double      MeanMs;     //!< 平均値[ms]です.
+        double      P50Ms;      //!< 50パーセンタイル[ms]です.
+        double      P95Ms;      //!< 95パーセンタイル[ms]です.
+        double      P99Ms;      //!< 99パーセンタイル[ms]です.
+        double      Low1Ms;     //!< 遅い方から1%の平均値[ms]です.
+    };
+
+    ///////////////////////////////////////////////////////////////////////////
+    // Metric structure
+    ///////////////////////////////////////////////////////////////////////////
+    struct Metric
+    {
+        std::string Name;       //!< 名前です.
+        double      Value;      //!< 値です.
+    };
+
+    //=========================================================================
+    // private variables.
+    //=========================================================================
+    BenchmarkSettings   m_Settings;     //!< 設定です.
+    BENCHMARK_STATE     m_State;        //!< 状態です.
+    uint32_t            m_Frame;        //!< 開始からのフレーム番号です.
+    std::vector<float>  m_CpuMs;        //!< 計測したフレーム時間です.
+    std::vector<float>  m_GpuMs;        //!< 計測したGPUフレーム時間です.
+    std::vector<Metric> m_Metrics;      //!< フレーム時間以外の記録する値です.
+
+    //=========================================================================
+    // private methods.
+    //=========================================================================
+
+    //-------------------------------------------------------------------------
+    //! @brief      計測値を集計します.
+    //-------------------------------------------------------------------------
+    static Summary Summarize(const std::vector<float>& values);
+
+    Benchmark           (const Benchmark&) = delete;
+    void operator =     (const Benchmark&) = delete;
+};
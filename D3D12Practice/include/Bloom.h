@@ -0,0 +1,178 @@
+﻿//-----------------------------------------------------------------------------
+// File : Bloom.h
+// Desc : Progressive Downsample / Upsample Bloom.
+// Copyright(c) Pocol. All right reserved.
+//-----------------------------------------------------------------------------
+#pragma once
+
+//-----------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------
+#include <d3d12.h>
+#include <wrl/client.h>
+#include <ConstantBuffer.h>
+#include <DescriptorPool.h>
+#include <GpuTimer.h>
+#include <PipelineCache.h>
+#include <RootSignature.h>
+
+
+///////////////////////////////////////////////////////////////////////////////
+// BLOOM_QUALITY enum
+///////////////////////////////////////////////////////////////////////////////
+enum BLOOM_QUALITY
+{
+    BLOOM_QUALITY_LOW = 0,  //!< 4段, バイリニア1タップの縮小と拡大.
+    BLOOM_QUALITY_MEDIUM,   //!< 5段, 13タップの縮小と 3x3 テントの拡大.
+    BLOOM_QUALITY_HIGH,     //!< 6段, MEDIUM に加えて最初の縮小で Karis 平均を取りちらつきを抑える.
+    BLOOM_QUALITY_COUNT,
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// BloomSettings structure
+///////////////////////////////////////////////////////////////////////////////
+struct BloomSettings
+{
+    bool            Enable      = true;                 //!< ブルームを有効にするかどうか.
+    BLOOM_QUALITY   Quality     = BLOOM_QUALITY_MEDIUM; //!< 品質です.
+    float           Threshold   = 1.0f;                 //!< 露光後の輝度のしきい値です.
+    float           Knee        = 0.5f;                 //!< しきい値付近をなめらかにする幅です.
+    float           Scatter     = 0.7f;                 //!< 拡大時に下の段をどれだけ混ぜるかです([0, 1]).
+    float           Intensity   = 0.05f;                //!< トーンマップで加算する強さです.
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// Bloom class
+///////////////////////////////////////////////////////////////////////////////
+//! @note       しきい値を適用しながら半解像度ずつ縮小し, 逆順に拡大しながら合成します.
+//!             縮小用と拡大用にそれぞれミップチェーンを持つテクスチャを1枚ずつ DEFAULT ヒープに確保します.
+//!             テクスチャは常に PIXEL_SHADER_RESOURCE | NON_PIXEL_SHADER_RESOURCE 状態に戻します.
+///////////////////////////////////////////////////////////////////////////////
+class Bloom
+{
+    //=========================================================================
+    // list of friend classes and methods.
+    //=========================================================================
+    /* NOTHING */
+
+public:
+    //=========================================================================
+    // public variables.
+    //=========================================================================
+    static const uint32_t FrameCount    = 2;                    //!< 定数バッファのバッファリング数です.
+    static const uint32_t MaxMipCount   = 6;                    //!< 最大の段数です.
+    static const uint32_t MaxPassCount  = MaxMipCount * 2 - 1;  //!< 最大のパス数です.
+
+    //=========================================================================
+    // public methods.
+    //=========================================================================
+
+    //-------------------------------------------------------------------------
+    //! @brief      コンストラクタです.
+    //-------------------------------------------------------------------------
+    Bloom();
+
+    //-------------------------------------------------------------------------
+    //! @brief      デストラクタです.
+    //-------------------------------------------------------------------------
+    ~Bloom();
+
+    //-------------------------------------------------------------------------
+    //! @brief      初期化処理を行います.
+    //!
+    //! @param[in]      pDevice         デバイスです.
+    //! @param[in]      pPoolRes        リソース用ディスクリプタプールです.
+    //! @param[in]      pCache          パイプラインステートキャッシュです.
+    //! @param[in]      downsampleCS    縮小用コンピュートシェーダです.
+    //! @param[in]      upsampleCS      拡大用コンピュートシェーダです.
+    //! @param[in]      width           シーンカラーの横幅です.
+    //! @param[in]      height          シーンカラーの縦幅です.
+    //! @retval true    初期化に成功.
+    //! @retval false   初期化に失敗.
+    //-------------------------------------------------------------------------
+    bool Init(
+        ID3D12Device*                   pDevice,
+        DescriptorPool*                 pPoolRes,
+        PipelineCache*                  pCache,
+        const D3D12_SHADER_BYTECODE&    downsampleCS,
+        const D3D12_SHADER_BYTECODE&    upsampleCS,
+        uint32_t                        width,
+        uint32_t                        height);
+
+    //-------------------------------------------------------------------------
+    //! @brief      終了処理を行います.
+    //-------------------------------------------------------------------------
+    void Term();
+
+    //-------------------------------------------------------------------------
+    //! @brief      縮小と拡大のパスを記録します.
+    //!
+    //! @param[in]      pCmd            コマンドリストです.
+    //! @param[in]      handleScene     シーンカラーのSRVです(NON_PIXEL_SHADER_RESOURCE を含む状態であること).
+    //! @param[in]      sceneWidth      シーンカラーのうち描画済みの左上の領域の横幅です.
+    //! @param[in]      sceneHeight     シーンカラーのうち描画済みの左上の領域の縦幅です.
+    //! @param[in]      handleExposure  露光バッファのSRVです.
+    //! @param[in]      frameIndex      フレーム番号です.
+    //! @param[in]      pTimer          パスごとの時間を計測するタイマーです(nullptr可).
+    //-------------------------------------------------------------------------
+    void Dispatch(
+        ID3D12GraphicsCommandList*  pCmd,
+        D3D12_GPU_DESCRIPTOR_HANDLE handleScene,
+        uint32_t                    sceneWidth,
+        uint32_t                    sceneHeight,
+        D3D12_GPU_DESCRIPTOR_HANDLE handleExposure,
+        uint32_t                    frameIndex,
+        GpuTimer*                   pTimer);
+
+    //-------------------------------------------------------------------------
+    //! @brief      設定を取得します.
+    //-------------------------------------------------------------------------
+    BloomSettings& GetSettings();
+
+    //-------------------------------------------------------------------------
+    //! @brief      合成に使う強さを取得します(無効時は0).
+    //-------------------------------------------------------------------------
+    float GetIntensity() const;
+
+    //-------------------------------------------------------------------------
+    //! @brief      合成するテクスチャ(拡大結果の最上段)のSRVを取得します.
+    //-------------------------------------------------------------------------
+    D3D12_GPU_DESCRIPTOR_HANDLE GetHandleSRV() const;
+
+private:
+    //=========================================================================
+    // private variables.
+    //=========================================================================
+    BloomSettings                                   m_Settings;                 //!< 設定です.
+    Microsoft::WRL::ComPtr<ID3D12Resource>          m_pDown;                    //!< 縮小用ミップチェーンです.
+    Microsoft::WRL::ComPtr<ID3D12Resource>          m_pUp;                      //!< 拡大用ミップチェーンです.
+    Microsoft::WRL::ComPtr<ID3D12PipelineState>     m_pDownsamplePSO;           //!< 縮小用パイプラインステートです.
+    Microsoft::WRL::ComPtr<ID3D12PipelineState>     m_pUpsamplePSO;             //!< 拡大用パイプラインステートです.
+    RootSignature                                   m_RootSig;                  //!< ルートシグニチャです.
+    ConstantBuffer                                  m_CB[FrameCount][MaxPassCount]; //!< パスごとの定数バッファです.
+    DescriptorPool*                                 m_pPool;                    //!< ディスクリプタプールです.
+    DescriptorHandle*                               m_pHandleDownSRV[MaxMipCount];  //!< 縮小用ミップごとのSRVです.
+    DescriptorHandle*                               m_pHandleDownUAV[MaxMipCount];  //!< 縮小用ミップごとのUAVです.
+    DescriptorHandle*                               m_pHandleUpSRV  [MaxMipCount];  //!< 拡大用ミップごとのSRVです.
+    DescriptorHandle*                               m_pHandleUpUAV  [MaxMipCount];  //!< 拡大用ミップごとのUAVです.
+    uint32_t                                        m_Width;                    //!< シーンカラーの横幅です.
+    uint32_t                                        m_Height;                   //!< シーンカラーの縦幅です.
+    uint32_t                                        m_MipCount;                 //!< 確保した段数です.
+    uint64_t                                        m_MemoryId;                 //!< メモリ使用量の記録番号です.
+
+    //=========================================================================
+    // private methods.
+    //=========================================================================
+
+    //-------------------------------------------------------------------------
+    //! @brief      ミップチェーンとビューを生成します.
+    //-------------------------------------------------------------------------
+    bool CreateChain(
+        ID3D12Device*       pDevice,
+        ID3D12Resource**    ppResource,
+        DescriptorHandle**  ppHandleSRV,
+        DescriptorHandle**  ppHandleUAV);
+
+    Bloom               (const Bloom&) = delete;
+    void operator =     (const Bloom&) = delete;
+};
@@ -0,0 +1,121 @@
+﻿//-----------------------------------------------------------------------------
+// File : CubeMapCooker.h
+// Desc : CPU Equirectangular To CubeMap Converter.
+// Copyright(c) Pocol. All right reserved.
+//-----------------------------------------------------------------------------
+#pragma once
+
+//-----------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------
+#include <cstdint>
+#include <vector>
+#include <filesystem>
+
+
+///////////////////////////////////////////////////////////////////////////////
+// CUBEMAP_FILTER enum
+///////////////////////////////////////////////////////////////////////////////
+enum CUBEMAP_FILTER
+{
+    CUBEMAP_FILTER_BILINEAR = 0,    //!< バイリニアフィルタ.
+    CUBEMAP_FILTER_BICUBIC,         //!< バイキュービックフィルタ(Catmull-Rom).
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// CUBEMAP_FORMAT enum
+///////////////////////////////////////////////////////////////////////////////
+enum CUBEMAP_FORMAT
+{
+    CUBEMAP_FORMAT_RGBA16F = 0,     //!< DXGI_FORMAT_R16G16B16A16_FLOAT.
+    CUBEMAP_FORMAT_RGBA32F,         //!< DXGI_FORMAT_R32G32B32A32_FLOAT.
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// FloatImage structure
+///////////////////////////////////////////////////////////////////////////////
+struct FloatImage
+{
+    uint32_t            Width  = 0;     //!< 横幅です.
+    uint32_t            Height = 0;     //!< 縦幅です.
+    std::vector<float>  Pixels;         //!< RGBA32Fのピクセルデータです.
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// CubeMapImage structure
+///////////////////////////////////////////////////////////////////////////////
+struct CubeMapImage
+{
+    uint32_t                FaceSize  = 0;  //!< 面のサイズです.
+    uint32_t                MipLevels = 0;  //!< ミップレベル数です.
+    std::vector<FloatImage> Surfaces;       //!< サブリソースです(面 * MipLevels + ミップの順).
+
+    //-------------------------------------------------------------------------
+    //! @brief      サブリソースを取得します.
+    //-------------------------------------------------------------------------
+    FloatImage& GetSurface(uint32_t face, uint32_t mip)
+    { return Surfaces[face * MipLevels + mip]; }
+
+    //-------------------------------------------------------------------------
+    //! @brief      サブリソースを取得します.
+    //-------------------------------------------------------------------------
+    const FloatImage& GetSurface(uint32_t face, uint32_t mip) const
+    { return Surfaces[face * MipLevels + mip]; }
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// CubeMapCookDesc structure
+///////////////////////////////////////////////////////////////////////////////
+struct CubeMapCookDesc
+{
+    uint32_t        FaceSize    = 0;                        //!< 面のサイズです(0ならスフィアマップの縦幅).
+    uint32_t        MipLevels   = 0;                        //!< ミップレベル数です(0なら1x1まで生成).
+    CUBEMAP_FILTER  Filter      = CUBEMAP_FILTER_BILINEAR;  //!< リサンプリングフィルタです.
+    uint32_t        ThreadCount = 0;                        //!< ワーカースレッド数です(0ならハードウェアスレッド数).
+};
+
+//-----------------------------------------------------------------------------
+//! @brief      浮動小数点形式のDDSファイルを読み込みます.
+//!
+//! @param[in]      path        ファイルパスです.
+//! @param[out]     result      読み込んだ画像(先頭ミップのみ)の格納先です.
+//! @retval true    読み込みに成功.
+//! @retval false   読み込みに失敗.
+//! @note       RGBA32F, RGBA16F, RGB32F に対応しています.
+//-----------------------------------------------------------------------------
+bool LoadFloatDDS(const std::filesystem::path& path, FloatImage& result);
+
+//-----------------------------------------------------------------------------
+//! @brief      スフィアマップ(正距円筒図法)をミップ付きキューブマップに変換します.
+//!
+//! @param[in]      sphereMap   入力スフィアマップです.
+//! @param[in]      desc        変換設定です.
+//! @param[out]     result      キューブマップの格納先です.
+//! @retval true    変換に成功.
+//! @retval false   変換に失敗.
+//! @note       面と行を単位としてワーカースレッドに分配します.
+//!             方向からの座標計算は SphereMapConverter のシェーダと同じ規約です.
+//-----------------------------------------------------------------------------
+bool CookCubeMap(const FloatImage& sphereMap, const CubeMapCookDesc& desc, CubeMapImage& result);
+
+//-----------------------------------------------------------------------------
+//! @brief      キューブマップをDDSファイルに書き出します.
+//!
+//! @param[in]      path        ファイルパスです.
+//! @param[in]      cubeMap     書き出すキューブマップです.
+//! @param[in]      format      出力フォーマットです.
+//! @retval true    書き出しに成功.
+//! @retval false   書き出しに失敗.
+//-----------------------------------------------------------------------------
+bool SaveCubeMapDDS(const std::filesystem::path& path, const CubeMapImage& cubeMap, CUBEMAP_FORMAT format);
+
+//-----------------------------------------------------------------------------
+//! @brief      画像をDDSファイルに書き出します.
+//!
+//! @param[in]      path        ファイルパスです.
+//! @param[in]      image       書き出す画像です.
+//! @param[in]      format      出力フォーマットです.
+//! @retval true    書き出しに成功.
+//! @retval false   書き出しに失敗.
+//-----------------------------------------------------------------------------
+bool SaveFloatDDS(const std::filesystem::path& path, const FloatImage& image, CUBEMAP_FORMAT format);
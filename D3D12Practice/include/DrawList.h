@@ -0,0 +1,179 @@
+﻿//-----------------------------------------------------------------------------
+// File : DrawList.h
+// Desc : Radix Sorted Draw Packet List.
+// Copyright(c) Pocol. All right reserved.
+//-----------------------------------------------------------------------------
+#pragma once
+
+//-----------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+
+//-----------------------------------------------------------------------------
+// Constant Values.
+//-----------------------------------------------------------------------------
+constexpr uint32_t  DRAW_KEY_PASS_BITS      = 4;    //!< ソートキーのパスのビット数です.
+constexpr uint32_t  DRAW_KEY_PIPELINE_BITS  = 12;   //!< ソートキーのパイプラインのビット数です.
+constexpr uint32_t  DRAW_KEY_MATERIAL_BITS  = 16;   //!< ソートキーのマテリアルのビット数です.
+constexpr uint32_t  DRAW_KEY_DEPTH_BITS     = 24;   //!< ソートキーの深度のビット数です.
+constexpr uint32_t  DRAW_KEY_SUB_BITS       = 8;    //!< ソートキーの同じ状態内の順序のビット数です.
+
+static_assert(DRAW_KEY_PASS_BITS + DRAW_KEY_PIPELINE_BITS + DRAW_KEY_MATERIAL_BITS
+            + DRAW_KEY_DEPTH_BITS + DRAW_KEY_SUB_BITS == 64, "Draw key must be 64 bits.");
+
+
+///////////////////////////////////////////////////////////////////////////////
+// DRAW_ORDER enum
+///////////////////////////////////////////////////////////////////////////////
+enum DRAW_ORDER
+{
+    DRAW_ORDER_STATE = 0,       //!< パス, パイプライン, マテリアル, 手前から奥の順です(状態の切り替えが最小).
+    DRAW_ORDER_FRONT_TO_BACK,   //!< パス, パイプライン, 手前から奥, マテリアルの順です(Early-Z 優先).
+    DRAW_ORDER_BACK_TO_FRONT,   //!< パス, 奥から手前, パイプライン, マテリアルの順です(半透明用).
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// DrawPacket structure
+///////////////////////////////////////////////////////////////////////////////
+struct DrawPacket
+{
+    uint64_t    Key;        //!< ソートキーです.
+    uint32_t    Index;      //!< 呼び出し側の描画データの番号です.
+    uint32_t    Reserved;   //!< 予約領域です.
+};
+
+//-----------------------------------------------------------------------------
+//! @brief      ビュー空間の深度をソートキー用に量子化します.
+//!
+//! @param[in]      viewDepth   カメラからの距離です(負の値は0とみなします).
+//! @return     DRAW_KEY_DEPTH_BITS ビットの値を返却します. 深度が大きいほど大きくなります.
+//! @note       正の浮動小数のビット列は大小関係を保つので, 上位ビットを取り出すと対数的に量子化されます.
+//-----------------------------------------------------------------------------
+uint32_t QuantizeDrawDepth(float viewDepth);
+
+//-----------------------------------------------------------------------------
+//! @brief      描画のソートキーを作ります.
+//!
+//! @param[in]      order       並べ方です.
+//! @param[in]      pass        パス番号です(小さいほど先に描画).
+//! @param[in]      pipeline    パイプライン番号です.
+//! @param[in]      material    マテリアル番号です.
+//! @param[in]      viewDepth   カメラからの距離です.
+//! @param[in]      sub         同じ状態の描画を並べる補助の値です.
+//! @return     ソートキーを返却します. 各フィールドは上位ビットを切り捨てます.
+//-----------------------------------------------------------------------------
+uint64_t MakeDrawKey(
+    DRAW_ORDER  order,
+    uint32_t    pass,
+    uint32_t    pipeline,
+    uint32_t    material,
+    float       viewDepth,
+    uint32_t    sub = 0);
+
+//-----------------------------------------------------------------------------
+//! @brief      ソートキーからパス番号を取り出します.
+//-----------------------------------------------------------------------------
+uint32_t GetDrawKeyPass(uint64_t key);
+
+//-----------------------------------------------------------------------------
+//! @brief      ソートキーからパイプライン番号を取り出します.
+//-----------------------------------------------------------------------------
+uint32_t GetDrawKeyPipeline(DRAW_ORDER order, uint64_t key);
+
+//-----------------------------------------------------------------------------
+//! @brief      ソートキーからマテリアル番号を取り出します.
+//-----------------------------------------------------------------------------
+uint32_t GetDrawKeyMaterial(DRAW_ORDER order, uint64_t key);
+
+
+///////////////////////////////////////////////////////////////////////////////
+// DrawList class
+///////////////////////////////////////////////////////////////////////////////
+//! @note       フレームごとに描画パケットを集め, キーの基数ソート(LSD, 8ビットずつ)で並べます.
+//!             全パケットで同じ値のバイトは走査を省くので, 使っていないフィールドの分は速くなります.
+//!             ソートは安定なので, 同じキーのパケットは追加した順に並びます.
+///////////////////////////////////////////////////////////////////////////////
+class DrawList
+{
+    //=========================================================================
+    // list of friend classes and methods.
+    //=========================================================================
+    /* NOTHING */
+
+public:
+    //=========================================================================
+    // public variables.
+    //=========================================================================
+    static const size_t ParallelThreshold = 64 * 1024;  //!< 並列にソートする最小のパケット数です.
+
+    //=========================================================================
+    // public methods.
+    //=========================================================================
+
+    //-------------------------------------------------------------------------
+    //! @brief      コンストラクタです.
+    //-------------------------------------------------------------------------
+    DrawList();
+
+    //-------------------------------------------------------------------------
+    //! @brief      デストラクタです.
+    //-------------------------------------------------------------------------
+    ~DrawList();
+
+    //-------------------------------------------------------------------------
+    //! @brief      パケットを空にします(メモリは保持します).
+    //-------------------------------------------------------------------------
+    void Clear();
+
+    //-------------------------------------------------------------------------
+    //! @brief      パケットのメモリを予約します.
+    //-------------------------------------------------------------------------
+    void Reserve(size_t count);
+
+    //-------------------------------------------------------------------------
+    //! @brief      パケットを追加します.
+    //!
+    //! @param[in]      key         ソートキーです.
+    //! @param[in]      index       呼び出し側の描画データの番号です.
+    //-------------------------------------------------------------------------
+    void Push(uint64_t key, uint32_t index);
+
+    //-------------------------------------------------------------------------
+    //! @brief      キーの昇順に並べ替えます.
+    //!
+    //! @param[in]      threadCount     ワーカースレッド数です(0なら ParallelThreshold 以上のときハードウェアスレッド数).
+    //-------------------------------------------------------------------------
+    void Sort(uint32_t threadCount = 0);
+
+    //-------------------------------------------------------------------------
+    //! @brief      キーの昇順に並んでいるかどうかチェックします.
+    //-------------------------------------------------------------------------
+    bool IsSorted() const;
+
+    //-------------------------------------------------------------------------
+    //! @brief      パケット数を取得します.
+    //-------------------------------------------------------------------------
+    size_t GetCount() const;
+
+    //-------------------------------------------------------------------------
+    //! @brief      パケットを取得します.
+    //-------------------------------------------------------------------------
+    const DrawPacket* GetPackets() const;
+
+private:
+    //=========================================================================
+    // private variables.
+    //=========================================================================
+    std::vector<DrawPacket>     m_Packets;      //!< パケットです.
+    std::vector<DrawPacket>     m_Temp;         //!< ソートの作業領域です.
+
+    //=========================================================================
+    // private methods.
+    //=========================================================================
+    DrawList            (const DrawList&) = delete;
+    void operator =     (const DrawList&) = delete;
+};
@@ -0,0 +1,142 @@
+﻿//-----------------------------------------------------------------------------
+// File : DynamicResolution.h
+// Desc : GPU Time Driven Dynamic Resolution Controller.
+// Copyright(c) Pocol. All right reserved.
+//-----------------------------------------------------------------------------
+#pragma once
+
+//-----------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------
+#include <cstdint>
+
+
+///////////////////////////////////////////////////////////////////////////////
+// DynamicResolutionSettings structure
+///////////////////////////////////////////////////////////////////////////////
+struct DynamicResolutionSettings
+{
+    bool        Enable          = true;     //!< 動的解像度を有効にするかどうか(無効時は MaxScale 固定).
+    float       TargetMs        = 15.0f;    //!< GPUフレーム時間の予算[ms]です.
+    float       Headroom        = 0.85f;    //!< 解像度を上げるときに目標とする予算の割合です.
+    float       MinScale        = 0.5f;     //!< 縦横の拡大率の下限です.
+    float       MaxScale        = 1.0f;     //!< 縦横の拡大率の上限です.
+    float       ScaleStep       = 0.05f;    //!< 拡大率の刻み幅です.
+    float       Smoothing       = 0.25f;    //!< 計測値の指数移動平均の係数です.
+    float       OutlierRatio    = 2.0f;     //!< 計測値を平均のこの倍率までに抑えます(単発のヒッチで下げないため. 0なら抑えません).
+    uint32_t    IncreaseDelay   = 30;       //!< 解像度を上げるまでに予算を下回り続ける必要があるフレーム数です.
+    uint32_t    Latency         = 3;        //!< 拡大率の変更後, 古い解像度の計測値として捨てるフレーム数です.
+    float       Sharpness       = 0.5f;     //!< 拡大時のシャープ化の強さ[0, 1]です.
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// DynamicResolution class
+///////////////////////////////////////////////////////////////////////////////
+//! @note       計測したGPUフレーム時間から, 次のフレームのシーンの拡大率を決めます.
+//!             描画コストは画素数(拡大率の2乗)に比例するとみなします.
+//!             予算を超えたら直ちに下げ, 下回り続けたら1段ずつ上げます.
+//!             デバイスに依存せず, 同じ計測値の列からは常に同じ拡大率の列が得られます.
+///////////////////////////////////////////////////////////////////////////////
+class DynamicResolution
+{
+    //=========================================================================
+    // list of friend classes and methods.
+    //=========================================================================
+    /* NOTHING */
+
+public:
+    //=========================================================================
+    // public variables.
+    //=========================================================================
+    /* NOTHING */
+
+    //=========================================================================
+    // public methods.
+    //=========================================================================
+
+    //-------------------------------------------------------------------------
+    //! @brief      コンストラクタです.
+    //-------------------------------------------------------------------------
+    DynamicResolution();
+
+    //-------------------------------------------------------------------------
+    //! @brief      デストラクタです.
+    //-------------------------------------------------------------------------
+    ~DynamicResolution();
+
+    //-------------------------------------------------------------------------
+    //! @brief      状態をリセットし, 拡大率を上限に戻します.
+    //-------------------------------------------------------------------------
+    void Reset();
+
+    //-------------------------------------------------------------------------
+    //! @brief      計測したGPUフレーム時間から拡大率を更新します.
+    //!
+    //! @param[in]      gpuMs       GPUフレーム時間[ms]です(0以下は無視します).
+    //! @return     更新後の拡大率を返却します.
+    //-------------------------------------------------------------------------
+    float Update(float gpuMs);
+
+    //-------------------------------------------------------------------------
+    //! @brief      現在の拡大率を取得します.
+    //-------------------------------------------------------------------------
+    float GetScale() const;
+
+    //-------------------------------------------------------------------------
+    //! @brief      平滑化したGPUフレーム時間[ms]を取得します.
+    //-------------------------------------------------------------------------
+    float GetFilteredMs() const;
+
+    //-------------------------------------------------------------------------
+    //! @brief      拡大率を変更した回数を取得します.
+    //-------------------------------------------------------------------------
+    uint32_t GetChangeCount() const;
+
+    //-------------------------------------------------------------------------
+    //! @brief      最大サイズに拡大率を掛けた描画サイズを求めます.
+    //!
+    //! @param[in]      maxWidth    最大の横幅です.
+    //! @param[in]      maxHeight   最大の縦幅です.
+    //! @param[out]     width       描画する横幅です.
+    //! @param[out]     height      描画する縦幅です.
+    //-------------------------------------------------------------------------
+    void GetRenderSize(uint32_t maxWidth, uint32_t maxHeight, uint32_t& width, uint32_t& height) const;
+
+    //-------------------------------------------------------------------------
+    //! @brief      シャープ化の強さを取得します(拡大しないときは0).
+    //-------------------------------------------------------------------------
+    float GetSharpness() const;
+
+    //-------------------------------------------------------------------------
+    //! @brief      設定を取得します.
+    //-------------------------------------------------------------------------
+    DynamicResolutionSettings& GetSettings();
+
+    //-------------------------------------------------------------------------
+    //! @brief      設定を取得します.
+    //-------------------------------------------------------------------------
+    const DynamicResolutionSettings& GetSettings() const;
+
+private:
+    //=========================================================================
+    // private variables.
+    //=========================================================================
+    DynamicResolutionSettings   m_Settings;         //!< 設定です.
+    float                       m_Scale;            //!< 現在の拡大率です.
+    float                       m_FilteredMs;       //!< 平滑化したGPUフレーム時間[ms]です(負なら未計測).
+    uint32_t                    m_SkipCount;        //!< 捨てる残りの計測数です.
+    uint32_t                    m_UnderCount;       //!< 予算を下回り続けたフレーム数です.
+    uint32_t                    m_ChangeCount;      //!< 拡大率を変更した回数です.
+
+    //=========================================================================
+    // private methods.
+    //=========================================================================
+
+    //-------------------------------------------------------------------------
+    //! @brief      拡大率を刻み幅に切り捨て, 範囲に収めます.
+    //-------------------------------------------------------------------------
+    float Quantize(float scale) const;
+
+    DynamicResolution   (const DynamicResolution&) = delete;
+    void operator =     (const DynamicResolution&) = delete;
+};
@@ -1,8 +1,18 @@
-#pragma once
+﻿#pragma once
 
 #include <string> 
 #include <Shlwapi.h>
+#include "VirtualFileSystem.h"
 
 #pragma comment( lib, "Shlwapi.lib ")
 
-bool SearchFilePath(const wchar_t* filename, std::wstring& result);
\ No newline at end of file
+bool SearchFilePath(const wchar_t* filename, std::wstring& result);
+
+// 検索パスを一度だけ走査して索引を作る(以降の SearchFilePath は索引を引く)
+bool MountSearchPaths(bool watch = false);
+
+// 検索パスの索引を破棄する
+void UnmountSearchPaths();
+
+// 検索パスの索引を取得する
+VirtualFileSystem& GetFileSystem();
\ No newline at end of file
@@ -0,0 +1,327 @@
+﻿//-----------------------------------------------------------------------------
+// File : FrameGraph.h
+// Desc : Frame Graph (Pass Culling, Ordering, Barriers and Transient Lifetimes).
+// Copyright(c) Pocol. All right reserved.
+//-----------------------------------------------------------------------------
+#pragma once
+
+//-----------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+
+//-----------------------------------------------------------------------------
+// Type Definitions.
+//-----------------------------------------------------------------------------
+using FramePassId     = uint32_t;
+using FrameResourceId = uint32_t;
+
+
+//-----------------------------------------------------------------------------
+// Constant Values.
+//-----------------------------------------------------------------------------
+constexpr uint32_t FRAME_GRAPH_INVALID_ID = UINT32_MAX;    //!< 無効なIDです.
+
+
+///////////////////////////////////////////////////////////////////////////////
+// FRAME_USAGE enum
+///////////////////////////////////////////////////////////////////////////////
+//! @note       読み込み用の値はビット和で組み合わせられます.
+///////////////////////////////////////////////////////////////////////////////
+enum FRAME_USAGE : uint32_t
+{
+    FRAME_USAGE_NONE                = 0,        //!< 未使用です(転送先の状態を問いません).
+    FRAME_USAGE_PIXEL_READ          = 0x0001,   //!< ピクセルシェーダから読み込みます.
+    FRAME_USAGE_NON_PIXEL_READ      = 0x0002,   //!< ピクセルシェーダ以外から読み込みます.
+    FRAME_USAGE_DEPTH_READ          = 0x0004,   //!< 深度テストのみに使います.
+    FRAME_USAGE_COPY_SRC            = 0x0008,   //!< コピー元です.
+    FRAME_USAGE_RENDER_TARGET       = 0x0100,   //!< レンダーターゲットです.
+    FRAME_USAGE_DEPTH_WRITE         = 0x0200,   //!< 深度を書き込みます.
+    FRAME_USAGE_UNORDERED_ACCESS    = 0x0400,   //!< UAVとして読み書きします.
+    FRAME_USAGE_COPY_DST            = 0x0800,   //!< コピー先です.
+    FRAME_USAGE_PRESENT             = 0x1000,   //!< 表示用です.
+
+    FRAME_USAGE_READ_MASK           = 0x00ff,   //!< 読み込み用の値です.
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// FRAME_BARRIER_TYPE enum
+///////////////////////////////////////////////////////////////////////////////
+enum FRAME_BARRIER_TYPE
+{
+    FRAME_BARRIER_TRANSITION = 0,   //!< 状態遷移です.
+    FRAME_BARRIER_UAV,              //!< UAV書き込み同士の同期です.
+    FRAME_BARRIER_ALIASING,         //!< 同じメモリを使う一時リソースの切り替えです.
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// FrameBarrier structure
+///////////////////////////////////////////////////////////////////////////////
+struct FrameBarrier
+{
+    FRAME_BARRIER_TYPE  Type;           //!< バリアの種類です.
+    FrameResourceId     Resource;       //!< 対象リソースです(エイリアシング時は切り替え後).
+    FrameResourceId     Previous;       //!< エイリアシング時の切り替え前のリソースです.
+    uint32_t            Before;         //!< 遷移前の FRAME_USAGE です.
+    uint32_t            After;          //!< 遷移後の FRAME_USAGE です.
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// FrameTransientDesc structure
+///////////////////////////////////////////////////////////////////////////////
+struct FrameTransientDesc
+{
+    uint64_t    Size;           //!< 必要なメモリサイズです.
+    uint64_t    Alignment;      //!< 配置のアライメントです(2のべき乗).
+};
+
+
+///////////////////////////////////////////////////////////////////////////////
+// FrameGraph class
+///////////////////////////////////////////////////////////////////////////////
+//! @note       パスが読み書きするリソースを宣言しておき, Compile() でCPUだけを使って
+//!             不要なパスの除去, 実行順の決定, バリアの導出, 一時リソースの寿命とメモリ配置を求めます.
+//!             同じリソースへのアクセスは宣言順に依存関係を結びます(書き込みの後の読み込み, 読み込みの後の書き込み).
+//!             外部でビューや状態を管理するリソースは Import() で取り込み, 最後に指定の状態へ戻します.
+///////////////////////////////////////////////////////////////////////////////
+class FrameGraph
+{
+    //=========================================================================
+    // list of friend classes and methods.
+    //=========================================================================
+    /* NOTHING */
+
+public:
+    ///////////////////////////////////////////////////////////////////////////
+    // ResourceInfo structure
+    ///////////////////////////////////////////////////////////////////////////
+    struct ResourceInfo
+    {
+        std::string         Name;           //!< リソース名です.
+        bool                Imported;       //!< 取り込んだリソースかどうか.
+        uint32_t            InitialUsage;   //!< フレーム開始時の状態です.
+        uint32_t            FinalUsage;     //!< フレーム終了時の状態です(NONE なら最後に使った状態のまま).
+        FrameTransientDesc  Transient;      //!< 一時リソースのメモリ要件です.
+        uint32_t            FirstOrder;     //!< 最初に使う実行順です(未使用なら FRAME_GRAPH_INVALID_ID).
+        uint32_t            LastOrder;      //!< 最後に使う実行順です.
+        uint64_t            HeapOffset;     //!< 一時リソースのヒープ内オフセットです.
+        uint32_t            EndUsage;       //!< コンパイル後のフレーム終了時の状態です.
+    };
+
+    ///////////////////////////////////////////////////////////////////////////
+    // CompileStats structure
+    ///////////////////////////////////////////////////////////////////////////
+    struct CompileStats
+    {
+        uint32_t    PassCount;          //!< 宣言されたパス数です.
+        uint32_t    CulledCount;        //!< 除去されたパス数です.
+        uint32_t    BarrierCount;       //!< 導出したバリア数です.
+        uint64_t    TransientBytes;     //!< 一時リソースの合計サイズです.
+        uint64_t    HeapBytes;          //!< メモリを共有した後のヒープサイズです.
+    };
+
+    //=========================================================================
+    // public variables.
+    //=========================================================================
+    /* NOTHING */
+
+    //=========================================================================
+    // public methods.
+    //=========================================================================
+
+    //-------------------------------------------------------------------------
+    //! @brief      コンストラクタです.
+    //-------------------------------------------------------------------------
+    FrameGraph();
+
+    //-------------------------------------------------------------------------
+    //! @brief      デストラクタです.
+    //-------------------------------------------------------------------------
+    ~FrameGraph();
+
+    //-------------------------------------------------------------------------
+    //! @brief      外部のリソースを取り込みます.
+    //!
+    //! @param[in]      name            リソース名です.
+    //! @param[in]      initialUsage    フレーム開始時の状態です.
+    //! @param[in]      finalUsage      フレーム終了時に戻す状態です(NONE なら最後に使った状態のまま).
+    //! @return     リソースIDを返却します.
+    //! @note       finalUsage を指定したリソースへの書き込みはフレームの出力とみなし, そのパスは除去されません.
+    //-------------------------------------------------------------------------
+    FrameResourceId Import(const char* name, uint32_t initialUsage, uint32_t finalUsage);
+
+    //-------------------------------------------------------------------------
+    //! @brief      一時リソースを宣言します.
+    //!
+    //! @param[in]      name            リソース名です.
+    //! @param[in]      desc            メモリ要件です.
+    //! @return     リソースIDを返却します.
+    //! @note       寿命の重ならない一時リソース同士は同じメモリを共有します.
+    //-------------------------------------------------------------------------
+    FrameResourceId Create(const char* name, const FrameTransientDesc& desc);
+
+    //-------------------------------------------------------------------------
+    //! @brief      パスを追加します.
+    //!
+    //! @param[in]      name            パス名です.
+    //! @param[in]      func            実行時の処理です.
+    //! @return     パスIDを返却します.
+    //-------------------------------------------------------------------------
+    FramePassId AddPass(const char* name, std::function<void()> func);
+
+    //-------------------------------------------------------------------------
+    //! @brief      パスが読み込むリソースを宣言します.
+    //!
+    //! @param[in]      pass            パスです.
+    //! @param[in]      resource        リソースです.
+    //! @param[in]      usage           読み込み用の FRAME_USAGE です.
+    //-------------------------------------------------------------------------
+    void Read(FramePassId pass, FrameResourceId resource, uint32_t usage);
+
+    //-------------------------------------------------------------------------
+    //! @brief      パスが書き込むリソースを宣言します.
+    //!
+    //! @param[in]      pass            パスです.
+    //! @param[in]      resource        リソースです.
+    //! @param[in]      usage           書き込み時の FRAME_USAGE です.
+    //! @note       パス内で状態を管理するリソースには, パス終了時の状態を指定します.
+    //-------------------------------------------------------------------------
+    void Write(FramePassId pass, FrameResourceId resource, uint32_t usage);
+
+    //-------------------------------------------------------------------------
+    //! @brief      パスを除去しないようにします.
+    //!
+    //! @param[in]      pass            パスです.
+    //! @note       宣言していないリソースに書き込むパスに指定します.
+    //-------------------------------------------------------------------------
+    void SetSideEffect(FramePassId pass);
+
+    //-------------------------------------------------------------------------
+    //! @brief      グラフをコンパイルします.
+    //!
+    //! @retval true    コンパイルに成功.
+    //! @retval false   不正なIDを使っているか, 書き込まれていない一時リソースを読み込んでいます.
+    //-------------------------------------------------------------------------
+    bool Compile();
+
+    //-------------------------------------------------------------------------
+    //! @brief      コンパイル結果の順にパスを実行します.
+    //!
+    //! @param[in]      barrierFunc     バリアを発行する処理です(各パスの前とフレームの最後に呼び出します).
+    //-------------------------------------------------------------------------
+    void Execute(const std::function<void(const FrameBarrier* pBarriers, uint32_t count)>& barrierFunc);
+
+    //-------------------------------------------------------------------------
+    //! @brief      パスとリソースをすべて削除します.
+    //-------------------------------------------------------------------------
+    void Clear();
+
+    //-------------------------------------------------------------------------
+    //! @brief      実行順に並んだパスを取得します(除去したパスは含みません).
+    //-------------------------------------------------------------------------
+    const std::vector<FramePassId>& GetOrder() const;
+
+    //-------------------------------------------------------------------------
+    //! @brief      パスの前に発行するバリアを取得します.
+    //!
+    //! @param[in]      order           実行順です(GetOrder().size() ならフレーム終了時).
+    //! @param[out]     count           バリア数の格納先です.
+    //-------------------------------------------------------------------------
+    const FrameBarrier* GetBarriers(uint32_t order, uint32_t& count) const;
+
+    //-------------------------------------------------------------------------
+    //! @brief      パス名を取得します.
+    //-------------------------------------------------------------------------
+    const std::string& GetPassName(FramePassId pass) const;
+
+    //-------------------------------------------------------------------------
+    //! @brief      パスが除去されたかどうかチェックします.
+    //-------------------------------------------------------------------------
+    bool IsCulled(FramePassId pass) const;
+
+    //-------------------------------------------------------------------------
+    //! @brief      リソースの情報を取得します.
+    //-------------------------------------------------------------------------
+    const ResourceInfo& GetResource(FrameResourceId resource) const;
+
+    //-------------------------------------------------------------------------
+    //! @brief      コンパイル結果の統計を取得します.
+    //-------------------------------------------------------------------------
+    const CompileStats& GetStats() const;
+
+    //-------------------------------------------------------------------------
+    //! @brief      コンパイル結果のレポートを作成します.
+    //-------------------------------------------------------------------------
+    std::string FormatReport() const;
+
+private:
+    ///////////////////////////////////////////////////////////////////////////
+    // Access structure
+    ///////////////////////////////////////////////////////////////////////////
+    struct Access
+    {
+        FrameResourceId     Resource;   //!< リソースです.
+        uint32_t            Usage;      //!< FRAME_USAGE です.
+        bool                Write;      //!< 書き込みかどうか.
+    };
+
+    ///////////////////////////////////////////////////////////////////////////
+    // Pass structure
+    ///////////////////////////////////////////////////////////////////////////
+    struct Pass
+    {
+        std::string                 Name;           //!< パス名です.
+        std::function<void()>       Func;           //!< 実行時の処理です.
+        std::vector<Access>         Accesses;       //!< 宣言したアクセスです.
+        std::vector<FramePassId>    Dependencies;   //!< 先に実行する必要があるパスです.
+        bool                        SideEffect;     //!< 除去しないかどうか.
+        bool                        Culled;         //!< 除去されたかどうか.
+    };
+
+    //=========================================================================
+    // private variables.
+    //=========================================================================
+    std::vector<Pass>               m_Passes;           //!< パスです.
+    std::vector<ResourceInfo>       m_Resources;        //!< リソースです.
+    std::vector<FramePassId>        m_Order;            //!< 実行順です.
+    std::vector<FrameBarrier>       m_Barriers;         //!< 全バリアです.
+    std::vector<uint32_t>           m_BarrierOffsets;   //!< 実行順ごとのバリアの開始位置です(末尾に番兵).
+    CompileStats                    m_Stats;            //!< コンパイル結果の統計です.
+    bool                            m_Compiled;         //!< コンパイル済みかどうか.
+
+    //=========================================================================
+    // private methods.
+    //=========================================================================
+
+    //-------------------------------------------------------------------------
+    //! @brief      アクセスの宣言順から依存関係を構築します.
+    //-------------------------------------------------------------------------
+    void BuildDependencies();
+
+    //-------------------------------------------------------------------------
+    //! @brief      出力に寄与しないパスを除去します.
+    //-------------------------------------------------------------------------
+    void Cull();
+
+    //-------------------------------------------------------------------------
+    //! @brief      実行順を決定します.
+    //-------------------------------------------------------------------------
+    void Schedule();
+
+    //-------------------------------------------------------------------------
+    //! @brief      一時リソースの寿命を求め, メモリを配置します.
+    //-------------------------------------------------------------------------
+    void AllocateTransients();
+
+    //-------------------------------------------------------------------------
+    //! @brief      バリアを導出します.
+    //-------------------------------------------------------------------------
+    void BuildBarriers();
+
+    FrameGraph          (const FrameGraph&) = delete;
+    void operator =     (const FrameGraph&) = delete;
+};
@@ -0,0 +1,174 @@
+﻿//-----------------------------------------------------------------------------
+// File : FramePacer.h
+// Desc : Frame Pacing For Low-Latency Presentation.
+// Copyright(c) Pocol. All right reserved.
+//-----------------------------------------------------------------------------
+#pragma once
+
+//-----------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------
+#include <cstdint>
+
+
+///////////////////////////////////////////////////////////////////////////////
+// LATENCY_MODE enum
+///////////////////////////////////////////////////////////////////////////////
+enum LATENCY_MODE
+{
+    LATENCY_MODE_VSYNC = 0,     //!< 垂直同期します. 表示後のフェンス待ちだけで制御します(従来の動作).
+    LATENCY_MODE_LOW,           //!< 垂直同期します. フレームの開始時に待機可能オブジェクトで待ちます.
+    LATENCY_MODE_UNCAPPED,      //!< 垂直同期しません. 対応していればティアリングを許可します.
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// FramePacer class
+///////////////////////////////////////////////////////////////////////////////
+//! @note       表示の同期間隔, ティアリング, 待機可能オブジェクトの待ち方を決め, 入力から表示までの遅延を集計します.
+//!             グラフィックスAPIにも時計にも依存しません. 時刻は呼び出し側が渡すので, 模擬的な表示クロックで動作を確認できます.
+///////////////////////////////////////////////////////////////////////////////
+class FramePacer
+{
+    //=========================================================================
+    // list of friend classes and methods.
+    //=========================================================================
+    /* NOTHING */
+
+public:
+    //=========================================================================
+    // public variables.
+    //=========================================================================
+    static const uint32_t MaxLatencyLimit   = 16;       //!< 最大遅延フレーム数の上限です(DXGIの上限).
+    static const uint32_t DefaultMaxLatency = 1;        //!< 既定の最大遅延フレーム数です.
+    static const uint32_t WaitTimeoutMs     = 100;      //!< 1フレームで待機可能オブジェクトを待つ最長時間[ms]です.
+    static const uint32_t HistorySize       = 32;       //!< 表示待ちとして覚えておくフレーム数です.
+
+    //=========================================================================
+    // public methods.
+    //=========================================================================
+
+    //-------------------------------------------------------------------------
+    //! @brief      コンストラクタです.
+    //-------------------------------------------------------------------------
+    FramePacer();
+
+    //-------------------------------------------------------------------------
+    //! @brief      デストラクタです.
+    //-------------------------------------------------------------------------
+    ~FramePacer();
+
+    //-------------------------------------------------------------------------
+    //! @brief      設定して記録を破棄します.
+    //!
+    //! @param[in]      mode                遅延モードです.
+    //! @param[in]      maxLatency          最大遅延フレーム数です(1 ～ MaxLatencyLimit に丸めます).
+    //! @param[in]      tearingSupported    ティアリングに対応しているかどうか.
+    //-------------------------------------------------------------------------
+    void Init(LATENCY_MODE mode, uint32_t maxLatency, bool tearingSupported);
+
+    //-------------------------------------------------------------------------
+    //! @brief      遅延モードを取得します.
+    //-------------------------------------------------------------------------
+    LATENCY_MODE GetMode() const;
+
+    //-------------------------------------------------------------------------
+    //! @brief      最大遅延フレーム数を取得します.
+    //-------------------------------------------------------------------------
+    uint32_t GetMaxLatency() const;
+
+    //-------------------------------------------------------------------------
+    //! @brief      待機可能オブジェクトを使うかどうか.
+    //-------------------------------------------------------------------------
+    bool UseWaitableObject() const;
+
+    //-------------------------------------------------------------------------
+    //! @brief      スワップチェインをティアリング可能として生成するかどうか.
+    //-------------------------------------------------------------------------
+    bool AllowTearing() const;
+
+    //-------------------------------------------------------------------------
+    //! @brief      表示の同期間隔を取得します.
+    //-------------------------------------------------------------------------
+    uint32_t GetSyncInterval() const;
+
+    //-------------------------------------------------------------------------
+    //! @brief      表示時にティアリングを要求するかどうか.
+    //!
+    //! @param[in]      fullscreen  排他的フルスクリーンかどうか(この場合は要求できません).
+    //-------------------------------------------------------------------------
+    bool UseTearing(bool fullscreen) const;
+
+    //-------------------------------------------------------------------------
+    //! @brief      このフレームで待機可能オブジェクトを待つ回数を取得します.
+    //!
+    //! @return     待機可能オブジェクトを使わない場合は0を返却します.
+    //! @note       前のフレームで待ちきれなかった分を含みます. 合わせて WaitTimeoutMs まで待ってください.
+    //-------------------------------------------------------------------------
+    uint32_t GetWaitCount() const;
+
+    //-------------------------------------------------------------------------
+    //! @brief      待機可能オブジェクトを待った結果を記録します.
+    //!
+    //! @param[in]      signaled    シグナル状態になった回数です.
+    //-------------------------------------------------------------------------
+    void OnWaitResult(uint32_t signaled);
+
+    //-------------------------------------------------------------------------
+    //! @brief      表示したフレームを記録します.
+    //!
+    //! @param[in]      presentId   表示の通し番号です(IDXGISwapChain::GetLastPresentCount).
+    //! @param[in]      beginMs     フレームの開始時刻(入力を読んだ時刻)[ms]です.
+    //-------------------------------------------------------------------------
+    void OnPresent(uint32_t presentId, double beginMs);
+
+    //-------------------------------------------------------------------------
+    //! @brief      画面に表示されたフレームを記録します.
+    //!
+    //! @param[in]      presentId   表示された表示の通し番号です(DXGI_FRAME_STATISTICS::PresentCount).
+    //! @param[in]      displayMs   表示された時刻[ms]です(DXGI_FRAME_STATISTICS::SyncQPCTime).
+    //! @note       同じ番号を繰り返し渡しても1回だけ数えます.
+    //-------------------------------------------------------------------------
+    void OnDisplayed(uint32_t presentId, double displayMs);
+
+    //-------------------------------------------------------------------------
+    //! @brief      入力から表示までの遅延の平均[ms]を取得します.
+    //!
+    //! @return     まだ表示を記録していない場合は0を返却します.
+    //-------------------------------------------------------------------------
+    double GetLatencyMs() const;
+
+    //-------------------------------------------------------------------------
+    //! @brief      待機可能オブジェクトを待ちきれなかった回数を取得します.
+    //-------------------------------------------------------------------------
+    uint32_t GetTimeoutCount() const;
+
+private:
+    ///////////////////////////////////////////////////////////////////////////
+    // Frame structure
+    ///////////////////////////////////////////////////////////////////////////
+    struct Frame
+    {
+        uint32_t    PresentId;      //!< 表示の通し番号です.
+        double      BeginMs;        //!< フレームの開始時刻[ms]です.
+        bool        Valid;          //!< 記録があるかどうか.
+    };
+
+    //=========================================================================
+    // private variables.
+    //=========================================================================
+    LATENCY_MODE    m_Mode;                     //!< 遅延モードです.
+    uint32_t        m_MaxLatency;               //!< 最大遅延フレーム数です.
+    bool            m_TearingSupported;         //!< ティアリングに対応しているかどうか.
+    uint32_t        m_Debt;                     //!< 待ちきれずに持ち越した回数です.
+    uint32_t        m_TimeoutCount;             //!< 待ちきれなかった回数です.
+    Frame           m_Frames[HistorySize];      //!< 表示待ちのフレームです.
+    uint32_t        m_LastDisplayedId;          //!< 最後に記録した表示の通し番号です.
+    bool            m_HasDisplayed;             //!< 表示を記録したかどうか.
+    double          m_LatencyMs;                //!< 遅延の指数移動平均[ms]です.
+
+    //=========================================================================
+    // private methods.
+    //=========================================================================
+    FramePacer          (const FramePacer&) = delete;
+    void operator =     (const FramePacer&) = delete;
+};
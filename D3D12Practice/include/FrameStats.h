@@ -0,0 +1,152 @@
+﻿//-----------------------------------------------------------------------------
+// File : FrameStats.h
+// Desc : Frame Time Statistics.
+// Copyright(c) Pocol. All right reserved.
+//-----------------------------------------------------------------------------
+#pragma once
+
+//-----------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+#include <fstream>
+
+
+///////////////////////////////////////////////////////////////////////////////
+// FrameStatsSummary structure
+///////////////////////////////////////////////////////////////////////////////
+struct FrameStatsSummary
+{
+    uint64_t    FrameCount;     //!< これまでに記録したフレーム数です.
+    uint32_t    SampleCount;    //!< 集計したフレーム数です(ウィンドウ内).
+    float       MinMs;          //!< フレーム時間の最小値[ms]です.
+    float       MaxMs;          //!< フレーム時間の最大値[ms]です.
+    float       MeanMs;         //!< フレーム時間の平均値[ms]です.
+    float       P50Ms;          //!< フレーム時間の50パーセンタイル[ms]です.
+    float       P95Ms;          //!< フレーム時間の95パーセンタイル[ms]です.
+    float       P99Ms;          //!< フレーム時間の99パーセンタイル[ms]です.
+    float       MeanFps;        //!< 平均フレームレートです.
+    float       Low1Fps;        //!< 遅い方から1%のフレームの平均フレームレートです.
+    float       BuildMeanMs;    //!< フレーム構築時間(フェンス待ちを除く)の平均値[ms]です.
+    float       BuildMaxMs;     //!< フレーム構築時間の最大値[ms]です.
+    float       WaitMeanMs;     //!< フェンス待ち時間の平均値[ms]です.
+    float       WaitMaxMs;      //!< フェンス待ち時間の最大値[ms]です.
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// FrameStats class
+///////////////////////////////////////////////////////////////////////////////
+//! @note       直近 WindowSize フレームの時間をリングバッファに記録し, パーセンタイル等を集計します.
+//!             記録は1つのスレッド, 集計は別の1つのスレッドから呼び出せます(ロックを使いません).
+//!             バッファは固定長なので, 記録と集計でメモリ確保は発生しません.
+///////////////////////////////////////////////////////////////////////////////
+class FrameStats
+{
+    //=========================================================================
+    // list of friend classes and methods.
+    //=========================================================================
+    /* NOTHING */
+
+public:
+    //=========================================================================
+    // public variables.
+    //=========================================================================
+    static const uint32_t WindowSize = 1024;    //!< 集計するフレーム数です.
+
+    //=========================================================================
+    // public methods.
+    //=========================================================================
+
+    //-------------------------------------------------------------------------
+    //! @brief      コンストラクタです.
+    //-------------------------------------------------------------------------
+    FrameStats();
+
+    //-------------------------------------------------------------------------
+    //! @brief      デストラクタです.
+    //-------------------------------------------------------------------------
+    ~FrameStats();
+
+    //-------------------------------------------------------------------------
+    //! @brief      記録を破棄します.
+    //!
+    //! @note       記録中のスレッドと同時に呼び出さないでください.
+    //-------------------------------------------------------------------------
+    void Reset();
+
+    //-------------------------------------------------------------------------
+    //! @brief      1フレーム分の時間を記録します.
+    //!
+    //! @param[in]      frameMs     前のフレームからの経過時間[ms]です.
+    //! @param[in]      buildMs     フレームの構築にかかった時間[ms]です(フェンス待ちを除く).
+    //! @param[in]      waitMs      フェンスの完了待ちにかかった時間[ms]です.
+    //-------------------------------------------------------------------------
+    void AddFrame(float frameMs, float buildMs, float waitMs);
+
+    //-------------------------------------------------------------------------
+    //! @brief      これまでに記録したフレーム数を取得します.
+    //-------------------------------------------------------------------------
+    uint64_t GetFrameCount() const;
+
+    //-------------------------------------------------------------------------
+    //! @brief      直近のフレームを集計します.
+    //!
+    //! @param[out]     summary     集計結果の格納先です.
+    //! @retval true    集計に成功.
+    //! @retval false   記録が無い.
+    //! @note       記録中に呼び出した場合, 集計中に上書きされたフレームが混ざることがあります.
+    //-------------------------------------------------------------------------
+    bool GetSummary(FrameStatsSummary& summary);
+
+    //-------------------------------------------------------------------------
+    //! @brief      CSVファイルを開き, 見出しを書き込みます.
+    //!
+    //! @param[in]      path        出力ファイルパスです.
+    //! @retval true    オープンに成功.
+    //! @retval false   オープンに失敗.
+    //-------------------------------------------------------------------------
+    bool OpenCsv(const char* path);
+
+    //-------------------------------------------------------------------------
+    //! @brief      CSVファイルを閉じます.
+    //-------------------------------------------------------------------------
+    void CloseCsv();
+
+    //-------------------------------------------------------------------------
+    //! @brief      集計結果をCSVファイルに1行追加します.
+    //!
+    //! @param[in]      summary     集計結果です.
+    //! @retval true    書き込みに成功.
+    //! @retval false   書き込みに失敗(ファイルが開かれていない場合も含む).
+    //-------------------------------------------------------------------------
+    bool WriteCsv(const FrameStatsSummary& summary);
+
+    //-------------------------------------------------------------------------
+    //! @brief      集計結果を画面表示用の1行の文字列にします.
+    //!
+    //! @param[in]      summary     集計結果です.
+    //! @param[out]     buffer      格納先です.
+    //! @param[in]      size        格納先のサイズです.
+    //-------------------------------------------------------------------------
+    static void FormatOverlay(const FrameStatsSummary& summary, char* buffer, size_t size);
+
+private:
+    //=========================================================================
+    // private variables.
+    //=========================================================================
+    std::array<std::atomic<float>, WindowSize>  m_FrameMs;      //!< フレーム時間です.
+    std::array<std::atomic<float>, WindowSize>  m_BuildMs;      //!< フレーム構築時間です.
+    std::array<std::atomic<float>, WindowSize>  m_WaitMs;       //!< フェンス待ち時間です.
+    std::atomic<uint64_t>                       m_Count;        //!< 記録したフレーム数です.
+    std::array<float, WindowSize>               m_Sorted;       //!< 集計用の作業領域です.
+    std::ofstream                               m_Csv;          //!< CSVファイルです.
+
+    //=========================================================================
+    // private methods.
+    //=========================================================================
+    FrameStats          (const FrameStats&) = delete;
+    void operator =     (const FrameStats&) = delete;
+};
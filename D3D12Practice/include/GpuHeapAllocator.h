@@ -0,0 +1,307 @@
+﻿//-----------------------------------------------------------------------------
+// File : GpuHeapAllocator.h
+// Desc : Placed Resource Heap Sub-Allocator.
+// Copyright(c) Pocol. All right reserved.
+//-----------------------------------------------------------------------------
+#pragma once
+
+//-----------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------
+#include <d3d12.h>
+#include <wrl/client.h>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <TlsfAllocator.h>
+#include <MemoryTracker.h>
+
+
+///////////////////////////////////////////////////////////////////////////////
+// GPU_MEMORY_KIND enum
+///////////////////////////////////////////////////////////////////////////////
+//! @note       リソースヒープ階層1でも置けるよう, リソースの種類ごとにヒープを分けます.
+///////////////////////////////////////////////////////////////////////////////
+enum GPU_MEMORY_KIND
+{
+    GPU_MEMORY_DEFAULT_BUFFER = 0,  //!< DEFAULT ヒープのバッファです.
+    GPU_MEMORY_DEFAULT_TARGET,      //!< DEFAULT ヒープのレンダーターゲット, 深度ステンシルです.
+    GPU_MEMORY_DEFAULT_TEXTURE,     //!< DEFAULT ヒープのそれ以外のテクスチャです.
+    GPU_MEMORY_UPLOAD_BUFFER,       //!< UPLOAD ヒープのバッファです.
+    GPU_MEMORY_READBACK_BUFFER,     //!< READBACK ヒープのバッファです.
+    GPU_MEMORY_KIND_COUNT,
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// GpuAllocation structure
+///////////////////////////////////////////////////////////////////////////////
+struct GpuAllocation
+{
+    uint32_t                    Kind    = GPU_MEMORY_KIND_COUNT;    //!< GPU_MEMORY_KIND です.
+    uint32_t                    Page    = UINT32_MAX;               //!< ページ番号です.
+    TlsfAllocator::Allocation   Block   = { 0, 0, TlsfAllocator::InvalidNode };  //!< ページ内の領域です.
+    uint64_t                    TrackId = MemoryTracker::InvalidId;             //!< メモリトラッカーの記録番号です.
+
+    //-------------------------------------------------------------------------
+    //! @brief      有効かどうかチェックします.
+    //-------------------------------------------------------------------------
+    bool IsValid() const
+    { return Kind < GPU_MEMORY_KIND_COUNT && Block.Node != TlsfAllocator::InvalidNode; }
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// GpuBuffer structure
+///////////////////////////////////////////////////////////////////////////////
+//! @note       UPLOAD / READBACK ヒープの大きなバッファから切り出した範囲です.
+//!             リソースはページと共有なので, 解放しないでください.
+///////////////////////////////////////////////////////////////////////////////
+struct GpuBuffer
+{
+    ID3D12Resource*             pResource   = nullptr;  //!< ページのバッファです.
+    uint64_t                    Offset      = 0;        //!< バッファ内のオフセットです.
+    uint64_t                    Size        = 0;        //!< サイズです.
+    D3D12_GPU_VIRTUAL_ADDRESS   GpuAddress  = 0;        //!< GPU仮想アドレスです.
+    uint8_t*                    pCpu        = nullptr;  //!< マップ済みのCPUアドレスです.
+    GpuAllocation               Allocation;             //!< 確保情報です.
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// GpuHeapAllocator class
+///////////////////////////////////////////////////////////////////////////////
+//! @note       大きなヒープ(ページ)を種類ごとに確保し, TLSF で切り分けて配置リソースを作ります.
+//!             ページより大きいリソースには専用のページを作ります.
+//!             UPLOAD / READBACK の小さなバッファはページ全体を覆うバッファから範囲を切り出すので,
+//!             64KB の配置アライメントで無駄になりません.
+//!             解放はGPUが使い終わってから行ってください. スレッドセーフです.
+///////////////////////////////////////////////////////////////////////////////
+class GpuHeapAllocator
+{
+    //=========================================================================
+    // list of friend classes and methods.
+    //=========================================================================
+    /* NOTHING */
+
+public:
+    //=========================================================================
+    // public variables.
+    //=========================================================================
+    static const uint64_t DefaultPageSize   = 64ull * 1024 * 1024;     //!< 既定のページサイズです.
+    static const uint64_t BufferGranularity = 256;                      //!< バッファを切り出す最小単位です.
+
+    //=========================================================================
+    // public methods.
+    //=========================================================================
+
+    //-------------------------------------------------------------------------
+    //! @brief      コンストラクタです.
+    //-------------------------------------------------------------------------
+    GpuHeapAllocator();
+
+    //-------------------------------------------------------------------------
+    //! @brief      デストラクタです.
+    //-------------------------------------------------------------------------
+    ~GpuHeapAllocator();
+
+    //-------------------------------------------------------------------------
+    //! @brief      初期化処理を行います.
+    //!
+    //! @param[in]      pDevice     デバイスです.
+    //! @param[in]      pageSize    1ページのサイズです(64KB の倍数).
+    //! @retval true    初期化に成功.
+    //! @retval false   初期化に失敗.
+    //-------------------------------------------------------------------------
+    bool Init(ID3D12Device* pDevice, uint64_t pageSize = DefaultPageSize);
+
+    //-------------------------------------------------------------------------
+    //! @brief      終了処理を行います.
+    //!
+    //! @note       配置したリソースはすべて先に解放しておいてください.
+    //-------------------------------------------------------------------------
+    void Term();
+
+    //-------------------------------------------------------------------------
+    //! @brief      配置リソースを生成します.
+    //!
+    //! @param[in]      heapType        ヒープタイプです.
+    //! @param[in]      desc            リソースの設定です.
+    //! @param[in]      state           初期状態です.
+    //! @param[in]      pClearValue     最適化クリア値です(nullptr可).
+    //! @param[out]     ppResource      リソースの格納先です.
+    //! @param[out]     allocation      確保情報の格納先です.
+    //! @param[in]      category        メモリ使用量を計上するカテゴリです.
+    //! @param[in]      name            解放漏れの報告に使う名前です(文字列リテラル).
+    //! @retval true    生成に成功.
+    //! @retval false   生成に失敗.
+    //-------------------------------------------------------------------------
+    bool CreateResource(
+        D3D12_HEAP_TYPE             heapType,
+        const D3D12_RESOURCE_DESC&  desc,
+        D3D12_RESOURCE_STATES       state,
+        const D3D12_CLEAR_VALUE*    pClearValue,
+        ID3D12Resource**            ppResource,
+        GpuAllocation&              allocation,
+        MEMORY_CATEGORY             category    = MEMORY_CATEGORY_OTHER,
+        const char*                 name        = nullptr);
+
+    //-------------------------------------------------------------------------
+    //! @brief      確保済みのメモリに別のリソースを重ねて配置します.
+    //!
+    //! @param[in]      allocation      重ねる先の確保情報です.
+    //! @param[in]      offset          確保領域内のオフセットです.
+    //! @param[in]      desc            リソースの設定です.
+    //! @param[in]      state           初期状態です.
+    //! @param[in]      pClearValue     最適化クリア値です(nullptr可).
+    //! @param[out]     ppResource      リソースの格納先です.
+    //! @retval true    生成に成功.
+    //! @retval false   領域に収まらないか, 生成に失敗.
+    //! @note       寿命が重ならないリソース同士で使い, 切り替え時にエイリアシングバリアを発行してください.
+    //!             使う前にクリア, 破棄(DiscardResource), または全体のコピーで初期化が必要です.
+    //-------------------------------------------------------------------------
+    bool CreateAliasedResource(
+        const GpuAllocation&        allocation,
+        uint64_t                    offset,
+        const D3D12_RESOURCE_DESC&  desc,
+        D3D12_RESOURCE_STATES       state,
+        const D3D12_CLEAR_VALUE*    pClearValue,
+        ID3D12Resource**            ppResource);
+
+    //-------------------------------------------------------------------------
+    //! @brief      リソースを置かずにメモリだけを確保します.
+    //!
+    //! @param[in]      kind            メモリの種類です.
+    //! @param[in]      size            サイズです.
+    //! @param[in]      alignment       アライメントです.
+    //! @param[out]     allocation      確保情報の格納先です.
+    //! @param[in]      category        メモリ使用量を計上するカテゴリです.
+    //! @param[in]      name            解放漏れの報告に使う名前です(文字列リテラル).
+    //! @retval true    確保に成功.
+    //! @retval false   確保に失敗.
+    //! @note       フレームグラフの一時リソースのように, 後から CreateAliasedResource() で複数のリソースを置く用途です.
+    //!             重ねて置いたリソースは確保した領域の分だけ計上されます.
+    //-------------------------------------------------------------------------
+    bool Allocate(
+        GPU_MEMORY_KIND     kind,
+        uint64_t            size,
+        uint64_t            alignment,
+        GpuAllocation&      allocation,
+        MEMORY_CATEGORY     category    = MEMORY_CATEGORY_OTHER,
+        const char*         name        = nullptr);
+
+    //-------------------------------------------------------------------------
+    //! @brief      UPLOAD / READBACK ヒープのバッファから範囲を切り出します.
+    //!
+    //! @param[in]      heapType        D3D12_HEAP_TYPE_UPLOAD または D3D12_HEAP_TYPE_READBACK です.
+    //! @param[in]      size            サイズです.
+    //! @param[in]      alignment       アライメントです(定数バッファなら256).
+    //! @param[out]     buffer          切り出した範囲の格納先です.
+    //! @param[in]      category        メモリ使用量を計上するカテゴリです.
+    //! @param[in]      name            解放漏れの報告に使う名前です(文字列リテラル).
+    //! @retval true    確保に成功.
+    //! @retval false   確保に失敗.
+    //-------------------------------------------------------------------------
+    bool AllocateBuffer(
+        D3D12_HEAP_TYPE     heapType,
+        uint64_t            size,
+        uint64_t            alignment,
+        GpuBuffer&          buffer,
+        MEMORY_CATEGORY     category    = MEMORY_CATEGORY_OTHER,
+        const char*         name        = nullptr);
+
+    //-------------------------------------------------------------------------
+    //! @brief      メモリを解放します.
+    //!
+    //! @param[in,out]  allocation      確保情報です. 解放後に無効になります.
+    //-------------------------------------------------------------------------
+    void Free(GpuAllocation& allocation);
+
+    //-------------------------------------------------------------------------
+    //! @brief      切り出したバッファを解放します.
+    //!
+    //! @param[in,out]  buffer          切り出した範囲です. 解放後に無効になります.
+    //-------------------------------------------------------------------------
+    void Free(GpuBuffer& buffer);
+
+    //-------------------------------------------------------------------------
+    //! @brief      メモリの種類ごとの統計を取得します.
+    //-------------------------------------------------------------------------
+    TlsfStats GetStats(GPU_MEMORY_KIND kind) const;
+
+    //-------------------------------------------------------------------------
+    //! @brief      使用量と断片化のレポートを作成します.
+    //-------------------------------------------------------------------------
+    std::string FormatReport() const;
+
+private:
+    ///////////////////////////////////////////////////////////////////////////
+    // Page structure
+    ///////////////////////////////////////////////////////////////////////////
+    struct Page
+    {
+        Microsoft::WRL::ComPtr<ID3D12Heap>      pHeap;          //!< ヒープです.
+        Microsoft::WRL::ComPtr<ID3D12Resource>  pBuffer;        //!< ページ全体を覆うバッファです(UPLOAD / READBACK のみ).
+        uint8_t*                                pMapped;        //!< バッファのマップ先です.
+        TlsfAllocator                           Allocator;      //!< ページ内の割り当てです.
+        bool                                    Dedicated;      //!< 1つのリソース専用のページかどうか.
+    };
+
+    //=========================================================================
+    // private variables.
+    //=========================================================================
+    Microsoft::WRL::ComPtr<ID3D12Device>    m_pDevice;                          //!< デバイスです.
+    uint64_t                                m_PageSize;                         //!< 1ページのサイズです.
+    std::vector<std::unique_ptr<Page>>      m_Pages[GPU_MEMORY_KIND_COUNT];     //!< 種類ごとのページです.
+    mutable std::mutex                      m_Mutex;                            //!< ミューテックスです.
+
+    //=========================================================================
+    // private methods.
+    //=========================================================================
+
+    //-------------------------------------------------------------------------
+    //! @brief      ページから領域を確保します(必要ならページを追加します).
+    //-------------------------------------------------------------------------
+    bool AllocateLocked(GPU_MEMORY_KIND kind, uint64_t size, uint64_t alignment, GpuAllocation& allocation);
+
+    //-------------------------------------------------------------------------
+    //! @brief      ページを追加します.
+    //-------------------------------------------------------------------------
+    Page* AddPage(GPU_MEMORY_KIND kind, uint64_t size, uint64_t alignment, bool dedicated, uint32_t& index);
+
+    //-------------------------------------------------------------------------
+    //! @brief      領域を解放します(空になった専用ページは破棄します).
+    //-------------------------------------------------------------------------
+    void FreeLocked(GpuAllocation& allocation);
+
+    GpuHeapAllocator    (const GpuHeapAllocator&) = delete;
+    void operator =     (const GpuHeapAllocator&) = delete;
+};
+
+//-----------------------------------------------------------------------------
+//! @brief      リソースが使うメモリのサイズを取得します.
+//!
+//! @param[in]      pResource       リソースです.
+//! @return     サイズ[byte]を返却します. 取得できない場合は0を返却します.
+//-----------------------------------------------------------------------------
+uint64_t GetResourceSize(ID3D12Resource* pResource);
+
+//-----------------------------------------------------------------------------
+//! @brief      アロケータを通さずに生成したリソースのメモリ使用量を計上します.
+//!
+//! @param[in]      pResource       リソースです.
+//! @param[in]      category        カテゴリです.
+//! @param[in]      name            解放漏れの報告に使う名前です(文字列リテラル).
+//! @return     記録番号を返却します. リソースの破棄時に GetMemoryTracker().Remove() に渡してください.
+//! @note       コミットリソースやスワップチェインのバッファ用です.
+//-----------------------------------------------------------------------------
+uint64_t TrackResource(ID3D12Resource* pResource, MEMORY_CATEGORY category, const char* name);
+
+//-----------------------------------------------------------------------------
+//! @brief      デバイスのローカルビデオメモリの予算と使用量を問い合わせます.
+//!
+//! @param[in]      pDevice         デバイスです.
+//! @param[out]     budget          OSが示す予算[byte]の格納先です.
+//! @param[out]     usage           プロセスの使用量[byte]の格納先です.
+//! @retval true    取得に成功.
+//! @retval false   IDXGIAdapter3 が使えない.
+//-----------------------------------------------------------------------------
+bool QueryVideoMemory(ID3D12Device* pDevice, uint64_t& budget, uint64_t& usage);
@@ -0,0 +1,180 @@
+﻿//-----------------------------------------------------------------------------
+// File : GpuTimer.h
+// Desc : GPU Timestamp Timer.
+// Copyright(c) Pocol. All right reserved.
+//-----------------------------------------------------------------------------
+#pragma once
+
+//-----------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------
+#include <d3d12.h>
+#include <wrl/client.h>
+#include <GpuHeapAllocator.h>
+#include <string>
+#include <vector>
+
+
+///////////////////////////////////////////////////////////////////////////////
+// GpuTimerSample structure
+///////////////////////////////////////////////////////////////////////////////
+struct GpuTimerSample
+{
+    std::string     Name;       //!< スコープ名です.
+    double          BeginUs;    //!< 開始時刻[us]です(CPUの steady_clock の起点から).
+    double          EndUs;      //!< 終了時刻[us]です(CPUの steady_clock の起点から).
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// GpuTimer class
+///////////////////////////////////////////////////////////////////////////////
+//! @note       タイムスタンプクエリでパスごとのGPU時間を計測します.
+//!             結果は同じフレームバッファを再利用するとき(FrameCount フレーム後)に読み戻すので, 待ちは発生しません.
+///////////////////////////////////////////////////////////////////////////////
+class GpuTimer
+{
+    //=========================================================================
+    // list of friend classes and methods.
+    //=========================================================================
+    /* NOTHING */
+
+public:
+    //=========================================================================
+    // public variables.
+    //=========================================================================
+    static const uint32_t FrameCount    = 2;            //!< フレームバッファ数です.
+    static const uint32_t InvalidScope  = UINT32_MAX;   //!< 無効なスコープ番号です.
+
+    //=========================================================================
+    // public methods.
+    //=========================================================================
+
+    //-------------------------------------------------------------------------
+    //! @brief      コンストラクタです.
+    //-------------------------------------------------------------------------
+    GpuTimer();
+
+    //-------------------------------------------------------------------------
+    //! @brief      デストラクタです.
+    //-------------------------------------------------------------------------
+    ~GpuTimer();
+
+    //-------------------------------------------------------------------------
+    //! @brief      初期化処理を行います.
+    //!
+    //! @param[in]      pDevice     デバイスです.
+    //! @param[in]      pAllocator  読み戻し用バッファを確保するアロケータです.
+    //! @param[in]      pQueue      計測するコマンドキューです.
+    //! @param[in]      maxScopes   1フレームあたりの最大スコープ数です.
+    //! @retval true    初期化に成功.
+    //! @retval false   初期化に失敗.
+    //-------------------------------------------------------------------------
+    bool Init(ID3D12Device* pDevice, GpuHeapAllocator* pAllocator, ID3D12CommandQueue* pQueue, uint32_t maxScopes);
+
+    //-------------------------------------------------------------------------
+    //! @brief      終了処理を行います.
+    //-------------------------------------------------------------------------
+    void Term();
+
+    //-------------------------------------------------------------------------
+    //! @brief      フレームの計測を開始します.
+    //!
+    //! @param[in]      frameIndex  フレーム番号です.
+    //! @note       同じフレーム番号で前回記録した結果を集計します. GPUの完了を待ってから呼び出してください.
+    //-------------------------------------------------------------------------
+    void BeginFrame(uint32_t frameIndex);
+
+    //-------------------------------------------------------------------------
+    //! @brief      スコープの計測を開始します.
+    //!
+    //! @param[in]      pCmd        コマンドリストです.
+    //! @param[in]      name        スコープ名です.
+    //! @return     スコープ番号を返却します. 上限を超えた場合は InvalidScope を返却します.
+    //-------------------------------------------------------------------------
+    uint32_t Begin(ID3D12GraphicsCommandList* pCmd, const char* name);
+
+    //-------------------------------------------------------------------------
+    //! @brief      スコープの計測を終了します.
+    //!
+    //! @param[in]      pCmd        コマンドリストです.
+    //! @param[in]      scope       Begin() が返却したスコープ番号です.
+    //-------------------------------------------------------------------------
+    void End(ID3D12GraphicsCommandList* pCmd, uint32_t scope);
+
+    //-------------------------------------------------------------------------
+    //! @brief      フレームの計測を終了し, クエリを読み戻し用バッファに解決します.
+    //!
+    //! @param[in]      pCmd        コマンドリストです.
+    //-------------------------------------------------------------------------
+    void EndFrame(ID3D12GraphicsCommandList* pCmd);
+
+    //-------------------------------------------------------------------------
+    //! @brief      集計をリセットします.
+    //-------------------------------------------------------------------------
+    void ResetStats();
+
+    //-------------------------------------------------------------------------
+    //! @brief      直前の BeginFrame() で集計したフレームのGPU時間を取得します.
+    //!
+    //! @param[out]     ms          最初のスコープの開始から最後のスコープの終了までの時間[ms]です.
+    //! @retval true    取得に成功.
+    //! @retval false   集計した結果がありません.
+    //-------------------------------------------------------------------------
+    bool GetLastFrameMs(double& ms) const;
+
+    //-------------------------------------------------------------------------
+    //! @brief      直前の BeginFrame() で集計したフレームのスコープごとの時刻を取得します.
+    //!
+    //! @note       CPUのタイムラインと並べられるよう, Calibrate() で合わせた時刻に変換済みです.
+    //-------------------------------------------------------------------------
+    const std::vector<GpuTimerSample>& GetLastFrameSamples() const;
+
+    //-------------------------------------------------------------------------
+    //! @brief      GPUのタイムスタンプとCPUの時刻の対応を取り直します.
+    //!
+    //! @retval true    取得に成功.
+    //! @retval false   取得に失敗.
+    //! @note       初期化時にも呼び出します. クロックのずれが気になる場合はキャプチャの前に呼び出してください.
+    //-------------------------------------------------------------------------
+    bool Calibrate();
+
+    //-------------------------------------------------------------------------
+    //! @brief      スコープごとの平均時間を文字列にします.
+    //-------------------------------------------------------------------------
+    std::string FormatReport() const;
+
+private:
+    ///////////////////////////////////////////////////////////////////////////
+    // Stats structure
+    ///////////////////////////////////////////////////////////////////////////
+    struct Stats
+    {
+        std::string Name;       //!< スコープ名です.
+        double      TotalMs;    //!< 合計時間[ms]です.
+        double      MaxMs;      //!< 最大時間[ms]です.
+        uint32_t    Count;      //!< 計測回数です.
+    };
+
+    //=========================================================================
+    // private variables.
+    //=========================================================================
+    Microsoft::WRL::ComPtr<ID3D12QueryHeap>     m_pQueryHeap;           //!< クエリヒープです.
+    GpuHeapAllocator*                           m_pAllocator;           //!< 読み戻し用バッファを確保したアロケータです.
+    GpuBuffer                                   m_Readback;             //!< 読み戻し用バッファです(マップ済み).
+    Microsoft::WRL::ComPtr<ID3D12CommandQueue>  m_pQueue;               //!< 計測するコマンドキューです.
+    double                                      m_TickToMs;             //!< タイムスタンプからミリ秒への変換係数です.
+    uint32_t                                    m_MaxScopes;            //!< 1フレームあたりの最大スコープ数です.
+    uint32_t                                    m_FrameIndex;           //!< 記録中のフレーム番号です.
+    double                                      m_LastFrameMs;          //!< 直前に集計したフレームのGPU時間[ms]です(負なら無し).
+    uint64_t                                    m_CalibrationTick;      //!< 対応を取ったときのGPUのタイムスタンプです.
+    double                                      m_CalibrationUs;        //!< 対応を取ったときのCPUの時刻[us]です.
+    std::vector<GpuTimerSample>                 m_Samples;              //!< 直前に集計したフレームのスコープごとの時刻です.
+    std::vector<std::string>                    m_Names[FrameCount];    //!< フレームごとのスコープ名です.
+    std::vector<Stats>                          m_Stats;                //!< スコープごとの集計です.
+
+    //=========================================================================
+    // private methods.
+    //=========================================================================
+    GpuTimer            (const GpuTimer&) = delete;
+    void operator =     (const GpuTimer&) = delete;
+};
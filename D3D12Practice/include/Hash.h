@@ -0,0 +1,114 @@
+﻿//-----------------------------------------------------------------------------
+// File : Hash.h
+// Desc : Hash Utility.
+// Copyright(c) Pocol. All right reserved.
+//-----------------------------------------------------------------------------
+#pragma once
+
+//-----------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+
+//-----------------------------------------------------------------------------
+// Constant Values.
+//-----------------------------------------------------------------------------
+constexpr uint64_t FNV1A_OFFSET_BASIS = 0xcbf29ce484222325ull;  //!< FNV-1aの初期値です.
+constexpr uint64_t FNV1A_PRIME        = 0x100000001b3ull;       //!< FNV-1aの乗数です.
+
+//-----------------------------------------------------------------------------
+//! @brief      FNV-1a(64bit)でハッシュ値を計算します.
+//!
+//! @param[in]      pData       データです.
+//! @param[in]      size        データサイズです.
+//! @param[in]      seed        初期値です.
+//! @return     ハッシュ値を返却します.
+//-----------------------------------------------------------------------------
+inline uint64_t HashFNV1a64(const void* pData, size_t size, uint64_t seed = FNV1A_OFFSET_BASIS)
+{
+    auto ptr  = static_cast<const uint8_t*>(pData);
+    auto hash = seed;
+    for (size_t i = 0; i < size; ++i)
+    {
+        hash ^= ptr[i];
+        hash *= FNV1A_PRIME;
+    }
+    return hash;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Hasher class
+///////////////////////////////////////////////////////////////////////////////
+class Hasher
+{
+    //=========================================================================
+    // list of friend classes and methods.
+    //=========================================================================
+    /* NOTHING */
+
+public:
+    //=========================================================================
+    // public variables.
+    //=========================================================================
+    /* NOTHING */
+
+    //=========================================================================
+    // public methods.
+    //=========================================================================
+
+    //-------------------------------------------------------------------------
+    //! @brief      コンストラクタです.
+    //-------------------------------------------------------------------------
+    Hasher()
+    : m_Hash(FNV1A_OFFSET_BASIS)
+    { /* DO_NOTHING */ }
+
+    //-------------------------------------------------------------------------
+    //! @brief      バイト列を追加します.
+    //-------------------------------------------------------------------------
+    Hasher& AddBytes(const void* pData, size_t size)
+    {
+        m_Hash = HashFNV1a64(pData, size, m_Hash);
+        return *this;
+    }
+
+    //-------------------------------------------------------------------------
+    //! @brief      値を追加します.
+    //!
+    //! @note       パディングを含む構造体は渡さず, メンバーごとに追加してください.
+    //-------------------------------------------------------------------------
+    template<typename T>
+    Hasher& Add(const T& value)
+    {
+        static_assert(std::is_arithmetic<T>::value || std::is_enum<T>::value, "Add() accepts scalar values only.");
+        return AddBytes(&value, sizeof(T));
+    }
+
+    //-------------------------------------------------------------------------
+    //! @brief      文字列を追加します(終端文字を含みます).
+    //-------------------------------------------------------------------------
+    Hasher& AddString(const char* value)
+    {
+        if (value == nullptr)
+        { return Add(uint8_t(0xff)); }
+
+        return AddBytes(value, strlen(value) + 1);
+    }
+
+    //-------------------------------------------------------------------------
+    //! @brief      ハッシュ値を取得します.
+    //-------------------------------------------------------------------------
+    uint64_t GetValue() const
+    { return m_Hash; }
+
+private:
+    //=========================================================================
+    // private variables.
+    //=========================================================================
+    uint64_t    m_Hash;     //!< ハッシュ値です.
+};
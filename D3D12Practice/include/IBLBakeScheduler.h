@@ -0,0 +1,186 @@
+﻿//-----------------------------------------------------------------------------
+// File : IBLBakeScheduler.h
+// Desc : Time Sliced Bake Scheduler.
+// Copyright(c) Pocol. All right reserved.
+//-----------------------------------------------------------------------------
+#pragma once
+
+//-----------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+
+
+///////////////////////////////////////////////////////////////////////////////
+// IBLBakeScheduler class
+///////////////////////////////////////////////////////////////////////////////
+//! @note       作業の種類ごとに重み1あたりのコストを見積もり, 1フレームの見積もりの合計が予算に収まるだけ発行します.
+//!             フレームごとに発行した作業を覚えておき, 後から届いたGPU時間を見積もりの比で種類ごとに分けて見積もりを更新します.
+//!             グラフィックスAPIにも時計にも依存しないので, 模擬的なクロックで動作を確認できます.
+///////////////////////////////////////////////////////////////////////////////
+class IBLBakeScheduler
+{
+    //=========================================================================
+    // list of friend classes and methods.
+    //=========================================================================
+    /* NOTHING */
+
+public:
+    ///////////////////////////////////////////////////////////////////////////
+    // WorkUnit structure
+    ///////////////////////////////////////////////////////////////////////////
+    struct WorkUnit
+    {
+        uint32_t    Kind;       //!< 作業の種類です.
+        uint32_t    Index;      //!< 種類内での番号です.
+        double      Weight;     //!< 重みです(同じ種類の作業どうしのコストの比).
+    };
+
+    ///////////////////////////////////////////////////////////////////////////
+    // Stats structure
+    ///////////////////////////////////////////////////////////////////////////
+    struct Stats
+    {
+        uint32_t    IssuedUnits;        //!< 発行済み作業数です.
+        uint32_t    BakeFrames;         //!< 作業を発行したフレーム数です.
+        uint32_t    OverBudgetFrames;   //!< 予算を超過したフレーム数です.
+        double      MaxFrameCost;       //!< 1フレームあたりの最大見積もりコスト[ms]です.
+    };
+
+    //=========================================================================
+    // public variables.
+    //=========================================================================
+    static const uint32_t MaxKindCount = 8;     //!< 作業の種類の最大数です.
+    static const uint32_t HistorySize  = 4;     //!< 計測結果を待つフレーム数です.
+
+    //=========================================================================
+    // public methods.
+    //=========================================================================
+
+    //-------------------------------------------------------------------------
+    //! @brief      コンストラクタです.
+    //-------------------------------------------------------------------------
+    IBLBakeScheduler();
+
+    //-------------------------------------------------------------------------
+    //! @brief      1フレームあたりのGPU時間予算を設定します.
+    //!
+    //! @param[in]      budgetMs        予算[ms]です.
+    //-------------------------------------------------------------------------
+    void SetBudget(double budgetMs);
+
+    //-------------------------------------------------------------------------
+    //! @brief      作業の種類ごとのコスト見積もりを設定します.
+    //!
+    //! @param[in]      kind            作業の種類です.
+    //! @param[in]      costMs          重み1あたりの見積もりコスト[ms]です.
+    //-------------------------------------------------------------------------
+    void SetCostEstimate(uint32_t kind, double costMs);
+
+    //-------------------------------------------------------------------------
+    //! @brief      作業の種類ごとのコスト見積もりを取得します.
+    //-------------------------------------------------------------------------
+    double GetCostEstimate(uint32_t kind) const;
+
+    //-------------------------------------------------------------------------
+    //! @brief      未発行の作業と統計を破棄します.
+    //-------------------------------------------------------------------------
+    void Reset();
+
+    //-------------------------------------------------------------------------
+    //! @brief      作業を追加します.
+    //!
+    //! @param[in]      kind            作業の種類です.
+    //! @param[in]      index           種類内での番号です.
+    //! @param[in]      weight          重みです. 見積もりコストはこの値を掛けたものになります.
+    //-------------------------------------------------------------------------
+    void Push(uint32_t kind, uint32_t index = 0, double weight = 1.0);
+
+    //-------------------------------------------------------------------------
+    //! @brief      フレームの開始を通知します.
+    //!
+    //! @param[in]      frameIndex      フレーム番号です. ReportFrame() で同じ番号を渡します.
+    //! @note       同じ番号で記録した作業のうち, 計測結果が届いていないものは破棄します.
+    //-------------------------------------------------------------------------
+    void BeginFrame(uint32_t frameIndex);
+
+    //-------------------------------------------------------------------------
+    //! @brief      このフレームで発行する次の作業を取得します.
+    //!
+    //! @param[out]     unit            発行する作業の格納先です.
+    //! @retval true    予算内に作業が収まるため発行します.
+    //! @retval false   作業が無いか, このフレームの予算を使い切りました.
+    //! @note       進行を保証するため, 1フレームに少なくとも1つは発行します.
+    //-------------------------------------------------------------------------
+    bool Next(WorkUnit& unit);
+
+    //-------------------------------------------------------------------------
+    //! @brief      計測した作業時間を報告し, 見積もりを更新します.
+    //!
+    //! @param[in]      kind            作業の種類です.
+    //! @param[in]      measuredMs      計測時間[ms]です.
+    //! @param[in]      weight          計測した作業の重みの合計です.
+    //-------------------------------------------------------------------------
+    void Report(uint32_t kind, double measuredMs, double weight = 1.0);
+
+    //-------------------------------------------------------------------------
+    //! @brief      フレームで発行した作業全体の計測時間を報告し, 見積もりを更新します.
+    //!
+    //! @param[in]      frameIndex      作業を発行したときに BeginFrame() に渡したフレーム番号です.
+    //! @param[in]      measuredMs      そのフレームで発行した作業全体の計測時間[ms]です.
+    //! @note       計測時間は発行時の見積もりの比で種類ごとに分けます. 作業を発行していなければ何もしません.
+    //-------------------------------------------------------------------------
+    void ReportFrame(uint32_t frameIndex, double measuredMs);
+
+    //-------------------------------------------------------------------------
+    //! @brief      未発行の作業が無いかどうかチェックします.
+    //-------------------------------------------------------------------------
+    bool IsEmpty() const;
+
+    //-------------------------------------------------------------------------
+    //! @brief      未発行の作業数を取得します.
+    //-------------------------------------------------------------------------
+    size_t GetPendingCount() const;
+
+    //-------------------------------------------------------------------------
+    //! @brief      このフレームで消費した見積もりコスト[ms]を取得します.
+    //-------------------------------------------------------------------------
+    double GetFrameCost() const;
+
+    //-------------------------------------------------------------------------
+    //! @brief      統計を取得します.
+    //-------------------------------------------------------------------------
+    const Stats& GetStats() const;
+
+private:
+    ///////////////////////////////////////////////////////////////////////////
+    // Issued structure
+    ///////////////////////////////////////////////////////////////////////////
+    struct Issued
+    {
+        uint32_t    FrameIndex;                 //!< フレーム番号です.
+        bool        Valid;                      //!< 計測結果を待っているかどうか.
+        double      Weight[MaxKindCount];       //!< 種類ごとの重みの合計です.
+        double      Cost  [MaxKindCount];       //!< 種類ごとの見積もりコストの合計です.
+    };
+
+    //=========================================================================
+    // private variables.
+    //=========================================================================
+    std::deque<WorkUnit>    m_Queue;                    //!< 未発行の作業です.
+    double                  m_Cost[MaxKindCount];       //!< 種類ごとの重み1あたりの見積もりコストです.
+    double                  m_Budget;                   //!< 1フレームあたりの予算です.
+    double                  m_FrameCost;                //!< このフレームで消費したコストです.
+    uint32_t                m_FrameIssued;              //!< このフレームで発行した作業数です.
+    Issued*                 m_pCurrent;                 //!< このフレームで発行した作業の記録先です.
+    Issued                  m_Issued[HistorySize];      //!< フレームごとに発行した作業です.
+    Stats                   m_Stats;                    //!< 統計です.
+
+    //=========================================================================
+    // private methods.
+    //=========================================================================
+    IBLBakeScheduler    (const IBLBakeScheduler&) = delete;
+    void operator =     (const IBLBakeScheduler&) = delete;
+};
@@ -0,0 +1,392 @@
+﻿//-----------------------------------------------------------------------------
+// File : JsonParser.h
+// Desc : Minimal JSON Parser.
+// Copyright(c) Pocol. All right reserved.
+//-----------------------------------------------------------------------------
+#pragma once
+
+//-----------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <utility>
+#include <vector>
+
+
+///////////////////////////////////////////////////////////////////////////////
+// JSON_TYPE enum
+///////////////////////////////////////////////////////////////////////////////
+enum JSON_TYPE
+{
+    JSON_TYPE_NULL = 0,     //!< null です.
+    JSON_TYPE_BOOL,         //!< 真偽値です.
+    JSON_TYPE_NUMBER,       //!< 数値です.
+    JSON_TYPE_STRING,       //!< 文字列です.
+    JSON_TYPE_ARRAY,        //!< 配列です.
+    JSON_TYPE_OBJECT,       //!< オブジェクトです.
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// JsonValue structure
+///////////////////////////////////////////////////////////////////////////////
+struct JsonValue
+{
+    JSON_TYPE                                       Type    = JSON_TYPE_NULL;   //!< 型です.
+    bool                                            Bool    = false;            //!< 真偽値です.
+    double                                          Number  = 0.0;              //!< 数値です.
+    std::string                                     String;                     //!< 文字列です.
+    std::vector<JsonValue>                          Array;                      //!< 配列です.
+    std::vector<std::pair<std::string, JsonValue>>  Object;                     //!< オブジェクトです(記述順).
+
+    //-------------------------------------------------------------------------
+    //! @brief      オブジェクトのメンバーを検索します.
+    //!
+    //! @param[in]      name        メンバー名です.
+    //! @return     見つからないかオブジェクトでなければ nullptr を返却します.
+    //-------------------------------------------------------------------------
+    const JsonValue* Find(const char* name) const
+    {
+        if (Type != JSON_TYPE_OBJECT)
+        { return nullptr; }
+
+        for (auto& member : Object)
+        {
+            if (member.first == name)
+            { return &member.second; }
+        }
+        return nullptr;
+    }
+};
+
+
+///////////////////////////////////////////////////////////////////////////////
+// JsonParser class
+///////////////////////////////////////////////////////////////////////////////
+//! @note       ベンチマーク結果やトレースを読むためのツール用の実装です.
+//!             RFC 8259 の文法に従い, 重複したメンバー名, 制御文字, nan や inf は不正とします.
+//!             \u エスケープは UTF-8 に変換します.
+///////////////////////////////////////////////////////////////////////////////
+class JsonParser
+{
+    //=========================================================================
+    // list of friend classes and methods.
+    //=========================================================================
+    /* NOTHING */
+
+public:
+    //=========================================================================
+    // public variables.
+    //=========================================================================
+    /* NOTHING */
+
+    //=========================================================================
+    // public methods.
+    //=========================================================================
+
+    //-------------------------------------------------------------------------
+    //! @brief      文字列を解析します.
+    //!
+    //! @param[in]      text        解析する文字列です.
+    //! @param[out]     result      解析結果です.
+    //! @retval true    解析に成功.
+    //! @retval false   解析に失敗.
+    //-------------------------------------------------------------------------
+    static bool Parse(const std::string& text, JsonValue& result)
+    {
+        JsonParser parser(text);
+        if (!parser.ParseValue(result, 0))
+        { return false; }
+
+        parser.SkipSpace();
+        return parser.m_Pos == text.size();
+    }
+
+private:
+    //=========================================================================
+    // private variables.
+    //=========================================================================
+    static const uint32_t MaxDepth = 64;    //!< 入れ子の最大数です.
+
+    const std::string&  m_Text;     //!< 解析する文字列です.
+    size_t              m_Pos;      //!< 現在の位置です.
+
+    //=========================================================================
+    // private methods.
+    //=========================================================================
+    JsonParser(const std::string& text)
+    : m_Text(text)
+    , m_Pos (0)
+    { /* DO_NOTHING */ }
+
+    void SkipSpace()
+    {
+        while (m_Pos < m_Text.size())
+        {
+            auto c = m_Text[m_Pos];
+            if (c != ' ' && c != '\t' && c != '\r' && c != '\n')
+            { break; }
+            m_Pos++;
+        }
+    }
+
+    bool Consume(const char* token)
+    {
+        auto length = strlen(token);
+        if (m_Text.compare(m_Pos, length, token) != 0)
+        { return false; }
+
+        m_Pos += length;
+        return true;
+    }
+
+    bool ParseHex4(uint32_t& result)
+    {
+        if (m_Pos + 4 > m_Text.size())
+        { return false; }
+
+        result = 0;
+        for (auto i = 0; i < 4; ++i)
+        {
+            auto c = m_Text[m_Pos++];
+            result <<= 4;
+            if      (c >= '0' && c <= '9') { result |= uint32_t(c - '0'); }
+            else if (c >= 'a' && c <= 'f') { result |= uint32_t(c - 'a' + 10); }
+            else if (c >= 'A' && c <= 'F') { result |= uint32_t(c - 'A' + 10); }
+            else { return false; }
+        }
+        return true;
+    }
+
+    static void AppendUtf8(std::string& result, uint32_t code)
+    {
+        if (code < 0x80)
+        { result += char(code); }
+        else if (code < 0x800)
+        {
+            result += char(0xc0 | (code >> 6));
+            result += char(0x80 | (code & 0x3f));
+        }
+        else if (code < 0x10000)
+        {
+            result += char(0xe0 | (code >> 12));
+            result += char(0x80 | ((code >> 6) & 0x3f));
+            result += char(0x80 | (code & 0x3f));
+        }
+        else
+        {
+            result += char(0xf0 | (code >> 18));
+            result += char(0x80 | ((code >> 12) & 0x3f));
+            result += char(0x80 | ((code >> 6) & 0x3f));
+            result += char(0x80 | (code & 0x3f));
+        }
+    }
+
+    bool ParseString(std::string& result)
+    {
+        if (!Consume("\""))
+        { return false; }
+
+        result.clear();
+        while (m_Pos < m_Text.size())
+        {
+            auto c = m_Text[m_Pos++];
+            if (c == '"')
+            { return true; }
+
+            if (uint8_t(c) < 0x20)
+            { return false; }
+
+            if (c != '\\')
+            {
+                result += c;
+                continue;
+            }
+
+            if (m_Pos >= m_Text.size())
+            { return false; }
+
+            c = m_Text[m_Pos++];
+            switch (c)
+            {
+            case '"':  result += '"';  break;
+            case '\\': result += '\\'; break;
+            case '/':  result += '/';  break;
+            case 'b':  result += '\b'; break;
+            case 'f':  result += '\f'; break;
+            case 'n':  result += '\n'; break;
+            case 'r':  result += '\r'; break;
+            case 't':  result += '\t'; break;
+            case 'u':
+                {
+                    uint32_t code = 0;
+                    if (!ParseHex4(code))
+                    { return false; }
+
+                    // サロゲートペアは続く下位サロゲートと結合する.
+                    if (code >= 0xd800 && code < 0xdc00)
+                    {
+                        uint32_t low = 0;
+                        if (!Consume("\\u") || !ParseHex4(low) || low < 0xdc00 || low >= 0xe000)
+                        { return false; }
+
+                        code = 0x10000 + ((code - 0xd800) << 10) + (low - 0xdc00);
+                    }
+                    else if (code >= 0xdc00 && code < 0xe000)
+                    { return false; }
+
+                    AppendUtf8(result, code);
+                }
+                break;
+            default:
+                return false;
+            }
+        }
+
+        return false;
+    }
+
+    bool IsDigit() const
+    { return m_Pos < m_Text.size() && m_Text[m_Pos] >= '0' && m_Text[m_Pos] <= '9'; }
+
+    bool ParseNumber(JsonValue& result)
+    {
+        // strtod は nan, inf, 16進数, 先頭の + も受け付けるため, 文法は自前で確認する.
+        auto begin = m_Pos;
+        Consume("-");
+
+        if (Consume("0"))
+        { /* 先頭の0の後に数字は続かない */ }
+        else if (IsDigit())
+        { while (IsDigit()) { m_Pos++; } }
+        else
+        { return false; }
+
+        if (Consume("."))
+        {
+            if (!IsDigit())
+            { return false; }
+            while (IsDigit()) { m_Pos++; }
+        }
+
+        if (Consume("e") || Consume("E"))
+        {
+            if (!Consume("+"))
+            { Consume("-"); }
+            if (!IsDigit())
+            { return false; }
+            while (IsDigit()) { m_Pos++; }
+        }
+
+        auto value = strtod(m_Text.substr(begin, m_Pos - begin).c_str(), nullptr);
+        if (!std::isfinite(value))
+        { return false; }
+
+        result.Type   = JSON_TYPE_NUMBER;
+        result.Number = value;
+        return true;
+    }
+
+    bool ParseValue(JsonValue& result, uint32_t depth)
+    {
+        if (depth > MaxDepth)
+        { return false; }
+
+        SkipSpace();
+        if (m_Pos >= m_Text.size())
+        { return false; }
+
+        result = JsonValue();
+
+        auto c = m_Text[m_Pos];
+        if (c == '{')
+        {
+            m_Pos++;
+            result.Type = JSON_TYPE_OBJECT;
+
+            SkipSpace();
+            if (Consume("}"))
+            { return true; }
+
+            for (;;)
+            {
+                std::pair<std::string, JsonValue> member;
+
+                SkipSpace();
+                if (!ParseString(member.first))
+                { return false; }
+
+                if (result.Find(member.first.c_str()) != nullptr)
+                { return false; }
+
+                SkipSpace();
+                if (!Consume(":") || !ParseValue(member.second, depth + 1))
+                { return false; }
+
+                result.Object.push_back(std::move(member));
+
+                SkipSpace();
+                if (Consume("}"))
+                { return true; }
+                if (!Consume(","))
+                { return false; }
+            }
+        }
+
+        if (c == '[')
+        {
+            m_Pos++;
+            result.Type = JSON_TYPE_ARRAY;
+
+            SkipSpace();
+            if (Consume("]"))
+            { return true; }
+
+            for (;;)
+            {
+                JsonValue item;
+                if (!ParseValue(item, depth + 1))
+                { return false; }
+
+                result.Array.push_back(std::move(item));
+
+                SkipSpace();
+                if (Consume("]"))
+                { return true; }
+                if (!Consume(","))
+                { return false; }
+            }
+        }
+
+        if (c == '"')
+        {
+            result.Type = JSON_TYPE_STRING;
+            return ParseString(result.String);
+        }
+
+        if (Consume("true"))
+        {
+            result.Type = JSON_TYPE_BOOL;
+            result.Bool = true;
+            return true;
+        }
+
+        if (Consume("false"))
+        {
+            result.Type = JSON_TYPE_BOOL;
+            result.Bool = false;
+            return true;
+        }
+
+        if (Consume("null"))
+        { return true; }
+
+        return ParseNumber(result);
+    }
+
+    JsonParser          (const JsonParser&) = delete;
+    void operator =     (const JsonParser&) = delete;
+};
@@ -0,0 +1,204 @@
+﻿//-----------------------------------------------------------------------------
+// File : LightCluster.h
+// Desc : Clustered Forward Light Culling.
+// Copyright(c) Pocol. All right reserved.
+//-----------------------------------------------------------------------------
+#pragma once
+
+//-----------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------
+#include <d3d12.h>
+#include <wrl/client.h>
+#include <LightClusterCPU.h>
+#include <ConstantBuffer.h>
+#include <DescriptorPool.h>
+#include <GpuHeapAllocator.h>
+#include <PipelineCache.h>
+#include <RootSignature.h>
+
+
+///////////////////////////////////////////////////////////////////////////////
+// LightCluster class
+///////////////////////////////////////////////////////////////////////////////
+//! @note       視錐台をクラスター(froxel)に分け, クラスターごとのライト番号リストを作ります.
+//!             割り当てはコンピュートシェーダで行い, CPU版(LightClusterCPU)に切り替えることもできます.
+//!             シーンのピクセルシェーダはクラスター番号から範囲を引き, リストのライトだけを評価します.
+//!
+//!             1つのクラスターに割り当てるライトは CLUSTER_MAX_LIGHTS 個までで, 超えた分は評価されません.
+//!             GPU版はクラスターごとに CLUSTER_MAX_LIGHTS 個の固定の領域に書き込むので,
+//!             ライト番号リストは使う量によらず CLUSTER_COUNT * CLUSTER_MAX_LIGHTS 個分(約3.4MiB)を確保します.
+//!             上限を超えたクラスターで残るライトは, CPU版では番号の小さい順ですが, GPU版ではスレッドの実行順で決まり不定です.
+//!             GPU版は捨てた数を数えないので, 上限に達しているかは CPU版の GetDroppedCount() で確認してください.
+///////////////////////////////////////////////////////////////////////////////
+class LightCluster
+{
+    //=========================================================================
+    // list of friend classes and methods.
+    //=========================================================================
+    /* NOTHING */
+
+public:
+    //=========================================================================
+    // public variables.
+    //=========================================================================
+    static const uint32_t FrameCount = 2;   //!< アップロードバッファのバッファリング数です.
+
+    //=========================================================================
+    // public methods.
+    //=========================================================================
+
+    //-------------------------------------------------------------------------
+    //! @brief      コンストラクタです.
+    //-------------------------------------------------------------------------
+    LightCluster();
+
+    //-------------------------------------------------------------------------
+    //! @brief      デストラクタです.
+    //-------------------------------------------------------------------------
+    ~LightCluster();
+
+    //-------------------------------------------------------------------------
+    //! @brief      初期化処理を行います.
+    //!
+    //! @param[in]      pDevice         デバイスです.
+    //! @param[in]      pPoolRes        リソース用ディスクリプタプールです.
+    //! @param[in]      pAllocator      バッファを確保するアロケータです.
+    //! @param[in]      pCache          パイプラインステートキャッシュです.
+    //! @param[in]      assignCS        ライト割り当て用コンピュートシェーダです.
+    //! @param[in]      maxLightCount   ライトの最大数です.
+    //! @retval true    初期化に成功.
+    //! @retval false   初期化に失敗.
+    //-------------------------------------------------------------------------
+    bool Init(
+        ID3D12Device*                   pDevice,
+        DescriptorPool*                 pPoolRes,
+        GpuHeapAllocator*               pAllocator,
+        PipelineCache*                  pCache,
+        const D3D12_SHADER_BYTECODE&    assignCS,
+        uint32_t                        maxLightCount);
+
+    //-------------------------------------------------------------------------
+    //! @brief      終了処理を行います.
+    //-------------------------------------------------------------------------
+    void Term();
+
+    //-------------------------------------------------------------------------
+    //! @brief      ライトをアップロードし, クラスターへの割り当てを記録します.
+    //!
+    //! @param[in]      pCmd        コマンドリストです.
+    //! @param[in]      constants   定数です(LightCount は最大数に切り詰めます).
+    //! @param[in]      pLights     ライトです(ワールド空間).
+    //! @param[in]      frameIndex  フレーム番号です.
+    //-------------------------------------------------------------------------
+    void Update(
+        ID3D12GraphicsCommandList*  pCmd,
+        const CbCluster&            constants,
+        const ClusterLight*         pLights,
+        uint32_t                    frameIndex);
+
+    //-------------------------------------------------------------------------
+    //! @brief      CPUで割り当てるかどうかを設定します.
+    //-------------------------------------------------------------------------
+    void SetUseCPU(bool value);
+
+    //-------------------------------------------------------------------------
+    //! @brief      CPUで割り当てるかどうかを取得します.
+    //-------------------------------------------------------------------------
+    bool IsUsingCPU() const;
+
+    //-------------------------------------------------------------------------
+    //! @brief      直前の CPU 割り当ての時間[ms]を取得します.
+    //-------------------------------------------------------------------------
+    double GetCPUTimeMs() const;
+
+    //-------------------------------------------------------------------------
+    //! @brief      CPU版の割り当て結果を取得します.
+    //-------------------------------------------------------------------------
+    const LightClusterCPU& GetCPU() const;
+
+    //-------------------------------------------------------------------------
+    //! @brief      定数バッファ(CbCluster)のCBVを取得します.
+    //-------------------------------------------------------------------------
+    D3D12_GPU_DESCRIPTOR_HANDLE GetHandleCB() const;
+
+    //-------------------------------------------------------------------------
+    //! @brief      ライトバッファ(ClusterLight)のSRVを取得します.
+    //-------------------------------------------------------------------------
+    D3D12_GPU_DESCRIPTOR_HANDLE GetHandleLights() const;
+
+    //-------------------------------------------------------------------------
+    //! @brief      クラスターごとの範囲(ClusterRange)のSRVを取得します.
+    //-------------------------------------------------------------------------
+    D3D12_GPU_DESCRIPTOR_HANDLE GetHandleRanges() const;
+
+    //-------------------------------------------------------------------------
+    //! @brief      ライト番号リストのSRVを取得します.
+    //-------------------------------------------------------------------------
+    D3D12_GPU_DESCRIPTOR_HANDLE GetHandleIndices() const;
+
+private:
+    ///////////////////////////////////////////////////////////////////////////
+    // UploadBuffer structure
+    ///////////////////////////////////////////////////////////////////////////
+    struct UploadBuffer
+    {
+        GpuBuffer                               Buffer;         //!< ページから切り出したバッファです(マップ済み).
+        DescriptorHandle*                       pHandleSRV;     //!< SRVです.
+    };
+
+    //=========================================================================
+    // private variables.
+    //=========================================================================
+    LightClusterCPU                                 m_CPU;                      //!< CPU版の割り当てです.
+    Microsoft::WRL::ComPtr<ID3D12Resource>          m_pRanges;                  //!< GPUで割り当てた範囲のバッファです.
+    Microsoft::WRL::ComPtr<ID3D12Resource>          m_pIndices;                 //!< GPUで割り当てたライト番号リストです.
+    GpuAllocation                                   m_RangesAlloc;              //!< 範囲のバッファの確保情報です.
+    GpuAllocation                                   m_IndicesAlloc;             //!< ライト番号リストの確保情報です.
+    Microsoft::WRL::ComPtr<ID3D12PipelineState>     m_pAssignPSO;               //!< 割り当て用パイプラインステートです.
+    RootSignature                                   m_RootSig;                  //!< ルートシグニチャです.
+    ConstantBuffer                                  m_CB[FrameCount];           //!< 定数バッファです.
+    UploadBuffer                                    m_Lights[FrameCount];       //!< ライトバッファです.
+    UploadBuffer                                    m_UploadRanges[FrameCount]; //!< CPUで割り当てた範囲です.
+    UploadBuffer                                    m_UploadIndices[FrameCount];//!< CPUで割り当てたライト番号リストです.
+    DescriptorPool*                                 m_pPool;                    //!< ディスクリプタプールです.
+    GpuHeapAllocator*                               m_pAllocator;               //!< バッファを確保したアロケータです.
+    DescriptorHandle*                               m_pHandleRangesUAV;         //!< 範囲のバッファのUAVです.
+    DescriptorHandle*                               m_pHandleIndicesUAV;        //!< ライト番号リストのUAVです.
+    DescriptorHandle*                               m_pHandleRangesSRV;         //!< 範囲のバッファのSRVです.
+    DescriptorHandle*                               m_pHandleIndicesSRV;        //!< ライト番号リストのSRVです.
+    uint32_t                                        m_MaxLightCount;            //!< ライトの最大数です.
+    uint32_t                                        m_BufferIndex;              //!< 直前に更新したバッファ番号です.
+    bool                                            m_UseCPU;                   //!< CPUで割り当てるかどうか.
+    double                                          m_CPUTimeMs;                //!< 直前の CPU 割り当ての時間[ms]です.
+
+    //=========================================================================
+    // private methods.
+    //=========================================================================
+
+    //-------------------------------------------------------------------------
+    //! @brief      GPUで書き込むバッファを生成します.
+    //-------------------------------------------------------------------------
+    bool CreateBuffer(
+        uint64_t            size,
+        ID3D12Resource**    ppResource,
+        GpuAllocation&      allocation,
+        const char*         name);
+
+    //-------------------------------------------------------------------------
+    //! @brief      マップしたアップロードバッファと構造化バッファのSRVを生成します.
+    //-------------------------------------------------------------------------
+    bool InitUploadBuffer(
+        ID3D12Device*   pDevice,
+        uint32_t        count,
+        uint32_t        stride,
+        UploadBuffer&   buffer);
+
+    //-------------------------------------------------------------------------
+    //! @brief      アップロードバッファを破棄します.
+    //-------------------------------------------------------------------------
+    void TermUploadBuffer(UploadBuffer& buffer);
+
+    LightCluster        (const LightCluster&) = delete;
+    void operator =     (const LightCluster&) = delete;
+};
@@ -0,0 +1,216 @@
+﻿//-----------------------------------------------------------------------------
+// File : LightClusterCPU.h
+// Desc : Clustered Light Assignment (CPU Fallback).
+// Copyright(c) Pocol. All right reserved.
+//-----------------------------------------------------------------------------
+#pragma once
+
+//-----------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------
+#include <cstdint>
+#include <vector>
+
+
+//-----------------------------------------------------------------------------
+// Constant Values.
+//-----------------------------------------------------------------------------
+constexpr uint32_t  CLUSTER_COUNT_X         = 16;       //!< 画面の横方向のクラスター数です.
+constexpr uint32_t  CLUSTER_COUNT_Y         = 9;        //!< 画面の縦方向のクラスター数です.
+constexpr uint32_t  CLUSTER_COUNT_Z         = 24;       //!< 奥行き方向のクラスター数です(対数分割).
+constexpr uint32_t  CLUSTER_COUNT           = CLUSTER_COUNT_X * CLUSTER_COUNT_Y * CLUSTER_COUNT_Z;  //!< クラスターの総数です.
+constexpr uint32_t  CLUSTER_MAX_LIGHTS      = 256;      //!< 1つのクラスターに割り当てるライトの最大数です(超えた分は捨てます. LightCluster を参照).
+constexpr uint32_t  CLUSTER_MAX_LIGHT_COUNT = 1u << 20; //!< 扱えるライトの最大数です.
+
+static_assert(CLUSTER_COUNT_X % 4 == 0, "CLUSTER_COUNT_X must be a multiple of 4.");
+static_assert(CLUSTER_COUNT <= (1u << 12), "Cluster index must fit in 12 bits.");
+
+
+///////////////////////////////////////////////////////////////////////////////
+// CLUSTER_LIGHT_TYPE enum
+///////////////////////////////////////////////////////////////////////////////
+enum CLUSTER_LIGHT_TYPE
+{
+    CLUSTER_LIGHT_POINT = 0,    //!< 点光源です.
+    CLUSTER_LIGHT_SPOT,         //!< スポットライトです.
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// ClusterLight structure
+///////////////////////////////////////////////////////////////////////////////
+//! @note       シェーダの ClusterLight と同じ並びです(ワールド空間).
+///////////////////////////////////////////////////////////////////////////////
+struct ClusterLight
+{
+    float       Position[3];    //!< 位置です.
+    float       Range;          //!< 影響範囲の半径です.
+    float       Color[3];       //!< 色です.
+    float       Intensity;      //!< 強度です.
+    float       Direction[3];   //!< スポットライトの向きです(正規化済み).
+    float       SpotCosOuter;   //!< スポットライトの外側の角度の余弦です.
+    float       SpotCosInner;   //!< スポットライトの内側の角度の余弦です.
+    uint32_t    Type;           //!< CLUSTER_LIGHT_TYPE です.
+    float       Reserved[2];    //!< 予約領域です.
+};
+
+static_assert(sizeof(ClusterLight) == 64, "ClusterLight must be 64 bytes.");
+
+///////////////////////////////////////////////////////////////////////////////
+// ClusterRange structure
+///////////////////////////////////////////////////////////////////////////////
+//! @note       クラスターごとのライト番号リストの範囲です.
+///////////////////////////////////////////////////////////////////////////////
+struct ClusterRange
+{
+    uint32_t    Offset;     //!< ライト番号リストの先頭です.
+    uint32_t    Count;      //!< ライト数です.
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// CbCluster structure
+///////////////////////////////////////////////////////////////////////////////
+//! @note       シェーダの CbCluster と同じ並びです.
+///////////////////////////////////////////////////////////////////////////////
+struct alignas(256) CbCluster
+{
+    float       View[16];           //!< ビュー行列です(行ベクトル, 右手系).
+    float       ProjScaleX;         //!< 射影行列の _11 です.
+    float       ProjScaleY;         //!< 射影行列の _22 です.
+    float       NearZ;              //!< 最初のスライスの手前の深度です.
+    float       FarZ;               //!< 最後のスライスの奥の深度です.
+    float       LogDepthScale;      //!< 深度の対数からスライス番号への倍率です.
+    float       LogDepthBias;       //!< 深度の対数からスライス番号へのバイアスです.
+    float       ViewportWidth;      //!< 描画する横幅です.
+    float       ViewportHeight;     //!< 描画する縦幅です.
+    uint32_t    LightCount;         //!< ライト数です.
+    uint32_t    Reserved[3];        //!< 予約領域です.
+};
+
+//-----------------------------------------------------------------------------
+//! @brief      シェーダに渡す定数を求めます.
+//!
+//! @param[in]      view        ビュー行列です(行ベクトル, 右手系).
+//! @param[in]      projScaleX  射影行列の _11 です.
+//! @param[in]      projScaleY  射影行列の _22 です.
+//! @param[in]      nearZ       最初のスライスの手前の深度です.
+//! @param[in]      farZ        最後のスライスの奥の深度です(これより奥のライトは割り当てません).
+//! @param[in]      width       描画する横幅です.
+//! @param[in]      height      描画する縦幅です.
+//! @param[in]      lightCount  ライト数です.
+//! @return     定数を返却します.
+//-----------------------------------------------------------------------------
+CbCluster MakeClusterConstants(
+    const float     view[16],
+    float           projScaleX,
+    float           projScaleY,
+    float           nearZ,
+    float           farZ,
+    uint32_t        width,
+    uint32_t        height,
+    uint32_t        lightCount);
+
+//-----------------------------------------------------------------------------
+//! @brief      深度からスライス番号を求めます.
+//!
+//! @note       clustered_lighting.hlsli の GetClusterSlice() と一致します.
+//-----------------------------------------------------------------------------
+uint32_t GetClusterSlice(const CbCluster& constants, float depth);
+
+
+///////////////////////////////////////////////////////////////////////////////
+// LightClusterCPU class
+///////////////////////////////////////////////////////////////////////////////
+//! @note       ライトの境界球とクラスターの AABB を比べ, クラスターごとのライト番号リストを作ります.
+//!             1つのライトは射影した範囲のクラスターだけを調べ, 横方向の4つを SIMD でまとめて判定します.
+//!             リストは詰めて格納し, 各リストはライト番号の昇順です(スレッド数によらず同じ結果になります).
+//!             CLUSTER_MAX_LIGHTS を超えたクラスターは番号の小さい順に上限まで残し, 残りは GetDroppedCount() で数えます.
+///////////////////////////////////////////////////////////////////////////////
+class LightClusterCPU
+{
+    //=========================================================================
+    // list of friend classes and methods.
+    //=========================================================================
+    /* NOTHING */
+
+public:
+    //=========================================================================
+    // public variables.
+    //=========================================================================
+    static const uint32_t LightsPerJob = 512;   //!< 1つのジョブで処理するライト数です.
+
+    //=========================================================================
+    // public methods.
+    //=========================================================================
+
+    //-------------------------------------------------------------------------
+    //! @brief      コンストラクタです.
+    //-------------------------------------------------------------------------
+    LightClusterCPU();
+
+    //-------------------------------------------------------------------------
+    //! @brief      デストラクタです.
+    //-------------------------------------------------------------------------
+    ~LightClusterCPU();
+
+    //-------------------------------------------------------------------------
+    //! @brief      ライトをクラスターに割り当てます.
+    //!
+    //! @param[in]      constants       定数です(LightCount は CLUSTER_MAX_LIGHT_COUNT 以下).
+    //! @param[in]      pLights         ライトです(LightCount 個).
+    //! @param[in]      threadCount     ワーカースレッド数です(0ならハードウェアスレッド数).
+    //-------------------------------------------------------------------------
+    void Assign(const CbCluster& constants, const ClusterLight* pLights, uint32_t threadCount = 0);
+
+    //-------------------------------------------------------------------------
+    //! @brief      クラスターごとの範囲を取得します(CLUSTER_COUNT 個).
+    //-------------------------------------------------------------------------
+    const ClusterRange* GetRanges() const;
+
+    //-------------------------------------------------------------------------
+    //! @brief      ライト番号リストを取得します.
+    //-------------------------------------------------------------------------
+    const uint32_t* GetIndices() const;
+
+    //-------------------------------------------------------------------------
+    //! @brief      ライト番号リストの要素数を取得します.
+    //-------------------------------------------------------------------------
+    uint32_t GetIndexCount() const;
+
+    //-------------------------------------------------------------------------
+    //! @brief      CLUSTER_MAX_LIGHTS を超えて割り当てられなかった数を取得します.
+    //-------------------------------------------------------------------------
+    uint32_t GetDroppedCount() const;
+
+private:
+    //=========================================================================
+    // private variables.
+    //=========================================================================
+    std::vector<float>                  m_Bounds;       //!< クラスターの AABB です(SoA, 最小XYZ, 最大XYZ の順).
+    std::vector<std::vector<uint32_t>>  m_Pairs;        //!< ジョブごとの(クラスター, ライト)の組です.
+    std::vector<ClusterRange>           m_Ranges;       //!< クラスターごとの範囲です.
+    std::vector<uint32_t>               m_Indices;      //!< ライト番号リストです.
+    uint32_t                            m_IndexCount;   //!< ライト番号リストの要素数です.
+    uint32_t                            m_Dropped;      //!< 割り当てられなかった数です.
+
+    //=========================================================================
+    // private methods.
+    //=========================================================================
+
+    //-------------------------------------------------------------------------
+    //! @brief      クラスターの AABB を求めます.
+    //-------------------------------------------------------------------------
+    void BuildBounds(const CbCluster& constants);
+
+    //-------------------------------------------------------------------------
+    //! @brief      ライトの範囲のクラスターを判定し, 組を追加します.
+    //-------------------------------------------------------------------------
+    void AssignLights(
+        const CbCluster&        constants,
+        const ClusterLight*     pLights,
+        uint32_t                begin,
+        uint32_t                end,
+        std::vector<uint32_t>&  pairs) const;
+
+    LightClusterCPU     (const LightClusterCPU&) = delete;
+    void operator =     (const LightClusterCPU&) = delete;
+};
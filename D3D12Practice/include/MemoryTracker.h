@@ -0,0 +1,216 @@
+﻿//-----------------------------------------------------------------------------
+// File : MemoryTracker.h
+// Desc : Memory Accounting By Category.
+// Copyright(c) Pocol. All right reserved.
+//-----------------------------------------------------------------------------
+#pragma once
+
+//-----------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+
+///////////////////////////////////////////////////////////////////////////////
+// MEMORY_CATEGORY enum
+///////////////////////////////////////////////////////////////////////////////
+enum MEMORY_CATEGORY
+{
+    MEMORY_CATEGORY_TEXTURE = 0,        //!< テクスチャです.
+    MEMORY_CATEGORY_MESH,               //!< 頂点バッファ, インデックスバッファです.
+    MEMORY_CATEGORY_CONSTANT_BUFFER,    //!< 定数バッファです.
+    MEMORY_CATEGORY_RENDER_TARGET,      //!< レンダーターゲット, 深度ステンシルです.
+    MEMORY_CATEGORY_IBL,                //!< 環境マップとIBLのベイク結果です.
+    MEMORY_CATEGORY_SHADER,             //!< シェーダバイトコードです.
+    MEMORY_CATEGORY_OTHER,              //!< それ以外です.
+    MEMORY_CATEGORY_COUNT,
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// MEMORY_DOMAIN enum
+///////////////////////////////////////////////////////////////////////////////
+enum MEMORY_DOMAIN
+{
+    MEMORY_DOMAIN_GPU = 0,      //!< GPUリソースです.
+    MEMORY_DOMAIN_CPU,          //!< CPU側のアセットデータです.
+    MEMORY_DOMAIN_COUNT,
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// MemoryStats structure
+///////////////////////////////////////////////////////////////////////////////
+struct MemoryStats
+{
+    uint64_t    CurrentBytes;   //!< 現在の使用量[byte]です.
+    uint64_t    PeakBytes;      //!< 最大使用量[byte]です.
+    uint64_t    LiveCount;      //!< 解放されていない確保の数です.
+    uint64_t    TotalCount;     //!< これまでの確保の数です.
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// MemoryTracker class
+///////////////////////////////////////////////////////////////////////////////
+//! @note       確保をカテゴリとドメイン(GPU / CPU)ごとに数え, 予算の超過と終了時の解放漏れを報告します.
+//!             カウンタはロックせずに読めます. 解放漏れの報告用の記録だけミューテックスで守ります.
+//!             グラフィックスAPIに依存しません. ビデオメモリの予算は呼び出し側が問い合わせて渡します.
+///////////////////////////////////////////////////////////////////////////////
+class MemoryTracker
+{
+    //=========================================================================
+    // list of friend classes and methods.
+    //=========================================================================
+    /* NOTHING */
+
+public:
+    //=========================================================================
+    // public variables.
+    //=========================================================================
+    static const uint64_t InvalidId = 0;    //!< 無効な記録番号です.
+
+    //=========================================================================
+    // public methods.
+    //=========================================================================
+
+    //-------------------------------------------------------------------------
+    //! @brief      コンストラクタです.
+    //-------------------------------------------------------------------------
+    MemoryTracker();
+
+    //-------------------------------------------------------------------------
+    //! @brief      デストラクタです.
+    //-------------------------------------------------------------------------
+    ~MemoryTracker();
+
+    //-------------------------------------------------------------------------
+    //! @brief      確保を記録します.
+    //!
+    //! @param[in]      category    カテゴリです.
+    //! @param[in]      domain      ドメインです.
+    //! @param[in]      bytes       サイズ[byte]です.
+    //! @param[in]      name        解放漏れの報告に使う名前です(文字列リテラルなど, 解放まで有効なもの).
+    //! @return     記録番号を返却します. 解放時に Remove() に渡してください.
+    //-------------------------------------------------------------------------
+    uint64_t Add(MEMORY_CATEGORY category, MEMORY_DOMAIN domain, uint64_t bytes, const char* name = nullptr);
+
+    //-------------------------------------------------------------------------
+    //! @brief      解放を記録します.
+    //!
+    //! @param[in]      id          Add() で返された記録番号です(InvalidId なら何もしません).
+    //-------------------------------------------------------------------------
+    void Remove(uint64_t id);
+
+    //-------------------------------------------------------------------------
+    //! @brief      カテゴリごとの統計を取得します.
+    //-------------------------------------------------------------------------
+    MemoryStats GetStats(MEMORY_CATEGORY category, MEMORY_DOMAIN domain) const;
+
+    //-------------------------------------------------------------------------
+    //! @brief      ドメイン全体の現在の使用量[byte]を取得します.
+    //-------------------------------------------------------------------------
+    uint64_t GetCurrentBytes(MEMORY_DOMAIN domain) const;
+
+    //-------------------------------------------------------------------------
+    //! @brief      カテゴリのGPUメモリの予算をバイト数で設定します.
+    //!
+    //! @param[in]      category    カテゴリです.
+    //! @param[in]      bytes       予算[byte]です(0 なら比率の設定を使います).
+    //-------------------------------------------------------------------------
+    void SetBudget(MEMORY_CATEGORY category, uint64_t bytes);
+
+    //-------------------------------------------------------------------------
+    //! @brief      カテゴリのGPUメモリの予算をOSが示すビデオメモリ予算に対する比率で設定します.
+    //!
+    //! @param[in]      category    カテゴリです.
+    //! @param[in]      ratio       比率です(0 なら予算無し).
+    //-------------------------------------------------------------------------
+    void SetBudgetRatio(MEMORY_CATEGORY category, float ratio);
+
+    //-------------------------------------------------------------------------
+    //! @brief      カテゴリのGPUメモリの予算[byte]を取得します.
+    //!
+    //! @return     予算が無い場合は0を返却します.
+    //-------------------------------------------------------------------------
+    uint64_t GetBudget(MEMORY_CATEGORY category) const;
+
+    //-------------------------------------------------------------------------
+    //! @brief      ビデオメモリの予算と使用量を更新し, カテゴリごとの予算を確認します.
+    //!
+    //! @param[in]      videoBudget     OSが示すビデオメモリの予算[byte]です(不明なら0).
+    //! @param[in]      videoUsage      プロセスのビデオメモリの使用量[byte]です(不明なら0).
+    //! @return     予算を超えたカテゴリのビットマスク(1 << MEMORY_CATEGORY)を返却します.
+    //-------------------------------------------------------------------------
+    uint32_t CheckBudgets(uint64_t videoBudget, uint64_t videoUsage);
+
+    //-------------------------------------------------------------------------
+    //! @brief      カテゴリの名前を取得します.
+    //-------------------------------------------------------------------------
+    static const char* GetName(MEMORY_CATEGORY category);
+
+    //-------------------------------------------------------------------------
+    //! @brief      現在の使用量, 最大使用量, 予算のレポートを作成します.
+    //-------------------------------------------------------------------------
+    std::string FormatReport() const;
+
+    //-------------------------------------------------------------------------
+    //! @brief      解放されていない確保のレポートを作成します.
+    //-------------------------------------------------------------------------
+    std::string FormatLeakReport() const;
+
+private:
+    ///////////////////////////////////////////////////////////////////////////
+    // Counter structure
+    ///////////////////////////////////////////////////////////////////////////
+    struct Counter
+    {
+        std::atomic<uint64_t>   Current { 0 };  //!< 現在の使用量です.
+        std::atomic<uint64_t>   Peak    { 0 };  //!< 最大使用量です.
+        std::atomic<uint64_t>   Live    { 0 };  //!< 解放されていない確保の数です.
+        std::atomic<uint64_t>   Total   { 0 };  //!< これまでの確保の数です.
+    };
+
+    ///////////////////////////////////////////////////////////////////////////
+    // Record structure
+    ///////////////////////////////////////////////////////////////////////////
+    struct Record
+    {
+        MEMORY_CATEGORY     Category;   //!< カテゴリです.
+        MEMORY_DOMAIN       Domain;     //!< ドメインです.
+        uint64_t            Bytes;      //!< サイズです.
+        const char*         Name;       //!< 名前です.
+    };
+
+    //=========================================================================
+    // private variables.
+    //=========================================================================
+    Counter                                 m_Counters[MEMORY_CATEGORY_COUNT][MEMORY_DOMAIN_COUNT];    //!< 使用量です.
+    Counter                                 m_Totals[MEMORY_DOMAIN_COUNT];                              //!< ドメイン全体の使用量です.
+    std::atomic<uint64_t>                   m_Budget[MEMORY_CATEGORY_COUNT];                            //!< 予算[byte]です.
+    std::atomic<float>                      m_BudgetRatio[MEMORY_CATEGORY_COUNT];                       //!< ビデオメモリ予算に対する比率です.
+    std::atomic<uint64_t>                   m_VideoBudget;                                              //!< OSが示すビデオメモリの予算です.
+    std::atomic<uint64_t>                   m_VideoUsage;                                               //!< プロセスのビデオメモリの使用量です.
+    std::atomic<uint64_t>                   m_VideoPeak;                                                //!< プロセスのビデオメモリの最大使用量です.
+    std::atomic<uint64_t>                   m_NextId;                                                   //!< 次の記録番号です.
+    mutable std::mutex                      m_Mutex;                                                    //!< ミューテックスです.
+    std::unordered_map<uint64_t, Record>    m_Records;                                                  //!< 解放されていない確保です.
+
+    //=========================================================================
+    // private methods.
+    //=========================================================================
+
+    //-------------------------------------------------------------------------
+    //! @brief      カウンタに加算し, 最大値を更新します.
+    //-------------------------------------------------------------------------
+    static void Increase(Counter& counter, uint64_t bytes);
+
+    MemoryTracker       (const MemoryTracker&) = delete;
+    void operator =     (const MemoryTracker&) = delete;
+};
+
+//-----------------------------------------------------------------------------
+//! @brief      プロセス全体で共有するメモリトラッカーを取得します.
+//-----------------------------------------------------------------------------
+MemoryTracker& GetMemoryTracker();
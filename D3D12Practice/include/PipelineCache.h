@@ -0,0 +1,141 @@
+﻿//-----------------------------------------------------------------------------
+// File : PipelineCache.h
+// Desc : Persistent Pipeline State Cache.
+// Copyright(c) Pocol. All right reserved.
+//-----------------------------------------------------------------------------
+#pragma once
+
+//-----------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------
+#include <d3d12.h>
+#include <mutex>
+#include <string>
+#include <PipelineCacheFile.h>
+#include <PipelineStateHash.h>
+
+
+///////////////////////////////////////////////////////////////////////////////
+// PipelineCache class
+///////////////////////////////////////////////////////////////////////////////
+class PipelineCache
+{
+    //=========================================================================
+    // list of friend classes and methods.
+    //=========================================================================
+    /* NOTHING */
+
+public:
+    ///////////////////////////////////////////////////////////////////////////
+    // Stats structure
+    ///////////////////////////////////////////////////////////////////////////
+    struct Stats
+    {
+        uint32_t    Hits;           //!< キャッシュから生成できた数です.
+        uint32_t    Misses;         //!< キャッシュに無く新規に生成した数です.
+        uint32_t    Rejected;       //!< ドライバにキャッシュを拒否された数です.
+        uint32_t    Stored;         //!< キャッシュに登録した数です.
+        double      HitTimeMs;      //!< ヒット時の生成時間の合計[ms]です.
+        double      MissTimeMs;     //!< ミス時の生成時間の合計[ms]です.
+    };
+
+    //=========================================================================
+    // public variables.
+    //=========================================================================
+    /* NOTHING */
+
+    //=========================================================================
+    // public methods.
+    //=========================================================================
+
+    //-------------------------------------------------------------------------
+    //! @brief      コンストラクタです.
+    //-------------------------------------------------------------------------
+    PipelineCache();
+
+    //-------------------------------------------------------------------------
+    //! @brief      デストラクタです.
+    //-------------------------------------------------------------------------
+    ~PipelineCache();
+
+    //-------------------------------------------------------------------------
+    //! @brief      初期化処理を行います.
+    //!
+    //! @param[in]      pDevice     デバイスです.
+    //! @param[in]      path        キャッシュファイルのパスです.
+    //! @retval true    初期化に成功.
+    //! @retval false   初期化に失敗.
+    //! @note       キャッシュファイルが無い, または壊れている場合は空の状態で開始します.
+    //-------------------------------------------------------------------------
+    bool Init(ID3D12Device* pDevice, const wchar_t* path);
+
+    //-------------------------------------------------------------------------
+    //! @brief      終了処理を行います. 変更があればファイルに保存します.
+    //-------------------------------------------------------------------------
+    void Term();
+
+    //-------------------------------------------------------------------------
+    //! @brief      キャッシュをファイルに保存します.
+    //-------------------------------------------------------------------------
+    bool Save();
+
+    //-------------------------------------------------------------------------
+    //! @brief      グラフィックスパイプラインステートを生成します.
+    //!
+    //! @param[in]      desc            パイプラインステートの設定です.
+    //! @param[in]      rootSigHash     ルートシグニチャのハッシュ値です.
+    //! @param[out]     ppPSO           パイプラインステートの格納先です.
+    //! @return     ID3D12Device::CreateGraphicsPipelineState() の結果を返却します.
+    //! @note       スレッドセーフです.
+    //-------------------------------------------------------------------------
+    HRESULT CreateGraphicsPipelineState(
+        const D3D12_GRAPHICS_PIPELINE_STATE_DESC&   desc,
+        uint64_t                                    rootSigHash,
+        ID3D12PipelineState**                       ppPSO);
+
+    //-------------------------------------------------------------------------
+    //! @brief      コンピュートパイプラインステートを生成します.
+    //!
+    //! @param[in]      desc            パイプラインステートの設定です.
+    //! @param[in]      rootSigHash     ルートシグニチャのハッシュ値です.
+    //! @param[out]     ppPSO           パイプラインステートの格納先です.
+    //! @return     ID3D12Device::CreateComputePipelineState() の結果を返却します.
+    //! @note       スレッドセーフです.
+    //-------------------------------------------------------------------------
+    HRESULT CreateComputePipelineState(
+        const D3D12_COMPUTE_PIPELINE_STATE_DESC&    desc,
+        uint64_t                                    rootSigHash,
+        ID3D12PipelineState**                       ppPSO);
+
+    //-------------------------------------------------------------------------
+    //! @brief      統計を取得します.
+    //-------------------------------------------------------------------------
+    Stats GetStats() const;
+
+private:
+    //=========================================================================
+    // private variables.
+    //=========================================================================
+    ID3D12Device*       m_pDevice;      //!< デバイスです.
+    std::wstring        m_Path;         //!< キャッシュファイルのパスです.
+    PipelineCacheFile   m_File;         //!< キャッシュファイルです.
+    Stats               m_Stats;        //!< 統計です.
+    mutable std::mutex  m_Mutex;        //!< ミューテックスです.
+
+    //=========================================================================
+    // private methods.
+    //=========================================================================
+
+    //-------------------------------------------------------------------------
+    //! @brief      キャッシュを用いてパイプラインステートを生成します.
+    //-------------------------------------------------------------------------
+    template<typename DescType, typename CreateFunc>
+    HRESULT CreateCore(
+        const DescType&         desc,
+        uint64_t                key,
+        ID3D12PipelineState**   ppPSO,
+        CreateFunc              create);
+
+    PipelineCache       (const PipelineCache&) = delete;
+    void operator =     (const PipelineCache&) = delete;
+};
@@ -0,0 +1,105 @@
+﻿//-----------------------------------------------------------------------------
+// File : PipelineCacheFile.h
+// Desc : Pipeline State Cache File.
+// Copyright(c) Pocol. All right reserved.
+//-----------------------------------------------------------------------------
+#pragma once
+
+//-----------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------
+#include <cstdint>
+#include <filesystem>
+#include <unordered_map>
+#include <vector>
+
+
+///////////////////////////////////////////////////////////////////////////////
+// PipelineCacheFile class
+///////////////////////////////////////////////////////////////////////////////
+//! @note       ファイル形式(リトルエンディアン)
+//!             Header  : Magic("PSOC"), Version, EntryCount, Reserved
+//!             Entry[] : Key(u64), Size(u64), Checksum(u64), Data[Size]
+//!             破損したエントリは読み込み時に捨てられます.
+///////////////////////////////////////////////////////////////////////////////
+class PipelineCacheFile
+{
+    //=========================================================================
+    // list of friend classes and methods.
+    //=========================================================================
+    /* NOTHING */
+
+public:
+    //=========================================================================
+    // public variables.
+    //=========================================================================
+    static const uint32_t Magic   = 0x434f5350;     //!< "PSOC"
+    static const uint32_t Version = 1;              //!< ファイルバージョンです.
+
+    //=========================================================================
+    // public methods.
+    //=========================================================================
+
+    //-------------------------------------------------------------------------
+    //! @brief      ファイルから読み込みます.
+    //!
+    //! @param[in]      path        ファイルパスです.
+    //! @retval true    読み込みに成功.
+    //! @retval false   ファイルが存在しないか, ヘッダが不正です.
+    //-------------------------------------------------------------------------
+    bool Load(const std::filesystem::path& path);
+
+    //-------------------------------------------------------------------------
+    //! @brief      ファイルに書き出します.
+    //!
+    //! @param[in]      path        ファイルパスです.
+    //! @retval true    書き出しに成功.
+    //! @retval false   書き出しに失敗.
+    //-------------------------------------------------------------------------
+    bool Save(const std::filesystem::path& path);
+
+    //-------------------------------------------------------------------------
+    //! @brief      エントリを検索します.
+    //!
+    //! @param[in]      key         キーです.
+    //! @return     見つからない場合は nullptr を返却します.
+    //-------------------------------------------------------------------------
+    const std::vector<uint8_t>* Find(uint64_t key) const;
+
+    //-------------------------------------------------------------------------
+    //! @brief      エントリを登録します. 既存のエントリは上書きされます.
+    //-------------------------------------------------------------------------
+    void Store(uint64_t key, const void* pData, size_t size);
+
+    //-------------------------------------------------------------------------
+    //! @brief      エントリを削除します.
+    //-------------------------------------------------------------------------
+    void Remove(uint64_t key);
+
+    //-------------------------------------------------------------------------
+    //! @brief      全てのエントリを削除します.
+    //-------------------------------------------------------------------------
+    void Clear();
+
+    //-------------------------------------------------------------------------
+    //! @brief      エントリ数を取得します.
+    //-------------------------------------------------------------------------
+    size_t GetCount() const;
+
+    //-------------------------------------------------------------------------
+    //! @brief      未保存の変更があるかどうかチェックします.
+    //-------------------------------------------------------------------------
+    bool IsDirty() const;
+
+private:
+    //=========================================================================
+    // private variables.
+    //=========================================================================
+    std::unordered_map<uint64_t, std::vector<uint8_t>>  m_Entries;          //!< エントリです.
+    bool                                                m_Dirty = false;    //!< 変更フラグです.
+
+    //=========================================================================
+    // private methods.
+    //=========================================================================
+    /* NOTHING */
+};
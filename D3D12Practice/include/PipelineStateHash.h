@@ -0,0 +1,48 @@
+﻿//-----------------------------------------------------------------------------
+// File : PipelineStateHash.h
+// Desc : Pipeline State Description Hash.
+// Copyright(c) Pocol. All right reserved.
+//-----------------------------------------------------------------------------
+#pragma once
+
+//-----------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------
+#include <d3d12.h>
+#include <cstdint>
+
+
+//-----------------------------------------------------------------------------
+//! @brief      シェーダバイトコードのハッシュ値を計算します.
+//-----------------------------------------------------------------------------
+uint64_t HashShaderBytecode(const D3D12_SHADER_BYTECODE& bytecode);
+
+//-----------------------------------------------------------------------------
+//! @brief      ルートシグニチャ設定のハッシュ値を計算します.
+//!
+//! @param[in]      desc        ルートシグニチャの設定です.
+//! @return     ポインタ値に依存しないハッシュ値を返却します.
+//-----------------------------------------------------------------------------
+uint64_t HashRootSignatureDesc(const D3D12_ROOT_SIGNATURE_DESC& desc);
+
+//-----------------------------------------------------------------------------
+//! @brief      グラフィックスパイプラインステート設定のハッシュ値を計算します.
+//!
+//! @param[in]      desc            パイプラインステートの設定です.
+//! @param[in]      rootSigHash     ルートシグニチャのハッシュ値です.
+//! @return     正規化した設定のハッシュ値を返却します.
+//! @note       ポインタ値は使用せず, シェーダはバイトコードの内容で識別します.
+//!             また, 結果に影響しない設定(無効なブレンド係数, 未使用のRTVフォーマット,
+//!             ステンシル無効時のステンシル設定など)は無視します.
+//!             desc.pRootSignature と desc.CachedPSO はハッシュに含めません.
+//-----------------------------------------------------------------------------
+uint64_t HashGraphicsPipelineStateDesc(const D3D12_GRAPHICS_PIPELINE_STATE_DESC& desc, uint64_t rootSigHash);
+
+//-----------------------------------------------------------------------------
+//! @brief      コンピュートパイプラインステート設定のハッシュ値を計算します.
+//!
+//! @param[in]      desc            パイプラインステートの設定です.
+//! @param[in]      rootSigHash     ルートシグニチャのハッシュ値です.
+//! @return     正規化した設定のハッシュ値を返却します.
+//-----------------------------------------------------------------------------
+uint64_t HashComputePipelineStateDesc(const D3D12_COMPUTE_PIPELINE_STATE_DESC& desc, uint64_t rootSigHash);
@@ -0,0 +1,221 @@
+﻿//-----------------------------------------------------------------------------
+// File : Profiler.h
+// Desc : CPU Scope Profiler And Chrome Trace Exporter.
+// Copyright(c) Pocol. All right reserved.
+//-----------------------------------------------------------------------------
+#pragma once
+
+//-----------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+
+///////////////////////////////////////////////////////////////////////////////
+// ProfileEvent structure
+///////////////////////////////////////////////////////////////////////////////
+struct ProfileEvent
+{
+    std::string     Name;       //!< スコープ名です.
+    double          BeginUs;    //!< 開始時刻[us]です(steady_clock の起点から).
+    double          EndUs;      //!< 終了時刻[us]です(steady_clock の起点から).
+    uint32_t        Track;      //!< トラック番号です(CPUはスレッド番号, GPUは Profiler::GpuTrack).
+    uint32_t        Depth;      //!< 入れ子の深さです.
+    uint32_t        Frame;      //!< フレーム番号です.
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// Profiler class
+///////////////////////////////////////////////////////////////////////////////
+//! @note       CPUの入れ子のスコープを計測して名前ごとに集計し, キャプチャ中はイベントとして記録します.
+//!             GPUの計測結果も時刻を合わせて追加すると, 両方のタイムラインを Chrome Trace 形式
+//!             (chrome://tracing, Perfetto)で出力できます. D3D12 に依存しません. スレッドセーフです.
+///////////////////////////////////////////////////////////////////////////////
+class Profiler
+{
+    //=========================================================================
+    // list of friend classes and methods.
+    //=========================================================================
+    /* NOTHING */
+
+public:
+    //=========================================================================
+    // public variables.
+    //=========================================================================
+    static const uint32_t GpuTrack          = 0xFFFF;       //!< GPUのイベントのトラック番号です.
+    static const uint32_t InvalidScope      = UINT32_MAX;   //!< 無効なスコープ番号です.
+    static const size_t   MaxCaptureEvents  = 1 << 20;      //!< キャプチャで記録する最大イベント数です.
+
+    //=========================================================================
+    // public methods.
+    //=========================================================================
+
+    //-------------------------------------------------------------------------
+    //! @brief      コンストラクタです.
+    //-------------------------------------------------------------------------
+    Profiler();
+
+    //-------------------------------------------------------------------------
+    //! @brief      デストラクタです.
+    //-------------------------------------------------------------------------
+    ~Profiler();
+
+    //-------------------------------------------------------------------------
+    //! @brief      フレームを開始します.
+    //!
+    //! @note       キャプチャ中に指定フレーム数に達したら, キャプチャを完了します.
+    //-------------------------------------------------------------------------
+    void BeginFrame();
+
+    //-------------------------------------------------------------------------
+    //! @brief      呼び出したスレッドでスコープの計測を開始します.
+    //!
+    //! @param[in]      name        スコープ名です(終了まで有効な文字列).
+    //! @return     スコープ番号(入れ子の深さ)を返却します.
+    //-------------------------------------------------------------------------
+    uint32_t BeginScope(const char* name);
+
+    //-------------------------------------------------------------------------
+    //! @brief      呼び出したスレッドでスコープの計測を終了します.
+    //!
+    //! @param[in]      scope       BeginScope() が返却したスコープ番号です(開始と逆順に終了すること).
+    //-------------------------------------------------------------------------
+    void EndScope(uint32_t scope);
+
+    //-------------------------------------------------------------------------
+    //! @brief      GPUのイベントを追加します.
+    //!
+    //! @param[in]      name        スコープ名です.
+    //! @param[in]      beginUs     開始時刻[us]です(CPUと同じ steady_clock の起点から).
+    //! @param[in]      endUs       終了時刻[us]です.
+    //! @note       キャプチャ中だけ記録します(集計はGPU側で行います).
+    //-------------------------------------------------------------------------
+    void AddGpuEvent(const char* name, double beginUs, double endUs);
+
+    //-------------------------------------------------------------------------
+    //! @brief      キャプチャを開始します.
+    //!
+    //! @param[in]      frameCount  記録するフレーム数です.
+    //! @note       以前のキャプチャのイベントは破棄します.
+    //-------------------------------------------------------------------------
+    void StartCapture(uint32_t frameCount);
+
+    //-------------------------------------------------------------------------
+    //! @brief      キャプチャ中かどうかチェックします.
+    //-------------------------------------------------------------------------
+    bool IsCapturing() const;
+
+    //-------------------------------------------------------------------------
+    //! @brief      キャプチャが完了して出力待ちかどうかチェックします.
+    //-------------------------------------------------------------------------
+    bool HasFinishedCapture() const;
+
+    //-------------------------------------------------------------------------
+    //! @brief      キャプチャしたイベントを破棄します.
+    //-------------------------------------------------------------------------
+    void ClearCapture();
+
+    //-------------------------------------------------------------------------
+    //! @brief      キャプチャしたイベントを取得します.
+    //-------------------------------------------------------------------------
+    std::vector<ProfileEvent> GetEvents() const;
+
+    //-------------------------------------------------------------------------
+    //! @brief      集計をリセットします.
+    //-------------------------------------------------------------------------
+    void ResetStats();
+
+    //-------------------------------------------------------------------------
+    //! @brief      スコープごとの平均時間を文字列にします.
+    //-------------------------------------------------------------------------
+    std::string FormatReport() const;
+
+    //-------------------------------------------------------------------------
+    //! @brief      キャプチャしたイベントを Chrome Trace 形式の JSON にします.
+    //-------------------------------------------------------------------------
+    std::string ExportChromeTrace() const;
+
+    //-------------------------------------------------------------------------
+    //! @brief      キャプチャしたイベントを Chrome Trace 形式でファイルに書き出します.
+    //!
+    //! @param[in]      path        出力ファイルパスです.
+    //! @retval true    書き出しに成功.
+    //! @retval false   書き出しに失敗.
+    //-------------------------------------------------------------------------
+    bool WriteChromeTrace(const char* path) const;
+
+    //-------------------------------------------------------------------------
+    //! @brief      現在時刻[us]を取得します(steady_clock の起点から).
+    //-------------------------------------------------------------------------
+    static double GetTimeUs();
+
+private:
+    ///////////////////////////////////////////////////////////////////////////
+    // Stats structure
+    ///////////////////////////////////////////////////////////////////////////
+    struct Stats
+    {
+        std::string Name;       //!< スコープ名です.
+        double      TotalMs;    //!< 合計時間[ms]です.
+        double      MaxMs;      //!< 最大時間[ms]です.
+        uint32_t    Count;      //!< 計測回数です.
+    };
+
+    //=========================================================================
+    // private variables.
+    //=========================================================================
+    mutable std::mutex              m_Mutex;            //!< ミューテックスです.
+    std::vector<Stats>              m_Stats;            //!< スコープごとの集計です.
+    std::vector<ProfileEvent>       m_Events;           //!< キャプチャしたイベントです.
+    std::vector<std::thread::id>    m_Threads;          //!< トラック番号ごとのスレッドです.
+    uint32_t                        m_Frame;            //!< フレーム番号です.
+    uint32_t                        m_CaptureEnd;       //!< キャプチャを終えるフレーム番号です.
+    bool                            m_Capturing;        //!< キャプチャ中かどうか.
+    bool                            m_CaptureFinished;  //!< キャプチャが完了したかどうか.
+
+    //=========================================================================
+    // private methods.
+    //=========================================================================
+
+    //-------------------------------------------------------------------------
+    //! @brief      呼び出したスレッドのトラック番号を取得します(ロック中に呼ぶこと).
+    //-------------------------------------------------------------------------
+    uint32_t GetTrackLocked();
+
+    Profiler            (const Profiler&) = delete;
+    void operator =     (const Profiler&) = delete;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// ProfileScope class
+///////////////////////////////////////////////////////////////////////////////
+//! @note       コンストラクタで計測を開始し, デストラクタで終了します.
+///////////////////////////////////////////////////////////////////////////////
+class ProfileScope
+{
+public:
+    //-------------------------------------------------------------------------
+    //! @brief      計測を開始します.
+    //-------------------------------------------------------------------------
+    ProfileScope(Profiler& profiler, const char* name)
+    : m_Profiler(profiler)
+    , m_Scope   (profiler.BeginScope(name))
+    { /* DO_NOTHING */ }
+
+    //-------------------------------------------------------------------------
+    //! @brief      計測を終了します.
+    //-------------------------------------------------------------------------
+    ~ProfileScope()
+    { m_Profiler.EndScope(m_Scope); }
+
+private:
+    Profiler&   m_Profiler;     //!< プロファイラです.
+    uint32_t    m_Scope;        //!< スコープ番号です.
+
+    ProfileScope        (const ProfileScope&) = delete;
+    void operator =     (const ProfileScope&) = delete;
+};
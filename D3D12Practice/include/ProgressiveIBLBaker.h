@@ -0,0 +1,209 @@
+﻿//-----------------------------------------------------------------------------
+// File : ProgressiveIBLBaker.h
+// Desc : Time Sliced IBL Baker.
+// Copyright(c) Pocol. All right reserved.
+//-----------------------------------------------------------------------------
+#pragma once
+
+//-----------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------
+#include <d3d12.h>
+#include <wrl/client.h>
+#include <DescriptorPool.h>
+#include <IBLBaker.h>
+#include <IBLBakeScheduler.h>
+#include <PipelineCache.h>
+
+
+///////////////////////////////////////////////////////////////////////////////
+// ProgressiveIBLBaker class
+///////////////////////////////////////////////////////////////////////////////
+//! @note       LD項は面ごと(鏡面反射はミップと面ごと)のディスパッチに分け, 1フレームの予算に収まるだけ記録します.
+//!             LD項のテクスチャは表と裏の2組を持ち, 裏の組が全て書き終わるまで表の組を参照させます.
+//!             DFG項は環境マップに依存しないので IBLBaker で一度だけ積分します.
+///////////////////////////////////////////////////////////////////////////////
+class ProgressiveIBLBaker
+{
+    //=========================================================================
+    // list of friend classes and methods.
+    //=========================================================================
+    /* NOTHING */
+
+public:
+    ///////////////////////////////////////////////////////////////////////////
+    // WORK_KIND enum
+    ///////////////////////////////////////////////////////////////////////////
+    enum WORK_KIND
+    {
+        WORK_DFG = 0,       //!< DFG項の積分.
+        WORK_DIFFUSE_LD,    //!< 拡散反射のLD項の1面の積分(番号は面).
+        WORK_SPECULAR_LD,   //!< 鏡面反射のLD項の1ミップの1面の積分(番号は ミップ * FaceCount + 面).
+    };
+
+    //=========================================================================
+    // public variables.
+    //=========================================================================
+    static const uint32_t FaceCount     = 6;                    //!< キューブマップの面の数です.
+    static const uint32_t MaxMipCount   = 16;                   //!< 鏡面反射のLD項の最大ミップ数です.
+
+    //=========================================================================
+    // public methods.
+    //=========================================================================
+
+    //-------------------------------------------------------------------------
+    //! @brief      コンストラクタです.
+    //-------------------------------------------------------------------------
+    ProgressiveIBLBaker();
+
+    //-------------------------------------------------------------------------
+    //! @brief      デストラクタです.
+    //-------------------------------------------------------------------------
+    ~ProgressiveIBLBaker();
+
+    //-------------------------------------------------------------------------
+    //! @brief      初期化処理を行います.
+    //!
+    //! @param[in]      pDevice         デバイスです.
+    //! @param[in]      pPoolRes        リソース用ディスクリプタプールです.
+    //! @param[in]      pPoolRTV        レンダーターゲット用ディスクリプタプールです.
+    //! @param[in]      pCache          パイプラインステートキャッシュです.
+    //! @param[in]      diffuseCS       拡散反射のLD項を積分するコンピュートシェーダです.
+    //! @param[in]      specularCS      鏡面反射のLD項を積分するコンピュートシェーダです.
+    //! @retval true    初期化に成功.
+    //! @retval false   初期化に失敗.
+    //-------------------------------------------------------------------------
+    bool Init(
+        ID3D12Device*                   pDevice,
+        DescriptorPool*                 pPoolRes,
+        DescriptorPool*                 pPoolRTV,
+        PipelineCache*                  pCache,
+        const D3D12_SHADER_BYTECODE&    diffuseCS,
+        const D3D12_SHADER_BYTECODE&    specularCS);
+
+    //-------------------------------------------------------------------------
+    //! @brief      終了処理を行います.
+    //-------------------------------------------------------------------------
+    void Term();
+
+    //-------------------------------------------------------------------------
+    //! @brief      全ての積分を一括で記録し, 結果を直ちに使用可能にします.
+    //!
+    //! @param[in]      pCmd        コマンドリストです.
+    //! @param[in]      handleCube  キューブマップのGPUディスクリプタハンドルです.
+    //-------------------------------------------------------------------------
+    void Bake(ID3D12GraphicsCommandList* pCmd, D3D12_GPU_DESCRIPTOR_HANDLE handleCube);
+
+    //-------------------------------------------------------------------------
+    //! @brief      環境マップの変更を要求します.
+    //!
+    //! @param[in]      handleCube  キューブマップのGPUディスクリプタハンドルです.
+    //! @note       積分は Update() で予算内に分割して記録されます.
+    //!             完了するまでは以前の結果が参照されます.
+    //-------------------------------------------------------------------------
+    void Request(D3D12_GPU_DESCRIPTOR_HANDLE handleCube);
+
+    //-------------------------------------------------------------------------
+    //! @brief      このフレームの作業を記録します.
+    //!
+    //! @param[in]      pCmd        コマンドリストです.
+    //! @param[in]      frameIndex  フレーム番号です. ReportGpuTime() で同じ番号を渡します.
+    //-------------------------------------------------------------------------
+    void Update(ID3D12GraphicsCommandList* pCmd, uint32_t frameIndex);
+
+    //-------------------------------------------------------------------------
+    //! @brief      Update() で記録した作業の計測時間を報告し, コストの見積もりを更新します.
+    //!
+    //! @param[in]      frameIndex  記録したときに Update() に渡したフレーム番号です.
+    //! @param[in]      gpuMs       記録した作業全体のGPU時間[ms]です.
+    //-------------------------------------------------------------------------
+    void ReportGpuTime(uint32_t frameIndex, double gpuMs);
+
+    //-------------------------------------------------------------------------
+    //! @brief      1フレームあたりのGPU時間予算[ms]を設定します.
+    //-------------------------------------------------------------------------
+    void SetBudget(double budgetMs);
+
+    //-------------------------------------------------------------------------
+    //! @brief      ベイク中かどうかチェックします.
+    //-------------------------------------------------------------------------
+    bool IsBaking() const;
+
+    //-------------------------------------------------------------------------
+    //! @brief      スケジューラを取得します.
+    //-------------------------------------------------------------------------
+    IBLBakeScheduler& GetScheduler();
+
+    //-------------------------------------------------------------------------
+    //! @brief      DFG項のGPUディスクリプタハンドルを取得します.
+    //-------------------------------------------------------------------------
+    D3D12_GPU_DESCRIPTOR_HANDLE GetHandleGPU_DFG() const;
+
+    //-------------------------------------------------------------------------
+    //! @brief      描画に使用する拡散反射のLD項のGPUディスクリプタハンドルを取得します.
+    //-------------------------------------------------------------------------
+    D3D12_GPU_DESCRIPTOR_HANDLE GetHandleGPU_DiffuseLD() const;
+
+    //-------------------------------------------------------------------------
+    //! @brief      描画に使用する鏡面反射のLD項のGPUディスクリプタハンドルを取得します.
+    //-------------------------------------------------------------------------
+    D3D12_GPU_DESCRIPTOR_HANDLE GetHandleGPU_SpecularLD() const;
+
+private:
+    ///////////////////////////////////////////////////////////////////////////
+    // LDSet structure
+    ///////////////////////////////////////////////////////////////////////////
+    struct LDSet
+    {
+        Microsoft::WRL::ComPtr<ID3D12Resource>  pDiffuse;                   //!< 拡散反射のLD項です.
+        Microsoft::WRL::ComPtr<ID3D12Resource>  pSpecular;                  //!< 鏡面反射のLD項です.
+        DescriptorHandle*                       pHandleDiffuseSRV;          //!< 拡散反射のLD項のSRVです.
+        DescriptorHandle*                       pHandleSpecularSRV;         //!< 鏡面反射のLD項のSRVです.
+        DescriptorHandle*                       pHandleDiffuseUAV;          //!< 拡散反射のLD項のUAVです.
+        DescriptorHandle*                       pHandleSpecularUAV[MaxMipCount];    //!< 鏡面反射のLD項のミップごとのUAVです.
+        bool                                    Writable;                   //!< 書き込み可能な状態かどうか.
+    };
+
+    //=========================================================================
+    // private variables.
+    //=========================================================================
+    IBLBaker                                        m_Baker;                //!< DFG項のベイクです.
+    bool                                            m_DFGReady;             //!< DFG項が積分済みかどうか.
+    LDSet                                           m_Set[2];               //!< LD項(表と裏)です.
+    uint32_t                                        m_Front;                //!< 描画に使用するLD項の番号です.
+    IBLBakeScheduler                                m_Scheduler;            //!< スケジューラです.
+    D3D12_GPU_DESCRIPTOR_HANDLE                     m_HandleCube;           //!< 入力キューブマップのハンドルです.
+    bool                                            m_Baking;               //!< ベイク中かどうか.
+    Microsoft::WRL::ComPtr<ID3D12PipelineState>     m_pDiffusePSO;          //!< 拡散反射のLD項のパイプラインステートです.
+    Microsoft::WRL::ComPtr<ID3D12PipelineState>     m_pSpecularPSO;         //!< 鏡面反射のLD項のパイプラインステートです.
+    Microsoft::WRL::ComPtr<ID3D12RootSignature>     m_pRootSig;             //!< ルートシグニチャです(作業ごとの設定はルート定数で渡します).
+    DescriptorPool*                                 m_pPool;                //!< ディスクリプタプールです.
+    uint64_t                                        m_MemoryId;             //!< メモリ使用量の記録番号です.
+
+    //=========================================================================
+    // private methods.
+    //=========================================================================
+
+    //-------------------------------------------------------------------------
+    //! @brief      LD項のテクスチャとビューを生成します.
+    //-------------------------------------------------------------------------
+    bool CreateSet(ID3D12Device* pDevice, LDSet& set);
+
+    //-------------------------------------------------------------------------
+    //! @brief      全ての作業を積みます.
+    //-------------------------------------------------------------------------
+    void PushAll(bool dfg);
+
+    //-------------------------------------------------------------------------
+    //! @brief      作業を1つ記録します.
+    //-------------------------------------------------------------------------
+    void Record(ID3D12GraphicsCommandList* pCmd, LDSet& set, const IBLBakeScheduler::WorkUnit& unit);
+
+    //-------------------------------------------------------------------------
+    //! @brief      LD項の状態を書き込み用と読み込み用の間で切り替えます.
+    //-------------------------------------------------------------------------
+    void SetWritable(ID3D12GraphicsCommandList* pCmd, LDSet& set, bool writable);
+
+    ProgressiveIBLBaker     (const ProgressiveIBLBaker&) = delete;
+    void operator =         (const ProgressiveIBLBaker&) = delete;
+};
@@ -12,11 +12,26 @@
 #include <ConstantBuffer.h>
 #include <Material.h>
 #include <SphereMapConverter.h>
-#include <IBLBaker.h>
+#include <ProgressiveIBLBaker.h>
+#include <AsyncPipelineCompiler.h>
+#include <AutoExposure.h>
+#include <Benchmark.h>
+#include <Bloom.h>
+#include <DrawList.h>
+#include <DynamicResolution.h>
+#include <FrameGraph.h>
+#include <GpuTimer.h>
+#include <IndexBuffer.h>
+#include <LightCluster.h>
+#include <Profiler.h>
+#include <TonemapLUT.h>
 #include <SkyBox.h>
+#include <SpscQueue.h>
 #include <Camera.h>
 #include <RootSignature.h>
 #include <array>
+#include <atomic>
+#include <chrono>
 
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -44,8 +59,9 @@ public:
     //!
     //! @param[in]      width       ウィンドウの横幅です.
     //! @param[in]      height      ウィンドウの縦幅です.
+    //! @param[in]      benchmark   ベンチマークの設定です(無効なら通常の対話モード).
     //-------------------------------------------------------------------------
-    SampleApp(uint32_t width, uint32_t height);
+    SampleApp(uint32_t width, uint32_t height, const BenchmarkSettings& benchmark = BenchmarkSettings());
 
     //-------------------------------------------------------------------------
     //! @brief      デストラクタです.
@@ -53,13 +69,48 @@ public:
     virtual ~SampleApp();
 
 private:
+    ///////////////////////////////////////////////////////////////////////////
+    // DepthPrepassMesh structure
+    ///////////////////////////////////////////////////////////////////////////
+    struct DepthPrepassMesh
+    {
+        uint32_t    IndexCount;     //!< インデックス数です.
+        uint32_t    StartIndex;     //!< 先頭のインデックスの位置です.
+        int32_t     BaseVertex;     //!< 先頭の頂点の位置です.
+    };
+
+    ///////////////////////////////////////////////////////////////////////////
+    // INPUT_RECORD_TYPE enum
+    ///////////////////////////////////////////////////////////////////////////
+    enum INPUT_RECORD_TYPE
+    {
+        INPUT_RECORD_CAMERA = 0,    //!< カメラの操作です.
+        INPUT_RECORD_KEY,           //!< キーの押下です.
+    };
+
+    ///////////////////////////////////////////////////////////////////////////
+    // InputRecord structure
+    ///////////////////////////////////////////////////////////////////////////
+    struct InputRecord
+    {
+        INPUT_RECORD_TYPE   Type;           //!< 種類です.
+        Camera::Event       CameraEvent;    //!< カメラの操作です(INPUT_RECORD_CAMERA).
+        uint32_t            KeyCode;        //!< 仮想キーコードです(INPUT_RECORD_KEY).
+    };
+
     //=========================================================================
     // private variables.
     //=========================================================================
-    ComPtr<ID3D12PipelineState>     m_pScenePSO;                    //!< シーン用パイプラインステートです.
+    AsyncPipelineCompiler           m_PipelineCompiler;             //!< パイプラインステートの非同期コンパイラです.
+    PipelineHandle                  m_ScenePSO;                     //!< シーン用パイプラインステートです.
+    PipelineHandle                  m_SceneEqualPSO;                //!< 深度プリパス後のシーン用パイプラインステートです(LESS_EQUAL, 書き込み無し).
+    PipelineHandle                  m_DepthPrepassPSO;              //!< 深度プリパス用パイプラインステートです.
     RootSignature                   m_SceneRootSig;                 //!< シーン用ルートシグニチャです.
-    ComPtr<ID3D12PipelineState>     m_pTonemapPSO;                  //!< トーンマップ用パイプラインステートです.
+    PipelineHandle                  m_TonemapPSO;                   //!< トーンマップ用パイプラインステートです.
+    PipelineHandle                  m_TonemapLUTPSO;                //!< LUTトーンマップ用パイプラインステートです.
     RootSignature                   m_TonemapRootSig;               //!< トーンマップ用ルートシグニチャです.
+    uint64_t                        m_SceneRootSigHash;             //!< シーン用ルートシグニチャのハッシュ値です.
+    uint64_t                        m_TonemapRootSigHash;           //!< トーンマップ用ルートシグニチャのハッシュ値です.
     ColorTarget                     m_SceneColorTarget;             //!< シーン用レンダーターゲットです.
     DepthTarget                     m_SceneDepthTarget;             //!< シーン用深度ターゲットです.
     VertexBuffer                    m_QuadVB;                       //!< 頂点バッファです.
@@ -67,24 +118,55 @@ private:
     ConstantBuffer                  m_LightCB[FrameCount];          //!< ライトバッファです.
     ConstantBuffer                  m_CameraCB[FrameCount];         //!< カメラバッファです.
     ConstantBuffer                  m_TransformCB[FrameCount];      //!< 変換用バッファです.
-    ConstantBuffer                  m_MeshCB[FrameCount * 16];      //!< メッシュ用バッファです.
+    uint32_t                        m_GridSize;                     //!< マテリアルボールを並べる1辺の数です.
+    uint32_t                        m_InstanceCount;                //!< 並べて描画するマテリアルボールの数です.
+    std::vector<ConstantBuffer>     m_MeshCB;                       //!< メッシュ用バッファです(FrameCount * m_InstanceCount).
     std::vector<Mesh*>              m_pMesh;                        //!< メッシュです.
+    DrawList                        m_DrawList;                     //!< ソート済みの描画リストです.
+    VertexBuffer                    m_DepthPrepassVB;               //!< 全メッシュの位置だけの頂点バッファです.
+    IndexBuffer                     m_DepthPrepassIB;               //!< 全メッシュのインデックスバッファです.
+    std::vector<DepthPrepassMesh>   m_DepthPrepassMesh;             //!< メッシュごとの描画範囲です.
+    bool                            m_UseDepthPrepass;              //!< 深度プリパスを行うかどうか.
     Material                        m_Material[16];                 //!< マテリアルです.
     float                           m_RotateAngle;                  //!< ライトの回転角です.
     int                             m_TonemapType;                  //!< トーンマップタイプ.
     int                             m_ColorSpace;                   //!< 出力色空間
     float                           m_BaseLuminance;                //!< 基準輝度値.
     float                           m_MaxLuminance;                 //!< 最大輝度値.
-    float                           m_Exposure;                     //!< 露光値.
+    float                           m_Exposure;                     //!< 露光補正値[EV].
+    AutoExposure                    m_AutoExposure;                 //!< 自動露出です.
+    TonemapLUT                      m_TonemapLUT;                   //!< トーンマップのLUTです.
+    bool                            m_UseTonemapLUT;                //!< LUTでトーンマップするかどうか.
+    Bloom                           m_Bloom;                        //!< ブルームです.
+    GpuTimer                        m_GpuTimer;                     //!< パスごとのGPU時間の計測です.
+    Profiler                        m_Profiler;                     //!< CPUのスコープの計測とトレース出力です.
+    LightCluster                    m_LightCluster;                 //!< クラスターごとのライトの割り当てです.
+    std::vector<ClusterLight>       m_PointLights;                  //!< 点光源とスポットライトです.
+    uint32_t                        m_PointLightCount;              //!< 描画に使うライト数です.
+    uint32_t                        m_SceneColorUsage;              //!< シーン用レンダーターゲットの現在の状態(FRAME_USAGE)です.
+    FrameGraph                      m_FrameGraph;                   //!< フレームグラフです.
+    DynamicResolution               m_DynamicResolution;            //!< 動的解像度の制御です.
+    D3D12_VIEWPORT                  m_SceneViewport;                //!< シーンを描画するビューポートです(左上の一部).
+    D3D12_RECT                      m_SceneScissor;                 //!< シーンを描画するシザー矩形です.
     Texture                         m_SphereMap;                    //!< スフィアマップです.
     SphereMapConverter              m_SphereMapConverter;           //!< スフィアマップコンバータ.
-    IBLBaker                        m_IBLBaker;                     //!< IBLベイク.
+    Texture                         m_CookedCubeMap;                //!< 事前変換済みキューブマップです.
+    bool                            m_UseCookedCubeMap;             //!< 事前変換済みキューブマップを使用するかどうか.
+    ProgressiveIBLBaker             m_IBLBaker;                     //!< IBLベイク.
     SkyBox                          m_SkyBox;                       //!< スカイボックスです.
     DirectX::SimpleMath::Matrix     m_View;                         //!< ビュー行列.
     DirectX::SimpleMath::Matrix     m_Proj;                         //!< 射影行列.
     Camera                          m_Camera;                       //!< カメラ.
     int                             m_PrevCursorX;                  //!< 前回のカーソル位置X.
     int                             m_PrevCursorY;                  //!< 前回のカーソル位置Y.
+    SpscQueue<InputRecord, 256>     m_InputQueue;                   //!< メッセージ処理から描画への入力の受け渡しです.
+    std::atomic<uint32_t>           m_DroppedInputCount;            //!< キューが一杯で捨てた入力の数です.
+    std::chrono::steady_clock::time_point   m_LaunchTime;           //!< 起動時刻です.
+    bool                            m_FirstFrameReported;           //!< 最初のフレームまでの時間を出力したかどうか.
+    std::chrono::steady_clock::time_point   m_LastFrameTime;        //!< 前フレームの時刻です.
+    BenchmarkSettings               m_BenchmarkSettings;            //!< ベンチマークの設定です.
+    Benchmark                       m_Benchmark;                    //!< ベンチマークの進行と集計です.
+    std::vector<uint64_t>           m_MemoryIds;                    //!< フレームワークのリソースのメモリ使用量の記録番号です.
 
     //=========================================================================
     // private methods.
@@ -113,10 +195,30 @@ private:
     //-------------------------------------------------------------------------
     void OnMsgProc(HWND hWnd, UINT msg, WPARAM wp, LPARAM lp) override;
 
+    //-------------------------------------------------------------------------
+    //! @brief      メッセージ処理から届いた入力を適用します.
+    //!
+    //! @note       描画側のスレッドでフレームの先頭に1回呼び出します.
+    //-------------------------------------------------------------------------
+    void ProcessInput();
+
+    //-------------------------------------------------------------------------
+    //! @brief      キーの押下を処理します.
+    //!
+    //! @param[in]      keyCode     仮想キーコードです.
+    //-------------------------------------------------------------------------
+    void OnKey(uint32_t keyCode);
+
+    //-------------------------------------------------------------------------
+    //! @brief      入力を描画側に渡します.
+    //-------------------------------------------------------------------------
+    void PushInput(const InputRecord& record);
+
     //-------------------------------------------------------------------------
     //! @brief      ディスプレイモードを変更します.
     //!
     //! @param[in]      hdr     trueであればHDRディスプレイ用の設定に変更します.
+    //! @note       描画スレッドから呼び出します. 結果は ALOG で出力します.
     //-------------------------------------------------------------------------
     void ChangeDisplayMode(bool hdr);
 
@@ -131,54 +233,25 @@ private:
     void DrawTonemap(ID3D12GraphicsCommandList* pCmdList);
 
     //-------------------------------------------------------------------------
-    //! @brief      メッシュを描画します.
+    //! @brief      マテリアルのテクスチャセットを設定します.
     //-------------------------------------------------------------------------
-    void DrawMesh(ID3D12GraphicsCommandList* pCmdList, int material_index);
+    void SetMaterial(ID3D12GraphicsCommandList* pCmdList, uint32_t material_index, uint32_t id);
 
-#if 0
-    std::array<ComPtr<ID3D12Resource>, 2> m_BloomBuffers;//ブルーム用バッファ
-    ComPtr<ID3D12Resource> m_pShrinkBuffer;//被写界深度用ぼかしバッファ
+    //-------------------------------------------------------------------------
+    //! @brief      環境キューブマップのリソース設定を取得します.
+    //-------------------------------------------------------------------------
+    D3D12_RESOURCE_DESC GetCubeMapDesc() const;
 
+    //-------------------------------------------------------------------------
+    //! @brief      環境キューブマップのGPUディスクリプタハンドルを取得します.
+    //-------------------------------------------------------------------------
+    D3D12_GPU_DESCRIPTOR_HANDLE GetCubeMapHandleGPU() const;
 
-     // bloom用のバッファの生成.
-    {
-        // ヒーププロパティ.
-        D3D12_HEAP_PROPERTIES prop = {};
-        prop.Type = D3D12_HEAP_TYPE_UPLOAD;
-        prop.CPUPageProperty = D3D12_CPU_PAGE_PROPERTY_UNKNOWN;
-        prop.MemoryPoolPreference = D3D12_MEMORY_POOL_UNKNOWN;
-        prop.CreationNodeMask = 1;
-        prop.VisibleNodeMask = 1;
-
-        // カラーターゲットのdesc
-        auto& desc = m_ColorTarget->GetDesc();
-
-        D3D12_CLEAR_VALUE clearValue = {};
-        clearValue.Color[0] = 0.0f;
-        clearValue.Color[1] = 0.0f;
-        clearValue.Color[2] = 0.0f;
-        clearValue.Color[3] = 1.0f;
-        clearValue.Format = desc.Format;
-
-        for (auto& res : m_BloomBuffers)
-        {
-            auto hr = m_pDevice->CreateCommittedResource(
-                &prop,
-                D3D12_HEAP_FLAG_NONE,
-                &desc,
-                D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE,
-                &clearValue,
-                IID_PPV_ARGS(res.ReleaseAndGetAddressOf()));
-
-            // 2枚目は縮小バッファなので幅を半分にする
-            desc.Width >>= 1;
-
-            if (FAILED(hr))
-            {
-                return false;
-            }
-        }
-    }
-#endif
+    //-------------------------------------------------------------------------
+    //! @brief      フレームワークのクラスが生成したリソースのメモリ使用量を計上します.
+    //!
+    //! @param[in]      meshBytes   ロードしたメッシュの頂点とインデックスのサイズ[byte]です.
+    //-------------------------------------------------------------------------
+    void TrackMemory(uint64_t meshBytes);
 
 };
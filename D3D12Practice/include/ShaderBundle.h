@@ -0,0 +1,162 @@
+﻿//-----------------------------------------------------------------------------
+// File : ShaderBundle.h
+// Desc : Shader Bytecode Bundle.
+// Copyright(c) Pocol. All right reserved.
+//-----------------------------------------------------------------------------
+#pragma once
+
+//-----------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+
+///////////////////////////////////////////////////////////////////////////////
+// ShaderBundle class
+///////////////////////////////////////////////////////////////////////////////
+//! @note       ファイル形式(リトルエンディアン)
+//!             Header  : Magic("SHDB"), Version, EntryCount, NameTableSize
+//!             Entry[] : NameHash(u64), ContentHash(u64), Offset(u64), Size(u64),
+//!                       NameOffset(u32), NameLength(u32)
+//!             Names   : 名前テーブル(終端文字なし)
+//!             Data    : バイトコード(16バイト境界に配置)
+//!             エントリは名前のハッシュ値順に並んでいます.
+///////////////////////////////////////////////////////////////////////////////
+class ShaderBundle
+{
+    //=========================================================================
+    // list of friend classes and methods.
+    //=========================================================================
+    /* NOTHING */
+
+public:
+    ///////////////////////////////////////////////////////////////////////////
+    // Source structure
+    ///////////////////////////////////////////////////////////////////////////
+    struct Source
+    {
+        std::string             Name;           //!< 名前です.
+        std::vector<uint8_t>    Data;           //!< バイトコードです.
+    };
+
+    ///////////////////////////////////////////////////////////////////////////
+    // Blob structure
+    ///////////////////////////////////////////////////////////////////////////
+    struct Blob
+    {
+        const void*     pData;          //!< バイトコードです(マップされたファイルを直接指します).
+        size_t          Size;           //!< バイトコードのサイズです.
+        uint64_t        ContentHash;    //!< バイトコードのハッシュ値です.
+    };
+
+    //=========================================================================
+    // public variables.
+    //=========================================================================
+    static const uint32_t Magic   = 0x42444853;     //!< "SHDB"
+    static const uint32_t Version = 1;              //!< ファイルバージョンです.
+
+    //=========================================================================
+    // public methods.
+    //=========================================================================
+
+    //-------------------------------------------------------------------------
+    //! @brief      コンストラクタです.
+    //-------------------------------------------------------------------------
+    ShaderBundle();
+
+    //-------------------------------------------------------------------------
+    //! @brief      デストラクタです.
+    //-------------------------------------------------------------------------
+    ~ShaderBundle();
+
+    //-------------------------------------------------------------------------
+    //! @brief      ファイルをメモリにマップして開きます.
+    //!
+    //! @param[in]      path        ファイルパスです.
+    //! @retval true    オープンに成功.
+    //! @retval false   ファイルが存在しないか, ヘッダまたはインデックスが不正です.
+    //-------------------------------------------------------------------------
+    bool Open(const std::filesystem::path& path);
+
+    //-------------------------------------------------------------------------
+    //! @brief      ファイルを閉じます.
+    //-------------------------------------------------------------------------
+    void Close();
+
+    //-------------------------------------------------------------------------
+    //! @brief      バイトコードを検索します.
+    //!
+    //! @param[in]      name        名前です(例 : "BasicVS.cso").
+    //! @param[out]     result      検索結果の格納先です.
+    //! @retval true    見つかった.
+    //! @retval false   見つからなかった.
+    //! @note       結果のポインタは Close() を呼び出すまで有効です.
+    //-------------------------------------------------------------------------
+    bool Find(const char* name, Blob& result) const;
+
+    //-------------------------------------------------------------------------
+    //! @brief      全バイトコードの内容をハッシュ値で検証します.
+    //!
+    //! @retval true    全て一致.
+    //! @retval false   一致しないエントリがある.
+    //-------------------------------------------------------------------------
+    bool Verify() const;
+
+    //-------------------------------------------------------------------------
+    //! @brief      開いているかどうかを取得します.
+    //-------------------------------------------------------------------------
+    bool IsOpen() const;
+
+    //-------------------------------------------------------------------------
+    //! @brief      エントリ数を取得します.
+    //-------------------------------------------------------------------------
+    uint32_t GetCount() const;
+
+    //-------------------------------------------------------------------------
+    //! @brief      マップしたファイルのサイズを取得します.
+    //-------------------------------------------------------------------------
+    size_t GetSize() const;
+
+    //-------------------------------------------------------------------------
+    //! @brief      バンドルをファイルに書き出します.
+    //!
+    //! @param[in]      path        ファイルパスです.
+    //! @param[in]      sources     バイトコードのリストです. 名前の重複は許されません.
+    //! @retval true    書き出しに成功.
+    //! @retval false   書き出しに失敗.
+    //-------------------------------------------------------------------------
+    static bool Write(const std::filesystem::path& path, const std::vector<Source>& sources);
+
+private:
+    ///////////////////////////////////////////////////////////////////////////
+    // Entry structure
+    ///////////////////////////////////////////////////////////////////////////
+    struct Entry;
+
+    //=========================================================================
+    // private variables.
+    //=========================================================================
+    const uint8_t*  m_pData;        //!< マップされたファイルの先頭です.
+    size_t          m_Size;         //!< ファイルサイズです.
+    const Entry*    m_pEntries;     //!< エントリです.
+    uint32_t        m_Count;        //!< エントリ数です.
+    const char*     m_pNames;       //!< 名前テーブルです.
+    void*           m_hFile;        //!< ファイルハンドルです(Windowsのみ).
+    void*           m_hMapping;     //!< マッピングハンドルです(Windowsのみ).
+
+    //=========================================================================
+    // private methods.
+    //=========================================================================
+
+    //-------------------------------------------------------------------------
+    //! @brief      ヘッダとインデックスを検証します.
+    //-------------------------------------------------------------------------
+    bool Validate();
+
+    ShaderBundle        (const ShaderBundle&) = delete;
+    void operator =     (const ShaderBundle&) = delete;
+};
@@ -0,0 +1,122 @@
+﻿//-----------------------------------------------------------------------------
+// File : SpscQueue.h
+// Desc : Lock-Free Single-Producer Single-Consumer Queue.
+// Copyright(c) Pocol. All right reserved.
+//-----------------------------------------------------------------------------
+#pragma once
+
+//-----------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------
+#include <atomic>
+#include <cstdint>
+#include <type_traits>
+
+
+///////////////////////////////////////////////////////////////////////////////
+// SpscQueue class
+///////////////////////////////////////////////////////////////////////////////
+//! @note       1つのスレッドが積み, 別の1つのスレッドが取り出す固定長のリングバッファです.
+//!             ロックもメモリ確保もしません. 一杯のときは積まずに失敗を返します.
+//!             積む側と取り出す側の位置はキャッシュラインを分けて置きます.
+///////////////////////////////////////////////////////////////////////////////
+template<typename T, uint32_t Size>
+class SpscQueue
+{
+    static_assert(Size >= 2 && (Size & (Size - 1)) == 0, "SpscQueue size must be a power of two.");
+    static_assert(std::is_trivially_copyable<T>::value, "SpscQueue element must be trivially copyable.");
+
+    //=========================================================================
+    // list of friend classes and methods.
+    //=========================================================================
+    /* NOTHING */
+
+public:
+    //=========================================================================
+    // public variables.
+    //=========================================================================
+    static const uint32_t Capacity = Size;      //!< 積める要素の最大数です.
+
+    //=========================================================================
+    // public methods.
+    //=========================================================================
+
+    //-------------------------------------------------------------------------
+    //! @brief      コンストラクタです.
+    //-------------------------------------------------------------------------
+    SpscQueue()
+    : m_Head(0)
+    , m_Tail(0)
+    { /* DO_NOTHING */ }
+
+    //-------------------------------------------------------------------------
+    //! @brief      デストラクタです.
+    //-------------------------------------------------------------------------
+    ~SpscQueue()
+    { /* DO_NOTHING */ }
+
+    //-------------------------------------------------------------------------
+    //! @brief      要素を積みます(積む側のスレッドからのみ呼び出せます).
+    //!
+    //! @param[in]      value       積む値です.
+    //! @retval true    積んだ.
+    //! @retval false   一杯なので積まなかった.
+    //-------------------------------------------------------------------------
+    bool TryPush(const T& value)
+    {
+        auto head = m_Head.load(std::memory_order_relaxed);
+        auto tail = m_Tail.load(std::memory_order_acquire);
+        if (head - tail >= Size)
+        { return false; }
+
+        m_Items[head & (Size - 1)] = value;
+        m_Head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    //-------------------------------------------------------------------------
+    //! @brief      要素を取り出します(取り出す側のスレッドからのみ呼び出せます).
+    //!
+    //! @param[out]     value       取り出した値の格納先です.
+    //! @retval true    取り出した.
+    //! @retval false   空だった.
+    //-------------------------------------------------------------------------
+    bool TryPop(T& value)
+    {
+        auto tail = m_Tail.load(std::memory_order_relaxed);
+        auto head = m_Head.load(std::memory_order_acquire);
+        if (head == tail)
+        { return false; }
+
+        value = m_Items[tail & (Size - 1)];
+        m_Tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    //-------------------------------------------------------------------------
+    //! @brief      積まれている要素の数を取得します.
+    //!
+    //! @note       他方のスレッドが操作中の場合は目安です.
+    //-------------------------------------------------------------------------
+    uint32_t GetCount() const
+    {
+        // 先に読み込み位置を読めば, 書き込み位置より先に進んでいることはない.
+        auto tail = m_Tail.load(std::memory_order_acquire);
+        auto head = m_Head.load(std::memory_order_acquire);
+        return head - tail;
+    }
+
+private:
+    //=========================================================================
+    // private variables.
+    //=========================================================================
+    alignas(64) std::atomic<uint32_t>   m_Head;             //!< 書き込み位置です(積む側のみ更新).
+    alignas(64) std::atomic<uint32_t>   m_Tail;             //!< 読み込み位置です(取り出す側のみ更新).
+    alignas(64) T                       m_Items[Size];      //!< 要素です.
+
+    //=========================================================================
+    // private methods.
+    //=========================================================================
+    SpscQueue           (const SpscQueue&) = delete;
+    void operator =     (const SpscQueue&) = delete;
+};
@@ -0,0 +1,221 @@
+﻿//-----------------------------------------------------------------------------
+// File : TaskGraph.h
+// Desc : Dependency-Aware Task Graph.
+// Copyright(c) Pocol. All right reserved.
+//-----------------------------------------------------------------------------
+#pragma once
+
+//-----------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <initializer_list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+
+//-----------------------------------------------------------------------------
+// Type Definitions.
+//-----------------------------------------------------------------------------
+using TaskId = uint32_t;
+
+
+///////////////////////////////////////////////////////////////////////////////
+// TASK_STATUS enum
+///////////////////////////////////////////////////////////////////////////////
+enum TASK_STATUS
+{
+    TASK_STATUS_PENDING = 0,    //!< 未実行です.
+    TASK_STATUS_SUCCEEDED,      //!< 成功しました.
+    TASK_STATUS_FAILED,         //!< 失敗しました.
+    TASK_STATUS_SKIPPED,        //!< 依存先が失敗したため実行しませんでした.
+};
+
+
+///////////////////////////////////////////////////////////////////////////////
+// TaskGraph class
+///////////////////////////////////////////////////////////////////////////////
+//! @note       依存関係が解決したタスクからワークスティーリング方式のスレッドプールで実行します.
+//!             Run() を呼び出したスレッドもワーカーとして処理に参加します.
+///////////////////////////////////////////////////////////////////////////////
+class TaskGraph
+{
+    //=========================================================================
+    // list of friend classes and methods.
+    //=========================================================================
+    /* NOTHING */
+
+public:
+    ///////////////////////////////////////////////////////////////////////////
+    // TaskInfo structure
+    ///////////////////////////////////////////////////////////////////////////
+    struct TaskInfo
+    {
+        std::string     Name;           //!< タスク名です.
+        TASK_STATUS     Status;         //!< 実行結果です.
+        uint32_t        ThreadIndex;    //!< 実行したワーカー番号です.
+        double          StartMs;        //!< Run() 開始からの開始時刻[ms]です.
+        double          EndMs;          //!< Run() 開始からの終了時刻[ms]です.
+    };
+
+    //=========================================================================
+    // public variables.
+    //=========================================================================
+    /* NOTHING */
+
+    //=========================================================================
+    // public methods.
+    //=========================================================================
+
+    //-------------------------------------------------------------------------
+    //! @brief      コンストラクタです.
+    //-------------------------------------------------------------------------
+    TaskGraph();
+
+    //-------------------------------------------------------------------------
+    //! @brief      デストラクタです.
+    //-------------------------------------------------------------------------
+    ~TaskGraph();
+
+    //-------------------------------------------------------------------------
+    //! @brief      タスクを追加します.
+    //!
+    //! @param[in]      name            タスク名です.
+    //! @param[in]      func            処理です. 失敗時は false を返します.
+    //! @param[in]      dependencies    先に完了している必要があるタスクです.
+    //! @return     タスクIDを返却します.
+    //-------------------------------------------------------------------------
+    TaskId Add(
+        const char*                     name,
+        std::function<bool()>           func,
+        std::initializer_list<TaskId>   dependencies = {});
+
+    //-------------------------------------------------------------------------
+    //! @brief      依存関係を追加します.
+    //!
+    //! @param[in]      task            タスクです.
+    //! @param[in]      dependency      先に完了している必要があるタスクです.
+    //-------------------------------------------------------------------------
+    void AddDependency(TaskId task, TaskId dependency);
+
+    //-------------------------------------------------------------------------
+    //! @brief      全てのタスクを実行します.
+    //!
+    //! @param[in]      threadCount     ワーカー数です(0ならハードウェアスレッド数).
+    //! @retval true    全てのタスクが成功.
+    //! @retval false   失敗したタスクがあるか, 依存関係が循環しています.
+    //! @note       失敗したタスクに依存するタスクは実行されません.
+    //-------------------------------------------------------------------------
+    bool Run(uint32_t threadCount = 0);
+
+    //-------------------------------------------------------------------------
+    //! @brief      タスクをすべて削除します.
+    //-------------------------------------------------------------------------
+    void Clear();
+
+    //-------------------------------------------------------------------------
+    //! @brief      タスク数を取得します.
+    //-------------------------------------------------------------------------
+    size_t GetCount() const;
+
+    //-------------------------------------------------------------------------
+    //! @brief      タスクの実行結果を取得します.
+    //-------------------------------------------------------------------------
+    const TaskInfo& GetInfo(TaskId id) const;
+
+    //-------------------------------------------------------------------------
+    //! @brief      直前の Run() の所要時間[ms]を取得します.
+    //-------------------------------------------------------------------------
+    double GetElapsedMs() const;
+
+    //-------------------------------------------------------------------------
+    //! @brief      全タスクの処理時間の合計[ms]を取得します.
+    //-------------------------------------------------------------------------
+    double GetSerialMs() const;
+
+    //-------------------------------------------------------------------------
+    //! @brief      クリティカルパスを取得します.
+    //!
+    //! @param[out]     path        実行順に並んだタスクIDの格納先です.
+    //! @return     クリティカルパスの処理時間の合計[ms]を返却します.
+    //-------------------------------------------------------------------------
+    double GetCriticalPath(std::vector<TaskId>& path) const;
+
+    //-------------------------------------------------------------------------
+    //! @brief      実行結果のレポートを作成します.
+    //-------------------------------------------------------------------------
+    std::string FormatReport() const;
+
+private:
+    ///////////////////////////////////////////////////////////////////////////
+    // Task structure
+    ///////////////////////////////////////////////////////////////////////////
+    struct Task
+    {
+        TaskInfo                    Info;           //!< 実行結果です.
+        std::function<bool()>       Func;           //!< 処理です.
+        std::vector<TaskId>         Dependencies;   //!< 依存先です.
+        std::vector<TaskId>         Dependents;     //!< 依存元です.
+        std::atomic<uint32_t>       Remaining;      //!< 未完了の依存先の数です.
+        std::atomic<bool>           Cancelled;      //!< 依存先が失敗したかどうかです.
+    };
+
+    ///////////////////////////////////////////////////////////////////////////
+    // Worker structure
+    ///////////////////////////////////////////////////////////////////////////
+    struct Worker
+    {
+        std::deque<TaskId>  Queue;      //!< 実行可能なタスクです.
+        std::mutex          Mutex;      //!< キュー用ミューテックスです.
+    };
+
+    //=========================================================================
+    // private variables.
+    //=========================================================================
+    std::vector<std::unique_ptr<Task>>      m_Tasks;            //!< タスクです.
+    std::vector<std::unique_ptr<Worker>>    m_Workers;          //!< ワーカーです.
+    std::atomic<uint32_t>                   m_Completed;        //!< 完了したタスク数です.
+    std::atomic<uint32_t>                   m_Ready;            //!< キューに積まれたタスク数です.
+    std::mutex                              m_WaitMutex;        //!< 待機用ミューテックスです.
+    std::condition_variable                 m_WaitCondition;    //!< 待機用条件変数です.
+    double                                  m_ElapsedMs;        //!< 直前の Run() の所要時間です.
+
+    //=========================================================================
+    // private methods.
+    //=========================================================================
+
+    //-------------------------------------------------------------------------
+    //! @brief      依存関係が循環していないか調べます.
+    //-------------------------------------------------------------------------
+    bool IsAcyclic() const;
+
+    //-------------------------------------------------------------------------
+    //! @brief      ワーカーの処理です.
+    //-------------------------------------------------------------------------
+    void WorkerLoop(uint32_t index, std::chrono::steady_clock::time_point origin);
+
+    //-------------------------------------------------------------------------
+    //! @brief      実行可能なタスクを取り出します(無ければ他のワーカーから盗みます).
+    //-------------------------------------------------------------------------
+    bool Pop(uint32_t index, TaskId& result);
+
+    //-------------------------------------------------------------------------
+    //! @brief      タスクをキューに積みます.
+    //-------------------------------------------------------------------------
+    void Push(uint32_t index, TaskId id);
+
+    //-------------------------------------------------------------------------
+    //! @brief      タスクの完了を依存元に通知します.
+    //-------------------------------------------------------------------------
+    void Complete(uint32_t index, TaskId id, bool succeeded);
+
+    TaskGraph           (const TaskGraph&) = delete;
+    void operator =     (const TaskGraph&) = delete;
+};
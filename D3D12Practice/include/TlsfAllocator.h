@@ -0,0 +1,213 @@
+﻿//-----------------------------------------------------------------------------
+// File : TlsfAllocator.h
+// Desc : Two-Level Segregated Fit Offset Allocator.
+// Copyright(c) Pocol. All right reserved.
+//-----------------------------------------------------------------------------
+#pragma once
+
+//-----------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------
+#include <cstdint>
+#include <vector>
+
+
+///////////////////////////////////////////////////////////////////////////////
+// TlsfStats structure
+///////////////////////////////////////////////////////////////////////////////
+struct TlsfStats
+{
+    uint64_t    Capacity;           //!< 管理している容量です.
+    uint64_t    UsedBytes;          //!< 確保中のサイズです(アライメントの詰め物を含みます).
+    uint64_t    FreeBytes;          //!< 空き容量です.
+    uint64_t    LargestFreeBlock;   //!< 最大の空きブロックのサイズです.
+    uint32_t    AllocationCount;    //!< 確保中のブロック数です.
+    uint32_t    FreeBlockCount;     //!< 空きブロック数です.
+    float       Fragmentation;      //!< 断片化率です(1 - 最大の空きブロック / 空き容量).
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// TlsfAllocator class
+///////////////////////////////////////////////////////////////////////////////
+//! @note       メモリそのものは持たず, [0, capacity) のオフセットだけを管理します.
+//!             確保と解放は空きリストの数に依らず O(1) で, 解放時に隣接する空きブロックと結合します.
+//!             スレッドセーフではありません.
+///////////////////////////////////////////////////////////////////////////////
+class TlsfAllocator
+{
+    //=========================================================================
+    // list of friend classes and methods.
+    //=========================================================================
+    /* NOTHING */
+
+public:
+    ///////////////////////////////////////////////////////////////////////////
+    // Allocation structure
+    ///////////////////////////////////////////////////////////////////////////
+    struct Allocation
+    {
+        uint64_t    Offset;     //!< 先頭からのオフセットです(要求したアライメントに揃っています).
+        uint64_t    Size;       //!< 確保したサイズです(粒度に切り上げ済み).
+        uint32_t    Node;       //!< 管理用ノード番号です.
+    };
+
+    //=========================================================================
+    // public variables.
+    //=========================================================================
+    static const uint32_t InvalidNode   = UINT32_MAX;   //!< 無効なノード番号です.
+    static const uint32_t SLBits        = 4;            //!< 第2レベルの分割数のビット数です.
+    static const uint32_t SLCount       = 1u << SLBits; //!< 第2レベルの分割数です.
+    static const uint32_t FLCount       = 48;           //!< 第1レベルの分割数です.
+
+    //=========================================================================
+    // public methods.
+    //=========================================================================
+
+    //-------------------------------------------------------------------------
+    //! @brief      コンストラクタです.
+    //-------------------------------------------------------------------------
+    TlsfAllocator();
+
+    //-------------------------------------------------------------------------
+    //! @brief      デストラクタです.
+    //-------------------------------------------------------------------------
+    ~TlsfAllocator();
+
+    //-------------------------------------------------------------------------
+    //! @brief      初期化処理を行います.
+    //!
+    //! @param[in]      capacity        管理する容量です.
+    //! @param[in]      granularity     確保の最小単位です(2のべき乗).
+    //! @retval true    初期化に成功.
+    //! @retval false   初期化に失敗.
+    //-------------------------------------------------------------------------
+    bool Init(uint64_t capacity, uint64_t granularity);
+
+    //-------------------------------------------------------------------------
+    //! @brief      終了処理を行います.
+    //-------------------------------------------------------------------------
+    void Term();
+
+    //-------------------------------------------------------------------------
+    //! @brief      領域を確保します.
+    //!
+    //! @param[in]      size            サイズです.
+    //! @param[in]      alignment       アライメントです(2のべき乗. 粒度未満なら粒度に揃えます).
+    //! @param[out]     result          確保結果の格納先です.
+    //! @retval true    確保に成功.
+    //! @retval false   空きがありません.
+    //-------------------------------------------------------------------------
+    bool Alloc(uint64_t size, uint64_t alignment, Allocation& result);
+
+    //-------------------------------------------------------------------------
+    //! @brief      領域を解放します.
+    //!
+    //! @param[in]      allocation      Alloc() で確保した結果です.
+    //-------------------------------------------------------------------------
+    void Free(const Allocation& allocation);
+
+    //-------------------------------------------------------------------------
+    //! @brief      すべての領域を解放します.
+    //-------------------------------------------------------------------------
+    void Reset();
+
+    //-------------------------------------------------------------------------
+    //! @brief      統計を取得します.
+    //-------------------------------------------------------------------------
+    TlsfStats GetStats() const;
+
+    //-------------------------------------------------------------------------
+    //! @brief      容量を取得します.
+    //-------------------------------------------------------------------------
+    uint64_t GetCapacity() const;
+
+    //-------------------------------------------------------------------------
+    //! @brief      確保中のブロックが無いかどうかチェックします.
+    //-------------------------------------------------------------------------
+    bool IsEmpty() const;
+
+    //-------------------------------------------------------------------------
+    //! @brief      内部構造の整合性を検証します.
+    //!
+    //! @retval true    整合性が取れています.
+    //! @retval false   壊れています.
+    //-------------------------------------------------------------------------
+    bool Validate() const;
+
+private:
+    ///////////////////////////////////////////////////////////////////////////
+    // Node structure
+    ///////////////////////////////////////////////////////////////////////////
+    struct Node
+    {
+        uint64_t    Offset;     //!< 先頭からのオフセットです.
+        uint64_t    Size;       //!< サイズです.
+        uint32_t    PrevPhys;   //!< アドレス順で前のノードです.
+        uint32_t    NextPhys;   //!< アドレス順で次のノードです.
+        uint32_t    PrevFree;   //!< 同じ空きリストの前のノードです.
+        uint32_t    NextFree;   //!< 同じ空きリストの次のノードです.
+        bool        Free;       //!< 空きブロックかどうか.
+    };
+
+    //=========================================================================
+    // private variables.
+    //=========================================================================
+    std::vector<Node>       m_Nodes;                    //!< ノードです.
+    std::vector<uint32_t>   m_UnusedNodes;              //!< 再利用できるノード番号です.
+    uint32_t                m_FreeHeads[FLCount][SLCount];  //!< 空きリストの先頭です.
+    uint64_t                m_FLBitmap;                 //!< 空きリストを持つ第1レベルのビットです.
+    uint32_t                m_SLBitmap[FLCount];        //!< 空きリストを持つ第2レベルのビットです.
+    uint64_t                m_Capacity;                 //!< 容量です.
+    uint64_t                m_Granularity;              //!< 確保の最小単位です.
+    uint32_t                m_GranularityShift;         //!< 確保の最小単位の log2 です.
+    uint64_t                m_UsedBytes;                //!< 確保中のサイズです.
+    uint32_t                m_AllocationCount;          //!< 確保中のブロック数です.
+    uint32_t                m_FreeBlockCount;           //!< 空きブロック数です.
+
+    //=========================================================================
+    // private methods.
+    //=========================================================================
+
+    //-------------------------------------------------------------------------
+    //! @brief      サイズが属する空きリストを求めます(切り捨て).
+    //-------------------------------------------------------------------------
+    void MappingInsert(uint64_t size, uint32_t& fl, uint32_t& sl) const;
+
+    //-------------------------------------------------------------------------
+    //! @brief      サイズ以上が必ず入る空きリストを求めます(切り上げ).
+    //-------------------------------------------------------------------------
+    bool MappingSearch(uint64_t size, uint32_t& fl, uint32_t& sl) const;
+
+    //-------------------------------------------------------------------------
+    //! @brief      指定リスト以降で空きのあるリストを探します.
+    //-------------------------------------------------------------------------
+    uint32_t FindSuitable(uint32_t& fl, uint32_t& sl) const;
+
+    //-------------------------------------------------------------------------
+    //! @brief      空きリストにノードを追加します.
+    //-------------------------------------------------------------------------
+    void InsertFree(uint32_t node);
+
+    //-------------------------------------------------------------------------
+    //! @brief      空きリストからノードを外します.
+    //-------------------------------------------------------------------------
+    void RemoveFree(uint32_t node);
+
+    //-------------------------------------------------------------------------
+    //! @brief      ノードを確保します.
+    //-------------------------------------------------------------------------
+    uint32_t NewNode();
+
+    //-------------------------------------------------------------------------
+    //! @brief      ノードを返却します.
+    //-------------------------------------------------------------------------
+    void DeleteNode(uint32_t node);
+
+    //-------------------------------------------------------------------------
+    //! @brief      ノードの先頭 size バイトを残し, 後ろを新しい空きブロックに分割します.
+    //-------------------------------------------------------------------------
+    void SplitTail(uint32_t node, uint64_t size);
+
+    TlsfAllocator       (const TlsfAllocator&) = delete;
+    void operator =     (const TlsfAllocator&) = delete;
+};
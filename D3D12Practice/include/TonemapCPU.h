@@ -0,0 +1,198 @@
+﻿//-----------------------------------------------------------------------------
+// File : TonemapCPU.h
+// Desc : CPU Reference Tonemapper.
+// Copyright(c) Pocol. All right reserved.
+//-----------------------------------------------------------------------------
+#pragma once
+
+//-----------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------
+#include "CubeMapCooker.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+
+///////////////////////////////////////////////////////////////////////////////
+// COLOR_SPACE_TYPE enum
+///////////////////////////////////////////////////////////////////////////////
+enum COLOR_SPACE_TYPE
+{
+    COLOR_SPACE_BT709,      // ITU-R BT.709
+    COLOR_SPACE_BT2100_PQ,  // ITU-R BT.2100 PQ System.
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// TONEMAP_TYPE enum
+///////////////////////////////////////////////////////////////////////////////
+enum TONEMAP_TYPE
+{
+    TONEMAP_NONE = 0,   // トーンマップなし.
+    TONEMAP_REINHARD,   // Reinhardトーンマップ.
+    TONEMAP_GT,         // GTトーンマップ.
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// TonemapParam structure
+///////////////////////////////////////////////////////////////////////////////
+//! @note       CbTonemap と同じ並びです.
+///////////////////////////////////////////////////////////////////////////////
+struct TonemapParam
+{
+    int     Type;               //!< トーンマップタイプです.
+    int     ColorSpace;         //!< 出力色空間です.
+    float   BaseLuminance;      //!< 基準輝度値[nit]です.
+    float   MaxLuminance;       //!< 最大輝度値[nit]です.
+};
+
+//-----------------------------------------------------------------------------
+//! @brief      1ピクセルにトーンマップと出力色空間への変換を適用します.
+//!
+//! @param[in]      param       トーンマップパラメータです.
+//! @param[in]      src         入力色(RGBA, 線形BT.709)です.
+//! @param[out]     dst         出力色の格納先です.
+//! @param[in]      exposure    トーンマップ前に乗算する露光です.
+//! @note       標準ライブラリの関数だけで計算する参照実装です.
+//-----------------------------------------------------------------------------
+void TonemapPixel(const TonemapParam& param, const float src[4], float dst[4], float exposure = 1.0f);
+
+//-----------------------------------------------------------------------------
+//! @brief      RGBA32F のピクセル列にトーンマップを適用します.
+//!
+//! @param[in]      param       トーンマップパラメータです.
+//! @param[in]      pSrc        入力ピクセルです.
+//! @param[out]     pDst        出力ピクセルの格納先です(pSrc と同じでも構いません).
+//! @param[in]      count       ピクセル数です.
+//! @param[in]      exposure    トーンマップ前に乗算する露光です.
+//! @note       4ピクセル単位でSSEを使って処理します. TonemapPixel() との差は2.5e-5以内です(PQ出力で最大).
+//-----------------------------------------------------------------------------
+void TonemapPixels(const TonemapParam& param, const float* pSrc, float* pDst, size_t count, float exposure = 1.0f);
+
+//-----------------------------------------------------------------------------
+//! @brief      画像にトーンマップを適用します.
+//!
+//! @param[in]      image       入力画像です.
+//! @param[in]      param       トーンマップパラメータです.
+//! @param[out]     result      出力画像の格納先です.
+//! @param[in]      threadCount ワーカースレッド数です(0ならハードウェアスレッド数).
+//! @param[in]      exposure    トーンマップ前に乗算する露光です.
+//! @retval true    変換に成功.
+//! @retval false   入力画像が不正です.
+//! @note       行をまとめたタイル単位でワーカースレッドに分配します.
+//-----------------------------------------------------------------------------
+bool TonemapImage(
+    const FloatImage&   image,
+    const TonemapParam& param,
+    FloatImage&         result,
+    uint32_t            threadCount = 0,
+    float               exposure    = 1.0f);
+
+
+//-----------------------------------------------------------------------------
+// Constant Values.
+//-----------------------------------------------------------------------------
+constexpr uint32_t  TONEMAP_LUT_MIN_SIZE        = 2;    //!< LUTの1辺の最小サイズです.
+constexpr uint32_t  TONEMAP_LUT_MAX_SIZE        = 128;  //!< LUTの1辺の最大サイズです.
+constexpr uint32_t  TONEMAP_LUT_SUBTEXEL_BITS   = 8;    //!< GPUのテクスチャフィルタの補間係数の精度です(D3D12_SUBTEXEL_FRACTIONAL_BIT_COUNT).
+
+///////////////////////////////////////////////////////////////////////////////
+// TonemapLUTDesc structure
+///////////////////////////////////////////////////////////////////////////////
+//! @note       入力は x' = log2(1 + x / 2^MinLog) で対数に符号化してからLUTを引きます.
+//!             暗部は線形, 明部は対数の間隔になり, 0 がちょうど先頭の格子点になります.
+///////////////////////////////////////////////////////////////////////////////
+struct TonemapLUTDesc
+{
+    uint32_t    Size    = 32;       //!< LUTの1辺のサイズです(32 か 64 を想定).
+    float       MinLog  = -12.0f;   //!< 線形区間の幅の log2 です.
+    float       MaxLog  = 8.0f;     //!< LUTで表す最大入力の log2 です(超えた値は飽和します).
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// TonemapLUTShaper structure
+///////////////////////////////////////////////////////////////////////////////
+//! @note       シェーダの CbTonemap の LutShaper と同じ並びです.
+///////////////////////////////////////////////////////////////////////////////
+struct TonemapLUTShaper
+{
+    float   InvEpsilon;     //!< 線形区間の幅の逆数です.
+    float   InvRange;       //!< 符号化後の値を [0, 1] に正規化する係数です.
+    float   Scale;          //!< テクスチャ座標へのスケールです((N - 1) / N).
+    float   Offset;         //!< テクスチャ座標へのオフセットです(0.5 / N).
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// TonemapLUTReport structure
+///////////////////////////////////////////////////////////////////////////////
+struct TonemapLUTReport
+{
+    uint32_t    SampleCount;        //!< 評価したサンプル数です.
+    float       MaxError;           //!< 出力値(符号化後)の最大誤差です.
+    float       MeanError;          //!< 出力値(符号化後)の平均誤差です.
+    float       MaxErrorInput[3];   //!< 最大誤差となった入力色です.
+    float       MaxErrorOutput[3];  //!< 最大誤差となった入力色の解析解です.
+};
+
+//-----------------------------------------------------------------------------
+//! @brief      LUTの入力符号化の定数を求めます.
+//!
+//! @param[in]      desc        LUTの設定です.
+//! @return     定数を返却します.
+//-----------------------------------------------------------------------------
+TonemapLUTShaper GetTonemapLUTShaper(const TonemapLUTDesc& desc);
+
+//-----------------------------------------------------------------------------
+//! @brief      トーンマップと出力色空間への変換をLUTに焼き込みます.
+//!
+//! @param[in]      param       トーンマップパラメータです.
+//! @param[in]      desc        LUTの設定です.
+//! @param[out]     lut         RGBA32F のLUTの格納先です(R が最も速く変化します).
+//! @param[in]      threadCount ワーカースレッド数です(0ならハードウェアスレッド数).
+//! @retval true    生成に成功.
+//! @retval false   パラメータが不正です.
+//! @note       露光はLUTの外で乗算するため, 露光が変わっても作り直す必要はありません.
+//-----------------------------------------------------------------------------
+bool BakeTonemapLUT(
+    const TonemapParam&     param,
+    const TonemapLUTDesc&   desc,
+    std::vector<float>&     lut,
+    uint32_t                threadCount = 0);
+
+//-----------------------------------------------------------------------------
+//! @brief      LUTを引きます.
+//!
+//! @param[in]      desc        LUTの設定です.
+//! @param[in]      pLUT        BakeTonemapLUT() で生成したLUTです.
+//! @param[in]      src         入力色(RGBA, 線形BT.709)です.
+//! @param[out]     dst         出力色の格納先です.
+//! @param[in]      exposure    LUTを引く前に乗算する露光です.
+//! @note       GPUと同じく, 補間係数を TONEMAP_LUT_SUBTEXEL_BITS に丸めたトライリニア補間です.
+//-----------------------------------------------------------------------------
+void SampleTonemapLUT(
+    const TonemapLUTDesc&   desc,
+    const float*            pLUT,
+    const float             src[4],
+    float                   dst[4],
+    float                   exposure = 1.0f);
+
+//-----------------------------------------------------------------------------
+//! @brief      LUTを解析解と比較して精度を評価します.
+//!
+//! @param[in]      param           トーンマップパラメータです.
+//! @param[in]      desc            LUTの設定です.
+//! @param[in]      lut             BakeTonemapLUT() で生成したLUTです.
+//! @param[out]     report          評価結果の格納先です.
+//! @param[in]      samplesPerAxis  1軸あたりのサンプル数です.
+//! @param[in]      threadCount     ワーカースレッド数です(0ならハードウェアスレッド数).
+//! @retval true    評価に成功.
+//! @retval false   パラメータが不正です.
+//! @note       入力は [0, 2^MaxLog] を符号化後の空間で等間隔に取り, 格子点の間を評価します.
+//-----------------------------------------------------------------------------
+bool EvaluateTonemapLUT(
+    const TonemapParam&         param,
+    const TonemapLUTDesc&       desc,
+    const std::vector<float>&   lut,
+    TonemapLUTReport&           report,
+    uint32_t                    samplesPerAxis = 65,
+    uint32_t                    threadCount    = 0);
@@ -0,0 +1,154 @@
+﻿//-----------------------------------------------------------------------------
+// File : TonemapLUT.h
+// Desc : Baked 3D LUT for Tonemapping.
+// Copyright(c) Pocol. All right reserved.
+//-----------------------------------------------------------------------------
+#pragma once
+
+//-----------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------
+#include <d3d12.h>
+#include <wrl/client.h>
+#include <future>
+#include <DescriptorPool.h>
+#include <TonemapCPU.h>
+
+
+///////////////////////////////////////////////////////////////////////////////
+// TonemapLUT class
+///////////////////////////////////////////////////////////////////////////////
+//! @note       パラメータが変わったときだけワーカースレッドでLUTを焼き直し, 出来上がったら転送します.
+//!             転送が終わるまでは IsReady() が false を返すので, 解析的なトーンマップで描画してください.
+///////////////////////////////////////////////////////////////////////////////
+class TonemapLUT
+{
+    //=========================================================================
+    // list of friend classes and methods.
+    //=========================================================================
+    /* NOTHING */
+
+public:
+    //=========================================================================
+    // public variables.
+    //=========================================================================
+    static const uint32_t FrameCount = 2;   //!< 転送バッファを再利用するまでに待つフレーム数です.
+
+    //=========================================================================
+    // public methods.
+    //=========================================================================
+
+    //-------------------------------------------------------------------------
+    //! @brief      コンストラクタです.
+    //-------------------------------------------------------------------------
+    TonemapLUT();
+
+    //-------------------------------------------------------------------------
+    //! @brief      デストラクタです.
+    //-------------------------------------------------------------------------
+    ~TonemapLUT();
+
+    //-------------------------------------------------------------------------
+    //! @brief      初期化処理を行います.
+    //!
+    //! @param[in]      pDevice     デバイスです.
+    //! @param[in]      pPoolRes    リソース用ディスクリプタプールです.
+    //! @param[in]      desc        LUTの設定です.
+    //! @retval true    初期化に成功.
+    //! @retval false   初期化に失敗.
+    //-------------------------------------------------------------------------
+    bool Init(ID3D12Device* pDevice, DescriptorPool* pPoolRes, const TonemapLUTDesc& desc);
+
+    //-------------------------------------------------------------------------
+    //! @brief      終了処理を行います.
+    //-------------------------------------------------------------------------
+    void Term();
+
+    //-------------------------------------------------------------------------
+    //! @brief      LUTの生成を要求します.
+    //!
+    //! @param[in]      param       トーンマップパラメータです.
+    //! @note       前回と同じパラメータなら何もしません. 生成中なら完了後に最新の要求を処理します.
+    //-------------------------------------------------------------------------
+    void Request(const TonemapParam& param);
+
+    //-------------------------------------------------------------------------
+    //! @brief      生成が完了したLUTをテクスチャに転送します.
+    //!
+    //! @param[in]      pCmd        コマンドリストです.
+    //! @retval true    LUTを更新しました.
+    //! @retval false   更新はありません.
+    //! @note       毎フレーム呼び出してください.
+    //-------------------------------------------------------------------------
+    bool Update(ID3D12GraphicsCommandList* pCmd);
+
+    //-------------------------------------------------------------------------
+    //! @brief      指定パラメータのLUTが使えるかどうかチェックします.
+    //-------------------------------------------------------------------------
+    bool IsReady(const TonemapParam& param) const;
+
+    //-------------------------------------------------------------------------
+    //! @brief      入力符号化の定数を取得します.
+    //-------------------------------------------------------------------------
+    const TonemapLUTShaper& GetShaper() const;
+
+    //-------------------------------------------------------------------------
+    //! @brief      LUTの設定を取得します.
+    //-------------------------------------------------------------------------
+    const TonemapLUTDesc& GetDesc() const;
+
+    //-------------------------------------------------------------------------
+    //! @brief      現在のLUTの精度の評価結果を取得します.
+    //-------------------------------------------------------------------------
+    const TonemapLUTReport& GetReport() const;
+
+    //-------------------------------------------------------------------------
+    //! @brief      LUTのSRVを取得します.
+    //-------------------------------------------------------------------------
+    D3D12_GPU_DESCRIPTOR_HANDLE GetHandleSRV() const;
+
+private:
+    ///////////////////////////////////////////////////////////////////////////
+    // BakeResult structure
+    ///////////////////////////////////////////////////////////////////////////
+    struct BakeResult
+    {
+        TonemapParam        Param;      //!< 生成に使ったパラメータです.
+        std::vector<float>  LUT;        //!< LUTです.
+        TonemapLUTReport    Report;     //!< 精度の評価結果です.
+        bool                Succeeded;  //!< 生成に成功したかどうか.
+    };
+
+    //=========================================================================
+    // private variables.
+    //=========================================================================
+    TonemapLUTDesc                          m_Desc;                 //!< LUTの設定です.
+    TonemapLUTShaper                        m_Shaper;               //!< 入力符号化の定数です.
+    Microsoft::WRL::ComPtr<ID3D12Resource>  m_pTexture;             //!< LUTテクスチャです.
+    Microsoft::WRL::ComPtr<ID3D12Resource>  m_pUpload;              //!< 転送バッファです.
+    uint64_t                                m_MemoryId;             //!< メモリ使用量の記録番号です.
+    D3D12_PLACED_SUBRESOURCE_FOOTPRINT      m_Footprint;            //!< 転送バッファのレイアウトです.
+    DescriptorPool*                         m_pPool;                //!< ディスクリプタプールです.
+    DescriptorHandle*                       m_pHandleSRV;           //!< LUTのSRVです.
+    std::future<BakeResult>                 m_Bake;                 //!< 生成中のLUTです.
+    TonemapParam                            m_RequestParam;         //!< 最後に要求されたパラメータです.
+    TonemapParam                            m_BakeParam;            //!< 生成中または生成済みのパラメータです.
+    TonemapParam                            m_ReadyParam;           //!< テクスチャに転送済みのパラメータです.
+    TonemapLUTReport                        m_Report;               //!< テクスチャのLUTの精度の評価結果です.
+    bool                                    m_HasRequest;           //!< 要求があるかどうか.
+    bool                                    m_Baking;               //!< 生成中かどうか.
+    bool                                    m_Ready;                //!< テクスチャが使えるかどうか.
+    uint32_t                                m_FramesSinceUpload;    //!< 最後に転送してからのフレーム数です.
+
+    //=========================================================================
+    // private methods.
+    //=========================================================================
+
+    //-------------------------------------------------------------------------
+    //! @brief      LUTを生成します(ワーカースレッドで実行されます).
+    //-------------------------------------------------------------------------
+    static BakeResult Bake(TonemapParam param, TonemapLUTDesc desc);
+
+    TonemapLUT          (const TonemapLUT&) = delete;
+    void operator =     (const TonemapLUT&) = delete;
+};
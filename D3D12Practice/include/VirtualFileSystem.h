@@ -0,0 +1,199 @@
+﻿//-----------------------------------------------------------------------------
+// File : VirtualFileSystem.h
+// Desc : Virtual File System.
+// Copyright(c) Pocol. All right reserved.
+//-----------------------------------------------------------------------------
+#pragma once
+
+//-----------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------
+#include <condition_variable>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+
+///////////////////////////////////////////////////////////////////////////////
+// VirtualFileSystem class
+///////////////////////////////////////////////////////////////////////////////
+//! @note       マウントしたディレクトリを一度だけ走査してパスの索引を作ります.
+//!             検索はマウントポイントごとに1回のハッシュ検索で, ファイルシステムには触れません.
+//!             索引は不変のスナップショットとして共有され, 更新時に差し替えられます.
+///////////////////////////////////////////////////////////////////////////////
+class VirtualFileSystem
+{
+    //=========================================================================
+    // list of friend classes and methods.
+    //=========================================================================
+    /* NOTHING */
+
+public:
+    //=========================================================================
+    // public variables.
+    //=========================================================================
+    static const uint32_t DefaultDepth      = 4;        //!< 走査する階層の既定値です.
+    static const uint32_t MaxFilesPerMount  = 65536;    //!< マウントポイントあたりの最大ファイル数です.
+
+    //=========================================================================
+    // public methods.
+    //=========================================================================
+
+    //-------------------------------------------------------------------------
+    //! @brief      コンストラクタです.
+    //-------------------------------------------------------------------------
+    VirtualFileSystem();
+
+    //-------------------------------------------------------------------------
+    //! @brief      デストラクタです.
+    //-------------------------------------------------------------------------
+    ~VirtualFileSystem();
+
+    //-------------------------------------------------------------------------
+    //! @brief      ディレクトリをマウントします.
+    //!
+    //! @param[in]      root        ディレクトリパスです.
+    //! @param[in]      maxDepth    走査する階層の深さです.
+    //! @retval true    マウントに成功.
+    //! @retval false   ディレクトリが存在しません.
+    //! @note       検索はマウントした順に行われます. 同じディレクトリの再マウントは無視されます.
+    //-------------------------------------------------------------------------
+    bool Mount(const std::filesystem::path& root, uint32_t maxDepth = DefaultDepth);
+
+    //-------------------------------------------------------------------------
+    //! @brief      全てのマウントを解除します.
+    //-------------------------------------------------------------------------
+    void UnmountAll();
+
+    //-------------------------------------------------------------------------
+    //! @brief      全てのマウントポイントを走査し直します.
+    //-------------------------------------------------------------------------
+    void Refresh();
+
+    //-------------------------------------------------------------------------
+    //! @brief      ディレクトリの監視を開始します.
+    //!
+    //! @param[in]      intervalMs      監視間隔[ms]です.
+    //! @note       走査したディレクトリの更新時刻が変わった場合に索引を作り直します.
+    //-------------------------------------------------------------------------
+    void StartWatch(uint32_t intervalMs = 1000);
+
+    //-------------------------------------------------------------------------
+    //! @brief      ディレクトリの監視を終了します.
+    //-------------------------------------------------------------------------
+    void StopWatch();
+
+    //-------------------------------------------------------------------------
+    //! @brief      ファイルパスを解決します.
+    //!
+    //! @param[in]      name        マウントポイントからの相対パス, または絶対パスです.
+    //! @param[out]     result      解決したパスの格納先です.
+    //! @retval true    見つかった.
+    //! @retval false   見つからなかった.
+    //! @note       スレッドセーフです.
+    //-------------------------------------------------------------------------
+    bool Resolve(const std::filesystem::path& name, std::filesystem::path& result) const;
+
+    //-------------------------------------------------------------------------
+    //! @brief      ファイルパスを解決します(ワイド文字列版).
+    //-------------------------------------------------------------------------
+    bool Resolve(const wchar_t* name, std::wstring& result) const;
+
+    //-------------------------------------------------------------------------
+    //! @brief      ファイルパスを解決します(UTF-8版).
+    //-------------------------------------------------------------------------
+    bool Resolve(const char* name, std::string& result) const;
+
+    //-------------------------------------------------------------------------
+    //! @brief      マウントポイント数を取得します.
+    //-------------------------------------------------------------------------
+    size_t GetMountCount() const;
+
+    //-------------------------------------------------------------------------
+    //! @brief      索引に登録されたファイル数を取得します.
+    //-------------------------------------------------------------------------
+    size_t GetFileCount() const;
+
+private:
+    ///////////////////////////////////////////////////////////////////////////
+    // MountPoint structure
+    ///////////////////////////////////////////////////////////////////////////
+    struct MountPoint
+    {
+        std::filesystem::path   Root;       //!< 正規化した絶対パスです.
+        std::string             Key;        //!< Root の索引のキーです(末尾に区切り文字を含みます).
+        uint32_t                MaxDepth;   //!< 走査する階層の深さです.
+    };
+
+    ///////////////////////////////////////////////////////////////////////////
+    // DirectoryStamp structure
+    ///////////////////////////////////////////////////////////////////////////
+    struct DirectoryStamp
+    {
+        std::filesystem::path               Path;       //!< ディレクトリパスです.
+        std::filesystem::file_time_type     Time;       //!< 走査時の更新時刻です.
+    };
+
+    ///////////////////////////////////////////////////////////////////////////
+    // Snapshot structure
+    ///////////////////////////////////////////////////////////////////////////
+    struct Snapshot
+    {
+        std::vector<MountPoint>                                 Mounts;         //!< マウントポイントです.
+        std::unordered_map<std::string, std::filesystem::path>  Files;          //!< 正規化したパスから実パスへの索引です.
+        std::vector<DirectoryStamp>                             Directories;    //!< 走査したディレクトリです.
+    };
+
+    //=========================================================================
+    // private variables.
+    //=========================================================================
+    std::shared_ptr<const Snapshot>     m_pSnapshot;        //!< 現在の索引です.
+    mutable std::mutex                  m_Mutex;            //!< 索引の差し替え用ミューテックスです.
+    std::mutex                          m_UpdateMutex;      //!< 索引の再構築用ミューテックスです.
+    std::thread                         m_WatchThread;      //!< 監視スレッドです.
+    std::mutex                          m_WatchMutex;       //!< 監視用ミューテックスです.
+    std::condition_variable             m_WatchCondition;   //!< 監視用条件変数です.
+    bool                                m_WatchStop;        //!< 監視の終了要求フラグです.
+
+    //=========================================================================
+    // private methods.
+    //=========================================================================
+
+    //-------------------------------------------------------------------------
+    //! @brief      現在の索引を取得します.
+    //-------------------------------------------------------------------------
+    std::shared_ptr<const Snapshot> GetSnapshot() const;
+
+    //-------------------------------------------------------------------------
+    //! @brief      索引を差し替えます.
+    //-------------------------------------------------------------------------
+    void SetSnapshot(std::shared_ptr<const Snapshot> pSnapshot);
+
+    //-------------------------------------------------------------------------
+    //! @brief      ディレクトリが変更されたかどうかを調べます.
+    //-------------------------------------------------------------------------
+    static bool IsModified(const Snapshot& snapshot);
+
+    //-------------------------------------------------------------------------
+    //! @brief      マウントポイントを走査して索引に追加します.
+    //-------------------------------------------------------------------------
+    static void Scan(const MountPoint& mount, Snapshot& snapshot);
+
+    //-------------------------------------------------------------------------
+    //! @brief      索引のキーを生成します.
+    //-------------------------------------------------------------------------
+    static std::string MakeKey(const std::filesystem::path& path);
+
+    //-------------------------------------------------------------------------
+    //! @brief      監視スレッドの処理です.
+    //-------------------------------------------------------------------------
+    void WatchThread(uint32_t intervalMs);
+
+    VirtualFileSystem   (const VirtualFileSystem&) = delete;
+    void operator =     (const VirtualFileSystem&) = delete;
+};
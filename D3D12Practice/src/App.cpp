@@ -5,11 +5,33 @@
 #include "VertexTypes.h"
 
 #include "FileUtil.h"
+#include "Hash.h"
 
 #include <assert.h>
+#include <cstdio>
+#include <cstring>
 
 namespace {
 	const auto ClassName = TEXT("SmapleWindowClass");
+	const char* const FrameStatsPath = "frame_stats.csv"; // フレーム統計の出力先
+	const uint64_t FrameStatsInterval = 120; // フレーム統計を出力する間隔(フレーム数)
+	const struct { MEMORY_CATEGORY Category; float Ratio; } MemoryBudgets[] = { // カテゴリごとのビデオメモリ予算(OSが示す予算に対する比率)
+		{ MEMORY_CATEGORY_TEXTURE, 0.50f },
+		{ MEMORY_CATEGORY_MESH, 0.15f },
+		{ MEMORY_CATEGORY_CONSTANT_BUFFER, 0.05f },
+		{ MEMORY_CATEGORY_RENDER_TARGET, 0.25f },
+		{ MEMORY_CATEGORY_IBL, 0.15f },
+	};
+	// QueryPerformanceCounter の値を[ms]にする(DXGI_FRAME_STATISTICS の時刻と同じ基準)
+	double QpcToMs(LONGLONG qpc) {
+		static const auto frequency = [] { LARGE_INTEGER value; QueryPerformanceFrequency(&value); return value.QuadPart; }();
+		return double(qpc) * 1000.0 / double(frequency);
+	}
+	// バックバッファに描くときのビューの形式(R8G8B8A8_UNORMはsRGBとして書き込む)
+	DXGI_FORMAT GetRenderTargetFormat(DXGI_FORMAT format) {
+		return (format == DXGI_FORMAT_R8G8B8A8_UNORM) ? DXGI_FORMAT_R8G8B8A8_UNORM_SRGB : format;
+	}
+
 	template<typename T> 
 	void SafeRelease(T*& ptr) { 
 		if (ptr != nullptr) {
@@ -24,12 +46,16 @@ namespace {
 	};
 }
 
-App::App(uint32_t width, uint32_t height) 
+App::App(uint32_t width, uint32_t height, DXGI_FORMAT format, LATENCY_MODE latencyMode, uint32_t maxLatency) 
 	: m_hInst(nullptr)
+	, m_BackBufferFormat(format)
 	, m_hWnd(nullptr)
 	, m_Width(width)
 	, m_Height(height) 
-{} 
+{
+	// ティアリングへの対応はデバイスの生成時に確認する
+	m_FramePacer.Init(latencyMode, maxLatency, false);
+} 
 
 App::~App()
 {
@@ -45,6 +71,13 @@ void App::Run()
 
 bool App::InitApp()
 {
+	// ファイル検索パスの索引を作成(デバッグ時はアセットの追加を監視する)
+#if defined(DEBUG) || defined(_DEBUG)
+	MountSearchPaths(true);
+#else
+	MountSearchPaths(false);
+#endif
+
 	// ウィンドウの初期化
 	if (!InitWnd()) {
 		return false;
@@ -58,14 +91,22 @@ bool App::InitApp()
 		return false;
 	}
 
+	// 初期化直後の使用量を予算と比べる
+	CheckMemoryBudgets();
+
+	// フレーム統計の出力先を開く(開けなくても描画は続ける)
+	m_FrameStats.OpenCsv(FrameStatsPath);
+
 	// 正常終了
 	return true;
 }
 
 void App::TermApp()
 {
+	m_FrameStats.CloseCsv();
 	TermD3D();
 	TermWnd();
+	UnmountSearchPaths();
 }
 
 bool App::InitWnd()
@@ -117,7 +158,7 @@ bool App::InitWnd()
 		nullptr,
 		nullptr,
 		m_hInst,
-		nullptr
+		this // WM_CREATE でウィンドウに関連付ける
 	);
 
 	if (m_hWnd == nullptr) {
@@ -133,6 +174,10 @@ bool App::InitWnd()
 
 void App::TermWnd()
 {
+	// 破棄した後にメッセージが届いてもアプリを呼ばない
+	if (m_hWnd != nullptr) {
+		SetWindowLongPtr(m_hWnd, GWLP_USERDATA, 0);
+	}
 	if (m_hInst != nullptr) {
 		UnregisterClass(ClassName, m_hInst);
 	}
@@ -142,17 +187,122 @@ void App::TermWnd()
 
 void App::MainLoop()
 {
+	// 描画は専用のスレッドで行い、メッセージが続けて届いてもフレームを遅らせない
+	m_StopRender = false;
+	m_RenderThread = std::thread(&App::RenderLoop, this);
+
+	// このスレッドはメッセージの処理だけを行う(届いたものはすべて処理する)
 	MSG msg = {};
+	while (GetMessage(&msg, nullptr, 0, 0) > 0) {
+		TranslateMessage(&msg);
+		DispatchMessage(&msg);
+	}
 
-	while (WM_QUIT != msg.message)
-	{
-		if (PeekMessage(&msg, nullptr, 0, 0, PM_REMOVE) == TRUE) {
+	// 通常はウィンドウを閉じる時に止めている
+	StopRenderThread();
+}
+
+void App::RenderLoop()
+{
+	while (!m_StopRender.load()) {
+		m_FenceWaitMs = 0.0f;
+		auto begin = std::chrono::steady_clock::now();
+		WaitFrameLatency();
+		OnRender();
+		auto end = std::chrono::steady_clock::now();
+		UpdateFrameStats(begin, end);
+	}
+}
+
+void App::StopRenderThread()
+{
+	// 終了を待つ間に届いたメッセージで再び呼ばれた場合は何もしない
+	if (!m_RenderThread.joinable() || m_StopRender.exchange(true)) {
+		return;
+	}
+
+	// 描画スレッドは表示処理やタイトルの更新でこのスレッドにメッセージを送って待つことがあるので、
+	// メッセージを処理しながら終了を待つ
+	auto hThread = static_cast<HANDLE>(m_RenderThread.native_handle());
+	auto quit = false;
+	int exitCode = 0;
+	while (MsgWaitForMultipleObjects(1, &hThread, FALSE, INFINITE, QS_ALLINPUT) == WAIT_OBJECT_0 + 1) {
+		MSG msg = {};
+		while (PeekMessage(&msg, nullptr, 0, 0, PM_REMOVE) == TRUE) {
+			if (msg.message == WM_QUIT) {
+				quit = true;
+				exitCode = int(msg.wParam);
+				continue;
+			}
 			TranslateMessage(&msg);
 			DispatchMessage(&msg);
 		}
-		else {
-			Render();
+	}
+	m_RenderThread.join();
+
+	// 取り出してしまった終了要求を戻す
+	if (quit) {
+		PostQuitMessage(exitCode);
+	}
+}
+
+void App::UpdateFrameStats(std::chrono::steady_clock::time_point begin, std::chrono::steady_clock::time_point end)
+{
+	// 最初のフレームは間隔が無いので記録しない
+	if (m_HasLastFrame) {
+		auto frameMs = std::chrono::duration<float, std::milli>(end - m_LastFrameTime).count();
+		auto renderMs = std::chrono::duration<float, std::milli>(end - begin).count();
+		auto buildMs = (renderMs > m_FenceWaitMs) ? renderMs - m_FenceWaitMs : 0.0f;
+		m_FrameStats.AddFrame(frameMs, buildMs, m_FenceWaitMs);
+	}
+	m_LastFrameTime = end;
+	m_HasLastFrame = true;
+
+	// 一定間隔でCSVに書き出し、タイトルに表示する
+	auto count = m_FrameStats.GetFrameCount();
+	if (count == 0 || (count % FrameStatsInterval) != 0) {
+		return;
+	}
+
+	FrameStatsSummary summary;
+	if (!m_FrameStats.GetSummary(summary)) {
+		return;
+	}
+
+	m_FrameStats.WriteCsv(summary);
+	CheckMemoryBudgets();
+
+	if (m_ShowFrameStats && m_hWnd != nullptr) {
+		char title[256];
+		FrameStats::FormatOverlay(summary, title, sizeof(title));
+		if (m_FramePacer.GetLatencyMs() > 0.0) {
+			auto length = strlen(title);
+			snprintf(title + length, sizeof(title) - length, " | Latency %.1f ms", m_FramePacer.GetLatencyMs());
+		}
+		SetWindowTextA(m_hWnd, title);
+	}
+}
+
+void App::CheckMemoryBudgets()
+{
+	uint64_t budget = 0;
+	uint64_t usage = 0;
+	QueryVideoMemory(m_pDevice.Get(), budget, usage); // 取得できなければ比率の予算は使わない
+
+	// 同じ超過を毎回出力しないよう、新たに超えたカテゴリだけ出力する
+	auto overBudget = GetMemoryTracker().CheckBudgets(budget, usage);
+	auto newlyOver = overBudget & ~m_OverBudget;
+	m_OverBudget = overBudget;
+
+	for (auto i = 0u; i < MEMORY_CATEGORY_COUNT; ++i) {
+		if ((newlyOver & (1u << i)) == 0) {
+			continue;
 		}
+		auto category = MEMORY_CATEGORY(i);
+		printf("Warning : %s memory is over budget. (%.2f MB / %.2f MB)\n",
+			MemoryTracker::GetName(category),
+			GetMemoryTracker().GetStats(category, MEMORY_DOMAIN_GPU).CurrentBytes / (1024.0 * 1024.0),
+			GetMemoryTracker().GetBudget(category) / (1024.0 * 1024.0));
 	}
 }
 
@@ -177,6 +327,34 @@ bool App::InitD3D()
 		return false;
 	}
 
+	// パイプラインステートキャッシュの初期化
+	if (!m_PipelineCache.Init(m_pDevice.Get(), L"pso_cache.bin")) {
+		return false;
+	}
+
+	// 配置リソース用ヒープアロケータの初期化
+	if (!m_HeapAllocator.Init(m_pDevice.Get())) {
+		return false;
+	}
+
+	// カテゴリごとのビデオメモリ予算を設定
+	for (auto& budget : MemoryBudgets) {
+		GetMemoryTracker().SetBudgetRatio(budget.Category, budget.Ratio);
+	}
+
+	// シェーダバンドルをマップ(無い場合は個別の.csoファイルから読み込む)
+	if (m_ShaderBundle.Open(L"../shader_bin/shaders.bundle")) {
+#if defined(DEBUG) || defined(_DEBUG)
+		// 壊れたバンドルは使わない
+		if (!m_ShaderBundle.Verify()) {
+			m_ShaderBundle.Close();
+		}
+#endif
+	}
+	if (m_ShaderBundle.IsOpen()) {
+		m_ShaderBundleMemory = GetMemoryTracker().Add(MEMORY_CATEGORY_SHADER, MEMORY_DOMAIN_CPU, m_ShaderBundle.GetSize(), "ShaderBundle");
+	}
+
 	// コマンドキューの生成
 	{
 		D3D12_COMMAND_QUEUE_DESC desc = {};
@@ -199,26 +377,48 @@ bool App::InitD3D()
 			return false; 
 		}
 
-		DXGI_SWAP_CHAIN_DESC desc = {};
-		desc.BufferDesc.Width = m_Width;
-		desc.BufferDesc.Height = m_Height;
-		desc.BufferDesc.RefreshRate.Numerator = 60;
-		desc.BufferDesc.RefreshRate.Denominator = 1;
-		desc.BufferDesc.ScanlineOrdering = DXGI_MODE_SCANLINE_ORDER_UNSPECIFIED;
-		desc.BufferDesc.Scaling = DXGI_MODE_SCALING_UNSPECIFIED;
-		desc.BufferDesc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
+		// ティアリング(垂直同期無しの表示)に対応しているか確認
+		auto tearingSupported = false;
+		{
+			ComPtr<IDXGIFactory5> pFactory5;
+			if (SUCCEEDED(pFactory->QueryInterface(IID_PPV_ARGS(&pFactory5)))) {
+				BOOL allowTearing = FALSE;
+				hr = pFactory5->CheckFeatureSupport(DXGI_FEATURE_PRESENT_ALLOW_TEARING, &allowTearing, sizeof(allowTearing));
+				tearingSupported = SUCCEEDED(hr) && (allowTearing == TRUE);
+			}
+		}
+		m_FramePacer.Init(m_FramePacer.GetMode(), m_FramePacer.GetMaxLatency(), tearingSupported);
+
+		DXGI_SWAP_CHAIN_DESC1 desc = {};
+		desc.Width = m_Width;
+		desc.Height = m_Height;
+		desc.Format = m_BackBufferFormat;
+		desc.Stereo = FALSE;
 		desc.SampleDesc.Count = 1;
 		desc.SampleDesc.Quality = 0;
 		desc.BufferUsage = DXGI_USAGE_RENDER_TARGET_OUTPUT;
 		desc.BufferCount = FrameCount;
-		desc.OutputWindow = m_hWnd;
-		desc.Windowed = TRUE;
+		desc.Scaling = DXGI_SCALING_STRETCH;
 		desc.SwapEffect = DXGI_SWAP_EFFECT_FLIP_DISCARD;
+		desc.AlphaMode = DXGI_ALPHA_MODE_UNSPECIFIED;
 		desc.Flags = DXGI_SWAP_CHAIN_FLAG_ALLOW_MODE_SWITCH;
+		if (m_FramePacer.UseWaitableObject()) {
+			desc.Flags |= DXGI_SWAP_CHAIN_FLAG_FRAME_LATENCY_WAITABLE_OBJECT; // フレームの開始時に待てるようにする
+		}
+		if (m_FramePacer.AllowTearing()) {
+			desc.Flags |= DXGI_SWAP_CHAIN_FLAG_ALLOW_TEARING; // Present(0)で垂直同期を待たずに表示する
+		}
 
-		IDXGISwapChain* pSwapChain = nullptr;
+		DXGI_SWAP_CHAIN_FULLSCREEN_DESC fullscreenDesc = {};
+		fullscreenDesc.RefreshRate.Numerator = 60;
+		fullscreenDesc.RefreshRate.Denominator = 1;
+		fullscreenDesc.ScanlineOrdering = DXGI_MODE_SCANLINE_ORDER_UNSPECIFIED;
+		fullscreenDesc.Scaling = DXGI_MODE_SCALING_UNSPECIFIED;
+		fullscreenDesc.Windowed = TRUE;
 
-		hr = pFactory->CreateSwapChain(m_pQueue.Get(), &desc, &pSwapChain);
+		IDXGISwapChain1* pSwapChain = nullptr;
+
+		hr = pFactory->CreateSwapChainForHwnd(m_pQueue.Get(), m_hWnd, &desc, &fullscreenDesc, nullptr, &pSwapChain);
 		if (FAILED(hr)) {
 			SafeRelease(pFactory);
 			return false; 
@@ -231,6 +431,17 @@ bool App::InitD3D()
 		  return false; 
 		}
 
+		// 表示待ちのフレーム数を制限し、空いたらシグナルになるオブジェクトを取得
+		if (m_FramePacer.UseWaitableObject()) {
+			hr = m_pSwapChain->SetMaximumFrameLatency(m_FramePacer.GetMaxLatency());
+			if (FAILED(hr)) {
+				SafeRelease(pFactory);
+				SafeRelease(pSwapChain);
+				return false;
+			}
+			m_FrameLatencyWaitable = m_pSwapChain->GetFrameLatencyWaitableObject();
+		}
+
 		m_FrameIndex = m_pSwapChain->GetCurrentBackBufferIndex();
 		SafeRelease(pFactory);
 		SafeRelease(pSwapChain);
@@ -291,10 +502,11 @@ bool App::InitD3D()
 			if (FAILED(hr)) {
 				return false;
 			}
+			m_ColorBufferMemory[i] = TrackResource(m_pColorBuffer[i].Get(), MEMORY_CATEGORY_RENDER_TARGET, "BackBuffer");
 
 			// 次元情報、ピクセルフォーマット
 			D3D12_RENDER_TARGET_VIEW_DESC viewDesc = {};
-			viewDesc.Format = DXGI_FORMAT_R8G8B8A8_UNORM_SRGB;
+			viewDesc.Format = GetRenderTargetFormat(m_BackBufferFormat);
 			viewDesc.ViewDimension = D3D12_RTV_DIMENSION_TEXTURE2D;
 			viewDesc.Texture2D.MipSlice = 0;
 			viewDesc.Texture2D.PlaneSlice = 0;
@@ -344,6 +556,9 @@ void App::TermD3D()
 {
 	WaitGpu();
 
+	// アプリのリソースの破棄(解放漏れの報告より先に行う)
+	OnTerm();
+
 	if (m_FenceEvent != nullptr)
 	{
 		CloseHandle(m_FenceEvent);
@@ -357,6 +572,8 @@ void App::TermD3D()
 	m_pHeapRTV.Reset();
 	for (auto i = 0u; i < FrameCount; ++i) {
 		m_pColorBuffer[i].Reset();
+		GetMemoryTracker().Remove(m_ColorBufferMemory[i]);
+		m_ColorBufferMemory[i] = 0;
 	}
 
 	// コマンドリストの破棄
@@ -368,16 +585,40 @@ void App::TermD3D()
 	}
 
 	// スワップチェインの破棄
+	if (m_FrameLatencyWaitable != nullptr) {
+		CloseHandle(m_FrameLatencyWaitable);
+		m_FrameLatencyWaitable = nullptr;
+	}
 	m_pSwapChain.Reset();
 
 	// コマンドキューの破棄
 	m_pQueue.Reset();
 
+	// 配置リソースの破棄とヒープの解放
+	m_pDepthBuffer.Reset();
+	m_HeapAllocator.Free(m_DepthAlloc);
+	m_HeapAllocator.Free(m_VB);
+	m_HeapAllocator.Free(m_IB);
+	m_HeapAllocator.Term();
+
+	// パイプラインステートキャッシュの保存と破棄
+	m_PipelineCache.Term();
+
+	// シェーダバンドルのアンマップ
+	m_ShaderBundle.Close();
+	GetMemoryTracker().Remove(m_ShaderBundleMemory);
+	m_ShaderBundleMemory = 0;
+
+	// 最大使用量と解放漏れの報告
+	CheckMemoryBudgets();
+	printf("%s", GetMemoryTracker().FormatReport().c_str());
+	printf("%s", GetMemoryTracker().FormatLeakReport().c_str());
+
 	//デバイスの破棄
 	m_pDevice.Reset();
 }
 
-void App::Render()
+void App::OnRender()
 {
 	{  
 		m_RotateAngle += 0.025f;
@@ -451,7 +692,7 @@ void App::Render()
 	ID3D12CommandList* ppCmdLists[] = { m_pCmdList.Get() };
 	m_pQueue->ExecuteCommandLists(1, ppCmdLists);
 
-	Present(1);
+	Present(GetSyncInterval());
 }
 
 void App::WaitGpu()
@@ -469,6 +710,43 @@ void App::WaitGpu()
 	m_FenceCounter[m_FrameIndex]++;
 }
 
+void App::WaitFrameLatency()
+{
+	// 表示待ちが最大遅延フレーム数を下回るまで待つ(フレーム構築とは別に計る)
+	auto count = m_FramePacer.GetWaitCount();
+	if (count > 0 && m_FrameLatencyWaitable != nullptr) {
+		auto waitBegin = std::chrono::steady_clock::now();
+		uint32_t signaled = 0;
+		for (auto i = 0u; i < count; ++i) {
+			// 前に待ちきれなかった分も待つ(確認するだけでは表示待ちが減らず、遅延が残る)。待つのは合わせてWaitTimeoutMsまで
+			auto elapsedMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - waitBegin).count();
+			DWORD timeout = 0;
+			if (elapsedMs < FramePacer::WaitTimeoutMs) {
+				timeout = DWORD(FramePacer::WaitTimeoutMs - elapsedMs);
+			}
+			if (WaitForSingleObjectEx(m_FrameLatencyWaitable, timeout, TRUE) == WAIT_OBJECT_0) {
+				signaled++;
+			}
+		}
+		m_FramePacer.OnWaitResult(signaled);
+		m_FenceWaitMs += std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - waitBegin).count();
+	}
+
+	// 入力はここから読むので、遅延の起点にする
+	LARGE_INTEGER now;
+	QueryPerformanceCounter(&now);
+	m_FrameBeginMs = QpcToMs(now.QuadPart);
+}
+
+void App::UpdateLatency()
+{
+	// 最後に画面に出た表示の時刻(表示処理を呼ぶたびに確認する)
+	DXGI_FRAME_STATISTICS stats = {};
+	if (SUCCEEDED(m_pSwapChain->GetFrameStatistics(&stats)) && stats.PresentCount != 0) {
+		m_FramePacer.OnDisplayed(stats.PresentCount, QpcToMs(stats.SyncQPCTime.QuadPart));
+	}
+}
+
 bool App::OnInit()
 {
 	// 頂点バッファの生成
@@ -480,56 +758,16 @@ bool App::OnInit()
 			{ DirectX::XMFLOAT3(-1.0f, 1.0f, 0.0f), DirectX::XMFLOAT4(1.0f, 0.0f, 1.0f, 1.0f)},
 		};
 
-		// ヒーププロパティ
-		D3D12_HEAP_PROPERTIES prop = {};
-		prop.Type = D3D12_HEAP_TYPE_UPLOAD;
-		prop.CPUPageProperty = D3D12_CPU_PAGE_PROPERTY_UNKNOWN;
-		prop.MemoryPoolPreference = D3D12_MEMORY_POOL_UNKNOWN;
-		prop.CreationNodeMask = 1;
-		prop.VisibleNodeMask = 1;
-
-		// リソースの設定
-		D3D12_RESOURCE_DESC desc = {};
-		desc.Dimension = D3D12_RESOURCE_DIMENSION_BUFFER;
-		desc.Alignment = 0;
-		desc.Width = sizeof(vertices);
-		desc.Height = 1;
-		desc.DepthOrArraySize = 1;
-		desc.MipLevels = 1;
-		desc.Format = DXGI_FORMAT_UNKNOWN;
-		desc.SampleDesc.Count = 1;
-		desc.SampleDesc.Quality = 0;
-		desc.Layout = D3D12_TEXTURE_LAYOUT_ROW_MAJOR;
-		desc.Flags = D3D12_RESOURCE_FLAG_NONE;
-
-		// リソースの生成
-		auto hr = m_pDevice->CreateCommittedResource(
-			&prop,
-			D3D12_HEAP_FLAG_NONE,
-			&desc,
-			D3D12_RESOURCE_STATE_GENERIC_READ,
-			nullptr,
-			IID_PPV_ARGS(m_pVB.GetAddressOf()));
-
-		if (FAILED(hr)) {
+		// アップロードヒープのページから切り出す(個別にヒープを作らない)
+		if (!m_HeapAllocator.AllocateBuffer(D3D12_HEAP_TYPE_UPLOAD, sizeof(vertices), 256, m_VB, MEMORY_CATEGORY_MESH, "VertexBuffer")) {
 			return false;
 		}
 
-		// マッピング
-		void* ptr = nullptr;
-		hr = m_pVB->Map(0, nullptr, &ptr);
-		if (FAILED(hr)) {
-			return false;
-		}
-
-		// 頂点データをマッピング先に設定
-		memcpy(ptr, vertices, sizeof(vertices));
-
-		//マッピング解除
-		m_pVB->Unmap(0, nullptr);
+		// 頂点データをマッピング先に設定(ページは常にマップ済み)
+		memcpy(m_VB.pCpu, vertices, sizeof(vertices));
 
 		// 頂点バッファビュー
-		m_VBV.BufferLocation = m_pVB->GetGPUVirtualAddress(); // GPUの仮想アドレス
+		m_VBV.BufferLocation = m_VB.GpuAddress; // GPUの仮想アドレス
 		m_VBV.SizeInBytes = static_cast<UINT>(sizeof(vertices)); // 頂点バッファ全体のサイズ
 		m_VBV.StrideInBytes = static_cast<UINT>(sizeof(Vertex)); // 1頂点あたりのサイズ
 	}
@@ -538,56 +776,16 @@ bool App::OnInit()
 	{
 		uint32_t indices[] = { 0, 1, 2, 0, 2, 3 };
 
-		// ヒーププロパティ
-		D3D12_HEAP_PROPERTIES prop = {};
-		prop.Type = D3D12_HEAP_TYPE_UPLOAD;
-		prop.CPUPageProperty = D3D12_CPU_PAGE_PROPERTY_UNKNOWN;
-		prop.MemoryPoolPreference = D3D12_MEMORY_POOL_UNKNOWN;
-		prop.CreationNodeMask = 1;
-		prop.VisibleNodeMask = 1;
-
-		// リソースの設定
-		D3D12_RESOURCE_DESC desc = {};
-		desc.Dimension = D3D12_RESOURCE_DIMENSION_BUFFER;
-		desc.Alignment = 0; 
-		desc.Width = sizeof(indices);
-		desc.Height = 1;  desc.DepthOrArraySize = 1;
-		desc.MipLevels = 1;
-		desc.Format = DXGI_FORMAT_UNKNOWN;
-		desc.SampleDesc.Count = 1;
-		desc.SampleDesc.Quality = 0;
-		desc.Layout = D3D12_TEXTURE_LAYOUT_ROW_MAJOR;
-		desc.Flags = D3D12_RESOURCE_FLAG_NONE;
-
-		// リソースの生成
-		auto hr = m_pDevice->CreateCommittedResource(
-			&prop,
-			D3D12_HEAP_FLAG_NONE,
-			&desc,
-			D3D12_RESOURCE_STATE_GENERIC_READ,
-			nullptr,
-			IID_PPV_ARGS(m_pIB.GetAddressOf()));
-		
-		if (FAILED(hr)) {
-			return false; 
-		}
-
-		// マッピングする
-		void* ptr = nullptr;
-		hr = m_pIB->Map(0, nullptr, &ptr);
-		
-		if (FAILED(hr)) {
+		// アップロードヒープのページから切り出す
+		if (!m_HeapAllocator.AllocateBuffer(D3D12_HEAP_TYPE_UPLOAD, sizeof(indices), 256, m_IB, MEMORY_CATEGORY_MESH, "IndexBuffer")) {
 			return false;
 		}
 
 		// インデックスデータをマッピング先に設定
-		memcpy(ptr, indices, sizeof(indices));
-
-		// マッピング解除
-		m_pIB->Unmap(0, nullptr);
+		memcpy(m_IB.pCpu, indices, sizeof(indices));
 
 		// インデックスバッファービューの設定
-		m_IBV.BufferLocation = m_pIB->GetGPUVirtualAddress();
+		m_IBV.BufferLocation = m_IB.GpuAddress;
 		m_IBV.Format = DXGI_FORMAT_R32_UINT;
 		m_IBV.SizeInBytes = sizeof(indices);
 	}
@@ -611,44 +809,17 @@ bool App::OnInit()
 
 	// 定数バッファの生成
 	{
-		D3D12_HEAP_PROPERTIES prop = {};
-		prop.Type = D3D12_HEAP_TYPE_UPLOAD;
-		prop.CPUPageProperty = D3D12_CPU_PAGE_PROPERTY_UNKNOWN;
-		prop.MemoryPoolPreference = D3D12_MEMORY_POOL_UNKNOWN;
-		prop.CreationNodeMask = 1;
-		prop.VisibleNodeMask = 1;
-
-		D3D12_RESOURCE_DESC desc = {};
-		desc.Dimension = D3D12_RESOURCE_DIMENSION_BUFFER;
-		desc.Alignment = 0;
-		desc.Width = sizeof(Transform);
-		desc.Height = 1;
-		desc.DepthOrArraySize = 1;
-		desc.MipLevels = 1;
-		desc.Format = DXGI_FORMAT_UNKNOWN;
-		desc.SampleDesc.Count = 1;
-		desc.SampleDesc.Quality = 0;
-		desc.Layout = D3D12_TEXTURE_LAYOUT_ROW_MAJOR;
-		desc.Flags = D3D12_RESOURCE_FLAG_NONE;
-
 		auto incrementSize = m_pDevice->GetDescriptorHandleIncrementSize(
 			D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
 		
 		for (auto i = 0; i < FrameCount * 2; ++i)
 		{
-			// リソース生成
-			auto hr = m_pDevice->CreateCommittedResource(
-				&prop,
-				D3D12_HEAP_FLAG_NONE,
-				&desc,
-				D3D12_RESOURCE_STATE_GENERIC_READ,
-				nullptr,
-				IID_PPV_ARGS(m_pCB[i].GetAddressOf()));
-			if (FAILED(hr)) {
+			// アップロードヒープのページから256バイト単位で切り出す
+			if (!m_HeapAllocator.AllocateBuffer(D3D12_HEAP_TYPE_UPLOAD, sizeof(Transform), 256, m_CB[i], MEMORY_CATEGORY_CONSTANT_BUFFER, "Transform")) {
 				return false;
 			}
 
-			auto address = m_pCB[i]->GetGPUVirtualAddress();
+			auto address = m_CB[i].GpuAddress;
 			auto handleCPU = m_pHeapCBV->GetCPUDescriptorHandleForHeapStart();
 			auto handleGPU = m_pHeapCBV->GetGPUDescriptorHandleForHeapStart();
 			handleCPU.ptr += incrementSize * i;
@@ -661,10 +832,7 @@ bool App::OnInit()
 
 			m_pDevice->CreateConstantBufferView(&m_CBV[i].Desc, handleCPU);
 
-			hr = m_pCB[i]->Map(0, nullptr, reinterpret_cast<void**>(&m_CBV[i].pBuffer));
-			if (FAILED(hr)) {
-				return false;
-			}
+			m_CBV[i].pBuffer = reinterpret_cast<Transform*>(m_CB[i].pCpu);
 
 			auto eyePos = DirectX::XMVectorSet(0.0f, 0.0f, 5.0f, 0.0f);
 			auto targetPos = DirectX::XMVectorZero();
@@ -681,13 +849,6 @@ bool App::OnInit()
 
 	// 深度ステンシルバッファの生成
 	{
-		D3D12_HEAP_PROPERTIES prop = {};
-		prop.Type = D3D12_HEAP_TYPE_DEFAULT;
-		prop.CPUPageProperty = D3D12_CPU_PAGE_PROPERTY_UNKNOWN;
-		prop.MemoryPoolPreference = D3D12_MEMORY_POOL_UNKNOWN;
-		prop.CreationNodeMask = 1;
-		prop.VisibleNodeMask = 1;
-
 		D3D12_RESOURCE_DESC resDesc = {};
 		resDesc.Dimension = D3D12_RESOURCE_DIMENSION_TEXTURE2D;
 		resDesc.Alignment = 0;
@@ -706,16 +867,16 @@ bool App::OnInit()
 		clearValue.DepthStencil.Depth = 1.0f;
 		clearValue.DepthStencil.Stencil = 0;
 
-		auto hr = m_pDevice->CreateCommittedResource(
-			&prop,
-			D3D12_HEAP_FLAG_NONE,
-			&resDesc,
+		// レンダーターゲット用ヒープのページに配置する
+		if (!m_HeapAllocator.CreateResource(
+			D3D12_HEAP_TYPE_DEFAULT,
+			resDesc,
 			D3D12_RESOURCE_STATE_DEPTH_WRITE,
 			&clearValue,
-			IID_PPV_ARGS(m_pDepthBuffer.GetAddressOf())
-		);
-
-		if (FAILED(hr)) {
+			m_pDepthBuffer.GetAddressOf(),
+			m_DepthAlloc,
+			MEMORY_CATEGORY_RENDER_TARGET,
+			"DepthBuffer")) {
 			return false;
 		}
 
@@ -725,7 +886,7 @@ bool App::OnInit()
 		heapDesc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_DSV;
 		heapDesc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_NONE;
 		heapDesc.NodeMask = 0;
-		hr = m_pDevice->CreateDescriptorHeap(
+		auto hr = m_pDevice->CreateDescriptorHeap(
 			&heapDesc,
 			IID_PPV_ARGS(m_pHeapDSV.GetAddressOf())
 		);
@@ -753,6 +914,9 @@ bool App::OnInit()
 
 	}
 
+	// ルートシグニチャのハッシュ値(パイプラインステートキャッシュのキーに使用)
+	uint64_t rootSigHash = 0;
+
 	// ルートシグニチャの生成
 	{
 		auto flag = D3D12_ROOT_SIGNATURE_FLAG_ALLOW_INPUT_ASSEMBLER_INPUT_LAYOUT;
@@ -786,6 +950,9 @@ bool App::OnInit()
 			return false;
 		}
 
+		// シリアライズ結果はポインタ値を含まないのでそのままハッシュ化する
+		rootSigHash = HashFNV1a64(pBlob->GetBufferPointer(), pBlob->GetBufferSize());
+
 		hr = m_pDevice->CreateRootSignature(
 			0,
 			pBlob->GetBufferPointer(),
@@ -858,43 +1025,39 @@ bool App::OnInit()
 		ComPtr<ID3DBlob> pVSBlob;
 		ComPtr<ID3DBlob> pPSBlob;
 
+		D3D12_SHADER_BYTECODE vs = {};
+		D3D12_SHADER_BYTECODE ps = {};
+
 		// 頂点シェーダー
-		auto hr = D3DReadFileToBlob(L"../shader_bin/simple_v.cso", pVSBlob.GetAddressOf());
-		if (FAILED(hr)) {
+		if (!LoadShader("simple_v.cso", vs, pVSBlob.GetAddressOf())) {
 			return false;
 		}
 
 		// ピクセルシェーダー
-		hr = D3DReadFileToBlob(L"../shader_bin/simple_p.cso", pPSBlob.GetAddressOf());
-		if (FAILED(hr)) {
+		if (!LoadShader("simple_p.cso", ps, pPSBlob.GetAddressOf())) {
 			return false;
 		}
 
 		D3D12_GRAPHICS_PIPELINE_STATE_DESC desc = {};
 		desc.InputLayout = { elements, _countof(elements) };
 		desc.pRootSignature = m_pRootSignature.Get();
-		desc.VS = {
-			pVSBlob->GetBufferPointer(),
-			pVSBlob->GetBufferSize()
-		};
-		desc.PS = {
-			pPSBlob->GetBufferPointer(),
-			pPSBlob->GetBufferSize()
-		};
+		desc.VS = vs;
+		desc.PS = ps;
 		desc.RasterizerState = descRS;
 		desc.BlendState = descBS;
 		desc.DepthStencilState = descDSS;
 		desc.SampleMask = UINT_MAX;
 		desc.PrimitiveTopologyType = D3D12_PRIMITIVE_TOPOLOGY_TYPE_TRIANGLE;
 		desc.NumRenderTargets = 1;
-		desc.RTVFormats[0] = DXGI_FORMAT_R8G8B8A8_UNORM_SRGB;
+		desc.RTVFormats[0] = GetRenderTargetFormat(m_BackBufferFormat);
 		desc.DSVFormat = DXGI_FORMAT_D32_FLOAT;
 		desc.SampleDesc.Count = 1;
 		desc.SampleDesc.Quality = 0;
 
-		hr = m_pDevice->CreateGraphicsPipelineState(
-			&desc,
-			IID_PPV_ARGS(m_pPSO.GetAddressOf()));
+		auto hr = m_PipelineCache.CreateGraphicsPipelineState(
+			desc,
+			rootSigHash,
+			m_pPSO.GetAddressOf());
 		if (FAILED(hr)) {
 			return false;
 		}
@@ -918,25 +1081,44 @@ bool App::OnInit()
 
 void App::OnTerm()
 {
-	for (auto i = 0; i < FrameCount; ++i)
+	for (auto i = 0; i < FrameCount * 2; ++i)
 	{
-		if (m_pCB[i].Get() != nullptr) {
-			m_pCB[i]->Unmap(0, nullptr);
-			memset(&m_CBV[i], 0, sizeof(m_CBV[i]));
-		} 
-		m_pCB[i].Reset(); 
-		m_pPSO.Reset();
+		// ページは常にマップ済みなのでアンマップ不要
+		m_HeapAllocator.Free(m_CB[i]);
+		memset(&m_CBV[i], 0, sizeof(m_CBV[i]));
 	}
+	m_pPSO.Reset();
+}
+
+void App::OnMsgProc(HWND hWnd, UINT msg, WPARAM wp, LPARAM lp)
+{
+	// 既定では何もしない
+	(void)hWnd;
+	(void)msg;
+	(void)wp;
+	(void)lp;
 }
 
 void App::Present(uint32_t interval)
 {
+	// ティアリングはウィンドウモードでだけ要求できる
+	BOOL fullscreen = FALSE;
+	m_pSwapChain->GetFullscreenState(&fullscreen, nullptr);
+	auto tearing = (interval == 0) && m_FramePacer.UseTearing(fullscreen == TRUE);
+
 	// フロントバッファを画面に表示、バックバッファのスワップ処理
 	m_pSwapChain->Present(
 		interval,		// 垂直同期とフレームの表示を同期する方法を指定。0-immidiate 1-1回目の垂直同期後(60fps) 2 - 2回目の垂直同期後(30fps)
-		0
+		tearing ? DXGI_PRESENT_ALLOW_TEARING : 0
 	);
 
+	// 入力から表示までの遅延を集計
+	UINT presentId = 0;
+	if (SUCCEEDED(m_pSwapChain->GetLastPresentCount(&presentId))) {
+		m_FramePacer.OnPresent(presentId, m_FrameBeginMs);
+	}
+	UpdateLatency();
+
 	// シグナル処理
 	const auto currentValue = m_FenceCounter[m_FrameIndex];
 	m_pQueue->Signal(
@@ -952,16 +1134,79 @@ void App::Present(uint32_t interval)
 
 		m_pFence->SetEventOnCompletion(m_FenceCounter[m_FrameIndex], m_FenceEvent);
 
+		// フレーム構築とは別にフェンス待ちの時間を計る
+		auto waitBegin = std::chrono::steady_clock::now();
 		WaitForSingleObjectEx(m_FenceEvent, INFINITE, FALSE); 
+		m_FenceWaitMs += std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - waitBegin).count();
 	}
 
 	// 次のフレームのフェンスカウンターを増やす
 	m_FenceCounter[m_FrameIndex] = currentValue + 1;
 }
 
+uint32_t App::GetSyncInterval() const
+{
+	return m_FramePacer.GetSyncInterval();
+}
+
+bool App::LoadShader(const char* name, D3D12_SHADER_BYTECODE& bytecode, ID3DBlob** ppBlob)
+{
+	if (name == nullptr || ppBlob == nullptr) {
+		return false;
+	}
+
+	// バンドルにあればマップ済みのメモリを直接参照する(追加のI/Oなし)
+	ShaderBundle::Blob blob = {};
+	if (m_ShaderBundle.Find(name, blob)) {
+		bytecode.pShaderBytecode = blob.pData;
+		bytecode.BytecodeLength = blob.Size;
+		return true;
+	}
+
+	// バンドルに無ければファイルを検索して読み込む
+	std::wstring filename(name, name + strlen(name));
+	std::wstring path;
+	if (!SearchFilePath(filename.c_str(), path)
+	 && !SearchFilePath((L"shader_bin\\" + filename).c_str(), path)) {
+		return false;
+	}
+
+	auto hr = D3DReadFileToBlob(path.c_str(), ppBlob);
+	if (FAILED(hr)) {
+		return false;
+	}
+
+	bytecode.pShaderBytecode = (*ppBlob)->GetBufferPointer();
+	bytecode.BytecodeLength = (*ppBlob)->GetBufferSize();
+	return true;
+}
+
 LRESULT App::WndProc(HWND hWnd, UINT msg, WPARAM wp, LPARAM lp)
 {
+	// WM_CREATEより前のメッセージではまだ関連付けられていない
+	auto pApp = reinterpret_cast<App*>(GetWindowLongPtr(hWnd, GWLP_USERDATA));
+	if (pApp != nullptr) {
+		pApp->OnMsgProc(hWnd, msg, wp, lp);
+	}
+
 	switch (msg) {
+	case WM_CREATE:
+	{
+		// メッセージから描画スレッドを止められるようにアプリを関連付ける
+		auto pCreate = reinterpret_cast<CREATESTRUCT*>(lp);
+		SetWindowLongPtr(hWnd, GWLP_USERDATA, reinterpret_cast<LONG_PTR>(pCreate->lpCreateParams));
+	}
+	break;
+
+	case WM_CLOSE:
+	{
+		// スワップチェインの出力先が無くなる前に描画スレッドを止める
+		if (pApp != nullptr) {
+			pApp->StopRenderThread();
+		}
+	}
+	break;
+
 	case WM_DESTROY:
 	{PostQuitMessage(0); }
 	break;
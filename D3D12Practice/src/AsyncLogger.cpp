@@ -0,0 +1,645 @@
+﻿//-----------------------------------------------------------------------------
+// File : AsyncLogger.cpp
+// Desc : Asynchronous Lock-Free Logger.
+// Copyright(c) Pocol. All right reserved.
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------
+#include "AsyncLogger.h"
+#include <algorithm>
+#include <chrono>
+#include <csignal>
+#include <cstdlib>
+#include <exception>
+
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif//NOMINMAX
+#include <Windows.h>
+#endif
+
+
+namespace {
+
+//-----------------------------------------------------------------------------
+// Constant Values.
+//-----------------------------------------------------------------------------
+constexpr uint64_t  NanosecondsPerWindow    = 1000000000ull;    // 流量制限の区間の長さ[ns]です.
+constexpr uint32_t  CrashFlushTimeoutMs     = 100;              // 異常終了時に書き出しを待つ時間[ms]です.
+constexpr int       CrashSignals[]          = { SIGSEGV, SIGABRT, SIGFPE, SIGILL };
+
+std::terminate_handler  g_PrevTerminate = nullptr;  // 登録前の terminate ハンドラです.
+std::atomic<bool>       g_CrashHandled  { false };  // 異常終了時の書き出しを済ませたかどうか.
+
+//-----------------------------------------------------------------------------
+//      現在時刻[ns]を取得します.
+//-----------------------------------------------------------------------------
+uint64_t GetTimeNs()
+{
+    return uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+//-----------------------------------------------------------------------------
+//      異常終了時に残りを書き出します.
+//-----------------------------------------------------------------------------
+void FlushOnCrash()
+{
+    // 複数のハンドラが続けて呼ばれた場合も1回だけ書き出す.
+    if (g_CrashHandled.exchange(true))
+    { return; }
+
+    // シグナルハンドラから呼ぶのは安全ではないが, 最後のログを残すことを優先する.
+    GetAsyncLogger().TryFlush(CrashFlushTimeoutMs);
+}
+
+//-----------------------------------------------------------------------------
+//      terminate ハンドラです.
+//-----------------------------------------------------------------------------
+void OnTerminate()
+{
+    FlushOnCrash();
+
+    if (g_PrevTerminate != nullptr)
+    { g_PrevTerminate(); }
+
+    std::abort();
+}
+
+//-----------------------------------------------------------------------------
+//      シグナルハンドラです.
+//-----------------------------------------------------------------------------
+void OnSignal(int sig)
+{
+    FlushOnCrash();
+
+    // 既定の処理に戻して再送出する.
+    signal(sig, SIG_DFL);
+    raise(sig);
+}
+
+#if defined(_WIN32)
+LPTOP_LEVEL_EXCEPTION_FILTER g_PrevFilter = nullptr;   // 登録前の未処理例外フィルタです.
+
+//-----------------------------------------------------------------------------
+//      未処理例外フィルタです.
+//-----------------------------------------------------------------------------
+LONG WINAPI OnUnhandledException(EXCEPTION_POINTERS* pInfo)
+{
+    FlushOnCrash();
+
+    if (g_PrevFilter != nullptr)
+    { return g_PrevFilter(pInfo); }
+
+    return EXCEPTION_CONTINUE_SEARCH;
+}
+#endif
+
+//-----------------------------------------------------------------------------
+//      異常終了時のハンドラを登録します.
+//-----------------------------------------------------------------------------
+void InstallCrashHandlers()
+{
+    static std::once_flag s_Once;
+    std::call_once(s_Once, []()
+    {
+        g_PrevTerminate = std::set_terminate(OnTerminate);
+
+        for (auto sig : CrashSignals)
+        { signal(sig, OnSignal); }
+
+    #if defined(_WIN32)
+        g_PrevFilter = SetUnhandledExceptionFilter(OnUnhandledException);
+    #endif
+    });
+}
+
+//-----------------------------------------------------------------------------
+//      引数を書式に合わせて追加します.
+//-----------------------------------------------------------------------------
+template<typename T>
+void AppendValue(std::string& line, const char* spec, T value)
+{
+    char buffer[256];
+    auto length = snprintf(buffer, sizeof(buffer), spec, value);
+    if (length > 0)
+    { line.append(buffer, (size_t(length) < sizeof(buffer)) ? size_t(length) : sizeof(buffer) - 1); }
+}
+
+//-----------------------------------------------------------------------------
+//      符号無しとして扱う値を元のサイズに切り詰めます.
+//-----------------------------------------------------------------------------
+uint64_t Truncate(uint64_t value, uint8_t size)
+{ return (size >= 8) ? value : (value & ((1ull << (size * 8)) - 1)); }
+
+} // namespace
+
+
+///////////////////////////////////////////////////////////////////////////////
+// AsyncLogger class
+///////////////////////////////////////////////////////////////////////////////
+thread_local AsyncLogger::RingOwner AsyncLogger::s_Owner;
+
+//-----------------------------------------------------------------------------
+//      コンストラクタです.
+//-----------------------------------------------------------------------------
+AsyncLogger::AsyncLogger()
+: m_Stop            (false)
+, m_Console         (true)
+, m_pFile           (nullptr)
+, m_RateLimit       (DefaultRateLimit)
+, m_NextThreadId    (0)
+, m_Written         (0)
+, m_Dropped         (0)
+, m_Suppressed      (0)
+, m_ReportedDropped (0)
+{ m_Batch.reserve(RingSize); }
+
+//-----------------------------------------------------------------------------
+//      デストラクタです.
+//-----------------------------------------------------------------------------
+AsyncLogger::~AsyncLogger()
+{ Term(); }
+
+//-----------------------------------------------------------------------------
+//      バックグラウンドスレッドを開始します.
+//-----------------------------------------------------------------------------
+bool AsyncLogger::Init(const char* path, bool console, bool handleCrash)
+{
+    if (m_Thread.joinable())
+    { return true; }
+
+    auto result = true;
+    {
+        std::lock_guard<std::timed_mutex> locker(m_DrainMutex);
+        m_Console = console;
+
+        if (path != nullptr)
+        {
+            m_pFile = fopen(path, "w");
+            result  = (m_pFile != nullptr);
+        }
+    }
+
+    if (handleCrash)
+    { InstallCrashHandlers(); }
+
+    m_Stop   = false;
+    m_Thread = std::thread(&AsyncLogger::ThreadProc, this);
+
+    if (!result)
+    { ALOG("Error : File Open Failed. path = %s", path); }
+
+    return result;
+}
+
+//-----------------------------------------------------------------------------
+//      残りを書き出してバックグラウンドスレッドを終了します.
+//-----------------------------------------------------------------------------
+void AsyncLogger::Term()
+{
+    if (m_Thread.joinable())
+    {
+        {
+            std::lock_guard<std::mutex> locker(m_WakeMutex);
+            m_Stop = true;
+        }
+        m_Wake.notify_all();
+        m_Thread.join();
+    }
+
+    Flush();
+
+    std::lock_guard<std::timed_mutex> locker(m_DrainMutex);
+    if (m_pFile != nullptr)
+    {
+        fclose(m_pFile);
+        m_pFile = nullptr;
+    }
+}
+
+//-----------------------------------------------------------------------------
+//      積まれているメッセージをすべて書き出します.
+//-----------------------------------------------------------------------------
+void AsyncLogger::Flush()
+{
+    std::lock_guard<std::timed_mutex> locker(m_DrainMutex);
+    Drain();
+}
+
+//-----------------------------------------------------------------------------
+//      待つ時間を限って, 積まれているメッセージをすべて書き出します.
+//-----------------------------------------------------------------------------
+bool AsyncLogger::TryFlush(uint32_t timeoutMs)
+{
+    if (!m_DrainMutex.try_lock_for(std::chrono::milliseconds(timeoutMs)))
+    { return false; }
+
+    Drain();
+    m_DrainMutex.unlock();
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+//      呼び出し箇所ごとの1秒あたりの出力数の上限を設定します.
+//-----------------------------------------------------------------------------
+void AsyncLogger::SetRateLimit(uint32_t count)
+{ m_RateLimit.store(count, std::memory_order_relaxed); }
+
+//-----------------------------------------------------------------------------
+//      統計を取得します.
+//-----------------------------------------------------------------------------
+AsyncLogStats AsyncLogger::GetStats() const
+{
+    AsyncLogStats result;
+    result.Written      = m_Written   .load(std::memory_order_relaxed);
+    result.Dropped      = m_Dropped   .load(std::memory_order_relaxed);
+    result.Suppressed   = m_Suppressed.load(std::memory_order_relaxed);
+    return result;
+}
+
+//-----------------------------------------------------------------------------
+//      流量制限を確認します.
+//-----------------------------------------------------------------------------
+bool AsyncLogger::Admit(AsyncLogSite& site, uint64_t time, uint32_t& suppressed)
+{
+    suppressed = 0;
+
+    auto limit = m_RateLimit.load(std::memory_order_relaxed);
+    if (limit == 0)
+    { return true; }
+
+    // 区間が変わったら最初に気付いたスレッドがカウンタを戻し, 捨てた数を引き取る.
+    auto window  = time / NanosecondsPerWindow;
+    auto current = site.Window.load(std::memory_order_relaxed);
+    if (current != window && site.Window.compare_exchange_strong(current, window, std::memory_order_relaxed))
+    {
+        site.Count.store(0, std::memory_order_relaxed);
+        suppressed = site.Suppressed.exchange(0, std::memory_order_relaxed);
+    }
+
+    if (site.Count.fetch_add(1, std::memory_order_relaxed) < limit)
+    { return true; }
+
+    site.Suppressed.fetch_add(1, std::memory_order_relaxed);
+    m_Suppressed   .fetch_add(1, std::memory_order_relaxed);
+    return false;
+}
+
+//-----------------------------------------------------------------------------
+//      流量制限を確認し, このスレッドのリングの書き込み先を取得します.
+//-----------------------------------------------------------------------------
+AsyncLogger::Record* AsyncLogger::BeginRecord(AsyncLogSite& site)
+{
+    auto     time       = GetTimeNs();
+    uint32_t suppressed = 0;
+    if (!Admit(site, time, suppressed))
+    { return nullptr; }
+
+    auto pRing = s_Owner.pRing;
+    if (pRing == nullptr)
+    { pRing = RegisterRing(); }
+
+    auto head = pRing->Head.load(std::memory_order_relaxed);
+    auto tail = pRing->Tail.load(std::memory_order_acquire);
+    if (head - tail >= RingSize)
+    {
+        m_Dropped.fetch_add(1, std::memory_order_relaxed);
+        return nullptr;
+    }
+
+    auto& record = pRing->Records[head & (RingSize - 1)];
+    record.pSite        = &site;
+    record.Time         = time;
+    record.ThreadId     = pRing->ThreadId;
+    record.Suppressed   = suppressed;
+    record.ArgCount     = 0;
+    record.TextUsed     = 0;
+
+    return &record;
+}
+
+//-----------------------------------------------------------------------------
+//      このスレッドのリングを登録します.
+//-----------------------------------------------------------------------------
+AsyncLogger::Ring* AsyncLogger::RegisterRing()
+{
+    std::unique_ptr<Ring> ring(new Ring());
+    ring->Head    .store(0, std::memory_order_relaxed);
+    ring->Tail    .store(0, std::memory_order_relaxed);
+    ring->Orphaned.store(false, std::memory_order_relaxed);
+    ring->ThreadId = m_NextThreadId.fetch_add(1, std::memory_order_relaxed);
+
+    auto pRing = ring.get();
+    {
+        std::lock_guard<std::mutex> locker(m_RingMutex);
+        m_Rings.push_back(std::move(ring));
+    }
+
+    s_Owner.pRing = pRing;
+    return pRing;
+}
+
+//-----------------------------------------------------------------------------
+//      書き込んだレコードを公開します.
+//-----------------------------------------------------------------------------
+void AsyncLogger::EndRecord()
+{
+    auto pRing = s_Owner.pRing;
+    pRing->Head.store(pRing->Head.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+}
+
+//-----------------------------------------------------------------------------
+//      全リングのレコードを取り出して書き出します.
+//-----------------------------------------------------------------------------
+void AsyncLogger::Drain()
+{
+    m_Batch.clear();
+    {
+        std::lock_guard<std::mutex> locker(m_RingMutex);
+        for (auto itr = m_Rings.begin(); itr != m_Rings.end();)
+        {
+            auto& ring = **itr;
+
+            // 先に終了を確認しておけば, それまでに積まれたレコードは必ず見える.
+            auto orphaned = ring.Orphaned.load(std::memory_order_acquire);
+            auto head     = ring.Head.load(std::memory_order_acquire);
+            auto tail     = ring.Tail.load(std::memory_order_relaxed);
+
+            for (; tail != head; ++tail)
+            { m_Batch.push_back(ring.Records[tail & (RingSize - 1)]); }
+
+            ring.Tail.store(tail, std::memory_order_release);
+
+            if (orphaned)
+            { itr = m_Rings.erase(itr); }
+            else
+            { ++itr; }
+        }
+    }
+
+    // スレッドをまたいで時刻順に並べる.
+    std::stable_sort(m_Batch.begin(), m_Batch.end(),
+        [](const Record& lhs, const Record& rhs) { return lhs.Time < rhs.Time; });
+
+    for (auto& record : m_Batch)
+    {
+        Format(record, m_Line);
+        Output(m_Line);
+    }
+    m_Written.fetch_add(m_Batch.size(), std::memory_order_relaxed);
+
+    auto dropped = m_Dropped.load(std::memory_order_relaxed);
+    if (dropped != m_ReportedDropped)
+    {
+        m_Line.clear();
+        AppendValue(m_Line, "[AsyncLogger] %llu messages dropped (queue full).\n",
+            static_cast<unsigned long long>(dropped - m_ReportedDropped));
+        Output(m_Line);
+        m_ReportedDropped = dropped;
+    }
+
+    if (m_pFile != nullptr)
+    { fflush(m_pFile); }
+    if (m_Console)
+    { fflush(stderr); }
+}
+
+//-----------------------------------------------------------------------------
+//      レコードを1行に整形します.
+//-----------------------------------------------------------------------------
+void AsyncLogger::Format(const Record& record, std::string& line) const
+{
+    line.clear();
+
+    // ELOG と同じ接頭辞に, 積んだスレッドを加える.
+    char prefix[512];
+    auto length = snprintf(prefix, sizeof(prefix), "[File : %s, Line : %d, Thread : %u] ",
+        record.pSite->File, record.pSite->Line, record.ThreadId);
+    if (length > 0)
+    { line.append(prefix, (size_t(length) < sizeof(prefix)) ? size_t(length) : sizeof(prefix) - 1); }
+
+    auto     p        = record.pSite->Format;
+    uint32_t argIndex = 0;
+    while (*p != '\0')
+    {
+        if (*p != '%')
+        {
+            line.push_back(*p);
+            ++p;
+            continue;
+        }
+
+        if (p[1] == '%')
+        {
+            line.push_back('%');
+            p += 2;
+            continue;
+        }
+
+        // フラグ, 幅, 精度はそのまま使い, 長さ修飾子は引数の型に合わせて付け直す.
+        char spec[32];
+        size_t count = 0;
+        spec[count++] = *p++;
+        while (*p != '\0' && strchr("-+ #0123456789.", *p) != nullptr && count < sizeof(spec) - 4)
+        { spec[count++] = *p++; }
+
+        while (*p != '\0' && strchr("hlLzjtIq", *p) != nullptr)
+        { ++p; }
+
+        auto conversion = *p;
+        if (conversion == '\0')
+        { break; }
+        ++p;
+
+        if (argIndex >= record.ArgCount)
+        {
+            line.append("<?>");
+            continue;
+        }
+
+        auto type  = record.Types[argIndex];
+        auto size  = record.Sizes[argIndex];
+        auto value = record.Args [argIndex];
+        argIndex++;
+
+        double real;
+        memcpy(&real, &value, sizeof(real));
+
+        switch (conversion)
+        {
+        case 'd':
+        case 'i':
+            {
+                spec[count++] = 'l';
+                spec[count++] = 'l';
+                spec[count++] = conversion;
+                spec[count]   = '\0';
+                auto v = (type == ARG_TYPE_DOUBLE) ? static_cast<long long>(real) : static_cast<long long>(value);
+                AppendValue(line, spec, v);
+            }
+            break;
+
+        case 'u':
+        case 'x':
+        case 'X':
+        case 'o':
+            {
+                spec[count++] = 'l';
+                spec[count++] = 'l';
+                spec[count++] = conversion;
+                spec[count]   = '\0';
+                auto v = (type == ARG_TYPE_DOUBLE) ? static_cast<unsigned long long>(real) : static_cast<unsigned long long>(Truncate(value, size));
+                AppendValue(line, spec, v);
+            }
+            break;
+
+        case 'c':
+            {
+                spec[count++] = 'c';
+                spec[count]   = '\0';
+                AppendValue(line, spec, static_cast<int>(value));
+            }
+            break;
+
+        case 'f':
+        case 'F':
+        case 'e':
+        case 'E':
+        case 'g':
+        case 'G':
+        case 'a':
+        case 'A':
+            {
+                spec[count++] = conversion;
+                spec[count]   = '\0';
+                auto v = (type == ARG_TYPE_DOUBLE) ? real
+                       : (type == ARG_TYPE_INT)    ? double(int64_t(value))
+                                                   : double(value);
+                AppendValue(line, spec, v);
+            }
+            break;
+
+        case 's':
+        case 'S':
+            {
+                if (type != ARG_TYPE_STRING)
+                {
+                    line.append("<?>");
+                    break;
+                }
+                spec[count++] = 's';
+                spec[count]   = '\0';
+                AppendValue(line, spec, &record.Text[value]);
+            }
+            break;
+
+        case 'p':
+            {
+                spec[count++] = 'p';
+                spec[count]   = '\0';
+                AppendValue(line, spec, reinterpret_cast<void*>(uintptr_t(value)));
+            }
+            break;
+
+        default:
+            line.append("<?>");
+            break;
+        }
+    }
+
+    if (record.Suppressed > 0)
+    {
+        char suffix[64];
+        length = snprintf(suffix, sizeof(suffix), " (%u similar messages suppressed)", record.Suppressed);
+        if (length > 0)
+        { line.append(suffix, (size_t(length) < sizeof(suffix)) ? size_t(length) : sizeof(suffix) - 1); }
+    }
+
+    line.push_back('\n');
+}
+
+//-----------------------------------------------------------------------------
+//      1行を書き出します.
+//-----------------------------------------------------------------------------
+void AsyncLogger::Output(const std::string& line)
+{
+    if (m_pFile != nullptr)
+    { fputs(line.c_str(), m_pFile); }
+
+    if (m_Console)
+    {
+        fputs(line.c_str(), stderr);
+    #if defined(_WIN32)
+        OutputDebugStringA(line.c_str());
+    #endif
+    }
+}
+
+//-----------------------------------------------------------------------------
+//      バックグラウンドスレッドの処理です.
+//-----------------------------------------------------------------------------
+void AsyncLogger::ThreadProc()
+{
+    std::unique_lock<std::mutex> locker(m_WakeMutex);
+    while (!m_Stop)
+    {
+        m_Wake.wait_for(locker, std::chrono::milliseconds(uint32_t(FlushIntervalMs)));
+
+        locker.unlock();
+        Flush();
+        locker.lock();
+    }
+}
+
+//-----------------------------------------------------------------------------
+//      文字列をテキスト領域にコピーします.
+//-----------------------------------------------------------------------------
+void AsyncLogger::PackString(Record& record, const char* value)
+{
+    if (value == nullptr)
+    { value = "(null)"; }
+
+    // 領域が足りなければ切り詰める. 一杯でも最後の終端文字を空文字として使う.
+    auto offset = (record.TextUsed < TextSize) ? record.TextUsed : TextSize - 1;
+    auto used   = offset;
+    while (*value != '\0' && used < TextSize - 1)
+    { record.Text[used++] = *value++; }
+    record.Text[used++] = '\0';
+
+    record.TextUsed = uint8_t(used);
+    SetArg(record, ARG_TYPE_STRING, offset, sizeof(value));
+}
+
+//-----------------------------------------------------------------------------
+//      ワイド文字列をテキスト領域にコピーします.
+//-----------------------------------------------------------------------------
+void AsyncLogger::PackString(Record& record, const wchar_t* value)
+{
+    if (value == nullptr)
+    { value = L"(null)"; }
+
+    auto offset = (record.TextUsed < TextSize) ? record.TextUsed : TextSize - 1;
+    auto used   = offset;
+    while (*value != L'\0' && used < TextSize - 1)
+    {
+        auto c = *value++;
+        record.Text[used++] = (c < 0x80) ? char(c) : '?';
+    }
+    record.Text[used++] = '\0';
+
+    record.TextUsed = uint8_t(used);
+    SetArg(record, ARG_TYPE_STRING, offset, sizeof(value));
+}
+
+//-----------------------------------------------------------------------------
+//      プロセス全体で共有する非同期ロガーを取得します.
+//-----------------------------------------------------------------------------
+AsyncLogger& GetAsyncLogger()
+{
+    static AsyncLogger s_Logger;
+    return s_Logger;
+}
@@ -0,0 +1,291 @@
+﻿//-----------------------------------------------------------------------------
+// File : AsyncPipelineCompiler.cpp
+// Desc : Asynchronous Pipeline State Compiler.
+// Copyright(c) Pocol. All right reserved.
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------
+#include "AsyncPipelineCompiler.h"
+#include <algorithm>
+
+
+namespace {
+
+//-----------------------------------------------------------------------------
+// Constant Values.
+//-----------------------------------------------------------------------------
+constexpr uint32_t MaxThreadCount = 4;  // ワーカースレッド数の上限.
+
+//-----------------------------------------------------------------------------
+//      シェーダバイトコードを複製します.
+//-----------------------------------------------------------------------------
+D3D12_SHADER_BYTECODE CopyShader(const D3D12_SHADER_BYTECODE& src, std::vector<uint8_t>& storage)
+{
+    if (src.pShaderBytecode == nullptr || src.BytecodeLength == 0)
+    { return D3D12_SHADER_BYTECODE{ nullptr, 0 }; }
+
+    auto ptr = static_cast<const uint8_t*>(src.pShaderBytecode);
+    storage.assign(ptr, ptr + src.BytecodeLength);
+    return D3D12_SHADER_BYTECODE{ storage.data(), storage.size() };
+}
+
+} // namespace
+
+
+///////////////////////////////////////////////////////////////////////////////
+// AsyncPipelineCompiler class
+///////////////////////////////////////////////////////////////////////////////
+
+//-----------------------------------------------------------------------------
+//      コンストラクタです.
+//-----------------------------------------------------------------------------
+AsyncPipelineCompiler::AsyncPipelineCompiler()
+: m_pCache      (nullptr)
+, m_Stop        (false)
+, m_TotalLatency(0.0)
+, m_Stats       ()
+{ /* DO_NOTHING */ }
+
+//-----------------------------------------------------------------------------
+//      デストラクタです.
+//-----------------------------------------------------------------------------
+AsyncPipelineCompiler::~AsyncPipelineCompiler()
+{ Term(); }
+
+//-----------------------------------------------------------------------------
+//      初期化処理を行います.
+//-----------------------------------------------------------------------------
+bool AsyncPipelineCompiler::Init(PipelineCache* pCache, uint32_t threadCount)
+{
+    if (pCache == nullptr)
+    { return false; }
+
+    m_pCache = pCache;
+    m_Stop   = false;
+
+    if (threadCount == 0)
+    {
+        // 描画スレッドの分を残す.
+        auto hardware = std::thread::hardware_concurrency();
+        threadCount = (hardware > 1) ? hardware - 1 : 1;
+    }
+    threadCount = std::min(threadCount, MaxThreadCount);
+
+    for (auto i = 0u; i < threadCount; ++i)
+    { m_Threads.emplace_back(&AsyncPipelineCompiler::WorkerThread, this); }
+
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+//      終了処理を行います.
+//-----------------------------------------------------------------------------
+void AsyncPipelineCompiler::Term()
+{
+    {
+        std::lock_guard<std::mutex> locker(m_Mutex);
+        m_Stop = true;
+        m_Queue.clear();
+    }
+    m_Condition.notify_all();
+
+    for (auto& thread : m_Threads)
+    {
+        if (thread.joinable())
+        { thread.join(); }
+    }
+    m_Threads.clear();
+
+    m_Finished.clear();
+    {
+        std::lock_guard<std::mutex> locker(m_EntryMutex);
+        m_Entries.clear();
+    }
+    m_pCache = nullptr;
+}
+
+//-----------------------------------------------------------------------------
+//      グラフィックスパイプラインステートの生成を要求します.
+//-----------------------------------------------------------------------------
+PipelineHandle AsyncPipelineCompiler::Request
+(
+    const D3D12_GRAPHICS_PIPELINE_STATE_DESC&   desc,
+    uint64_t                                    rootSigHash,
+    PipelineHandle                              fallback
+)
+{
+    if (m_pCache == nullptr)
+    { return INVALID_PIPELINE_HANDLE; }
+
+    auto entry = std::make_unique<Entry>();
+    entry->Desc        = desc;
+    entry->pRootSig    = desc.pRootSignature;
+    entry->RootSigHash = rootSigHash;
+    entry->Fallback    = fallback;
+    entry->LatencyMs   = 0.0;
+    entry->Result      = E_PENDING;
+    entry->Status      = PIPELINE_STATUS_PENDING;
+
+    // 呼び出し側のデータに依存しないよう複製する.
+    entry->Desc.VS = CopyShader(desc.VS, entry->Shaders[0]);
+    entry->Desc.PS = CopyShader(desc.PS, entry->Shaders[1]);
+    entry->Desc.DS = CopyShader(desc.DS, entry->Shaders[2]);
+    entry->Desc.HS = CopyShader(desc.HS, entry->Shaders[3]);
+    entry->Desc.GS = CopyShader(desc.GS, entry->Shaders[4]);
+
+    entry->Elements.assign(
+        desc.InputLayout.pInputElementDescs,
+        desc.InputLayout.pInputElementDescs + desc.InputLayout.NumElements);
+    for (auto& element : entry->Elements)
+    {
+        entry->Names.emplace_back(element.SemanticName);
+        element.SemanticName = entry->Names.back().c_str();
+    }
+    entry->Desc.InputLayout.pInputElementDescs = entry->Elements.data();
+
+    entry->SOEntries.assign(
+        desc.StreamOutput.pSODeclaration,
+        desc.StreamOutput.pSODeclaration + desc.StreamOutput.NumEntries);
+    for (auto& soEntry : entry->SOEntries)
+    {
+        if (soEntry.SemanticName == nullptr)
+        { continue; }
+
+        entry->Names.emplace_back(soEntry.SemanticName);
+        soEntry.SemanticName = entry->Names.back().c_str();
+    }
+    entry->SOStrides.assign(
+        desc.StreamOutput.pBufferStrides,
+        desc.StreamOutput.pBufferStrides + desc.StreamOutput.NumStrides);
+    entry->Desc.StreamOutput.pSODeclaration = entry->SOEntries.data();
+    entry->Desc.StreamOutput.pBufferStrides = entry->SOStrides.data();
+
+    entry->Desc.CachedPSO.pCachedBlob           = nullptr;
+    entry->Desc.CachedPSO.CachedBlobSizeInBytes = 0;
+
+    // 複製までは呼び出し側のスレッドで並列に行い, 登録だけを排他する.
+    auto ptr    = entry.get();
+    auto handle = INVALID_PIPELINE_HANDLE;
+    {
+        std::lock_guard<std::mutex> locker(m_EntryMutex);
+        handle = PipelineHandle(m_Entries.size());
+        m_Entries.push_back(std::move(entry));
+    }
+
+    {
+        std::lock_guard<std::mutex> locker(m_Mutex);
+        ptr->SubmitTime = std::chrono::steady_clock::now();
+        m_Queue.push_back(ptr);
+        m_Stats.QueueDepth++;
+    }
+    m_Condition.notify_one();
+
+    return handle;
+}
+
+//-----------------------------------------------------------------------------
+//      完了したコンパイルを反映します.
+//-----------------------------------------------------------------------------
+void AsyncPipelineCompiler::Poll()
+{
+    std::vector<Entry*> finished;
+    {
+        std::lock_guard<std::mutex> locker(m_Mutex);
+        finished.swap(m_Finished);
+        m_Stats.QueueDepth -= uint32_t(finished.size());
+    }
+
+    for (auto entry : finished)
+    {
+        if (SUCCEEDED(entry->Result))
+        {
+            entry->pPSO   = entry->pCompiled;
+            entry->Status = PIPELINE_STATUS_READY;
+            m_Stats.Completed++;
+        }
+        else
+        {
+            entry->Status = PIPELINE_STATUS_FAILED;
+            m_Stats.Failed++;
+        }
+        entry->pCompiled.Reset();
+
+        m_TotalLatency += entry->LatencyMs;
+        m_Stats.LastLatencyMs    = entry->LatencyMs;
+        m_Stats.MaxLatencyMs     = std::max(m_Stats.MaxLatencyMs, entry->LatencyMs);
+        m_Stats.AverageLatencyMs = m_TotalLatency / double(m_Stats.Completed + m_Stats.Failed);
+    }
+}
+
+//-----------------------------------------------------------------------------
+//      描画に使用するパイプラインステートを取得します.
+//-----------------------------------------------------------------------------
+ID3D12PipelineState* AsyncPipelineCompiler::Get(PipelineHandle handle) const
+{
+    std::lock_guard<std::mutex> locker(m_EntryMutex);
+
+    // フォールバックを辿る(循環しないよう要求数で打ち切る).
+    for (size_t i = 0; i < m_Entries.size() && handle < m_Entries.size(); ++i)
+    {
+        auto& entry = m_Entries[handle];
+        if (entry->Status == PIPELINE_STATUS_READY)
+        { return entry->pPSO.Get(); }
+
+        handle = entry->Fallback;
+    }
+
+    return nullptr;
+}
+
+//-----------------------------------------------------------------------------
+//      状態を取得します.
+//-----------------------------------------------------------------------------
+PIPELINE_STATUS AsyncPipelineCompiler::GetStatus(PipelineHandle handle) const
+{
+    std::lock_guard<std::mutex> locker(m_EntryMutex);
+
+    if (handle >= m_Entries.size())
+    { return PIPELINE_STATUS_INVALID; }
+
+    return m_Entries[handle]->Status;
+}
+
+//-----------------------------------------------------------------------------
+//      統計を取得します.
+//-----------------------------------------------------------------------------
+const AsyncPipelineCompiler::Stats& AsyncPipelineCompiler::GetStats() const
+{ return m_Stats; }
+
+//-----------------------------------------------------------------------------
+//      ワーカースレッドの処理です.
+//-----------------------------------------------------------------------------
+void AsyncPipelineCompiler::WorkerThread()
+{
+    for (;;)
+    {
+        Entry* entry = nullptr;
+        {
+            std::unique_lock<std::mutex> locker(m_Mutex);
+            m_Condition.wait(locker, [this]() { return m_Stop || !m_Queue.empty(); });
+
+            if (m_Stop)
+            { return; }
+
+            entry = m_Queue.front();
+            m_Queue.pop_front();
+        }
+
+        entry->Result = m_pCache->CreateGraphicsPipelineState(
+            entry->Desc,
+            entry->RootSigHash,
+            entry->pCompiled.GetAddressOf());
+
+        auto end = std::chrono::steady_clock::now();
+
+        std::lock_guard<std::mutex> locker(m_Mutex);
+        entry->LatencyMs = std::chrono::duration<double, std::milli>(end - entry->SubmitTime).count();
+        m_Finished.push_back(entry);
+    }
+}
@@ -0,0 +1,362 @@
+﻿//-----------------------------------------------------------------------------
+// File : AutoExposure.cpp
+// Desc : Histogram Based Auto Exposure.
+// Copyright(c) Pocol. All right reserved.
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------
+#include "AutoExposure.h"
+#include "PipelineStateHash.h"
+#include "GpuHeapAllocator.h"
+#include "Logger.h"
+
+
+namespace {
+
+//-----------------------------------------------------------------------------
+// Constant Values.
+//-----------------------------------------------------------------------------
+constexpr uint32_t HistogramGroupSize = 16;     // ヒストグラム作成のスレッドグループのサイズ.
+
+// 露光バッファの読み込み時の状態(トーンマップとブルームの両方から読む).
+constexpr D3D12_RESOURCE_STATES ReadState = D3D12_RESOURCE_STATES(
+    D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE | D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+
+//-----------------------------------------------------------------------------
+//      遷移バリアを設定します.
+//-----------------------------------------------------------------------------
+D3D12_RESOURCE_BARRIER Transition(ID3D12Resource* pResource, D3D12_RESOURCE_STATES before, D3D12_RESOURCE_STATES after)
+{
+    D3D12_RESOURCE_BARRIER barrier = {};
+    barrier.Type                    = D3D12_RESOURCE_BARRIER_TYPE_TRANSITION;
+    barrier.Transition.pResource    = pResource;
+    barrier.Transition.Subresource  = D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES;
+    barrier.Transition.StateBefore  = before;
+    barrier.Transition.StateAfter   = after;
+    return barrier;
+}
+
+//-----------------------------------------------------------------------------
+//      UAVバリアを設定します.
+//-----------------------------------------------------------------------------
+D3D12_RESOURCE_BARRIER UAVBarrier(ID3D12Resource* pResource)
+{
+    D3D12_RESOURCE_BARRIER barrier = {};
+    barrier.Type            = D3D12_RESOURCE_BARRIER_TYPE_UAV;
+    barrier.UAV.pResource   = pResource;
+    return barrier;
+}
+
+} // namespace
+
+
+///////////////////////////////////////////////////////////////////////////////
+// AutoExposure class
+///////////////////////////////////////////////////////////////////////////////
+
+//-----------------------------------------------------------------------------
+//      コンストラクタです.
+//-----------------------------------------------------------------------------
+AutoExposure::AutoExposure()
+: m_MemoryId            (MemoryTracker::InvalidId)
+, m_pPool               (nullptr)
+, m_pHandleHistogramUAV (nullptr)
+, m_pHandleExposureUAV  (nullptr)
+, m_pHandleExposureSRV  (nullptr)
+, m_Reset               (true)
+{ /* DO_NOTHING */ }
+
+//-----------------------------------------------------------------------------
+//      デストラクタです.
+//-----------------------------------------------------------------------------
+AutoExposure::~AutoExposure()
+{ Term(); }
+
+//-----------------------------------------------------------------------------
+//      初期化処理を行います.
+//-----------------------------------------------------------------------------
+bool AutoExposure::Init
+(
+    ID3D12Device*                   pDevice,
+    DescriptorPool*                 pPoolRes,
+    PipelineCache*                  pCache,
+    const D3D12_SHADER_BYTECODE&    histogramCS,
+    const D3D12_SHADER_BYTECODE&    adaptCS
+)
+{
+    if (pDevice == nullptr || pPoolRes == nullptr || pCache == nullptr)
+    {
+        ELOG("Error : Invalid Argument.");
+        return false;
+    }
+
+    m_pPool = pPoolRes;
+
+    // コミットリソースはゼロ初期化されているので, ヒストグラムは最初から空になっている.
+    if (!CreateBuffer(
+        pDevice,
+        sizeof(uint32_t) * EXPOSURE_BIN_COUNT,
+        D3D12_RESOURCE_STATE_UNORDERED_ACCESS,
+        m_pHistogram.GetAddressOf()))
+    {
+        ELOG("Error : Histogram Buffer Create Failed.");
+        return false;
+    }
+
+    if (!CreateBuffer(
+        pDevice,
+        sizeof(ExposureState),
+        ReadState,
+        m_pExposure.GetAddressOf()))
+    {
+        ELOG("Error : Exposure Buffer Create Failed.");
+        return false;
+    }
+
+    m_MemoryId = GetMemoryTracker().Add(
+        MEMORY_CATEGORY_OTHER,
+        MEMORY_DOMAIN_GPU,
+        GetResourceSize(m_pHistogram.Get()) + GetResourceSize(m_pExposure.Get()),
+        "AutoExposure");
+
+    // ディスクリプタを生成.
+    {
+        m_pHandleHistogramUAV = m_pPool->AllocHandle();
+        m_pHandleExposureUAV  = m_pPool->AllocHandle();
+        m_pHandleExposureSRV  = m_pPool->AllocHandle();
+        if (m_pHandleHistogramUAV == nullptr
+         || m_pHandleExposureUAV  == nullptr
+         || m_pHandleExposureSRV  == nullptr)
+        {
+            ELOG("Error : DescriptorPool::AllocHandle() Failed.");
+            return false;
+        }
+
+        D3D12_UNORDERED_ACCESS_VIEW_DESC uavDesc = {};
+        uavDesc.Format                      = DXGI_FORMAT_UNKNOWN;
+        uavDesc.ViewDimension               = D3D12_UAV_DIMENSION_BUFFER;
+        uavDesc.Buffer.NumElements          = EXPOSURE_BIN_COUNT;
+        uavDesc.Buffer.StructureByteStride  = sizeof(uint32_t);
+        pDevice->CreateUnorderedAccessView(m_pHistogram.Get(), nullptr, &uavDesc, m_pHandleHistogramUAV->HandleCPU);
+
+        uavDesc.Buffer.NumElements          = 1;
+        uavDesc.Buffer.StructureByteStride  = sizeof(ExposureState);
+        pDevice->CreateUnorderedAccessView(m_pExposure.Get(), nullptr, &uavDesc, m_pHandleExposureUAV->HandleCPU);
+
+        D3D12_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
+        srvDesc.Format                      = DXGI_FORMAT_UNKNOWN;
+        srvDesc.ViewDimension               = D3D12_SRV_DIMENSION_BUFFER;
+        srvDesc.Shader4ComponentMapping     = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
+        srvDesc.Buffer.NumElements          = 1;
+        srvDesc.Buffer.StructureByteStride  = sizeof(ExposureState);
+        pDevice->CreateShaderResourceView(m_pExposure.Get(), &srvDesc, m_pHandleExposureSRV->HandleCPU);
+    }
+
+    // 定数バッファを生成.
+    for (auto i = 0u; i < FrameCount; ++i)
+    {
+        if (!m_CB[i].Init(pDevice, pPoolRes, sizeof(CbExposure)))
+        {
+            ELOG("Error : ConstantBuffer::Init() Failed.");
+            return false;
+        }
+    }
+
+    // ルートシグニチャを生成.
+    uint64_t rootSigHash = 0;
+    {
+        RootSignature::Desc desc;
+        desc.Begin(4)
+            .SetCBV(ShaderStage::ALL, 0, 0)
+            .SetSRV(ShaderStage::ALL, 1, 0)
+            .SetUAV(ShaderStage::ALL, 2, 0)
+            .SetUAV(ShaderStage::ALL, 3, 1)
+            .End();
+
+        if (!m_RootSig.Init(pDevice, desc.GetDesc()))
+        {
+            ELOG("Error : RootSignature::Init() Failed.");
+            return false;
+        }
+
+        rootSigHash = HashRootSignatureDesc(*desc.GetDesc());
+    }
+
+    // パイプラインステートを生成.
+    {
+        D3D12_COMPUTE_PIPELINE_STATE_DESC desc = {};
+        desc.pRootSignature = m_RootSig.GetPtr();
+        desc.CS             = histogramCS;
+
+        auto hr = pCache->CreateComputePipelineState(desc, rootSigHash, m_pHistogramPSO.GetAddressOf());
+        if (FAILED(hr))
+        {
+            ELOG("Error : CreateComputePipelineState() Failed. retcode = 0x%x", hr);
+            return false;
+        }
+
+        desc.CS = adaptCS;
+        hr = pCache->CreateComputePipelineState(desc, rootSigHash, m_pAdaptPSO.GetAddressOf());
+        if (FAILED(hr))
+        {
+            ELOG("Error : CreateComputePipelineState() Failed. retcode = 0x%x", hr);
+            return false;
+        }
+    }
+
+    m_Reset = true;
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+//      終了処理を行います.
+//-----------------------------------------------------------------------------
+void AutoExposure::Term()
+{
+    for (auto i = 0u; i < FrameCount; ++i)
+    { m_CB[i].Term(); }
+
+    if (m_pPool != nullptr)
+    {
+        if (m_pHandleHistogramUAV != nullptr)
+        { m_pPool->FreeHandle(m_pHandleHistogramUAV); }
+
+        if (m_pHandleExposureUAV != nullptr)
+        { m_pPool->FreeHandle(m_pHandleExposureUAV); }
+
+        if (m_pHandleExposureSRV != nullptr)
+        { m_pPool->FreeHandle(m_pHandleExposureSRV); }
+
+        m_pPool = nullptr;
+    }
+
+    m_pHandleHistogramUAV = nullptr;
+    m_pHandleExposureUAV  = nullptr;
+    m_pHandleExposureSRV  = nullptr;
+
+    m_pHistogramPSO.Reset();
+    m_pAdaptPSO.Reset();
+    m_RootSig.Term();
+    m_pHistogram.Reset();
+    m_pExposure.Reset();
+
+    GetMemoryTracker().Remove(m_MemoryId);
+    m_MemoryId = MemoryTracker::InvalidId;
+}
+
+//-----------------------------------------------------------------------------
+//      ヒストグラムの作成と露光値の順応を記録します.
+//-----------------------------------------------------------------------------
+void AutoExposure::Dispatch
+(
+    ID3D12GraphicsCommandList*  pCmd,
+    D3D12_GPU_DESCRIPTOR_HANDLE handleScene,
+    uint32_t                    width,
+    uint32_t                    height,
+    float                       deltaTime,
+    uint32_t                    frameIndex
+)
+{
+    if (m_pHistogramPSO == nullptr || m_pAdaptPSO == nullptr)
+    { return; }
+
+    // 浮動小数の計算はCPUで済ませ, シェーダには整数で渡す.
+    auto& cb = m_CB[frameIndex % FrameCount];
+    *cb.GetPtr<CbExposure>() = MakeExposureConstants(m_Settings, width, height, deltaTime, m_Reset);
+    m_Reset = false;
+
+    {
+        D3D12_RESOURCE_BARRIER barriers[] = {
+            Transition(m_pExposure.Get(), ReadState, D3D12_RESOURCE_STATE_UNORDERED_ACCESS),
+            UAVBarrier(m_pHistogram.Get()),     // 前フレームのクリアを待つ.
+        };
+        pCmd->ResourceBarrier(_countof(barriers), barriers);
+    }
+
+    pCmd->SetComputeRootSignature(m_RootSig.GetPtr());
+    pCmd->SetComputeRootDescriptorTable(0, cb.GetHandleGPU());
+    pCmd->SetComputeRootDescriptorTable(1, handleScene);
+    pCmd->SetComputeRootDescriptorTable(2, m_pHandleHistogramUAV->HandleGPU);
+    pCmd->SetComputeRootDescriptorTable(3, m_pHandleExposureUAV->HandleGPU);
+
+    // 輝度ヒストグラムを作成.
+    pCmd->SetPipelineState(m_pHistogramPSO.Get());
+    pCmd->Dispatch(
+        (width  + HistogramGroupSize - 1) / HistogramGroupSize,
+        (height + HistogramGroupSize - 1) / HistogramGroupSize,
+        1);
+
+    {
+        auto barrier = UAVBarrier(m_pHistogram.Get());
+        pCmd->ResourceBarrier(1, &barrier);
+    }
+
+    // 露光値を求めて順応させる(ヒストグラムはここでクリアされる).
+    pCmd->SetPipelineState(m_pAdaptPSO.Get());
+    pCmd->Dispatch(1, 1, 1);
+
+    {
+        auto barrier = Transition(m_pExposure.Get(), D3D12_RESOURCE_STATE_UNORDERED_ACCESS, ReadState);
+        pCmd->ResourceBarrier(1, &barrier);
+    }
+}
+
+//-----------------------------------------------------------------------------
+//      次のフレームで順応せずに目標値へ合わせます.
+//-----------------------------------------------------------------------------
+void AutoExposure::Reset()
+{ m_Reset = true; }
+
+//-----------------------------------------------------------------------------
+//      設定を取得します.
+//-----------------------------------------------------------------------------
+ExposureSettings& AutoExposure::GetSettings()
+{ return m_Settings; }
+
+//-----------------------------------------------------------------------------
+//      露光バッファのSRVを取得します.
+//-----------------------------------------------------------------------------
+D3D12_GPU_DESCRIPTOR_HANDLE AutoExposure::GetHandleSRV() const
+{ return m_pHandleExposureSRV->HandleGPU; }
+
+//-----------------------------------------------------------------------------
+//      UAV用のバッファを生成します.
+//-----------------------------------------------------------------------------
+bool AutoExposure::CreateBuffer
+(
+    ID3D12Device*           pDevice,
+    uint64_t                size,
+    D3D12_RESOURCE_STATES   state,
+    ID3D12Resource**        ppResource
+)
+{
+    D3D12_HEAP_PROPERTIES prop = {};
+    prop.Type                 = D3D12_HEAP_TYPE_DEFAULT;
+    prop.CPUPageProperty      = D3D12_CPU_PAGE_PROPERTY_UNKNOWN;
+    prop.MemoryPoolPreference = D3D12_MEMORY_POOL_UNKNOWN;
+    prop.CreationNodeMask     = 1;
+    prop.VisibleNodeMask      = 1;
+
+    D3D12_RESOURCE_DESC desc = {};
+    desc.Dimension          = D3D12_RESOURCE_DIMENSION_BUFFER;
+    desc.Width              = size;
+    desc.Height             = 1;
+    desc.DepthOrArraySize   = 1;
+    desc.MipLevels          = 1;
+    desc.Format             = DXGI_FORMAT_UNKNOWN;
+    desc.SampleDesc.Count   = 1;
+    desc.Layout             = D3D12_TEXTURE_LAYOUT_ROW_MAJOR;
+    desc.Flags              = D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS;
+
+    auto hr = pDevice->CreateCommittedResource(
+        &prop,
+        D3D12_HEAP_FLAG_NONE,
+        &desc,
+        state,
+        nullptr,
+        IID_PPV_ARGS(ppResource));
+
+    return SUCCEEDED(hr);
+}
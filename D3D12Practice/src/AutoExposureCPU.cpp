@@ -0,0 +1,211 @@
+﻿//-----------------------------------------------------------------------------
+// File : AutoExposureCPU.cpp
+// Desc : Histogram Based Auto Exposure (CPU Reference).
+// Copyright(c) Pocol. All right reserved.
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------
+#include "AutoExposureCPU.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+
+namespace {
+
+//-----------------------------------------------------------------------------
+// Constant Values.
+//-----------------------------------------------------------------------------
+constexpr float     LuminanceR  = 0.2126f;  // ITU-R BT.709 の輝度係数.
+constexpr float     LuminanceG  = 0.7152f;
+constexpr float     LuminanceB  = 0.0722f;
+constexpr float     MaxEVRange  = 32.0f;    // 露光値の上限と下限の絶対値の最大値.
+
+//-----------------------------------------------------------------------------
+//      露光値を固定小数に変換します.
+//-----------------------------------------------------------------------------
+inline int32_t ToFixedEV(float value)
+{
+    value = std::min(std::max(value, -MaxEVRange), MaxEVRange);
+    return int32_t(std::lround(value * EXPOSURE_EV_ONE));
+}
+
+//-----------------------------------------------------------------------------
+//      順応速度から1フレームあたりの順応率(固定小数)を求めます.
+//-----------------------------------------------------------------------------
+inline int32_t ToFixedRate(float speed, float deltaTime)
+{
+    auto rate = 1.0f - std::exp(-std::max(speed, 0.0f) * std::max(deltaTime, 0.0f));
+    return std::min(std::max(int32_t(std::lround(rate * EXPOSURE_RATE_ONE)), 0), EXPOSURE_RATE_ONE);
+}
+
+//-----------------------------------------------------------------------------
+//      浮動小数のビット列を取得します.
+//-----------------------------------------------------------------------------
+inline uint32_t AsUint(float value)
+{
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+//-----------------------------------------------------------------------------
+//      ビット列を浮動小数として解釈します.
+//-----------------------------------------------------------------------------
+inline float AsFloat(uint32_t bits)
+{
+    float value;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+} // namespace
+
+
+//-----------------------------------------------------------------------------
+//      シェーダに渡す定数を求めます.
+//-----------------------------------------------------------------------------
+CbExposure MakeExposureConstants
+(
+    const ExposureSettings& settings,
+    uint32_t                width,
+    uint32_t                height,
+    float                   deltaTime,
+    bool                    reset
+)
+{
+    // 16段がすべて正規化数で表せる範囲に制限.
+    auto minLog = std::min(std::max(settings.MinLogLuminance, -126), 127 - 16);
+
+    auto pixelCount = std::min(uint64_t(width) * height, uint64_t(EXPOSURE_MAX_PIXELS));
+    auto lowPercent  = std::min(std::max(settings.LowPercent,  0.0f), 1.0f);
+    auto highPercent = std::min(std::max(settings.HighPercent, 0.0f), 1.0f);
+
+    CbExposure result = {};
+    result.Width            = width;
+    result.Height           = height;
+    result.MinLuminanceBits = uint32_t(minLog + 127) << 23;
+    result.LowCount         = uint32_t(double(pixelCount) * lowPercent);
+    result.HighCount        = uint32_t(double(pixelCount) * highPercent);
+    result.MinLogLuminance  = minLog * EXPOSURE_EV_ONE;
+    result.MinEV            = ToFixedEV(settings.MinEV);
+    result.MaxEV            = ToFixedEV(std::max(settings.MinEV, settings.MaxEV));
+    result.RateToDark       = ToFixedRate(settings.SpeedToDark,  deltaTime);
+    result.RateToLight      = ToFixedRate(settings.SpeedToLight, deltaTime);
+    result.Flags            = 0;
+
+    if (settings.Enable)
+    {
+        result.KeyLogValue = ToFixedEV(std::log2(std::max(settings.KeyValue, 1e-6f)) + settings.Compensation);
+        result.Flags |= EXPOSURE_FLAG_ENABLE;
+    }
+    else
+    {
+        // 無効時は補正値がそのまま露光値になる.
+        result.KeyLogValue = ToFixedEV(settings.Compensation);
+    }
+
+    if (reset)
+    { result.Flags |= EXPOSURE_FLAG_RESET; }
+
+    return result;
+}
+
+//-----------------------------------------------------------------------------
+//      ピクセルのヒストグラムのビン番号を求めます.
+//-----------------------------------------------------------------------------
+uint32_t GetExposureBin(const CbExposure& constants, const float rgb[3])
+{
+    // シェーダ側は precise で積和の融合を禁止している. 加算順序も合わせること.
+    float r = rgb[0] * LuminanceR;
+    float g = rgb[1] * LuminanceG;
+    float b = rgb[2] * LuminanceB;
+    float L = (r + g) + b;
+
+    // 最小輝度以下(と NaN)は先頭のビン.
+    if (!(L > AsFloat(constants.MinLuminanceBits)))
+    { return 0; }
+
+    // 正の浮動小数のビット列は log2 の区分線形近似になっている.
+    auto bin = (AsUint(L) - constants.MinLuminanceBits) >> EXPOSURE_BIN_SHIFT;
+    return std::min(bin, EXPOSURE_BIN_COUNT - 1);
+}
+
+//-----------------------------------------------------------------------------
+//      輝度ヒストグラムを作成します.
+//-----------------------------------------------------------------------------
+void BuildExposureHistogram
+(
+    const CbExposure&   constants,
+    const float*        pPixels,
+    uint32_t            histogram[EXPOSURE_BIN_COUNT]
+)
+{
+    memset(histogram, 0, sizeof(uint32_t) * EXPOSURE_BIN_COUNT);
+
+    auto count = size_t(constants.Width) * constants.Height;
+    for (size_t i = 0; i < count; ++i)
+    { histogram[GetExposureBin(constants, pPixels + i * 4)]++; }
+}
+
+//-----------------------------------------------------------------------------
+//      ヒストグラムから露光値を求め, 時間方向に順応させます.
+//-----------------------------------------------------------------------------
+void AdaptExposure
+(
+    const CbExposure&   constants,
+    const uint32_t      histogram[EXPOSURE_BIN_COUNT],
+    ExposureState&      state
+)
+{
+    auto target = state.TargetEV;
+
+    if (constants.Flags & EXPOSURE_FLAG_ENABLE)
+    {
+        // 暗い側と明るい側を除いた区間の平均ビンを整数で求める.
+        uint32_t accum = 0;
+        uint32_t count = 0;
+        uint32_t sum   = 0;
+        for (auto i = 0u; i < EXPOSURE_BIN_COUNT; ++i)
+        {
+            auto lo = std::max(accum, constants.LowCount);
+            auto hi = std::min(accum + histogram[i], constants.HighCount);
+            if (hi > lo)
+            {
+                count += hi - lo;
+                sum   += (hi - lo) * i;
+            }
+            accum += histogram[i];
+        }
+
+        if (count > 0)
+        {
+            // 1ビン = 1/16段 = 256 / EXPOSURE_EV_ONE 段. ビンの中心を取るため半ビン足す.
+            const uint32_t scale = EXPOSURE_EV_ONE / EXPOSURE_BINS_PER_OCTAVE;
+            auto averageBin = int32_t((sum / count) * scale + ((sum % count) * scale) / count + scale / 2);
+
+            state.AverageLogLuminance = constants.MinLogLuminance + averageBin;
+            target = constants.KeyLogValue - state.AverageLogLuminance;
+        }
+    }
+    else
+    {
+        target = constants.KeyLogValue;
+    }
+
+    target = std::min(std::max(target, constants.MinEV), constants.MaxEV);
+    state.TargetEV = target;
+
+    if (constants.Flags & EXPOSURE_FLAG_RESET)
+    { state.EV = target; }
+    else
+    {
+        auto diff = target - state.EV;
+        auto rate = (diff > 0) ? constants.RateToDark : constants.RateToLight;
+        state.EV += (diff * rate) >> EXPOSURE_RATE_SHIFT;
+    }
+
+    state.Exposure = std::exp2(float(state.EV) / float(EXPOSURE_EV_ONE));
+}
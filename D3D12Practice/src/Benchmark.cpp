@@ -0,0 +1,441 @@
+﻿//-----------------------------------------------------------------------------
+// File : Benchmark.cpp
+// Desc : Deterministic Benchmark Runner.
+// Copyright(c) Pocol. All right reserved.
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------
+#include "Benchmark.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cwchar>
+#include <fstream>
+
+
+namespace {
+
+//-----------------------------------------------------------------------------
+// Constant Values.
+//-----------------------------------------------------------------------------
+constexpr float     Pi              = 3.14159265358979f;    // 円周率.
+constexpr float     CameraTilt      = 0.25f;                // 垂直方向に揺らす角度[rad].
+constexpr float     CameraDolly     = 0.5f;                 // ドリーで前後させる量.
+constexpr uint32_t  MaxFrames       = 1u << 20;             // 計測前後それぞれの最大フレーム数.
+constexpr uint32_t  MaxResolution   = 16384;                // 描画する縦横の最大サイズ.
+
+static const char Usage[] =
+    "Usage : D3D12Practice [-benchmark] [-width N] [-height N] [-warmup N] [-frames N]\n"
+    "                      [-grid N] [-label NAME] [-out PATH]\n"
+    "    -benchmark     run the benchmark, write the results to -out and close.\n"
+    "    -width/-height render resolution (default 1920x1080).\n"
+    "    -warmup        frames to discard before measuring (default 120).\n"
+    "    -frames        frames to measure (default 600).\n"
+    "    -grid          N x N material balls (1 - 16, default 4).\n"
+    "    -label         free text written to the results (e.g. build name).\n"
+    "    -out           results file (default benchmark.json).\n";
+
+//-----------------------------------------------------------------------------
+//      ワイド文字列を変換します(ASCII の範囲を想定).
+//-----------------------------------------------------------------------------
+std::string ToNarrow(const wchar_t* value)
+{
+    std::string result;
+    for (auto p = value; *p != L'\0'; ++p)
+    { result += (*p < 0x80) ? char(*p) : '?'; }
+    return result;
+}
+
+//-----------------------------------------------------------------------------
+//      範囲内の整数として読み取ります.
+//-----------------------------------------------------------------------------
+bool ParseUint(const wchar_t* value, uint32_t minValue, uint32_t maxValue, uint32_t& result)
+{
+    wchar_t* pEnd = nullptr;
+    auto parsed = wcstoul(value, &pEnd, 10);
+    if (pEnd == value || *pEnd != L'\0' || parsed < minValue || parsed > maxValue)
+    { return false; }
+
+    result = uint32_t(parsed);
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+//      JSON の文字列として出力します.
+//-----------------------------------------------------------------------------
+void AppendJsonString(std::string& result, const std::string& value)
+{
+    result += '"';
+    for (auto c : value)
+    {
+        switch (c)
+        {
+        case '"':  result += "\\\""; break;
+        case '\\': result += "\\\\"; break;
+        default:
+            if (uint8_t(c) < 0x20)
+            { result += ' '; }
+            else
+            { result += c; }
+            break;
+        }
+    }
+    result += '"';
+}
+
+//-----------------------------------------------------------------------------
+//      フレーム時間[ms]をフレームレートにします.
+//-----------------------------------------------------------------------------
+double ToFps(double ms)
+{ return (ms > 0.0) ? 1000.0 / ms : 0.0; }
+
+//-----------------------------------------------------------------------------
+//      カメラの軌道上の位置を求めます.
+//-----------------------------------------------------------------------------
+void GetCameraPose(uint32_t frame, float& tilt, float& dolly)
+{
+    auto phase = 2.0f * Pi * float(frame % Benchmark::CameraPathFrames) / float(Benchmark::CameraPathFrames);
+    tilt  = CameraTilt  * sinf(phase);
+    dolly = CameraDolly * sinf(2.0f * phase);
+}
+
+} // namespace
+
+
+//-----------------------------------------------------------------------------
+//      コマンドライン引数からベンチマークの設定を読み取ります.
+//-----------------------------------------------------------------------------
+bool ParseBenchmarkArgs(int argc, wchar_t** argv, BenchmarkSettings& settings)
+{
+    for (auto i = 1; i < argc; ++i)
+    {
+        auto arg   = argv[i];
+        auto value = (i + 1 < argc) ? argv[i + 1] : nullptr;
+
+        if (wcscmp(arg, L"-benchmark") == 0)
+        {
+            settings.Enable = true;
+            continue;
+        }
+
+        // 以降は値を取る引数.
+        if (value == nullptr)
+        { return false; }
+
+        auto result = true;
+        if      (wcscmp(arg, L"-width")  == 0) { result = ParseUint(value, 1, MaxResolution, settings.Width); }
+        else if (wcscmp(arg, L"-height") == 0) { result = ParseUint(value, 1, MaxResolution, settings.Height); }
+        else if (wcscmp(arg, L"-warmup") == 0) { result = ParseUint(value, 0, MaxFrames, settings.WarmupFrames); }
+        else if (wcscmp(arg, L"-frames") == 0) { result = ParseUint(value, 1, MaxFrames, settings.MeasureFrames); }
+        else if (wcscmp(arg, L"-grid")   == 0) { result = ParseUint(value, 1, Benchmark::MaxGridSize, settings.GridSize); }
+        else if (wcscmp(arg, L"-label")  == 0) { settings.Label      = ToNarrow(value); }
+        else if (wcscmp(arg, L"-out")    == 0) { settings.OutputPath = ToNarrow(value); }
+        else
+        { return false; }
+
+        if (!result)
+        { return false; }
+
+        ++i;
+    }
+
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+//      コマンドライン引数の説明を取得します.
+//-----------------------------------------------------------------------------
+const char* GetBenchmarkUsage()
+{ return Usage; }
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Benchmark class
+///////////////////////////////////////////////////////////////////////////////
+
+//-----------------------------------------------------------------------------
+//      コンストラクタです.
+//-----------------------------------------------------------------------------
+Benchmark::Benchmark()
+: m_State(BENCHMARK_STATE_IDLE)
+, m_Frame(0)
+{ /* DO_NOTHING */ }
+
+//-----------------------------------------------------------------------------
+//      デストラクタです.
+//-----------------------------------------------------------------------------
+Benchmark::~Benchmark()
+{ /* DO_NOTHING */ }
+
+//-----------------------------------------------------------------------------
+//      ベンチマークを開始します.
+//-----------------------------------------------------------------------------
+void Benchmark::Start(const BenchmarkSettings& settings)
+{
+    m_Settings = settings;
+    m_Frame    = 0;
+    m_State    = (settings.WarmupFrames > 0) ? BENCHMARK_STATE_WARMUP : BENCHMARK_STATE_MEASURE;
+
+    // 計測中にメモリ確保が起きないよう先に確保しておく.
+    m_CpuMs.clear();
+    m_GpuMs.clear();
+    m_Metrics.clear();
+    m_CpuMs.reserve(settings.MeasureFrames);
+    m_GpuMs.reserve(settings.MeasureFrames);
+}
+
+//-----------------------------------------------------------------------------
+//      状態を取得します.
+//-----------------------------------------------------------------------------
+BENCHMARK_STATE Benchmark::GetState() const
+{ return m_State; }
+
+//-----------------------------------------------------------------------------
+//      計測前か計測中かどうかチェックします.
+//-----------------------------------------------------------------------------
+bool Benchmark::IsRunning() const
+{ return m_State == BENCHMARK_STATE_WARMUP || m_State == BENCHMARK_STATE_MEASURE; }
+
+//-----------------------------------------------------------------------------
+//      現在のフレームのカメラの変化量を取得します.
+//-----------------------------------------------------------------------------
+BenchmarkCameraStep Benchmark::GetCameraStep() const
+{
+    BenchmarkCameraStep step = {};
+    if (!IsRunning())
+    { return step; }
+
+    // 軌道上の位置の差分にすることで, 累積しても軌道から外れないようにする.
+    float tilt0, dolly0, tilt1, dolly1;
+    GetCameraPose(m_Frame,     tilt0, dolly0);
+    GetCameraPose(m_Frame + 1, tilt1, dolly1);
+
+    step.RotateH = 2.0f * Pi / float(CameraPathFrames);
+    step.RotateV = tilt1  - tilt0;
+    step.Dolly   = dolly1 - dolly0;
+    return step;
+}
+
+//-----------------------------------------------------------------------------
+//      1フレーム分の時間を記録し, 次のフレームに進めます.
+//-----------------------------------------------------------------------------
+void Benchmark::AddFrame(float cpuMs, float gpuMs)
+{
+    if (!IsRunning())
+    { return; }
+
+    if (m_State == BENCHMARK_STATE_MEASURE)
+    {
+        m_CpuMs.push_back(cpuMs);
+        if (gpuMs >= 0.0f)
+        { m_GpuMs.push_back(gpuMs); }
+    }
+
+    m_Frame++;
+
+    if (m_State == BENCHMARK_STATE_WARMUP && m_Frame >= m_Settings.WarmupFrames)
+    { m_State = BENCHMARK_STATE_MEASURE; }
+    else if (m_State == BENCHMARK_STATE_MEASURE && m_CpuMs.size() >= m_Settings.MeasureFrames)
+    { m_State = BENCHMARK_STATE_FINISHED; }
+}
+
+//-----------------------------------------------------------------------------
+//      結果に記録する値を設定します.
+//-----------------------------------------------------------------------------
+void Benchmark::SetMetric(const char* name, double value)
+{
+    if (name == nullptr)
+    { return; }
+
+    for (auto& metric : m_Metrics)
+    {
+        if (metric.Name == name)
+        {
+            metric.Value = value;
+            return;
+        }
+    }
+
+    m_Metrics.push_back({ name, value });
+}
+
+//-----------------------------------------------------------------------------
+//      設定を取得します.
+//-----------------------------------------------------------------------------
+const BenchmarkSettings& Benchmark::GetSettings() const
+{ return m_Settings; }
+
+//-----------------------------------------------------------------------------
+//      計測結果を JSON 形式の文字列にします.
+//-----------------------------------------------------------------------------
+std::string Benchmark::ExportJson() const
+{
+    auto cpu = Summarize(m_CpuMs);
+    auto gpu = Summarize(m_GpuMs);
+
+    std::string result;
+    char buffer[512];
+
+    result += "{\n";
+    result += "    \"version\": 1,\n";
+    result += "    \"label\": ";
+    AppendJsonString(result, m_Settings.Label);
+    result += ",\n";
+#if defined(VOE_DIST)
+    result += "    \"configuration\": \"Dist\",\n";
+#elif defined(VOE_DEBUG) || defined(DEBUG) || defined(_DEBUG)
+    result += "    \"configuration\": \"Debug\",\n";
+#else
+    result += "    \"configuration\": \"Release\",\n";
+#endif
+    result += "    \"completed\": ";
+    result += (m_State == BENCHMARK_STATE_FINISHED) ? "true,\n" : "false,\n";
+
+    snprintf(buffer, sizeof(buffer),
+        "    \"settings\": { \"width\": %u, \"height\": %u, \"warmup_frames\": %u, \"measure_frames\": %u, "
+        "\"grid_size\": %u, \"instance_count\": %u, \"camera_path_frames\": %u },\n",
+        m_Settings.Width,
+        m_Settings.Height,
+        m_Settings.WarmupFrames,
+        m_Settings.MeasureFrames,
+        m_Settings.GridSize,
+        m_Settings.GridSize * m_Settings.GridSize,
+        CameraPathFrames);
+    result += buffer;
+
+    const struct { const char* Name; const Summary* pSummary; } sections[] = {
+        { "cpu_frame_ms", &cpu },
+        { "gpu_frame_ms", &gpu },
+    };
+
+    for (auto& section : sections)
+    {
+        auto& s = *section.pSummary;
+        snprintf(buffer, sizeof(buffer),
+            "    \"%s\": { \"count\": %u, \"min\": %.4f, \"mean\": %.4f, \"max\": %.4f, "
+            "\"p50\": %.4f, \"p95\": %.4f, \"p99\": %.4f, \"low1\": %.4f },\n",
+            section.Name,
+            s.Count,
+            s.MinMs,
+            s.MeanMs,
+            s.MaxMs,
+            s.P50Ms,
+            s.P95Ms,
+            s.P99Ms,
+            s.Low1Ms);
+        result += buffer;
+    }
+
+    snprintf(buffer, sizeof(buffer),
+        "    \"fps\": { \"mean\": %.3f, \"low1\": %.3f },\n",
+        ToFps(cpu.MeanMs),
+        ToFps(cpu.Low1Ms));
+    result += buffer;
+
+    result += "    \"metrics\": {";
+    for (size_t i = 0; i < m_Metrics.size(); ++i)
+    {
+        result += (i == 0) ? " " : ", ";
+        AppendJsonString(result, m_Metrics[i].Name);
+        snprintf(buffer, sizeof(buffer), ": %.17g", m_Metrics[i].Value);
+        result += buffer;
+    }
+    result += m_Metrics.empty() ? "}\n" : " }\n";
+
+    result += "}\n";
+    return result;
+}
+
+//-----------------------------------------------------------------------------
+//      計測結果を JSON 形式でファイルに書き出します.
+//-----------------------------------------------------------------------------
+bool Benchmark::WriteJson(const char* path) const
+{
+    if (path == nullptr)
+    { return false; }
+
+    auto json = ExportJson();
+
+    std::ofstream stream(path, std::ios::binary | std::ios::trunc);
+    if (!stream.is_open())
+    { return false; }
+
+    stream.write(json.data(), std::streamsize(json.size()));
+    return stream.good();
+}
+
+//-----------------------------------------------------------------------------
+//      計測結果の要約を文字列にします.
+//-----------------------------------------------------------------------------
+std::string Benchmark::FormatReport() const
+{
+    auto cpu = Summarize(m_CpuMs);
+    auto gpu = Summarize(m_GpuMs);
+
+    char buffer[512];
+    snprintf(buffer, sizeof(buffer),
+        "Benchmark : %ux%u, %u x %u balls, %u frames\n"
+        "    CPU frame  mean %8.3f ms  p95 %8.3f ms  p99 %8.3f ms  (%.1f fps, 1%% low %.1f fps)\n"
+        "    GPU frame  mean %8.3f ms  p95 %8.3f ms  p99 %8.3f ms\n",
+        m_Settings.Width,
+        m_Settings.Height,
+        m_Settings.GridSize,
+        m_Settings.GridSize,
+        cpu.Count,
+        cpu.MeanMs,
+        cpu.P95Ms,
+        cpu.P99Ms,
+        ToFps(cpu.MeanMs),
+        ToFps(cpu.Low1Ms),
+        gpu.MeanMs,
+        gpu.P95Ms,
+        gpu.P99Ms);
+
+    return buffer;
+}
+
+//-----------------------------------------------------------------------------
+//      計測値を集計します.
+//-----------------------------------------------------------------------------
+Benchmark::Summary Benchmark::Summarize(const std::vector<float>& values)
+{
+    Summary result = {};
+    if (values.empty())
+    { return result; }
+
+    auto sorted = values;
+    std::sort(sorted.begin(), sorted.end());
+
+    auto count = uint32_t(sorted.size());
+    auto percentile = [&](uint32_t percent)
+    {
+        // 最近傍順位法.
+        auto rank = (uint64_t(count) * percent + 99) / 100;
+        auto index = (rank > 0) ? uint32_t(rank - 1) : 0u;
+        return double(sorted[(index < count) ? index : count - 1]);
+    };
+
+    double sum = 0.0;
+    for (auto value : sorted)
+    { sum += value; }
+
+    // 遅い方から1%(最低1フレーム)の平均.
+    auto lowCount = (count + 99) / 100;
+    double lowSum = 0.0;
+    for (auto i = count - lowCount; i < count; ++i)
+    { lowSum += sorted[i]; }
+
+    result.Count  = count;
+    result.MinMs  = sorted.front();
+    result.MaxMs  = sorted.back();
+    result.MeanMs = sum / count;
+    result.P50Ms  = percentile(50);
+    result.P95Ms  = percentile(95);
+    result.P99Ms  = percentile(99);
+    result.Low1Ms = lowSum / lowCount;
+
+    return result;
+}
@@ -0,0 +1,509 @@
+﻿//-----------------------------------------------------------------------------
+// File : Bloom.cpp
+// Desc : Progressive Downsample / Upsample Bloom.
+// Copyright(c) Pocol. All right reserved.
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------
+#include "Bloom.h"
+#include "PipelineStateHash.h"
+#include "GpuHeapAllocator.h"
+#include "Logger.h"
+
+
+namespace {
+
+//-----------------------------------------------------------------------------
+// Constant Values.
+//-----------------------------------------------------------------------------
+constexpr DXGI_FORMAT   BloomFormat             = DXGI_FORMAT_R11G11B10_FLOAT;  // ミップチェーンのフォーマット.
+constexpr uint32_t      GroupSize               = 8;                            // スレッドグループのサイズ.
+constexpr uint32_t      BLOOM_FLAG_PREFILTER    = 0x1;                          // 露光を掛けてしきい値を適用する.
+constexpr uint32_t      BLOOM_FLAG_HQ           = 0x2;                          // 13タップの縮小と 3x3 テントの拡大.
+constexpr uint32_t      BLOOM_FLAG_KARIS        = 0x4;                          // Karis 平均でちらつきを抑える.
+
+// 読み込み時の状態(トーンマップのピクセルシェーダとコンピュートシェーダの両方から読む).
+constexpr D3D12_RESOURCE_STATES ReadState = D3D12_RESOURCE_STATES(
+    D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE | D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+
+///////////////////////////////////////////////////////////////////////////////
+// Preset structure
+///////////////////////////////////////////////////////////////////////////////
+struct Preset
+{
+    uint32_t    MipCount;   // 段数.
+    uint32_t    Flags;      // BLOOM_FLAG の組み合わせ.
+};
+
+// BLOOM_QUALITY ごとの設定.
+constexpr Preset Presets[BLOOM_QUALITY_COUNT] = {
+    { 4, 0 },
+    { 5, BLOOM_FLAG_HQ },
+    { 6, BLOOM_FLAG_HQ | BLOOM_FLAG_KARIS },
+};
+
+// タイマーのスコープ名.
+constexpr const char* DownPassNames[Bloom::MaxMipCount] = {
+    "Bloom Down 1/2", "Bloom Down 1/4", "Bloom Down 1/8", "Bloom Down 1/16", "Bloom Down 1/32", "Bloom Down 1/64",
+};
+constexpr const char* UpPassNames[Bloom::MaxMipCount] = {
+    "Bloom Up 1/2", "Bloom Up 1/4", "Bloom Up 1/8", "Bloom Up 1/16", "Bloom Up 1/32", "Bloom Up 1/64",
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// CbBloom structure
+///////////////////////////////////////////////////////////////////////////////
+struct alignas(256) CbBloom
+{
+    uint32_t    DstWidth;       // 出力の横幅.
+    uint32_t    DstHeight;      // 出力の縦幅.
+    float       InvDstWidth;    // 出力の横幅の逆数.
+    float       InvDstHeight;   // 出力の縦幅の逆数.
+    float       InvSrcWidth;    // 入力の横幅の逆数.
+    float       InvSrcHeight;   // 入力の縦幅の逆数.
+    float       Threshold;      // しきい値.
+    float       Knee;           // しきい値付近をなめらかにする幅.
+    float       Scatter;        // 拡大時に下の段を混ぜる割合.
+    uint32_t    Flags;          // BLOOM_FLAG の組み合わせ.
+    float       SrcUVScaleX;    // 入力の有効な領域の横方向の割合.
+    float       SrcUVScaleY;    // 入力の有効な領域の縦方向の割合.
+};
+
+//-----------------------------------------------------------------------------
+//      遷移バリアを設定します.
+//-----------------------------------------------------------------------------
+D3D12_RESOURCE_BARRIER Transition
+(
+    ID3D12Resource*         pResource,
+    uint32_t                subresource,
+    D3D12_RESOURCE_STATES   before,
+    D3D12_RESOURCE_STATES   after
+)
+{
+    D3D12_RESOURCE_BARRIER barrier = {};
+    barrier.Type                    = D3D12_RESOURCE_BARRIER_TYPE_TRANSITION;
+    barrier.Transition.pResource    = pResource;
+    barrier.Transition.Subresource  = subresource;
+    barrier.Transition.StateBefore  = before;
+    barrier.Transition.StateAfter   = after;
+    return barrier;
+}
+
+//-----------------------------------------------------------------------------
+//      ミップの大きさを求めます.
+//-----------------------------------------------------------------------------
+inline uint32_t MipSize(uint32_t size, uint32_t mip)
+{
+    size >>= mip;
+    return (size > 0) ? size : 1;
+}
+
+} // namespace
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Bloom class
+///////////////////////////////////////////////////////////////////////////////
+
+//-----------------------------------------------------------------------------
+//      コンストラクタです.
+//-----------------------------------------------------------------------------
+Bloom::Bloom()
+: m_pPool   (nullptr)
+, m_Width   (0)
+, m_Height  (0)
+, m_MipCount(0)
+, m_MemoryId(MemoryTracker::InvalidId)
+{
+    for (auto i = 0u; i < MaxMipCount; ++i)
+    {
+        m_pHandleDownSRV[i] = nullptr;
+        m_pHandleDownUAV[i] = nullptr;
+        m_pHandleUpSRV  [i] = nullptr;
+        m_pHandleUpUAV  [i] = nullptr;
+    }
+}
+
+//-----------------------------------------------------------------------------
+//      デストラクタです.
+//-----------------------------------------------------------------------------
+Bloom::~Bloom()
+{ Term(); }
+
+//-----------------------------------------------------------------------------
+//      初期化処理を行います.
+//-----------------------------------------------------------------------------
+bool Bloom::Init
+(
+    ID3D12Device*                   pDevice,
+    DescriptorPool*                 pPoolRes,
+    PipelineCache*                  pCache,
+    const D3D12_SHADER_BYTECODE&    downsampleCS,
+    const D3D12_SHADER_BYTECODE&    upsampleCS,
+    uint32_t                        width,
+    uint32_t                        height
+)
+{
+    if (pDevice == nullptr || pPoolRes == nullptr || pCache == nullptr || width < 4 || height < 4)
+    {
+        ELOG("Error : Invalid Argument.");
+        return false;
+    }
+
+    m_pPool  = pPoolRes;
+    m_Width  = width;
+    m_Height = height;
+
+    // 半解像度から 1x1 まで取れる段数に制限する.
+    {
+        auto size = MipSize(width < height ? width : height, 1);
+        m_MipCount = 1;
+        while ((size >> m_MipCount) > 0 && m_MipCount < MaxMipCount)
+        { m_MipCount++; }
+    }
+
+    if (!CreateChain(pDevice, m_pDown.GetAddressOf(), m_pHandleDownSRV, m_pHandleDownUAV))
+    {
+        ELOG("Error : Downsample Chain Create Failed.");
+        return false;
+    }
+
+    if (!CreateChain(pDevice, m_pUp.GetAddressOf(), m_pHandleUpSRV, m_pHandleUpUAV))
+    {
+        ELOG("Error : Upsample Chain Create Failed.");
+        return false;
+    }
+
+    m_MemoryId = GetMemoryTracker().Add(
+        MEMORY_CATEGORY_RENDER_TARGET,
+        MEMORY_DOMAIN_GPU,
+        GetResourceSize(m_pDown.Get()) + GetResourceSize(m_pUp.Get()),
+        "Bloom");
+
+    // 定数バッファを生成.
+    for (auto i = 0u; i < FrameCount; ++i)
+    {
+        for (auto j = 0u; j < MaxPassCount; ++j)
+        {
+            if (!m_CB[i][j].Init(pDevice, pPoolRes, sizeof(CbBloom)))
+            {
+                ELOG("Error : ConstantBuffer::Init() Failed.");
+                return false;
+            }
+        }
+    }
+
+    // ルートシグニチャを生成.
+    uint64_t rootSigHash = 0;
+    {
+        RootSignature::Desc desc;
+        desc.Begin(5)
+            .SetCBV(ShaderStage::ALL, 0, 0)
+            .SetSRV(ShaderStage::ALL, 1, 0)
+            .SetSRV(ShaderStage::ALL, 2, 1)
+            .SetSRV(ShaderStage::ALL, 3, 2)
+            .SetUAV(ShaderStage::ALL, 4, 0)
+            .AddStaticSmp(ShaderStage::ALL, 0, SamplerState::LinearWrap)
+            .End();
+
+        if (!m_RootSig.Init(pDevice, desc.GetDesc()))
+        {
+            ELOG("Error : RootSignature::Init() Failed.");
+            return false;
+        }
+
+        rootSigHash = HashRootSignatureDesc(*desc.GetDesc());
+    }
+
+    // パイプラインステートを生成.
+    {
+        D3D12_COMPUTE_PIPELINE_STATE_DESC desc = {};
+        desc.pRootSignature = m_RootSig.GetPtr();
+        desc.CS             = downsampleCS;
+
+        auto hr = pCache->CreateComputePipelineState(desc, rootSigHash, m_pDownsamplePSO.GetAddressOf());
+        if (FAILED(hr))
+        {
+            ELOG("Error : CreateComputePipelineState() Failed. retcode = 0x%x", hr);
+            return false;
+        }
+
+        desc.CS = upsampleCS;
+        hr = pCache->CreateComputePipelineState(desc, rootSigHash, m_pUpsamplePSO.GetAddressOf());
+        if (FAILED(hr))
+        {
+            ELOG("Error : CreateComputePipelineState() Failed. retcode = 0x%x", hr);
+            return false;
+        }
+    }
+
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+//      終了処理を行います.
+//-----------------------------------------------------------------------------
+void Bloom::Term()
+{
+    for (auto i = 0u; i < FrameCount; ++i)
+    {
+        for (auto j = 0u; j < MaxPassCount; ++j)
+        { m_CB[i][j].Term(); }
+    }
+
+    for (auto i = 0u; i < MaxMipCount; ++i)
+    {
+        DescriptorHandle** ppHandles[] = {
+            &m_pHandleDownSRV[i],
+            &m_pHandleDownUAV[i],
+            &m_pHandleUpSRV  [i],
+            &m_pHandleUpUAV  [i],
+        };
+
+        for (auto ppHandle : ppHandles)
+        {
+            if (m_pPool != nullptr && *ppHandle != nullptr)
+            { m_pPool->FreeHandle(*ppHandle); }
+
+            *ppHandle = nullptr;
+        }
+    }
+
+    m_pPool = nullptr;
+
+    m_pDownsamplePSO.Reset();
+    m_pUpsamplePSO.Reset();
+    m_RootSig.Term();
+    m_pDown.Reset();
+    m_pUp.Reset();
+
+    GetMemoryTracker().Remove(m_MemoryId);
+    m_MemoryId = MemoryTracker::InvalidId;
+
+    m_MipCount = 0;
+}
+
+//-----------------------------------------------------------------------------
+//      縮小と拡大のパスを記録します.
+//-----------------------------------------------------------------------------
+void Bloom::Dispatch
+(
+    ID3D12GraphicsCommandList*  pCmd,
+    D3D12_GPU_DESCRIPTOR_HANDLE handleScene,
+    uint32_t                    sceneWidth,
+    uint32_t                    sceneHeight,
+    D3D12_GPU_DESCRIPTOR_HANDLE handleExposure,
+    uint32_t                    frameIndex,
+    GpuTimer*                   pTimer
+)
+{
+    if (!m_Settings.Enable || m_pDownsamplePSO == nullptr || m_pUpsamplePSO == nullptr)
+    { return; }
+
+    auto quality  = (m_Settings.Quality < BLOOM_QUALITY_COUNT) ? m_Settings.Quality : BLOOM_QUALITY_HIGH;
+    auto& preset  = Presets[quality];
+    auto mipCount = (preset.MipCount < m_MipCount) ? preset.MipCount : m_MipCount;
+    auto pCB      = m_CB[frameIndex % FrameCount];
+
+    auto mip0Width  = MipSize(m_Width,  1);
+    auto mip0Height = MipSize(m_Height, 1);
+
+    // 動的解像度でシーンが左上の一部にしか描かれていなくても, 縮小の段は常に全体の大きさで作る.
+    sceneWidth  = (sceneWidth  == 0 || sceneWidth  > m_Width)  ? m_Width  : sceneWidth;
+    sceneHeight = (sceneHeight == 0 || sceneHeight > m_Height) ? m_Height : sceneHeight;
+
+    auto total = (pTimer != nullptr) ? pTimer->Begin(pCmd, "Bloom") : GpuTimer::InvalidScope;
+
+    pCmd->SetComputeRootSignature(m_RootSig.GetPtr());
+    pCmd->SetComputeRootDescriptorTable(2, handleExposure);
+
+    // 直前のパスの出力を読み込み状態に戻すバリアは, 次のパスの開始と一緒に発行する.
+    D3D12_RESOURCE_BARRIER barriers[2];
+    auto pending = 0u;
+    auto pass    = 0u;
+
+    // 縮小.
+    pCmd->SetPipelineState(m_pDownsamplePSO.Get());
+    for (auto i = 0u; i < mipCount; ++i)
+    {
+        auto dstWidth  = MipSize(mip0Width,  i);
+        auto dstHeight = MipSize(mip0Height, i);
+        auto srcWidth  = (i == 0) ? sceneWidth  : MipSize(mip0Width,  i - 1);
+        auto srcHeight = (i == 0) ? sceneHeight : MipSize(mip0Height, i - 1);
+
+        auto ptr = pCB[pass].GetPtr<CbBloom>();
+        ptr->DstWidth       = dstWidth;
+        ptr->DstHeight      = dstHeight;
+        ptr->InvDstWidth    = 1.0f / float(dstWidth);
+        ptr->InvDstHeight   = 1.0f / float(dstHeight);
+        ptr->InvSrcWidth    = 1.0f / float(srcWidth);
+        ptr->InvSrcHeight   = 1.0f / float(srcHeight);
+        ptr->Threshold      = m_Settings.Threshold;
+        ptr->Knee           = m_Settings.Knee;
+        ptr->Scatter        = m_Settings.Scatter;
+        ptr->Flags          = preset.Flags & BLOOM_FLAG_HQ;
+        ptr->SrcUVScaleX    = (i == 0) ? float(sceneWidth)  / float(m_Width)  : 1.0f;
+        ptr->SrcUVScaleY    = (i == 0) ? float(sceneHeight) / float(m_Height) : 1.0f;
+
+        // 最初の段だけ露光としきい値を適用する.
+        if (i == 0)
+        { ptr->Flags |= BLOOM_FLAG_PREFILTER | (preset.Flags & BLOOM_FLAG_KARIS); }
+
+        barriers[pending++] = Transition(m_pDown.Get(), i, ReadState, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+        pCmd->ResourceBarrier(pending, barriers);
+
+        auto src = (i == 0) ? handleScene : m_pHandleDownSRV[i - 1]->HandleGPU;
+        pCmd->SetComputeRootDescriptorTable(0, pCB[pass].GetHandleGPU());
+        pCmd->SetComputeRootDescriptorTable(1, src);
+        pCmd->SetComputeRootDescriptorTable(3, src);
+        pCmd->SetComputeRootDescriptorTable(4, m_pHandleDownUAV[i]->HandleGPU);
+
+        auto scope = (pTimer != nullptr) ? pTimer->Begin(pCmd, DownPassNames[i]) : GpuTimer::InvalidScope;
+        pCmd->Dispatch((dstWidth + GroupSize - 1) / GroupSize, (dstHeight + GroupSize - 1) / GroupSize, 1);
+        if (pTimer != nullptr)
+        { pTimer->End(pCmd, scope); }
+
+        barriers[0] = Transition(m_pDown.Get(), i, D3D12_RESOURCE_STATE_UNORDERED_ACCESS, ReadState);
+        pending = 1;
+        pass++;
+    }
+
+    // 拡大. 最下段は縮小結果をそのまま使う.
+    pCmd->SetPipelineState(m_pUpsamplePSO.Get());
+    for (auto i = int(mipCount) - 2; i >= 0; --i)
+    {
+        auto dstWidth  = MipSize(mip0Width,  i);
+        auto dstHeight = MipSize(mip0Height, i);
+        auto srcWidth  = MipSize(mip0Width,  i + 1);
+        auto srcHeight = MipSize(mip0Height, i + 1);
+
+        auto ptr = pCB[pass].GetPtr<CbBloom>();
+        ptr->DstWidth       = dstWidth;
+        ptr->DstHeight      = dstHeight;
+        ptr->InvDstWidth    = 1.0f / float(dstWidth);
+        ptr->InvDstHeight   = 1.0f / float(dstHeight);
+        ptr->InvSrcWidth    = 1.0f / float(srcWidth);
+        ptr->InvSrcHeight   = 1.0f / float(srcHeight);
+        ptr->Threshold      = m_Settings.Threshold;
+        ptr->Knee           = m_Settings.Knee;
+        ptr->Scatter        = m_Settings.Scatter;
+        ptr->Flags          = preset.Flags & BLOOM_FLAG_HQ;
+        ptr->SrcUVScaleX    = 1.0f;
+        ptr->SrcUVScaleY    = 1.0f;
+
+        barriers[pending++] = Transition(m_pUp.Get(), i, ReadState, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+        pCmd->ResourceBarrier(pending, barriers);
+
+        auto lower = (i + 1 == int(mipCount) - 1) ? m_pHandleDownSRV[i + 1] : m_pHandleUpSRV[i + 1];
+        pCmd->SetComputeRootDescriptorTable(0, pCB[pass].GetHandleGPU());
+        pCmd->SetComputeRootDescriptorTable(1, lower->HandleGPU);
+        pCmd->SetComputeRootDescriptorTable(3, m_pHandleDownSRV[i]->HandleGPU);
+        pCmd->SetComputeRootDescriptorTable(4, m_pHandleUpUAV[i]->HandleGPU);
+
+        auto scope = (pTimer != nullptr) ? pTimer->Begin(pCmd, UpPassNames[i]) : GpuTimer::InvalidScope;
+        pCmd->Dispatch((dstWidth + GroupSize - 1) / GroupSize, (dstHeight + GroupSize - 1) / GroupSize, 1);
+        if (pTimer != nullptr)
+        { pTimer->End(pCmd, scope); }
+
+        barriers[0] = Transition(m_pUp.Get(), i, D3D12_RESOURCE_STATE_UNORDERED_ACCESS, ReadState);
+        pending = 1;
+        pass++;
+    }
+
+    if (pending > 0)
+    { pCmd->ResourceBarrier(pending, barriers); }
+
+    if (pTimer != nullptr)
+    { pTimer->End(pCmd, total); }
+}
+
+//-----------------------------------------------------------------------------
+//      設定を取得します.
+//-----------------------------------------------------------------------------
+BloomSettings& Bloom::GetSettings()
+{ return m_Settings; }
+
+//-----------------------------------------------------------------------------
+//      合成に使う強さを取得します.
+//-----------------------------------------------------------------------------
+float Bloom::GetIntensity() const
+{ return (m_Settings.Enable && m_pUp != nullptr) ? m_Settings.Intensity : 0.0f; }
+
+//-----------------------------------------------------------------------------
+//      合成するテクスチャのSRVを取得します.
+//-----------------------------------------------------------------------------
+D3D12_GPU_DESCRIPTOR_HANDLE Bloom::GetHandleSRV() const
+{ return m_pHandleUpSRV[0]->HandleGPU; }
+
+//-----------------------------------------------------------------------------
+//      ミップチェーンとビューを生成します.
+//-----------------------------------------------------------------------------
+bool Bloom::CreateChain
+(
+    ID3D12Device*       pDevice,
+    ID3D12Resource**    ppResource,
+    DescriptorHandle**  ppHandleSRV,
+    DescriptorHandle**  ppHandleUAV
+)
+{
+    D3D12_HEAP_PROPERTIES prop = {};
+    prop.Type                 = D3D12_HEAP_TYPE_DEFAULT;
+    prop.CPUPageProperty      = D3D12_CPU_PAGE_PROPERTY_UNKNOWN;
+    prop.MemoryPoolPreference = D3D12_MEMORY_POOL_UNKNOWN;
+    prop.CreationNodeMask     = 1;
+    prop.VisibleNodeMask      = 1;
+
+    D3D12_RESOURCE_DESC desc = {};
+    desc.Dimension          = D3D12_RESOURCE_DIMENSION_TEXTURE2D;
+    desc.Width              = MipSize(m_Width,  1);
+    desc.Height             = MipSize(m_Height, 1);
+    desc.DepthOrArraySize   = 1;
+    desc.MipLevels          = UINT16(m_MipCount);
+    desc.Format             = BloomFormat;
+    desc.SampleDesc.Count   = 1;
+    desc.Layout             = D3D12_TEXTURE_LAYOUT_UNKNOWN;
+    desc.Flags              = D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS;
+
+    auto hr = pDevice->CreateCommittedResource(
+        &prop,
+        D3D12_HEAP_FLAG_NONE,
+        &desc,
+        ReadState,
+        nullptr,
+        IID_PPV_ARGS(ppResource));
+    if (FAILED(hr))
+    {
+        ELOG("Error : ID3D12Device::CreateCommittedResource() Failed. retcode = 0x%x", hr);
+        return false;
+    }
+
+    // ミップごとにビューを生成.
+    for (auto i = 0u; i < m_MipCount; ++i)
+    {
+        ppHandleSRV[i] = m_pPool->AllocHandle();
+        ppHandleUAV[i] = m_pPool->AllocHandle();
+        if (ppHandleSRV[i] == nullptr || ppHandleUAV[i] == nullptr)
+        {
+            ELOG("Error : DescriptorPool::AllocHandle() Failed.");
+            return false;
+        }
+
+        D3D12_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
+        srvDesc.Format                      = BloomFormat;
+        srvDesc.ViewDimension               = D3D12_SRV_DIMENSION_TEXTURE2D;
+        srvDesc.Shader4ComponentMapping     = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
+        srvDesc.Texture2D.MostDetailedMip   = i;
+        srvDesc.Texture2D.MipLevels         = 1;
+        pDevice->CreateShaderResourceView(*ppResource, &srvDesc, ppHandleSRV[i]->HandleCPU);
+
+        D3D12_UNORDERED_ACCESS_VIEW_DESC uavDesc = {};
+        uavDesc.Format              = BloomFormat;
+        uavDesc.ViewDimension       = D3D12_UAV_DIMENSION_TEXTURE2D;
+        uavDesc.Texture2D.MipSlice  = i;
+        pDevice->CreateUnorderedAccessView(*ppResource, nullptr, &uavDesc, ppHandleUAV[i]->HandleCPU);
+    }
+
+    return true;
+}
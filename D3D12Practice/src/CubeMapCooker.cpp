@@ -0,0 +1,629 @@
+﻿//-----------------------------------------------------------------------------
+// File : CubeMapCooker.cpp
+// Desc : CPU Equirectangular To CubeMap Converter.
+// Copyright(c) Pocol. All right reserved.
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------
+#include "CubeMapCooker.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <thread>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#define COOKER_USE_SSE  (1)
+#include <xmmintrin.h>
+#endif
+
+
+namespace {
+
+//-----------------------------------------------------------------------------
+// Constant Values.
+//-----------------------------------------------------------------------------
+constexpr float     F_PI                = 3.14159265358979323846f;
+constexpr uint32_t  DDS_MAGIC           = 0x20534444;   // "DDS "
+constexpr uint32_t  DDS_FOURCC_DX10     = 0x30315844;   // "DX10"
+constexpr uint32_t  DDS_FOURCC_RGBA16F  = 113;          // D3DFMT_A16B16G16R16F
+constexpr uint32_t  DDS_FOURCC_RGBA32F  = 116;          // D3DFMT_A32B32G32R32F
+constexpr uint32_t  DDPF_FOURCC         = 0x4;
+constexpr uint32_t  DDSD_CAPS           = 0x1;
+constexpr uint32_t  DDSD_HEIGHT         = 0x2;
+constexpr uint32_t  DDSD_WIDTH          = 0x4;
+constexpr uint32_t  DDSD_PITCH          = 0x8;
+constexpr uint32_t  DDSD_PIXELFORMAT    = 0x1000;
+constexpr uint32_t  DDSD_MIPMAPCOUNT    = 0x20000;
+constexpr uint32_t  DDSCAPS_COMPLEX     = 0x8;
+constexpr uint32_t  DDSCAPS_TEXTURE     = 0x1000;
+constexpr uint32_t  DDSCAPS_MIPMAP      = 0x400000;
+constexpr uint32_t  DDSCAPS2_CUBEMAP    = 0xFE00;       // CUBEMAP | 全ての面.
+constexpr uint32_t  DXGI_RGBA32F        = 2;            // DXGI_FORMAT_R32G32B32A32_FLOAT
+constexpr uint32_t  DXGI_RGB32F         = 6;            // DXGI_FORMAT_R32G32B32_FLOAT
+constexpr uint32_t  DXGI_RGBA16F        = 10;           // DXGI_FORMAT_R16G16B16A16_FLOAT
+constexpr uint32_t  DIMENSION_TEXTURE2D = 3;            // D3D12_RESOURCE_DIMENSION_TEXTURE2D
+constexpr uint32_t  MISC_TEXTURECUBE    = 0x4;          // D3D11_RESOURCE_MISC_TEXTURECUBE
+
+///////////////////////////////////////////////////////////////////////////////
+// DDSPixelFormat structure
+///////////////////////////////////////////////////////////////////////////////
+struct DDSPixelFormat
+{
+    uint32_t    Size;
+    uint32_t    Flags;
+    uint32_t    FourCC;
+    uint32_t    RGBBitCount;
+    uint32_t    RBitMask;
+    uint32_t    GBitMask;
+    uint32_t    BBitMask;
+    uint32_t    ABitMask;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// DDSHeader structure
+///////////////////////////////////////////////////////////////////////////////
+struct DDSHeader
+{
+    uint32_t        Size;
+    uint32_t        Flags;
+    uint32_t        Height;
+    uint32_t        Width;
+    uint32_t        PitchOrLinearSize;
+    uint32_t        Depth;
+    uint32_t        MipMapCount;
+    uint32_t        Reserved1[11];
+    DDSPixelFormat  PixelFormat;
+    uint32_t        Caps;
+    uint32_t        Caps2;
+    uint32_t        Caps3;
+    uint32_t        Caps4;
+    uint32_t        Reserved2;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// DDSHeaderDXT10 structure
+///////////////////////////////////////////////////////////////////////////////
+struct DDSHeaderDXT10
+{
+    uint32_t    DxgiFormat;
+    uint32_t    ResourceDimension;
+    uint32_t    MiscFlag;
+    uint32_t    ArraySize;
+    uint32_t    MiscFlags2;
+};
+
+static_assert(sizeof(DDSHeader) == 124, "Invalid DDS header size.");
+static_assert(sizeof(DDSHeaderDXT10) == 20, "Invalid DDS DX10 header size.");
+
+///////////////////////////////////////////////////////////////////////////////
+// Float4 structure
+///////////////////////////////////////////////////////////////////////////////
+#if COOKER_USE_SSE
+using Float4 = __m128;
+
+inline Float4 Load4  (const float* p)                   { return _mm_loadu_ps(p); }
+inline void   Store4 (float* p, Float4 v)               { _mm_storeu_ps(p, v); }
+inline Float4 Zero4  ()                                 { return _mm_setzero_ps(); }
+inline Float4 MulAdd4(Float4 a, float s, Float4 c)      { return _mm_add_ps(_mm_mul_ps(a, _mm_set1_ps(s)), c); }
+inline Float4 Add4   (Float4 a, Float4 b)               { return _mm_add_ps(a, b); }
+inline Float4 Scale4 (Float4 a, float s)                { return _mm_mul_ps(a, _mm_set1_ps(s)); }
+inline Float4 Max4   (Float4 a, Float4 b)               { return _mm_max_ps(a, b); }
+#else
+struct Float4 { float v[4]; };
+
+inline Float4 Load4  (const float* p)                   { return { p[0], p[1], p[2], p[3] }; }
+inline void   Store4 (float* p, Float4 a)               { memcpy(p, a.v, sizeof(a.v)); }
+inline Float4 Zero4  ()                                 { return { 0.0f, 0.0f, 0.0f, 0.0f }; }
+inline Float4 MulAdd4(Float4 a, float s, Float4 c)      { return { a.v[0] * s + c.v[0], a.v[1] * s + c.v[1], a.v[2] * s + c.v[2], a.v[3] * s + c.v[3] }; }
+inline Float4 Add4   (Float4 a, Float4 b)               { return { a.v[0] + b.v[0], a.v[1] + b.v[1], a.v[2] + b.v[2], a.v[3] + b.v[3] }; }
+inline Float4 Scale4 (Float4 a, float s)                { return { a.v[0] * s, a.v[1] * s, a.v[2] * s, a.v[3] * s }; }
+inline Float4 Max4   (Float4 a, Float4 b)               { return { std::max(a.v[0], b.v[0]), std::max(a.v[1], b.v[1]), std::max(a.v[2], b.v[2]), std::max(a.v[3], b.v[3]) }; }
+#endif
+
+//-----------------------------------------------------------------------------
+//      半精度浮動小数を単精度浮動小数に変換します.
+//-----------------------------------------------------------------------------
+float HalfToFloat(uint16_t value)
+{
+    uint32_t sign = uint32_t(value & 0x8000) << 16;
+    uint32_t exp  = (value >> 10) & 0x1F;
+    uint32_t mant = value & 0x3FF;
+    uint32_t bits;
+
+    if (exp == 0)
+    {
+        if (mant == 0)
+        { bits = sign; }
+        else
+        {
+            // 非正規化数を正規化.
+            exp = 127 - 15 + 1;
+            while ((mant & 0x400) == 0)
+            {
+                mant <<= 1;
+                exp--;
+            }
+            bits = sign | (exp << 23) | ((mant & 0x3FF) << 13);
+        }
+    }
+    else if (exp == 0x1F)
+    { bits = sign | 0x7F800000 | (mant << 13); }
+    else
+    { bits = sign | ((exp + 127 - 15) << 23) | (mant << 13); }
+
+    float result;
+    memcpy(&result, &bits, sizeof(result));
+    return result;
+}
+
+//-----------------------------------------------------------------------------
+//      単精度浮動小数を半精度浮動小数に変換します(最近接偶数丸め).
+//-----------------------------------------------------------------------------
+uint16_t FloatToHalf(float value)
+{
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+
+    uint16_t sign = uint16_t((bits >> 16) & 0x8000);
+    uint32_t absBits = bits & 0x7FFFFFFF;
+
+    // NaN と 無限大.
+    if (absBits >= 0x7F800000)
+    { return uint16_t(sign | 0x7C00 | ((absBits > 0x7F800000) ? 0x200 : 0)); }
+
+    // 半精度で表現できない大きな値は無限大.
+    if (absBits >= 0x477FF000)
+    { return uint16_t(sign | 0x7C00); }
+
+    // 非正規化数.
+    if (absBits < 0x38800000)
+    {
+        if (absBits < 0x33000000)
+        { return sign; }
+
+        uint32_t exp   = absBits >> 23;
+        uint32_t mant  = (absBits & 0x7FFFFF) | 0x800000;
+        uint32_t shift = 126 - exp;
+        uint32_t half  = mant >> shift;
+        uint32_t rem   = mant & ((1u << shift) - 1);
+        uint32_t mid   = 1u << (shift - 1);
+        if (rem > mid || (rem == mid && (half & 1)))
+        { half++; }
+        return uint16_t(sign | half);
+    }
+
+    uint32_t half = ((absBits - 0x38000000) >> 13);
+    uint32_t rem  = absBits & 0x1FFF;
+    if (rem > 0x1000 || (rem == 0x1000 && (half & 1)))
+    { half++; }
+    return uint16_t(sign | half);
+}
+
+//-----------------------------------------------------------------------------
+//      指定回数の処理をワーカースレッドに分配して実行します.
+//-----------------------------------------------------------------------------
+template<typename Func>
+void ParallelFor(uint32_t count, uint32_t threadCount, Func func)
+{
+    threadCount = std::max(1u, std::min(threadCount, count));
+
+    std::atomic<uint32_t> next(0);
+    auto worker = [&]()
+    {
+        for (auto i = next.fetch_add(1); i < count; i = next.fetch_add(1))
+        { func(i); }
+    };
+
+    std::vector<std::thread> threads;
+    threads.reserve(threadCount - 1);
+    for (auto i = 1u; i < threadCount; ++i)
+    { threads.emplace_back(worker); }
+
+    worker();
+
+    for (auto& thread : threads)
+    { thread.join(); }
+}
+
+//-----------------------------------------------------------------------------
+//      テクセルを取得します(横方向は繰り返し, 縦方向はクランプ).
+//-----------------------------------------------------------------------------
+inline const float* GetTexel(const FloatImage& image, int x, int y)
+{
+    auto w = int(image.Width);
+    auto h = int(image.Height);
+    x %= w;
+    if (x < 0)
+    { x += w; }
+    y = std::min(std::max(y, 0), h - 1);
+    return &image.Pixels[(size_t(y) * image.Width + x) * 4];
+}
+
+//-----------------------------------------------------------------------------
+//      Catmull-Romの重みを計算します.
+//-----------------------------------------------------------------------------
+inline void CatmullRomWeights(float t, float w[4])
+{
+    auto t2 = t * t;
+    auto t3 = t2 * t;
+    w[0] = 0.5f * (-t3 + 2.0f * t2 - t);
+    w[1] = 0.5f * ( 3.0f * t3 - 5.0f * t2 + 2.0f);
+    w[2] = 0.5f * (-3.0f * t3 + 4.0f * t2 + t);
+    w[3] = 0.5f * ( t3 - t2);
+}
+
+//-----------------------------------------------------------------------------
+//      スフィアマップをサンプリングします.
+//-----------------------------------------------------------------------------
+Float4 SampleSphereMap(const FloatImage& image, float u, float v, CUBEMAP_FILTER filter)
+{
+    auto fx = u * image.Width  - 0.5f;
+    auto fy = v * image.Height - 0.5f;
+    auto x0 = int(std::floor(fx));
+    auto y0 = int(std::floor(fy));
+    auto tx = fx - x0;
+    auto ty = fy - y0;
+
+    if (filter == CUBEMAP_FILTER_BICUBIC)
+    {
+        float wx[4];
+        float wy[4];
+        CatmullRomWeights(tx, wx);
+        CatmullRomWeights(ty, wy);
+
+        auto result = Zero4();
+        for (auto j = 0; j < 4; ++j)
+        {
+            auto row = Zero4();
+            for (auto i = 0; i < 4; ++i)
+            { row = MulAdd4(Load4(GetTexel(image, x0 - 1 + i, y0 - 1 + j)), wx[i], row); }
+            result = MulAdd4(row, wy[j], result);
+        }
+
+        // Catmull-Romのオーバーシュートで負値にならないようにする.
+        return Max4(result, Zero4());
+    }
+
+    auto c00 = Load4(GetTexel(image, x0,     y0));
+    auto c10 = Load4(GetTexel(image, x0 + 1, y0));
+    auto c01 = Load4(GetTexel(image, x0,     y0 + 1));
+    auto c11 = Load4(GetTexel(image, x0 + 1, y0 + 1));
+
+    auto result = Scale4(c00, (1.0f - tx) * (1.0f - ty));
+    result = MulAdd4(c10, tx * (1.0f - ty), result);
+    result = MulAdd4(c01, (1.0f - tx) * ty, result);
+    result = MulAdd4(c11, tx * ty, result);
+    return result;
+}
+
+//-----------------------------------------------------------------------------
+//      キューブマップの面とテクセル位置から方向ベクトルを求めます.
+//-----------------------------------------------------------------------------
+inline void GetCubeDirection(uint32_t face, float u, float v, float dir[3])
+{
+    switch (face)
+    {
+    case 0: dir[0] =  1.0f; dir[1] = -v;    dir[2] = -u;    break;  // +X
+    case 1: dir[0] = -1.0f; dir[1] = -v;    dir[2] =  u;    break;  // -X
+    case 2: dir[0] =  u;    dir[1] =  1.0f; dir[2] =  v;    break;  // +Y
+    case 3: dir[0] =  u;    dir[1] = -1.0f; dir[2] = -v;    break;  // -Y
+    case 4: dir[0] =  u;    dir[1] = -v;    dir[2] =  1.0f; break;  // +Z
+    default:dir[0] = -u;    dir[1] = -v;    dir[2] = -1.0f; break;  // -Z
+    }
+
+    auto invLen = 1.0f / std::sqrt(dir[0] * dir[0] + dir[1] * dir[1] + dir[2] * dir[2]);
+    dir[0] *= invLen;
+    dir[1] *= invLen;
+    dir[2] *= invLen;
+}
+
+//-----------------------------------------------------------------------------
+//      ファイルから指定サイズを読み込みます.
+//-----------------------------------------------------------------------------
+template<typename T>
+bool ReadValue(std::ifstream& stream, T& value)
+{
+    stream.read(reinterpret_cast<char*>(&value), sizeof(T));
+    return bool(stream);
+}
+
+} // namespace
+
+
+//-----------------------------------------------------------------------------
+//      浮動小数点形式のDDSファイルを読み込みます.
+//-----------------------------------------------------------------------------
+bool LoadFloatDDS(const std::filesystem::path& path, FloatImage& result)
+{
+    std::ifstream stream(path, std::ios::binary);
+    if (!stream.is_open())
+    { return false; }
+
+    uint32_t  magic = 0;
+    DDSHeader header = {};
+    if (!ReadValue(stream, magic) || magic != DDS_MAGIC)
+    { return false; }
+
+    if (!ReadValue(stream, header) || header.Size != sizeof(DDSHeader))
+    { return false; }
+
+    auto format = 0u;
+    if ((header.PixelFormat.Flags & DDPF_FOURCC) == 0)
+    { return false; }
+
+    if (header.PixelFormat.FourCC == DDS_FOURCC_DX10)
+    {
+        DDSHeaderDXT10 ext = {};
+        if (!ReadValue(stream, ext) || ext.ResourceDimension != DIMENSION_TEXTURE2D)
+        { return false; }
+        format = ext.DxgiFormat;
+    }
+    else if (header.PixelFormat.FourCC == DDS_FOURCC_RGBA32F)
+    { format = DXGI_RGBA32F; }
+    else if (header.PixelFormat.FourCC == DDS_FOURCC_RGBA16F)
+    { format = DXGI_RGBA16F; }
+
+    if (header.Width == 0 || header.Height == 0)
+    { return false; }
+
+    result.Width  = header.Width;
+    result.Height = header.Height;
+    result.Pixels.resize(size_t(header.Width) * header.Height * 4);
+
+    auto count = size_t(header.Width) * header.Height;
+    switch (format)
+    {
+    case DXGI_RGBA32F:
+        {
+            stream.read(reinterpret_cast<char*>(result.Pixels.data()), count * sizeof(float) * 4);
+        }
+        break;
+
+    case DXGI_RGB32F:
+        {
+            std::vector<float> rgb(count * 3);
+            stream.read(reinterpret_cast<char*>(rgb.data()), rgb.size() * sizeof(float));
+            for (size_t i = 0; i < count; ++i)
+            {
+                result.Pixels[i * 4 + 0] = rgb[i * 3 + 0];
+                result.Pixels[i * 4 + 1] = rgb[i * 3 + 1];
+                result.Pixels[i * 4 + 2] = rgb[i * 3 + 2];
+                result.Pixels[i * 4 + 3] = 1.0f;
+            }
+        }
+        break;
+
+    case DXGI_RGBA16F:
+        {
+            std::vector<uint16_t> half(count * 4);
+            stream.read(reinterpret_cast<char*>(half.data()), half.size() * sizeof(uint16_t));
+            for (size_t i = 0; i < half.size(); ++i)
+            { result.Pixels[i] = HalfToFloat(half[i]); }
+        }
+        break;
+
+    default:
+        return false;
+    }
+
+    return bool(stream);
+}
+
+//-----------------------------------------------------------------------------
+//      スフィアマップをミップ付きキューブマップに変換します.
+//-----------------------------------------------------------------------------
+bool CookCubeMap(const FloatImage& sphereMap, const CubeMapCookDesc& desc, CubeMapImage& result)
+{
+    if (sphereMap.Width == 0 || sphereMap.Height == 0
+     || sphereMap.Pixels.size() < size_t(sphereMap.Width) * sphereMap.Height * 4)
+    { return false; }
+
+    auto faceSize = (desc.FaceSize != 0) ? desc.FaceSize : sphereMap.Height;
+
+    // 1x1までのミップ数を求める.
+    auto maxMips = 1u;
+    while ((faceSize >> maxMips) != 0)
+    { maxMips++; }
+
+    auto mipLevels = (desc.MipLevels != 0) ? std::min(desc.MipLevels, maxMips) : maxMips;
+
+    auto threadCount = desc.ThreadCount;
+    if (threadCount == 0)
+    { threadCount = std::max(1u, std::thread::hardware_concurrency()); }
+
+    result.FaceSize  = faceSize;
+    result.MipLevels = mipLevels;
+    result.Surfaces.clear();
+    result.Surfaces.resize(6 * mipLevels);
+
+    for (auto face = 0u; face < 6; ++face)
+    {
+        for (auto mip = 0u; mip < mipLevels; ++mip)
+        {
+            auto& surface = result.GetSurface(face, mip);
+            surface.Width  = std::max(1u, faceSize >> mip);
+            surface.Height = surface.Width;
+            surface.Pixels.resize(size_t(surface.Width) * surface.Height * 4);
+        }
+    }
+
+    // 先頭ミップをスフィアマップからリサンプリング(面 x 行 単位で並列化).
+    ParallelFor(6 * faceSize, threadCount, [&](uint32_t index)
+    {
+        auto face = index / faceSize;
+        auto y    = index % faceSize;
+        auto& surface = result.GetSurface(face, 0);
+        auto  dst     = &surface.Pixels[size_t(y) * faceSize * 4];
+
+        auto v = 2.0f * (y + 0.5f) / float(faceSize) - 1.0f;
+        for (auto x = 0u; x < faceSize; ++x)
+        {
+            auto u = 2.0f * (x + 0.5f) / float(faceSize) - 1.0f;
+
+            float dir[3];
+            GetCubeDirection(face, u, v, dir);
+
+            auto su = std::atan2(dir[2], dir[0]) / (2.0f * F_PI) + 0.5f;
+            auto sv = std::acos(std::min(std::max(dir[1], -1.0f), 1.0f)) / F_PI;
+
+            Store4(dst + x * 4, SampleSphereMap(sphereMap, su, sv, desc.Filter));
+        }
+    });
+
+    // 下位ミップは上位ミップを2x2ボックスフィルタで縮小.
+    for (auto mip = 1u; mip < mipLevels; ++mip)
+    {
+        auto size = std::max(1u, faceSize >> mip);
+        ParallelFor(6 * size, threadCount, [&](uint32_t index)
+        {
+            auto face = index / size;
+            auto y    = index % size;
+            auto& src = result.GetSurface(face, mip - 1);
+            auto& dst = result.GetSurface(face, mip);
+
+            auto y0 = std::min(y * 2 + 0, src.Height - 1);
+            auto y1 = std::min(y * 2 + 1, src.Height - 1);
+            auto row0 = &src.Pixels[size_t(y0) * src.Width * 4];
+            auto row1 = &src.Pixels[size_t(y1) * src.Width * 4];
+            auto out  = &dst.Pixels[size_t(y) * dst.Width * 4];
+
+            for (auto x = 0u; x < size; ++x)
+            {
+                auto x0 = std::min(x * 2 + 0, src.Width - 1);
+                auto x1 = std::min(x * 2 + 1, src.Width - 1);
+
+                auto sum = Add4(
+                    Add4(Load4(row0 + x0 * 4), Load4(row0 + x1 * 4)),
+                    Add4(Load4(row1 + x0 * 4), Load4(row1 + x1 * 4)));
+                Store4(out + x * 4, Scale4(sum, 0.25f));
+            }
+        });
+    }
+
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+//      キューブマップをDDSファイルに書き出します.
+//-----------------------------------------------------------------------------
+bool SaveCubeMapDDS(const std::filesystem::path& path, const CubeMapImage& cubeMap, CUBEMAP_FORMAT format)
+{
+    if (cubeMap.FaceSize == 0 || cubeMap.MipLevels == 0
+     || cubeMap.Surfaces.size() != size_t(6) * cubeMap.MipLevels)
+    { return false; }
+
+    std::ofstream stream(path, std::ios::binary);
+    if (!stream.is_open())
+    { return false; }
+
+    auto bytesPerPixel = (format == CUBEMAP_FORMAT_RGBA32F) ? 16u : 8u;
+
+    DDSHeader header = {};
+    header.Size                 = sizeof(DDSHeader);
+    header.Flags                = DDSD_CAPS | DDSD_HEIGHT | DDSD_WIDTH | DDSD_PITCH | DDSD_PIXELFORMAT | DDSD_MIPMAPCOUNT;
+    header.Height               = cubeMap.FaceSize;
+    header.Width                = cubeMap.FaceSize;
+    header.PitchOrLinearSize    = cubeMap.FaceSize * bytesPerPixel;
+    header.Depth                = 0;
+    header.MipMapCount          = cubeMap.MipLevels;
+    header.PixelFormat.Size     = sizeof(DDSPixelFormat);
+    header.PixelFormat.Flags    = DDPF_FOURCC;
+    header.PixelFormat.FourCC   = DDS_FOURCC_DX10;
+    header.Caps                 = DDSCAPS_COMPLEX | DDSCAPS_TEXTURE | DDSCAPS_MIPMAP;
+    header.Caps2                = DDSCAPS2_CUBEMAP;
+
+    DDSHeaderDXT10 ext = {};
+    ext.DxgiFormat          = (format == CUBEMAP_FORMAT_RGBA32F) ? DXGI_RGBA32F : DXGI_RGBA16F;
+    ext.ResourceDimension   = DIMENSION_TEXTURE2D;
+    ext.MiscFlag            = MISC_TEXTURECUBE;
+    ext.ArraySize           = 1;
+    ext.MiscFlags2          = 0;
+
+    stream.write(reinterpret_cast<const char*>(&DDS_MAGIC), sizeof(DDS_MAGIC));
+    stream.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    stream.write(reinterpret_cast<const char*>(&ext), sizeof(ext));
+
+    // サブリソースは 面 -> ミップ の順で格納する.
+    std::vector<uint16_t> half;
+    for (auto& surface : cubeMap.Surfaces)
+    {
+        if (format == CUBEMAP_FORMAT_RGBA32F)
+        {
+            stream.write(
+                reinterpret_cast<const char*>(surface.Pixels.data()),
+                surface.Pixels.size() * sizeof(float));
+        }
+        else
+        {
+            half.resize(surface.Pixels.size());
+            for (size_t i = 0; i < surface.Pixels.size(); ++i)
+            { half[i] = FloatToHalf(surface.Pixels[i]); }
+
+            stream.write(
+                reinterpret_cast<const char*>(half.data()),
+                half.size() * sizeof(uint16_t));
+        }
+    }
+
+    return bool(stream);
+}
+
+//-----------------------------------------------------------------------------
+//      画像をDDSファイルに書き出します.
+//-----------------------------------------------------------------------------
+bool SaveFloatDDS(const std::filesystem::path& path, const FloatImage& image, CUBEMAP_FORMAT format)
+{
+    auto count = size_t(image.Width) * image.Height * 4;
+    if (count == 0 || image.Pixels.size() < count)
+    { return false; }
+
+    std::ofstream stream(path, std::ios::binary);
+    if (!stream.is_open())
+    { return false; }
+
+    auto bytesPerPixel = (format == CUBEMAP_FORMAT_RGBA32F) ? 16u : 8u;
+
+    DDSHeader header = {};
+    header.Size                 = sizeof(DDSHeader);
+    header.Flags                = DDSD_CAPS | DDSD_HEIGHT | DDSD_WIDTH | DDSD_PITCH | DDSD_PIXELFORMAT;
+    header.Height               = image.Height;
+    header.Width                = image.Width;
+    header.PitchOrLinearSize    = image.Width * bytesPerPixel;
+    header.MipMapCount          = 1;
+    header.PixelFormat.Size     = sizeof(DDSPixelFormat);
+    header.PixelFormat.Flags    = DDPF_FOURCC;
+    header.PixelFormat.FourCC   = DDS_FOURCC_DX10;
+    header.Caps                 = DDSCAPS_TEXTURE;
+
+    DDSHeaderDXT10 ext = {};
+    ext.DxgiFormat          = (format == CUBEMAP_FORMAT_RGBA32F) ? DXGI_RGBA32F : DXGI_RGBA16F;
+    ext.ResourceDimension   = DIMENSION_TEXTURE2D;
+    ext.ArraySize           = 1;
+
+    stream.write(reinterpret_cast<const char*>(&DDS_MAGIC), sizeof(DDS_MAGIC));
+    stream.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    stream.write(reinterpret_cast<const char*>(&ext), sizeof(ext));
+
+    if (format == CUBEMAP_FORMAT_RGBA32F)
+    {
+        stream.write(
+            reinterpret_cast<const char*>(image.Pixels.data()),
+            count * sizeof(float));
+    }
+    else
+    {
+        std::vector<uint16_t> half(count);
+        for (size_t i = 0; i < count; ++i)
+        { half[i] = FloatToHalf(image.Pixels[i]); }
+
+        stream.write(
+            reinterpret_cast<const char*>(half.data()),
+            half.size() * sizeof(uint16_t));
+    }
+
+    return bool(stream);
+}
@@ -0,0 +1,387 @@
+﻿//-----------------------------------------------------------------------------
+// File : DrawList.cpp
+// Desc : Radix Sorted Draw Packet List.
+// Copyright(c) Pocol. All right reserved.
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------
+#include "DrawList.h"
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <thread>
+
+
+namespace {
+
+//-----------------------------------------------------------------------------
+// Constant Values.
+//-----------------------------------------------------------------------------
+constexpr uint32_t  RadixBits       = 8;                        // 1回の走査で並べるビット数.
+constexpr uint32_t  RadixSize       = 1u << RadixBits;          // 1回の走査のバケット数.
+constexpr uint32_t  RadixMask       = RadixSize - 1;            // 1回の走査のマスク.
+constexpr size_t    MinChunkSize    = 16 * 1024;                // 1スレッドが受け持つ最小のパケット数.
+
+constexpr uint64_t  PassMask        = (1ull << DRAW_KEY_PASS_BITS)     - 1;
+constexpr uint64_t  PipelineMask    = (1ull << DRAW_KEY_PIPELINE_BITS) - 1;
+constexpr uint64_t  MaterialMask    = (1ull << DRAW_KEY_MATERIAL_BITS) - 1;
+constexpr uint64_t  DepthMask       = (1ull << DRAW_KEY_DEPTH_BITS)    - 1;
+constexpr uint64_t  SubMask         = (1ull << DRAW_KEY_SUB_BITS)      - 1;
+
+constexpr uint32_t  PassShift       = 64 - DRAW_KEY_PASS_BITS;
+
+// DRAW_ORDER_STATE の配置.
+constexpr uint32_t  StatePipelineShift  = PassShift - DRAW_KEY_PIPELINE_BITS;
+constexpr uint32_t  StateMaterialShift  = StatePipelineShift - DRAW_KEY_MATERIAL_BITS;
+constexpr uint32_t  StateDepthShift     = StateMaterialShift - DRAW_KEY_DEPTH_BITS;
+
+// DRAW_ORDER_FRONT_TO_BACK の配置.
+constexpr uint32_t  FrontPipelineShift  = PassShift - DRAW_KEY_PIPELINE_BITS;
+constexpr uint32_t  FrontDepthShift     = FrontPipelineShift - DRAW_KEY_DEPTH_BITS;
+constexpr uint32_t  FrontMaterialShift  = FrontDepthShift - DRAW_KEY_MATERIAL_BITS;
+
+// DRAW_ORDER_BACK_TO_FRONT の配置.
+constexpr uint32_t  BackDepthShift      = PassShift - DRAW_KEY_DEPTH_BITS;
+constexpr uint32_t  BackPipelineShift   = BackDepthShift - DRAW_KEY_PIPELINE_BITS;
+constexpr uint32_t  BackMaterialShift   = BackPipelineShift - DRAW_KEY_MATERIAL_BITS;
+
+static_assert(StateDepthShift == DRAW_KEY_SUB_BITS && FrontMaterialShift == DRAW_KEY_SUB_BITS
+           && BackMaterialShift == DRAW_KEY_SUB_BITS, "Draw key layout mismatch.");
+
+///////////////////////////////////////////////////////////////////////////////
+// SpinBarrier class
+///////////////////////////////////////////////////////////////////////////////
+class SpinBarrier
+{
+public:
+    explicit SpinBarrier(uint32_t threadCount)
+    : m_ThreadCount(threadCount)
+    , m_Count      (0)
+    , m_Generation (0)
+    { /* DO_NOTHING */ }
+
+    //-------------------------------------------------------------------------
+    //      全スレッドが到着するまで待機します.
+    //-------------------------------------------------------------------------
+    void Wait()
+    {
+        auto generation = m_Generation.load(std::memory_order_acquire);
+        if (m_Count.fetch_add(1, std::memory_order_acq_rel) + 1 == m_ThreadCount)
+        {
+            m_Count.store(0, std::memory_order_relaxed);
+            m_Generation.fetch_add(1, std::memory_order_release);
+            return;
+        }
+
+        while (m_Generation.load(std::memory_order_acquire) == generation)
+        { std::this_thread::yield(); }
+    }
+
+private:
+    uint32_t                m_ThreadCount;
+    std::atomic<uint32_t>   m_Count;
+    std::atomic<uint32_t>   m_Generation;
+};
+
+//-----------------------------------------------------------------------------
+//      パケット間で値が異なるビットを求めます.
+//-----------------------------------------------------------------------------
+uint64_t FindVaryingBits(const DrawPacket* pPackets, size_t begin, size_t end, uint64_t reference)
+{
+    uint64_t result = 0;
+    for (auto i = begin; i < end; ++i)
+    { result |= pPackets[i].Key ^ reference; }
+    return result;
+}
+
+//-----------------------------------------------------------------------------
+//      1桁分の基数ソートを行います.
+//-----------------------------------------------------------------------------
+void RadixPass(const DrawPacket* pSrc, DrawPacket* pDst, size_t count, uint32_t shift)
+{
+    uint32_t offsets[RadixSize] = {};
+    for (size_t i = 0; i < count; ++i)
+    { offsets[(pSrc[i].Key >> shift) & RadixMask]++; }
+
+    uint32_t sum = 0;
+    for (auto d = 0u; d < RadixSize; ++d)
+    {
+        auto n = offsets[d];
+        offsets[d] = sum;
+        sum += n;
+    }
+
+    for (size_t i = 0; i < count; ++i)
+    { pDst[offsets[(pSrc[i].Key >> shift) & RadixMask]++] = pSrc[i]; }
+}
+
+} // namespace
+
+
+//-----------------------------------------------------------------------------
+//      ビュー空間の深度をソートキー用に量子化します.
+//-----------------------------------------------------------------------------
+uint32_t QuantizeDrawDepth(float viewDepth)
+{
+    // NaN と負の値は0にする.
+    if (!(viewDepth > 0.0f))
+    { return 0; }
+
+    uint32_t bits;
+    memcpy(&bits, &viewDepth, sizeof(bits));
+
+    // 符号ビットは常に0なので, 残り31ビットの上位を使う.
+    return uint32_t((bits >> (31 - DRAW_KEY_DEPTH_BITS)) & DepthMask);
+}
+
+//-----------------------------------------------------------------------------
+//      描画のソートキーを作ります.
+//-----------------------------------------------------------------------------
+uint64_t MakeDrawKey
+(
+    DRAW_ORDER  order,
+    uint32_t    pass,
+    uint32_t    pipeline,
+    uint32_t    material,
+    float       viewDepth,
+    uint32_t    sub
+)
+{
+    auto depth = uint64_t(QuantizeDrawDepth(viewDepth));
+    auto key   = ((uint64_t(pass) & PassMask) << PassShift) | (uint64_t(sub) & SubMask);
+
+    switch (order)
+    {
+    case DRAW_ORDER_FRONT_TO_BACK:
+        key |= (uint64_t(pipeline) & PipelineMask) << FrontPipelineShift;
+        key |= depth                               << FrontDepthShift;
+        key |= (uint64_t(material) & MaterialMask) << FrontMaterialShift;
+        break;
+
+    case DRAW_ORDER_BACK_TO_FRONT:
+        key |= (~depth & DepthMask)                << BackDepthShift;
+        key |= (uint64_t(pipeline) & PipelineMask) << BackPipelineShift;
+        key |= (uint64_t(material) & MaterialMask) << BackMaterialShift;
+        break;
+
+    default:
+        key |= (uint64_t(pipeline) & PipelineMask) << StatePipelineShift;
+        key |= (uint64_t(material) & MaterialMask) << StateMaterialShift;
+        key |= depth                               << StateDepthShift;
+        break;
+    }
+
+    return key;
+}
+
+//-----------------------------------------------------------------------------
+//      ソートキーからパス番号を取り出します.
+//-----------------------------------------------------------------------------
+uint32_t GetDrawKeyPass(uint64_t key)
+{ return uint32_t(key >> PassShift); }
+
+//-----------------------------------------------------------------------------
+//      ソートキーからパイプライン番号を取り出します.
+//-----------------------------------------------------------------------------
+uint32_t GetDrawKeyPipeline(DRAW_ORDER order, uint64_t key)
+{
+    auto shift = (order == DRAW_ORDER_FRONT_TO_BACK) ? FrontPipelineShift
+               : (order == DRAW_ORDER_BACK_TO_FRONT) ? BackPipelineShift
+               : StatePipelineShift;
+    return uint32_t((key >> shift) & PipelineMask);
+}
+
+//-----------------------------------------------------------------------------
+//      ソートキーからマテリアル番号を取り出します.
+//-----------------------------------------------------------------------------
+uint32_t GetDrawKeyMaterial(DRAW_ORDER order, uint64_t key)
+{
+    auto shift = (order == DRAW_ORDER_FRONT_TO_BACK) ? FrontMaterialShift
+               : (order == DRAW_ORDER_BACK_TO_FRONT) ? BackMaterialShift
+               : StateMaterialShift;
+    return uint32_t((key >> shift) & MaterialMask);
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// DrawList class
+///////////////////////////////////////////////////////////////////////////////
+
+//-----------------------------------------------------------------------------
+//      コンストラクタです.
+//-----------------------------------------------------------------------------
+DrawList::DrawList()
+{ /* DO_NOTHING */ }
+
+//-----------------------------------------------------------------------------
+//      デストラクタです.
+//-----------------------------------------------------------------------------
+DrawList::~DrawList()
+{ /* DO_NOTHING */ }
+
+//-----------------------------------------------------------------------------
+//      パケットを空にします.
+//-----------------------------------------------------------------------------
+void DrawList::Clear()
+{ m_Packets.clear(); }
+
+//-----------------------------------------------------------------------------
+//      パケットのメモリを予約します.
+//-----------------------------------------------------------------------------
+void DrawList::Reserve(size_t count)
+{
+    m_Packets.reserve(count);
+    m_Temp   .reserve(count);
+}
+
+//-----------------------------------------------------------------------------
+//      パケットを追加します.
+//-----------------------------------------------------------------------------
+void DrawList::Push(uint64_t key, uint32_t index)
+{ m_Packets.push_back({ key, index, 0 }); }
+
+//-----------------------------------------------------------------------------
+//      キーの昇順に並べ替えます.
+//-----------------------------------------------------------------------------
+void DrawList::Sort(uint32_t threadCount)
+{
+    auto count = m_Packets.size();
+    if (count < 2)
+    { return; }
+
+    if (threadCount == 0)
+    {
+        threadCount = (count >= ParallelThreshold)
+            ? std::max(1u, std::thread::hardware_concurrency())
+            : 1u;
+    }
+
+    // 1スレッドあたりの量が少なすぎると同期の方が高くつく.
+    auto maxThreads = uint32_t((count + MinChunkSize - 1) / MinChunkSize);
+    threadCount = std::max(1u, std::min(threadCount, maxThreads));
+
+    m_Temp.resize(count);
+
+    auto pPackets  = m_Packets.data();
+    auto pTemp     = m_Temp.data();
+    auto reference = pPackets[0].Key;
+    auto passCount = 0u;
+
+    if (threadCount == 1)
+    {
+        auto varying = FindVaryingBits(pPackets, 0, count, reference);
+
+        auto pSrc = pPackets;
+        auto pDst = pTemp;
+        for (auto shift = 0u; shift < 64; shift += RadixBits)
+        {
+            // 全パケットで同じ桁は並べ替える必要がない.
+            if (((varying >> shift) & RadixMask) == 0)
+            { continue; }
+
+            RadixPass(pSrc, pDst, count, shift);
+            std::swap(pSrc, pDst);
+            passCount++;
+        }
+    }
+    else
+    {
+        std::vector<uint64_t> varyings(threadCount, 0);
+        std::vector<uint32_t> histograms(size_t(threadCount) * RadixSize);
+        SpinBarrier barrier(threadCount);
+
+        auto worker = [&](uint32_t threadIndex)
+        {
+            auto begin = count * threadIndex / threadCount;
+            auto end   = count * (threadIndex + 1) / threadCount;
+
+            varyings[threadIndex] = FindVaryingBits(pPackets, begin, end, reference);
+            barrier.Wait();
+
+            uint64_t varying = 0;
+            for (auto v : varyings)
+            { varying |= v; }
+
+            auto pSrc   = pPackets;
+            auto pDst   = pTemp;
+            auto pLocal = histograms.data() + size_t(threadIndex) * RadixSize;
+
+            for (auto shift = 0u; shift < 64; shift += RadixBits)
+            {
+                if (((varying >> shift) & RadixMask) == 0)
+                { continue; }
+
+                // 受け持ち範囲のヒストグラム.
+                memset(pLocal, 0, sizeof(uint32_t) * RadixSize);
+                for (auto i = begin; i < end; ++i)
+                { pLocal[(pSrc[i].Key >> shift) & RadixMask]++; }
+                barrier.Wait();
+
+                // 桁ごとに, 前の桁の合計と前のスレッドの同じ桁の数を足した位置から書き込む(安定).
+                uint32_t offsets[RadixSize];
+                uint32_t sum = 0;
+                for (auto d = 0u; d < RadixSize; ++d)
+                {
+                    offsets[d] = sum;
+                    for (auto t = 0u; t < threadCount; ++t)
+                    {
+                        auto n = histograms[size_t(t) * RadixSize + d];
+                        if (t < threadIndex)
+                        { offsets[d] += n; }
+                        sum += n;
+                    }
+                }
+
+                for (auto i = begin; i < end; ++i)
+                { pDst[offsets[(pSrc[i].Key >> shift) & RadixMask]++] = pSrc[i]; }
+                barrier.Wait();
+
+                std::swap(pSrc, pDst);
+                if (threadIndex == 0)
+                { passCount++; }
+            }
+        };
+
+        std::vector<std::thread> threads;
+        threads.reserve(threadCount - 1);
+        for (auto i = 1u; i < threadCount; ++i)
+        { threads.emplace_back(worker, i); }
+
+        worker(0);
+
+        for (auto& thread : threads)
+        { thread.join(); }
+    }
+
+    // 走査回数が奇数なら結果は作業領域にある.
+    if (passCount & 0x1)
+    { m_Packets.swap(m_Temp); }
+}
+
+//-----------------------------------------------------------------------------
+//      キーの昇順に並んでいるかどうかチェックします.
+//-----------------------------------------------------------------------------
+bool DrawList::IsSorted() const
+{
+    for (size_t i = 1; i < m_Packets.size(); ++i)
+    {
+        if (m_Packets[i - 1].Key > m_Packets[i].Key)
+        { return false; }
+    }
+
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+//      パケット数を取得します.
+//-----------------------------------------------------------------------------
+size_t DrawList::GetCount() const
+{ return m_Packets.size(); }
+
+//-----------------------------------------------------------------------------
+//      パケットを取得します.
+//-----------------------------------------------------------------------------
+const DrawPacket* DrawList::GetPackets() const
+{ return m_Packets.data(); }
@@ -0,0 +1,198 @@
+﻿//-----------------------------------------------------------------------------
+// File : DynamicResolution.cpp
+// Desc : GPU Time Driven Dynamic Resolution Controller.
+// Copyright(c) Pocol. All right reserved.
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------
+#include "DynamicResolution.h"
+#include <cmath>
+
+
+namespace {
+
+//-----------------------------------------------------------------------------
+// Constant Values.
+//-----------------------------------------------------------------------------
+constexpr uint32_t  MinRenderSize   = 8;        // 描画サイズの下限.
+constexpr float     QuantizeEpsilon = 1e-4f;    // 刻み幅ちょうどの値が切り捨てられないための余裕.
+
+} // namespace
+
+
+///////////////////////////////////////////////////////////////////////////////
+// DynamicResolution class
+///////////////////////////////////////////////////////////////////////////////
+
+//-----------------------------------------------------------------------------
+//      コンストラクタです.
+//-----------------------------------------------------------------------------
+DynamicResolution::DynamicResolution()
+{ Reset(); }
+
+//-----------------------------------------------------------------------------
+//      デストラクタです.
+//-----------------------------------------------------------------------------
+DynamicResolution::~DynamicResolution()
+{ /* DO_NOTHING */ }
+
+//-----------------------------------------------------------------------------
+//      状態をリセットし, 拡大率を上限に戻します.
+//-----------------------------------------------------------------------------
+void DynamicResolution::Reset()
+{
+    m_Scale       = Quantize(m_Settings.MaxScale);
+    m_FilteredMs  = -1.0f;
+    m_SkipCount   = 0;
+    m_UnderCount  = 0;
+    m_ChangeCount = 0;
+}
+
+//-----------------------------------------------------------------------------
+//      計測したGPUフレーム時間から拡大率を更新します.
+//-----------------------------------------------------------------------------
+float DynamicResolution::Update(float gpuMs)
+{
+    if (!m_Settings.Enable)
+    {
+        m_Scale = Quantize(m_Settings.MaxScale);
+        return m_Scale;
+    }
+
+    if (!(gpuMs > 0.0f) || m_Settings.TargetMs <= 0.0f)
+    { return m_Scale; }
+
+    // 変更前の解像度で描いたフレームの計測値は使わない.
+    if (m_SkipCount > 0)
+    {
+        m_SkipCount--;
+        return m_Scale;
+    }
+
+    if (m_FilteredMs < 0.0f)
+    { m_FilteredMs = gpuMs; }
+    else
+    {
+        // 単発のヒッチ(PSOの生成やストリーミング)で平均が跳ねないよう抑える.
+        // 負荷が本当に増えた場合も, 数フレームで平均が追いつく.
+        if (m_Settings.OutlierRatio > 0.0f && gpuMs > m_FilteredMs * m_Settings.OutlierRatio)
+        { gpuMs = m_FilteredMs * m_Settings.OutlierRatio; }
+
+        m_FilteredMs += (gpuMs - m_FilteredMs) * m_Settings.Smoothing;
+    }
+
+    // 画素数に比例するとして, 予算に収まる拡大率を求める.
+    auto budget = m_Settings.TargetMs * m_Settings.Headroom;
+    auto ideal  = m_Scale * std::sqrt(budget / m_FilteredMs);
+    auto scale  = m_Scale;
+
+    if (m_FilteredMs > m_Settings.TargetMs)
+    {
+        // 予算超過は直ちに下げる.
+        m_UnderCount = 0;
+        scale = Quantize(ideal);
+        if (scale >= m_Scale)
+        { scale = Quantize(m_Scale - m_Settings.ScaleStep); }
+    }
+    else if (m_FilteredMs < budget)
+    {
+        // 余裕が続いたときだけ1段ずつ上げる.
+        m_UnderCount++;
+        if (m_UnderCount >= m_Settings.IncreaseDelay)
+        {
+            auto next = Quantize(m_Scale + m_Settings.ScaleStep);
+            scale = (Quantize(ideal) < next) ? Quantize(ideal) : next;
+        }
+    }
+    else
+    {
+        // 予算内で余裕も無いので維持する.
+        m_UnderCount = 0;
+    }
+
+    if (scale != m_Scale)
+    {
+        // 平均値も新しい解像度の見込みに合わせておく.
+        auto ratio = scale / m_Scale;
+        m_FilteredMs *= ratio * ratio;
+        m_Scale       = scale;
+        m_SkipCount   = m_Settings.Latency;
+        m_UnderCount  = 0;
+        m_ChangeCount++;
+    }
+
+    return m_Scale;
+}
+
+//-----------------------------------------------------------------------------
+//      現在の拡大率を取得します.
+//-----------------------------------------------------------------------------
+float DynamicResolution::GetScale() const
+{ return m_Scale; }
+
+//-----------------------------------------------------------------------------
+//      平滑化したGPUフレーム時間[ms]を取得します.
+//-----------------------------------------------------------------------------
+float DynamicResolution::GetFilteredMs() const
+{ return (m_FilteredMs < 0.0f) ? 0.0f : m_FilteredMs; }
+
+//-----------------------------------------------------------------------------
+//      拡大率を変更した回数を取得します.
+//-----------------------------------------------------------------------------
+uint32_t DynamicResolution::GetChangeCount() const
+{ return m_ChangeCount; }
+
+//-----------------------------------------------------------------------------
+//      最大サイズに拡大率を掛けた描画サイズを求めます.
+//-----------------------------------------------------------------------------
+void DynamicResolution::GetRenderSize(uint32_t maxWidth, uint32_t maxHeight, uint32_t& width, uint32_t& height) const
+{
+    width  = uint32_t(float(maxWidth)  * m_Scale + 0.5f);
+    height = uint32_t(float(maxHeight) * m_Scale + 0.5f);
+
+    if (width < MinRenderSize)
+    { width = (maxWidth < MinRenderSize) ? maxWidth : MinRenderSize; }
+    if (height < MinRenderSize)
+    { height = (maxHeight < MinRenderSize) ? maxHeight : MinRenderSize; }
+
+    if (width > maxWidth)
+    { width = maxWidth; }
+    if (height > maxHeight)
+    { height = maxHeight; }
+}
+
+//-----------------------------------------------------------------------------
+//      シャープ化の強さを取得します(拡大しないときは0).
+//-----------------------------------------------------------------------------
+float DynamicResolution::GetSharpness() const
+{ return (m_Scale < 1.0f) ? m_Settings.Sharpness : 0.0f; }
+
+//-----------------------------------------------------------------------------
+//      設定を取得します.
+//-----------------------------------------------------------------------------
+DynamicResolutionSettings& DynamicResolution::GetSettings()
+{ return m_Settings; }
+
+//-----------------------------------------------------------------------------
+//      設定を取得します.
+//-----------------------------------------------------------------------------
+const DynamicResolutionSettings& DynamicResolution::GetSettings() const
+{ return m_Settings; }
+
+//-----------------------------------------------------------------------------
+//      拡大率を刻み幅に切り捨て, 範囲に収めます.
+//-----------------------------------------------------------------------------
+float DynamicResolution::Quantize(float scale) const
+{
+    if (m_Settings.ScaleStep > 0.0f)
+    { scale = std::floor(scale / m_Settings.ScaleStep + QuantizeEpsilon) * m_Settings.ScaleStep; }
+
+    if (scale < m_Settings.MinScale)
+    { scale = m_Settings.MinScale; }
+    if (scale > m_Settings.MaxScale)
+    { scale = m_Settings.MaxScale; }
+
+    return scale;
+}
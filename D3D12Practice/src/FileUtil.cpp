@@ -1,5 +1,54 @@
 ﻿#include "FileUtil.h"
 
+namespace {
+	VirtualFileSystem g_FileSystem; // 検索パスの索引
+
+	// 実行ファイルのディレクトリを取得する
+	std::wstring GetExeDirectory() {
+		wchar_t exePath[520] = {};
+		GetModuleFileNameW(nullptr, exePath, 520);
+
+		exePath[519] = L'\0'; // null終端化.
+		PathRemoveFileSpecW(exePath);
+		return exePath;
+	}
+}
+
+bool MountSearchPaths(bool watch) {
+	// SearchFilePath が試すのと同じ順番でマウントする
+	const std::filesystem::path exeDir = GetExeDirectory();
+	const std::filesystem::path roots[] = {
+		L".",
+		L"..",
+		L"..\\..",
+		std::filesystem::current_path().root_path() / L"res",
+		exeDir,
+		exeDir / L"..",
+		exeDir / L"..\\..",
+		exeDir / L"res",
+	};
+
+	auto mounted = false;
+	for (auto& root : roots) {
+		mounted |= g_FileSystem.Mount(root);
+	}
+
+	if (mounted && watch) {
+		g_FileSystem.StartWatch();
+	}
+
+	return mounted;
+}
+
+void UnmountSearchPaths() {
+	g_FileSystem.StopWatch();
+	g_FileSystem.UnmountAll();
+}
+
+VirtualFileSystem& GetFileSystem() {
+	return g_FileSystem;
+}
+
 bool SearchFilePath(const wchar_t* filename, std::wstring& result) {
 	if (filename == nullptr) { 
 		return false; 
@@ -9,6 +58,12 @@ bool SearchFilePath(const wchar_t* filename, std::wstring& result) {
 		return false; 
 	}
 
+	// 索引があればファイルシステムに触れずに解決する
+	if (g_FileSystem.Resolve(filename, result)) {
+		return true;
+	}
+
+	// 索引の走査範囲外のファイルは従来通り探す
 	wchar_t exePath[520] = {};
 	GetModuleFileNameW(nullptr, exePath, 520);
 
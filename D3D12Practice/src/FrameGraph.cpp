@@ -0,0 +1,778 @@
+﻿//-----------------------------------------------------------------------------
+// File : FrameGraph.cpp
+// Desc : Frame Graph (Pass Culling, Ordering, Barriers and Transient Lifetimes).
+// Copyright(c) Pocol. All right reserved.
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------
+#include "FrameGraph.h"
+#include <algorithm>
+#include <cassert>
+#include <cstdio>
+
+
+namespace {
+
+///////////////////////////////////////////////////////////////////////////////
+// TimelineEntry structure
+///////////////////////////////////////////////////////////////////////////////
+struct TimelineEntry
+{
+    uint32_t    Order;      //!< 実行順です.
+    uint32_t    Usage;      //!< FRAME_USAGE です.
+    bool        Write;      //!< 書き込みかどうか.
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// PendingBarrier structure
+///////////////////////////////////////////////////////////////////////////////
+struct PendingBarrier
+{
+    uint32_t        Order;      //!< 発行する実行順です.
+    FrameBarrier    Barrier;    //!< バリアです.
+};
+
+//-----------------------------------------------------------------------------
+//      読み込み専用の状態かどうかチェックします.
+//-----------------------------------------------------------------------------
+inline bool IsReadOnly(uint32_t usage)
+{ return usage != FRAME_USAGE_NONE && (usage & ~uint32_t(FRAME_USAGE_READ_MASK)) == 0; }
+
+//-----------------------------------------------------------------------------
+//      アライメントを揃えます.
+//-----------------------------------------------------------------------------
+inline uint64_t AlignUp(uint64_t value, uint64_t alignment)
+{ return (value + alignment - 1) & ~(alignment - 1); }
+
+//-----------------------------------------------------------------------------
+//      寿命が重なるかどうかチェックします.
+//-----------------------------------------------------------------------------
+inline bool IsOverlapped(const FrameGraph::ResourceInfo& a, const FrameGraph::ResourceInfo& b)
+{ return a.FirstOrder <= b.LastOrder && b.FirstOrder <= a.LastOrder; }
+
+//-----------------------------------------------------------------------------
+//      メモリ範囲が重なるかどうかチェックします.
+//-----------------------------------------------------------------------------
+inline bool IsAliased(const FrameGraph::ResourceInfo& a, const FrameGraph::ResourceInfo& b)
+{
+    return a.HeapOffset < b.HeapOffset + b.Transient.Size
+        && b.HeapOffset < a.HeapOffset + a.Transient.Size;
+}
+
+} // namespace
+
+
+///////////////////////////////////////////////////////////////////////////////
+// FrameGraph class
+///////////////////////////////////////////////////////////////////////////////
+
+//-----------------------------------------------------------------------------
+//      コンストラクタです.
+//-----------------------------------------------------------------------------
+FrameGraph::FrameGraph()
+: m_Stats   ()
+, m_Compiled(false)
+{ /* DO_NOTHING */ }
+
+//-----------------------------------------------------------------------------
+//      デストラクタです.
+//-----------------------------------------------------------------------------
+FrameGraph::~FrameGraph()
+{ Clear(); }
+
+//-----------------------------------------------------------------------------
+//      外部のリソースを取り込みます.
+//-----------------------------------------------------------------------------
+FrameResourceId FrameGraph::Import(const char* name, uint32_t initialUsage, uint32_t finalUsage)
+{
+    ResourceInfo info = {};
+    info.Name           = (name != nullptr) ? name : "";
+    info.Imported       = true;
+    info.InitialUsage   = initialUsage;
+    info.FinalUsage     = finalUsage;
+    info.FirstOrder     = FRAME_GRAPH_INVALID_ID;
+    info.LastOrder      = FRAME_GRAPH_INVALID_ID;
+    info.EndUsage       = initialUsage;
+
+    m_Resources.push_back(info);
+    m_Compiled = false;
+
+    return FrameResourceId(m_Resources.size() - 1);
+}
+
+//-----------------------------------------------------------------------------
+//      一時リソースを宣言します.
+//-----------------------------------------------------------------------------
+FrameResourceId FrameGraph::Create(const char* name, const FrameTransientDesc& desc)
+{
+    ResourceInfo info = {};
+    info.Name           = (name != nullptr) ? name : "";
+    info.Imported       = false;
+    info.Transient      = desc;
+    info.FirstOrder     = FRAME_GRAPH_INVALID_ID;
+    info.LastOrder      = FRAME_GRAPH_INVALID_ID;
+
+    if (info.Transient.Alignment == 0)
+    { info.Transient.Alignment = 1; }
+
+    m_Resources.push_back(info);
+    m_Compiled = false;
+
+    return FrameResourceId(m_Resources.size() - 1);
+}
+
+//-----------------------------------------------------------------------------
+//      パスを追加します.
+//-----------------------------------------------------------------------------
+FramePassId FrameGraph::AddPass(const char* name, std::function<void()> func)
+{
+    Pass pass;
+    pass.Name       = (name != nullptr) ? name : "";
+    pass.Func       = std::move(func);
+    pass.SideEffect = false;
+    pass.Culled     = false;
+
+    m_Passes.push_back(std::move(pass));
+    m_Compiled = false;
+
+    return FramePassId(m_Passes.size() - 1);
+}
+
+//-----------------------------------------------------------------------------
+//      パスが読み込むリソースを宣言します.
+//-----------------------------------------------------------------------------
+void FrameGraph::Read(FramePassId pass, FrameResourceId resource, uint32_t usage)
+{
+    assert(pass < m_Passes.size());
+    assert((usage & ~uint32_t(FRAME_USAGE_READ_MASK)) == 0);
+
+    // 同じパスで複数回読むなら状態をまとめる.
+    auto& accesses = m_Passes[pass].Accesses;
+    for (auto& access : accesses)
+    {
+        if (access.Resource == resource)
+        {
+            if (!access.Write)
+            { access.Usage |= usage; }
+            return;
+        }
+    }
+
+    accesses.push_back({ resource, usage, false });
+    m_Compiled = false;
+}
+
+//-----------------------------------------------------------------------------
+//      パスが書き込むリソースを宣言します.
+//-----------------------------------------------------------------------------
+void FrameGraph::Write(FramePassId pass, FrameResourceId resource, uint32_t usage)
+{
+    assert(pass < m_Passes.size());
+
+    // 読み書きするなら書き込みとして扱う.
+    auto& accesses = m_Passes[pass].Accesses;
+    for (auto& access : accesses)
+    {
+        if (access.Resource == resource)
+        {
+            access.Usage = usage;
+            access.Write = true;
+            return;
+        }
+    }
+
+    accesses.push_back({ resource, usage, true });
+    m_Compiled = false;
+}
+
+//-----------------------------------------------------------------------------
+//      パスを除去しないようにします.
+//-----------------------------------------------------------------------------
+void FrameGraph::SetSideEffect(FramePassId pass)
+{
+    assert(pass < m_Passes.size());
+    m_Passes[pass].SideEffect = true;
+    m_Compiled = false;
+}
+
+//-----------------------------------------------------------------------------
+//      グラフをコンパイルします.
+//-----------------------------------------------------------------------------
+bool FrameGraph::Compile()
+{
+    m_Compiled = false;
+    m_Order.clear();
+    m_Barriers.clear();
+    m_BarrierOffsets.clear();
+    m_Stats = {};
+
+    // 不正なリソースIDと, 書き込まれる前の一時リソースの読み込みを検出.
+    {
+        std::vector<bool> written(m_Resources.size(), false);
+        for (auto& pass : m_Passes)
+        {
+            for (auto& access : pass.Accesses)
+            {
+                if (access.Resource >= m_Resources.size())
+                { return false; }
+
+                auto& res = m_Resources[access.Resource];
+                if (!res.Imported && !access.Write && !written[access.Resource])
+                { return false; }
+
+                if (access.Write)
+                { written[access.Resource] = true; }
+            }
+        }
+    }
+
+    BuildDependencies();
+    Cull();
+    Schedule();
+    AllocateTransients();
+    BuildBarriers();
+
+    m_Stats.PassCount    = uint32_t(m_Passes.size());
+    m_Stats.CulledCount  = uint32_t(m_Passes.size() - m_Order.size());
+    m_Stats.BarrierCount = uint32_t(m_Barriers.size());
+
+    m_Compiled = true;
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+//      コンパイル結果の順にパスを実行します.
+//-----------------------------------------------------------------------------
+void FrameGraph::Execute(const std::function<void(const FrameBarrier* pBarriers, uint32_t count)>& barrierFunc)
+{
+    if (!m_Compiled)
+    { return; }
+
+    for (auto i = 0u; i <= m_Order.size(); ++i)
+    {
+        uint32_t count = 0;
+        auto pBarriers = GetBarriers(i, count);
+        if (count > 0 && barrierFunc)
+        { barrierFunc(pBarriers, count); }
+
+        if (i == m_Order.size())
+        { break; }
+
+        auto& pass = m_Passes[m_Order[i]];
+        if (pass.Func)
+        { pass.Func(); }
+    }
+}
+
+//-----------------------------------------------------------------------------
+//      パスとリソースをすべて削除します.
+//-----------------------------------------------------------------------------
+void FrameGraph::Clear()
+{
+    m_Passes.clear();
+    m_Resources.clear();
+    m_Order.clear();
+    m_Barriers.clear();
+    m_BarrierOffsets.clear();
+    m_Stats    = {};
+    m_Compiled = false;
+}
+
+//-----------------------------------------------------------------------------
+//      実行順に並んだパスを取得します.
+//-----------------------------------------------------------------------------
+const std::vector<FramePassId>& FrameGraph::GetOrder() const
+{ return m_Order; }
+
+//-----------------------------------------------------------------------------
+//      パスの前に発行するバリアを取得します.
+//-----------------------------------------------------------------------------
+const FrameBarrier* FrameGraph::GetBarriers(uint32_t order, uint32_t& count) const
+{
+    if (!m_Compiled || order + 1 >= m_BarrierOffsets.size())
+    {
+        count = 0;
+        return nullptr;
+    }
+
+    auto begin = m_BarrierOffsets[order];
+    count = m_BarrierOffsets[order + 1] - begin;
+    return (count > 0) ? &m_Barriers[begin] : nullptr;
+}
+
+//-----------------------------------------------------------------------------
+//      パス名を取得します.
+//-----------------------------------------------------------------------------
+const std::string& FrameGraph::GetPassName(FramePassId pass) const
+{ return m_Passes[pass].Name; }
+
+//-----------------------------------------------------------------------------
+//      パスが除去されたかどうかチェックします.
+//-----------------------------------------------------------------------------
+bool FrameGraph::IsCulled(FramePassId pass) const
+{ return m_Passes[pass].Culled; }
+
+//-----------------------------------------------------------------------------
+//      リソースの情報を取得します.
+//-----------------------------------------------------------------------------
+const FrameGraph::ResourceInfo& FrameGraph::GetResource(FrameResourceId resource) const
+{ return m_Resources[resource]; }
+
+//-----------------------------------------------------------------------------
+//      コンパイル結果の統計を取得します.
+//-----------------------------------------------------------------------------
+const FrameGraph::CompileStats& FrameGraph::GetStats() const
+{ return m_Stats; }
+
+//-----------------------------------------------------------------------------
+//      コンパイル結果のレポートを作成します.
+//-----------------------------------------------------------------------------
+std::string FrameGraph::FormatReport() const
+{
+    std::string result;
+    char line[256];
+
+    snprintf(line, sizeof(line), "Frame Graph : %u passes, %u culled, %u barriers, transient %llu bytes -> heap %llu bytes\n",
+        m_Stats.PassCount,
+        m_Stats.CulledCount,
+        m_Stats.BarrierCount,
+        static_cast<unsigned long long>(m_Stats.TransientBytes),
+        static_cast<unsigned long long>(m_Stats.HeapBytes));
+    result += line;
+
+    for (auto i = 0u; i < m_Order.size(); ++i)
+    {
+        uint32_t count = 0;
+        GetBarriers(i, count);
+        snprintf(line, sizeof(line), "    %3u : %-24s %u barriers\n", i, m_Passes[m_Order[i]].Name.c_str(), count);
+        result += line;
+    }
+
+    for (auto& pass : m_Passes)
+    {
+        if (!pass.Culled)
+        { continue; }
+
+        snprintf(line, sizeof(line), "    --- : %-24s culled\n", pass.Name.c_str());
+        result += line;
+    }
+
+    for (auto& res : m_Resources)
+    {
+        if (res.Imported || res.FirstOrder == FRAME_GRAPH_INVALID_ID)
+        { continue; }
+
+        snprintf(line, sizeof(line), "    transient %-20s [%u, %u] offset %llu size %llu\n",
+            res.Name.c_str(),
+            res.FirstOrder,
+            res.LastOrder,
+            static_cast<unsigned long long>(res.HeapOffset),
+            static_cast<unsigned long long>(res.Transient.Size));
+        result += line;
+    }
+
+    return result;
+}
+
+//-----------------------------------------------------------------------------
+//      アクセスの宣言順から依存関係を構築します.
+//-----------------------------------------------------------------------------
+void FrameGraph::BuildDependencies()
+{
+    std::vector<FramePassId>                lastWriter(m_Resources.size(), FRAME_GRAPH_INVALID_ID);
+    std::vector<std::vector<FramePassId>>   readers   (m_Resources.size());
+
+    for (auto i = 0u; i < m_Passes.size(); ++i)
+    {
+        auto& pass = m_Passes[i];
+        pass.Dependencies.clear();
+        pass.Culled = false;
+
+        for (auto& access : pass.Accesses)
+        {
+            auto r = access.Resource;
+
+            // 書き込みの後の読み込み, 書き込みの後の書き込み.
+            if (lastWriter[r] != FRAME_GRAPH_INVALID_ID)
+            { pass.Dependencies.push_back(lastWriter[r]); }
+
+            if (access.Write)
+            {
+                // 読み込みの後の書き込み.
+                for (auto reader : readers[r])
+                {
+                    if (reader != i)
+                    { pass.Dependencies.push_back(reader); }
+                }
+
+                lastWriter[r] = i;
+                readers[r].clear();
+            }
+            else
+            {
+                readers[r].push_back(i);
+            }
+        }
+
+        std::sort(pass.Dependencies.begin(), pass.Dependencies.end());
+        pass.Dependencies.erase(
+            std::unique(pass.Dependencies.begin(), pass.Dependencies.end()),
+            pass.Dependencies.end());
+    }
+}
+
+//-----------------------------------------------------------------------------
+//      出力に寄与しないパスを除去します.
+//-----------------------------------------------------------------------------
+void FrameGraph::Cull()
+{
+    // 各リソースを最後に書き込んだパスと, 読み込みごとにその内容を書いたパスを求める.
+    // 読み込みの後の書き込みは順序だけの依存なので, 生存判定には使わない.
+    std::vector<std::vector<FramePassId>>   producers (m_Passes.size());
+    std::vector<FramePassId>                lastWriter(m_Resources.size(), FRAME_GRAPH_INVALID_ID);
+    std::vector<FramePassId>                stack;
+
+    for (auto i = 0u; i < m_Passes.size(); ++i)
+    {
+        auto& pass = m_Passes[i];
+        auto  root = pass.SideEffect;
+
+        for (auto& access : pass.Accesses)
+        {
+            auto  r   = access.Resource;
+            auto& res = m_Resources[r];
+
+            if (lastWriter[r] != FRAME_GRAPH_INVALID_ID)
+            { producers[i].push_back(lastWriter[r]); }
+
+            if (access.Write)
+            {
+                lastWriter[r] = i;
+                if (res.Imported && res.FinalUsage != FRAME_USAGE_NONE)
+                { root = true; }
+            }
+        }
+
+        pass.Culled = true;
+        if (root)
+        { stack.push_back(i); }
+    }
+
+    while (!stack.empty())
+    {
+        auto i = stack.back();
+        stack.pop_back();
+
+        if (!m_Passes[i].Culled)
+        { continue; }
+
+        m_Passes[i].Culled = false;
+        for (auto producer : producers[i])
+        {
+            if (m_Passes[producer].Culled)
+            { stack.push_back(producer); }
+        }
+    }
+}
+
+//-----------------------------------------------------------------------------
+//      実行順を決定します.
+//-----------------------------------------------------------------------------
+void FrameGraph::Schedule()
+{
+    auto count = uint32_t(m_Passes.size());
+
+    std::vector<uint32_t>                   remaining (count, 0);
+    std::vector<std::vector<FramePassId>>   dependents(count);
+    std::vector<uint32_t>                   stamp     (count, FRAME_GRAPH_INVALID_ID);
+    std::vector<FramePassId>                ready;
+
+    for (auto i = 0u; i < count; ++i)
+    {
+        if (m_Passes[i].Culled)
+        { continue; }
+
+        for (auto dep : m_Passes[i].Dependencies)
+        {
+            if (m_Passes[dep].Culled)
+            { continue; }
+
+            remaining[i]++;
+            dependents[dep].push_back(i);
+        }
+
+        if (remaining[i] == 0)
+        { ready.push_back(i); }
+    }
+
+    m_Order.reserve(count);
+
+    // 実行可能なパスのうち, 直前のパスに依存しないものを優先してバリアによる待ちを離す.
+    // 同じ条件なら宣言順を優先して結果を決定的にする.
+    while (!ready.empty())
+    {
+        auto best = size_t(0);
+        for (size_t j = 1; j < ready.size(); ++j)
+        {
+            auto candidate = ready[j];
+            auto current   = ready[best];
+            auto candidateStalls = (stamp[candidate] == m_Order.size());
+            auto currentStalls   = (stamp[current]   == m_Order.size());
+
+            if (candidateStalls != currentStalls)
+            {
+                if (!candidateStalls)
+                { best = j; }
+            }
+            else if (candidate < current)
+            {
+                best = j;
+            }
+        }
+
+        auto pass = ready[best];
+        ready[best] = ready.back();
+        ready.pop_back();
+
+        m_Order.push_back(pass);
+
+        // 次の実行順で「直前のパスに依存する」印を付ける.
+        auto next = uint32_t(m_Order.size());
+        for (auto dependent : dependents[pass])
+        {
+            stamp[dependent] = next;
+            if (--remaining[dependent] == 0)
+            { ready.push_back(dependent); }
+        }
+    }
+
+    // 依存関係は常に宣言順の前から後ろへ向かうので循環しない.
+    assert(m_Order.size() == count - size_t(std::count_if(m_Passes.begin(), m_Passes.end(), [](const Pass& pass) { return pass.Culled; })));
+}
+
+//-----------------------------------------------------------------------------
+//      一時リソースの寿命を求め, メモリを配置します.
+//-----------------------------------------------------------------------------
+void FrameGraph::AllocateTransients()
+{
+    for (auto& res : m_Resources)
+    {
+        res.FirstOrder = FRAME_GRAPH_INVALID_ID;
+        res.LastOrder  = FRAME_GRAPH_INVALID_ID;
+        res.HeapOffset = 0;
+    }
+
+    for (auto i = 0u; i < m_Order.size(); ++i)
+    {
+        for (auto& access : m_Passes[m_Order[i]].Accesses)
+        {
+            auto& res = m_Resources[access.Resource];
+            if (res.FirstOrder == FRAME_GRAPH_INVALID_ID)
+            {
+                res.FirstOrder = i;
+
+                // 一時リソースは最初に使う状態で始まり, フレームの最後にその状態へ戻す.
+                if (!res.Imported)
+                {
+                    res.InitialUsage = access.Usage;
+                    res.FinalUsage   = access.Usage;
+                }
+            }
+            res.LastOrder = i;
+        }
+    }
+
+    // 大きいものから順に, 寿命の重なるリソースと被らない最も低いアドレスに置く.
+    std::vector<FrameResourceId> transients;
+    for (auto i = 0u; i < m_Resources.size(); ++i)
+    {
+        auto& res = m_Resources[i];
+        if (!res.Imported && res.FirstOrder != FRAME_GRAPH_INVALID_ID)
+        { transients.push_back(i); }
+    }
+
+    std::sort(transients.begin(), transients.end(), [&](FrameResourceId a, FrameResourceId b)
+    {
+        auto sizeA = m_Resources[a].Transient.Size;
+        auto sizeB = m_Resources[b].Transient.Size;
+        return (sizeA != sizeB) ? (sizeA > sizeB) : (a < b);
+    });
+
+    std::vector<FrameResourceId> placed;
+    std::vector<FrameResourceId> conflicts;
+    placed.reserve(transients.size());
+
+    for (auto id : transients)
+    {
+        auto& res = m_Resources[id];
+
+        conflicts.clear();
+        for (auto other : placed)
+        {
+            if (IsOverlapped(res, m_Resources[other]))
+            { conflicts.push_back(other); }
+        }
+
+        std::sort(conflicts.begin(), conflicts.end(), [&](FrameResourceId a, FrameResourceId b)
+        { return m_Resources[a].HeapOffset < m_Resources[b].HeapOffset; });
+
+        uint64_t offset = 0;
+        for (auto other : conflicts)
+        {
+            auto& o = m_Resources[other];
+            if (AlignUp(offset, res.Transient.Alignment) + res.Transient.Size <= o.HeapOffset)
+            { break; }
+
+            offset = std::max(offset, o.HeapOffset + o.Transient.Size);
+        }
+
+        res.HeapOffset = AlignUp(offset, res.Transient.Alignment);
+        placed.push_back(id);
+
+        m_Stats.TransientBytes += res.Transient.Size;
+        m_Stats.HeapBytes = std::max(m_Stats.HeapBytes, res.HeapOffset + res.Transient.Size);
+    }
+}
+
+//-----------------------------------------------------------------------------
+//      バリアを導出します.
+//-----------------------------------------------------------------------------
+void FrameGraph::BuildBarriers()
+{
+    auto end = uint32_t(m_Order.size());
+
+    // リソースごとのアクセスを実行順に並べる.
+    std::vector<std::vector<TimelineEntry>> timelines(m_Resources.size());
+    for (auto i = 0u; i < end; ++i)
+    {
+        for (auto& access : m_Passes[m_Order[i]].Accesses)
+        { timelines[access.Resource].push_back({ i, access.Usage, access.Write }); }
+    }
+
+    std::vector<PendingBarrier> pending;
+
+    for (auto r = 0u; r < m_Resources.size(); ++r)
+    {
+        auto& res      = m_Resources[r];
+        auto& timeline = timelines[r];
+        if (timeline.empty())
+        {
+            res.EndUsage = res.InitialUsage;
+            continue;
+        }
+
+        // 同じメモリを先に使い終えた一時リソースからの切り替え.
+        if (!res.Imported)
+        {
+            auto previous = FRAME_GRAPH_INVALID_ID;
+            auto found    = 0u;
+            for (auto o = 0u; o < m_Resources.size(); ++o)
+            {
+                auto& other = m_Resources[o];
+                if (o == r || other.Imported || other.FirstOrder == FRAME_GRAPH_INVALID_ID)
+                { continue; }
+
+                if (other.LastOrder < res.FirstOrder && IsAliased(res, other))
+                {
+                    previous = o;
+                    found++;
+                }
+            }
+
+            if (found > 0)
+            {
+                FrameBarrier barrier = {};
+                barrier.Type     = FRAME_BARRIER_ALIASING;
+                barrier.Resource = r;
+                barrier.Previous = (found == 1) ? previous : FRAME_GRAPH_INVALID_ID;
+                pending.push_back({ res.FirstOrder, barrier });
+            }
+        }
+
+        auto state = res.InitialUsage;
+        for (size_t k = 0; k < timeline.size(); ++k)
+        {
+            auto& entry = timeline[k];
+            auto  usage = entry.Usage;
+
+            if (!entry.Write)
+            {
+                // 既に読める状態なら何もしない.
+                if (IsReadOnly(state) && (state & usage) == usage)
+                { continue; }
+
+                // 次の書き込みまでの読み込みをまとめて1回で遷移する.
+                for (auto n = k + 1; n < timeline.size() && !timeline[n].Write; ++n)
+                { usage |= timeline[n].Usage; }
+            }
+            else if (state == usage)
+            {
+                // UAVへの書き込みが続くときは同期だけ取る.
+                if (usage == FRAME_USAGE_UNORDERED_ACCESS && k > 0)
+                {
+                    FrameBarrier barrier = {};
+                    barrier.Type     = FRAME_BARRIER_UAV;
+                    barrier.Resource = r;
+                    barrier.Previous = FRAME_GRAPH_INVALID_ID;
+                    barrier.Before   = state;
+                    barrier.After    = usage;
+                    pending.push_back({ entry.Order, barrier });
+                }
+                continue;
+            }
+
+            if (state != FRAME_USAGE_NONE && state != usage)
+            {
+                FrameBarrier barrier = {};
+                barrier.Type     = FRAME_BARRIER_TRANSITION;
+                barrier.Resource = r;
+                barrier.Previous = FRAME_GRAPH_INVALID_ID;
+                barrier.Before   = state;
+                barrier.After    = usage;
+                pending.push_back({ entry.Order, barrier });
+            }
+
+            state = usage;
+        }
+
+        if (res.FinalUsage != FRAME_USAGE_NONE && state != res.FinalUsage)
+        {
+            FrameBarrier barrier = {};
+            barrier.Type     = FRAME_BARRIER_TRANSITION;
+            barrier.Resource = r;
+            barrier.Previous = FRAME_GRAPH_INVALID_ID;
+            barrier.Before   = state;
+            barrier.After    = res.FinalUsage;
+            pending.push_back({ end, barrier });
+
+            state = res.FinalUsage;
+        }
+
+        res.EndUsage = state;
+    }
+
+    // 実行順ごとにまとめる. エイリアシングは同じ実行順の遷移より先に発行する.
+    std::stable_sort(pending.begin(), pending.end(), [](const PendingBarrier& a, const PendingBarrier& b)
+    {
+        if (a.Order != b.Order)
+        { return a.Order < b.Order; }
+
+        auto aliasA = (a.Barrier.Type == FRAME_BARRIER_ALIASING);
+        auto aliasB = (b.Barrier.Type == FRAME_BARRIER_ALIASING);
+        return aliasA && !aliasB;
+    });
+
+    m_Barriers.reserve(pending.size());
+    m_BarrierOffsets.assign(end + 2, 0);
+
+    for (auto& item : pending)
+    {
+        m_Barriers.push_back(item.Barrier);
+        m_BarrierOffsets[item.Order + 1]++;
+    }
+
+    for (auto i = 1u; i < m_BarrierOffsets.size(); ++i)
+    { m_BarrierOffsets[i] += m_BarrierOffsets[i - 1]; }
+}
@@ -0,0 +1,170 @@
+﻿//-----------------------------------------------------------------------------
+// File : FramePacer.cpp
+// Desc : Frame Pacing For Low-Latency Presentation.
+// Copyright(c) Pocol. All right reserved.
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------
+#include "FramePacer.h"
+
+
+namespace {
+
+//-----------------------------------------------------------------------------
+// Constant Values.
+//-----------------------------------------------------------------------------
+constexpr double LatencySmoothing = 0.1;    // 遅延の指数移動平均の係数.
+
+} // namespace
+
+
+///////////////////////////////////////////////////////////////////////////////
+// FramePacer class
+///////////////////////////////////////////////////////////////////////////////
+
+//-----------------------------------------------------------------------------
+//      コンストラクタです.
+//-----------------------------------------------------------------------------
+FramePacer::FramePacer()
+{ Init(LATENCY_MODE_VSYNC, DefaultMaxLatency, false); }
+
+//-----------------------------------------------------------------------------
+//      デストラクタです.
+//-----------------------------------------------------------------------------
+FramePacer::~FramePacer()
+{ /* DO_NOTHING */ }
+
+//-----------------------------------------------------------------------------
+//      設定して記録を破棄します.
+//-----------------------------------------------------------------------------
+void FramePacer::Init(LATENCY_MODE mode, uint32_t maxLatency, bool tearingSupported)
+{
+    m_Mode              = mode;
+    m_MaxLatency        = (maxLatency < 1) ? 1 : (maxLatency > MaxLatencyLimit) ? MaxLatencyLimit : maxLatency;
+    m_TearingSupported  = tearingSupported;
+    m_Debt              = 0;
+    m_TimeoutCount      = 0;
+    m_LastDisplayedId   = 0;
+    m_HasDisplayed      = false;
+    m_LatencyMs         = 0.0;
+
+    for (auto& frame : m_Frames)
+    {
+        frame.PresentId = 0;
+        frame.BeginMs   = 0.0;
+        frame.Valid     = false;
+    }
+}
+
+//-----------------------------------------------------------------------------
+//      遅延モードを取得します.
+//-----------------------------------------------------------------------------
+LATENCY_MODE FramePacer::GetMode() const
+{ return m_Mode; }
+
+//-----------------------------------------------------------------------------
+//      最大遅延フレーム数を取得します.
+//-----------------------------------------------------------------------------
+uint32_t FramePacer::GetMaxLatency() const
+{ return m_MaxLatency; }
+
+//-----------------------------------------------------------------------------
+//      待機可能オブジェクトを使うかどうか.
+//-----------------------------------------------------------------------------
+bool FramePacer::UseWaitableObject() const
+{ return m_Mode != LATENCY_MODE_VSYNC; }
+
+//-----------------------------------------------------------------------------
+//      スワップチェインをティアリング可能として生成するかどうか.
+//-----------------------------------------------------------------------------
+bool FramePacer::AllowTearing() const
+{ return m_Mode == LATENCY_MODE_UNCAPPED && m_TearingSupported; }
+
+//-----------------------------------------------------------------------------
+//      表示の同期間隔を取得します.
+//-----------------------------------------------------------------------------
+uint32_t FramePacer::GetSyncInterval() const
+{ return (m_Mode == LATENCY_MODE_UNCAPPED) ? 0 : 1; }
+
+//-----------------------------------------------------------------------------
+//      表示時にティアリングを要求するかどうか.
+//-----------------------------------------------------------------------------
+bool FramePacer::UseTearing(bool fullscreen) const
+{
+    // ティアリングは同期間隔が0のウィンドウモード(ボーダーレスを含む)でだけ要求できる.
+    return AllowTearing() && GetSyncInterval() == 0 && !fullscreen;
+}
+
+//-----------------------------------------------------------------------------
+//      このフレームで待機可能オブジェクトを待つ回数を取得します.
+//-----------------------------------------------------------------------------
+uint32_t FramePacer::GetWaitCount() const
+{
+    if (!UseWaitableObject())
+    { return 0; }
+
+    return 1 + m_Debt;
+}
+
+//-----------------------------------------------------------------------------
+//      待機可能オブジェクトを待った結果を記録します.
+//-----------------------------------------------------------------------------
+void FramePacer::OnWaitResult(uint32_t signaled)
+{
+    // 待ちきれなかった分のシグナルは後で届き, 残ったままだと以降の待ちがすぐ抜けて遅延が1フレーム増える.
+    // 次のフレームで余分に受け取って打ち消す.
+    auto owed = 1 + m_Debt;
+    if (signaled == 0)
+    { m_TimeoutCount++; }
+
+    // 待ちきれなかったフレームはすべて返す(最大遅延フレーム数で打ち切ると, 止まっていた間に積んだ分だけ遅延が残る).
+    // 上限はシグナルが戻らない場合に待つ回数が増え続けないためのものです.
+    m_Debt = (signaled >= owed) ? 0 : owed - signaled;
+    if (m_Debt > MaxLatencyLimit)
+    { m_Debt = MaxLatencyLimit; }
+}
+
+//-----------------------------------------------------------------------------
+//      表示したフレームを記録します.
+//-----------------------------------------------------------------------------
+void FramePacer::OnPresent(uint32_t presentId, double beginMs)
+{
+    auto& frame = m_Frames[presentId % HistorySize];
+    frame.PresentId = presentId;
+    frame.BeginMs   = beginMs;
+    frame.Valid     = true;
+}
+
+//-----------------------------------------------------------------------------
+//      画面に表示されたフレームを記録します.
+//-----------------------------------------------------------------------------
+void FramePacer::OnDisplayed(uint32_t presentId, double displayMs)
+{
+    if (m_HasDisplayed && presentId == m_LastDisplayedId)
+    { return; }
+
+    auto& frame = m_Frames[presentId % HistorySize];
+    if (!frame.Valid || frame.PresentId != presentId || displayMs < frame.BeginMs)
+    { return; }
+
+    auto latencyMs = displayMs - frame.BeginMs;
+    m_LatencyMs = (m_HasDisplayed) ? m_LatencyMs + (latencyMs - m_LatencyMs) * LatencySmoothing : latencyMs;
+
+    frame.Valid       = false;
+    m_LastDisplayedId = presentId;
+    m_HasDisplayed    = true;
+}
+
+//-----------------------------------------------------------------------------
+//      入力から表示までの遅延の平均[ms]を取得します.
+//-----------------------------------------------------------------------------
+double FramePacer::GetLatencyMs() const
+{ return m_LatencyMs; }
+
+//-----------------------------------------------------------------------------
+//      待機可能オブジェクトを待ちきれなかった回数を取得します.
+//-----------------------------------------------------------------------------
+uint32_t FramePacer::GetTimeoutCount() const
+{ return m_TimeoutCount; }
@@ -0,0 +1,228 @@
+﻿//-----------------------------------------------------------------------------
+// File : FrameStats.cpp
+// Desc : Frame Time Statistics.
+// Copyright(c) Pocol. All right reserved.
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------
+#include "FrameStats.h"
+#include <algorithm>
+#include <cstdio>
+
+
+namespace {
+
+//-----------------------------------------------------------------------------
+//      昇順に並んだ値から最近傍順位法でパーセンタイルを求めます.
+//-----------------------------------------------------------------------------
+float GetPercentile(const float* pSorted, uint32_t count, uint32_t percent)
+{
+    auto rank = (uint64_t(count) * percent + 99) / 100;
+    auto index = (rank > 0) ? uint32_t(rank - 1) : 0u;
+    return pSorted[(index < count) ? index : count - 1];
+}
+
+//-----------------------------------------------------------------------------
+//      フレーム時間[ms]をフレームレートにします.
+//-----------------------------------------------------------------------------
+float ToFps(float ms)
+{ return (ms > 0.0f) ? 1000.0f / ms : 0.0f; }
+
+} // namespace
+
+
+///////////////////////////////////////////////////////////////////////////////
+// FrameStats class
+///////////////////////////////////////////////////////////////////////////////
+
+//-----------------------------------------------------------------------------
+//      コンストラクタです.
+//-----------------------------------------------------------------------------
+FrameStats::FrameStats()
+{ Reset(); }
+
+//-----------------------------------------------------------------------------
+//      デストラクタです.
+//-----------------------------------------------------------------------------
+FrameStats::~FrameStats()
+{ CloseCsv(); }
+
+//-----------------------------------------------------------------------------
+//      記録を破棄します.
+//-----------------------------------------------------------------------------
+void FrameStats::Reset()
+{
+    for (auto i = 0u; i < WindowSize; ++i)
+    {
+        m_FrameMs[i].store(0.0f, std::memory_order_relaxed);
+        m_BuildMs[i].store(0.0f, std::memory_order_relaxed);
+        m_WaitMs [i].store(0.0f, std::memory_order_relaxed);
+    }
+
+    m_Count.store(0, std::memory_order_release);
+}
+
+//-----------------------------------------------------------------------------
+//      1フレーム分の時間を記録します.
+//-----------------------------------------------------------------------------
+void FrameStats::AddFrame(float frameMs, float buildMs, float waitMs)
+{
+    // 記録するスレッドは1つなので, 書き込んでから数を公開すればよい.
+    auto count = m_Count.load(std::memory_order_relaxed);
+    auto index = uint32_t(count % WindowSize);
+
+    m_FrameMs[index].store(frameMs, std::memory_order_relaxed);
+    m_BuildMs[index].store(buildMs, std::memory_order_relaxed);
+    m_WaitMs [index].store(waitMs,  std::memory_order_relaxed);
+
+    m_Count.store(count + 1, std::memory_order_release);
+}
+
+//-----------------------------------------------------------------------------
+//      これまでに記録したフレーム数を取得します.
+//-----------------------------------------------------------------------------
+uint64_t FrameStats::GetFrameCount() const
+{ return m_Count.load(std::memory_order_acquire); }
+
+//-----------------------------------------------------------------------------
+//      直近のフレームを集計します.
+//-----------------------------------------------------------------------------
+bool FrameStats::GetSummary(FrameStatsSummary& summary)
+{
+    auto frameCount = m_Count.load(std::memory_order_acquire);
+    if (frameCount == 0)
+    { return false; }
+
+    auto count = uint32_t((frameCount < WindowSize) ? frameCount : WindowSize);
+
+    double frameSum = 0.0;
+    double buildSum = 0.0;
+    double waitSum  = 0.0;
+    float  buildMax = 0.0f;
+    float  waitMax  = 0.0f;
+
+    for (auto i = 0u; i < count; ++i)
+    {
+        auto frameMs = m_FrameMs[i].load(std::memory_order_relaxed);
+        auto buildMs = m_BuildMs[i].load(std::memory_order_relaxed);
+        auto waitMs  = m_WaitMs [i].load(std::memory_order_relaxed);
+
+        m_Sorted[i] = frameMs;
+        frameSum += frameMs;
+        buildSum += buildMs;
+        waitSum  += waitMs;
+        buildMax  = (buildMs > buildMax) ? buildMs : buildMax;
+        waitMax   = (waitMs  > waitMax)  ? waitMs  : waitMax;
+    }
+
+    // 最大 WindowSize 個なので並べ替えてしまう.
+    auto pSorted = m_Sorted.data();
+    std::sort(pSorted, pSorted + count);
+
+    // 遅い方から1%(最低1フレーム)の平均.
+    auto lowCount = (count + 99) / 100;
+    double lowSum = 0.0;
+    for (auto i = count - lowCount; i < count; ++i)
+    { lowSum += pSorted[i]; }
+
+    summary.FrameCount  = frameCount;
+    summary.SampleCount = count;
+    summary.MinMs       = pSorted[0];
+    summary.MaxMs       = pSorted[count - 1];
+    summary.MeanMs      = float(frameSum / count);
+    summary.P50Ms       = GetPercentile(pSorted, count, 50);
+    summary.P95Ms       = GetPercentile(pSorted, count, 95);
+    summary.P99Ms       = GetPercentile(pSorted, count, 99);
+    summary.MeanFps     = ToFps(summary.MeanMs);
+    summary.Low1Fps     = ToFps(float(lowSum / lowCount));
+    summary.BuildMeanMs = float(buildSum / count);
+    summary.BuildMaxMs  = buildMax;
+    summary.WaitMeanMs  = float(waitSum / count);
+    summary.WaitMaxMs   = waitMax;
+
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+//      CSVファイルを開き, 見出しを書き込みます.
+//-----------------------------------------------------------------------------
+bool FrameStats::OpenCsv(const char* path)
+{
+    CloseCsv();
+
+    if (path == nullptr)
+    { return false; }
+
+    m_Csv.open(path, std::ios::out | std::ios::trunc);
+    if (!m_Csv.is_open())
+    { return false; }
+
+    m_Csv << "frame,samples,min_ms,mean_ms,max_ms,p50_ms,p95_ms,p99_ms,mean_fps,low1_fps,"
+             "build_mean_ms,build_max_ms,wait_mean_ms,wait_max_ms\n";
+    m_Csv.flush();
+    return m_Csv.good();
+}
+
+//-----------------------------------------------------------------------------
+//      CSVファイルを閉じます.
+//-----------------------------------------------------------------------------
+void FrameStats::CloseCsv()
+{
+    if (m_Csv.is_open())
+    { m_Csv.close(); }
+}
+
+//-----------------------------------------------------------------------------
+//      集計結果をCSVファイルに1行追加します.
+//-----------------------------------------------------------------------------
+bool FrameStats::WriteCsv(const FrameStatsSummary& summary)
+{
+    if (!m_Csv.is_open())
+    { return false; }
+
+    char line[512];
+    auto length = snprintf(line, sizeof(line),
+        "%llu,%u,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f,%.2f,%.2f,%.3f,%.3f,%.3f,%.3f\n",
+        static_cast<unsigned long long>(summary.FrameCount),
+        summary.SampleCount,
+        summary.MinMs,
+        summary.MeanMs,
+        summary.MaxMs,
+        summary.P50Ms,
+        summary.P95Ms,
+        summary.P99Ms,
+        summary.MeanFps,
+        summary.Low1Fps,
+        summary.BuildMeanMs,
+        summary.BuildMaxMs,
+        summary.WaitMeanMs,
+        summary.WaitMaxMs);
+    if (length <= 0)
+    { return false; }
+
+    // 異常終了しても途中までは残るよう, 行ごとに書き出す.
+    m_Csv.write(line, length);
+    m_Csv.flush();
+    return m_Csv.good();
+}
+
+//-----------------------------------------------------------------------------
+//      集計結果を画面表示用の1行の文字列にします.
+//-----------------------------------------------------------------------------
+void FrameStats::FormatOverlay(const FrameStatsSummary& summary, char* buffer, size_t size)
+{
+    if (buffer == nullptr || size == 0)
+    { return; }
+
+    snprintf(buffer, size,
+        "%.1f fps (1%% low %.1f) | p50 %.2f / p95 %.2f / p99 %.2f ms | build %.2f ms | wait %.2f ms",
+        summary.MeanFps,
+        summary.Low1Fps,
+        summary.P50Ms,
+        summary.P95Ms,
+        summary.P99Ms,
+        summary.BuildMeanMs,
+        summary.WaitMeanMs);
+}
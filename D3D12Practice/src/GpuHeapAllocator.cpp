@@ -0,0 +1,703 @@
+﻿//-----------------------------------------------------------------------------
+// File : GpuHeapAllocator.cpp
+// Desc : Placed Resource Heap Sub-Allocator.
+// Copyright(c) Pocol. All right reserved.
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------
+#include "GpuHeapAllocator.h"
+#include "Logger.h"
+#include "AsyncLogger.h"
+#include <dxgi1_4.h>
+#include <wrl/client.h>
+#include <cstdio>
+
+
+namespace {
+
+//-----------------------------------------------------------------------------
+// Constant Values.
+//-----------------------------------------------------------------------------
+constexpr uint64_t TextureGranularity = D3D12_SMALL_RESOURCE_PLACEMENT_ALIGNMENT;  // テクスチャ用ページの最小単位(4KB).
+
+//-----------------------------------------------------------------------------
+//      メモリの種類の名前を取得します.
+//-----------------------------------------------------------------------------
+const char* ToString(uint32_t kind)
+{
+    switch (kind)
+    {
+    case GPU_MEMORY_DEFAULT_BUFFER:     return "Default Buffer";
+    case GPU_MEMORY_DEFAULT_TARGET:     return "Default Target";
+    case GPU_MEMORY_DEFAULT_TEXTURE:    return "Default Texture";
+    case GPU_MEMORY_UPLOAD_BUFFER:      return "Upload Buffer";
+    case GPU_MEMORY_READBACK_BUFFER:    return "Readback Buffer";
+    default:                            return "Unknown";
+    }
+}
+
+//-----------------------------------------------------------------------------
+//      メモリの種類に対応するヒープタイプを取得します.
+//-----------------------------------------------------------------------------
+D3D12_HEAP_TYPE ToHeapType(uint32_t kind)
+{
+    switch (kind)
+    {
+    case GPU_MEMORY_UPLOAD_BUFFER:      return D3D12_HEAP_TYPE_UPLOAD;
+    case GPU_MEMORY_READBACK_BUFFER:    return D3D12_HEAP_TYPE_READBACK;
+    default:                            return D3D12_HEAP_TYPE_DEFAULT;
+    }
+}
+
+//-----------------------------------------------------------------------------
+//      メモリの種類に対応するヒープフラグを取得します.
+//-----------------------------------------------------------------------------
+D3D12_HEAP_FLAGS ToHeapFlags(uint32_t kind)
+{
+    switch (kind)
+    {
+    case GPU_MEMORY_DEFAULT_TARGET:     return D3D12_HEAP_FLAG_ALLOW_ONLY_RT_DS_TEXTURES;
+    case GPU_MEMORY_DEFAULT_TEXTURE:    return D3D12_HEAP_FLAG_ALLOW_ONLY_NON_RT_DS_TEXTURES;
+    default:                            return D3D12_HEAP_FLAG_ALLOW_ONLY_BUFFERS;
+    }
+}
+
+//-----------------------------------------------------------------------------
+//      リソースの設定からメモリの種類を求めます.
+//-----------------------------------------------------------------------------
+bool ToMemoryKind(D3D12_HEAP_TYPE heapType, const D3D12_RESOURCE_DESC& desc, GPU_MEMORY_KIND& kind)
+{
+    if (desc.Dimension == D3D12_RESOURCE_DIMENSION_BUFFER)
+    {
+        switch (heapType)
+        {
+        case D3D12_HEAP_TYPE_DEFAULT:   kind = GPU_MEMORY_DEFAULT_BUFFER;   return true;
+        case D3D12_HEAP_TYPE_UPLOAD:    kind = GPU_MEMORY_UPLOAD_BUFFER;    return true;
+        case D3D12_HEAP_TYPE_READBACK:  kind = GPU_MEMORY_READBACK_BUFFER;  return true;
+        default:                        return false;
+        }
+    }
+
+    if (heapType != D3D12_HEAP_TYPE_DEFAULT)
+    { return false; }
+
+    auto targetFlags = D3D12_RESOURCE_FLAG_ALLOW_RENDER_TARGET | D3D12_RESOURCE_FLAG_ALLOW_DEPTH_STENCIL;
+    kind = (desc.Flags & targetFlags) ? GPU_MEMORY_DEFAULT_TARGET : GPU_MEMORY_DEFAULT_TEXTURE;
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+//      アライメントを揃えます.
+//-----------------------------------------------------------------------------
+inline uint64_t AlignUp(uint64_t value, uint64_t alignment)
+{ return (value + alignment - 1) & ~(alignment - 1); }
+
+} // namespace
+
+
+///////////////////////////////////////////////////////////////////////////////
+// GpuHeapAllocator class
+///////////////////////////////////////////////////////////////////////////////
+
+//-----------------------------------------------------------------------------
+//      コンストラクタです.
+//-----------------------------------------------------------------------------
+GpuHeapAllocator::GpuHeapAllocator()
+: m_PageSize(DefaultPageSize)
+{ /* DO_NOTHING */ }
+
+//-----------------------------------------------------------------------------
+//      デストラクタです.
+//-----------------------------------------------------------------------------
+GpuHeapAllocator::~GpuHeapAllocator()
+{ Term(); }
+
+//-----------------------------------------------------------------------------
+//      初期化処理を行います.
+//-----------------------------------------------------------------------------
+bool GpuHeapAllocator::Init(ID3D12Device* pDevice, uint64_t pageSize)
+{
+    if (pDevice == nullptr || pageSize == 0)
+    {
+        ELOG("Error : Invalid Argument.");
+        return false;
+    }
+
+    std::lock_guard<std::mutex> locker(m_Mutex);
+
+    m_pDevice  = pDevice;
+    m_PageSize = AlignUp(pageSize, D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT);
+
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+//      終了処理を行います.
+//-----------------------------------------------------------------------------
+void GpuHeapAllocator::Term()
+{
+    std::lock_guard<std::mutex> locker(m_Mutex);
+
+    for (auto& pages : m_Pages)
+    {
+        for (auto& page : pages)
+        {
+            if (page && page->pBuffer && page->pMapped != nullptr)
+            { page->pBuffer->Unmap(0, nullptr); }
+        }
+        pages.clear();
+    }
+
+    m_pDevice.Reset();
+}
+
+//-----------------------------------------------------------------------------
+//      配置リソースを生成します.
+//-----------------------------------------------------------------------------
+bool GpuHeapAllocator::CreateResource
+(
+    D3D12_HEAP_TYPE             heapType,
+    const D3D12_RESOURCE_DESC&  desc,
+    D3D12_RESOURCE_STATES       state,
+    const D3D12_CLEAR_VALUE*    pClearValue,
+    ID3D12Resource**            ppResource,
+    GpuAllocation&              allocation,
+    MEMORY_CATEGORY             category,
+    const char*                 name
+)
+{
+    if (m_pDevice == nullptr || ppResource == nullptr)
+    {
+        ALOG("Error : Invalid Argument.");
+        return false;
+    }
+
+    GPU_MEMORY_KIND kind;
+    if (!ToMemoryKind(heapType, desc, kind))
+    {
+        ALOG("Error : Unsupported Heap Type.");
+        return false;
+    }
+
+    // CPUから見えるバッファはページのバッファから切り出す.
+    if (kind == GPU_MEMORY_UPLOAD_BUFFER || kind == GPU_MEMORY_READBACK_BUFFER)
+    {
+        ALOG("Error : Use GpuHeapAllocator::AllocateBuffer() for upload / readback buffers.");
+        return false;
+    }
+
+    // 小さなテクスチャは 4KB アライメントで置けるか試す.
+    auto resDesc = desc;
+    D3D12_RESOURCE_ALLOCATION_INFO info = {};
+    if (kind == GPU_MEMORY_DEFAULT_TEXTURE && resDesc.SampleDesc.Count <= 1)
+    {
+        resDesc.Alignment = D3D12_SMALL_RESOURCE_PLACEMENT_ALIGNMENT;
+        info = m_pDevice->GetResourceAllocationInfo(0, 1, &resDesc);
+        if (info.Alignment != D3D12_SMALL_RESOURCE_PLACEMENT_ALIGNMENT)
+        { resDesc.Alignment = 0; }
+    }
+
+    if (resDesc.Alignment == 0)
+    { info = m_pDevice->GetResourceAllocationInfo(0, 1, &resDesc); }
+
+    if (info.SizeInBytes == UINT64_MAX)
+    {
+        ALOG("Error : ID3D12Device::GetResourceAllocationInfo() Failed.");
+        return false;
+    }
+
+    std::lock_guard<std::mutex> locker(m_Mutex);
+
+    if (!AllocateLocked(kind, info.SizeInBytes, info.Alignment, allocation))
+    { return false; }
+
+    auto& page = *m_Pages[kind][allocation.Page];
+    auto hr = m_pDevice->CreatePlacedResource(
+        page.pHeap.Get(),
+        allocation.Block.Offset,
+        &resDesc,
+        state,
+        pClearValue,
+        IID_PPV_ARGS(ppResource));
+    if (FAILED(hr))
+    {
+        ALOG("Error : ID3D12Device::CreatePlacedResource() Failed. retcode = 0x%x", hr);
+        FreeLocked(allocation);
+        return false;
+    }
+
+    allocation.TrackId = GetMemoryTracker().Add(category, MEMORY_DOMAIN_GPU, allocation.Block.Size, name);
+
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+//      確保済みのメモリに別のリソースを重ねて配置します.
+//-----------------------------------------------------------------------------
+bool GpuHeapAllocator::CreateAliasedResource
+(
+    const GpuAllocation&        allocation,
+    uint64_t                    offset,
+    const D3D12_RESOURCE_DESC&  desc,
+    D3D12_RESOURCE_STATES       state,
+    const D3D12_CLEAR_VALUE*    pClearValue,
+    ID3D12Resource**            ppResource
+)
+{
+    if (m_pDevice == nullptr || ppResource == nullptr || !allocation.IsValid())
+    {
+        ALOG("Error : Invalid Argument.");
+        return false;
+    }
+
+    GPU_MEMORY_KIND kind;
+    if (!ToMemoryKind(ToHeapType(allocation.Kind), desc, kind) || kind != GPU_MEMORY_KIND(allocation.Kind))
+    {
+        ALOG("Error : Resource does not match the memory kind.");
+        return false;
+    }
+
+    auto info = m_pDevice->GetResourceAllocationInfo(0, 1, &desc);
+    if (info.SizeInBytes == UINT64_MAX
+     || offset % info.Alignment != 0
+     || offset + info.SizeInBytes > allocation.Block.Size)
+    {
+        ALOG("Error : Aliased resource does not fit in the allocation.");
+        return false;
+    }
+
+    std::lock_guard<std::mutex> locker(m_Mutex);
+
+    auto& page = *m_Pages[allocation.Kind][allocation.Page];
+    auto hr = m_pDevice->CreatePlacedResource(
+        page.pHeap.Get(),
+        allocation.Block.Offset + offset,
+        &desc,
+        state,
+        pClearValue,
+        IID_PPV_ARGS(ppResource));
+    if (FAILED(hr))
+    {
+        ALOG("Error : ID3D12Device::CreatePlacedResource() Failed. retcode = 0x%x", hr);
+        return false;
+    }
+
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+//      リソースを置かずにメモリだけを確保します.
+//-----------------------------------------------------------------------------
+bool GpuHeapAllocator::Allocate
+(
+    GPU_MEMORY_KIND     kind,
+    uint64_t            size,
+    uint64_t            alignment,
+    GpuAllocation&      allocation,
+    MEMORY_CATEGORY     category,
+    const char*         name
+)
+{
+    if (m_pDevice == nullptr || kind >= GPU_MEMORY_KIND_COUNT || size == 0)
+    {
+        ALOG("Error : Invalid Argument.");
+        return false;
+    }
+
+    std::lock_guard<std::mutex> locker(m_Mutex);
+    if (!AllocateLocked(kind, size, alignment, allocation))
+    { return false; }
+
+    allocation.TrackId = GetMemoryTracker().Add(category, MEMORY_DOMAIN_GPU, allocation.Block.Size, name);
+
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+//      UPLOAD / READBACK ヒープのバッファから範囲を切り出します.
+//-----------------------------------------------------------------------------
+bool GpuHeapAllocator::AllocateBuffer
+(
+    D3D12_HEAP_TYPE     heapType,
+    uint64_t            size,
+    uint64_t            alignment,
+    GpuBuffer&          buffer,
+    MEMORY_CATEGORY     category,
+    const char*         name
+)
+{
+    GPU_MEMORY_KIND kind;
+    if (heapType == D3D12_HEAP_TYPE_UPLOAD)
+    { kind = GPU_MEMORY_UPLOAD_BUFFER; }
+    else if (heapType == D3D12_HEAP_TYPE_READBACK)
+    { kind = GPU_MEMORY_READBACK_BUFFER; }
+    else
+    {
+        ALOG("Error : Invalid Argument.");
+        return false;
+    }
+
+    if (m_pDevice == nullptr || size == 0)
+    {
+        ALOG("Error : Invalid Argument.");
+        return false;
+    }
+
+    std::lock_guard<std::mutex> locker(m_Mutex);
+
+    if (alignment < BufferGranularity)
+    { alignment = BufferGranularity; }
+
+    GpuAllocation allocation;
+    if (!AllocateLocked(kind, size, alignment, allocation))
+    { return false; }
+
+    allocation.TrackId = GetMemoryTracker().Add(category, MEMORY_DOMAIN_GPU, allocation.Block.Size, name);
+
+    auto& page = *m_Pages[kind][allocation.Page];
+
+    buffer.pResource    = page.pBuffer.Get();
+    buffer.Offset       = allocation.Block.Offset;
+    buffer.Size         = size;
+    buffer.GpuAddress   = page.pBuffer->GetGPUVirtualAddress() + allocation.Block.Offset;
+    buffer.pCpu         = page.pMapped + allocation.Block.Offset;
+    buffer.Allocation   = allocation;
+
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+//      メモリを解放します.
+//-----------------------------------------------------------------------------
+void GpuHeapAllocator::Free(GpuAllocation& allocation)
+{
+    if (!allocation.IsValid())
+    { return; }
+
+    std::lock_guard<std::mutex> locker(m_Mutex);
+    FreeLocked(allocation);
+}
+
+//-----------------------------------------------------------------------------
+//      切り出したバッファを解放します.
+//-----------------------------------------------------------------------------
+void GpuHeapAllocator::Free(GpuBuffer& buffer)
+{
+    Free(buffer.Allocation);
+    buffer = GpuBuffer();
+}
+
+//-----------------------------------------------------------------------------
+//      メモリの種類ごとの統計を取得します.
+//-----------------------------------------------------------------------------
+TlsfStats GpuHeapAllocator::GetStats(GPU_MEMORY_KIND kind) const
+{
+    TlsfStats result = {};
+    if (kind >= GPU_MEMORY_KIND_COUNT)
+    { return result; }
+
+    std::lock_guard<std::mutex> locker(m_Mutex);
+
+    for (auto& page : m_Pages[kind])
+    {
+        if (!page)
+        { continue; }
+
+        auto stats = page->Allocator.GetStats();
+        result.Capacity         += stats.Capacity;
+        result.UsedBytes        += stats.UsedBytes;
+        result.FreeBytes        += stats.FreeBytes;
+        result.AllocationCount  += stats.AllocationCount;
+        result.FreeBlockCount   += stats.FreeBlockCount;
+        if (stats.LargestFreeBlock > result.LargestFreeBlock)
+        { result.LargestFreeBlock = stats.LargestFreeBlock; }
+    }
+
+    if (result.FreeBytes > 0)
+    { result.Fragmentation = 1.0f - float(double(result.LargestFreeBlock) / double(result.FreeBytes)); }
+
+    return result;
+}
+
+//-----------------------------------------------------------------------------
+//      使用量と断片化のレポートを作成します.
+//-----------------------------------------------------------------------------
+std::string GpuHeapAllocator::FormatReport() const
+{
+    std::string result = "GPU Heap Allocator (pages / used / capacity / largest free / fragmentation)\n";
+
+    char line[256];
+    for (auto kind = 0u; kind < GPU_MEMORY_KIND_COUNT; ++kind)
+    {
+        uint32_t pageCount = 0;
+        {
+            std::lock_guard<std::mutex> locker(m_Mutex);
+            for (auto& page : m_Pages[kind])
+            {
+                if (page)
+                { pageCount++; }
+            }
+        }
+
+        auto stats = GetStats(GPU_MEMORY_KIND(kind));
+        snprintf(line, sizeof(line), "    %-16s %3u pages  %9.2f MB / %9.2f MB  %9.2f MB  %5.1f%%  (%u allocations)\n",
+            ToString(kind),
+            pageCount,
+            double(stats.UsedBytes) / (1024.0 * 1024.0),
+            double(stats.Capacity) / (1024.0 * 1024.0),
+            double(stats.LargestFreeBlock) / (1024.0 * 1024.0),
+            stats.Fragmentation * 100.0f,
+            stats.AllocationCount);
+        result += line;
+    }
+
+    return result;
+}
+
+//-----------------------------------------------------------------------------
+//      ページから領域を確保します.
+//-----------------------------------------------------------------------------
+bool GpuHeapAllocator::AllocateLocked(GPU_MEMORY_KIND kind, uint64_t size, uint64_t alignment, GpuAllocation& allocation)
+{
+    allocation = GpuAllocation();
+
+    auto& pages = m_Pages[kind];
+
+    // ページより大きいか, MSAA のように大きなアライメントが必要なら専用のページを作る.
+    if (size > m_PageSize || alignment > D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT)
+    {
+        uint32_t index = 0;
+        auto pPage = AddPage(kind, AlignUp(size, alignment), alignment, true, index);
+        if (pPage == nullptr)
+        { return false; }
+
+        if (!pPage->Allocator.Alloc(size, alignment, allocation.Block))
+        {
+            pages[index].reset();
+            return false;
+        }
+
+        allocation.Kind = kind;
+        allocation.Page = index;
+        return true;
+    }
+
+    for (auto i = 0u; i < pages.size(); ++i)
+    {
+        auto& page = pages[i];
+        if (!page || page->Dedicated)
+        { continue; }
+
+        if (page->Allocator.Alloc(size, alignment, allocation.Block))
+        {
+            allocation.Kind = kind;
+            allocation.Page = i;
+            return true;
+        }
+    }
+
+    uint32_t index = 0;
+    auto pPage = AddPage(kind, m_PageSize, alignment, false, index);
+    if (pPage == nullptr || !pPage->Allocator.Alloc(size, alignment, allocation.Block))
+    { return false; }
+
+    allocation.Kind = kind;
+    allocation.Page = index;
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+//      ページを追加します.
+//-----------------------------------------------------------------------------
+GpuHeapAllocator::Page* GpuHeapAllocator::AddPage
+(
+    GPU_MEMORY_KIND kind,
+    uint64_t        size,
+    uint64_t        alignment,
+    bool            dedicated,
+    uint32_t&       index
+)
+{
+    // MSAA のリソースを置くヒープは 4MB アライメントが必要.
+    alignment = (alignment > D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT)
+        ? D3D12_DEFAULT_MSAA_RESOURCE_PLACEMENT_ALIGNMENT
+        : D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT;
+
+    size = AlignUp(size, D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT);
+
+    auto page = std::make_unique<Page>();
+    page->pMapped   = nullptr;
+    page->Dedicated = dedicated;
+
+    D3D12_HEAP_DESC desc = {};
+    desc.SizeInBytes                     = size;
+    desc.Properties.Type                 = ToHeapType(kind);
+    desc.Properties.CPUPageProperty      = D3D12_CPU_PAGE_PROPERTY_UNKNOWN;
+    desc.Properties.MemoryPoolPreference = D3D12_MEMORY_POOL_UNKNOWN;
+    desc.Properties.CreationNodeMask     = 1;
+    desc.Properties.VisibleNodeMask      = 1;
+    desc.Alignment                       = alignment;
+    desc.Flags                           = ToHeapFlags(kind);
+
+    auto hr = m_pDevice->CreateHeap(&desc, IID_PPV_ARGS(page->pHeap.GetAddressOf()));
+    if (FAILED(hr))
+    {
+        ALOG("Error : ID3D12Device::CreateHeap() Failed. retcode = 0x%x", hr);
+        return nullptr;
+    }
+
+    auto granularity = (kind == GPU_MEMORY_UPLOAD_BUFFER || kind == GPU_MEMORY_READBACK_BUFFER)
+        ? BufferGranularity
+        : TextureGranularity;
+
+    if (!page->Allocator.Init(size, granularity))
+    {
+        ALOG("Error : TlsfAllocator::Init() Failed.");
+        return nullptr;
+    }
+
+    // CPUから見えるページは全体を1つのバッファで覆い, 常にマップしておく.
+    if (kind == GPU_MEMORY_UPLOAD_BUFFER || kind == GPU_MEMORY_READBACK_BUFFER)
+    {
+        D3D12_RESOURCE_DESC bufferDesc = {};
+        bufferDesc.Dimension          = D3D12_RESOURCE_DIMENSION_BUFFER;
+        bufferDesc.Alignment          = 0;
+        bufferDesc.Width              = size;
+        bufferDesc.Height             = 1;
+        bufferDesc.DepthOrArraySize   = 1;
+        bufferDesc.MipLevels          = 1;
+        bufferDesc.Format             = DXGI_FORMAT_UNKNOWN;
+        bufferDesc.SampleDesc.Count   = 1;
+        bufferDesc.SampleDesc.Quality = 0;
+        bufferDesc.Layout             = D3D12_TEXTURE_LAYOUT_ROW_MAJOR;
+        bufferDesc.Flags              = D3D12_RESOURCE_FLAG_NONE;
+
+        auto state = (kind == GPU_MEMORY_UPLOAD_BUFFER)
+            ? D3D12_RESOURCE_STATE_GENERIC_READ
+            : D3D12_RESOURCE_STATE_COPY_DEST;
+
+        hr = m_pDevice->CreatePlacedResource(
+            page->pHeap.Get(),
+            0,
+            &bufferDesc,
+            state,
+            nullptr,
+            IID_PPV_ARGS(page->pBuffer.GetAddressOf()));
+        if (FAILED(hr))
+        {
+            ALOG("Error : ID3D12Device::CreatePlacedResource() Failed. retcode = 0x%x", hr);
+            return nullptr;
+        }
+
+        // アップロード用はCPUから読まない.
+        D3D12_RANGE readRange = {};
+        hr = page->pBuffer->Map(0, (kind == GPU_MEMORY_UPLOAD_BUFFER) ? &readRange : nullptr, reinterpret_cast<void**>(&page->pMapped));
+        if (FAILED(hr))
+        {
+            ALOG("Error : ID3D12Resource::Map() Failed. retcode = 0x%x", hr);
+            return nullptr;
+        }
+    }
+
+    // 空いたスロットを再利用して, 他の確保情報のページ番号を変えないようにする.
+    auto& pages = m_Pages[kind];
+    for (auto i = 0u; i < pages.size(); ++i)
+    {
+        if (!pages[i])
+        {
+            pages[i] = std::move(page);
+            index = i;
+            return pages[i].get();
+        }
+    }
+
+    pages.push_back(std::move(page));
+    index = uint32_t(pages.size() - 1);
+    return pages.back().get();
+}
+
+//-----------------------------------------------------------------------------
+//      領域を解放します.
+//-----------------------------------------------------------------------------
+void GpuHeapAllocator::FreeLocked(GpuAllocation& allocation)
+{
+    GetMemoryTracker().Remove(allocation.TrackId);
+
+    auto& pages = m_Pages[allocation.Kind];
+    if (allocation.Page < pages.size() && pages[allocation.Page])
+    {
+        auto& page = pages[allocation.Page];
+        page->Allocator.Free(allocation.Block);
+
+        // 専用ページは空になったら返す.
+        if (page->Dedicated && page->Allocator.IsEmpty())
+        {
+            if (page->pBuffer && page->pMapped != nullptr)
+            { page->pBuffer->Unmap(0, nullptr); }
+            page.reset();
+        }
+    }
+
+    allocation = GpuAllocation();
+}
+
+
+//-----------------------------------------------------------------------------
+//      リソースが使うメモリのサイズを取得します.
+//-----------------------------------------------------------------------------
+uint64_t GetResourceSize(ID3D12Resource* pResource)
+{
+    if (pResource == nullptr)
+    { return 0; }
+
+    Microsoft::WRL::ComPtr<ID3D12Device> pDevice;
+    auto hr = pResource->GetDevice(IID_PPV_ARGS(pDevice.GetAddressOf()));
+    if (FAILED(hr))
+    { return 0; }
+
+    auto desc = pResource->GetDesc();
+    auto info = pDevice->GetResourceAllocationInfo(0, 1, &desc);
+    return (info.SizeInBytes != UINT64_MAX) ? info.SizeInBytes : 0;
+}
+
+//-----------------------------------------------------------------------------
+//      アロケータを通さずに生成したリソースのメモリ使用量を計上します.
+//-----------------------------------------------------------------------------
+uint64_t TrackResource(ID3D12Resource* pResource, MEMORY_CATEGORY category, const char* name)
+{
+    if (pResource == nullptr)
+    { return MemoryTracker::InvalidId; }
+
+    return GetMemoryTracker().Add(category, MEMORY_DOMAIN_GPU, GetResourceSize(pResource), name);
+}
+
+//-----------------------------------------------------------------------------
+//      デバイスのローカルビデオメモリの予算と使用量を問い合わせます.
+//-----------------------------------------------------------------------------
+bool QueryVideoMemory(ID3D12Device* pDevice, uint64_t& budget, uint64_t& usage)
+{
+    if (pDevice == nullptr)
+    { return false; }
+
+    Microsoft::WRL::ComPtr<IDXGIFactory4> pFactory;
+    auto hr = CreateDXGIFactory1(IID_PPV_ARGS(pFactory.GetAddressOf()));
+    if (FAILED(hr))
+    { return false; }
+
+    // デバイスを作ったアダプタを探す.
+    Microsoft::WRL::ComPtr<IDXGIAdapter3> pAdapter;
+    hr = pFactory->EnumAdapterByLuid(pDevice->GetAdapterLuid(), IID_PPV_ARGS(pAdapter.GetAddressOf()));
+    if (FAILED(hr))
+    { return false; }
+
+    DXGI_QUERY_VIDEO_MEMORY_INFO info = {};
+    hr = pAdapter->QueryVideoMemoryInfo(0, DXGI_MEMORY_SEGMENT_GROUP_LOCAL, &info);
+    if (FAILED(hr))
+    { return false; }
+
+    budget = info.Budget;
+    usage  = info.CurrentUsage;
+    return true;
+}
@@ -0,0 +1,315 @@
+﻿//-----------------------------------------------------------------------------
+// File : GpuTimer.cpp
+// Desc : GPU Timestamp Timer.
+// Copyright(c) Pocol. All right reserved.
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------
+#include "GpuTimer.h"
+#include "Logger.h"
+#include <chrono>
+#include <cstdio>
+
+
+///////////////////////////////////////////////////////////////////////////////
+// GpuTimer class
+///////////////////////////////////////////////////////////////////////////////
+
+//-----------------------------------------------------------------------------
+//      コンストラクタです.
+//-----------------------------------------------------------------------------
+GpuTimer::GpuTimer()
+: m_pAllocator      (nullptr)
+, m_TickToMs        (0.0)
+, m_MaxScopes       (0)
+, m_FrameIndex      (0)
+, m_LastFrameMs     (-1.0)
+, m_CalibrationTick (0)
+, m_CalibrationUs   (0.0)
+{ /* DO_NOTHING */ }
+
+//-----------------------------------------------------------------------------
+//      デストラクタです.
+//-----------------------------------------------------------------------------
+GpuTimer::~GpuTimer()
+{ Term(); }
+
+//-----------------------------------------------------------------------------
+//      初期化処理を行います.
+//-----------------------------------------------------------------------------
+bool GpuTimer::Init(ID3D12Device* pDevice, GpuHeapAllocator* pAllocator, ID3D12CommandQueue* pQueue, uint32_t maxScopes)
+{
+    if (pDevice == nullptr || pAllocator == nullptr || pQueue == nullptr || maxScopes == 0)
+    {
+        ELOG("Error : Invalid Argument.");
+        return false;
+    }
+
+    UINT64 frequency = 0;
+    auto hr = pQueue->GetTimestampFrequency(&frequency);
+    if (FAILED(hr) || frequency == 0)
+    {
+        ELOG("Error : ID3D12CommandQueue::GetTimestampFrequency() Failed. retcode = 0x%x", hr);
+        return false;
+    }
+
+    m_TickToMs  = 1000.0 / double(frequency);
+    m_MaxScopes = maxScopes;
+    m_pQueue    = pQueue;
+
+    if (!Calibrate())
+    {
+        ELOG("Error : GpuTimer::Calibrate() Failed.");
+        return false;
+    }
+
+    // フレームごとに開始と終了の2つずつ.
+    auto queryCount = maxScopes * 2 * FrameCount;
+
+    D3D12_QUERY_HEAP_DESC heapDesc = {};
+    heapDesc.Type       = D3D12_QUERY_HEAP_TYPE_TIMESTAMP;
+    heapDesc.Count      = queryCount;
+    heapDesc.NodeMask   = 0;
+
+    hr = pDevice->CreateQueryHeap(&heapDesc, IID_PPV_ARGS(m_pQueryHeap.GetAddressOf()));
+    if (FAILED(hr))
+    {
+        ELOG("Error : ID3D12Device::CreateQueryHeap() Failed. retcode = 0x%x", hr);
+        return false;
+    }
+
+    // 読み戻し用のページから切り出す. ページのバッファはマップ済みで COPY_DEST のままになっている.
+    if (!pAllocator->AllocateBuffer(
+        D3D12_HEAP_TYPE_READBACK,
+        sizeof(uint64_t) * queryCount,
+        sizeof(uint64_t),
+        m_Readback,
+        MEMORY_CATEGORY_OTHER,
+        "GpuTimer"))
+    {
+        ELOG("Error : GpuHeapAllocator::AllocateBuffer() Failed.");
+        return false;
+    }
+
+    m_pAllocator = pAllocator;
+
+    for (auto i = 0u; i < FrameCount; ++i)
+    {
+        m_Names[i].clear();
+        m_Names[i].reserve(maxScopes);
+    }
+
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+//      終了処理を行います.
+//-----------------------------------------------------------------------------
+void GpuTimer::Term()
+{
+    if (m_pAllocator != nullptr)
+    {
+        m_pAllocator->Free(m_Readback);
+        m_pAllocator = nullptr;
+    }
+
+    m_pQueryHeap.Reset();
+    m_pQueue.Reset();
+
+    for (auto i = 0u; i < FrameCount; ++i)
+    { m_Names[i].clear(); }
+
+    m_Stats.clear();
+    m_Samples.clear();
+    m_MaxScopes = 0;
+}
+
+//-----------------------------------------------------------------------------
+//      フレームの計測を開始します.
+//-----------------------------------------------------------------------------
+void GpuTimer::BeginFrame(uint32_t frameIndex)
+{
+    if (m_Readback.pCpu == nullptr)
+    { return; }
+
+    m_FrameIndex  = frameIndex % FrameCount;
+    m_LastFrameMs = -1.0;
+    m_Samples.clear();
+
+    auto& names = m_Names[m_FrameIndex];
+    if (!names.empty())
+    {
+        // 前回このフレーム番号で記録した結果を集計する.
+        auto base = m_FrameIndex * m_MaxScopes * 2;
+
+        // ページのバッファはマップしたままなので, そのまま読める.
+        auto pTicks = reinterpret_cast<const uint64_t*>(m_Readback.pCpu) + base;
+
+        uint64_t frameBegin = UINT64_MAX;
+        uint64_t frameEnd   = 0;
+
+        for (size_t i = 0; i < names.size(); ++i)
+        {
+            auto begin = pTicks[i * 2 + 0];
+            auto end   = pTicks[i * 2 + 1];
+            auto ms    = (end > begin) ? double(end - begin) * m_TickToMs : 0.0;
+
+            // 最初の開始から最後の終了までをフレーム時間とする.
+            if (end > begin)
+            {
+                frameBegin = (begin < frameBegin) ? begin : frameBegin;
+                frameEnd   = (end   > frameEnd)   ? end   : frameEnd;
+
+                // CPUの時刻に変換して残す.
+                auto beginUs = m_CalibrationUs + (double(begin) - double(m_CalibrationTick)) * m_TickToMs * 1000.0;
+                auto endUs   = m_CalibrationUs + (double(end)   - double(m_CalibrationTick)) * m_TickToMs * 1000.0;
+                m_Samples.push_back({ names[i], beginUs, endUs });
+            }
+
+            Stats* pStats = nullptr;
+            for (auto& stats : m_Stats)
+            {
+                if (stats.Name == names[i])
+                {
+                    pStats = &stats;
+                    break;
+                }
+            }
+
+            if (pStats == nullptr)
+            {
+                m_Stats.push_back({ names[i], 0.0, 0.0, 0 });
+                pStats = &m_Stats.back();
+            }
+
+            pStats->TotalMs += ms;
+            pStats->MaxMs    = (ms > pStats->MaxMs) ? ms : pStats->MaxMs;
+            pStats->Count++;
+        }
+
+        if (frameEnd > frameBegin)
+        { m_LastFrameMs = double(frameEnd - frameBegin) * m_TickToMs; }
+    }
+
+    names.clear();
+}
+
+//-----------------------------------------------------------------------------
+//      スコープの計測を開始します.
+//-----------------------------------------------------------------------------
+uint32_t GpuTimer::Begin(ID3D12GraphicsCommandList* pCmd, const char* name)
+{
+    auto& names = m_Names[m_FrameIndex];
+    if (m_pQueryHeap == nullptr || names.size() >= m_MaxScopes)
+    { return InvalidScope; }
+
+    auto scope = uint32_t(names.size());
+    names.push_back(name);
+
+    auto index = (m_FrameIndex * m_MaxScopes + scope) * 2;
+    pCmd->EndQuery(m_pQueryHeap.Get(), D3D12_QUERY_TYPE_TIMESTAMP, index);
+
+    return scope;
+}
+
+//-----------------------------------------------------------------------------
+//      スコープの計測を終了します.
+//-----------------------------------------------------------------------------
+void GpuTimer::End(ID3D12GraphicsCommandList* pCmd, uint32_t scope)
+{
+    if (m_pQueryHeap == nullptr || scope == InvalidScope)
+    { return; }
+
+    auto index = (m_FrameIndex * m_MaxScopes + scope) * 2 + 1;
+    pCmd->EndQuery(m_pQueryHeap.Get(), D3D12_QUERY_TYPE_TIMESTAMP, index);
+}
+
+//-----------------------------------------------------------------------------
+//      フレームの計測を終了し, クエリを読み戻し用バッファに解決します.
+//-----------------------------------------------------------------------------
+void GpuTimer::EndFrame(ID3D12GraphicsCommandList* pCmd)
+{
+    auto& names = m_Names[m_FrameIndex];
+    if (m_pQueryHeap == nullptr || names.empty())
+    { return; }
+
+    auto base  = m_FrameIndex * m_MaxScopes * 2;
+    auto count = uint32_t(names.size() * 2);
+
+    pCmd->ResolveQueryData(
+        m_pQueryHeap.Get(),
+        D3D12_QUERY_TYPE_TIMESTAMP,
+        base,
+        count,
+        m_Readback.pResource,
+        m_Readback.Offset + sizeof(uint64_t) * base);
+}
+
+//-----------------------------------------------------------------------------
+//      集計をリセットします.
+//-----------------------------------------------------------------------------
+void GpuTimer::ResetStats()
+{ m_Stats.clear(); }
+
+//-----------------------------------------------------------------------------
+//      直前に集計したフレームのGPU時間を取得します.
+//-----------------------------------------------------------------------------
+bool GpuTimer::GetLastFrameMs(double& ms) const
+{
+    if (m_LastFrameMs < 0.0)
+    { return false; }
+
+    ms = m_LastFrameMs;
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+//      直前に集計したフレームのスコープごとの時刻を取得します.
+//-----------------------------------------------------------------------------
+const std::vector<GpuTimerSample>& GpuTimer::GetLastFrameSamples() const
+{ return m_Samples; }
+
+//-----------------------------------------------------------------------------
+//      GPUのタイムスタンプとCPUの時刻の対応を取り直します.
+//-----------------------------------------------------------------------------
+bool GpuTimer::Calibrate()
+{
+    if (m_pQueue == nullptr)
+    { return false; }
+
+    UINT64 gpuTick = 0;
+    UINT64 cpuTick = 0;
+    auto hr = m_pQueue->GetClockCalibration(&gpuTick, &cpuTick);
+    if (FAILED(hr))
+    { return false; }
+
+    // 直後の steady_clock の時刻を対応させる(誤差は数マイクロ秒).
+    auto now = std::chrono::steady_clock::now().time_since_epoch();
+    m_CalibrationTick = gpuTick;
+    m_CalibrationUs   = std::chrono::duration<double, std::micro>(now).count();
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+//      スコープごとの平均時間を文字列にします.
+//-----------------------------------------------------------------------------
+std::string GpuTimer::FormatReport() const
+{
+    std::string result = "GPU Timing (average / max)\n";
+
+    char line[256];
+    for (auto& stats : m_Stats)
+    {
+        auto average = (stats.Count > 0) ? stats.TotalMs / double(stats.Count) : 0.0;
+        snprintf(line, sizeof(line), "    %-24s %8.3f ms  %8.3f ms  (%u frames)\n",
+            stats.Name.c_str(),
+            average,
+            stats.MaxMs,
+            stats.Count);
+        result += line;
+    }
+
+    return result;
+}
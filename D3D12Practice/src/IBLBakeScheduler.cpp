@@ -0,0 +1,209 @@
+﻿//-----------------------------------------------------------------------------
+// File : IBLBakeScheduler.cpp
+// Desc : Time Sliced Bake Scheduler.
+// Copyright(c) Pocol. All right reserved.
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------
+#include "IBLBakeScheduler.h"
+#include <algorithm>
+
+
+namespace {
+
+//-----------------------------------------------------------------------------
+// Constant Values.
+//-----------------------------------------------------------------------------
+constexpr double DefaultBudget  = 2.0;      // 既定の予算[ms].
+constexpr double DefaultCost    = 1.0;      // 既定の見積もりコスト[ms].
+constexpr double SmoothFactor   = 0.25;     // 見積もり更新の平滑化係数.
+constexpr double MinWeight      = 1e-6;     // 見積もりを更新する重みの下限.
+
+} // namespace
+
+
+///////////////////////////////////////////////////////////////////////////////
+// IBLBakeScheduler class
+///////////////////////////////////////////////////////////////////////////////
+
+//-----------------------------------------------------------------------------
+//      コンストラクタです.
+//-----------------------------------------------------------------------------
+IBLBakeScheduler::IBLBakeScheduler()
+: m_Budget      (DefaultBudget)
+, m_FrameCost   (0.0)
+, m_FrameIssued (0)
+, m_pCurrent    (nullptr)
+, m_Issued      ()
+, m_Stats       ()
+{
+    for (auto i = 0u; i < MaxKindCount; ++i)
+    { m_Cost[i] = DefaultCost; }
+}
+
+//-----------------------------------------------------------------------------
+//      1フレームあたりのGPU時間予算を設定します.
+//-----------------------------------------------------------------------------
+void IBLBakeScheduler::SetBudget(double budgetMs)
+{ m_Budget = std::max(budgetMs, 0.0); }
+
+//-----------------------------------------------------------------------------
+//      作業の種類ごとのコスト見積もりを設定します.
+//-----------------------------------------------------------------------------
+void IBLBakeScheduler::SetCostEstimate(uint32_t kind, double costMs)
+{
+    if (kind < MaxKindCount)
+    { m_Cost[kind] = std::max(costMs, 0.0); }
+}
+
+//-----------------------------------------------------------------------------
+//      作業の種類ごとのコスト見積もりを取得します.
+//-----------------------------------------------------------------------------
+double IBLBakeScheduler::GetCostEstimate(uint32_t kind) const
+{ return (kind < MaxKindCount) ? m_Cost[kind] : DefaultCost; }
+
+//-----------------------------------------------------------------------------
+//      未発行の作業と統計を破棄します.
+//-----------------------------------------------------------------------------
+void IBLBakeScheduler::Reset()
+{
+    // 発行済みの作業の記録は残す. 計測結果が届けば見積もりの更新に使える.
+    m_Queue.clear();
+    m_FrameCost   = 0.0;
+    m_FrameIssued = 0;
+    m_Stats       = Stats();
+}
+
+//-----------------------------------------------------------------------------
+//      作業を追加します.
+//-----------------------------------------------------------------------------
+void IBLBakeScheduler::Push(uint32_t kind, uint32_t index, double weight)
+{ m_Queue.push_back({ kind, index, std::max(weight, 0.0) }); }
+
+//-----------------------------------------------------------------------------
+//      フレームの開始を通知します.
+//-----------------------------------------------------------------------------
+void IBLBakeScheduler::BeginFrame(uint32_t frameIndex)
+{
+    m_FrameCost   = 0.0;
+    m_FrameIssued = 0;
+
+    m_pCurrent = &m_Issued[frameIndex % HistorySize];
+    *m_pCurrent = Issued();
+    m_pCurrent->FrameIndex = frameIndex;
+}
+
+//-----------------------------------------------------------------------------
+//      このフレームで発行する次の作業を取得します.
+//-----------------------------------------------------------------------------
+bool IBLBakeScheduler::Next(WorkUnit& unit)
+{
+    if (m_Queue.empty())
+    { return false; }
+
+    auto& front = m_Queue.front();
+    auto  cost  = GetCostEstimate(front.Kind) * front.Weight;
+
+    // 予算を超える場合は次のフレームに回す. ただし何も発行していなければ進行を優先する.
+    if (m_FrameIssued > 0 && m_FrameCost + cost > m_Budget)
+    { return false; }
+
+    unit = m_Queue.front();
+    m_Queue.pop_front();
+
+    if (m_FrameIssued == 0)
+    { m_Stats.BakeFrames++; }
+
+    m_FrameIssued++;
+    m_FrameCost += cost;
+
+    m_Stats.IssuedUnits++;
+    m_Stats.MaxFrameCost = std::max(m_Stats.MaxFrameCost, m_FrameCost);
+
+    // 計測結果が届いたときに種類ごとに分けられるよう記録する.
+    if (m_pCurrent != nullptr && unit.Kind < MaxKindCount)
+    {
+        m_pCurrent->Valid = true;
+        m_pCurrent->Weight[unit.Kind] += unit.Weight;
+        m_pCurrent->Cost  [unit.Kind] += cost;
+    }
+
+    if (m_FrameCost > m_Budget && m_FrameIssued == 1)
+    { m_Stats.OverBudgetFrames++; }
+
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+//      計測した作業時間を報告し, 見積もりを更新します.
+//-----------------------------------------------------------------------------
+void IBLBakeScheduler::Report(uint32_t kind, double measuredMs, double weight)
+{
+    if (kind >= MaxKindCount || measuredMs < 0.0 || weight < MinWeight)
+    { return; }
+
+    m_Cost[kind] += (measuredMs / weight - m_Cost[kind]) * SmoothFactor;
+}
+
+//-----------------------------------------------------------------------------
+//      フレームで発行した作業全体の計測時間を報告し, 見積もりを更新します.
+//-----------------------------------------------------------------------------
+void IBLBakeScheduler::ReportFrame(uint32_t frameIndex, double measuredMs)
+{
+    auto& issued = m_Issued[frameIndex % HistorySize];
+    if (!issued.Valid || issued.FrameIndex != frameIndex || measuredMs < 0.0)
+    { return; }
+
+    // 同じ結果で二度更新しない.
+    issued.Valid = false;
+
+    auto total = 0.0;
+    for (auto i = 0u; i < MaxKindCount; ++i)
+    { total += issued.Cost[i]; }
+
+    // 見積もりが全て0なら重みの比で分ける.
+    auto useWeight = (total <= 0.0);
+    if (useWeight)
+    {
+        for (auto i = 0u; i < MaxKindCount; ++i)
+        { total += issued.Weight[i]; }
+    }
+
+    if (total <= 0.0)
+    { return; }
+
+    for (auto i = 0u; i < MaxKindCount; ++i)
+    {
+        if (issued.Weight[i] < MinWeight)
+        { continue; }
+
+        auto share = (useWeight ? issued.Weight[i] : issued.Cost[i]) / total;
+        Report(i, measuredMs * share, issued.Weight[i]);
+    }
+}
+
+//-----------------------------------------------------------------------------
+//      未発行の作業が無いかどうかチェックします.
+//-----------------------------------------------------------------------------
+bool IBLBakeScheduler::IsEmpty() const
+{ return m_Queue.empty(); }
+
+//-----------------------------------------------------------------------------
+//      未発行の作業数を取得します.
+//-----------------------------------------------------------------------------
+size_t IBLBakeScheduler::GetPendingCount() const
+{ return m_Queue.size(); }
+
+//-----------------------------------------------------------------------------
+//      このフレームで消費した見積もりコストを取得します.
+//-----------------------------------------------------------------------------
+double IBLBakeScheduler::GetFrameCost() const
+{ return m_FrameCost; }
+
+//-----------------------------------------------------------------------------
+//      統計を取得します.
+//-----------------------------------------------------------------------------
+const IBLBakeScheduler::Stats& IBLBakeScheduler::GetStats() const
+{ return m_Stats; }
@@ -0,0 +1,476 @@
+﻿//-----------------------------------------------------------------------------
+// File : LightCluster.cpp
+// Desc : Clustered Forward Light Culling.
+// Copyright(c) Pocol. All right reserved.
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------
+#include "LightCluster.h"
+#include "PipelineStateHash.h"
+#include "Logger.h"
+#include <chrono>
+#include <cstring>
+
+
+namespace {
+
+//-----------------------------------------------------------------------------
+// Constant Values.
+//-----------------------------------------------------------------------------
+constexpr uint32_t IndexCapacity = CLUSTER_COUNT * CLUSTER_MAX_LIGHTS;     // ライト番号リストの最大要素数.
+
+// 割り当て結果の読み込み時の状態(シーンのピクセルシェーダから読む).
+constexpr D3D12_RESOURCE_STATES ReadState = D3D12_RESOURCE_STATES(
+    D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE | D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+
+//-----------------------------------------------------------------------------
+//      遷移バリアを設定します.
+//-----------------------------------------------------------------------------
+D3D12_RESOURCE_BARRIER Transition(ID3D12Resource* pResource, D3D12_RESOURCE_STATES before, D3D12_RESOURCE_STATES after)
+{
+    D3D12_RESOURCE_BARRIER barrier = {};
+    barrier.Type                    = D3D12_RESOURCE_BARRIER_TYPE_TRANSITION;
+    barrier.Transition.pResource    = pResource;
+    barrier.Transition.Subresource  = D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES;
+    barrier.Transition.StateBefore  = before;
+    barrier.Transition.StateAfter   = after;
+    return barrier;
+}
+
+} // namespace
+
+
+///////////////////////////////////////////////////////////////////////////////
+// LightCluster class
+///////////////////////////////////////////////////////////////////////////////
+
+//-----------------------------------------------------------------------------
+//      コンストラクタです.
+//-----------------------------------------------------------------------------
+LightCluster::LightCluster()
+: m_pPool               (nullptr)
+, m_pAllocator          (nullptr)
+, m_pHandleRangesUAV    (nullptr)
+, m_pHandleIndicesUAV   (nullptr)
+, m_pHandleRangesSRV    (nullptr)
+, m_pHandleIndicesSRV   (nullptr)
+, m_MaxLightCount       (0)
+, m_BufferIndex         (0)
+, m_UseCPU              (false)
+, m_CPUTimeMs           (0.0)
+{
+    for (auto i = 0u; i < FrameCount; ++i)
+    {
+        m_Lights[i]       .pHandleSRV = nullptr;
+        m_UploadRanges[i] .pHandleSRV = nullptr;
+        m_UploadIndices[i].pHandleSRV = nullptr;
+    }
+}
+
+//-----------------------------------------------------------------------------
+//      デストラクタです.
+//-----------------------------------------------------------------------------
+LightCluster::~LightCluster()
+{ Term(); }
+
+//-----------------------------------------------------------------------------
+//      初期化処理を行います.
+//-----------------------------------------------------------------------------
+bool LightCluster::Init
+(
+    ID3D12Device*                   pDevice,
+    DescriptorPool*                 pPoolRes,
+    GpuHeapAllocator*               pAllocator,
+    PipelineCache*                  pCache,
+    const D3D12_SHADER_BYTECODE&    assignCS,
+    uint32_t                        maxLightCount
+)
+{
+    if (pDevice == nullptr || pPoolRes == nullptr || pAllocator == nullptr || pCache == nullptr
+     || maxLightCount == 0 || maxLightCount > CLUSTER_MAX_LIGHT_COUNT)
+    {
+        ELOG("Error : Invalid Argument.");
+        return false;
+    }
+
+    m_pPool         = pPoolRes;
+    m_pAllocator    = pAllocator;
+    m_MaxLightCount = maxLightCount;
+
+    // GPUで割り当てる結果のバッファ.
+    if (!CreateBuffer(
+        sizeof(ClusterRange) * CLUSTER_COUNT,
+        m_pRanges.GetAddressOf(),
+        m_RangesAlloc,
+        "LightCluster.Ranges"))
+    {
+        ELOG("Error : Cluster Range Buffer Create Failed.");
+        return false;
+    }
+
+    if (!CreateBuffer(
+        sizeof(uint32_t) * IndexCapacity,
+        m_pIndices.GetAddressOf(),
+        m_IndicesAlloc,
+        "LightCluster.Indices"))
+    {
+        ELOG("Error : Light Index Buffer Create Failed.");
+        return false;
+    }
+
+    // ディスクリプタを生成.
+    {
+        m_pHandleRangesUAV  = m_pPool->AllocHandle();
+        m_pHandleIndicesUAV = m_pPool->AllocHandle();
+        m_pHandleRangesSRV  = m_pPool->AllocHandle();
+        m_pHandleIndicesSRV = m_pPool->AllocHandle();
+        if (m_pHandleRangesUAV  == nullptr
+         || m_pHandleIndicesUAV == nullptr
+         || m_pHandleRangesSRV  == nullptr
+         || m_pHandleIndicesSRV == nullptr)
+        {
+            ELOG("Error : DescriptorPool::AllocHandle() Failed.");
+            return false;
+        }
+
+        D3D12_UNORDERED_ACCESS_VIEW_DESC uavDesc = {};
+        uavDesc.Format                      = DXGI_FORMAT_UNKNOWN;
+        uavDesc.ViewDimension               = D3D12_UAV_DIMENSION_BUFFER;
+        uavDesc.Buffer.NumElements          = CLUSTER_COUNT;
+        uavDesc.Buffer.StructureByteStride  = sizeof(ClusterRange);
+        pDevice->CreateUnorderedAccessView(m_pRanges.Get(), nullptr, &uavDesc, m_pHandleRangesUAV->HandleCPU);
+
+        uavDesc.Buffer.NumElements          = IndexCapacity;
+        uavDesc.Buffer.StructureByteStride  = sizeof(uint32_t);
+        pDevice->CreateUnorderedAccessView(m_pIndices.Get(), nullptr, &uavDesc, m_pHandleIndicesUAV->HandleCPU);
+
+        D3D12_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
+        srvDesc.Format                      = DXGI_FORMAT_UNKNOWN;
+        srvDesc.ViewDimension               = D3D12_SRV_DIMENSION_BUFFER;
+        srvDesc.Shader4ComponentMapping     = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
+        srvDesc.Buffer.NumElements          = CLUSTER_COUNT;
+        srvDesc.Buffer.StructureByteStride  = sizeof(ClusterRange);
+        pDevice->CreateShaderResourceView(m_pRanges.Get(), &srvDesc, m_pHandleRangesSRV->HandleCPU);
+
+        srvDesc.Buffer.NumElements          = IndexCapacity;
+        srvDesc.Buffer.StructureByteStride  = sizeof(uint32_t);
+        pDevice->CreateShaderResourceView(m_pIndices.Get(), &srvDesc, m_pHandleIndicesSRV->HandleCPU);
+    }
+
+    // フレームごとのライトと, CPUで割り当てた結果のアップロードバッファ.
+    for (auto i = 0u; i < FrameCount; ++i)
+    {
+        if (!InitUploadBuffer(pDevice, maxLightCount, sizeof(ClusterLight), m_Lights[i])
+         || !InitUploadBuffer(pDevice, CLUSTER_COUNT, sizeof(ClusterRange), m_UploadRanges[i])
+         || !InitUploadBuffer(pDevice, IndexCapacity, sizeof(uint32_t), m_UploadIndices[i]))
+        {
+            ELOG("Error : Upload Buffer Create Failed.");
+            return false;
+        }
+
+        if (!m_CB[i].Init(pDevice, pPoolRes, sizeof(CbCluster)))
+        {
+            ELOG("Error : ConstantBuffer::Init() Failed.");
+            return false;
+        }
+    }
+
+    // ルートシグニチャを生成.
+    uint64_t rootSigHash = 0;
+    {
+        RootSignature::Desc desc;
+        desc.Begin(4)
+            .SetCBV(ShaderStage::ALL, 0, 0)
+            .SetSRV(ShaderStage::ALL, 1, 0)
+            .SetUAV(ShaderStage::ALL, 2, 0)
+            .SetUAV(ShaderStage::ALL, 3, 1)
+            .End();
+
+        if (!m_RootSig.Init(pDevice, desc.GetDesc()))
+        {
+            ELOG("Error : RootSignature::Init() Failed.");
+            return false;
+        }
+
+        rootSigHash = HashRootSignatureDesc(*desc.GetDesc());
+    }
+
+    // パイプラインステートを生成.
+    {
+        D3D12_COMPUTE_PIPELINE_STATE_DESC desc = {};
+        desc.pRootSignature = m_RootSig.GetPtr();
+        desc.CS             = assignCS;
+
+        auto hr = pCache->CreateComputePipelineState(desc, rootSigHash, m_pAssignPSO.GetAddressOf());
+        if (FAILED(hr))
+        {
+            ELOG("Error : CreateComputePipelineState() Failed. retcode = 0x%x", hr);
+            return false;
+        }
+    }
+
+    m_BufferIndex = 0;
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+//      終了処理を行います.
+//-----------------------------------------------------------------------------
+void LightCluster::Term()
+{
+    for (auto i = 0u; i < FrameCount; ++i)
+    {
+        m_CB[i].Term();
+        TermUploadBuffer(m_Lights[i]);
+        TermUploadBuffer(m_UploadRanges[i]);
+        TermUploadBuffer(m_UploadIndices[i]);
+    }
+
+    if (m_pPool != nullptr)
+    {
+        if (m_pHandleRangesUAV != nullptr)
+        { m_pPool->FreeHandle(m_pHandleRangesUAV); }
+
+        if (m_pHandleIndicesUAV != nullptr)
+        { m_pPool->FreeHandle(m_pHandleIndicesUAV); }
+
+        if (m_pHandleRangesSRV != nullptr)
+        { m_pPool->FreeHandle(m_pHandleRangesSRV); }
+
+        if (m_pHandleIndicesSRV != nullptr)
+        { m_pPool->FreeHandle(m_pHandleIndicesSRV); }
+
+        m_pPool = nullptr;
+    }
+
+    m_pHandleRangesUAV  = nullptr;
+    m_pHandleIndicesUAV = nullptr;
+    m_pHandleRangesSRV  = nullptr;
+    m_pHandleIndicesSRV = nullptr;
+
+    m_pAssignPSO.Reset();
+    m_RootSig.Term();
+    m_pRanges.Reset();
+    m_pIndices.Reset();
+    m_MaxLightCount = 0;
+
+    if (m_pAllocator != nullptr)
+    {
+        m_pAllocator->Free(m_RangesAlloc);
+        m_pAllocator->Free(m_IndicesAlloc);
+        m_pAllocator = nullptr;
+    }
+}
+
+//-----------------------------------------------------------------------------
+//      ライトをアップロードし, クラスターへの割り当てを記録します.
+//-----------------------------------------------------------------------------
+void LightCluster::Update
+(
+    ID3D12GraphicsCommandList*  pCmd,
+    const CbCluster&            constants,
+    const ClusterLight*         pLights,
+    uint32_t                    frameIndex
+)
+{
+    if (m_pAssignPSO == nullptr)
+    { return; }
+
+    m_BufferIndex = frameIndex % FrameCount;
+
+    auto cb = constants;
+    if (cb.LightCount > m_MaxLightCount)
+    { cb.LightCount = m_MaxLightCount; }
+    if (pLights == nullptr)
+    { cb.LightCount = 0; }
+
+    *m_CB[m_BufferIndex].GetPtr<CbCluster>() = cb;
+
+    if (cb.LightCount > 0)
+    { memcpy(m_Lights[m_BufferIndex].Buffer.pCpu, pLights, sizeof(ClusterLight) * cb.LightCount); }
+
+    if (m_UseCPU)
+    {
+        // CPUで割り当て, 詰めたリストをアップロードする.
+        auto start = std::chrono::steady_clock::now();
+        m_CPU.Assign(cb, pLights);
+        m_CPUTimeMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+        memcpy(m_UploadRanges[m_BufferIndex].Buffer.pCpu, m_CPU.GetRanges(), sizeof(ClusterRange) * CLUSTER_COUNT);
+        memcpy(m_UploadIndices[m_BufferIndex].Buffer.pCpu, m_CPU.GetIndices(), sizeof(uint32_t) * m_CPU.GetIndexCount());
+        return;
+    }
+
+    {
+        D3D12_RESOURCE_BARRIER barriers[] = {
+            Transition(m_pRanges .Get(), ReadState, D3D12_RESOURCE_STATE_UNORDERED_ACCESS),
+            Transition(m_pIndices.Get(), ReadState, D3D12_RESOURCE_STATE_UNORDERED_ACCESS),
+        };
+        pCmd->ResourceBarrier(_countof(barriers), barriers);
+    }
+
+    pCmd->SetComputeRootSignature(m_RootSig.GetPtr());
+    pCmd->SetComputeRootDescriptorTable(0, m_CB[m_BufferIndex].GetHandleGPU());
+    pCmd->SetComputeRootDescriptorTable(1, m_Lights[m_BufferIndex].pHandleSRV->HandleGPU);
+    pCmd->SetComputeRootDescriptorTable(2, m_pHandleRangesUAV->HandleGPU);
+    pCmd->SetComputeRootDescriptorTable(3, m_pHandleIndicesUAV->HandleGPU);
+
+    // 1グループが1クラスターを担当する.
+    pCmd->SetPipelineState(m_pAssignPSO.Get());
+    pCmd->Dispatch(CLUSTER_COUNT_X, CLUSTER_COUNT_Y, CLUSTER_COUNT_Z);
+
+    {
+        D3D12_RESOURCE_BARRIER barriers[] = {
+            Transition(m_pRanges .Get(), D3D12_RESOURCE_STATE_UNORDERED_ACCESS, ReadState),
+            Transition(m_pIndices.Get(), D3D12_RESOURCE_STATE_UNORDERED_ACCESS, ReadState),
+        };
+        pCmd->ResourceBarrier(_countof(barriers), barriers);
+    }
+}
+
+//-----------------------------------------------------------------------------
+//      CPUで割り当てるかどうかを設定します.
+//-----------------------------------------------------------------------------
+void LightCluster::SetUseCPU(bool value)
+{ m_UseCPU = value; }
+
+//-----------------------------------------------------------------------------
+//      CPUで割り当てるかどうかを取得します.
+//-----------------------------------------------------------------------------
+bool LightCluster::IsUsingCPU() const
+{ return m_UseCPU; }
+
+//-----------------------------------------------------------------------------
+//      直前の CPU 割り当ての時間[ms]を取得します.
+//-----------------------------------------------------------------------------
+double LightCluster::GetCPUTimeMs() const
+{ return m_CPUTimeMs; }
+
+//-----------------------------------------------------------------------------
+//      CPU版の割り当て結果を取得します.
+//-----------------------------------------------------------------------------
+const LightClusterCPU& LightCluster::GetCPU() const
+{ return m_CPU; }
+
+//-----------------------------------------------------------------------------
+//      定数バッファのCBVを取得します.
+//-----------------------------------------------------------------------------
+D3D12_GPU_DESCRIPTOR_HANDLE LightCluster::GetHandleCB() const
+{ return m_CB[m_BufferIndex].GetHandleGPU(); }
+
+//-----------------------------------------------------------------------------
+//      ライトバッファのSRVを取得します.
+//-----------------------------------------------------------------------------
+D3D12_GPU_DESCRIPTOR_HANDLE LightCluster::GetHandleLights() const
+{ return m_Lights[m_BufferIndex].pHandleSRV->HandleGPU; }
+
+//-----------------------------------------------------------------------------
+//      クラスターごとの範囲のSRVを取得します.
+//-----------------------------------------------------------------------------
+D3D12_GPU_DESCRIPTOR_HANDLE LightCluster::GetHandleRanges() const
+{
+    return (m_UseCPU)
+        ? m_UploadRanges[m_BufferIndex].pHandleSRV->HandleGPU
+        : m_pHandleRangesSRV->HandleGPU;
+}
+
+//-----------------------------------------------------------------------------
+//      ライト番号リストのSRVを取得します.
+//-----------------------------------------------------------------------------
+D3D12_GPU_DESCRIPTOR_HANDLE LightCluster::GetHandleIndices() const
+{
+    return (m_UseCPU)
+        ? m_UploadIndices[m_BufferIndex].pHandleSRV->HandleGPU
+        : m_pHandleIndicesSRV->HandleGPU;
+}
+
+//-----------------------------------------------------------------------------
+//      GPUで書き込むバッファを生成します.
+//-----------------------------------------------------------------------------
+bool LightCluster::CreateBuffer
+(
+    uint64_t            size,
+    ID3D12Resource**    ppResource,
+    GpuAllocation&      allocation,
+    const char*         name
+)
+{
+    D3D12_RESOURCE_DESC desc = {};
+    desc.Dimension          = D3D12_RESOURCE_DIMENSION_BUFFER;
+    desc.Width              = size;
+    desc.Height             = 1;
+    desc.DepthOrArraySize   = 1;
+    desc.MipLevels          = 1;
+    desc.Format             = DXGI_FORMAT_UNKNOWN;
+    desc.SampleDesc.Count   = 1;
+    desc.Layout             = D3D12_TEXTURE_LAYOUT_ROW_MAJOR;
+    desc.Flags              = D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS;
+
+    return m_pAllocator->CreateResource(
+        D3D12_HEAP_TYPE_DEFAULT,
+        desc,
+        ReadState,
+        nullptr,
+        ppResource,
+        allocation,
+        MEMORY_CATEGORY_OTHER,
+        name);
+}
+
+//-----------------------------------------------------------------------------
+//      マップしたアップロードバッファと構造化バッファのSRVを生成します.
+//-----------------------------------------------------------------------------
+bool LightCluster::InitUploadBuffer
+(
+    ID3D12Device*   pDevice,
+    uint32_t        count,
+    uint32_t        stride,
+    UploadBuffer&   buffer
+)
+{
+    // アップロード用のページから切り出す(マップ済み).
+    // 切り出し単位の 256 バイトは各ストライドの倍数なので, 先頭を要素番号で指定できる.
+    if (!m_pAllocator->AllocateBuffer(
+        D3D12_HEAP_TYPE_UPLOAD,
+        uint64_t(count) * stride,
+        stride,
+        buffer.Buffer,
+        MEMORY_CATEGORY_OTHER,
+        "LightCluster.Upload"))
+    { return false; }
+
+    if (buffer.Buffer.Offset % stride != 0)
+    { return false; }
+
+    buffer.pHandleSRV = m_pPool->AllocHandle();
+    if (buffer.pHandleSRV == nullptr)
+    { return false; }
+
+    D3D12_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
+    srvDesc.Format                      = DXGI_FORMAT_UNKNOWN;
+    srvDesc.ViewDimension               = D3D12_SRV_DIMENSION_BUFFER;
+    srvDesc.Shader4ComponentMapping     = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
+    srvDesc.Buffer.FirstElement         = buffer.Buffer.Offset / stride;
+    srvDesc.Buffer.NumElements          = count;
+    srvDesc.Buffer.StructureByteStride  = stride;
+    pDevice->CreateShaderResourceView(buffer.Buffer.pResource, &srvDesc, buffer.pHandleSRV->HandleCPU);
+
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+//      アップロードバッファを破棄します.
+//-----------------------------------------------------------------------------
+void LightCluster::TermUploadBuffer(UploadBuffer& buffer)
+{
+    if (buffer.pHandleSRV != nullptr && m_pPool != nullptr)
+    { m_pPool->FreeHandle(buffer.pHandleSRV); }
+
+    // ページのバッファは共有なので, アンマップせずに範囲だけ返す.
+    if (m_pAllocator != nullptr)
+    { m_pAllocator->Free(buffer.Buffer); }
+
+    buffer.pHandleSRV = nullptr;
+}
@@ -0,0 +1,435 @@
+﻿//-----------------------------------------------------------------------------
+// File : LightClusterCPU.cpp
+// Desc : Clustered Light Assignment (CPU Fallback).
+// Copyright(c) Pocol. All right reserved.
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------
+#include "LightClusterCPU.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <thread>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE__)
+#include <xmmintrin.h>
+#define CLUSTER_USE_SSE     1
+#else
+#define CLUSTER_USE_SSE     0
+#endif
+
+
+namespace {
+
+//-----------------------------------------------------------------------------
+// Constant Values.
+//-----------------------------------------------------------------------------
+constexpr uint32_t  PairLightBits   = 20;                           // 組のうちライト番号のビット数.
+constexpr uint32_t  PairLightMask   = (1u << PairLightBits) - 1;    // 組からライト番号を取り出すマスク.
+constexpr float     MinNearZ        = 1e-4f;                        // 手前の深度の下限.
+constexpr float     Cos45           = 0.70710678f;                  // 45度の余弦.
+
+static_assert(CLUSTER_MAX_LIGHT_COUNT <= (1u << PairLightBits), "Light index must fit in a pair.");
+
+//-----------------------------------------------------------------------------
+//      ジョブを並列に実行します.
+//-----------------------------------------------------------------------------
+template<typename Func>
+void ParallelFor(uint32_t jobCount, uint32_t threadCount, Func func)
+{
+    if (threadCount == 0)
+    { threadCount = std::max(1u, std::thread::hardware_concurrency()); }
+
+    threadCount = std::max(1u, std::min(threadCount, jobCount));
+
+    // ジョブはワーカースレッドが順に取りに行く.
+    std::atomic<uint32_t> next(0);
+    auto worker = [&]()
+    {
+        for (auto job = next.fetch_add(1); job < jobCount; job = next.fetch_add(1))
+        { func(job); }
+    };
+
+    std::vector<std::thread> threads;
+    threads.reserve(threadCount - 1);
+    for (auto i = 1u; i < threadCount; ++i)
+    { threads.emplace_back(worker); }
+
+    worker();
+
+    for (auto& thread : threads)
+    { thread.join(); }
+}
+
+//-----------------------------------------------------------------------------
+//      スライスの手前の深度を求めます.
+//-----------------------------------------------------------------------------
+inline float GetSliceDepth(const CbCluster& constants, uint32_t slice)
+{
+    if (slice == 0)
+    { return constants.NearZ; }
+    if (slice >= CLUSTER_COUNT_Z)
+    { return constants.FarZ; }
+
+    return std::exp((float(slice) + constants.LogDepthBias) / constants.LogDepthScale);
+}
+
+//-----------------------------------------------------------------------------
+//      正規化デバイス座標をクラスターの番号に変換します.
+//-----------------------------------------------------------------------------
+inline uint32_t ToTile(float t, uint32_t count)
+{
+    auto tile = int32_t(std::floor(t * float(count)));
+    return uint32_t(std::min(std::max(tile, 0), int32_t(count) - 1));
+}
+
+//-----------------------------------------------------------------------------
+//      ライトの境界球をワールド空間で求めます.
+//-----------------------------------------------------------------------------
+inline void GetLightSphere(const ClusterLight& light, float center[3], float& radius)
+{
+    center[0] = light.Position[0];
+    center[1] = light.Position[1];
+    center[2] = light.Position[2];
+    radius    = light.Range;
+
+    if (light.Type != CLUSTER_LIGHT_SPOT)
+    { return; }
+
+    // 円錐を囲む球. 広い円錐は底面の円, 狭い円錐は頂点と底面の円を通る球.
+    auto cosAngle = std::min(std::max(light.SpotCosOuter, 0.0f), 1.0f);
+    auto offset   = 0.0f;
+    if (cosAngle < Cos45)
+    {
+        offset = light.Range * cosAngle;
+        radius = light.Range * std::sqrt(1.0f - cosAngle * cosAngle);
+    }
+    else
+    {
+        offset = light.Range * 0.5f / cosAngle;
+        radius = offset;
+    }
+
+    center[0] += light.Direction[0] * offset;
+    center[1] += light.Direction[1] * offset;
+    center[2] += light.Direction[2] * offset;
+}
+
+} // namespace
+
+
+//-----------------------------------------------------------------------------
+//      シェーダに渡す定数を求めます.
+//-----------------------------------------------------------------------------
+CbCluster MakeClusterConstants
+(
+    const float     view[16],
+    float           projScaleX,
+    float           projScaleY,
+    float           nearZ,
+    float           farZ,
+    uint32_t        width,
+    uint32_t        height,
+    uint32_t        lightCount
+)
+{
+    nearZ = std::max(nearZ, MinNearZ);
+    farZ  = std::max(farZ, nearZ * 1.001f);
+
+    CbCluster result = {};
+    memcpy(result.View, view, sizeof(result.View));
+    result.ProjScaleX       = projScaleX;
+    result.ProjScaleY       = projScaleY;
+    result.NearZ            = nearZ;
+    result.FarZ             = farZ;
+    result.LogDepthScale    = float(CLUSTER_COUNT_Z) / std::log(farZ / nearZ);
+    result.LogDepthBias     = std::log(nearZ) * result.LogDepthScale;
+    result.ViewportWidth    = float(std::max(width,  1u));
+    result.ViewportHeight   = float(std::max(height, 1u));
+    result.LightCount       = std::min(lightCount, CLUSTER_MAX_LIGHT_COUNT);
+
+    return result;
+}
+
+//-----------------------------------------------------------------------------
+//      深度からスライス番号を求めます.
+//-----------------------------------------------------------------------------
+uint32_t GetClusterSlice(const CbCluster& constants, float depth)
+{
+    if (!(depth > constants.NearZ))
+    { return 0; }
+
+    auto slice = int32_t(std::floor(std::log(depth) * constants.LogDepthScale - constants.LogDepthBias));
+    return uint32_t(std::min(std::max(slice, 0), int32_t(CLUSTER_COUNT_Z) - 1));
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// LightClusterCPU class
+///////////////////////////////////////////////////////////////////////////////
+
+//-----------------------------------------------------------------------------
+//      コンストラクタです.
+//-----------------------------------------------------------------------------
+LightClusterCPU::LightClusterCPU()
+: m_Bounds      (size_t(CLUSTER_COUNT) * 6, 0.0f)
+, m_Ranges      (CLUSTER_COUNT)
+, m_IndexCount  (0)
+, m_Dropped     (0)
+{ /* DO_NOTHING */ }
+
+//-----------------------------------------------------------------------------
+//      デストラクタです.
+//-----------------------------------------------------------------------------
+LightClusterCPU::~LightClusterCPU()
+{ /* DO_NOTHING */ }
+
+//-----------------------------------------------------------------------------
+//      ライトをクラスターに割り当てます.
+//-----------------------------------------------------------------------------
+void LightClusterCPU::Assign(const CbCluster& constants, const ClusterLight* pLights, uint32_t threadCount)
+{
+    auto lightCount = std::min(constants.LightCount, CLUSTER_MAX_LIGHT_COUNT);
+    if (pLights == nullptr)
+    { lightCount = 0; }
+
+    BuildBounds(constants);
+
+    // ライトを連続した区間のジョブに分け, 区間ごとに組を集める.
+    auto jobCount = (lightCount + LightsPerJob - 1) / LightsPerJob;
+    if (m_Pairs.size() < jobCount)
+    { m_Pairs.resize(jobCount); }
+
+    ParallelFor(jobCount, threadCount, [&](uint32_t job)
+    {
+        auto begin = job * LightsPerJob;
+        auto end   = std::min(begin + LightsPerJob, lightCount);
+        m_Pairs[job].clear();
+        AssignLights(constants, pLights, begin, end, m_Pairs[job]);
+    });
+
+    // クラスターごとに数えて先頭位置を決める.
+    for (auto& range : m_Ranges)
+    { range.Count = 0; }
+
+    for (auto job = 0u; job < jobCount; ++job)
+    {
+        for (auto pair : m_Pairs[job])
+        { m_Ranges[pair >> PairLightBits].Count++; }
+    }
+
+    m_IndexCount = 0;
+    m_Dropped    = 0;
+    for (auto& range : m_Ranges)
+    {
+        auto count = std::min(range.Count, CLUSTER_MAX_LIGHTS);
+        m_Dropped    += range.Count - count;
+        range.Offset  = m_IndexCount;
+        range.Count   = 0;
+        m_IndexCount += count;
+    }
+
+    if (m_Indices.size() < m_IndexCount)
+    { m_Indices.resize(m_IndexCount); }
+
+    // ジョブはライト番号の順なので, 順に詰めれば各リストは昇順になる.
+    for (auto job = 0u; job < jobCount; ++job)
+    {
+        for (auto pair : m_Pairs[job])
+        {
+            auto& range = m_Ranges[pair >> PairLightBits];
+            if (range.Count < CLUSTER_MAX_LIGHTS)
+            { m_Indices[range.Offset + range.Count++] = pair & PairLightMask; }
+        }
+    }
+}
+
+//-----------------------------------------------------------------------------
+//      クラスターごとの範囲を取得します.
+//-----------------------------------------------------------------------------
+const ClusterRange* LightClusterCPU::GetRanges() const
+{ return m_Ranges.data(); }
+
+//-----------------------------------------------------------------------------
+//      ライト番号リストを取得します.
+//-----------------------------------------------------------------------------
+const uint32_t* LightClusterCPU::GetIndices() const
+{ return m_Indices.data(); }
+
+//-----------------------------------------------------------------------------
+//      ライト番号リストの要素数を取得します.
+//-----------------------------------------------------------------------------
+uint32_t LightClusterCPU::GetIndexCount() const
+{ return m_IndexCount; }
+
+//-----------------------------------------------------------------------------
+//      割り当てられなかった数を取得します.
+//-----------------------------------------------------------------------------
+uint32_t LightClusterCPU::GetDroppedCount() const
+{ return m_Dropped; }
+
+//-----------------------------------------------------------------------------
+//      クラスターの AABB を求めます.
+//-----------------------------------------------------------------------------
+void LightClusterCPU::BuildBounds(const CbCluster& constants)
+{
+    auto pMinX = m_Bounds.data();
+    auto pMinY = pMinX + CLUSTER_COUNT;
+    auto pMinZ = pMinY + CLUSTER_COUNT;
+    auto pMaxX = pMinZ + CLUSTER_COUNT;
+    auto pMaxY = pMaxX + CLUSTER_COUNT;
+    auto pMaxZ = pMaxY + CLUSTER_COUNT;
+
+    auto invScaleX = 1.0f / constants.ProjScaleX;
+    auto invScaleY = 1.0f / constants.ProjScaleY;
+
+    // Z は深度(ビュー空間の -z)で持つ.
+    for (auto z = 0u; z < CLUSTER_COUNT_Z; ++z)
+    {
+        auto dn = GetSliceDepth(constants, z);
+        auto df = GetSliceDepth(constants, z + 1);
+
+        for (auto y = 0u; y < CLUSTER_COUNT_Y; ++y)
+        {
+            // 画面の上がクラスターの y = 0.
+            auto y1 = 1.0f - 2.0f * float(y)     / float(CLUSTER_COUNT_Y);
+            auto y0 = 1.0f - 2.0f * float(y + 1) / float(CLUSTER_COUNT_Y);
+
+            for (auto x = 0u; x < CLUSTER_COUNT_X; ++x)
+            {
+                auto x0 = -1.0f + 2.0f * float(x)     / float(CLUSTER_COUNT_X);
+                auto x1 = -1.0f + 2.0f * float(x + 1) / float(CLUSTER_COUNT_X);
+
+                auto index = (z * CLUSTER_COUNT_Y + y) * CLUSTER_COUNT_X + x;
+                pMinX[index] = std::min(x0 * dn, x0 * df) * invScaleX;
+                pMaxX[index] = std::max(x1 * dn, x1 * df) * invScaleX;
+                pMinY[index] = std::min(y0 * dn, y0 * df) * invScaleY;
+                pMaxY[index] = std::max(y1 * dn, y1 * df) * invScaleY;
+                pMinZ[index] = dn;
+                pMaxZ[index] = df;
+            }
+        }
+    }
+}
+
+//-----------------------------------------------------------------------------
+//      ライトの範囲のクラスターを判定し, 組を追加します.
+//-----------------------------------------------------------------------------
+void LightClusterCPU::AssignLights
+(
+    const CbCluster&        constants,
+    const ClusterLight*     pLights,
+    uint32_t                begin,
+    uint32_t                end,
+    std::vector<uint32_t>&  pairs
+) const
+{
+    auto pMinX = m_Bounds.data();
+    auto pMinY = pMinX + CLUSTER_COUNT;
+    auto pMinZ = pMinY + CLUSTER_COUNT;
+    auto pMaxX = pMinZ + CLUSTER_COUNT;
+    auto pMaxY = pMaxX + CLUSTER_COUNT;
+    auto pMaxZ = pMaxY + CLUSTER_COUNT;
+
+    auto& m = constants.View;
+
+    for (auto i = begin; i < end; ++i)
+    {
+        float world[3];
+        float radius;
+        GetLightSphere(pLights[i], world, radius);
+        if (!(radius > 0.0f))
+        { continue; }
+
+        // ビュー空間に変換(行ベクトル). 深度は -z.
+        auto cx =   world[0] * m[0] + world[1] * m[4] + world[2] * m[ 8] + m[12];
+        auto cy =   world[0] * m[1] + world[1] * m[5] + world[2] * m[ 9] + m[13];
+        auto cd = -(world[0] * m[2] + world[1] * m[6] + world[2] * m[10] + m[14]);
+
+        if (cd + radius < constants.NearZ || cd - radius > constants.FarZ)
+        { continue; }
+
+        auto dmin = std::max(cd - radius, constants.NearZ);
+        auto dmax = std::min(cd + radius, constants.FarZ);
+
+        // 球を囲む箱の角を射影した範囲. x / d は d について単調なので端点で最大最小になる.
+        auto minNdcX = std::min((cx - radius) / dmin, (cx - radius) / dmax) * constants.ProjScaleX;
+        auto maxNdcX = std::max((cx + radius) / dmin, (cx + radius) / dmax) * constants.ProjScaleX;
+        auto minNdcY = std::min((cy - radius) / dmin, (cy - radius) / dmax) * constants.ProjScaleY;
+        auto maxNdcY = std::max((cy + radius) / dmin, (cy + radius) / dmax) * constants.ProjScaleY;
+
+        if (maxNdcX < -1.0f || minNdcX > 1.0f || maxNdcY < -1.0f || minNdcY > 1.0f)
+        { continue; }
+
+        auto tx0 = ToTile((minNdcX + 1.0f) * 0.5f, CLUSTER_COUNT_X);
+        auto tx1 = ToTile((maxNdcX + 1.0f) * 0.5f, CLUSTER_COUNT_X);
+        auto ty0 = ToTile((1.0f - maxNdcY) * 0.5f, CLUSTER_COUNT_Y);
+        auto ty1 = ToTile((1.0f - minNdcY) * 0.5f, CLUSTER_COUNT_Y);
+        auto tz0 = GetClusterSlice(constants, dmin);
+        auto tz1 = GetClusterSlice(constants, dmax);
+
+        auto radiusSq = radius * radius;
+
+    #if CLUSTER_USE_SSE
+        auto vx    = _mm_set1_ps(cx);
+        auto vy    = _mm_set1_ps(cy);
+        auto vd    = _mm_set1_ps(cd);
+        auto vr    = _mm_set1_ps(radiusSq);
+        auto zero  = _mm_setzero_ps();
+    #endif
+
+        for (auto z = tz0; z <= tz1; ++z)
+        {
+            for (auto y = ty0; y <= ty1; ++y)
+            {
+                auto row = (z * CLUSTER_COUNT_Y + y) * CLUSTER_COUNT_X;
+
+                // 横方向の4クラスターをまとめて判定する.
+                for (auto x = tx0 & ~3u; x <= tx1; x += 4)
+                {
+                    auto index = row + x;
+
+                #if CLUSTER_USE_SSE
+                    auto dx = _mm_add_ps(
+                        _mm_max_ps(_mm_sub_ps(_mm_loadu_ps(pMinX + index), vx), zero),
+                        _mm_max_ps(_mm_sub_ps(vx, _mm_loadu_ps(pMaxX + index)), zero));
+                    auto dy = _mm_add_ps(
+                        _mm_max_ps(_mm_sub_ps(_mm_loadu_ps(pMinY + index), vy), zero),
+                        _mm_max_ps(_mm_sub_ps(vy, _mm_loadu_ps(pMaxY + index)), zero));
+                    auto dz = _mm_add_ps(
+                        _mm_max_ps(_mm_sub_ps(_mm_loadu_ps(pMinZ + index), vd), zero),
+                        _mm_max_ps(_mm_sub_ps(vd, _mm_loadu_ps(pMaxZ + index)), zero));
+
+                    auto distSq = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz));
+                    auto mask   = uint32_t(_mm_movemask_ps(_mm_cmple_ps(distSq, vr)));
+                #else
+                    auto mask = 0u;
+                    for (auto k = 0u; k < 4; ++k)
+                    {
+                        auto dx = std::max(pMinX[index + k] - cx, 0.0f) + std::max(cx - pMaxX[index + k], 0.0f);
+                        auto dy = std::max(pMinY[index + k] - cy, 0.0f) + std::max(cy - pMaxY[index + k], 0.0f);
+                        auto dz = std::max(pMinZ[index + k] - cd, 0.0f) + std::max(cd - pMaxZ[index + k], 0.0f);
+                        if (dx * dx + dy * dy + dz * dz <= radiusSq)
+                        { mask |= 1u << k; }
+                    }
+                #endif
+
+                    // 射影した範囲の外は捨てる.
+                    if (x < tx0)
+                    { mask &= 0xFu << (tx0 - x); }
+                    if (x + 3 > tx1)
+                    { mask &= 0xFu >> (x + 3 - tx1); }
+
+                    for (auto k = 0u; mask != 0; ++k, mask >>= 1)
+                    {
+                        if (mask & 1u)
+                        { pairs.push_back(((index + k) << PairLightBits) | i); }
+                    }
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,351 @@
+﻿//-----------------------------------------------------------------------------
+// File : MemoryTracker.cpp
+// Desc : Memory Accounting By Category.
+// Copyright(c) Pocol. All right reserved.
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------
+#include "MemoryTracker.h"
+#include <algorithm>
+#include <cstdio>
+#include <vector>
+
+
+namespace {
+
+//-----------------------------------------------------------------------------
+// Constant Values.
+//-----------------------------------------------------------------------------
+constexpr double BytesPerMB = 1024.0 * 1024.0;     // 1MB のバイト数.
+
+//-----------------------------------------------------------------------------
+//      ドメインの名前を取得します.
+//-----------------------------------------------------------------------------
+const char* ToString(MEMORY_DOMAIN domain)
+{ return (domain == MEMORY_DOMAIN_GPU) ? "GPU" : "CPU"; }
+
+//-----------------------------------------------------------------------------
+//      バイト数をMB単位にします.
+//-----------------------------------------------------------------------------
+double ToMB(uint64_t bytes)
+{ return double(bytes) / BytesPerMB; }
+
+//-----------------------------------------------------------------------------
+//      書式付きで文字列に追加します.
+//-----------------------------------------------------------------------------
+template<typename... Args>
+void Append(std::string& result, const char* format, Args... args)
+{
+    char line[256];
+    auto length = snprintf(line, sizeof(line), format, args...);
+    if (length > 0)
+    { result.append(line, (size_t(length) < sizeof(line)) ? size_t(length) : sizeof(line) - 1); }
+}
+
+} // namespace
+
+
+///////////////////////////////////////////////////////////////////////////////
+// MemoryTracker class
+///////////////////////////////////////////////////////////////////////////////
+
+//-----------------------------------------------------------------------------
+//      コンストラクタです.
+//-----------------------------------------------------------------------------
+MemoryTracker::MemoryTracker()
+: m_VideoBudget (0)
+, m_VideoUsage  (0)
+, m_VideoPeak   (0)
+, m_NextId      (InvalidId + 1)
+{
+    for (auto i = 0u; i < MEMORY_CATEGORY_COUNT; ++i)
+    {
+        m_Budget     [i].store(0, std::memory_order_relaxed);
+        m_BudgetRatio[i].store(0.0f, std::memory_order_relaxed);
+    }
+}
+
+//-----------------------------------------------------------------------------
+//      デストラクタです.
+//-----------------------------------------------------------------------------
+MemoryTracker::~MemoryTracker()
+{ /* DO_NOTHING */ }
+
+//-----------------------------------------------------------------------------
+//      確保を記録します.
+//-----------------------------------------------------------------------------
+uint64_t MemoryTracker::Add(MEMORY_CATEGORY category, MEMORY_DOMAIN domain, uint64_t bytes, const char* name)
+{
+    if (category >= MEMORY_CATEGORY_COUNT || domain >= MEMORY_DOMAIN_COUNT)
+    { return InvalidId; }
+
+    Increase(m_Counters[category][domain], bytes);
+    Increase(m_Totals[domain], bytes);
+
+    auto id = m_NextId.fetch_add(1, std::memory_order_relaxed);
+
+    std::lock_guard<std::mutex> locker(m_Mutex);
+    m_Records[id] = Record{ category, domain, bytes, name };
+
+    return id;
+}
+
+//-----------------------------------------------------------------------------
+//      解放を記録します.
+//-----------------------------------------------------------------------------
+void MemoryTracker::Remove(uint64_t id)
+{
+    if (id == InvalidId)
+    { return; }
+
+    Record record;
+    {
+        std::lock_guard<std::mutex> locker(m_Mutex);
+        auto itr = m_Records.find(id);
+        if (itr == m_Records.end())
+        { return; }
+
+        record = itr->second;
+        m_Records.erase(itr);
+    }
+
+    Counter* counters[] = {
+        &m_Counters[record.Category][record.Domain],
+        &m_Totals[record.Domain],
+    };
+
+    for (auto pCounter : counters)
+    {
+        pCounter->Current.fetch_sub(record.Bytes, std::memory_order_relaxed);
+        pCounter->Live   .fetch_sub(1, std::memory_order_relaxed);
+    }
+}
+
+//-----------------------------------------------------------------------------
+//      カテゴリごとの統計を取得します.
+//-----------------------------------------------------------------------------
+MemoryStats MemoryTracker::GetStats(MEMORY_CATEGORY category, MEMORY_DOMAIN domain) const
+{
+    MemoryStats result = {};
+    if (category >= MEMORY_CATEGORY_COUNT || domain >= MEMORY_DOMAIN_COUNT)
+    { return result; }
+
+    auto& counter = m_Counters[category][domain];
+    result.CurrentBytes = counter.Current.load(std::memory_order_relaxed);
+    result.PeakBytes    = counter.Peak   .load(std::memory_order_relaxed);
+    result.LiveCount    = counter.Live   .load(std::memory_order_relaxed);
+    result.TotalCount   = counter.Total  .load(std::memory_order_relaxed);
+    return result;
+}
+
+//-----------------------------------------------------------------------------
+//      ドメイン全体の現在の使用量を取得します.
+//-----------------------------------------------------------------------------
+uint64_t MemoryTracker::GetCurrentBytes(MEMORY_DOMAIN domain) const
+{
+    if (domain >= MEMORY_DOMAIN_COUNT)
+    { return 0; }
+
+    return m_Totals[domain].Current.load(std::memory_order_relaxed);
+}
+
+//-----------------------------------------------------------------------------
+//      カテゴリの予算をバイト数で設定します.
+//-----------------------------------------------------------------------------
+void MemoryTracker::SetBudget(MEMORY_CATEGORY category, uint64_t bytes)
+{
+    if (category < MEMORY_CATEGORY_COUNT)
+    { m_Budget[category].store(bytes, std::memory_order_relaxed); }
+}
+
+//-----------------------------------------------------------------------------
+//      カテゴリの予算をビデオメモリ予算に対する比率で設定します.
+//-----------------------------------------------------------------------------
+void MemoryTracker::SetBudgetRatio(MEMORY_CATEGORY category, float ratio)
+{
+    if (category < MEMORY_CATEGORY_COUNT)
+    { m_BudgetRatio[category].store((ratio > 0.0f) ? ratio : 0.0f, std::memory_order_relaxed); }
+}
+
+//-----------------------------------------------------------------------------
+//      カテゴリの予算を取得します.
+//-----------------------------------------------------------------------------
+uint64_t MemoryTracker::GetBudget(MEMORY_CATEGORY category) const
+{
+    if (category >= MEMORY_CATEGORY_COUNT)
+    { return 0; }
+
+    // バイト数の指定を優先する.
+    auto bytes = m_Budget[category].load(std::memory_order_relaxed);
+    if (bytes != 0)
+    { return bytes; }
+
+    auto ratio  = m_BudgetRatio[category].load(std::memory_order_relaxed);
+    auto budget = m_VideoBudget.load(std::memory_order_relaxed);
+    return uint64_t(double(budget) * ratio);
+}
+
+//-----------------------------------------------------------------------------
+//      ビデオメモリの予算と使用量を更新し, カテゴリごとの予算を確認します.
+//-----------------------------------------------------------------------------
+uint32_t MemoryTracker::CheckBudgets(uint64_t videoBudget, uint64_t videoUsage)
+{
+    m_VideoBudget.store(videoBudget, std::memory_order_relaxed);
+    m_VideoUsage .store(videoUsage,  std::memory_order_relaxed);
+
+    auto peak = m_VideoPeak.load(std::memory_order_relaxed);
+    while (videoUsage > peak && !m_VideoPeak.compare_exchange_weak(peak, videoUsage, std::memory_order_relaxed))
+    { /* DO_NOTHING */ }
+
+    uint32_t result = 0;
+    for (auto i = 0u; i < MEMORY_CATEGORY_COUNT; ++i)
+    {
+        auto budget  = GetBudget(MEMORY_CATEGORY(i));
+        auto current = m_Counters[i][MEMORY_DOMAIN_GPU].Current.load(std::memory_order_relaxed);
+        if (budget != 0 && current > budget)
+        { result |= 1u << i; }
+    }
+
+    return result;
+}
+
+//-----------------------------------------------------------------------------
+//      カテゴリの名前を取得します.
+//-----------------------------------------------------------------------------
+const char* MemoryTracker::GetName(MEMORY_CATEGORY category)
+{
+    switch (category)
+    {
+    case MEMORY_CATEGORY_TEXTURE:           return "Texture";
+    case MEMORY_CATEGORY_MESH:              return "Mesh";
+    case MEMORY_CATEGORY_CONSTANT_BUFFER:   return "Constant Buffer";
+    case MEMORY_CATEGORY_RENDER_TARGET:     return "Render Target";
+    case MEMORY_CATEGORY_IBL:               return "IBL";
+    case MEMORY_CATEGORY_SHADER:            return "Shader";
+    case MEMORY_CATEGORY_OTHER:             return "Other";
+    default:                                return "Unknown";
+    }
+}
+
+//-----------------------------------------------------------------------------
+//      現在の使用量, 最大使用量, 予算のレポートを作成します.
+//-----------------------------------------------------------------------------
+std::string MemoryTracker::FormatReport() const
+{
+    std::string result;
+
+    auto videoBudget = m_VideoBudget.load(std::memory_order_relaxed);
+    if (videoBudget != 0)
+    {
+        Append(result, "Video Memory : usage %.2f MB / budget %.2f MB (peak %.2f MB)\n",
+            ToMB(m_VideoUsage.load(std::memory_order_relaxed)),
+            ToMB(videoBudget),
+            ToMB(m_VideoPeak.load(std::memory_order_relaxed)));
+    }
+
+    Append(result, "%-16s %12s %12s %8s %12s %12s %12s\n",
+        "Category", "GPU [MB]", "GPU Peak", "Live", "Budget", "CPU [MB]", "CPU Peak");
+
+    for (auto i = 0u; i < MEMORY_CATEGORY_COUNT; ++i)
+    {
+        auto category = MEMORY_CATEGORY(i);
+        auto gpu      = GetStats(category, MEMORY_DOMAIN_GPU);
+        auto cpu      = GetStats(category, MEMORY_DOMAIN_CPU);
+        auto budget   = GetBudget(category);
+
+        char budgetText[32] = "-";
+        if (budget != 0)
+        { snprintf(budgetText, sizeof(budgetText), "%.2f%s", ToMB(budget), (gpu.CurrentBytes > budget) ? " !" : ""); }
+
+        Append(result, "%-16s %12.2f %12.2f %8llu %12s %12.2f %12.2f\n",
+            GetName(category),
+            ToMB(gpu.CurrentBytes),
+            ToMB(gpu.PeakBytes),
+            static_cast<unsigned long long>(gpu.LiveCount + cpu.LiveCount),
+            budgetText,
+            ToMB(cpu.CurrentBytes),
+            ToMB(cpu.PeakBytes));
+    }
+
+    for (auto i = 0u; i < MEMORY_DOMAIN_COUNT; ++i)
+    {
+        auto& total = m_Totals[i];
+        Append(result, "Total %s : %.2f MB (peak %.2f MB, %llu allocations)\n",
+            ToString(MEMORY_DOMAIN(i)),
+            ToMB(total.Current.load(std::memory_order_relaxed)),
+            ToMB(total.Peak   .load(std::memory_order_relaxed)),
+            static_cast<unsigned long long>(total.Total.load(std::memory_order_relaxed)));
+    }
+
+    return result;
+}
+
+//-----------------------------------------------------------------------------
+//      解放されていない確保のレポートを作成します.
+//-----------------------------------------------------------------------------
+std::string MemoryTracker::FormatLeakReport() const
+{
+    std::vector<std::pair<uint64_t, Record>> records;
+    {
+        std::lock_guard<std::mutex> locker(m_Mutex);
+        records.assign(m_Records.begin(), m_Records.end());
+    }
+
+    std::string result;
+    if (records.empty())
+    {
+        result = "Memory Leaks : none\n";
+        return result;
+    }
+
+    // 確保した順に並べる.
+    std::sort(records.begin(), records.end(),
+        [](const std::pair<uint64_t, Record>& lhs, const std::pair<uint64_t, Record>& rhs)
+        { return lhs.first < rhs.first; });
+
+    uint64_t bytes = 0;
+    for (auto& itr : records)
+    { bytes += itr.second.Bytes; }
+
+    Append(result, "Memory Leaks : %llu allocations, %.2f MB\n",
+        static_cast<unsigned long long>(records.size()), ToMB(bytes));
+
+    for (auto& itr : records)
+    {
+        auto& record = itr.second;
+        Append(result, "  #%llu %s %-16s %12llu bytes  %s\n",
+            static_cast<unsigned long long>(itr.first),
+            ToString(record.Domain),
+            GetName(record.Category),
+            static_cast<unsigned long long>(record.Bytes),
+            (record.Name != nullptr) ? record.Name : "(unnamed)");
+    }
+
+    return result;
+}
+
+//-----------------------------------------------------------------------------
+//      カウンタに加算し, 最大値を更新します.
+//-----------------------------------------------------------------------------
+void MemoryTracker::Increase(Counter& counter, uint64_t bytes)
+{
+    auto current = counter.Current.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+    counter.Live .fetch_add(1, std::memory_order_relaxed);
+    counter.Total.fetch_add(1, std::memory_order_relaxed);
+
+    auto peak = counter.Peak.load(std::memory_order_relaxed);
+    while (current > peak && !counter.Peak.compare_exchange_weak(peak, current, std::memory_order_relaxed))
+    { /* DO_NOTHING */ }
+}
+
+
+//-----------------------------------------------------------------------------
+//      プロセス全体で共有するメモリトラッカーを取得します.
+//-----------------------------------------------------------------------------
+MemoryTracker& GetMemoryTracker()
+{
+    static MemoryTracker s_Tracker;
+    return s_Tracker;
+}
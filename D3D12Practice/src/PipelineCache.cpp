@@ -0,0 +1,206 @@
+﻿//-----------------------------------------------------------------------------
+// File : PipelineCache.cpp
+// Desc : Persistent Pipeline State Cache.
+// Copyright(c) Pocol. All right reserved.
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------
+#include "PipelineCache.h"
+#include <chrono>
+#include <vector>
+#include <wrl/client.h>
+
+
+namespace {
+
+//-----------------------------------------------------------------------------
+//      経過時間[ms]を求めます.
+//-----------------------------------------------------------------------------
+double ElapsedMs(std::chrono::steady_clock::time_point begin)
+{
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::milli>(end - begin).count();
+}
+
+} // namespace
+
+
+///////////////////////////////////////////////////////////////////////////////
+// PipelineCache class
+///////////////////////////////////////////////////////////////////////////////
+
+//-----------------------------------------------------------------------------
+//      コンストラクタです.
+//-----------------------------------------------------------------------------
+PipelineCache::PipelineCache()
+: m_pDevice (nullptr)
+, m_Stats   ()
+{ /* DO_NOTHING */ }
+
+//-----------------------------------------------------------------------------
+//      デストラクタです.
+//-----------------------------------------------------------------------------
+PipelineCache::~PipelineCache()
+{ Term(); }
+
+//-----------------------------------------------------------------------------
+//      初期化処理を行います.
+//-----------------------------------------------------------------------------
+bool PipelineCache::Init(ID3D12Device* pDevice, const wchar_t* path)
+{
+    if (pDevice == nullptr || path == nullptr)
+    { return false; }
+
+    std::lock_guard<std::mutex> locker(m_Mutex);
+
+    m_pDevice = pDevice;
+    m_Path    = path;
+    m_Stats   = Stats();
+
+    // 読み込めなくても空のキャッシュとして続行する.
+    m_File.Load(m_Path);
+
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+//      終了処理を行います.
+//-----------------------------------------------------------------------------
+void PipelineCache::Term()
+{
+    if (m_pDevice == nullptr)
+    { return; }
+
+    Save();
+
+    std::lock_guard<std::mutex> locker(m_Mutex);
+    m_File.Clear();
+    m_pDevice = nullptr;
+}
+
+//-----------------------------------------------------------------------------
+//      キャッシュをファイルに保存します.
+//-----------------------------------------------------------------------------
+bool PipelineCache::Save()
+{
+    std::lock_guard<std::mutex> locker(m_Mutex);
+
+    if (!m_File.IsDirty())
+    { return true; }
+
+    return m_File.Save(m_Path);
+}
+
+//-----------------------------------------------------------------------------
+//      グラフィックスパイプラインステートを生成します.
+//-----------------------------------------------------------------------------
+HRESULT PipelineCache::CreateGraphicsPipelineState
+(
+    const D3D12_GRAPHICS_PIPELINE_STATE_DESC&   desc,
+    uint64_t                                    rootSigHash,
+    ID3D12PipelineState**                       ppPSO
+)
+{
+    auto key = HashGraphicsPipelineStateDesc(desc, rootSigHash);
+    return CreateCore(desc, key, ppPSO,
+        [this](const D3D12_GRAPHICS_PIPELINE_STATE_DESC& d, ID3D12PipelineState** pp)
+        { return m_pDevice->CreateGraphicsPipelineState(&d, IID_PPV_ARGS(pp)); });
+}
+
+//-----------------------------------------------------------------------------
+//      コンピュートパイプラインステートを生成します.
+//-----------------------------------------------------------------------------
+HRESULT PipelineCache::CreateComputePipelineState
+(
+    const D3D12_COMPUTE_PIPELINE_STATE_DESC&    desc,
+    uint64_t                                    rootSigHash,
+    ID3D12PipelineState**                       ppPSO
+)
+{
+    auto key = HashComputePipelineStateDesc(desc, rootSigHash);
+    return CreateCore(desc, key, ppPSO,
+        [this](const D3D12_COMPUTE_PIPELINE_STATE_DESC& d, ID3D12PipelineState** pp)
+        { return m_pDevice->CreateComputePipelineState(&d, IID_PPV_ARGS(pp)); });
+}
+
+//-----------------------------------------------------------------------------
+//      キャッシュを用いてパイプラインステートを生成します.
+//-----------------------------------------------------------------------------
+template<typename DescType, typename CreateFunc>
+HRESULT PipelineCache::CreateCore
+(
+    const DescType&         desc,
+    uint64_t                key,
+    ID3D12PipelineState**   ppPSO,
+    CreateFunc              create
+)
+{
+    if (m_pDevice == nullptr || ppPSO == nullptr)
+    { return E_INVALIDARG; }
+
+    auto begin = std::chrono::steady_clock::now();
+
+    // キャッシュ済みのブロブを探す(生成中はロックしない).
+    std::vector<uint8_t> blob;
+    {
+        std::lock_guard<std::mutex> locker(m_Mutex);
+        auto pEntry = m_File.Find(key);
+        if (pEntry != nullptr)
+        { blob = *pEntry; }
+    }
+
+    if (!blob.empty())
+    {
+        auto cached = desc;
+        cached.CachedPSO.pCachedBlob           = blob.data();
+        cached.CachedPSO.CachedBlobSizeInBytes = blob.size();
+
+        auto hr = create(cached, ppPSO);
+        if (SUCCEEDED(hr))
+        {
+            std::lock_guard<std::mutex> locker(m_Mutex);
+            m_Stats.Hits++;
+            m_Stats.HitTimeMs += ElapsedMs(begin);
+            return hr;
+        }
+
+        // ドライバ更新やアダプタ変更で無効になったブロブは捨てる.
+        std::lock_guard<std::mutex> locker(m_Mutex);
+        m_Stats.Rejected++;
+        m_File.Remove(key);
+    }
+
+    auto uncached = desc;
+    uncached.CachedPSO.pCachedBlob           = nullptr;
+    uncached.CachedPSO.CachedBlobSizeInBytes = 0;
+
+    auto hr = create(uncached, ppPSO);
+    if (FAILED(hr))
+    { return hr; }
+
+    Microsoft::WRL::ComPtr<ID3DBlob> pBlob;
+    auto hrBlob = (*ppPSO)->GetCachedBlob(pBlob.GetAddressOf());
+
+    std::lock_guard<std::mutex> locker(m_Mutex);
+    m_Stats.Misses++;
+    m_Stats.MissTimeMs += ElapsedMs(begin);
+
+    if (SUCCEEDED(hrBlob) && pBlob != nullptr && pBlob->GetBufferSize() > 0)
+    {
+        m_File.Store(key, pBlob->GetBufferPointer(), pBlob->GetBufferSize());
+        m_Stats.Stored++;
+    }
+
+    return hr;
+}
+
+//-----------------------------------------------------------------------------
+//      統計を取得します.
+//-----------------------------------------------------------------------------
+PipelineCache::Stats PipelineCache::GetStats() const
+{
+    std::lock_guard<std::mutex> locker(m_Mutex);
+    return m_Stats;
+}
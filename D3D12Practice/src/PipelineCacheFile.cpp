@@ -0,0 +1,207 @@
+﻿//-----------------------------------------------------------------------------
+// File : PipelineCacheFile.cpp
+// Desc : Pipeline State Cache File.
+// Copyright(c) Pocol. All right reserved.
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------
+#include "PipelineCacheFile.h"
+#include "Hash.h"
+#include <algorithm>
+#include <fstream>
+
+
+namespace {
+
+///////////////////////////////////////////////////////////////////////////////
+// FileHeader structure
+///////////////////////////////////////////////////////////////////////////////
+struct FileHeader
+{
+    uint32_t    Magic;
+    uint32_t    Version;
+    uint32_t    EntryCount;
+    uint32_t    Reserved;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// EntryHeader structure
+///////////////////////////////////////////////////////////////////////////////
+struct EntryHeader
+{
+    uint64_t    Key;
+    uint64_t    Size;
+    uint64_t    Checksum;
+};
+
+static_assert(sizeof(FileHeader)  == 16, "Invalid file header size.");
+static_assert(sizeof(EntryHeader) == 24, "Invalid entry header size.");
+
+//-----------------------------------------------------------------------------
+// Constant Values.
+//-----------------------------------------------------------------------------
+constexpr uint64_t MaxEntrySize = 64ull * 1024 * 1024;  // 1エントリの上限サイズ.
+
+} // namespace
+
+
+///////////////////////////////////////////////////////////////////////////////
+// PipelineCacheFile class
+///////////////////////////////////////////////////////////////////////////////
+
+//-----------------------------------------------------------------------------
+//      ファイルから読み込みます.
+//-----------------------------------------------------------------------------
+bool PipelineCacheFile::Load(const std::filesystem::path& path)
+{
+    m_Entries.clear();
+    m_Dirty = false;
+
+    std::ifstream stream(path, std::ios::binary);
+    if (!stream.is_open())
+    { return false; }
+
+    FileHeader header = {};
+    stream.read(reinterpret_cast<char*>(&header), sizeof(header));
+    if (!stream || header.Magic != Magic || header.Version != Version)
+    { return false; }
+
+    for (auto i = 0u; i < header.EntryCount; ++i)
+    {
+        EntryHeader entry = {};
+        stream.read(reinterpret_cast<char*>(&entry), sizeof(entry));
+        if (!stream || entry.Size > MaxEntrySize)
+        { break; }
+
+        std::vector<uint8_t> data(size_t(entry.Size));
+        stream.read(reinterpret_cast<char*>(data.data()), std::streamsize(data.size()));
+        if (!stream)
+        { break; }
+
+        // 破損したエントリは捨てる.
+        if (HashFNV1a64(data.data(), data.size()) != entry.Checksum)
+        {
+            m_Dirty = true;
+            continue;
+        }
+
+        m_Entries[entry.Key] = std::move(data);
+    }
+
+    if (m_Entries.size() != header.EntryCount)
+    { m_Dirty = true; }
+
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+//      ファイルに書き出します.
+//-----------------------------------------------------------------------------
+bool PipelineCacheFile::Save(const std::filesystem::path& path)
+{
+    // 書き込み途中で落ちても既存のファイルを壊さないよう一時ファイルに書き出す.
+    auto tempPath = path;
+    tempPath += ".tmp";
+
+    {
+        std::ofstream stream(tempPath, std::ios::binary | std::ios::trunc);
+        if (!stream.is_open())
+        { return false; }
+
+        FileHeader header = {};
+        header.Magic      = Magic;
+        header.Version    = Version;
+        header.EntryCount = uint32_t(m_Entries.size());
+        stream.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+        // 出力を決定的にするためキー順に並べる.
+        std::vector<uint64_t> keys;
+        keys.reserve(m_Entries.size());
+        for (auto& itr : m_Entries)
+        { keys.push_back(itr.first); }
+        std::sort(keys.begin(), keys.end());
+
+        for (auto key : keys)
+        {
+            auto& data = m_Entries.at(key);
+
+            EntryHeader entry = {};
+            entry.Key      = key;
+            entry.Size     = data.size();
+            entry.Checksum = HashFNV1a64(data.data(), data.size());
+
+            stream.write(reinterpret_cast<const char*>(&entry), sizeof(entry));
+            stream.write(reinterpret_cast<const char*>(data.data()), std::streamsize(data.size()));
+        }
+
+        if (!stream)
+        { return false; }
+    }
+
+    std::error_code ec;
+    std::filesystem::rename(tempPath, path, ec);
+    if (ec)
+    {
+        std::filesystem::remove(tempPath, ec);
+        return false;
+    }
+
+    m_Dirty = false;
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+//      エントリを検索します.
+//-----------------------------------------------------------------------------
+const std::vector<uint8_t>* PipelineCacheFile::Find(uint64_t key) const
+{
+    auto itr = m_Entries.find(key);
+    if (itr == m_Entries.end())
+    { return nullptr; }
+
+    return &itr->second;
+}
+
+//-----------------------------------------------------------------------------
+//      エントリを登録します.
+//-----------------------------------------------------------------------------
+void PipelineCacheFile::Store(uint64_t key, const void* pData, size_t size)
+{
+    auto ptr = static_cast<const uint8_t*>(pData);
+    m_Entries[key].assign(ptr, ptr + size);
+    m_Dirty = true;
+}
+
+//-----------------------------------------------------------------------------
+//      エントリを削除します.
+//-----------------------------------------------------------------------------
+void PipelineCacheFile::Remove(uint64_t key)
+{
+    if (m_Entries.erase(key) > 0)
+    { m_Dirty = true; }
+}
+
+//-----------------------------------------------------------------------------
+//      全てのエントリを削除します.
+//-----------------------------------------------------------------------------
+void PipelineCacheFile::Clear()
+{
+    if (!m_Entries.empty())
+    { m_Dirty = true; }
+
+    m_Entries.clear();
+}
+
+//-----------------------------------------------------------------------------
+//      エントリ数を取得します.
+//-----------------------------------------------------------------------------
+size_t PipelineCacheFile::GetCount() const
+{ return m_Entries.size(); }
+
+//-----------------------------------------------------------------------------
+//      未保存の変更があるかどうかチェックします.
+//-----------------------------------------------------------------------------
+bool PipelineCacheFile::IsDirty() const
+{ return m_Dirty; }
@@ -0,0 +1,292 @@
+﻿//-----------------------------------------------------------------------------
+// File : PipelineStateHash.cpp
+// Desc : Pipeline State Description Hash.
+// Copyright(c) Pocol. All right reserved.
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------
+#include "PipelineStateHash.h"
+#include "Hash.h"
+
+
+namespace {
+
+//-----------------------------------------------------------------------------
+// Constant Values.
+//-----------------------------------------------------------------------------
+constexpr uint32_t HashVersion     = 1;          // 正規化規則を変更したら更新すること.
+constexpr uint32_t TagGraphics     = 0x53505347; // "GSPS"
+constexpr uint32_t TagCompute      = 0x53505343; // "CSPS"
+
+//-----------------------------------------------------------------------------
+//      シェーダを追加します.
+//-----------------------------------------------------------------------------
+void AddShader(Hasher& hasher, const D3D12_SHADER_BYTECODE& bytecode)
+{
+    hasher.Add(uint64_t(bytecode.BytecodeLength));
+    hasher.Add(HashShaderBytecode(bytecode));
+}
+
+//-----------------------------------------------------------------------------
+//      ステンシル操作を追加します.
+//-----------------------------------------------------------------------------
+void AddStencilOp(Hasher& hasher, const D3D12_DEPTH_STENCILOP_DESC& desc)
+{
+    hasher.Add(desc.StencilFailOp)
+          .Add(desc.StencilDepthFailOp)
+          .Add(desc.StencilPassOp)
+          .Add(desc.StencilFunc);
+}
+
+//-----------------------------------------------------------------------------
+//      ブレンドステートを追加します.
+//-----------------------------------------------------------------------------
+void AddBlendState(Hasher& hasher, const D3D12_BLEND_DESC& desc, UINT numRenderTargets)
+{
+    hasher.Add(desc.AlphaToCoverageEnable)
+          .Add(desc.IndependentBlendEnable);
+
+    // 独立ブレンドでなければ先頭の設定のみ有効.
+    auto count = (desc.IndependentBlendEnable) ? numRenderTargets : 1u;
+    if (count > D3D12_SIMULTANEOUS_RENDER_TARGET_COUNT)
+    { count = D3D12_SIMULTANEOUS_RENDER_TARGET_COUNT; }
+
+    for (auto i = 0u; i < count; ++i)
+    {
+        auto& rt = desc.RenderTarget[i];
+        hasher.Add(rt.BlendEnable)
+              .Add(rt.LogicOpEnable)
+              .Add(rt.RenderTargetWriteMask);
+
+        if (rt.BlendEnable)
+        {
+            hasher.Add(rt.SrcBlend)
+                  .Add(rt.DestBlend)
+                  .Add(rt.BlendOp)
+                  .Add(rt.SrcBlendAlpha)
+                  .Add(rt.DestBlendAlpha)
+                  .Add(rt.BlendOpAlpha);
+        }
+
+        if (rt.LogicOpEnable)
+        { hasher.Add(rt.LogicOp); }
+    }
+}
+
+//-----------------------------------------------------------------------------
+//      ラスタライザーステートを追加します.
+//-----------------------------------------------------------------------------
+void AddRasterizerState(Hasher& hasher, const D3D12_RASTERIZER_DESC& desc)
+{
+    hasher.Add(desc.FillMode)
+          .Add(desc.CullMode)
+          .Add(desc.FrontCounterClockwise)
+          .Add(desc.DepthBias)
+          .Add(desc.DepthBiasClamp)
+          .Add(desc.SlopeScaledDepthBias)
+          .Add(desc.DepthClipEnable)
+          .Add(desc.MultisampleEnable)
+          .Add(desc.AntialiasedLineEnable)
+          .Add(desc.ForcedSampleCount)
+          .Add(desc.ConservativeRaster);
+}
+
+//-----------------------------------------------------------------------------
+//      深度ステンシルステートを追加します.
+//-----------------------------------------------------------------------------
+void AddDepthStencilState(Hasher& hasher, const D3D12_DEPTH_STENCIL_DESC& desc)
+{
+    hasher.Add(desc.DepthEnable);
+    if (desc.DepthEnable)
+    {
+        hasher.Add(desc.DepthWriteMask)
+              .Add(desc.DepthFunc);
+    }
+
+    hasher.Add(desc.StencilEnable);
+    if (desc.StencilEnable)
+    {
+        hasher.Add(desc.StencilReadMask)
+              .Add(desc.StencilWriteMask);
+        AddStencilOp(hasher, desc.FrontFace);
+        AddStencilOp(hasher, desc.BackFace);
+    }
+}
+
+} // namespace
+
+
+//-----------------------------------------------------------------------------
+//      シェーダバイトコードのハッシュ値を計算します.
+//-----------------------------------------------------------------------------
+uint64_t HashShaderBytecode(const D3D12_SHADER_BYTECODE& bytecode)
+{
+    if (bytecode.pShaderBytecode == nullptr || bytecode.BytecodeLength == 0)
+    { return 0; }
+
+    return HashFNV1a64(bytecode.pShaderBytecode, bytecode.BytecodeLength);
+}
+
+//-----------------------------------------------------------------------------
+//      ルートシグニチャ設定のハッシュ値を計算します.
+//-----------------------------------------------------------------------------
+uint64_t HashRootSignatureDesc(const D3D12_ROOT_SIGNATURE_DESC& desc)
+{
+    Hasher hasher;
+    hasher.Add(HashVersion)
+          .Add(desc.Flags)
+          .Add(desc.NumParameters);
+
+    for (auto i = 0u; i < desc.NumParameters; ++i)
+    {
+        auto& param = desc.pParameters[i];
+        hasher.Add(param.ParameterType)
+              .Add(param.ShaderVisibility);
+
+        switch (param.ParameterType)
+        {
+        case D3D12_ROOT_PARAMETER_TYPE_DESCRIPTOR_TABLE:
+            {
+                auto& table = param.DescriptorTable;
+                hasher.Add(table.NumDescriptorRanges);
+                for (auto j = 0u; j < table.NumDescriptorRanges; ++j)
+                {
+                    auto& range = table.pDescriptorRanges[j];
+                    hasher.Add(range.RangeType)
+                          .Add(range.NumDescriptors)
+                          .Add(range.BaseShaderRegister)
+                          .Add(range.RegisterSpace)
+                          .Add(range.OffsetInDescriptorsFromTableStart);
+                }
+            }
+            break;
+
+        case D3D12_ROOT_PARAMETER_TYPE_32BIT_CONSTANTS:
+            {
+                hasher.Add(param.Constants.ShaderRegister)
+                      .Add(param.Constants.RegisterSpace)
+                      .Add(param.Constants.Num32BitValues);
+            }
+            break;
+
+        default:
+            {
+                hasher.Add(param.Descriptor.ShaderRegister)
+                      .Add(param.Descriptor.RegisterSpace);
+            }
+            break;
+        }
+    }
+
+    hasher.Add(desc.NumStaticSamplers);
+    for (auto i = 0u; i < desc.NumStaticSamplers; ++i)
+    {
+        auto& smp = desc.pStaticSamplers[i];
+        hasher.Add(smp.Filter)
+              .Add(smp.AddressU)
+              .Add(smp.AddressV)
+              .Add(smp.AddressW)
+              .Add(smp.MipLODBias)
+              .Add(smp.MaxAnisotropy)
+              .Add(smp.ComparisonFunc)
+              .Add(smp.BorderColor)
+              .Add(smp.MinLOD)
+              .Add(smp.MaxLOD)
+              .Add(smp.ShaderRegister)
+              .Add(smp.RegisterSpace)
+              .Add(smp.ShaderVisibility);
+    }
+
+    return hasher.GetValue();
+}
+
+//-----------------------------------------------------------------------------
+//      グラフィックスパイプラインステート設定のハッシュ値を計算します.
+//-----------------------------------------------------------------------------
+uint64_t HashGraphicsPipelineStateDesc(const D3D12_GRAPHICS_PIPELINE_STATE_DESC& desc, uint64_t rootSigHash)
+{
+    Hasher hasher;
+    hasher.Add(HashVersion)
+          .Add(TagGraphics)
+          .Add(rootSigHash);
+
+    AddShader(hasher, desc.VS);
+    AddShader(hasher, desc.PS);
+    AddShader(hasher, desc.DS);
+    AddShader(hasher, desc.HS);
+    AddShader(hasher, desc.GS);
+
+    // ストリーム出力.
+    auto& so = desc.StreamOutput;
+    hasher.Add(so.NumEntries);
+    for (auto i = 0u; i < so.NumEntries; ++i)
+    {
+        auto& entry = so.pSODeclaration[i];
+        hasher.Add(entry.Stream)
+              .AddString(entry.SemanticName)
+              .Add(entry.SemanticIndex)
+              .Add(entry.StartComponent)
+              .Add(entry.ComponentCount)
+              .Add(entry.OutputSlot);
+    }
+    hasher.Add(so.NumStrides);
+    for (auto i = 0u; i < so.NumStrides; ++i)
+    { hasher.Add(so.pBufferStrides[i]); }
+    if (so.NumEntries > 0)
+    { hasher.Add(so.RasterizedStream); }
+
+    AddBlendState       (hasher, desc.BlendState, desc.NumRenderTargets);
+    hasher.Add(desc.SampleMask);
+    AddRasterizerState  (hasher, desc.RasterizerState);
+    AddDepthStencilState(hasher, desc.DepthStencilState);
+
+    // 入力レイアウト.
+    hasher.Add(desc.InputLayout.NumElements);
+    for (auto i = 0u; i < desc.InputLayout.NumElements; ++i)
+    {
+        auto& element = desc.InputLayout.pInputElementDescs[i];
+        hasher.AddString(element.SemanticName)
+              .Add(element.SemanticIndex)
+              .Add(element.Format)
+              .Add(element.InputSlot)
+              .Add(element.AlignedByteOffset)
+              .Add(element.InputSlotClass)
+              .Add(element.InstanceDataStepRate);
+    }
+
+    hasher.Add(desc.IBStripCutValue)
+          .Add(desc.PrimitiveTopologyType)
+          .Add(desc.NumRenderTargets);
+
+    // 使用するレンダーターゲットのフォーマットのみ.
+    for (auto i = 0u; i < desc.NumRenderTargets && i < D3D12_SIMULTANEOUS_RENDER_TARGET_COUNT; ++i)
+    { hasher.Add(desc.RTVFormats[i]); }
+
+    hasher.Add(desc.DSVFormat)
+          .Add(desc.SampleDesc.Count)
+          .Add(desc.SampleDesc.Quality)
+          .Add(desc.NodeMask)
+          .Add(desc.Flags);
+
+    return hasher.GetValue();
+}
+
+//-----------------------------------------------------------------------------
+//      コンピュートパイプラインステート設定のハッシュ値を計算します.
+//-----------------------------------------------------------------------------
+uint64_t HashComputePipelineStateDesc(const D3D12_COMPUTE_PIPELINE_STATE_DESC& desc, uint64_t rootSigHash)
+{
+    Hasher hasher;
+    hasher.Add(HashVersion)
+          .Add(TagCompute)
+          .Add(rootSigHash);
+
+    AddShader(hasher, desc.CS);
+
+    hasher.Add(desc.NodeMask)
+          .Add(desc.Flags);
+
+    return hasher.GetValue();
+}
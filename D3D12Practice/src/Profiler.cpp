@@ -0,0 +1,342 @@
+﻿//-----------------------------------------------------------------------------
+// File : Profiler.cpp
+// Desc : CPU Scope Profiler And Chrome Trace Exporter.
+// Copyright(c) Pocol. All right reserved.
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------
+#include "Profiler.h"
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+
+
+namespace {
+
+///////////////////////////////////////////////////////////////////////////////
+// OpenScope structure
+///////////////////////////////////////////////////////////////////////////////
+struct OpenScope
+{
+    const char* Name;       // スコープ名.
+    double      BeginUs;    // 開始時刻[us].
+};
+
+// スレッドごとの計測中のスコープ.
+thread_local std::vector<OpenScope> t_OpenScopes;
+
+//-----------------------------------------------------------------------------
+//      JSON の文字列として出力します.
+//-----------------------------------------------------------------------------
+void AppendJsonString(std::string& result, const std::string& value)
+{
+    result += '"';
+    for (auto c : value)
+    {
+        switch (c)
+        {
+        case '"':  result += "\\\""; break;
+        case '\\': result += "\\\\"; break;
+        case '\n': result += "\\n";  break;
+        case '\t': result += "\\t";  break;
+        default:
+            if (uint8_t(c) < 0x20)
+            {
+                char code[8];
+                snprintf(code, sizeof(code), "\\u%04x", uint32_t(uint8_t(c)));
+                result += code;
+            }
+            else
+            { result += c; }
+            break;
+        }
+    }
+    result += '"';
+}
+
+} // namespace
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Profiler class
+///////////////////////////////////////////////////////////////////////////////
+
+//-----------------------------------------------------------------------------
+//      コンストラクタです.
+//-----------------------------------------------------------------------------
+Profiler::Profiler()
+: m_Frame           (0)
+, m_CaptureEnd      (0)
+, m_Capturing       (false)
+, m_CaptureFinished (false)
+{ /* DO_NOTHING */ }
+
+//-----------------------------------------------------------------------------
+//      デストラクタです.
+//-----------------------------------------------------------------------------
+Profiler::~Profiler()
+{ /* DO_NOTHING */ }
+
+//-----------------------------------------------------------------------------
+//      フレームを開始します.
+//-----------------------------------------------------------------------------
+void Profiler::BeginFrame()
+{
+    std::lock_guard<std::mutex> locker(m_Mutex);
+
+    m_Frame++;
+    if (m_Capturing && m_Frame >= m_CaptureEnd)
+    {
+        m_Capturing       = false;
+        m_CaptureFinished = true;
+    }
+}
+
+//-----------------------------------------------------------------------------
+//      呼び出したスレッドでスコープの計測を開始します.
+//-----------------------------------------------------------------------------
+uint32_t Profiler::BeginScope(const char* name)
+{
+    auto scope = uint32_t(t_OpenScopes.size());
+    t_OpenScopes.push_back({ name, GetTimeUs() });
+    return scope;
+}
+
+//-----------------------------------------------------------------------------
+//      呼び出したスレッドでスコープの計測を終了します.
+//-----------------------------------------------------------------------------
+void Profiler::EndScope(uint32_t scope)
+{
+    auto endUs = GetTimeUs();
+
+    if (scope == InvalidScope || scope >= t_OpenScopes.size())
+    { return; }
+
+    // 終了し忘れた内側のスコープもここで閉じる.
+    auto open = t_OpenScopes[scope];
+    t_OpenScopes.resize(scope);
+
+    auto ms = (endUs - open.BeginUs) * 1e-3;
+
+    std::lock_guard<std::mutex> locker(m_Mutex);
+
+    Stats* pStats = nullptr;
+    for (auto& stats : m_Stats)
+    {
+        if (stats.Name == open.Name)
+        {
+            pStats = &stats;
+            break;
+        }
+    }
+
+    if (pStats == nullptr)
+    {
+        m_Stats.push_back({ open.Name, 0.0, 0.0, 0 });
+        pStats = &m_Stats.back();
+    }
+
+    pStats->TotalMs += ms;
+    pStats->MaxMs    = (ms > pStats->MaxMs) ? ms : pStats->MaxMs;
+    pStats->Count++;
+
+    if (m_Capturing && m_Events.size() < MaxCaptureEvents)
+    { m_Events.push_back({ open.Name, open.BeginUs, endUs, GetTrackLocked(), scope, m_Frame }); }
+}
+
+//-----------------------------------------------------------------------------
+//      GPUのイベントを追加します.
+//-----------------------------------------------------------------------------
+void Profiler::AddGpuEvent(const char* name, double beginUs, double endUs)
+{
+    std::lock_guard<std::mutex> locker(m_Mutex);
+
+    if (m_Capturing && m_Events.size() < MaxCaptureEvents && endUs >= beginUs)
+    { m_Events.push_back({ name, beginUs, endUs, GpuTrack, 0, m_Frame }); }
+}
+
+//-----------------------------------------------------------------------------
+//      キャプチャを開始します.
+//-----------------------------------------------------------------------------
+void Profiler::StartCapture(uint32_t frameCount)
+{
+    std::lock_guard<std::mutex> locker(m_Mutex);
+
+    m_Events.clear();
+    m_Capturing       = (frameCount > 0);
+    m_CaptureFinished = false;
+    m_CaptureEnd      = m_Frame + frameCount + 1;
+}
+
+//-----------------------------------------------------------------------------
+//      キャプチャ中かどうかチェックします.
+//-----------------------------------------------------------------------------
+bool Profiler::IsCapturing() const
+{
+    std::lock_guard<std::mutex> locker(m_Mutex);
+    return m_Capturing;
+}
+
+//-----------------------------------------------------------------------------
+//      キャプチャが完了して出力待ちかどうかチェックします.
+//-----------------------------------------------------------------------------
+bool Profiler::HasFinishedCapture() const
+{
+    std::lock_guard<std::mutex> locker(m_Mutex);
+    return m_CaptureFinished;
+}
+
+//-----------------------------------------------------------------------------
+//      キャプチャしたイベントを破棄します.
+//-----------------------------------------------------------------------------
+void Profiler::ClearCapture()
+{
+    std::lock_guard<std::mutex> locker(m_Mutex);
+
+    m_Events.clear();
+    m_Events.shrink_to_fit();
+    m_CaptureFinished = false;
+}
+
+//-----------------------------------------------------------------------------
+//      キャプチャしたイベントを取得します.
+//-----------------------------------------------------------------------------
+std::vector<ProfileEvent> Profiler::GetEvents() const
+{
+    std::lock_guard<std::mutex> locker(m_Mutex);
+    return m_Events;
+}
+
+//-----------------------------------------------------------------------------
+//      集計をリセットします.
+//-----------------------------------------------------------------------------
+void Profiler::ResetStats()
+{
+    std::lock_guard<std::mutex> locker(m_Mutex);
+    m_Stats.clear();
+}
+
+//-----------------------------------------------------------------------------
+//      スコープごとの平均時間を文字列にします.
+//-----------------------------------------------------------------------------
+std::string Profiler::FormatReport() const
+{
+    std::lock_guard<std::mutex> locker(m_Mutex);
+
+    std::string result = "CPU Timing (average / max)\n";
+
+    char line[256];
+    for (auto& stats : m_Stats)
+    {
+        auto average = (stats.Count > 0) ? stats.TotalMs / double(stats.Count) : 0.0;
+        snprintf(line, sizeof(line), "    %-24s %8.3f ms  %8.3f ms  (%u calls)\n",
+            stats.Name.c_str(),
+            average,
+            stats.MaxMs,
+            stats.Count);
+        result += line;
+    }
+
+    return result;
+}
+
+//-----------------------------------------------------------------------------
+//      キャプチャしたイベントを Chrome Trace 形式の JSON にします.
+//-----------------------------------------------------------------------------
+std::string Profiler::ExportChromeTrace() const
+{
+    std::lock_guard<std::mutex> locker(m_Mutex);
+
+    // 最初のイベントを時刻0にする.
+    auto originUs = 0.0;
+    if (!m_Events.empty())
+    {
+        originUs = m_Events.front().BeginUs;
+        for (auto& e : m_Events)
+        { originUs = (e.BeginUs < originUs) ? e.BeginUs : originUs; }
+    }
+
+    std::string result;
+    result.reserve(128 + m_Events.size() * 128);
+    result += "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+
+    char buffer[256];
+
+    // トラック名. GPU は CPU スレッドの下に並べる.
+    snprintf(buffer, sizeof(buffer),
+        "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"GPU\"}},\n"
+        "{\"name\":\"thread_sort_index\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"sort_index\":%u}}",
+        GpuTrack, GpuTrack, GpuTrack);
+    result += buffer;
+
+    for (size_t i = 0; i < m_Threads.size(); ++i)
+    {
+        snprintf(buffer, sizeof(buffer),
+            ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"CPU Thread %u\"}}",
+            uint32_t(i), uint32_t(i));
+        result += buffer;
+    }
+
+    for (auto& e : m_Events)
+    {
+        result += ",\n{\"name\":";
+        AppendJsonString(result, e.Name);
+        snprintf(buffer, sizeof(buffer),
+            ",\"cat\":\"%s\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":%u,\"args\":{\"frame\":%u,\"depth\":%u}}",
+            (e.Track == GpuTrack) ? "gpu" : "cpu",
+            e.BeginUs - originUs,
+            e.EndUs - e.BeginUs,
+            e.Track,
+            e.Frame,
+            e.Depth);
+        result += buffer;
+    }
+
+    result += "\n]}\n";
+    return result;
+}
+
+//-----------------------------------------------------------------------------
+//      キャプチャしたイベントを Chrome Trace 形式でファイルに書き出します.
+//-----------------------------------------------------------------------------
+bool Profiler::WriteChromeTrace(const char* path) const
+{
+    if (path == nullptr)
+    { return false; }
+
+    auto json = ExportChromeTrace();
+
+    std::ofstream stream(path, std::ios::binary | std::ios::trunc);
+    if (!stream.is_open())
+    { return false; }
+
+    stream.write(json.data(), std::streamsize(json.size()));
+    return stream.good();
+}
+
+//-----------------------------------------------------------------------------
+//      現在時刻[us]を取得します.
+//-----------------------------------------------------------------------------
+double Profiler::GetTimeUs()
+{
+    auto now = std::chrono::steady_clock::now().time_since_epoch();
+    return std::chrono::duration<double, std::micro>(now).count();
+}
+
+//-----------------------------------------------------------------------------
+//      呼び出したスレッドのトラック番号を取得します.
+//-----------------------------------------------------------------------------
+uint32_t Profiler::GetTrackLocked()
+{
+    auto id = std::this_thread::get_id();
+    for (size_t i = 0; i < m_Threads.size(); ++i)
+    {
+        if (m_Threads[i] == id)
+        { return uint32_t(i); }
+    }
+
+    m_Threads.push_back(id);
+    return uint32_t(m_Threads.size() - 1);
+}
@@ -0,0 +1,617 @@
+﻿//-----------------------------------------------------------------------------
+// File : ProgressiveIBLBaker.cpp
+// Desc : Time Sliced IBL Baker.
+// Copyright(c) Pocol. All right reserved.
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------
+#include "ProgressiveIBLBaker.h"
+#include "PipelineStateHash.h"
+#include "GpuHeapAllocator.h"
+#include "Logger.h"
+
+
+namespace {
+
+//-----------------------------------------------------------------------------
+// Constant Values.
+//-----------------------------------------------------------------------------
+constexpr double        DefaultBudget           = 2.0;                              // 既定の予算[ms].
+constexpr double        CostDFG                 = 0.5;                              // DFG項の初期見積もり[ms].
+constexpr double        CostFace                = 0.3;                              // LD項のミップ0の1面の初期見積もり[ms].
+constexpr DXGI_FORMAT   LDFormat                = DXGI_FORMAT_R16G16B16A16_FLOAT;   // LD項のフォーマット.
+constexpr uint32_t      GroupSize               = 8;                                // スレッドグループのサイズ.
+constexpr uint32_t      DiffuseSampleCount      = 256;                              // 拡散反射の1テクセルあたりのサンプル数.
+constexpr uint32_t      SpecularSampleCount     = 256;                              // 鏡面反射の1テクセルあたりのサンプル数.
+
+// 読み込み時の状態(シーンのピクセルシェーダから読む).
+constexpr D3D12_RESOURCE_STATES ReadState = D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE;
+
+///////////////////////////////////////////////////////////////////////////////
+// BakeConstants structure
+///////////////////////////////////////////////////////////////////////////////
+struct BakeConstants
+{
+    uint32_t    Face;           // 書き込む面の番号.
+    uint32_t    DstSize;        // 書き込むミップの大きさ.
+    float       Roughness;      // ラフネス(鏡面反射のみ).
+    uint32_t    SampleCount;    // 1テクセルあたりのサンプル数.
+};
+
+//-----------------------------------------------------------------------------
+//      ミップの大きさを求めます.
+//-----------------------------------------------------------------------------
+inline uint32_t MipSize(uint32_t size, uint32_t mip)
+{
+    size >>= mip;
+    return (size > 0) ? size : 1;
+}
+
+//-----------------------------------------------------------------------------
+//      LD項のミップ0の大きさを取得します.
+//-----------------------------------------------------------------------------
+inline uint32_t GetLDSize()
+{ return uint32_t(IBLBaker::LDTextureSize); }
+
+//-----------------------------------------------------------------------------
+//      鏡面反射のLD項のミップ数を取得します.
+//-----------------------------------------------------------------------------
+inline uint32_t GetLDMipCount()
+{ return uint32_t(IBLBaker::MipCount); }
+
+//-----------------------------------------------------------------------------
+//      全体の状態を切り替える遷移バリアを設定します.
+//-----------------------------------------------------------------------------
+D3D12_RESOURCE_BARRIER Transition
+(
+    ID3D12Resource*         pResource,
+    D3D12_RESOURCE_STATES   before,
+    D3D12_RESOURCE_STATES   after
+)
+{
+    D3D12_RESOURCE_BARRIER barrier = {};
+    barrier.Type                    = D3D12_RESOURCE_BARRIER_TYPE_TRANSITION;
+    barrier.Transition.pResource    = pResource;
+    barrier.Transition.Subresource  = D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES;
+    barrier.Transition.StateBefore  = before;
+    barrier.Transition.StateAfter   = after;
+    return barrier;
+}
+
+} // namespace
+
+
+///////////////////////////////////////////////////////////////////////////////
+// ProgressiveIBLBaker class
+///////////////////////////////////////////////////////////////////////////////
+
+//-----------------------------------------------------------------------------
+//      コンストラクタです.
+//-----------------------------------------------------------------------------
+ProgressiveIBLBaker::ProgressiveIBLBaker()
+: m_DFGReady    (false)
+, m_Front       (0)
+, m_HandleCube  ()
+, m_Baking      (false)
+, m_pPool       (nullptr)
+, m_MemoryId    (MemoryTracker::InvalidId)
+{
+    static_assert(IBLBaker::MipCount <= MaxMipCount, "IBLBaker::MipCount exceeds ProgressiveIBLBaker::MaxMipCount.");
+
+    for (auto& set : m_Set)
+    {
+        set.pHandleDiffuseSRV   = nullptr;
+        set.pHandleSpecularSRV  = nullptr;
+        set.pHandleDiffuseUAV   = nullptr;
+        set.Writable            = false;
+
+        for (auto i = 0u; i < MaxMipCount; ++i)
+        { set.pHandleSpecularUAV[i] = nullptr; }
+    }
+
+    m_Scheduler.SetBudget(DefaultBudget);
+    m_Scheduler.SetCostEstimate(WORK_DFG,         CostDFG);
+    m_Scheduler.SetCostEstimate(WORK_DIFFUSE_LD,  CostFace);
+    m_Scheduler.SetCostEstimate(WORK_SPECULAR_LD, CostFace);
+}
+
+//-----------------------------------------------------------------------------
+//      デストラクタです.
+//-----------------------------------------------------------------------------
+ProgressiveIBLBaker::~ProgressiveIBLBaker()
+{ Term(); }
+
+//-----------------------------------------------------------------------------
+//      初期化処理を行います.
+//-----------------------------------------------------------------------------
+bool ProgressiveIBLBaker::Init
+(
+    ID3D12Device*                   pDevice,
+    DescriptorPool*                 pPoolRes,
+    DescriptorPool*                 pPoolRTV,
+    PipelineCache*                  pCache,
+    const D3D12_SHADER_BYTECODE&    diffuseCS,
+    const D3D12_SHADER_BYTECODE&    specularCS
+)
+{
+    if (pDevice == nullptr || pPoolRes == nullptr || pPoolRTV == nullptr || pCache == nullptr)
+    {
+        ELOG("Error : Invalid Argument.");
+        return false;
+    }
+
+    // DFG項は IBLBaker で積分する.
+    if (!m_Baker.Init(pDevice, pPoolRes, pPoolRTV))
+    {
+        ELOG("Error : IBLBaker::Init() Failed.");
+        return false;
+    }
+
+    m_pPool    = pPoolRes;
+    m_DFGReady = false;
+    m_Front    = 0;
+    m_Baking   = false;
+    m_Scheduler.Reset();
+
+    // LD項を表と裏の2組生成.
+    uint64_t totalBytes = 0;
+    for (auto& set : m_Set)
+    {
+        if (!CreateSet(pDevice, set))
+        {
+            ELOG("Error : LD Texture Create Failed.");
+            return false;
+        }
+
+        totalBytes += GetResourceSize(set.pDiffuse.Get()) + GetResourceSize(set.pSpecular.Get());
+    }
+
+    m_MemoryId = GetMemoryTracker().Add(MEMORY_CATEGORY_IBL, MEMORY_DOMAIN_GPU, totalBytes, "ProgressiveIBLBaker");
+
+    // ルートシグニチャを生成.
+    uint64_t rootSigHash = 0;
+    {
+        D3D12_DESCRIPTOR_RANGE ranges[2] = {};
+        ranges[0].RangeType                         = D3D12_DESCRIPTOR_RANGE_TYPE_SRV;
+        ranges[0].NumDescriptors                    = 1;
+        ranges[0].BaseShaderRegister                = 0;
+        ranges[0].OffsetInDescriptorsFromTableStart = D3D12_DESCRIPTOR_RANGE_OFFSET_APPEND;
+        ranges[1].RangeType                         = D3D12_DESCRIPTOR_RANGE_TYPE_UAV;
+        ranges[1].NumDescriptors                    = 1;
+        ranges[1].BaseShaderRegister                = 0;
+        ranges[1].OffsetInDescriptorsFromTableStart = D3D12_DESCRIPTOR_RANGE_OFFSET_APPEND;
+
+        D3D12_ROOT_PARAMETER params[3] = {};
+        params[0].ParameterType                         = D3D12_ROOT_PARAMETER_TYPE_32BIT_CONSTANTS;
+        params[0].Constants.ShaderRegister              = 0;
+        params[0].Constants.Num32BitValues              = sizeof(BakeConstants) / 4;
+        params[0].ShaderVisibility                      = D3D12_SHADER_VISIBILITY_ALL;
+        params[1].ParameterType                         = D3D12_ROOT_PARAMETER_TYPE_DESCRIPTOR_TABLE;
+        params[1].DescriptorTable.NumDescriptorRanges   = 1;
+        params[1].DescriptorTable.pDescriptorRanges     = &ranges[0];
+        params[1].ShaderVisibility                      = D3D12_SHADER_VISIBILITY_ALL;
+        params[2].ParameterType                         = D3D12_ROOT_PARAMETER_TYPE_DESCRIPTOR_TABLE;
+        params[2].DescriptorTable.NumDescriptorRanges   = 1;
+        params[2].DescriptorTable.pDescriptorRanges     = &ranges[1];
+        params[2].ShaderVisibility                      = D3D12_SHADER_VISIBILITY_ALL;
+
+        D3D12_STATIC_SAMPLER_DESC sampler = {};
+        sampler.Filter              = D3D12_FILTER_MIN_MAG_MIP_LINEAR;
+        sampler.AddressU            = D3D12_TEXTURE_ADDRESS_MODE_CLAMP;
+        sampler.AddressV            = D3D12_TEXTURE_ADDRESS_MODE_CLAMP;
+        sampler.AddressW            = D3D12_TEXTURE_ADDRESS_MODE_CLAMP;
+        sampler.MaxLOD              = D3D12_FLOAT32_MAX;
+        sampler.ComparisonFunc      = D3D12_COMPARISON_FUNC_NEVER;
+        sampler.ShaderRegister      = 0;
+        sampler.ShaderVisibility    = D3D12_SHADER_VISIBILITY_ALL;
+
+        D3D12_ROOT_SIGNATURE_DESC desc = {};
+        desc.NumParameters      = _countof(params);
+        desc.pParameters        = params;
+        desc.NumStaticSamplers  = 1;
+        desc.pStaticSamplers    = &sampler;
+
+        Microsoft::WRL::ComPtr<ID3DBlob> pBlob;
+        Microsoft::WRL::ComPtr<ID3DBlob> pErrorBlob;
+        auto hr = D3D12SerializeRootSignature(
+            &desc,
+            D3D_ROOT_SIGNATURE_VERSION_1_0,
+            pBlob.GetAddressOf(),
+            pErrorBlob.GetAddressOf());
+        if (FAILED(hr))
+        {
+            ELOG("Error : D3D12SerializeRootSignature() Failed. retcode = 0x%x", hr);
+            return false;
+        }
+
+        hr = pDevice->CreateRootSignature(
+            0,
+            pBlob->GetBufferPointer(),
+            pBlob->GetBufferSize(),
+            IID_PPV_ARGS(m_pRootSig.GetAddressOf()));
+        if (FAILED(hr))
+        {
+            ELOG("Error : ID3D12Device::CreateRootSignature() Failed. retcode = 0x%x", hr);
+            return false;
+        }
+
+        rootSigHash = HashRootSignatureDesc(desc);
+    }
+
+    // パイプラインステートを生成.
+    {
+        D3D12_COMPUTE_PIPELINE_STATE_DESC desc = {};
+        desc.pRootSignature = m_pRootSig.Get();
+        desc.CS             = diffuseCS;
+
+        auto hr = pCache->CreateComputePipelineState(desc, rootSigHash, m_pDiffusePSO.GetAddressOf());
+        if (FAILED(hr))
+        {
+            ELOG("Error : CreateComputePipelineState() Failed. retcode = 0x%x", hr);
+            return false;
+        }
+
+        desc.CS = specularCS;
+        hr = pCache->CreateComputePipelineState(desc, rootSigHash, m_pSpecularPSO.GetAddressOf());
+        if (FAILED(hr))
+        {
+            ELOG("Error : CreateComputePipelineState() Failed. retcode = 0x%x", hr);
+            return false;
+        }
+    }
+
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+//      終了処理を行います.
+//-----------------------------------------------------------------------------
+void ProgressiveIBLBaker::Term()
+{
+    m_Scheduler.Reset();
+    m_Baking   = false;
+    m_DFGReady = false;
+
+    for (auto& set : m_Set)
+    {
+        DescriptorHandle** ppHandles[3 + MaxMipCount] = {
+            &set.pHandleDiffuseSRV,
+            &set.pHandleSpecularSRV,
+            &set.pHandleDiffuseUAV,
+        };
+        for (auto i = 0u; i < MaxMipCount; ++i)
+        { ppHandles[3 + i] = &set.pHandleSpecularUAV[i]; }
+
+        for (auto ppHandle : ppHandles)
+        {
+            if (m_pPool != nullptr && *ppHandle != nullptr)
+            { m_pPool->FreeHandle(*ppHandle); }
+
+            *ppHandle = nullptr;
+        }
+
+        set.pDiffuse.Reset();
+        set.pSpecular.Reset();
+        set.Writable = false;
+    }
+
+    m_pPool = nullptr;
+
+    m_pDiffusePSO.Reset();
+    m_pSpecularPSO.Reset();
+    m_pRootSig.Reset();
+    m_Baker.Term();
+
+    GetMemoryTracker().Remove(m_MemoryId);
+    m_MemoryId = MemoryTracker::InvalidId;
+}
+
+//-----------------------------------------------------------------------------
+//      全ての積分を一括で記録します.
+//-----------------------------------------------------------------------------
+void ProgressiveIBLBaker::Bake(ID3D12GraphicsCommandList* pCmd, D3D12_GPU_DESCRIPTOR_HANDLE handleCube)
+{
+    // 進行中のベイクは破棄.
+    m_Scheduler.Reset();
+    m_Baking     = false;
+    m_HandleCube = handleCube;
+
+    // 予算を無視して表の組に全て記録する.
+    auto& set = m_Set[m_Front];
+    if (!m_DFGReady)
+    { Record(pCmd, set, { WORK_DFG, 0, 1.0 }); }
+
+    for (auto face = 0u; face < FaceCount; ++face)
+    { Record(pCmd, set, { WORK_DIFFUSE_LD, face, 1.0 }); }
+
+    for (auto mip = 0u; mip < GetLDMipCount(); ++mip)
+    {
+        for (auto face = 0u; face < FaceCount; ++face)
+        { Record(pCmd, set, { WORK_SPECULAR_LD, mip * FaceCount + face, 1.0 }); }
+    }
+
+    SetWritable(pCmd, set, false);
+}
+
+//-----------------------------------------------------------------------------
+//      環境マップの変更を要求します.
+//-----------------------------------------------------------------------------
+void ProgressiveIBLBaker::Request(D3D12_GPU_DESCRIPTOR_HANDLE handleCube)
+{
+    m_HandleCube = handleCube;
+
+    // 裏側に対する作業を積み直す.
+    m_Scheduler.Reset();
+    PushAll(!m_DFGReady);
+    m_Baking = true;
+}
+
+//-----------------------------------------------------------------------------
+//      このフレームの作業を記録します.
+//-----------------------------------------------------------------------------
+void ProgressiveIBLBaker::Update(ID3D12GraphicsCommandList* pCmd, uint32_t frameIndex)
+{
+    if (!m_Baking)
+    { return; }
+
+    auto  back = 1 - m_Front;
+    auto& set  = m_Set[back];
+
+    m_Scheduler.BeginFrame(frameIndex);
+
+    IBLBakeScheduler::WorkUnit unit;
+    while (m_Scheduler.Next(unit))
+    { Record(pCmd, set, unit); }
+
+    // 全て記録し終えたら表と裏を入れ替える.
+    // 同一キューで実行されるため, 以降に記録される描画からは積分結果が見える.
+    if (m_Scheduler.IsEmpty())
+    {
+        SetWritable(pCmd, set, false);
+        m_Front  = back;
+        m_Baking = false;
+    }
+}
+
+//-----------------------------------------------------------------------------
+//      記録した作業の計測時間を報告し, コストの見積もりを更新します.
+//-----------------------------------------------------------------------------
+void ProgressiveIBLBaker::ReportGpuTime(uint32_t frameIndex, double gpuMs)
+{ m_Scheduler.ReportFrame(frameIndex, gpuMs); }
+
+//-----------------------------------------------------------------------------
+//      1フレームあたりのGPU時間予算を設定します.
+//-----------------------------------------------------------------------------
+void ProgressiveIBLBaker::SetBudget(double budgetMs)
+{ m_Scheduler.SetBudget(budgetMs); }
+
+//-----------------------------------------------------------------------------
+//      ベイク中かどうかチェックします.
+//-----------------------------------------------------------------------------
+bool ProgressiveIBLBaker::IsBaking() const
+{ return m_Baking; }
+
+//-----------------------------------------------------------------------------
+//      スケジューラを取得します.
+//-----------------------------------------------------------------------------
+IBLBakeScheduler& ProgressiveIBLBaker::GetScheduler()
+{ return m_Scheduler; }
+
+//-----------------------------------------------------------------------------
+//      DFG項のGPUディスクリプタハンドルを取得します.
+//-----------------------------------------------------------------------------
+D3D12_GPU_DESCRIPTOR_HANDLE ProgressiveIBLBaker::GetHandleGPU_DFG() const
+{ return m_Baker.GetHandleGPU_DFG(); }
+
+//-----------------------------------------------------------------------------
+//      描画に使用する拡散反射のLD項のGPUディスクリプタハンドルを取得します.
+//-----------------------------------------------------------------------------
+D3D12_GPU_DESCRIPTOR_HANDLE ProgressiveIBLBaker::GetHandleGPU_DiffuseLD() const
+{ return m_Set[m_Front].pHandleDiffuseSRV->HandleGPU; }
+
+//-----------------------------------------------------------------------------
+//      描画に使用する鏡面反射のLD項のGPUディスクリプタハンドルを取得します.
+//-----------------------------------------------------------------------------
+D3D12_GPU_DESCRIPTOR_HANDLE ProgressiveIBLBaker::GetHandleGPU_SpecularLD() const
+{ return m_Set[m_Front].pHandleSpecularSRV->HandleGPU; }
+
+//-----------------------------------------------------------------------------
+//      LD項のテクスチャとビューを生成します.
+//-----------------------------------------------------------------------------
+bool ProgressiveIBLBaker::CreateSet(ID3D12Device* pDevice, LDSet& set)
+{
+    D3D12_HEAP_PROPERTIES prop = {};
+    prop.Type                 = D3D12_HEAP_TYPE_DEFAULT;
+    prop.CPUPageProperty      = D3D12_CPU_PAGE_PROPERTY_UNKNOWN;
+    prop.MemoryPoolPreference = D3D12_MEMORY_POOL_UNKNOWN;
+    prop.CreationNodeMask     = 1;
+    prop.VisibleNodeMask      = 1;
+
+    D3D12_RESOURCE_DESC desc = {};
+    desc.Dimension          = D3D12_RESOURCE_DIMENSION_TEXTURE2D;
+    desc.Width              = GetLDSize();
+    desc.Height             = GetLDSize();
+    desc.DepthOrArraySize   = FaceCount;
+    desc.MipLevels          = 1;
+    desc.Format             = LDFormat;
+    desc.SampleDesc.Count   = 1;
+    desc.Layout             = D3D12_TEXTURE_LAYOUT_UNKNOWN;
+    desc.Flags              = D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS;
+
+    auto hr = pDevice->CreateCommittedResource(
+        &prop,
+        D3D12_HEAP_FLAG_NONE,
+        &desc,
+        ReadState,
+        nullptr,
+        IID_PPV_ARGS(set.pDiffuse.GetAddressOf()));
+    if (FAILED(hr))
+    {
+        ELOG("Error : ID3D12Device::CreateCommittedResource() Failed. retcode = 0x%x", hr);
+        return false;
+    }
+
+    desc.MipLevels = UINT16(GetLDMipCount());
+    hr = pDevice->CreateCommittedResource(
+        &prop,
+        D3D12_HEAP_FLAG_NONE,
+        &desc,
+        ReadState,
+        nullptr,
+        IID_PPV_ARGS(set.pSpecular.GetAddressOf()));
+    if (FAILED(hr))
+    {
+        ELOG("Error : ID3D12Device::CreateCommittedResource() Failed. retcode = 0x%x", hr);
+        return false;
+    }
+
+    set.Writable = false;
+
+    set.pHandleDiffuseSRV  = m_pPool->AllocHandle();
+    set.pHandleSpecularSRV = m_pPool->AllocHandle();
+    set.pHandleDiffuseUAV  = m_pPool->AllocHandle();
+    if (set.pHandleDiffuseSRV == nullptr || set.pHandleSpecularSRV == nullptr || set.pHandleDiffuseUAV == nullptr)
+    {
+        ELOG("Error : DescriptorPool::AllocHandle() Failed.");
+        return false;
+    }
+
+    // 描画からはキューブマップとして読む.
+    D3D12_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
+    srvDesc.Format                          = LDFormat;
+    srvDesc.ViewDimension                   = D3D12_SRV_DIMENSION_TEXTURECUBE;
+    srvDesc.Shader4ComponentMapping         = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
+    srvDesc.TextureCube.MostDetailedMip     = 0;
+    srvDesc.TextureCube.MipLevels           = 1;
+    pDevice->CreateShaderResourceView(set.pDiffuse.Get(), &srvDesc, set.pHandleDiffuseSRV->HandleCPU);
+
+    srvDesc.TextureCube.MipLevels = GetLDMipCount();
+    pDevice->CreateShaderResourceView(set.pSpecular.Get(), &srvDesc, set.pHandleSpecularSRV->HandleCPU);
+
+    // 積分では6面の配列として書き込む.
+    D3D12_UNORDERED_ACCESS_VIEW_DESC uavDesc = {};
+    uavDesc.Format                          = LDFormat;
+    uavDesc.ViewDimension                   = D3D12_UAV_DIMENSION_TEXTURE2DARRAY;
+    uavDesc.Texture2DArray.MipSlice         = 0;
+    uavDesc.Texture2DArray.FirstArraySlice  = 0;
+    uavDesc.Texture2DArray.ArraySize        = FaceCount;
+    pDevice->CreateUnorderedAccessView(set.pDiffuse.Get(), nullptr, &uavDesc, set.pHandleDiffuseUAV->HandleCPU);
+
+    for (auto i = 0u; i < GetLDMipCount(); ++i)
+    {
+        set.pHandleSpecularUAV[i] = m_pPool->AllocHandle();
+        if (set.pHandleSpecularUAV[i] == nullptr)
+        {
+            ELOG("Error : DescriptorPool::AllocHandle() Failed.");
+            return false;
+        }
+
+        uavDesc.Texture2DArray.MipSlice = i;
+        pDevice->CreateUnorderedAccessView(set.pSpecular.Get(), nullptr, &uavDesc, set.pHandleSpecularUAV[i]->HandleCPU);
+    }
+
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+//      全ての作業を積みます.
+//-----------------------------------------------------------------------------
+void ProgressiveIBLBaker::PushAll(bool dfg)
+{
+    if (dfg)
+    { m_Scheduler.Push(WORK_DFG); }
+
+    // 重みはミップ0の1面に対するテクセル数の比(1テクセルあたりのサンプル数は一定).
+    for (auto face = 0u; face < FaceCount; ++face)
+    { m_Scheduler.Push(WORK_DIFFUSE_LD, face); }
+
+    auto size = GetLDSize();
+    for (auto mip = 0u; mip < GetLDMipCount(); ++mip)
+    {
+        auto mipSize = MipSize(size, mip);
+        auto weight  = (double(mipSize) * double(mipSize)) / (double(size) * double(size));
+
+        for (auto face = 0u; face < FaceCount; ++face)
+        { m_Scheduler.Push(WORK_SPECULAR_LD, mip * FaceCount + face, weight); }
+    }
+}
+
+//-----------------------------------------------------------------------------
+//      作業を1つ記録します.
+//-----------------------------------------------------------------------------
+void ProgressiveIBLBaker::Record
+(
+    ID3D12GraphicsCommandList*          pCmd,
+    LDSet&                              set,
+    const IBLBakeScheduler::WorkUnit&   unit
+)
+{
+    if (unit.Kind == WORK_DFG)
+    {
+        m_Baker.IntegrateDFG(pCmd);
+        m_DFGReady = true;
+        return;
+    }
+
+    SetWritable(pCmd, set, true);
+
+    BakeConstants constants = {};
+    D3D12_GPU_DESCRIPTOR_HANDLE handleUAV = {};
+
+    if (unit.Kind == WORK_DIFFUSE_LD)
+    {
+        constants.Face          = unit.Index;
+        constants.DstSize       = GetLDSize();
+        constants.Roughness     = 0.0f;
+        constants.SampleCount   = DiffuseSampleCount;
+
+        pCmd->SetPipelineState(m_pDiffusePSO.Get());
+        handleUAV = set.pHandleDiffuseUAV->HandleGPU;
+    }
+    else
+    {
+        auto mip      = unit.Index / FaceCount;
+        auto mipCount = GetLDMipCount();
+
+        // ミップごとにラフネスを等間隔に割り当てる(最後のミップが1).
+        constants.Face          = unit.Index % FaceCount;
+        constants.DstSize       = MipSize(GetLDSize(), mip);
+        constants.Roughness     = (mipCount > 1) ? float(mip) / float(mipCount - 1) : 0.0f;
+        constants.SampleCount   = SpecularSampleCount;
+
+        pCmd->SetPipelineState(m_pSpecularPSO.Get());
+        handleUAV = set.pHandleSpecularUAV[mip]->HandleGPU;
+    }
+
+    // 書き込む面とミップは作業ごとに異なるので, 続けて記録してもUAVバリアは要らない.
+    pCmd->SetComputeRootSignature(m_pRootSig.Get());
+    pCmd->SetComputeRoot32BitConstants(0, sizeof(constants) / 4, &constants, 0);
+    pCmd->SetComputeRootDescriptorTable(1, m_HandleCube);
+    pCmd->SetComputeRootDescriptorTable(2, handleUAV);
+
+    auto groups = (constants.DstSize + GroupSize - 1) / GroupSize;
+    pCmd->Dispatch(groups, groups, 1);
+}
+
+//-----------------------------------------------------------------------------
+//      LD項の状態を書き込み用と読み込み用の間で切り替えます.
+//-----------------------------------------------------------------------------
+void ProgressiveIBLBaker::SetWritable(ID3D12GraphicsCommandList* pCmd, LDSet& set, bool writable)
+{
+    if (set.Writable == writable)
+    { return; }
+
+    // 裏の組は描画から参照されないので, 書き込み中は全体を UNORDERED_ACCESS にしておく.
+    auto before = (writable) ? ReadState : D3D12_RESOURCE_STATE_UNORDERED_ACCESS;
+    auto after  = (writable) ? D3D12_RESOURCE_STATE_UNORDERED_ACCESS : ReadState;
+
+    D3D12_RESOURCE_BARRIER barriers[] = {
+        Transition(set.pDiffuse .Get(), before, after),
+        Transition(set.pSpecular.Get(), before, after),
+    };
+    pCmd->ResourceBarrier(_countof(barriers), barriers);
+
+    set.Writable = writable;
+}
@@ -9,10 +9,18 @@
 //-----------------------------------------------------------------------------
 #include "SampleApp.h"
 #include "FileUtil.h"
+#include "GpuHeapAllocator.h"
 #include "Logger.h"
+#include "AsyncLogger.h"
 #include "CommonStates.h"
 #include "DirectXHelpers.h"
 #include "SimpleMath.h"
+#include "TaskGraph.h"
+#include "TonemapCPU.h"
+#include <cassert>
+#include <cstdio>
+#include <cstring>
+#include <random>
 
 
 //-----------------------------------------------------------------------------
@@ -23,25 +31,6 @@ using namespace DirectX::SimpleMath;
 
 namespace {
 
-///////////////////////////////////////////////////////////////////////////////
-// COLOR_SPACE_TYPE enum
-///////////////////////////////////////////////////////////////////////////////
-enum COLOR_SPACE_TYPE
-{
-    COLOR_SPACE_BT709,      // ITU-R BT.709
-    COLOR_SPACE_BT2100_PQ,  // ITU-R BT.2100 PQ System.
-};
-
-///////////////////////////////////////////////////////////////////////////////
-// TONEMAP_TYPE enum
-///////////////////////////////////////////////////////////////////////////////
-enum TONEMAP_TYPE
-{
-    TONEMAP_NONE = 0,   // トーンマップなし.
-    TONEMAP_REINHARD,   // Reinhardトーンマップ.
-    TONEMAP_GT,         // GTトーンマップ.
-};
-
 ///////////////////////////////////////////////////////////////////////////////
 // CbTonemap structure
 ///////////////////////////////////////////////////////////////////////////////
@@ -51,8 +40,33 @@ struct alignas(256) CbTonemap
     int     ColorSpace;         // 出力色空間.
     float   BaseLuminance;      // 基準輝度値[nit].
     float   MaxLuminance;       // 最大輝度値[nit].
+    TonemapLUTShaper LutShaper; // LUTの入力符号化の定数.
+    float   BloomIntensity;     // ブルームの強さ.
+    float   Sharpness;          // 拡大時のシャープ化の強さ.
+    Vector2 UVScale;            // シーンカラーのうち描画済みの領域の割合.
+    Vector2 InvSceneSize;       // シーンカラーの大きさの逆数.
 };
 
+// CPU版トーンマップ(TonemapCPU)とパラメータの並びを一致させる.
+static_assert(offsetof(CbTonemap, Type)          == offsetof(TonemapParam, Type),          "CbTonemap mismatch.");
+static_assert(offsetof(CbTonemap, ColorSpace)    == offsetof(TonemapParam, ColorSpace),    "CbTonemap mismatch.");
+static_assert(offsetof(CbTonemap, BaseLuminance) == offsetof(TonemapParam, BaseLuminance), "CbTonemap mismatch.");
+static_assert(offsetof(CbTonemap, MaxLuminance)  == offsetof(TonemapParam, MaxLuminance),  "CbTonemap mismatch.");
+static_assert(offsetof(CbTonemap, LutShaper) % 16 == 0, "LutShaper must be float4 aligned.");
+static_assert(offsetof(CbTonemap, UVScale) % 16 <= 8 && offsetof(CbTonemap, InvSceneSize) % 16 <= 8, "float2 must not straddle a float4.");
+
+//-----------------------------------------------------------------------------
+// Constant Values.
+//-----------------------------------------------------------------------------
+constexpr uint32_t TonemapLUTSize = 32;     // トーンマップのLUTの1辺のサイズ.
+constexpr uint32_t GpuTimerScopes = 32;     // 1フレームあたりのGPU計測スコープの最大数.
+constexpr uint32_t MaxBatchBarriers = 16;   // 1回にまとめて発行するバリアの最大数.
+constexpr float    BenchmarkDeltaTime = 1.0f / 60.0f;   // ベンチマーク中の1フレームの経過時間[s](固定).
+constexpr uint32_t MaxPointLights = 65536;  // 点光源とスポットライトの最大数.
+constexpr float    ClusterFarZ    = 100.0f; // ライトを割り当てる最も奥の深度.
+constexpr uint32_t ProfileCaptureFrames = 120;  // トレースに記録するフレーム数.
+constexpr char     ProfileTracePath[]   = "profile_trace.json";  // トレースの出力先.
+
 ///////////////////////////////////////////////////////////////////////////////
 // CbMesh structure
 ///////////////////////////////////////////////////////////////////////////////
@@ -129,6 +143,87 @@ void SetTextureSet(
     material.SetTexture(0, TU_NORMAL,     pathN,  batch);
 }
 
+//-----------------------------------------------------------------------------
+//      フレームグラフの状態をリソースステートに変換します.
+//-----------------------------------------------------------------------------
+D3D12_RESOURCE_STATES ToResourceState(uint32_t usage)
+{
+    auto state = D3D12_RESOURCE_STATE_COMMON;
+
+    if (usage & FRAME_USAGE_PIXEL_READ)         { state |= D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE; }
+    if (usage & FRAME_USAGE_NON_PIXEL_READ)     { state |= D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE; }
+    if (usage & FRAME_USAGE_DEPTH_READ)         { state |= D3D12_RESOURCE_STATE_DEPTH_READ; }
+    if (usage & FRAME_USAGE_COPY_SRC)           { state |= D3D12_RESOURCE_STATE_COPY_SOURCE; }
+    if (usage & FRAME_USAGE_RENDER_TARGET)      { state |= D3D12_RESOURCE_STATE_RENDER_TARGET; }
+    if (usage & FRAME_USAGE_DEPTH_WRITE)        { state |= D3D12_RESOURCE_STATE_DEPTH_WRITE; }
+    if (usage & FRAME_USAGE_UNORDERED_ACCESS)   { state |= D3D12_RESOURCE_STATE_UNORDERED_ACCESS; }
+    if (usage & FRAME_USAGE_COPY_DST)           { state |= D3D12_RESOURCE_STATE_COPY_DEST; }
+    if (usage & FRAME_USAGE_PRESENT)            { state |= D3D12_RESOURCE_STATE_PRESENT; }
+
+    return state;
+}
+
+//-----------------------------------------------------------------------------
+//      フレームグラフが導出したバリアをまとめて発行します.
+//-----------------------------------------------------------------------------
+void RecordBarriers
+(
+    ID3D12GraphicsCommandList*  pCmd,
+    const FrameBarrier*         pBarriers,
+    uint32_t                    count,
+    ID3D12Resource* const*      ppResources
+)
+{
+    D3D12_RESOURCE_BARRIER barriers[MaxBatchBarriers];
+    UINT batchCount = 0;
+
+    for (auto i = 0u; i < count; ++i)
+    {
+        auto& src = pBarriers[i];
+
+        // 順序付けのためだけに宣言したリソースは対象外.
+        auto pResource = ppResources[src.Resource];
+        if (pResource == nullptr)
+        { continue; }
+
+        auto& dst = barriers[batchCount];
+        dst = {};
+        dst.Flags = D3D12_RESOURCE_BARRIER_FLAG_NONE;
+
+        switch (src.Type)
+        {
+        case FRAME_BARRIER_TRANSITION:
+            dst.Type                    = D3D12_RESOURCE_BARRIER_TYPE_TRANSITION;
+            dst.Transition.pResource    = pResource;
+            dst.Transition.Subresource  = D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES;
+            dst.Transition.StateBefore  = ToResourceState(src.Before);
+            dst.Transition.StateAfter   = ToResourceState(src.After);
+            break;
+
+        case FRAME_BARRIER_UAV:
+            dst.Type                    = D3D12_RESOURCE_BARRIER_TYPE_UAV;
+            dst.UAV.pResource           = pResource;
+            break;
+
+        case FRAME_BARRIER_ALIASING:
+            dst.Type                    = D3D12_RESOURCE_BARRIER_TYPE_ALIASING;
+            dst.Aliasing.pResourceBefore = (src.Previous != FRAME_GRAPH_INVALID_ID) ? ppResources[src.Previous] : nullptr;
+            dst.Aliasing.pResourceAfter  = pResource;
+            break;
+        }
+
+        batchCount++;
+        if (batchCount == MaxBatchBarriers)
+        {
+            pCmd->ResourceBarrier(batchCount, barriers);
+            batchCount = 0;
+        }
+    }
+
+    if (batchCount > 0)
+    { pCmd->ResourceBarrier(batchCount, barriers); }
+}
+
 } // namespace
 
 
@@ -139,16 +234,41 @@ void SetTextureSet(
 //-----------------------------------------------------------------------------
 //      コンストラクタです.
 //-----------------------------------------------------------------------------
-SampleApp::SampleApp(uint32_t width, uint32_t height)
+SampleApp::SampleApp(uint32_t width, uint32_t height, const BenchmarkSettings& benchmark)
 : App(width, height, DXGI_FORMAT_R10G10B10A2_UNORM)
+, m_ScenePSO         (INVALID_PIPELINE_HANDLE)
+, m_SceneEqualPSO    (INVALID_PIPELINE_HANDLE)
+, m_DepthPrepassPSO  (INVALID_PIPELINE_HANDLE)
+, m_TonemapPSO       (INVALID_PIPELINE_HANDLE)
+, m_TonemapLUTPSO    (INVALID_PIPELINE_HANDLE)
+, m_SceneRootSigHash  (0)
+, m_TonemapRootSigHash(0)
+, m_GridSize        (benchmark.GridSize)
+, m_InstanceCount   (m_GridSize * m_GridSize)
+, m_MeshCB          (FrameCount * m_GridSize * m_GridSize)
+, m_UseDepthPrepass (true)
 , m_TonemapType     (TONEMAP_GT)
 , m_ColorSpace      (COLOR_SPACE_BT709)
 , m_BaseLuminance   (100.0f)
 , m_MaxLuminance    (100.0f)
-, m_Exposure        (1.0f)
+, m_Exposure        (0.0f)
+, m_UseTonemapLUT   (false)
+, m_PointLightCount (1024)
+, m_SceneColorUsage (FRAME_USAGE_PIXEL_READ)
+, m_SceneViewport   ()
+, m_SceneScissor    ()
+, m_UseCookedCubeMap(false)
 , m_PrevCursorX     (0)
 , m_PrevCursorY     (0)
-{ /* DO_NOTHING */ }
+, m_DroppedInputCount(0)
+, m_LaunchTime      (std::chrono::steady_clock::now())
+, m_FirstFrameReported(false)
+, m_LastFrameTime   (m_LaunchTime)
+, m_BenchmarkSettings(benchmark)
+{
+    // 範囲は ParseBenchmarkArgs() で検証済み.
+    assert(1 <= benchmark.GridSize && benchmark.GridSize <= Benchmark::MaxGridSize);
+}
 
 //-----------------------------------------------------------------------------
 //      デストラクタです.
@@ -161,7 +281,19 @@ SampleApp::~SampleApp()
 //-----------------------------------------------------------------------------
 bool SampleApp::OnInit()
 {
+    // 依存関係のある初期化処理をタスクとして登録し, 並列に実行する.
+    // ディスクリプタの確保は DescriptorPool 内部で排他されているため,
+    // アップロードバッチをタスクごとに用意すれば独立したリソースは同時に生成できる.
+    TaskGraph graph;
+
+    // マテリアル数はメッシュのロード後に確定する.
+    size_t materialCount = 0;
+
+    // メモリ使用量の計上用(メッシュのタスクだけが書き込む).
+    uint64_t meshBytes = 0;
+
     // メッシュをロード.
+    auto loadMesh = graph.Add("LoadMesh", [&]()
     {
         std::wstring path;
 
@@ -184,6 +316,8 @@ bool SampleApp::OnInit()
             return false;
         }
 
+        materialCount = resMaterial.size();
+
         // メモリを予約.
         m_pMesh.reserve(resMesh.size());
 
@@ -215,113 +349,255 @@ bool SampleApp::OnInit()
         // メモリ最適化.
         m_pMesh.shrink_to_fit();
 
-        for(auto j=0; j<16; ++j)
+        // 深度プリパス用に, 全メッシュの位置だけを1つの頂点バッファにまとめる.
+        {
+            size_t vertexCount = 0;
+            size_t indexCount  = 0;
+            for (auto& res : resMesh)
+            {
+                vertexCount += res.Vertices.size();
+                indexCount  += res.Indices.size();
+                meshBytes   += res.Vertices.size() * sizeof(res.Vertices[0]) + res.Indices.size() * sizeof(uint32_t);
+            }
+
+            if (!m_DepthPrepassVB.Init<Vector3>(m_pDevice.Get(), vertexCount))
+            {
+                ELOG("Error : VertexBuffer::Init() Failed.");
+                return false;
+            }
+
+            if (!m_DepthPrepassIB.Init(m_pDevice.Get(), indexCount))
+            {
+                ELOG("Error : IndexBuffer::Init() Failed.");
+                return false;
+            }
+
+            auto pPositions = m_DepthPrepassVB.Map<Vector3>();
+            auto pIndices   = m_DepthPrepassIB.Map();
+            if (pPositions == nullptr || pIndices == nullptr)
+            {
+                ELOG("Error : Depth Pre-Pass Buffer Map Failed.");
+                return false;
+            }
+
+            m_DepthPrepassMesh.resize(resMesh.size());
+
+            uint32_t baseVertex = 0;
+            uint32_t startIndex = 0;
+            for (size_t i = 0; i < resMesh.size(); ++i)
+            {
+                auto& res = resMesh[i];
+
+                m_DepthPrepassMesh[i].IndexCount = uint32_t(res.Indices.size());
+                m_DepthPrepassMesh[i].StartIndex = startIndex;
+                m_DepthPrepassMesh[i].BaseVertex = int32_t(baseVertex);
+
+                for (size_t j = 0; j < res.Vertices.size(); ++j)
+                { pPositions[baseVertex + j] = res.Vertices[j].Position; }
+
+                memcpy(pIndices + startIndex, res.Indices.data(), sizeof(uint32_t) * res.Indices.size());
+
+                baseVertex += uint32_t(res.Vertices.size());
+                startIndex += uint32_t(res.Indices.size());
+            }
+
+            m_DepthPrepassVB.Unmap();
+            m_DepthPrepassIB.Unmap();
+        }
+
+        return true;
+    });
+
+    // マテリアルとテクスチャセットの初期化(マテリアルごとに並列に読み込む).
+    static const struct { const char* Name; const wchar_t* Path; } TextureSets[] = {
+        { "wood",       L"../res/texture/wood"       },
+        { "camouflage", L"../res/texture/camouflage" },
+        { "dirt",       L"../res/texture/dirt"       },
+        { "fabric",     L"../res/texture/fabric"     },
+        { "leathertte", L"../res/texture/leathertte" },
+        { "machinery",  L"../res/texture/machinery"  },
+        { "marble",     L"../res/texture/marble"     },
+        { "plastic",    L"../res/texture/plastic"    },
+        { "rubber",     L"../res/texture/rubber"     },
+        { "rust",       L"../res/texture/rust"       },
+        { "bronze",     L"../res/texture/bronze"     },
+        { "steel",      L"../res/texture/steel"      },
+        { "iron",       L"../res/texture/iron"       },
+        { "alminum",    L"../res/texture/alminum"    },
+        { "copper",     L"../res/texture/copper"     },
+        { "gold",       L"../res/texture/gold"       },
+    };
+    static_assert(_countof(TextureSets) == _countof(m_Material), "TextureSets and m_Material must match.");
+
+    for(auto j=0; j<16; ++j)
+    {
+        auto name = std::string("Material:") + TextureSets[j].Name;
+        graph.Add(name.c_str(), [&, j]()
         {
             // マテリアル初期化.
             if (!m_Material[j].Init(
                 m_pDevice.Get(),
                 m_pPool[POOL_TYPE_RES],
                 sizeof(CbMaterial),
-                resMaterial.size()))
+                materialCount))
             {
                 ELOG("Error : Material::Init() Failed.");
                 return false;
             }
-        }
 
-        // リソースバッチを用意.
-        DirectX::ResourceUploadBatch batch(m_pDevice.Get());
+            // リソースバッチを用意.
+            DirectX::ResourceUploadBatch batch(m_pDevice.Get());
 
-        // バッチ開始.
-        batch.Begin();
+            // バッチ開始.
+            batch.Begin();
 
-        SetTextureSet(L"../res/texture/wood",       m_Material[0],  batch);
-        SetTextureSet(L"../res/texture/camouflage", m_Material[1],  batch);
-        SetTextureSet(L"../res/texture/dirt",       m_Material[2],  batch);
-        SetTextureSet(L"../res/texture/fabric",     m_Material[3],  batch);
-        SetTextureSet(L"../res/texture/leathertte", m_Material[4],  batch);
-        SetTextureSet(L"../res/texture/machinery",  m_Material[5],  batch);
-        SetTextureSet(L"../res/texture/marble",     m_Material[6],  batch);
-        SetTextureSet(L"../res/texture/plastic",    m_Material[7],  batch);
-        SetTextureSet(L"../res/texture/rubber",     m_Material[8],  batch);
-        SetTextureSet(L"../res/texture/rust",       m_Material[9],  batch);
-        SetTextureSet(L"../res/texture/bronze",     m_Material[10], batch);
-        SetTextureSet(L"../res/texture/steel",      m_Material[11], batch);
-        SetTextureSet(L"../res/texture/iron",       m_Material[12], batch);
-        SetTextureSet(L"../res/texture/alminum",    m_Material[13], batch);
-        SetTextureSet(L"../res/texture/copper",     m_Material[14], batch);
-        SetTextureSet(L"../res/texture/gold",       m_Material[15], batch);
+            SetTextureSet(TextureSets[j].Path, m_Material[j], batch);
 
-        // バッチ終了.
-        auto future = batch.End(m_pQueue.Get());
+            // バッチ終了.
+            auto future = batch.End(m_pQueue.Get());
 
-        // バッチ完了を待機.
-        future.wait();
+            // バッチ完了を待機.
+            future.wait();
+
+            return true;
+        }, { loadMesh });
     }
 
-    // ライトバッファの生成.
+    // 定数バッファの生成.
+    graph.Add("ConstantBuffers", [&]()
     {
-        for (auto i=0; i<FrameCount; ++i)
+        // ライトバッファの生成.
         {
-            if (!m_LightCB[i].Init(m_pDevice.Get(), m_pPool[POOL_TYPE_RES], sizeof(CbLight)))
+            for (auto i=0; i<FrameCount; ++i)
             {
-                ELOG("Error : ConstantBuffer::Init() Failed.");
-                return false;
+                if (!m_LightCB[i].Init(m_pDevice.Get(), m_pPool[POOL_TYPE_RES], sizeof(CbLight)))
+                {
+                    ELOG("Error : ConstantBuffer::Init() Failed.");
+                    return false;
+                }
             }
         }
-    }
 
-    // カメラバッファの設定.
-    {
-        for (auto i=0; i<FrameCount; ++i)
+        // カメラバッファの設定.
+        {
+            for (auto i=0; i<FrameCount; ++i)
+            {
+                if (!m_CameraCB[i].Init(m_pDevice.Get(), m_pPool[POOL_TYPE_RES], sizeof(CbCamera)))
+                {
+                    ELOG("Error : ConstantBuffer::Init() Failed.");
+                    return false;
+                }
+            }
+        }
+
+        // トーンマップ用定数バッファの生成.
+        for(auto i=0; i<FrameCount; ++i)
         {
-            if (!m_CameraCB[i].Init(m_pDevice.Get(), m_pPool[POOL_TYPE_RES], sizeof(CbCamera)))
+            if (!m_TonemapCB[i].Init(m_pDevice.Get(), m_pPool[POOL_TYPE_RES], sizeof(CbTonemap)))
             {
                 ELOG("Error : ConstantBuffer::Init() Failed.");
                 return false;
             }
         }
-    }
 
-    // シーン用カラーターゲットの生成.
-    {
-        float clearColor[4] = { 0.2f, 0.2f, 0.2f, 1.0f };
+        // 変換行列用の定数バッファの生成.
+        {
+            for (auto i = 0u; i<FrameCount; ++i)
+            {
+                // 定数バッファ初期化.
+                if (!m_TransformCB[i].Init(m_pDevice.Get(), m_pPool[POOL_TYPE_RES], sizeof(CbTransform)))
+                {
+                    ELOG("Error : ConstantBuffer::Init() Failed.");
+                    return false;
+                }
 
-        if (!m_SceneColorTarget.Init(
-            m_pDevice.Get(),
-            m_pPool[POOL_TYPE_RTV],
-            m_pPool[POOL_TYPE_RES],
-            m_Width,
-            m_Height,
-            DXGI_FORMAT_R10G10B10A2_UNORM,
-            clearColor))
+                // カメラ設定.
+                auto eyePos     = Vector3(0.0f, 1.0f, 2.0f);
+                auto targetPos  = Vector3::Zero;
+                auto upward     = Vector3::UnitY;
+
+                // 垂直画角とアスペクト比の設定.
+                auto fovY = DirectX::XMConvertToRadians(37.5f);
+                auto aspect = static_cast<float>(m_Width) / static_cast<float>(m_Height);
+
+                // 変換行列を設定.
+                auto ptr = m_TransformCB[i].GetPtr<CbTransform>();
+                ptr->View   = Matrix::CreateLookAt(eyePos, targetPos, upward);
+                ptr->Proj   = Matrix::CreatePerspectiveFieldOfView(fovY, aspect, 1.0f, 1000.0f);
+            }
+        }
+
+        // メッシュ用バッファの生成.
         {
-            ELOG("Error : ColorTarget::Init() Failed.");
-            return false;
+            for (size_t i=0; i<m_MeshCB.size(); ++i)
+            {
+                if (!m_MeshCB[i].Init(m_pDevice.Get(), m_pPool[POOL_TYPE_RES], sizeof(CbMesh)))
+                {
+                    ELOG("Error : ConstantBuffer::Init() Failed.");
+                    return false;
+                }
+
+                auto ptr = m_MeshCB[i].GetPtr<CbMesh>();
+                ptr->World = Matrix::Identity;
+            }
         }
-    }
 
-    // シーン用深度ターゲットの生成.
+        return true;
+    });
+
+    // シーン用ターゲットの生成.
+    auto sceneTargets = graph.Add("SceneTargets", [&]()
     {
-        if (!m_SceneDepthTarget.Init(
-            m_pDevice.Get(),
-            m_pPool[POOL_TYPE_DSV],
-            nullptr,
-            m_Width,
-            m_Height,
-            DXGI_FORMAT_D32_FLOAT,
-            1.0f,
-            0))
+        // シーン用カラーターゲットの生成.
         {
-            ELOG("Error : DepthTarget::Init() Failed.");
-            return false;
+            float clearColor[4] = { 0.2f, 0.2f, 0.2f, 1.0f };
+
+            if (!m_SceneColorTarget.Init(
+                m_pDevice.Get(),
+                m_pPool[POOL_TYPE_RTV],
+                m_pPool[POOL_TYPE_RES],
+                m_Width,
+                m_Height,
+                DXGI_FORMAT_R10G10B10A2_UNORM,
+                clearColor))
+            {
+                ELOG("Error : ColorTarget::Init() Failed.");
+                return false;
+            }
+        }
+
+        // シーン用深度ターゲットの生成.
+        {
+            if (!m_SceneDepthTarget.Init(
+                m_pDevice.Get(),
+                m_pPool[POOL_TYPE_DSV],
+                nullptr,
+                m_Width,
+                m_Height,
+                DXGI_FORMAT_D32_FLOAT,
+                1.0f,
+                0))
+            {
+                ELOG("Error : DepthTarget::Init() Failed.");
+                return false;
+            }
         }
+
+        return true;
+    });
+
+    // パイプラインステートの非同期コンパイラの初期化.
+    if (!m_PipelineCompiler.Init(&m_PipelineCache))
+    {
+        ELOG("Error : AsyncPipelineCompiler::Init() Failed.");
+        return false;
     }
 
     // シーン用ルートシグニチャの生成.
+    auto sceneRootSig = graph.Add("SceneRootSig", [&]()
     {
         RootSignature::Desc desc;
-        desc.Begin(11)
+        desc.Begin(15)
             .SetCBV(ShaderStage::VS,  0, 0)
             .SetCBV(ShaderStage::VS,  1, 1)
             .SetCBV(ShaderStage::PS,  2, 1)
@@ -333,6 +609,10 @@ bool SampleApp::OnInit()
             .SetSRV(ShaderStage::PS,  8, 4)
             .SetSRV(ShaderStage::PS,  9, 5)
             .SetSRV(ShaderStage::PS, 10, 6)
+            .SetCBV(ShaderStage::PS, 11, 3)
+            .SetSRV(ShaderStage::PS, 12, 7)
+            .SetSRV(ShaderStage::PS, 13, 8)
+            .SetSRV(ShaderStage::PS, 14, 9)
             .AddStaticSmp(ShaderStage::PS, 0, SamplerState::LinearWrap)
             .AddStaticSmp(ShaderStage::PS, 1, SamplerState::LinearWrap)
             .AddStaticSmp(ShaderStage::PS, 2, SamplerState::LinearWrap)
@@ -348,43 +628,31 @@ bool SampleApp::OnInit()
             ELOG("Error : RootSignature::Init() Failed.");
             return false;
         }
-    }
 
-    // シーン用パイプラインステートの生成.
-    {
-        std::wstring vsPath;
-        std::wstring psPath;
-
-        // 頂点シェーダを検索.
-        if (!SearchFilePath(L"BasicVS.cso", vsPath))
-        {
-            ELOG("Error : Vertex Shader Not Found.");
-            return false;
-        }
+        m_SceneRootSigHash = HashRootSignatureDesc(*desc.GetDesc());
 
-        // ピクセルシェーダを検索.
-        if (!SearchFilePath(L"BasicPS.cso", psPath))
-        {
-            ELOG("Error : Pixel Shader Node Found.");
-            return false;
-        }
+        return true;
+    });
 
+    // シーン用パイプラインステートの生成.
+    graph.Add("ScenePSO", [&]()
+    {
+        D3D12_SHADER_BYTECODE vs = {};
+        D3D12_SHADER_BYTECODE ps = {};
         ComPtr<ID3DBlob> pVSBlob;
         ComPtr<ID3DBlob> pPSBlob;
 
-        // 頂点シェーダを読み込む.
-        auto hr = D3DReadFileToBlob(vsPath.c_str(), pVSBlob.GetAddressOf());
-        if (FAILED(hr))
+        // 頂点シェーダを取得(バンドルに無ければファイルから読み込む).
+        if (!LoadShader("BasicVS.cso", vs, pVSBlob.GetAddressOf()))
         {
-            ELOG("Error : D3DReadFiledToBlob() Failed. path = %ls", vsPath.c_str());
+            ELOG("Error : Vertex Shader Not Found.");
             return false;
         }
 
-        // ピクセルシェーダを読み込む.
-        hr = D3DReadFileToBlob(psPath.c_str(), pPSBlob.GetAddressOf());
-        if (FAILED(hr))
+        // ピクセルシェーダを取得.
+        if (!LoadShader("BasicPS.cso", ps, pPSBlob.GetAddressOf()))
         {
-            ELOG("Error : D3DReadFileToBlob() Failed. path = %ls", psPath.c_str());
+            ELOG("Error : Pixel Shader Not Found.");
             return false;
         }
 
@@ -399,8 +667,8 @@ bool SampleApp::OnInit()
         D3D12_GRAPHICS_PIPELINE_STATE_DESC desc = {};
         desc.InputLayout            = { elements, 4 };
         desc.pRootSignature         = m_SceneRootSig.GetPtr();
-        desc.VS                     = { pVSBlob->GetBufferPointer(), pVSBlob->GetBufferSize() };
-        desc.PS                     = { pPSBlob->GetBufferPointer(), pPSBlob->GetBufferSize() };
+        desc.VS                     = vs;
+        desc.PS                     = ps;
         desc.RasterizerState        = DirectX::CommonStates::CullNone;
         desc.BlendState             = DirectX::CommonStates::Opaque;
         desc.DepthStencilState      = DirectX::CommonStates::DepthDefault;
@@ -412,21 +680,75 @@ bool SampleApp::OnInit()
         desc.SampleDesc.Count       = 1;
         desc.SampleDesc.Quality     = 0;
 
-        // パイプラインステートを生成.
-        hr = m_pDevice->CreateGraphicsPipelineState(&desc, IID_PPV_ARGS(m_pScenePSO.GetAddressOf()));
-        if (FAILED(hr))
+        // パイプラインステートの生成を要求(完了までシーンの描画はスキップされる).
+        m_ScenePSO = m_PipelineCompiler.Request(desc, m_SceneRootSigHash);
+        if (m_ScenePSO == INVALID_PIPELINE_HANDLE)
         {
-            ELOG("Error : ID3D12Device::CreateGraphicsPipelineState() Failed. retcode = 0x%x", hr);
+            ELOG("Error : AsyncPipelineCompiler::Request() Failed.");
             return false;
         }
-    }
+
+        // 深度プリパスの後は, 最前面のピクセルだけをシェーディングする.
+        // プリパスとシーンは別の頂点シェーダで SV_Position を計算するため, 深度がビット単位で
+        // 一致する保証が無い. EQUAL では欠けが出るので LESS_EQUAL で比較する.
+        {
+            D3D12_DEPTH_STENCIL_DESC depthTest = DirectX::CommonStates::DepthDefault;
+            depthTest.DepthWriteMask = D3D12_DEPTH_WRITE_MASK_ZERO;
+            depthTest.DepthFunc      = D3D12_COMPARISON_FUNC_LESS_EQUAL;
+
+            auto equalDesc = desc;
+            equalDesc.DepthStencilState = depthTest;
+
+            m_SceneEqualPSO = m_PipelineCompiler.Request(equalDesc, m_SceneRootSigHash);
+            if (m_SceneEqualPSO == INVALID_PIPELINE_HANDLE)
+            {
+                ELOG("Error : AsyncPipelineCompiler::Request() Failed.");
+                return false;
+            }
+        }
+
+        // 深度プリパスは位置だけの頂点ストリームで深度のみ書き込む.
+        {
+            D3D12_SHADER_BYTECODE prepassVS = {};
+            ComPtr<ID3DBlob> pPrepassBlob;
+            if (!LoadShader("depth_prepass_v.cso", prepassVS, pPrepassBlob.GetAddressOf()))
+            {
+                ELOG("Error : Vertex Shader Not Found.");
+                return false;
+            }
+
+            D3D12_INPUT_ELEMENT_DESC positionOnly[] = {
+                { "POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 0, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
+            };
+
+            auto prepassDesc = desc;
+            prepassDesc.InputLayout         = { positionOnly, 1 };
+            prepassDesc.VS                  = prepassVS;
+            prepassDesc.PS                  = {};
+            prepassDesc.NumRenderTargets    = 0;
+            prepassDesc.RTVFormats[0]       = DXGI_FORMAT_UNKNOWN;
+
+            m_DepthPrepassPSO = m_PipelineCompiler.Request(prepassDesc, m_SceneRootSigHash);
+            if (m_DepthPrepassPSO == INVALID_PIPELINE_HANDLE)
+            {
+                ELOG("Error : AsyncPipelineCompiler::Request() Failed.");
+                return false;
+            }
+        }
+
+        return true;
+    }, { sceneRootSig, sceneTargets });
 
     // トーンマップ用ルートシグニチャの生成.
+    auto tonemapRootSig = graph.Add("TonemapRootSig", [&]()
     {
         RootSignature::Desc desc;
-        desc.Begin(2)
+        desc.Begin(5)
             .SetCBV(ShaderStage::PS, 0, 0)
             .SetSRV(ShaderStage::PS, 1, 0)
+            .SetSRV(ShaderStage::PS, 2, 1)
+            .SetSRV(ShaderStage::PS, 3, 2)
+            .SetSRV(ShaderStage::PS, 4, 3)
             .AddStaticSmp(ShaderStage::PS, 0, SamplerState::LinearWrap)
             .AllowIL()
             .End();
@@ -436,43 +758,31 @@ bool SampleApp::OnInit()
             ELOG("Error : RootSignature::Init() Failed.");
             return false;
         }
-    }
-
-    // トーンマップ用パイプラインステートの生成.
-    {
-        std::wstring vsPath;
-        std::wstring psPath;
 
-        // 頂点シェーダを検索.
-        if (!SearchFilePath(L"QuadVS.cso", vsPath))
-        {
-            ELOG( "Error : Vertex Shader Not Found.");
-            return false;
-        }
+        m_TonemapRootSigHash = HashRootSignatureDesc(*desc.GetDesc());
 
-        // ピクセルシェーダを検索.
-        if (!SearchFilePath(L"TonemapPS.cso", psPath))
-        {
-            ELOG( "Error : Pixel Shader Node Found.");
-            return false;
-        }
+        return true;
+    });
 
+    // トーンマップ用パイプラインステートの生成.
+    graph.Add("TonemapPSO", [&]()
+    {
+        D3D12_SHADER_BYTECODE vs = {};
+        D3D12_SHADER_BYTECODE ps = {};
         ComPtr<ID3DBlob> pVSBlob;
         ComPtr<ID3DBlob> pPSBlob;
 
-        // 頂点シェーダを読み込む.
-        auto hr = D3DReadFileToBlob( vsPath.c_str(), pVSBlob.GetAddressOf() );
-        if ( FAILED(hr) )
+        // 頂点シェーダを取得.
+        if (!LoadShader("QuadVS.cso", vs, pVSBlob.GetAddressOf()))
         {
-            ELOG( "Error : D3DReadFiledToBlob() Failed. path = %ls", vsPath.c_str() );
+            ELOG( "Error : Vertex Shader Not Found.");
             return false;
         }
 
-        // ピクセルシェーダを読み込む.
-        hr = D3DReadFileToBlob( psPath.c_str(), pPSBlob.GetAddressOf() );
-        if ( FAILED(hr) )
+        // ピクセルシェーダを取得.
+        if (!LoadShader("tonemap_p.cso", ps, pPSBlob.GetAddressOf()))
         {
-            ELOG( "Error : D3DReadFileToBlob() Failed. path = %ls", psPath.c_str() );
+            ELOG( "Error : Pixel Shader Not Found.");
             return false;
         }
 
@@ -485,8 +795,8 @@ bool SampleApp::OnInit()
         D3D12_GRAPHICS_PIPELINE_STATE_DESC desc = {};
         desc.InputLayout            = { elements, 2 };
         desc.pRootSignature         = m_TonemapRootSig.GetPtr();
-        desc.VS                     = { pVSBlob->GetBufferPointer(), pVSBlob->GetBufferSize() };
-        desc.PS                     = { pPSBlob->GetBufferPointer(), pPSBlob->GetBufferSize() };
+        desc.VS                     = vs;
+        desc.PS                     = ps;
         desc.RasterizerState        = DirectX::CommonStates::CullNone;
         desc.BlendState             = DirectX::CommonStates::Opaque;
         desc.DepthStencilState      = DirectX::CommonStates::DepthDefault;
@@ -498,148 +808,277 @@ bool SampleApp::OnInit()
         desc.SampleDesc.Count       = 1;
         desc.SampleDesc.Quality     = 0;
 
-        // パイプラインステートを生成.
-        hr = m_pDevice->CreateGraphicsPipelineState( &desc, IID_PPV_ARGS(m_pTonemapPSO.GetAddressOf()) );
-        if ( FAILED(hr) )
+        // パイプラインステートの生成を要求.
+        m_TonemapPSO = m_PipelineCompiler.Request( desc, m_TonemapRootSigHash );
+        if ( m_TonemapPSO == INVALID_PIPELINE_HANDLE )
         {
-            ELOG( "Error : ID3D12Device::CreateGraphicsPipelineState() Failed. retcode = 0x%x", hr );
+            ELOG( "Error : AsyncPipelineCompiler::Request() Failed." );
             return false;
         }
-    }
 
-    // 頂点バッファの生成.
-    {
-        struct Vertex
+        // LUT版はピクセルシェーダだけが異なる.
+        ComPtr<ID3DBlob> pLutBlob;
+        if (!LoadShader("tonemap_lut_p.cso", desc.PS, pLutBlob.GetAddressOf()))
         {
-            float px;
-            float py;
-
-            float tx;
-            float ty;
-        };
+            ELOG( "Error : Pixel Shader Not Found.");
+            return false;
+        }
 
-        if (!m_QuadVB.Init<Vertex>(m_pDevice.Get(), 3))
+        m_TonemapLUTPSO = m_PipelineCompiler.Request( desc, m_TonemapRootSigHash );
+        if ( m_TonemapLUTPSO == INVALID_PIPELINE_HANDLE )
         {
-            ELOG( "Error : VertexBuffer::Init() Failed.");
+            ELOG( "Error : AsyncPipelineCompiler::Request() Failed." );
             return false;
         }
 
-        auto ptr = m_QuadVB.Map<Vertex>();
-        assert(ptr != nullptr);
-        ptr[0].px = -1.0f;  ptr[0].py =  1.0f;  ptr[0].tx = 0.0f;   ptr[0].ty = -1.0f;
-        ptr[1].px =  3.0f;  ptr[1].py =  1.0f;  ptr[1].tx = 2.0f;   ptr[1].ty = -1.0f;
-        ptr[2].px = -1.0f;  ptr[2].py = -3.0f;  ptr[2].tx = 0.0f;   ptr[2].ty = 1.0f;
-        m_QuadVB.Unmap();
-    }
+        return true;
+    }, { tonemapRootSig });
 
-    for(auto i=0; i<FrameCount; ++i)
+    // トーンマップのLUTの初期化.
+    graph.Add("TonemapLUT", [&]()
     {
-        if (!m_TonemapCB[i].Init(m_pDevice.Get(), m_pPool[POOL_TYPE_RES], sizeof(CbTonemap)))
+        TonemapLUTDesc desc;
+        desc.Size = TonemapLUTSize;
+
+        if (!m_TonemapLUT.Init(m_pDevice.Get(), m_pPool[POOL_TYPE_RES], desc))
         {
-            ELOG("Error : ConstantBuffer::Init() Failed.");
+            ELOG("Error : TonemapLUT::Init() Failed.");
             return false;
         }
-    }
 
-    // 変換行列用の定数バッファの生成.
-    {
-        for (auto i = 0u; i<FrameCount; ++i)
-        {
-            // 定数バッファ初期化.
-            if (!m_TransformCB[i].Init(m_pDevice.Get(), m_pPool[POOL_TYPE_RES], sizeof(CbTransform)))
-            {
-                ELOG("Error : ConstantBuffer::Init() Failed.");
-                return false;
-            }
+        return true;
+    });
 
-            // カメラ設定.
-            auto eyePos     = Vector3(0.0f, 1.0f, 2.0f);
-            auto targetPos  = Vector3::Zero;
-            auto upward     = Vector3::UnitY;
+    // ブルームの初期化.
+    graph.Add("Bloom", [&]()
+    {
+        D3D12_SHADER_BYTECODE downsampleCS = {};
+        D3D12_SHADER_BYTECODE upsampleCS = {};
+        ComPtr<ID3DBlob> pDownsampleBlob;
+        ComPtr<ID3DBlob> pUpsampleBlob;
 
-            // 垂直画角とアスペクト比の設定.
-            auto fovY = DirectX::XMConvertToRadians(37.5f);
-            auto aspect = static_cast<float>(m_Width) / static_cast<float>(m_Height);
+        if (!LoadShader("bloom_downsample_c.cso", downsampleCS, pDownsampleBlob.GetAddressOf()))
+        {
+            ELOG("Error : Compute Shader Not Found.");
+            return false;
+        }
 
-            // 変換行列を設定.
-            auto ptr = m_TransformCB[i].GetPtr<CbTransform>();
-            ptr->View   = Matrix::CreateLookAt(eyePos, targetPos, upward);
-            ptr->Proj   = Matrix::CreatePerspectiveFieldOfView(fovY, aspect, 1.0f, 1000.0f);
+        if (!LoadShader("bloom_upsample_c.cso", upsampleCS, pUpsampleBlob.GetAddressOf()))
+        {
+            ELOG("Error : Compute Shader Not Found.");
+            return false;
         }
-    }
 
-    // bloom用のバッファの生成.
-    {
-        // ヒーププロパティ.
-        D3D12_HEAP_PROPERTIES prop = {};
-        prop.Type = D3D12_HEAP_TYPE_UPLOAD;
-        prop.CPUPageProperty = D3D12_CPU_PAGE_PROPERTY_UNKNOWN;
-        prop.MemoryPoolPreference = D3D12_MEMORY_POOL_UNKNOWN;
-        prop.CreationNodeMask = 1;
-        prop.VisibleNodeMask = 1;
-
-        // カラーターゲットのdesc
-        auto& desc = m_ColorTarget->GetDesc();
-
-        D3D12_CLEAR_VALUE clearValue = {};
-        clearValue.Color[0] = 0.0f;
-        clearValue.Color[1] = 0.0f;
-        clearValue.Color[2] = 0.0f;
-        clearValue.Color[3] = 1.0f;
-        clearValue.Format = desc.Format;
-
-        for (auto& res : m_BloomBuffers) 
-        {
-            auto hr = m_pDevice->CreateCommittedResource(
-                &prop,
-                D3D12_HEAP_FLAG_NONE,
-                &desc,
-                D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE,
-                &clearValue,
-                IID_PPV_ARGS(res.ReleaseAndGetAddressOf()));
-
-            // 2枚目は縮小バッファなので幅を半分にする
-            desc.Width >>= 1;
-
-            if (FAILED(hr))
-            {
-                return false;
-            }
+        if (!m_Bloom.Init(
+            m_pDevice.Get(),
+            m_pPool[POOL_TYPE_RES],
+            &m_PipelineCache,
+            downsampleCS,
+            upsampleCS,
+            m_Width,
+            m_Height))
+        {
+            ELOG("Error : Bloom::Init() Failed.");
+            return false;
         }
-    }
 
-    // メッシュ用バッファの生成.
+        return true;
+    });
+
+    // GPU時間計測の初期化.
+    graph.Add("GpuTimer", [&]()
     {
-        for (auto i=0; i<FrameCount * 16; ++i)
+        if (!m_GpuTimer.Init(m_pDevice.Get(), &m_HeapAllocator, m_pQueue.Get(), GpuTimerScopes))
         {
-            if (!m_MeshCB[i].Init(m_pDevice.Get(), m_pPool[POOL_TYPE_RES], sizeof(CbMesh)))
-            {
-                ELOG("Error : ConstantBuffer::Init() Failed.");
-                return false;
-            }
-
-            auto ptr = m_MeshCB[i].GetPtr<CbMesh>();
-            ptr->World = Matrix::Identity;
+            ELOG("Error : GpuTimer::Init() Failed.");
+            return false;
         }
-    }
 
-    if (!m_IBLBaker.Init(m_pDevice.Get(), m_pPool[POOL_TYPE_RES], m_pPool[POOL_TYPE_RTV]))
-    {
-        ELOG("Error : IBLBaker::Init() Failed.");
-        return false;
-    }
+        return true;
+    });
 
-    // テクスチャロード.
+    // 自動露出の初期化.
+    graph.Add("AutoExposure", [&]()
     {
-        DirectX::ResourceUploadBatch batch(m_pDevice.Get());
-
-        // バッチ開始.
-        batch.Begin();
+        D3D12_SHADER_BYTECODE histogramCS = {};
+        D3D12_SHADER_BYTECODE adaptCS = {};
+        ComPtr<ID3DBlob> pHistogramBlob;
+        ComPtr<ID3DBlob> pAdaptBlob;
 
-        // スフィアマップ読み込み.
+        if (!LoadShader("luminance_histogram_c.cso", histogramCS, pHistogramBlob.GetAddressOf()))
         {
-            std::wstring sphereMapPath;
-            if (!SearchFilePathW(L"../res/texture/hdr014.dds", sphereMapPath))
+            ELOG("Error : Compute Shader Not Found.");
+            return false;
+        }
+
+        if (!LoadShader("exposure_adapt_c.cso", adaptCS, pAdaptBlob.GetAddressOf()))
+        {
+            ELOG("Error : Compute Shader Not Found.");
+            return false;
+        }
+
+        if (!m_AutoExposure.Init(
+            m_pDevice.Get(),
+            m_pPool[POOL_TYPE_RES],
+            &m_PipelineCache,
+            histogramCS,
+            adaptCS))
+        {
+            ELOG("Error : AutoExposure::Init() Failed.");
+            return false;
+        }
+
+        return true;
+    });
+
+    // クラスターライティングの初期化.
+    graph.Add("LightCluster", [&]()
+    {
+        D3D12_SHADER_BYTECODE assignCS = {};
+        ComPtr<ID3DBlob> pAssignBlob;
+
+        if (!LoadShader("light_cluster_c.cso", assignCS, pAssignBlob.GetAddressOf()))
+        {
+            ELOG("Error : Compute Shader Not Found.");
+            return false;
+        }
+
+        if (!m_LightCluster.Init(
+            m_pDevice.Get(),
+            m_pPool[POOL_TYPE_RES],
+            &m_HeapAllocator,
+            &m_PipelineCache,
+            assignCS,
+            MaxPointLights))
+        {
+            ELOG("Error : LightCluster::Init() Failed.");
+            return false;
+        }
+
+        // オブジェクトの周りに色付きのライトをばら撒く. 4つに1つは下向きのスポットライト.
+        std::mt19937 rng(12345);
+        std::uniform_real_distribution<float> dist(0.0f, 1.0f);
+
+        m_PointLights.resize(MaxPointLights);
+        for (auto& light : m_PointLights)
+        {
+            auto color = Vector3(dist(rng), dist(rng), dist(rng));
+            color /= (color.x + color.y + color.z + 1e-3f);
+
+            light = {};
+            light.Position[0]   = dist(rng) * 6.0f - 3.0f;
+            light.Position[1]   = dist(rng) * 1.5f + 0.05f;
+            light.Position[2]   = dist(rng) * 6.0f - 3.0f;
+            light.Range         = dist(rng) * 0.4f + 0.2f;
+            light.Color[0]      = color.x;
+            light.Color[1]      = color.y;
+            light.Color[2]      = color.z;
+            light.Intensity     = dist(rng) * 2.0f + 1.0f;
+            light.Direction[1]  = -1.0f;
+            light.SpotCosOuter  = DirectX::XMScalarCos(DirectX::XMConvertToRadians(40.0f));
+            light.SpotCosInner  = DirectX::XMScalarCos(DirectX::XMConvertToRadians(30.0f));
+            light.Type          = (dist(rng) < 0.25f) ? CLUSTER_LIGHT_SPOT : CLUSTER_LIGHT_POINT;
+        }
+
+        return true;
+    });
+
+    // 頂点バッファの生成.
+    graph.Add("QuadVB", [&]()
+    {
+        struct Vertex
+        {
+            float px;
+            float py;
+
+            float tx;
+            float ty;
+        };
+
+        if (!m_QuadVB.Init<Vertex>(m_pDevice.Get(), 3))
+        {
+            ELOG( "Error : VertexBuffer::Init() Failed.");
+            return false;
+        }
+
+        auto ptr = m_QuadVB.Map<Vertex>();
+        assert(ptr != nullptr);
+        ptr[0].px = -1.0f;  ptr[0].py =  1.0f;  ptr[0].tx = 0.0f;   ptr[0].ty = -1.0f;
+        ptr[1].px =  3.0f;  ptr[1].py =  1.0f;  ptr[1].tx = 2.0f;   ptr[1].ty = -1.0f;
+        ptr[2].px = -1.0f;  ptr[2].py = -3.0f;  ptr[2].tx = 0.0f;   ptr[2].ty = 1.0f;
+        m_QuadVB.Unmap();
+
+        return true;
+    });
+
+    // IBLベイクの初期化.
+    auto iblBaker = graph.Add("IBLBaker", [&]()
+    {
+        D3D12_SHADER_BYTECODE diffuseCS = {};
+        D3D12_SHADER_BYTECODE specularCS = {};
+        ComPtr<ID3DBlob> pDiffuseBlob;
+        ComPtr<ID3DBlob> pSpecularBlob;
+
+        if (!LoadShader("ibl_diffuse_ld_c.cso", diffuseCS, pDiffuseBlob.GetAddressOf()))
+        {
+            ELOG("Error : Compute Shader Not Found.");
+            return false;
+        }
+
+        if (!LoadShader("ibl_specular_ld_c.cso", specularCS, pSpecularBlob.GetAddressOf()))
+        {
+            ELOG("Error : Compute Shader Not Found.");
+            return false;
+        }
+
+        if (!m_IBLBaker.Init(
+            m_pDevice.Get(),
+            m_pPool[POOL_TYPE_RES],
+            m_pPool[POOL_TYPE_RTV],
+            &m_PipelineCache,
+            diffuseCS,
+            specularCS))
+        {
+            ELOG("Error : ProgressiveIBLBaker::Init() Failed.");
+            return false;
+        }
+
+        return true;
+    });
+
+    // 環境マップのロード.
+    auto environmentMap = graph.Add("EnvironmentMap", [&]()
+    {
+        DirectX::ResourceUploadBatch batch(m_pDevice.Get());
+
+        // バッチ開始.
+        batch.Begin();
+
+        // 事前変換済みキューブマップ読み込み.
+        {
+            std::wstring cubeMapPath;
+            if (SearchFilePath(L"../res/texture/hdr014_cube.dds", cubeMapPath))
+            {
+                // テクスチャ初期化.
+                if (!m_CookedCubeMap.Init(
+                    m_pDevice.Get(),
+                    m_pPool[POOL_TYPE_RES],
+                    cubeMapPath.c_str(),
+                    batch))
+                {
+                    ELOG("Error : Texture::Init() Failed.");
+                    return false;
+                }
+
+                m_UseCookedCubeMap = true;
+            }
+        }
+
+        // スフィアマップ読み込み.
+        if (!m_UseCookedCubeMap)
+        {
+            std::wstring sphereMapPath;
+            if (!SearchFilePath(L"../res/texture/hdr014.dds", sphereMapPath))
             {
                 ELOG("Error : File Not Found.");
                 return false;
@@ -662,31 +1101,44 @@ bool SampleApp::OnInit()
 
         // 完了を待機.
         future.wait();
-    }
+
+        return true;
+    });
 
     // スフィアマップコンバーター初期化.
-    if (!m_SphereMapConverter.Init(
-        m_pDevice.Get(),
-        m_pPool[POOL_TYPE_RTV],
-        m_pPool[POOL_TYPE_RES],
-        m_SphereMap.GetResource()->GetDesc()))
+    auto sphereMapConverter = graph.Add("SphereMapConverter", [&]()
     {
-        ELOG("Error : SphereMapConverter::Init() Failed.");
-        return false;
-    }
+        if (!m_UseCookedCubeMap && !m_SphereMapConverter.Init(
+            m_pDevice.Get(),
+            m_pPool[POOL_TYPE_RTV],
+            m_pPool[POOL_TYPE_RES],
+            m_SphereMap.GetResource()->GetDesc()))
+        {
+            ELOG("Error : SphereMapConverter::Init() Failed.");
+            return false;
+        }
+
+        return true;
+    }, { environmentMap });
 
     // スカイボックス初期化.
-    if (!m_SkyBox.Init(
-        m_pDevice.Get(),
-        m_pPool[POOL_TYPE_RES],
-        DXGI_FORMAT_R10G10B10A2_UNORM,
-        DXGI_FORMAT_D32_FLOAT))
+    graph.Add("SkyBox", [&]()
     {
-        ELOG("Error : SkyBox::Init() Failed.");
-        return false;
-    }
+        if (!m_SkyBox.Init(
+            m_pDevice.Get(),
+            m_pPool[POOL_TYPE_RES],
+            DXGI_FORMAT_R10G10B10A2_UNORM,
+            DXGI_FORMAT_D32_FLOAT))
+        {
+            ELOG("Error : SkyBox::Init() Failed.");
+            return false;
+        }
+
+        return true;
+    });
 
     // ベイク処理を実行.
+    graph.Add("Bake", [&]()
     {
         // コマンドリストの記録を開始.
         auto pCmd = m_CommandList.Reset();
@@ -697,17 +1149,12 @@ bool SampleApp::OnInit()
 
         pCmd->SetDescriptorHeaps(1, pHeaps);
 
-        // キューブマップに変換.
-        m_SphereMapConverter.DrawToCube(pCmd, m_SphereMap.GetHandleGPU());
+        // キューブマップに変換(事前変換済みであれば不要).
+        if (!m_UseCookedCubeMap)
+        { m_SphereMapConverter.DrawToCube(pCmd, m_SphereMap.GetHandleGPU()); }
 
-        auto desc   = m_SphereMapConverter.GetCubeMapDesc();
-        auto handle = m_SphereMapConverter.GetCubeMapHandleGPU();
-
-        // DFG項を積分.
-        m_IBLBaker.IntegrateDFG(pCmd);
-
-        // LD項を積分.
-        m_IBLBaker.IntegrateLD(pCmd, uint32_t(desc.Width), desc.MipLevels, handle);
+        // DFG項とLD項を積分.
+        m_IBLBaker.Bake(pCmd, GetCubeMapHandleGPU());
 
         // コマンドリストの記録を終了.
         pCmd->Close();
@@ -718,6 +1165,32 @@ bool SampleApp::OnInit()
 
         // 完了を待機.
         m_Fence.Sync( m_pQueue.Get() );
+
+        return true;
+    }, { iblBaker, environmentMap, sphereMapConverter });
+
+    // 初期化を実行.
+    auto succeeded = graph.Run();
+
+    // クリティカルパスを含む所要時間を出力.
+    printf("%s", graph.FormatReport().c_str());
+
+    if (!succeeded)
+    {
+        ELOG("Error : Initialize Task Failed.");
+        return false;
+    }
+
+    // タスクが終わってからまとめて計上する.
+    TrackMemory(meshBytes);
+
+    // ベンチマークは描画負荷を一定にするため動的解像度を使わない.
+    if (m_BenchmarkSettings.Enable)
+    {
+        m_DynamicResolution.GetSettings().Enable = false;
+        m_DynamicResolution.Reset();
+        m_Camera.Reset();
+        m_Benchmark.Start(m_BenchmarkSettings);
     }
 
     return true;
@@ -737,7 +1210,7 @@ void SampleApp::OnTerm()
         m_TransformCB[i].Term();
     }
 
-    for(auto i=0; i<FrameCount* 16; ++i)
+    for(size_t i=0; i<m_MeshCB.size(); ++i)
     {
         m_MeshCB[i].Term();
     }
@@ -750,6 +1223,10 @@ void SampleApp::OnTerm()
     m_pMesh.clear();
     m_pMesh.shrink_to_fit();
 
+    m_DepthPrepassVB.Term();
+    m_DepthPrepassIB.Term();
+    m_DepthPrepassMesh.clear();
+
     // マテリアル破棄.
     for(auto i=0; i<16; ++i)
     {
@@ -758,17 +1235,33 @@ void SampleApp::OnTerm()
 
     m_SceneColorTarget.Term();
     m_SceneDepthTarget.Term();
+    m_AutoExposure.Term();
+    m_LightCluster.Term();
+    m_PointLights.clear();
+    m_TonemapLUT.Term();
+    m_Bloom.Term();
+    m_GpuTimer.Term();
+
+    // コンパイル中のパイプラインの完了を待ってから破棄.
+    m_PipelineCompiler.Term();
+    m_ScenePSO   = INVALID_PIPELINE_HANDLE;
+    m_SceneEqualPSO = INVALID_PIPELINE_HANDLE;
+    m_DepthPrepassPSO = INVALID_PIPELINE_HANDLE;
+    m_TonemapPSO = INVALID_PIPELINE_HANDLE;
+    m_TonemapLUTPSO = INVALID_PIPELINE_HANDLE;
 
-    m_pScenePSO   .Reset();
     m_SceneRootSig.Term();
-
-    m_pTonemapPSO   .Reset();
     m_TonemapRootSig.Term();
 
     m_IBLBaker.Term();
     m_SphereMapConverter.Term();
     m_SphereMap.Term();
+    m_CookedCubeMap.Term();
     m_SkyBox.Term();
+
+    for (auto id : m_MemoryIds)
+    { GetMemoryTracker().Remove(id); }
+    m_MemoryIds.clear();
 }
 
 //-----------------------------------------------------------------------------
@@ -776,6 +1269,44 @@ void SampleApp::OnTerm()
 //-----------------------------------------------------------------------------
 void SampleApp::OnRender()
 {
+    m_Profiler.BeginFrame();
+    ProfileScope frameScope(m_Profiler, "OnRender");
+
+    // メッセージ処理から届いた入力を反映.
+    ProcessInput();
+
+    // 完了したパイプラインのコンパイルを反映.
+    m_PipelineCompiler.Poll();
+
+    // 経過時間を求める(停止後に一気に順応しないよう制限する).
+    auto now = std::chrono::steady_clock::now();
+    auto deltaTime = std::chrono::duration<float>(now - m_LastFrameTime).count();
+    auto frameMs   = deltaTime * 1000.0f;
+    if (deltaTime > 0.1f)
+    { deltaTime = 0.1f; }
+    m_LastFrameTime = now;
+
+    // ベンチマーク中はフレーム番号だけで決まるカメラの軌道をたどり, 経過時間も固定する.
+    // パイプラインが揃うまでは進めない.
+    auto benchmarking = m_Benchmark.IsRunning() && m_FirstFrameReported;
+    if (benchmarking)
+    {
+        auto step = m_Benchmark.GetCameraStep();
+
+        Camera::Event args = {};
+        args.Type    = Camera::EventRotate;
+        args.RotateH = step.RotateH;
+        args.RotateV = step.RotateV;
+        m_Camera.UpdateByEvent(args);
+
+        args = {};
+        args.Type  = Camera::EventDolly;
+        args.Dolly = step.Dolly;
+        m_Camera.UpdateByEvent(args);
+
+        deltaTime = BenchmarkDeltaTime;
+    }
+
     // カメラ更新.
     {
         auto fovY = DirectX::XMConvertToRadians(37.5f);
@@ -788,75 +1319,262 @@ void SampleApp::OnRender()
     // コマンドリストの記録を開始.
     auto pCmd = m_CommandList.Reset();
 
+    // 同じフレーム番号で前回計測した結果を集計.
+    m_GpuTimer.BeginFrame(m_FrameIndex);
+
+    // キャプチャ中ならGPUのタイムラインも記録する.
+    if (m_Profiler.IsCapturing())
+    {
+        for (auto& sample : m_GpuTimer.GetLastFrameSamples())
+        { m_Profiler.AddGpuEvent(sample.Name.c_str(), sample.BeginUs, sample.EndUs); }
+    }
+
+    // 同じフレーム番号で記録したIBLベイクの作業の計測時間を見積もりに反映する.
+    for (auto& sample : m_GpuTimer.GetLastFrameSamples())
+    {
+        if (sample.Name == "IBLBake")
+        { m_IBLBaker.ReportGpuTime(m_FrameIndex, (sample.EndUs - sample.BeginUs) / 1000.0); }
+    }
+
+    // 集計したGPU時間から, このフレームでシーンを描く大きさを決める.
+    // レンダーターゲットは最大サイズのまま, 左上の一部だけに描画する.
+    {
+        double gpuMs = 0.0;
+        if (m_GpuTimer.GetLastFrameMs(gpuMs))
+        { m_DynamicResolution.Update(float(gpuMs)); }
+
+        uint32_t width  = m_Width;
+        uint32_t height = m_Height;
+        m_DynamicResolution.GetRenderSize(m_Width, m_Height, width, height);
+
+        m_SceneViewport          = m_Viewport;
+        m_SceneViewport.TopLeftX = 0.0f;
+        m_SceneViewport.TopLeftY = 0.0f;
+        m_SceneViewport.Width    = float(width);
+        m_SceneViewport.Height   = float(height);
+
+        m_SceneScissor.left     = 0;
+        m_SceneScissor.top      = 0;
+        m_SceneScissor.right    = LONG(width);
+        m_SceneScissor.bottom   = LONG(height);
+    }
+
     ID3D12DescriptorHeap* const pHeaps[] = {
         m_pPool[POOL_TYPE_RES]->GetHeap(),
     };
     pCmd->SetDescriptorHeaps(1, pHeaps);
 
+    // フレームグラフを構築.
+    // 内部で状態を管理するリソース(IBL, 露光, ブルーム, LUT)は順序付けのためだけに宣言する.
+    auto& graph = m_FrameGraph;
+    graph.Clear();
+
+    std::vector<ID3D12Resource*> resources;
+    auto importResource = [&](const char* name, ID3D12Resource* pResource, uint32_t initialUsage, uint32_t finalUsage)
+    {
+        resources.push_back(pResource);
+        return graph.Import(name, initialUsage, finalUsage);
+    };
+
+    const uint32_t ShaderRead = FRAME_USAGE_PIXEL_READ | FRAME_USAGE_NON_PIXEL_READ;
+
+    auto backBuffer = importResource("BackBuffer", m_ColorTarget[m_FrameIndex].GetResource(), FRAME_USAGE_PRESENT, FRAME_USAGE_PRESENT);
+    auto depth      = importResource("Depth",      m_DepthTarget.GetResource(),      FRAME_USAGE_DEPTH_WRITE, FRAME_USAGE_DEPTH_WRITE);
+    auto sceneColor = importResource("SceneColor", m_SceneColorTarget.GetResource(), m_SceneColorUsage, FRAME_USAGE_NONE);
+    auto sceneDepth = importResource("SceneDepth", m_SceneDepthTarget.GetResource(), FRAME_USAGE_DEPTH_WRITE, FRAME_USAGE_DEPTH_WRITE);
+    auto ibl        = importResource("IBL",        nullptr, FRAME_USAGE_PIXEL_READ, FRAME_USAGE_NONE);
+    auto exposure   = importResource("Exposure",   nullptr, ShaderRead, FRAME_USAGE_NONE);
+    auto bloom      = importResource("Bloom",      nullptr, ShaderRead, FRAME_USAGE_NONE);
+    auto lut        = importResource("TonemapLUT", nullptr, FRAME_USAGE_PIXEL_READ, FRAME_USAGE_NONE);
+    auto clusters   = importResource("Clusters",   nullptr, FRAME_USAGE_PIXEL_READ, FRAME_USAGE_NONE);
+
+    // 環境マップ変更時のベイクを予算内で進める.
     {
-        // 書き込み用リソースバリア設定.
-        DirectX::TransitionResource(pCmd,
-            m_SceneColorTarget.GetResource(),
-            D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE,
-            D3D12_RESOURCE_STATE_RENDER_TARGET);
-
-        // ディスクリプタ取得.
-        auto handleRTV = m_SceneColorTarget.GetHandleRTV();
-        auto handleDSV = m_SceneDepthTarget.GetHandleDSV();
-
-        // レンダーターゲットを設定.
-        pCmd->OMSetRenderTargets(1, &handleRTV->HandleCPU, FALSE, &handleDSV->HandleCPU);
-
-        // レンダーターゲットをクリア.
-        m_SceneColorTarget.ClearView(pCmd);
-        m_SceneDepthTarget.ClearView(pCmd);
-
-        // ビューポート設定.
-        pCmd->RSSetViewports(1, &m_Viewport);
-        pCmd->RSSetScissorRects(1, &m_Scissor);
-
-        // 背景描画.
-        m_SkyBox.Draw(pCmd, m_SphereMapConverter.GetCubeMapHandleGPU(), m_View, m_Proj, 100.0f);
-
-        // シーンの描画.
-        DrawScene(pCmd);
-
-        // 読み込み用リソースバリア設定.
-        DirectX::TransitionResource(pCmd,
-            m_SceneColorTarget.GetResource(),
-            D3D12_RESOURCE_STATE_RENDER_TARGET,
-            D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+        auto pass = graph.AddPass("IBLBake", [&]()
+        {
+            auto scope = m_GpuTimer.Begin(pCmd, "IBLBake");
+            m_IBLBaker.Update(pCmd, m_FrameIndex);
+            m_GpuTimer.End(pCmd, scope);
+        });
+        graph.Write(pass, ibl, FRAME_USAGE_PIXEL_READ);
+        graph.SetSideEffect(pass);
+    }
+
+    // ライトをクラスターに割り当てる. 描画する大きさのビューポートで分割する.
+    {
+        auto pass = graph.AddPass("LightCulling", [&]()
+        {
+            auto scope = m_GpuTimer.Begin(pCmd, "LightCulling");
+
+            auto constants = MakeClusterConstants(
+                &m_View._11,
+                m_Proj._11,
+                m_Proj._22,
+                0.1f,
+                ClusterFarZ,
+                uint32_t(m_SceneScissor.right),
+                uint32_t(m_SceneScissor.bottom),
+                m_PointLightCount);
+
+            m_LightCluster.Update(pCmd, constants, m_PointLights.data(), m_FrameIndex);
+
+            m_GpuTimer.End(pCmd, scope);
+        });
+        graph.Write(pass, clusters, FRAME_USAGE_PIXEL_READ);
+    }
+
+    // シーンを描画.
+    {
+        auto pass = graph.AddPass("Scene", [&]()
+        {
+            auto scope = m_GpuTimer.Begin(pCmd, "Scene");
+
+            // ディスクリプタ取得.
+            auto handleRTV = m_SceneColorTarget.GetHandleRTV();
+            auto handleDSV = m_SceneDepthTarget.GetHandleDSV();
+
+            // レンダーターゲットを設定.
+            pCmd->OMSetRenderTargets(1, &handleRTV->HandleCPU, FALSE, &handleDSV->HandleCPU);
+
+            // レンダーターゲットをクリア.
+            m_SceneColorTarget.ClearView(pCmd);
+            m_SceneDepthTarget.ClearView(pCmd);
+
+            // ビューポート設定(動的解像度の大きさ).
+            pCmd->RSSetViewports(1, &m_SceneViewport);
+            pCmd->RSSetScissorRects(1, &m_SceneScissor);
+
+            // シーンの描画(深度プリパスを含む).
+            DrawScene(pCmd);
+
+            // 背景は不透明物の後に描き, 隠れたピクセルを深度テストで捨てる.
+            auto skyScope = m_GpuTimer.Begin(pCmd, "SkyBox");
+            m_SkyBox.Draw(pCmd, GetCubeMapHandleGPU(), m_View, m_Proj, 100.0f);
+            m_GpuTimer.End(pCmd, skyScope);
+
+            m_GpuTimer.End(pCmd, scope);
+        });
+        graph.Read (pass, ibl,        FRAME_USAGE_PIXEL_READ);
+        graph.Read (pass, clusters,   FRAME_USAGE_PIXEL_READ);
+        graph.Write(pass, sceneColor, FRAME_USAGE_RENDER_TARGET);
+        graph.Write(pass, sceneDepth, FRAME_USAGE_DEPTH_WRITE);
+    }
+
+    // 自動露出. 結果はGPUバッファに残し, トーンマップが直接参照する.
+    {
+        auto pass = graph.AddPass("AutoExposure", [&]()
+        {
+            auto scope = m_GpuTimer.Begin(pCmd, "AutoExposure");
+
+            // 描画済みの左上の領域だけでヒストグラムを作る.
+            m_AutoExposure.GetSettings().Compensation = m_Exposure;
+            m_AutoExposure.Dispatch(
+                pCmd,
+                m_SceneColorTarget.GetHandleSRV()->HandleGPU,
+                uint32_t(m_SceneScissor.right),
+                uint32_t(m_SceneScissor.bottom),
+                deltaTime,
+                m_FrameIndex);
+
+            m_GpuTimer.End(pCmd, scope);
+        });
+        graph.Read (pass, sceneColor, FRAME_USAGE_NON_PIXEL_READ);
+        graph.Write(pass, exposure,   ShaderRead);
+    }
+
+    // ブルーム. 露光後の明るさでしきい値を判定するため自動露出の後に行う.
+    {
+        auto pass = graph.AddPass("Bloom", [&]()
+        {
+            m_Bloom.Dispatch(
+                pCmd,
+                m_SceneColorTarget.GetHandleSRV()->HandleGPU,
+                uint32_t(m_SceneScissor.right),
+                uint32_t(m_SceneScissor.bottom),
+                m_AutoExposure.GetHandleSRV(),
+                m_FrameIndex,
+                &m_GpuTimer);
+        });
+        graph.Read (pass, sceneColor, FRAME_USAGE_NON_PIXEL_READ);
+        graph.Read (pass, exposure,   FRAME_USAGE_NON_PIXEL_READ);
+        graph.Write(pass, bloom,      ShaderRead);
+    }
+
+    // パラメータが変わったときだけLUTを焼き直し, 出来上がったら転送する.
+    {
+        auto pass = graph.AddPass("TonemapLUT", [&]()
+        {
+            if (m_UseTonemapLUT)
+            { m_TonemapLUT.Request({ m_TonemapType, m_ColorSpace, m_BaseLuminance, m_MaxLuminance }); }
+
+            if (m_TonemapLUT.Update(pCmd))
+            {
+                auto& report = m_TonemapLUT.GetReport();
+                printf("Tonemap LUT : %u^3, max error %.5f (%.2f / 1023), mean error %.6f, worst input (%g, %g, %g)\n",
+                    m_TonemapLUT.GetDesc().Size,
+                    report.MaxError,
+                    report.MaxError * 1023.0f,
+                    report.MeanError,
+                    report.MaxErrorInput[0],
+                    report.MaxErrorInput[1],
+                    report.MaxErrorInput[2]);
+            }
+        });
+        graph.Write(pass, lut, FRAME_USAGE_PIXEL_READ);
+        graph.SetSideEffect(pass);
     }
 
     // フレームバッファに描画.
     {
-        // 書き込み用リソースバリア設定.
-        DirectX::TransitionResource(pCmd,
-            m_ColorTarget[m_FrameIndex].GetResource(),
-            D3D12_RESOURCE_STATE_PRESENT,
-            D3D12_RESOURCE_STATE_RENDER_TARGET);
-
-        // ディスクリプタ取得.
-        auto handleRTV = m_ColorTarget[m_FrameIndex].GetHandleRTV();
-        auto handleDSV = m_DepthTarget.GetHandleDSV();
-
-        // レンダーターゲットを設定.
-        pCmd->OMSetRenderTargets(1, &handleRTV->HandleCPU, FALSE, &handleDSV->HandleCPU);
-
-        // レンダーターゲットをクリア.
-        m_ColorTarget[m_FrameIndex].ClearView(pCmd);
-        m_DepthTarget.ClearView(pCmd);
-
-        // トーンマップを適用.
-        DrawTonemap(pCmd);
-
-        // 表示用リソースバリア設定.
-        DirectX::TransitionResource(pCmd,
-            m_ColorTarget[m_FrameIndex].GetResource(),
-            D3D12_RESOURCE_STATE_RENDER_TARGET,
-            D3D12_RESOURCE_STATE_PRESENT);
+        auto pass = graph.AddPass("Tonemap", [&]()
+        {
+            auto scope = m_GpuTimer.Begin(pCmd, "Tonemap");
+
+            // ディスクリプタ取得.
+            auto handleRTV = m_ColorTarget[m_FrameIndex].GetHandleRTV();
+            auto handleDSV = m_DepthTarget.GetHandleDSV();
+
+            // レンダーターゲットを設定.
+            pCmd->OMSetRenderTargets(1, &handleRTV->HandleCPU, FALSE, &handleDSV->HandleCPU);
+
+            // レンダーターゲットをクリア.
+            m_ColorTarget[m_FrameIndex].ClearView(pCmd);
+            m_DepthTarget.ClearView(pCmd);
+
+            // トーンマップを適用.
+            DrawTonemap(pCmd);
+
+            m_GpuTimer.End(pCmd, scope);
+        });
+        graph.Read (pass, sceneColor, FRAME_USAGE_PIXEL_READ);
+        graph.Read (pass, exposure,   FRAME_USAGE_PIXEL_READ);
+        graph.Read (pass, lut,        FRAME_USAGE_PIXEL_READ);
+        graph.Write(pass, backBuffer, FRAME_USAGE_RENDER_TARGET);
+        graph.Write(pass, depth,      FRAME_USAGE_DEPTH_WRITE);
+
+        // 無効なブルームは読まないので, パスごと除去される.
+        if (m_Bloom.GetSettings().Enable)
+        { graph.Read(pass, bloom, FRAME_USAGE_PIXEL_READ); }
+    }
+
+    // 実行順とバリアを決めて記録.
+    if (graph.Compile())
+    {
+        graph.Execute([&](const FrameBarrier* pBarriers, uint32_t count)
+        {
+            RecordBarriers(pCmd, pBarriers, count, resources.data());
+        });
+
+        m_SceneColorUsage = graph.GetResource(sceneColor).EndUsage;
+    }
+    else
+    {
+        ALOG("Error : FrameGraph::Compile() Failed.");
     }
 
+    // 計測結果を読み戻し用バッファに解決.
+    m_GpuTimer.EndFrame(pCmd);
+
     // コマンドリストの記録を終了.
     pCmd->Close();
 
@@ -864,8 +1582,70 @@ void SampleApp::OnRender()
     ID3D12CommandList* pLists[] = { pCmd };
     m_pQueue->ExecuteCommandLists( 1, pLists );
 
-    // 画面に表示.
-    Present(1);
+    // 画面に表示. ベンチマーク中は表示を待たずに計測する(ティアリングの可否は App が判断する).
+    {
+        ProfileScope presentScope(m_Profiler, "Present");
+        Present(m_Benchmark.IsRunning() ? 0 : GetSyncInterval());
+    }
+
+    // ベンチマークの計測を進め, 完了したら結果を書き出して終了する.
+    if (benchmarking)
+    {
+        double gpuMs = -1.0;
+        m_GpuTimer.GetLastFrameMs(gpuMs);
+        m_Benchmark.AddFrame(frameMs, float(gpuMs));
+
+        if (m_Benchmark.GetState() == BENCHMARK_STATE_FINISHED)
+        {
+            // フレーム時間以外の比較対象も記録する.
+            uint64_t usedBytes = 0;
+            uint32_t allocationCount = 0;
+            for (auto i = 0; i < GPU_MEMORY_KIND_COUNT; ++i)
+            {
+                auto stats = m_HeapAllocator.GetStats(GPU_MEMORY_KIND(i));
+                usedBytes       += stats.UsedBytes;
+                allocationCount += stats.AllocationCount;
+            }
+            auto drawCount = m_DrawList.GetCount() * (m_UseDepthPrepass ? 2 : 1);
+            m_Benchmark.SetMetric("draw_calls",           double(drawCount));
+            m_Benchmark.SetMetric("gpu_heap_used_bytes",  double(usedBytes));
+            m_Benchmark.SetMetric("gpu_heap_allocations", double(allocationCount));
+
+            auto& path = m_BenchmarkSettings.OutputPath;
+            printf("%s", m_Benchmark.FormatReport().c_str());
+            printf("%s", m_GpuTimer.FormatReport().c_str());
+            if (m_Benchmark.WriteJson(path.c_str()))
+            { printf("Benchmark results written : %s\n", path.c_str()); }
+            else
+            { ALOG("Error : Benchmark::WriteJson() Failed. path = %s", path.c_str()); }
+
+            // 描画スレッドの PostQuitMessage はメッセージループに届かないので, ウィンドウを閉じる.
+            PostMessage(m_hWnd, WM_CLOSE, 0, 0);
+        }
+    }
+
+    // キャプチャが完了したらトレースを書き出す.
+    if (m_Profiler.HasFinishedCapture())
+    {
+        if (m_Profiler.WriteChromeTrace(ProfileTracePath))
+        { printf("Profile trace written : %s\n", ProfileTracePath); }
+        else
+        { ALOG("Error : Profiler::WriteChromeTrace() Failed. path = %s", ProfileTracePath); }
+
+        m_Profiler.ClearCapture();
+    }
+
+    // 起動から全パイプラインが揃った最初のフレームまでの時間を出力.
+    if (!m_FirstFrameReported
+     && m_PipelineCompiler.GetStatus(m_ScenePSO)   == PIPELINE_STATUS_READY
+     && m_PipelineCompiler.GetStatus(m_TonemapPSO) == PIPELINE_STATUS_READY)
+    {
+        auto elapsed = std::chrono::steady_clock::now() - m_LaunchTime;
+        auto elapsedMs = std::chrono::duration<double, std::milli>(elapsed).count();
+        printf("Time To First Frame : %.2f ms\n", elapsedMs);
+        m_Benchmark.SetMetric("time_to_first_frame_ms", elapsedMs);
+        m_FirstFrameReported = true;
+    }
 }
 
 //-----------------------------------------------------------------------------
@@ -873,11 +1653,18 @@ void SampleApp::OnRender()
 //-----------------------------------------------------------------------------
 void SampleApp::DrawScene(ID3D12GraphicsCommandList* pCmd)
 {
+    ProfileScope drawScope(m_Profiler, "DrawScene");
+
+    // パイプラインが準備できていなければ描画しない.
+    auto pPSO = m_PipelineCompiler.Get(m_ScenePSO);
+    if (pPSO == nullptr)
+    { return; }
+
     // ライトバッファの更新.
     {
         auto ptr = m_LightCB[m_FrameIndex].GetPtr<CbLight>();
-        ptr->TextureSize    = m_IBLBaker.LDTextureSize;
-        ptr->MipCount       = m_IBLBaker.MipCount;
+        ptr->TextureSize    = IBLBaker::LDTextureSize;
+        ptr->MipCount       = IBLBaker::MipCount;
         ptr->LightDirection = Vector3(0.0f, -1.0f, 0.0f);
         ptr->LightIntensity = 1.0f;
     }
@@ -895,18 +1682,33 @@ void SampleApp::DrawScene(ID3D12GraphicsCommandList* pCmd)
         ptr->Proj  = m_Proj;
     }
 
-    // メッシュのワールド行列の更新
+    // メッシュのワールド行列の更新と描画パケットの追加.
+    // 手前から奥に並べて Early-Z を効かせ, 同じ状態が続く間は設定を省く.
+    m_DrawList.Clear();
     {
-        auto space = 0.75f;
-        for(auto i=0; i<16; ++i)
+        auto space     = 0.75f;
+        auto offset    = -space * 0.5f * float(m_GridSize - 1);
+        auto meshCount = uint32_t(m_pMesh.size());
+        for (auto i = 0u; i < m_InstanceCount; ++i)
         {
-            auto x = -space * 1.5f + (i % 4) * space;
-            auto z = -space * 1.5f + (i / 4) * space;
+            auto x = offset + (i % m_GridSize) * space;
+            auto z = offset + (i / m_GridSize) * space;
 
-            auto ptr = m_MeshCB[i + m_FrameIndex * 16].GetPtr<CbMesh>();
+            auto ptr = m_MeshCB[i + m_FrameIndex * m_InstanceCount].GetPtr<CbMesh>();
             ptr->World = Matrix::CreateTranslation(Vector3(x, 0.0f, z));
+
+            // 右手系なのでビュー空間の -Z が奥行き.
+            auto viewPos = Vector3::Transform(Vector3(x, 0.0f, z), m_View);
+
+            for (auto j = 0u; j < meshCount; ++j)
+            {
+                auto material = ((i % _countof(m_Material)) << 8) | (m_pMesh[j]->GetMaterialId() & 0xff);
+                auto key = MakeDrawKey(DRAW_ORDER_FRONT_TO_BACK, 0, 0, material, -viewPos.z);
+                m_DrawList.Push(key, i * meshCount + j);
+            }
         }
     }
+    m_DrawList.Sort();
 
     pCmd->SetGraphicsRootSignature(m_SceneRootSig.GetPtr());
     pCmd->SetGraphicsRootDescriptorTable(0, m_TransformCB[m_FrameIndex].GetHandleGPU());
@@ -915,37 +1717,156 @@ void SampleApp::DrawScene(ID3D12GraphicsCommandList* pCmd)
     pCmd->SetGraphicsRootDescriptorTable(4, m_IBLBaker.GetHandleGPU_DFG());
     pCmd->SetGraphicsRootDescriptorTable(5, m_IBLBaker.GetHandleGPU_DiffuseLD());
     pCmd->SetGraphicsRootDescriptorTable(6, m_IBLBaker.GetHandleGPU_SpecularLD());
-    pCmd->SetPipelineState(m_pScenePSO.Get());
+    pCmd->SetGraphicsRootDescriptorTable(11, m_LightCluster.GetHandleCB());
+    pCmd->SetGraphicsRootDescriptorTable(12, m_LightCluster.GetHandleLights());
+    pCmd->SetGraphicsRootDescriptorTable(13, m_LightCluster.GetHandleRanges());
+    pCmd->SetGraphicsRootDescriptorTable(14, m_LightCluster.GetHandleIndices());
+
+    auto meshCount = uint32_t(m_pMesh.size());
+    auto pPackets  = m_DrawList.GetPackets();
+
+    // 深度プリパス. 位置だけの頂点ストリームで深度を先に埋め, シェーディングの重ね描きを無くす.
+    auto pPrepassPSO = m_PipelineCompiler.Get(m_DepthPrepassPSO);
+    auto pEqualPSO   = m_PipelineCompiler.Get(m_SceneEqualPSO);
+    if (m_UseDepthPrepass && pPrepassPSO != nullptr && pEqualPSO != nullptr)
+    {
+        auto scope = m_GpuTimer.Begin(pCmd, "DepthPrepass");
+
+        auto vbv = m_DepthPrepassVB.GetView();
+        auto ibv = m_DepthPrepassIB.GetView();
+        pCmd->SetPipelineState(pPrepassPSO);
+        pCmd->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+        pCmd->IASetVertexBuffers(0, 1, &vbv);
+        pCmd->IASetIndexBuffer(&ibv);
+
+        auto lastInstance = UINT32_MAX;
+        for (size_t k = 0; k < m_DrawList.GetCount(); ++k)
+        {
+            auto instance = pPackets[k].Index / meshCount;
+            auto& mesh    = m_DepthPrepassMesh[pPackets[k].Index % meshCount];
+
+            if (instance != lastInstance)
+            {
+                pCmd->SetGraphicsRootDescriptorTable(1, m_MeshCB[instance + m_FrameIndex * m_InstanceCount].GetHandleGPU());
+                lastInstance = instance;
+            }
+
+            pCmd->DrawIndexedInstanced(mesh.IndexCount, 1, mesh.StartIndex, mesh.BaseVertex, 0);
+        }
+
+        m_GpuTimer.End(pCmd, scope);
+
+        // 深度が一致したピクセルだけをシェーディングする.
+        pPSO = pEqualPSO;
+    }
+
+    pCmd->SetPipelineState(pPSO);
 
     // オブジェクトを描画.
-    for(auto i=0; i<16; ++i)
+    auto lastInstance = UINT32_MAX;
+    auto lastMaterial = UINT32_MAX;
+    for (size_t k = 0; k < m_DrawList.GetCount(); ++k)
     {
-        pCmd->SetGraphicsRootDescriptorTable(1, m_MeshCB[i + m_FrameIndex * 16].GetHandleGPU());
-        DrawMesh(pCmd, i);
+        auto instance = pPackets[k].Index / meshCount;
+        auto mesh     = pPackets[k].Index % meshCount;
+
+        if (instance != lastInstance)
+        {
+            pCmd->SetGraphicsRootDescriptorTable(1, m_MeshCB[instance + m_FrameIndex * m_InstanceCount].GetHandleGPU());
+            lastInstance = instance;
+        }
+
+        auto material = GetDrawKeyMaterial(DRAW_ORDER_FRONT_TO_BACK, pPackets[k].Key);
+        if (material != lastMaterial)
+        {
+            SetMaterial(pCmd, instance, m_pMesh[mesh]->GetMaterialId());
+            lastMaterial = material;
+        }
+
+        m_pMesh[mesh]->Draw(pCmd);
     }
 }
 
 //-----------------------------------------------------------------------------
-//      メッシュを描画します.
+//      マテリアルのテクスチャセットを設定します.
 //-----------------------------------------------------------------------------
-void SampleApp::DrawMesh(ID3D12GraphicsCommandList* pCmd, int material_index)
+void SampleApp::SetMaterial(ID3D12GraphicsCommandList* pCmd, uint32_t material_index, uint32_t id)
 {
-    for (size_t i = 0; i<m_pMesh.size(); ++i)
-    {
-        // マテリアルIDを取得.
-        auto id = m_pMesh[i]->GetMaterialId();
+    auto& mat = m_Material[material_index % _countof(m_Material)];
+
+    // テクスチャセットを設定.
+    pCmd->SetGraphicsRootDescriptorTable(7,  mat.GetTextureHandle(id, TU_BASE_COLOR));
+    pCmd->SetGraphicsRootDescriptorTable(8,  mat.GetTextureHandle(id, TU_METALLIC));
+    pCmd->SetGraphicsRootDescriptorTable(9,  mat.GetTextureHandle(id, TU_ROUGHNESS));
+    pCmd->SetGraphicsRootDescriptorTable(10, mat.GetTextureHandle(id, TU_NORMAL));
+}
 
-        auto& mat = m_Material[material_index];
+//-----------------------------------------------------------------------------
+//      環境キューブマップのリソース設定を取得します.
+//-----------------------------------------------------------------------------
+D3D12_RESOURCE_DESC SampleApp::GetCubeMapDesc() const
+{
+    if (m_UseCookedCubeMap)
+    { return m_CookedCubeMap.GetResource()->GetDesc(); }
 
-        // テクスチャセットを設定.
-        pCmd->SetGraphicsRootDescriptorTable(7,  mat.GetTextureHandle(id, TU_BASE_COLOR));
-        pCmd->SetGraphicsRootDescriptorTable(8,  mat.GetTextureHandle(id, TU_METALLIC));
-        pCmd->SetGraphicsRootDescriptorTable(9,  mat.GetTextureHandle(id, TU_ROUGHNESS));
-        pCmd->SetGraphicsRootDescriptorTable(10, mat.GetTextureHandle(id, TU_NORMAL));
+    return m_SphereMapConverter.GetCubeMapDesc();
+}
 
-        // メッシュを描画.
-        m_pMesh[i]->Draw(pCmd);
+//-----------------------------------------------------------------------------
+//      フレームワークのクラスが生成したリソースのメモリ使用量を計上します.
+//-----------------------------------------------------------------------------
+void SampleApp::TrackMemory(uint64_t meshBytes)
+{
+    auto& tracker = GetMemoryTracker();
+
+    // リソースを取得できるものは実際のサイズを計上する.
+    struct TrackTarget
+    {
+        ID3D12Resource*     pResource;
+        MEMORY_CATEGORY     Category;
+        const char*         Name;
+    };
+
+    TrackTarget targets[] = {
+        { m_SceneColorTarget.GetResource(), MEMORY_CATEGORY_RENDER_TARGET,  "SceneColorTarget" },
+        { m_SceneDepthTarget.GetResource(), MEMORY_CATEGORY_RENDER_TARGET,  "SceneDepthTarget" },
+        { m_CookedCubeMap   .GetResource(), MEMORY_CATEGORY_IBL,            "CookedCubeMap" },
+        { m_SphereMap       .GetResource(), MEMORY_CATEGORY_IBL,            "SphereMap" },
+    };
+
+    for (auto& target : targets)
+    {
+        if (target.pResource != nullptr)
+        { m_MemoryIds.push_back(TrackResource(target.pResource, target.Category, target.Name)); }
     }
+
+    // メッシュと深度プリパスのバッファはデータのサイズを計上する.
+    auto vbv = m_DepthPrepassVB.GetView();
+    auto ibv = m_DepthPrepassIB.GetView();
+    m_MemoryIds.push_back(tracker.Add(MEMORY_CATEGORY_MESH, MEMORY_DOMAIN_GPU, meshBytes, "Mesh"));
+    m_MemoryIds.push_back(tracker.Add(MEMORY_CATEGORY_MESH, MEMORY_DOMAIN_GPU, uint64_t(vbv.SizeInBytes) + ibv.SizeInBytes, "DepthPrepass"));
+
+    // 定数バッファは1つずつコミットリソースになるので, 64KB ずつとして見積もる.
+    auto constantBufferCount = uint64_t(FrameCount) * 4 + m_MeshCB.size();
+    m_MemoryIds.push_back(tracker.Add(
+        MEMORY_CATEGORY_CONSTANT_BUFFER,
+        MEMORY_DOMAIN_GPU,
+        constantBufferCount * D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT,
+        "ConstantBuffer"));
+
+    // CPU側のライトの配列.
+    m_MemoryIds.push_back(tracker.Add(MEMORY_CATEGORY_OTHER, MEMORY_DOMAIN_CPU, m_PointLights.capacity() * sizeof(ClusterLight), "PointLights"));
+}
+
+//-----------------------------------------------------------------------------
+//      環境キューブマップのGPUディスクリプタハンドルを取得します.
+//-----------------------------------------------------------------------------
+D3D12_GPU_DESCRIPTOR_HANDLE SampleApp::GetCubeMapHandleGPU() const
+{
+    if (m_UseCookedCubeMap)
+    { return m_CookedCubeMap.GetHandleGPU(); }
+
+    return m_SphereMapConverter.GetCubeMapHandleGPU();
 }
 
 //-----------------------------------------------------------------------------
@@ -953,6 +1874,20 @@ void SampleApp::DrawMesh(ID3D12GraphicsCommandList* pCmd, int material_index)
 //-----------------------------------------------------------------------------
 void SampleApp::DrawTonemap(ID3D12GraphicsCommandList* pCmd)
 {
+    // パイプラインが準備できていなければ描画しない.
+    auto pPSO = m_PipelineCompiler.Get(m_TonemapPSO);
+    if (pPSO == nullptr)
+    { return; }
+
+    // 現在のパラメータのLUTが転送済みならLUT版を使う.
+    if (m_UseTonemapLUT
+     && m_TonemapLUT.IsReady({ m_TonemapType, m_ColorSpace, m_BaseLuminance, m_MaxLuminance }))
+    {
+        auto pLutPSO = m_PipelineCompiler.Get(m_TonemapLUTPSO);
+        if (pLutPSO != nullptr)
+        { pPSO = pLutPSO; }
+    }
+
     // 定数バッファ更新
     {
         auto ptr = m_TonemapCB[m_FrameIndex].GetPtr<CbTonemap>();
@@ -960,13 +1895,21 @@ void SampleApp::DrawTonemap(ID3D12GraphicsCommandList* pCmd)
         ptr->ColorSpace     = m_ColorSpace;
         ptr->BaseLuminance  = m_BaseLuminance;
         ptr->MaxLuminance   = m_MaxLuminance;
+        ptr->LutShaper      = m_TonemapLUT.GetShaper();
+        ptr->BloomIntensity = m_Bloom.GetIntensity();
+        ptr->Sharpness      = m_DynamicResolution.GetSharpness();
+        ptr->UVScale        = Vector2(m_SceneViewport.Width / float(m_Width), m_SceneViewport.Height / float(m_Height));
+        ptr->InvSceneSize   = Vector2(1.0f / float(m_Width), 1.0f / float(m_Height));
     }
 
     pCmd->SetGraphicsRootSignature(m_TonemapRootSig.GetPtr());
     pCmd->SetGraphicsRootDescriptorTable(0, m_TonemapCB[m_FrameIndex].GetHandleGPU());
     pCmd->SetGraphicsRootDescriptorTable(1, m_SceneColorTarget.GetHandleSRV()->HandleGPU);
+    pCmd->SetGraphicsRootDescriptorTable(2, m_AutoExposure.GetHandleSRV());
+    pCmd->SetGraphicsRootDescriptorTable(3, m_TonemapLUT.GetHandleSRV());
+    pCmd->SetGraphicsRootDescriptorTable(4, m_Bloom.GetHandleSRV());
 
-    pCmd->SetPipelineState(m_pTonemapPSO.Get());
+    pCmd->SetPipelineState(pPSO);
     pCmd->RSSetViewports(1, &m_Viewport);
     pCmd->RSSetScissorRects(1, &m_Scissor);
 
@@ -984,24 +1927,14 @@ void SampleApp::ChangeDisplayMode(bool hdr)
     {
         if (!IsSupportHDR())
         {
-            MessageBox(
-                nullptr,
-                TEXT("HDRがサポートされていないディスプレイです."),
-                TEXT("HDR非サポート"),
-                MB_OK | MB_ICONINFORMATION);
-            ELOG("Error : Display not support HDR.");
+            ALOG("Error : Display not support HDR.");
             return;
         }
 
         auto hr = m_pSwapChain->SetColorSpace1(DXGI_COLOR_SPACE_RGB_FULL_G2084_NONE_P2020);
         if (FAILED(hr))
         {
-            MessageBox(
-                nullptr,
-                TEXT("ITU-R BT.2100 PQ Systemの色域設定に失敗しました"),
-                TEXT("色域設定失敗"),
-                MB_OK | MB_ICONERROR);
-            ELOG("Error : IDXGISwapChain::SetColorSpace1() Failed.");
+            ALOG("Error : IDXGISwapChain::SetColorSpace1() Failed. color space = ITU-R BT.2100 PQ");
             return;
         }
 
@@ -1027,39 +1960,22 @@ void SampleApp::ChangeDisplayMode(bool hdr)
         hr = m_pSwapChain->SetHDRMetaData(DXGI_HDR_METADATA_TYPE_HDR10, sizeof(DXGI_HDR_METADATA_HDR10), &metaData);
         if (FAILED(hr))
         {
-            ELOG("Error : IDXGISwapChain::SetHDRMetaData() Failed.");
+            ALOG("Error : IDXGISwapChain::SetHDRMetaData() Failed.");
         }
 
         m_BaseLuminance = 100.0f;
         m_MaxLuminance  = GetMaxLuminance();
 
-        // 成功したことを知らせるダイアログを出す.
-        std::string message;
-        message += "HDRディスプレイ用に設定を変更しました\n\n";
-        message += "色空間：ITU-R BT.2100 PQ\n";
-        message += "最大輝度値：";
-        message += std::to_string(GetMaxLuminance());
-        message += " [nit]\n";
-        message += "最小輝度値：";
-        message += std::to_string(GetMinLuminance());
-        message += " [nit]\n";
-
-        MessageBoxA(nullptr,
-            message.c_str(),
-            "HDR設定成功",
-            MB_OK | MB_ICONINFORMATION);
+        // 描画スレッドから呼ばれるため, ダイアログは出さずにログで知らせる.
+        ALOG("Info : Display mode changed to HDR. color space = ITU-R BT.2100 PQ, max luminance = %f [nit], min luminance = %f [nit]",
+            GetMaxLuminance(), GetMinLuminance());
     }
     else
     {
         auto hr = m_pSwapChain->SetColorSpace1(DXGI_COLOR_SPACE_RGB_FULL_G22_NONE_P709);
         if (FAILED(hr))
         {
-            MessageBox(
-                nullptr,
-                TEXT("ITU-R BT.709の色域設定に失敗しました"),
-                TEXT("色域設定失敗"),
-                MB_OK | MB_ICONERROR);
-            ELOG("Error : IDXGISwapChain::SetColorSpace1() Failed.");
+            ALOG("Error : IDXGISwapChain::SetColorSpace1() Failed. color space = ITU-R BT.709");
             return;
         }
 
@@ -1085,26 +2001,15 @@ void SampleApp::ChangeDisplayMode(bool hdr)
         hr = m_pSwapChain->SetHDRMetaData(DXGI_HDR_METADATA_TYPE_HDR10, sizeof(DXGI_HDR_METADATA_HDR10), &metaData);
         if (FAILED(hr))
         {
-            ELOG("Error : IDXGISwapChain::SetHDRMetaData() Failed.");
+            ALOG("Error : IDXGISwapChain::SetHDRMetaData() Failed.");
         }
 
         m_BaseLuminance = 100.0f;
         m_MaxLuminance  = 100.0f;
 
-        // 成功したことを知らせるダイアログを出す.
-        std::string message;
-        message += "SDRディスプレイ用に設定を変更しました\n\n";
-        message += "色空間：ITU-R BT.709\n";
-        message += "最大輝度値：";
-        message += std::to_string(GetMaxLuminance());
-        message += " [nit]\n";
-        message += "最小輝度値：";
-        message += std::to_string(GetMinLuminance());
-        message += " [nit]\n";
-        MessageBoxA(nullptr,
-            message.c_str(),
-            "SDR設定成功",
-            MB_OK | MB_ICONINFORMATION);
+        // 描画スレッドから呼ばれるため, ダイアログは出さずにログで知らせる.
+        ALOG("Info : Display mode changed to SDR. color space = ITU-R BT.709, max luminance = %f [nit], min luminance = %f [nit]",
+            GetMaxLuminance(), GetMinLuminance());
     }
 }
 
@@ -1127,54 +2032,18 @@ void SampleApp::OnMsgProc(HWND hWnd, UINT msg, WPARAM wp, LPARAM lp)
 
         if (isKeyDown)
         {
-            switch (keyCode)
+            // 終了はメッセージを処理するスレッドに通知する必要があるので, ここで処理する.
+            // 描画スレッドを止めてからウィンドウを破棄するよう, 閉じるボタンと同じ経路を通す.
+            if (keyCode == VK_ESCAPE)
             {
-            case VK_ESCAPE:
-                {
-                    PostQuitMessage(0);
-                }
-                break;
-
-            // HDRモード.
-            case 'H':
-                {
-                    ChangeDisplayMode(true);
-                }
-                break;
-
-            // SDRモード.
-            case 'S':
-                {
-                    ChangeDisplayMode(false);
-                }
-                break;
-
-            // トーンマップなし.
-            case 'N':
-                {
-                    m_TonemapType = TONEMAP_NONE;
-                }
-                break;
-
-            // Reinhardトーンマップ.
-            case 'R':
-                {
-                    m_TonemapType = TONEMAP_REINHARD;
-                }
-                break;
-
-            // GTトーンマップ
-            case 'G':
-                {
-                    m_TonemapType = TONEMAP_GT;
-                }
-                break;
-
-            case 'C':
-                {
-                    m_Camera.Reset();
-                }
-                break;
+                PostMessage(hWnd, WM_CLOSE, 0, 0);
+            }
+            else
+            {
+                InputRecord record = {};
+                record.Type    = INPUT_RECORD_KEY;
+                record.KeyCode = keyCode;
+                PushInput(record);
             }
         }
     }
@@ -1228,13 +2097,11 @@ void SampleApp::OnMsgProc(HWND hWnd, UINT msg, WPARAM wp, LPARAM lp)
             args.Type = Camera::EventRotate;
             args.RotateH = DirectX::XMConvertToRadians(-0.5f * (x - m_PrevCursorX));
             args.RotateV = DirectX::XMConvertToRadians(0.5f * (y - m_PrevCursorY));
-            m_Camera.UpdateByEvent(args);
         }
         else if (right)
         {
             args.Type = Camera::EventDolly;
             args.Dolly = DirectX::XMConvertToRadians(0.5f * (y - m_PrevCursorY));
-            m_Camera.UpdateByEvent(args);
         }
         else if (middle)
         {
@@ -1249,10 +2116,257 @@ void SampleApp::OnMsgProc(HWND hWnd, UINT msg, WPARAM wp, LPARAM lp)
                 args.MoveX = DirectX::XMConvertToRadians(0.5f * (x - m_PrevCursorX));
                 args.MoveY = DirectX::XMConvertToRadians(0.5f * (y - m_PrevCursorY));
             }
-            m_Camera.UpdateByEvent(args);
+        }
+
+        // カメラは描画側で動かす.
+        if (left || right || middle)
+        {
+            InputRecord record = {};
+            record.Type        = INPUT_RECORD_CAMERA;
+            record.CameraEvent = args;
+            PushInput(record);
         }
 
         m_PrevCursorX = x;
         m_PrevCursorY = y;
     }
 }
+
+//-----------------------------------------------------------------------------
+//      入力を描画側に渡します.
+//-----------------------------------------------------------------------------
+void SampleApp::PushInput(const InputRecord& record)
+{
+    // 描画が止まっている間の入力は捨てる(メッセージ処理を待たせない).
+    if (!m_InputQueue.TryPush(record))
+    { m_DroppedInputCount.fetch_add(1, std::memory_order_relaxed); }
+}
+
+//-----------------------------------------------------------------------------
+//      メッセージ処理から届いた入力を適用します.
+//-----------------------------------------------------------------------------
+void SampleApp::ProcessInput()
+{
+    InputRecord record;
+    while (m_InputQueue.TryPop(record))
+    {
+        switch (record.Type)
+        {
+        case INPUT_RECORD_CAMERA:
+            {
+                m_Camera.UpdateByEvent(record.CameraEvent);
+            }
+            break;
+
+        case INPUT_RECORD_KEY:
+            {
+                OnKey(record.KeyCode);
+            }
+            break;
+        }
+    }
+}
+
+//-----------------------------------------------------------------------------
+//      キーの押下を処理します.
+//-----------------------------------------------------------------------------
+void SampleApp::OnKey(uint32_t keyCode)
+{
+    switch (keyCode)
+    {
+    // HDRモード.
+    case 'H':
+        {
+            ChangeDisplayMode(true);
+        }
+        break;
+
+    // SDRモード.
+    case 'S':
+        {
+            ChangeDisplayMode(false);
+        }
+        break;
+
+    // トーンマップなし.
+    case 'N':
+        {
+            m_TonemapType = TONEMAP_NONE;
+        }
+        break;
+
+    // Reinhardトーンマップ.
+    case 'R':
+        {
+            m_TonemapType = TONEMAP_REINHARD;
+        }
+        break;
+
+    // GTトーンマップ
+    case 'G':
+        {
+            m_TonemapType = TONEMAP_GT;
+        }
+        break;
+
+    case 'C':
+        {
+            m_Camera.Reset();
+        }
+        break;
+
+    // ブルームの切り替え.
+    case 'B':
+        {
+            auto& settings = m_Bloom.GetSettings();
+            settings.Enable = !settings.Enable;
+            m_GpuTimer.ResetStats();
+        }
+        break;
+
+    // ブルームの品質を切り替え.
+    case 'Q':
+        {
+            auto& settings = m_Bloom.GetSettings();
+            settings.Quality = BLOOM_QUALITY((settings.Quality + 1) % BLOOM_QUALITY_COUNT);
+            m_GpuTimer.ResetStats();
+        }
+        break;
+
+    // パスごとのGPU時間を出力.
+    case 'T':
+        {
+            printf("%s", m_GpuTimer.FormatReport().c_str());
+            printf("%s", m_Profiler.FormatReport().c_str());
+            printf("Dynamic Resolution : %s, scale %.2f, %.2f ms / %.2f ms, %u changes\n",
+                m_DynamicResolution.GetSettings().Enable ? "on" : "off",
+                m_DynamicResolution.GetScale(),
+                m_DynamicResolution.GetFilteredMs(),
+                m_DynamicResolution.GetSettings().TargetMs,
+                m_DynamicResolution.GetChangeCount());
+            if (m_LightCluster.IsUsingCPU())
+            {
+                auto& cpu = m_LightCluster.GetCPU();
+                printf("Light Culling (CPU) : %u lights, %.3f ms, %u indices, %u dropped\n",
+                    m_PointLightCount,
+                    m_LightCluster.GetCPUTimeMs(),
+                    cpu.GetIndexCount(),
+                    cpu.GetDroppedCount());
+            }
+            printf("Input Queue : %u dropped\n", m_DroppedInputCount.load(std::memory_order_relaxed));
+        }
+        break;
+
+    // ライト数の切り替え(0, 1k, 4k, 16k, 64k).
+    case 'P':
+        {
+            m_PointLightCount = (m_PointLightCount == 0) ? 1024 : m_PointLightCount * 4;
+            if (m_PointLightCount > MaxPointLights)
+            { m_PointLightCount = 0; }
+            m_GpuTimer.ResetStats();
+            printf("Point Lights : %u\n", m_PointLightCount);
+        }
+        break;
+
+    // ライトの割り当てを CPU / GPU で切り替え.
+    case 'K':
+        {
+            m_LightCluster.SetUseCPU(!m_LightCluster.IsUsingCPU());
+            m_GpuTimer.ResetStats();
+            printf("Light Culling : %s\n", m_LightCluster.IsUsingCPU() ? "CPU" : "GPU");
+        }
+        break;
+
+    // 深度プリパスの切り替え.
+    case 'D':
+        {
+            m_UseDepthPrepass = !m_UseDepthPrepass;
+            m_GpuTimer.ResetStats();
+            printf("Depth Pre-Pass : %s\n", m_UseDepthPrepass ? "ON" : "OFF");
+        }
+        break;
+
+    // 動的解像度の切り替え.
+    case 'V':
+        {
+            auto& settings = m_DynamicResolution.GetSettings();
+            settings.Enable = !settings.Enable;
+            m_DynamicResolution.Reset();
+            m_GpuTimer.ResetStats();
+        }
+        break;
+
+    // CPUとGPUのタイムラインを Chrome Trace 形式で記録.
+    case 'X':
+        {
+            if (!m_Profiler.IsCapturing())
+            {
+                m_GpuTimer.Calibrate();
+                m_Profiler.StartCapture(ProfileCaptureFrames);
+                printf("Profile capture started : %u frames\n", ProfileCaptureFrames);
+            }
+        }
+        break;
+
+    // フレームグラフのコンパイル結果を出力.
+    case 'F':
+        {
+            printf("%s", m_FrameGraph.FormatReport().c_str());
+        }
+        break;
+
+    // 配置リソース用ヒープの使用量と断片化を出力.
+    case 'M':
+        {
+            printf("%s", m_HeapAllocator.FormatReport().c_str());
+
+            uint64_t budget = 0;
+            uint64_t usage  = 0;
+            QueryVideoMemory(m_pDevice.Get(), budget, usage);
+            GetMemoryTracker().CheckBudgets(budget, usage);
+            printf("%s", GetMemoryTracker().FormatReport().c_str());
+        }
+        break;
+
+    // LUTトーンマップの切り替え.
+    case 'L':
+        {
+            m_UseTonemapLUT = !m_UseTonemapLUT;
+        }
+        break;
+
+    // 自動露出の切り替え.
+    case 'A':
+        {
+            auto& settings = m_AutoExposure.GetSettings();
+            settings.Enable = !settings.Enable;
+            m_AutoExposure.Reset();
+        }
+        break;
+
+    // 露光補正を上げる.
+    case VK_OEM_PLUS:
+    case VK_ADD:
+        {
+            if (m_Exposure < 8.0f)
+            { m_Exposure += 0.5f; }
+        }
+        break;
+
+    // 露光補正を下げる.
+    case VK_OEM_MINUS:
+    case VK_SUBTRACT:
+        {
+            if (m_Exposure > -8.0f)
+            { m_Exposure -= 0.5f; }
+        }
+        break;
+
+    // IBLを再ベイク.
+    case 'I':
+        {
+            m_IBLBaker.Request(GetCubeMapHandleGPU());
+        }
+        break;
+    }
+}
@@ -0,0 +1,419 @@
+﻿//-----------------------------------------------------------------------------
+// File : ShaderBundle.cpp
+// Desc : Shader Bytecode Bundle.
+// Copyright(c) Pocol. All right reserved.
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------
+#include "ShaderBundle.h"
+#include "Hash.h"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+
+#if defined(_WIN32)
+    #ifndef NOMINMAX
+    #define NOMINMAX
+    #endif
+    #include <Windows.h>
+#else
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+
+///////////////////////////////////////////////////////////////////////////////
+// ShaderBundle::Entry structure
+///////////////////////////////////////////////////////////////////////////////
+struct ShaderBundle::Entry
+{
+    uint64_t    NameHash;       //!< 名前のハッシュ値です.
+    uint64_t    ContentHash;    //!< バイトコードのハッシュ値です.
+    uint64_t    Offset;         //!< ファイル先頭からのバイトコードの位置です.
+    uint64_t    Size;           //!< バイトコードのサイズです.
+    uint32_t    NameOffset;     //!< 名前テーブル内の位置です.
+    uint32_t    NameLength;     //!< 名前の長さです.
+};
+
+
+namespace {
+
+///////////////////////////////////////////////////////////////////////////////
+// FileHeader structure
+///////////////////////////////////////////////////////////////////////////////
+struct FileHeader
+{
+    uint32_t    Magic;          //!< マジックです.
+    uint32_t    Version;        //!< ファイルバージョンです.
+    uint32_t    EntryCount;     //!< エントリ数です.
+    uint32_t    NameTableSize;  //!< 名前テーブルのサイズです.
+};
+
+//-----------------------------------------------------------------------------
+// Constant Values.
+//-----------------------------------------------------------------------------
+constexpr size_t DataAlignment = 16;    // バイトコードの配置境界.
+
+//-----------------------------------------------------------------------------
+//      名前のハッシュ値を計算します.
+//-----------------------------------------------------------------------------
+uint64_t HashName(const char* name, size_t length)
+{ return HashFNV1a64(name, length); }
+
+//-----------------------------------------------------------------------------
+//      境界に切り上げます.
+//-----------------------------------------------------------------------------
+size_t AlignUp(size_t value, size_t alignment)
+{ return (value + alignment - 1) & ~(alignment - 1); }
+
+} // namespace
+
+
+///////////////////////////////////////////////////////////////////////////////
+// ShaderBundle class
+///////////////////////////////////////////////////////////////////////////////
+
+//-----------------------------------------------------------------------------
+//      コンストラクタです.
+//-----------------------------------------------------------------------------
+ShaderBundle::ShaderBundle()
+: m_pData   (nullptr)
+, m_Size    (0)
+, m_pEntries(nullptr)
+, m_Count   (0)
+, m_pNames  (nullptr)
+, m_hFile   (nullptr)
+, m_hMapping(nullptr)
+{ /* DO_NOTHING */ }
+
+//-----------------------------------------------------------------------------
+//      デストラクタです.
+//-----------------------------------------------------------------------------
+ShaderBundle::~ShaderBundle()
+{ Close(); }
+
+//-----------------------------------------------------------------------------
+//      ファイルをメモリにマップして開きます.
+//-----------------------------------------------------------------------------
+bool ShaderBundle::Open(const std::filesystem::path& path)
+{
+    Close();
+
+#if defined(_WIN32)
+    auto hFile = CreateFileW(
+        path.c_str(),
+        GENERIC_READ,
+        FILE_SHARE_READ,
+        nullptr,
+        OPEN_EXISTING,
+        FILE_ATTRIBUTE_NORMAL,
+        nullptr);
+    if (hFile == INVALID_HANDLE_VALUE)
+    { return false; }
+
+    LARGE_INTEGER fileSize = {};
+    if (!GetFileSizeEx(hFile, &fileSize) || fileSize.QuadPart == 0)
+    {
+        CloseHandle(hFile);
+        return false;
+    }
+
+    auto hMapping = CreateFileMappingW(hFile, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (hMapping == nullptr)
+    {
+        CloseHandle(hFile);
+        return false;
+    }
+
+    auto ptr = MapViewOfFile(hMapping, FILE_MAP_READ, 0, 0, 0);
+    if (ptr == nullptr)
+    {
+        CloseHandle(hMapping);
+        CloseHandle(hFile);
+        return false;
+    }
+
+    m_hFile    = hFile;
+    m_hMapping = hMapping;
+    m_pData    = static_cast<const uint8_t*>(ptr);
+    m_Size     = size_t(fileSize.QuadPart);
+#else
+    auto fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+    { return false; }
+
+    struct stat info = {};
+    if (fstat(fd, &info) != 0 || info.st_size <= 0)
+    {
+        close(fd);
+        return false;
+    }
+
+    auto ptr = mmap(nullptr, size_t(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+
+    // マップ後はファイル記述子は不要.
+    close(fd);
+
+    if (ptr == MAP_FAILED)
+    { return false; }
+
+    m_pData = static_cast<const uint8_t*>(ptr);
+    m_Size  = size_t(info.st_size);
+#endif
+
+    if (!Validate())
+    {
+        Close();
+        return false;
+    }
+
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+//      ファイルを閉じます.
+//-----------------------------------------------------------------------------
+void ShaderBundle::Close()
+{
+#if defined(_WIN32)
+    if (m_pData != nullptr)
+    { UnmapViewOfFile(m_pData); }
+
+    if (m_hMapping != nullptr)
+    { CloseHandle(m_hMapping); }
+
+    if (m_hFile != nullptr)
+    { CloseHandle(m_hFile); }
+#else
+    if (m_pData != nullptr)
+    { munmap(const_cast<uint8_t*>(m_pData), m_Size); }
+#endif
+
+    m_pData    = nullptr;
+    m_Size     = 0;
+    m_pEntries = nullptr;
+    m_Count    = 0;
+    m_pNames   = nullptr;
+    m_hFile    = nullptr;
+    m_hMapping = nullptr;
+}
+
+//-----------------------------------------------------------------------------
+//      バイトコードを検索します.
+//-----------------------------------------------------------------------------
+bool ShaderBundle::Find(const char* name, Blob& result) const
+{
+    if (name == nullptr || m_pEntries == nullptr)
+    { return false; }
+
+    auto length = strlen(name);
+    auto hash   = HashName(name, length);
+
+    auto begin = m_pEntries;
+    auto end   = m_pEntries + m_Count;
+    auto itr   = std::lower_bound(begin, end, hash,
+        [](const Entry& entry, uint64_t value) { return entry.NameHash < value; });
+
+    for (; itr != end && itr->NameHash == hash; ++itr)
+    {
+        if (itr->NameLength != length || memcmp(m_pNames + itr->NameOffset, name, length) != 0)
+        { continue; }
+
+        result.pData       = m_pData + itr->Offset;
+        result.Size        = size_t(itr->Size);
+        result.ContentHash = itr->ContentHash;
+        return true;
+    }
+
+    return false;
+}
+
+//-----------------------------------------------------------------------------
+//      全バイトコードの内容をハッシュ値で検証します.
+//-----------------------------------------------------------------------------
+bool ShaderBundle::Verify() const
+{
+    for (auto i = 0u; i < m_Count; ++i)
+    {
+        auto& entry = m_pEntries[i];
+        if (HashFNV1a64(m_pData + entry.Offset, size_t(entry.Size)) != entry.ContentHash)
+        { return false; }
+    }
+
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+//      開いているかどうかを取得します.
+//-----------------------------------------------------------------------------
+bool ShaderBundle::IsOpen() const
+{ return m_pData != nullptr; }
+
+//-----------------------------------------------------------------------------
+//      エントリ数を取得します.
+//-----------------------------------------------------------------------------
+uint32_t ShaderBundle::GetCount() const
+{ return m_Count; }
+
+//-----------------------------------------------------------------------------
+//      マップしたファイルのサイズを取得します.
+//-----------------------------------------------------------------------------
+size_t ShaderBundle::GetSize() const
+{ return m_Size; }
+
+//-----------------------------------------------------------------------------
+//      ヘッダとインデックスを検証します.
+//-----------------------------------------------------------------------------
+bool ShaderBundle::Validate()
+{
+    if (m_Size < sizeof(FileHeader))
+    { return false; }
+
+    FileHeader header;
+    memcpy(&header, m_pData, sizeof(header));
+
+    if (header.Magic != Magic || header.Version != Version)
+    { return false; }
+
+    auto indexSize = uint64_t(header.EntryCount) * sizeof(Entry);
+    auto dataBegin = uint64_t(sizeof(FileHeader)) + indexSize + header.NameTableSize;
+    if (dataBegin > m_Size)
+    { return false; }
+
+    auto pEntries = reinterpret_cast<const Entry*>(m_pData + sizeof(FileHeader));
+    for (auto i = 0u; i < header.EntryCount; ++i)
+    {
+        auto& entry = pEntries[i];
+
+        if (uint64_t(entry.NameOffset) + entry.NameLength > header.NameTableSize)
+        { return false; }
+
+        if (entry.Offset < dataBegin || entry.Size > m_Size - entry.Offset)
+        { return false; }
+
+        // 二分探索のため並び順も確認する.
+        if (i > 0 && pEntries[i - 1].NameHash > entry.NameHash)
+        { return false; }
+    }
+
+    m_pEntries = pEntries;
+    m_Count    = header.EntryCount;
+    m_pNames   = reinterpret_cast<const char*>(m_pData + sizeof(FileHeader) + indexSize);
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+//      バンドルをファイルに書き出します.
+//-----------------------------------------------------------------------------
+bool ShaderBundle::Write(const std::filesystem::path& path, const std::vector<Source>& sources)
+{
+    // 出力を決定的にするため名前のハッシュ値順に並べる.
+    std::vector<const Source*> sorted;
+    sorted.reserve(sources.size());
+    for (auto& source : sources)
+    { sorted.push_back(&source); }
+
+    std::sort(sorted.begin(), sorted.end(), [](const Source* lhs, const Source* rhs)
+    {
+        auto lhsHash = HashName(lhs->Name.data(), lhs->Name.size());
+        auto rhsHash = HashName(rhs->Name.data(), rhs->Name.size());
+        return (lhsHash != rhsHash) ? (lhsHash < rhsHash) : (lhs->Name < rhs->Name);
+    });
+
+    for (size_t i = 1; i < sorted.size(); ++i)
+    {
+        if (sorted[i - 1]->Name == sorted[i]->Name)
+        { return false; }
+    }
+
+    // 名前テーブルを構築.
+    std::string names;
+    for (auto source : sorted)
+    { names += source->Name; }
+
+    if (names.size() > UINT32_MAX)
+    { return false; }
+
+    FileHeader header = {};
+    header.Magic         = Magic;
+    header.Version       = Version;
+    header.EntryCount    = uint32_t(sorted.size());
+    header.NameTableSize = uint32_t(names.size());
+
+    // レイアウトを決定.
+    std::vector<Entry> entries(sorted.size());
+    size_t nameOffset = 0;
+    size_t offset     = sizeof(FileHeader) + sizeof(Entry) * entries.size() + names.size();
+    for (size_t i = 0; i < sorted.size(); ++i)
+    {
+        auto& source = *sorted[i];
+
+        offset = AlignUp(offset, DataAlignment);
+
+        entries[i].NameHash    = HashName(source.Name.data(), source.Name.size());
+        entries[i].ContentHash = HashFNV1a64(source.Data.data(), source.Data.size());
+        entries[i].Offset      = offset;
+        entries[i].Size        = source.Data.size();
+        entries[i].NameOffset  = uint32_t(nameOffset);
+        entries[i].NameLength  = uint32_t(source.Name.size());
+
+        nameOffset += source.Name.size();
+        offset     += source.Data.size();
+    }
+
+    // メモリ上に組み立てる.
+    std::vector<uint8_t> image(offset, 0);
+    memcpy(image.data(), &header, sizeof(header));
+    if (!entries.empty())
+    { memcpy(image.data() + sizeof(header), entries.data(), sizeof(Entry) * entries.size()); }
+    if (!names.empty())
+    { memcpy(image.data() + sizeof(header) + sizeof(Entry) * entries.size(), names.data(), names.size()); }
+    for (size_t i = 0; i < sorted.size(); ++i)
+    {
+        auto& data = sorted[i]->Data;
+        if (!data.empty())
+        { memcpy(image.data() + entries[i].Offset, data.data(), data.size()); }
+    }
+
+    // 内容が同じなら書き換えない(タイムスタンプを保ち不要な再ビルドを避ける).
+    {
+        std::ifstream stream(path, std::ios::binary);
+        if (stream.is_open())
+        {
+            std::vector<uint8_t> current(
+                (std::istreambuf_iterator<char>(stream)),
+                std::istreambuf_iterator<char>());
+            if (current == image)
+            { return true; }
+        }
+    }
+
+    // 書き込み途中で落ちても既存のファイルを壊さないよう一時ファイルに書き出す.
+    auto tempPath = path;
+    tempPath += ".tmp";
+
+    {
+        std::ofstream stream(tempPath, std::ios::binary | std::ios::trunc);
+        if (!stream.is_open())
+        { return false; }
+
+        stream.write(reinterpret_cast<const char*>(image.data()), std::streamsize(image.size()));
+        if (!stream)
+        { return false; }
+    }
+
+    std::error_code ec;
+    std::filesystem::rename(tempPath, path, ec);
+    if (ec)
+    {
+        std::filesystem::remove(tempPath, ec);
+        return false;
+    }
+
+    return true;
+}
@@ -0,0 +1,462 @@
+﻿//-----------------------------------------------------------------------------
+// File : TaskGraph.cpp
+// Desc : Dependency-Aware Task Graph.
+// Copyright(c) Pocol. All right reserved.
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------
+#include "TaskGraph.h"
+#include <algorithm>
+#include <cassert>
+#include <cstdio>
+#include <thread>
+
+
+namespace {
+
+//-----------------------------------------------------------------------------
+//      経過時間[ms]を求めます.
+//-----------------------------------------------------------------------------
+double ElapsedMs(std::chrono::steady_clock::time_point origin)
+{
+    auto now = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::milli>(now - origin).count();
+}
+
+//-----------------------------------------------------------------------------
+//      実行結果の文字列を取得します.
+//-----------------------------------------------------------------------------
+const char* ToString(TASK_STATUS status)
+{
+    switch (status)
+    {
+    case TASK_STATUS_SUCCEEDED: return "ok";
+    case TASK_STATUS_FAILED:    return "FAILED";
+    case TASK_STATUS_SKIPPED:   return "skipped";
+    default:                    return "pending";
+    }
+}
+
+} // namespace
+
+
+///////////////////////////////////////////////////////////////////////////////
+// TaskGraph class
+///////////////////////////////////////////////////////////////////////////////
+
+//-----------------------------------------------------------------------------
+//      コンストラクタです.
+//-----------------------------------------------------------------------------
+TaskGraph::TaskGraph()
+: m_Completed(0)
+, m_Ready    (0)
+, m_ElapsedMs(0.0)
+{ /* DO_NOTHING */ }
+
+//-----------------------------------------------------------------------------
+//      デストラクタです.
+//-----------------------------------------------------------------------------
+TaskGraph::~TaskGraph()
+{ Clear(); }
+
+//-----------------------------------------------------------------------------
+//      タスクを追加します.
+//-----------------------------------------------------------------------------
+TaskId TaskGraph::Add
+(
+    const char*                     name,
+    std::function<bool()>           func,
+    std::initializer_list<TaskId>   dependencies
+)
+{
+    auto id   = TaskId(m_Tasks.size());
+    auto task = std::make_unique<Task>();
+
+    task->Info.Name        = (name != nullptr) ? name : "";
+    task->Info.Status      = TASK_STATUS_PENDING;
+    task->Info.ThreadIndex = 0;
+    task->Info.StartMs     = 0.0;
+    task->Info.EndMs       = 0.0;
+    task->Func             = std::move(func);
+    task->Remaining        = 0;
+    task->Cancelled        = false;
+
+    m_Tasks.push_back(std::move(task));
+
+    for (auto dependency : dependencies)
+    { AddDependency(id, dependency); }
+
+    return id;
+}
+
+//-----------------------------------------------------------------------------
+//      依存関係を追加します.
+//-----------------------------------------------------------------------------
+void TaskGraph::AddDependency(TaskId task, TaskId dependency)
+{
+    assert(task < m_Tasks.size() && dependency < m_Tasks.size());
+    if (task >= m_Tasks.size() || dependency >= m_Tasks.size() || task == dependency)
+    { return; }
+
+    auto& deps = m_Tasks[task]->Dependencies;
+    if (std::find(deps.begin(), deps.end(), dependency) != deps.end())
+    { return; }
+
+    deps.push_back(dependency);
+    m_Tasks[dependency]->Dependents.push_back(task);
+}
+
+//-----------------------------------------------------------------------------
+//      全てのタスクを実行します.
+//-----------------------------------------------------------------------------
+bool TaskGraph::Run(uint32_t threadCount)
+{
+    if (m_Tasks.empty())
+    { return true; }
+
+    if (!IsAcyclic())
+    { return false; }
+
+    if (threadCount == 0)
+    { threadCount = std::max(std::thread::hardware_concurrency(), 1u); }
+    threadCount = std::min(threadCount, uint32_t(m_Tasks.size()));
+
+    // 状態をリセット.
+    for (auto& task : m_Tasks)
+    {
+        task->Info.Status      = TASK_STATUS_PENDING;
+        task->Info.ThreadIndex = 0;
+        task->Info.StartMs     = 0.0;
+        task->Info.EndMs       = 0.0;
+        task->Remaining        = uint32_t(task->Dependencies.size());
+        task->Cancelled        = false;
+    }
+    m_Completed = 0;
+    m_Ready     = 0;
+
+    m_Workers.clear();
+    for (auto i = 0u; i < threadCount; ++i)
+    { m_Workers.push_back(std::make_unique<Worker>()); }
+
+    auto origin = std::chrono::steady_clock::now();
+
+    // 依存の無いタスクを各ワーカーに振り分ける.
+    auto worker = 0u;
+    for (auto i = 0u; i < m_Tasks.size(); ++i)
+    {
+        if (m_Tasks[i]->Dependencies.empty())
+        {
+            Push(worker, TaskId(i));
+            worker = (worker + 1) % threadCount;
+        }
+    }
+
+    std::vector<std::thread> threads;
+    for (auto i = 1u; i < threadCount; ++i)
+    { threads.emplace_back(&TaskGraph::WorkerLoop, this, i, origin); }
+
+    // 呼び出し元のスレッドも処理に参加する.
+    WorkerLoop(0, origin);
+
+    for (auto& thread : threads)
+    { thread.join(); }
+
+    m_ElapsedMs = ElapsedMs(origin);
+    m_Workers.clear();
+
+    for (auto& task : m_Tasks)
+    {
+        if (task->Info.Status != TASK_STATUS_SUCCEEDED)
+        { return false; }
+    }
+
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+//      タスクをすべて削除します.
+//-----------------------------------------------------------------------------
+void TaskGraph::Clear()
+{
+    m_Tasks.clear();
+    m_Workers.clear();
+    m_ElapsedMs = 0.0;
+}
+
+//-----------------------------------------------------------------------------
+//      タスク数を取得します.
+//-----------------------------------------------------------------------------
+size_t TaskGraph::GetCount() const
+{ return m_Tasks.size(); }
+
+//-----------------------------------------------------------------------------
+//      タスクの実行結果を取得します.
+//-----------------------------------------------------------------------------
+const TaskGraph::TaskInfo& TaskGraph::GetInfo(TaskId id) const
+{ return m_Tasks[id]->Info; }
+
+//-----------------------------------------------------------------------------
+//      直前の Run() の所要時間[ms]を取得します.
+//-----------------------------------------------------------------------------
+double TaskGraph::GetElapsedMs() const
+{ return m_ElapsedMs; }
+
+//-----------------------------------------------------------------------------
+//      全タスクの処理時間の合計[ms]を取得します.
+//-----------------------------------------------------------------------------
+double TaskGraph::GetSerialMs() const
+{
+    auto result = 0.0;
+    for (auto& task : m_Tasks)
+    { result += task->Info.EndMs - task->Info.StartMs; }
+
+    return result;
+}
+
+//-----------------------------------------------------------------------------
+//      クリティカルパスを取得します.
+//-----------------------------------------------------------------------------
+double TaskGraph::GetCriticalPath(std::vector<TaskId>& path) const
+{
+    path.clear();
+    if (m_Tasks.empty())
+    { return 0.0; }
+
+    // トポロジカル順に最長経路を求める.
+    auto count = m_Tasks.size();
+    std::vector<uint32_t> remaining(count);
+    std::vector<TaskId>   order;
+    order.reserve(count);
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        remaining[i] = uint32_t(m_Tasks[i]->Dependencies.size());
+        if (remaining[i] == 0)
+        { order.push_back(TaskId(i)); }
+    }
+
+    for (size_t i = 0; i < order.size(); ++i)
+    {
+        for (auto dependent : m_Tasks[order[i]]->Dependents)
+        {
+            if (--remaining[dependent] == 0)
+            { order.push_back(dependent); }
+        }
+    }
+
+    std::vector<double> finish(count, 0.0);
+    std::vector<TaskId> prev  (count, TaskId(-1));
+    for (auto id : order)
+    {
+        auto& task = *m_Tasks[id];
+
+        auto start = 0.0;
+        for (auto dependency : task.Dependencies)
+        {
+            if (finish[dependency] > start)
+            {
+                start    = finish[dependency];
+                prev[id] = dependency;
+            }
+        }
+
+        finish[id] = start + (task.Info.EndMs - task.Info.StartMs);
+    }
+
+    auto last = TaskId(std::max_element(finish.begin(), finish.end()) - finish.begin());
+    for (auto id = last; id != TaskId(-1); id = prev[id])
+    { path.push_back(id); }
+    std::reverse(path.begin(), path.end());
+
+    return finish[last];
+}
+
+//-----------------------------------------------------------------------------
+//      実行結果のレポートを作成します.
+//-----------------------------------------------------------------------------
+std::string TaskGraph::FormatReport() const
+{
+    std::string result;
+    char line[256];
+
+    std::vector<TaskId> path;
+    auto criticalMs = GetCriticalPath(path);
+    auto serialMs   = GetSerialMs();
+
+    snprintf(line, sizeof(line),
+        "TaskGraph : %zu tasks, elapsed %.2f ms, serial %.2f ms, critical path %.2f ms\n",
+        m_Tasks.size(), m_ElapsedMs, serialMs, criticalMs);
+    result += line;
+
+    result += "Critical Path :\n";
+    for (auto id : path)
+    {
+        auto& info = m_Tasks[id]->Info;
+        snprintf(line, sizeof(line), "    %-24s %8.2f ms\n", info.Name.c_str(), info.EndMs - info.StartMs);
+        result += line;
+    }
+
+    result += "Tasks :\n";
+    for (auto& task : m_Tasks)
+    {
+        auto& info = task->Info;
+        snprintf(line, sizeof(line), "    %-24s start %8.2f ms  duration %8.2f ms  thread %2u  %s\n",
+            info.Name.c_str(), info.StartMs, info.EndMs - info.StartMs, info.ThreadIndex, ToString(info.Status));
+        result += line;
+    }
+
+    return result;
+}
+
+//-----------------------------------------------------------------------------
+//      依存関係が循環していないか調べます.
+//-----------------------------------------------------------------------------
+bool TaskGraph::IsAcyclic() const
+{
+    std::vector<uint32_t> remaining(m_Tasks.size());
+    std::vector<TaskId>   ready;
+
+    for (size_t i = 0; i < m_Tasks.size(); ++i)
+    {
+        remaining[i] = uint32_t(m_Tasks[i]->Dependencies.size());
+        if (remaining[i] == 0)
+        { ready.push_back(TaskId(i)); }
+    }
+
+    size_t visited = 0;
+    while (!ready.empty())
+    {
+        auto id = ready.back();
+        ready.pop_back();
+        visited++;
+
+        for (auto dependent : m_Tasks[id]->Dependents)
+        {
+            if (--remaining[dependent] == 0)
+            { ready.push_back(dependent); }
+        }
+    }
+
+    return visited == m_Tasks.size();
+}
+
+//-----------------------------------------------------------------------------
+//      ワーカーの処理です.
+//-----------------------------------------------------------------------------
+void TaskGraph::WorkerLoop(uint32_t index, std::chrono::steady_clock::time_point origin)
+{
+    auto total = uint32_t(m_Tasks.size());
+
+    while (m_Completed < total)
+    {
+        TaskId id;
+        if (!Pop(index, id))
+        {
+            std::unique_lock<std::mutex> locker(m_WaitMutex);
+            m_WaitCondition.wait(locker, [&]() { return m_Ready > 0 || m_Completed >= total; });
+            continue;
+        }
+
+        auto& task = *m_Tasks[id];
+        task.Info.ThreadIndex = index;
+        task.Info.StartMs     = ElapsedMs(origin);
+
+        auto succeeded = false;
+        if (task.Cancelled)
+        {
+            task.Info.Status = TASK_STATUS_SKIPPED;
+        }
+        else
+        {
+            succeeded = task.Func ? task.Func() : true;
+            task.Info.Status = succeeded ? TASK_STATUS_SUCCEEDED : TASK_STATUS_FAILED;
+        }
+
+        task.Info.EndMs = ElapsedMs(origin);
+
+        Complete(index, id, succeeded);
+    }
+}
+
+//-----------------------------------------------------------------------------
+//      実行可能なタスクを取り出します.
+//-----------------------------------------------------------------------------
+bool TaskGraph::Pop(uint32_t index, TaskId& result)
+{
+    auto count = uint32_t(m_Workers.size());
+
+    // 自分のキューは後ろから(直前に解放した依存元を優先して局所性を保つ).
+    {
+        auto& worker = *m_Workers[index];
+        std::lock_guard<std::mutex> locker(worker.Mutex);
+        if (!worker.Queue.empty())
+        {
+            result = worker.Queue.back();
+            worker.Queue.pop_back();
+            m_Ready--;
+            return true;
+        }
+    }
+
+    // 他のワーカーのキューは前から盗む.
+    for (auto i = 1u; i < count; ++i)
+    {
+        auto& victim = *m_Workers[(index + i) % count];
+        std::lock_guard<std::mutex> locker(victim.Mutex);
+        if (!victim.Queue.empty())
+        {
+            result = victim.Queue.front();
+            victim.Queue.pop_front();
+            m_Ready--;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+//-----------------------------------------------------------------------------
+//      タスクをキューに積みます.
+//-----------------------------------------------------------------------------
+void TaskGraph::Push(uint32_t index, TaskId id)
+{
+    {
+        auto& worker = *m_Workers[index];
+        std::lock_guard<std::mutex> locker(worker.Mutex);
+        worker.Queue.push_back(id);
+    }
+
+    // 待機中のワーカーが通知を取りこぼさないようロック下で更新する.
+    {
+        std::lock_guard<std::mutex> locker(m_WaitMutex);
+        m_Ready++;
+    }
+    m_WaitCondition.notify_one();
+}
+
+//-----------------------------------------------------------------------------
+//      タスクの完了を依存元に通知します.
+//-----------------------------------------------------------------------------
+void TaskGraph::Complete(uint32_t index, TaskId id, bool succeeded)
+{
+    for (auto dependent : m_Tasks[id]->Dependents)
+    {
+        auto& task = *m_Tasks[dependent];
+        if (!succeeded)
+        { task.Cancelled = true; }
+
+        if (--task.Remaining == 0)
+        { Push(index, dependent); }
+    }
+
+    uint32_t completed;
+    {
+        std::lock_guard<std::mutex> locker(m_WaitMutex);
+        completed = ++m_Completed;
+    }
+
+    if (completed == m_Tasks.size())
+    { m_WaitCondition.notify_all(); }
+}
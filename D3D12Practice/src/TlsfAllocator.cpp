@@ -0,0 +1,628 @@
+﻿//-----------------------------------------------------------------------------
+// File : TlsfAllocator.cpp
+// Desc : Two-Level Segregated Fit Offset Allocator.
+// Copyright(c) Pocol. All right reserved.
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------
+#include "TlsfAllocator.h"
+#include <cassert>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+
+namespace {
+
+//-----------------------------------------------------------------------------
+//      最上位ビットの位置を求めます(value != 0).
+//-----------------------------------------------------------------------------
+inline uint32_t FindLastSet(uint64_t value)
+{
+#if defined(_MSC_VER)
+    unsigned long index = 0;
+    _BitScanReverse64(&index, value);
+    return uint32_t(index);
+#else
+    return uint32_t(63 - __builtin_clzll(value));
+#endif
+}
+
+//-----------------------------------------------------------------------------
+//      最下位ビットの位置を求めます(value != 0).
+//-----------------------------------------------------------------------------
+inline uint32_t FindFirstSet(uint64_t value)
+{
+#if defined(_MSC_VER)
+    unsigned long index = 0;
+    _BitScanForward64(&index, value);
+    return uint32_t(index);
+#else
+    return uint32_t(__builtin_ctzll(value));
+#endif
+}
+
+//-----------------------------------------------------------------------------
+//      2のべき乗かどうかチェックします.
+//-----------------------------------------------------------------------------
+inline bool IsPow2(uint64_t value)
+{ return value != 0 && (value & (value - 1)) == 0; }
+
+//-----------------------------------------------------------------------------
+//      アライメントを揃えます.
+//-----------------------------------------------------------------------------
+inline uint64_t AlignUp(uint64_t value, uint64_t alignment)
+{ return (value + alignment - 1) & ~(alignment - 1); }
+
+} // namespace
+
+
+///////////////////////////////////////////////////////////////////////////////
+// TlsfAllocator class
+///////////////////////////////////////////////////////////////////////////////
+
+//-----------------------------------------------------------------------------
+//      コンストラクタです.
+//-----------------------------------------------------------------------------
+TlsfAllocator::TlsfAllocator()
+: m_FLBitmap        (0)
+, m_Capacity        (0)
+, m_Granularity     (0)
+, m_GranularityShift(0)
+, m_UsedBytes       (0)
+, m_AllocationCount (0)
+, m_FreeBlockCount  (0)
+{
+    for (auto fl = 0u; fl < FLCount; ++fl)
+    {
+        m_SLBitmap[fl] = 0;
+        for (auto sl = 0u; sl < SLCount; ++sl)
+        { m_FreeHeads[fl][sl] = InvalidNode; }
+    }
+}
+
+//-----------------------------------------------------------------------------
+//      デストラクタです.
+//-----------------------------------------------------------------------------
+TlsfAllocator::~TlsfAllocator()
+{ Term(); }
+
+//-----------------------------------------------------------------------------
+//      初期化処理を行います.
+//-----------------------------------------------------------------------------
+bool TlsfAllocator::Init(uint64_t capacity, uint64_t granularity)
+{
+    if (!IsPow2(granularity) || capacity < granularity)
+    { return false; }
+
+    // 第1レベルの範囲に収まらない容量は扱わない.
+    auto units = capacity / granularity;
+    if (FindLastSet(units) + 1 >= FLCount + SLBits)
+    { return false; }
+
+    m_Capacity          = capacity - capacity % granularity;
+    m_Granularity       = granularity;
+    m_GranularityShift  = FindLastSet(granularity);
+
+    Reset();
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+//      終了処理を行います.
+//-----------------------------------------------------------------------------
+void TlsfAllocator::Term()
+{
+    m_Nodes.clear();
+    m_Nodes.shrink_to_fit();
+    m_UnusedNodes.clear();
+    m_UnusedNodes.shrink_to_fit();
+
+    m_FLBitmap = 0;
+    for (auto fl = 0u; fl < FLCount; ++fl)
+    {
+        m_SLBitmap[fl] = 0;
+        for (auto sl = 0u; sl < SLCount; ++sl)
+        { m_FreeHeads[fl][sl] = InvalidNode; }
+    }
+
+    m_Capacity          = 0;
+    m_Granularity       = 0;
+    m_GranularityShift  = 0;
+    m_UsedBytes         = 0;
+    m_AllocationCount   = 0;
+    m_FreeBlockCount    = 0;
+}
+
+//-----------------------------------------------------------------------------
+//      領域を確保します.
+//-----------------------------------------------------------------------------
+bool TlsfAllocator::Alloc(uint64_t size, uint64_t alignment, Allocation& result)
+{
+    result.Offset = 0;
+    result.Size   = 0;
+    result.Node   = InvalidNode;
+
+    if (m_Capacity == 0 || size > m_Capacity)
+    { return false; }
+
+    if (alignment < m_Granularity)
+    { alignment = m_Granularity; }
+
+    if (!IsPow2(alignment))
+    { return false; }
+
+    size = AlignUp((size == 0) ? 1 : size, m_Granularity);
+
+    // アライメントの詰め物を含めても必ず入るブロックを探す.
+    auto searchSize = size + (alignment - m_Granularity);
+
+    uint32_t fl = 0;
+    uint32_t sl = 0;
+    auto node = InvalidNode;
+    if (MappingSearch(searchSize, fl, sl))
+    { node = FindSuitable(fl, sl); }
+
+    // 切り上げで溢れた場合は, 1つ下のリストを線形に探す(容量いっぱいの確保など).
+    if (node == InvalidNode)
+    {
+        MappingInsert(searchSize, fl, sl);
+        for (auto i = m_FreeHeads[fl][sl]; i != InvalidNode; i = m_Nodes[i].NextFree)
+        {
+            auto& candidate = m_Nodes[i];
+            if (AlignUp(candidate.Offset, alignment) + size <= candidate.Offset + candidate.Size)
+            {
+                node = i;
+                break;
+            }
+        }
+    }
+
+    if (node == InvalidNode)
+    { return false; }
+
+    RemoveFree(node);
+
+    // 先頭の詰め物を空きブロックとして切り出す.
+    auto padding = AlignUp(m_Nodes[node].Offset, alignment) - m_Nodes[node].Offset;
+    if (padding > 0)
+    {
+        auto front = NewNode();
+        auto& f = m_Nodes[front];
+        auto& n = m_Nodes[node];
+
+        f.Offset    = n.Offset;
+        f.Size      = padding;
+        f.PrevPhys  = n.PrevPhys;
+        f.NextPhys  = node;
+        f.Free      = true;
+
+        if (n.PrevPhys != InvalidNode)
+        { m_Nodes[n.PrevPhys].NextPhys = front; }
+
+        n.Offset   += padding;
+        n.Size     -= padding;
+        n.PrevPhys  = front;
+
+        InsertFree(front);
+    }
+
+    // 後ろの余りを空きブロックとして切り出す.
+    if (m_Nodes[node].Size > size)
+    { SplitTail(node, size); }
+
+    auto& n = m_Nodes[node];
+    n.Free = false;
+
+    m_UsedBytes += n.Size;
+    m_AllocationCount++;
+
+    result.Offset = n.Offset;
+    result.Size   = n.Size;
+    result.Node   = node;
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+//      領域を解放します.
+//-----------------------------------------------------------------------------
+void TlsfAllocator::Free(const Allocation& allocation)
+{
+    auto node = allocation.Node;
+    if (node == InvalidNode || node >= m_Nodes.size())
+    { return; }
+
+    assert(!m_Nodes[node].Free);
+    assert(m_Nodes[node].Offset == allocation.Offset);
+
+    m_UsedBytes -= m_Nodes[node].Size;
+    m_AllocationCount--;
+    m_Nodes[node].Free = true;
+
+    // 前の空きブロックと結合.
+    auto prev = m_Nodes[node].PrevPhys;
+    if (prev != InvalidNode && m_Nodes[prev].Free)
+    {
+        RemoveFree(prev);
+
+        auto& p = m_Nodes[prev];
+        auto& n = m_Nodes[node];
+        p.Size     += n.Size;
+        p.NextPhys  = n.NextPhys;
+        if (n.NextPhys != InvalidNode)
+        { m_Nodes[n.NextPhys].PrevPhys = prev; }
+
+        DeleteNode(node);
+        node = prev;
+    }
+
+    // 次の空きブロックと結合.
+    auto next = m_Nodes[node].NextPhys;
+    if (next != InvalidNode && m_Nodes[next].Free)
+    {
+        RemoveFree(next);
+
+        auto& n  = m_Nodes[node];
+        auto& nx = m_Nodes[next];
+        n.Size     += nx.Size;
+        n.NextPhys  = nx.NextPhys;
+        if (nx.NextPhys != InvalidNode)
+        { m_Nodes[nx.NextPhys].PrevPhys = node; }
+
+        DeleteNode(next);
+    }
+
+    InsertFree(node);
+}
+
+//-----------------------------------------------------------------------------
+//      すべての領域を解放します.
+//-----------------------------------------------------------------------------
+void TlsfAllocator::Reset()
+{
+    m_Nodes.clear();
+    m_UnusedNodes.clear();
+
+    m_FLBitmap = 0;
+    for (auto fl = 0u; fl < FLCount; ++fl)
+    {
+        m_SLBitmap[fl] = 0;
+        for (auto sl = 0u; sl < SLCount; ++sl)
+        { m_FreeHeads[fl][sl] = InvalidNode; }
+    }
+
+    m_UsedBytes       = 0;
+    m_AllocationCount = 0;
+    m_FreeBlockCount  = 0;
+
+    if (m_Capacity == 0)
+    { return; }
+
+    // ノード0は常に先頭のブロックです(結合時は後ろのノードを消すので残り続ける).
+    auto node = NewNode();
+    auto& n = m_Nodes[node];
+    n.Offset    = 0;
+    n.Size      = m_Capacity;
+    n.PrevPhys  = InvalidNode;
+    n.NextPhys  = InvalidNode;
+    n.Free      = true;
+
+    InsertFree(node);
+}
+
+//-----------------------------------------------------------------------------
+//      統計を取得します.
+//-----------------------------------------------------------------------------
+TlsfStats TlsfAllocator::GetStats() const
+{
+    TlsfStats stats = {};
+    stats.Capacity          = m_Capacity;
+    stats.UsedBytes         = m_UsedBytes;
+    stats.FreeBytes         = m_Capacity - m_UsedBytes;
+    stats.AllocationCount   = m_AllocationCount;
+    stats.FreeBlockCount    = m_FreeBlockCount;
+
+    // 最大の空きブロックは最も上のリストにある.
+    if (m_FLBitmap != 0)
+    {
+        auto fl = FindLastSet(m_FLBitmap);
+        auto sl = FindLastSet(m_SLBitmap[fl]);
+        for (auto i = m_FreeHeads[fl][sl]; i != InvalidNode; i = m_Nodes[i].NextFree)
+        {
+            if (m_Nodes[i].Size > stats.LargestFreeBlock)
+            { stats.LargestFreeBlock = m_Nodes[i].Size; }
+        }
+    }
+
+    if (stats.FreeBytes > 0)
+    { stats.Fragmentation = 1.0f - float(double(stats.LargestFreeBlock) / double(stats.FreeBytes)); }
+
+    return stats;
+}
+
+//-----------------------------------------------------------------------------
+//      容量を取得します.
+//-----------------------------------------------------------------------------
+uint64_t TlsfAllocator::GetCapacity() const
+{ return m_Capacity; }
+
+//-----------------------------------------------------------------------------
+//      確保中のブロックが無いかどうかチェックします.
+//-----------------------------------------------------------------------------
+bool TlsfAllocator::IsEmpty() const
+{ return m_AllocationCount == 0; }
+
+//-----------------------------------------------------------------------------
+//      内部構造の整合性を検証します.
+//-----------------------------------------------------------------------------
+bool TlsfAllocator::Validate() const
+{
+    if (m_Capacity == 0)
+    { return m_Nodes.empty(); }
+
+    // アドレス順にたどって隙間と重なりが無いか調べる.
+    uint64_t offset     = 0;
+    uint64_t used       = 0;
+    uint32_t usedCount  = 0;
+    uint32_t freeCount  = 0;
+    auto     prev       = InvalidNode;
+    auto     prevFree   = false;
+
+    for (auto i = 0u; i != InvalidNode; i = m_Nodes[i].NextPhys)
+    {
+        if (i >= m_Nodes.size())
+        { return false; }
+
+        auto& n = m_Nodes[i];
+        if (n.Offset != offset || n.Size == 0 || n.PrevPhys != prev)
+        { return false; }
+
+        if (n.Offset % m_Granularity != 0 || n.Size % m_Granularity != 0)
+        { return false; }
+
+        if (n.Free)
+        {
+            // 空きブロック同士は隣り合わない.
+            if (prevFree)
+            { return false; }
+
+            // 正しい空きリストに入っている.
+            uint32_t fl = 0;
+            uint32_t sl = 0;
+            MappingInsert(n.Size, fl, sl);
+
+            auto found = false;
+            for (auto j = m_FreeHeads[fl][sl]; j != InvalidNode; j = m_Nodes[j].NextFree)
+            {
+                if (j == i)
+                {
+                    found = true;
+                    break;
+                }
+            }
+
+            if (!found)
+            { return false; }
+
+            freeCount++;
+        }
+        else
+        {
+            used += n.Size;
+            usedCount++;
+        }
+
+        offset  += n.Size;
+        prev     = i;
+        prevFree = n.Free;
+    }
+
+    if (offset != m_Capacity || used != m_UsedBytes)
+    { return false; }
+
+    if (usedCount != m_AllocationCount || freeCount != m_FreeBlockCount)
+    { return false; }
+
+    // ビットマップと空きリストが一致している.
+    uint32_t listed = 0;
+    for (auto fl = 0u; fl < FLCount; ++fl)
+    {
+        auto hasFL = (m_FLBitmap >> fl) & 1;
+        if (hasFL != (m_SLBitmap[fl] != 0 ? 1u : 0u))
+        { return false; }
+
+        for (auto sl = 0u; sl < SLCount; ++sl)
+        {
+            auto head = m_FreeHeads[fl][sl];
+            auto hasSL = (m_SLBitmap[fl] >> sl) & 1;
+            if (hasSL != (head != InvalidNode ? 1u : 0u))
+            { return false; }
+
+            auto prevNode = InvalidNode;
+            for (auto j = head; j != InvalidNode; j = m_Nodes[j].NextFree)
+            {
+                if (!m_Nodes[j].Free || m_Nodes[j].PrevFree != prevNode)
+                { return false; }
+
+                prevNode = j;
+                listed++;
+            }
+        }
+    }
+
+    return listed == m_FreeBlockCount;
+}
+
+//-----------------------------------------------------------------------------
+//      サイズが属する空きリストを求めます(切り捨て).
+//-----------------------------------------------------------------------------
+void TlsfAllocator::MappingInsert(uint64_t size, uint32_t& fl, uint32_t& sl) const
+{
+    auto units = size >> m_GranularityShift;
+    if (units < SLCount)
+    {
+        fl = 0;
+        sl = uint32_t(units);
+        return;
+    }
+
+    auto msb = FindLastSet(units);
+    fl = msb - SLBits + 1;
+    sl = uint32_t(units >> (msb - SLBits)) - SLCount;
+}
+
+//-----------------------------------------------------------------------------
+//      サイズ以上が必ず入る空きリストを求めます(切り上げ).
+//-----------------------------------------------------------------------------
+bool TlsfAllocator::MappingSearch(uint64_t size, uint32_t& fl, uint32_t& sl) const
+{
+    auto units = (size + m_Granularity - 1) >> m_GranularityShift;
+    if (units >= SLCount)
+    {
+        auto msb = FindLastSet(units);
+        units += (uint64_t(1) << (msb - SLBits)) - 1;
+    }
+
+    MappingInsert(units << m_GranularityShift, fl, sl);
+    return fl < FLCount;
+}
+
+//-----------------------------------------------------------------------------
+//      指定リスト以降で空きのあるリストを探します.
+//-----------------------------------------------------------------------------
+uint32_t TlsfAllocator::FindSuitable(uint32_t& fl, uint32_t& sl) const
+{
+    auto slMap = m_SLBitmap[fl] & (~0u << sl);
+    if (slMap == 0)
+    {
+        auto flMap = (fl + 1 < 64) ? (m_FLBitmap & (~uint64_t(0) << (fl + 1))) : 0;
+        if (flMap == 0)
+        { return InvalidNode; }
+
+        fl    = FindFirstSet(flMap);
+        slMap = m_SLBitmap[fl];
+    }
+
+    sl = FindFirstSet(slMap);
+    return m_FreeHeads[fl][sl];
+}
+
+//-----------------------------------------------------------------------------
+//      空きリストにノードを追加します.
+//-----------------------------------------------------------------------------
+void TlsfAllocator::InsertFree(uint32_t node)
+{
+    uint32_t fl = 0;
+    uint32_t sl = 0;
+    MappingInsert(m_Nodes[node].Size, fl, sl);
+
+    auto head = m_FreeHeads[fl][sl];
+    auto& n = m_Nodes[node];
+    n.Free      = true;
+    n.PrevFree  = InvalidNode;
+    n.NextFree  = head;
+
+    if (head != InvalidNode)
+    { m_Nodes[head].PrevFree = node; }
+
+    m_FreeHeads[fl][sl] = node;
+    m_FLBitmap     |= uint64_t(1) << fl;
+    m_SLBitmap[fl] |= 1u << sl;
+    m_FreeBlockCount++;
+}
+
+//-----------------------------------------------------------------------------
+//      空きリストからノードを外します.
+//-----------------------------------------------------------------------------
+void TlsfAllocator::RemoveFree(uint32_t node)
+{
+    uint32_t fl = 0;
+    uint32_t sl = 0;
+    MappingInsert(m_Nodes[node].Size, fl, sl);
+
+    auto& n = m_Nodes[node];
+    if (n.PrevFree != InvalidNode)
+    { m_Nodes[n.PrevFree].NextFree = n.NextFree; }
+    else
+    { m_FreeHeads[fl][sl] = n.NextFree; }
+
+    if (n.NextFree != InvalidNode)
+    { m_Nodes[n.NextFree].PrevFree = n.PrevFree; }
+
+    n.PrevFree = InvalidNode;
+    n.NextFree = InvalidNode;
+
+    if (m_FreeHeads[fl][sl] == InvalidNode)
+    {
+        m_SLBitmap[fl] &= ~(1u << sl);
+        if (m_SLBitmap[fl] == 0)
+        { m_FLBitmap &= ~(uint64_t(1) << fl); }
+    }
+
+    m_FreeBlockCount--;
+}
+
+//-----------------------------------------------------------------------------
+//      ノードを確保します.
+//-----------------------------------------------------------------------------
+uint32_t TlsfAllocator::NewNode()
+{
+    uint32_t node;
+    if (!m_UnusedNodes.empty())
+    {
+        node = m_UnusedNodes.back();
+        m_UnusedNodes.pop_back();
+    }
+    else
+    {
+        node = uint32_t(m_Nodes.size());
+        m_Nodes.emplace_back();
+    }
+
+    auto& n = m_Nodes[node];
+    n.Offset    = 0;
+    n.Size      = 0;
+    n.PrevPhys  = InvalidNode;
+    n.NextPhys  = InvalidNode;
+    n.PrevFree  = InvalidNode;
+    n.NextFree  = InvalidNode;
+    n.Free      = false;
+
+    return node;
+}
+
+//-----------------------------------------------------------------------------
+//      ノードを返却します.
+//-----------------------------------------------------------------------------
+void TlsfAllocator::DeleteNode(uint32_t node)
+{
+    m_Nodes[node].Size = 0;
+    m_Nodes[node].Free = false;
+    m_UnusedNodes.push_back(node);
+}
+
+//-----------------------------------------------------------------------------
+//      ノードの先頭 size バイトを残し, 後ろを新しい空きブロックに分割します.
+//-----------------------------------------------------------------------------
+void TlsfAllocator::SplitTail(uint32_t node, uint64_t size)
+{
+    auto tail = NewNode();
+    auto& t = m_Nodes[tail];
+    auto& n = m_Nodes[node];
+
+    t.Offset    = n.Offset + size;
+    t.Size      = n.Size - size;
+    t.PrevPhys  = node;
+    t.NextPhys  = n.NextPhys;
+
+    if (n.NextPhys != InvalidNode)
+    { m_Nodes[n.NextPhys].PrevPhys = tail; }
+
+    n.Size     = size;
+    n.NextPhys = tail;
+
+    InsertFree(tail);
+}
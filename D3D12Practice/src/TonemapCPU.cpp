@@ -0,0 +1,683 @@
+﻿//-----------------------------------------------------------------------------
+// File : TonemapCPU.cpp
+// Desc : CPU Reference Tonemapper.
+// Copyright(c) Pocol. All right reserved.
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------
+#include "TonemapCPU.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <thread>
+#include <vector>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#define TONEMAP_USE_SSE     (1)
+#include <emmintrin.h>
+#endif
+
+
+namespace {
+
+//-----------------------------------------------------------------------------
+// Constant Values.
+//-----------------------------------------------------------------------------
+constexpr uint32_t  TileRows    = 16;                       // タイルあたりの行数.
+constexpr float     MaxInput    = 65504.0f;                 // 入力の最大値(シーンカラーの半精度浮動小数の最大値).
+constexpr float     InvGamma    = 1.0f / 2.2f;              // BT.709 出力のガンマ.
+constexpr float     PQ_M1       = 2610.0f / 4096.0f / 4.0f; // ST.2084 の定数.
+constexpr float     PQ_M2       = 2523.0f / 4096.0f * 128.0f;
+constexpr float     PQ_C1       = 3424.0f / 4096.0f;
+constexpr float     PQ_C2       = 2413.0f / 4096.0f * 32.0f;
+constexpr float     PQ_C3       = 2392.0f / 4096.0f * 32.0f;
+constexpr float     GT_A        = 1.0f;                     // GTトーンマップの傾き.
+constexpr float     GT_M        = 0.22f;                    // GTトーンマップの線形区間の開始点.
+constexpr float     GT_L        = 0.4f;                     // GTトーンマップの線形区間の長さ.
+constexpr float     GT_C        = 1.33f;                    // GTトーンマップの暗部の曲率.
+constexpr float     GT_B        = 0.0f;                     // GTトーンマップの黒レベル.
+
+// ITU-R BT.709 から ITU-R BT.2020 への変換行列(ITU-R BT.2087).
+constexpr float Rec709ToRec2020[3][3] = {
+    { 0.627402f, 0.329292f, 0.043306f },
+    { 0.069095f, 0.919544f, 0.011360f },
+    { 0.016394f, 0.088028f, 0.895578f },
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// Constants structure
+///////////////////////////////////////////////////////////////////////////////
+struct Constants
+{
+    int     Type;           // トーンマップタイプ.
+    int     ColorSpace;     // 出力色空間.
+    float   Exposure;       // トーンマップ前に乗算する露光.
+    float   PeakRatio;      // 最大輝度値 / 基準輝度値.
+    float   PQScale;        // 基準輝度値 / 10000[nit].
+    float   S0;             // GTトーンマップの肩の開始点.
+    float   S1;             // GTトーンマップの肩の開始値.
+    float   CP;             // GTトーンマップの肩の指数係数.
+};
+
+//-----------------------------------------------------------------------------
+//      パラメータから定数を求めます.
+//-----------------------------------------------------------------------------
+Constants MakeConstants(const TonemapParam& param, float exposure)
+{
+    Constants result = {};
+    result.Type       = param.Type;
+    result.ColorSpace = param.ColorSpace;
+    result.Exposure   = exposure;
+    result.PeakRatio  = param.MaxLuminance / param.BaseLuminance;
+    result.PQScale    = param.BaseLuminance / 10000.0f;
+
+    auto P  = result.PeakRatio;
+    auto l0 = ((P - GT_M) * GT_L) / GT_A;
+    auto C2 = (GT_A * P) / (P - (GT_M + GT_A * l0));
+
+    result.S0 = GT_M + l0;
+    result.S1 = GT_M + GT_A * l0;
+    result.CP = -C2 / P;
+    return result;
+}
+
+//-----------------------------------------------------------------------------
+//      Reinhardトーンマップです.
+//-----------------------------------------------------------------------------
+inline float Reinhard(float x, const Constants& c)
+{ return x * c.PeakRatio / (x + c.PeakRatio); }
+
+//-----------------------------------------------------------------------------
+//      GTトーンマップです(Uchimura 2017).
+//-----------------------------------------------------------------------------
+inline float GranTurismo(float x, const Constants& c)
+{
+    auto P = c.PeakRatio;
+
+    auto t  = std::min(std::max(x / GT_M, 0.0f), 1.0f);
+    auto w0 = 1.0f - t * t * (3.0f - 2.0f * t);
+    auto w2 = (x >= c.S0) ? 1.0f : 0.0f;
+    auto w1 = 1.0f - w0 - w2;
+
+    // 暗部は x < m でしか使わないので, 巨大な入力で無限大にならないよう抑える.
+    auto T = GT_M * std::pow(std::min(x, GT_M) / GT_M, GT_C) + GT_B;
+    auto S = P - (P - c.S1) * std::exp(c.CP * (x - c.S0));
+    auto L = GT_M + GT_A * (x - GT_M);
+
+    return T * w0 + L * w1 + S * w2;
+}
+
+//-----------------------------------------------------------------------------
+//      ST.2084 (PQ) の伝達関数です.
+//-----------------------------------------------------------------------------
+inline float LinearToST2084(float x)
+{
+    auto cp = std::pow(x, PQ_M1);
+    return std::pow((PQ_C1 + PQ_C2 * cp) / (1.0f + PQ_C3 * cp), PQ_M2);
+}
+
+//-----------------------------------------------------------------------------
+//      負の値と NaN を 0 にします.
+//-----------------------------------------------------------------------------
+inline float Positive(float x)
+{ return (x > 0.0f) ? x : 0.0f; }
+
+//-----------------------------------------------------------------------------
+//      入力値を [0, MaxInput] に収めます(NaN は 0).
+//-----------------------------------------------------------------------------
+inline float ClampInput(float x)
+{ return std::min(Positive(x), MaxInput); }
+
+//-----------------------------------------------------------------------------
+//      1ピクセルを変換します.
+//-----------------------------------------------------------------------------
+void TonemapScalar(const Constants& c, const float* src, float* dst)
+{
+    float rgb[3] = {
+        ClampInput(src[0] * c.Exposure),
+        ClampInput(src[1] * c.Exposure),
+        ClampInput(src[2] * c.Exposure),
+    };
+
+    for (auto i = 0; i < 3; ++i)
+    {
+        if (c.Type == TONEMAP_REINHARD)
+        { rgb[i] = Reinhard(rgb[i], c); }
+        else if (c.Type == TONEMAP_GT)
+        { rgb[i] = GranTurismo(rgb[i], c); }
+    }
+
+    if (c.ColorSpace == COLOR_SPACE_BT2100_PQ)
+    {
+        float wide[3];
+        for (auto i = 0; i < 3; ++i)
+        {
+            wide[i] = Rec709ToRec2020[i][0] * rgb[0]
+                    + Rec709ToRec2020[i][1] * rgb[1]
+                    + Rec709ToRec2020[i][2] * rgb[2];
+        }
+
+        for (auto i = 0; i < 3; ++i)
+        { dst[i] = LinearToST2084(Positive(wide[i] * c.PQScale)); }
+    }
+    else
+    {
+        for (auto i = 0; i < 3; ++i)
+        { dst[i] = std::pow(std::min(rgb[i], 1.0f), InvGamma); }
+    }
+
+    dst[3] = src[3];
+}
+
+#if TONEMAP_USE_SSE
+//-----------------------------------------------------------------------------
+//      2の累乗を求めます.
+//-----------------------------------------------------------------------------
+inline __m128 Exp2(__m128 x)
+{
+    x = _mm_min_ps(_mm_max_ps(x, _mm_set1_ps(-126.0f)), _mm_set1_ps(127.0f));
+
+    // 整数部は指数に, 小数部[-0.5, 0.5]は多項式(2^f のテイラー展開)で求める.
+    auto xi = _mm_cvtps_epi32(x);
+    auto f  = _mm_sub_ps(x, _mm_cvtepi32_ps(xi));
+
+    auto p = _mm_set1_ps(1.5252733804e-5f);
+    p = _mm_add_ps(_mm_mul_ps(p, f), _mm_set1_ps(1.5403530393e-4f));
+    p = _mm_add_ps(_mm_mul_ps(p, f), _mm_set1_ps(1.3333558146e-3f));
+    p = _mm_add_ps(_mm_mul_ps(p, f), _mm_set1_ps(9.6181291076e-3f));
+    p = _mm_add_ps(_mm_mul_ps(p, f), _mm_set1_ps(5.5504108665e-2f));
+    p = _mm_add_ps(_mm_mul_ps(p, f), _mm_set1_ps(2.4022650696e-1f));
+    p = _mm_add_ps(_mm_mul_ps(p, f), _mm_set1_ps(6.9314718056e-1f));
+    p = _mm_add_ps(_mm_mul_ps(p, f), _mm_set1_ps(1.0f));
+
+    auto scale = _mm_castsi128_ps(_mm_slli_epi32(_mm_add_epi32(xi, _mm_set1_epi32(127)), 23));
+    return _mm_mul_ps(p, scale);
+}
+
+//-----------------------------------------------------------------------------
+//      2を底とする対数を求めます(x > 0).
+//-----------------------------------------------------------------------------
+inline __m128 Log2(__m128 x)
+{
+    auto bits = _mm_castps_si128(x);
+    auto e    = _mm_sub_epi32(_mm_srli_epi32(bits, 23), _mm_set1_epi32(127));
+    auto m    = _mm_castsi128_ps(_mm_or_si128(
+        _mm_and_si128(bits, _mm_set1_epi32(0x007FFFFF)),
+        _mm_set1_epi32(0x3F800000)));
+
+    // 仮数を [sqrt(0.5), sqrt(2)) に寄せて級数の収束を早める.
+    auto mask = _mm_cmpgt_ps(m, _mm_set1_ps(1.41421356f));
+    m = _mm_or_ps(_mm_and_ps(mask, _mm_mul_ps(m, _mm_set1_ps(0.5f))), _mm_andnot_ps(mask, m));
+    e = _mm_sub_epi32(e, _mm_castps_si128(mask));
+
+    // log2(m) = 2 / ln2 * atanh((m - 1) / (m + 1)).
+    auto t  = _mm_div_ps(_mm_sub_ps(m, _mm_set1_ps(1.0f)), _mm_add_ps(m, _mm_set1_ps(1.0f)));
+    auto t2 = _mm_mul_ps(t, t);
+
+    auto p = _mm_set1_ps(1.0f / 9.0f);
+    p = _mm_add_ps(_mm_mul_ps(p, t2), _mm_set1_ps(1.0f / 7.0f));
+    p = _mm_add_ps(_mm_mul_ps(p, t2), _mm_set1_ps(1.0f / 5.0f));
+    p = _mm_add_ps(_mm_mul_ps(p, t2), _mm_set1_ps(1.0f / 3.0f));
+    p = _mm_add_ps(_mm_mul_ps(p, t2), _mm_set1_ps(1.0f));
+    p = _mm_mul_ps(_mm_mul_ps(p, t), _mm_set1_ps(2.88539008f));
+
+    return _mm_add_ps(_mm_cvtepi32_ps(e), p);
+}
+
+//-----------------------------------------------------------------------------
+//      累乗を求めます(x >= 0).
+//-----------------------------------------------------------------------------
+inline __m128 Pow(__m128 x, float y)
+{ return Exp2(_mm_mul_ps(Log2(x), _mm_set1_ps(y))); }
+
+//-----------------------------------------------------------------------------
+//      負の値と NaN を 0 にします.
+//-----------------------------------------------------------------------------
+inline __m128 Positive(__m128 x)
+{ return _mm_max_ps(x, _mm_setzero_ps()); }     // maxps は NaN のとき第2引数を返す.
+
+//-----------------------------------------------------------------------------
+//      入力値を [0, MaxInput] に収めます(NaN は 0).
+//-----------------------------------------------------------------------------
+inline __m128 ClampInput(__m128 x)
+{ return _mm_min_ps(Positive(x), _mm_set1_ps(MaxInput)); }
+
+//-----------------------------------------------------------------------------
+//      Reinhardトーンマップです.
+//-----------------------------------------------------------------------------
+inline __m128 Reinhard(__m128 x, const Constants& c)
+{
+    auto k = _mm_set1_ps(c.PeakRatio);
+    return _mm_div_ps(_mm_mul_ps(x, k), _mm_add_ps(x, k));
+}
+
+//-----------------------------------------------------------------------------
+//      GTトーンマップです(Uchimura 2017).
+//-----------------------------------------------------------------------------
+inline __m128 GranTurismo(__m128 x, const Constants& c)
+{
+    auto one = _mm_set1_ps(1.0f);
+    auto m   = _mm_set1_ps(GT_M);
+    auto P   = _mm_set1_ps(c.PeakRatio);
+
+    auto t  = _mm_min_ps(_mm_mul_ps(x, _mm_set1_ps(1.0f / GT_M)), one);
+    auto w0 = _mm_sub_ps(one, _mm_mul_ps(_mm_mul_ps(t, t), _mm_sub_ps(_mm_set1_ps(3.0f), _mm_add_ps(t, t))));
+    auto w2 = _mm_and_ps(_mm_cmpge_ps(x, _mm_set1_ps(c.S0)), one);
+    auto w1 = _mm_sub_ps(_mm_sub_ps(one, w0), w2);
+
+    auto T = _mm_add_ps(_mm_mul_ps(m, Pow(t, GT_C)), _mm_set1_ps(GT_B));
+    auto e = Exp2(_mm_mul_ps(_mm_sub_ps(x, _mm_set1_ps(c.S0)), _mm_set1_ps(c.CP * 1.44269504f)));
+    auto S = _mm_sub_ps(P, _mm_mul_ps(_mm_set1_ps(c.PeakRatio - c.S1), e));
+    auto L = _mm_add_ps(m, _mm_mul_ps(_mm_set1_ps(GT_A), _mm_sub_ps(x, m)));
+
+    return _mm_add_ps(_mm_add_ps(_mm_mul_ps(T, w0), _mm_mul_ps(L, w1)), _mm_mul_ps(S, w2));
+}
+
+//-----------------------------------------------------------------------------
+//      ST.2084 (PQ) の伝達関数です.
+//-----------------------------------------------------------------------------
+inline __m128 LinearToST2084(__m128 x)
+{
+    auto cp  = Pow(x, PQ_M1);
+    auto num = _mm_add_ps(_mm_set1_ps(PQ_C1), _mm_mul_ps(_mm_set1_ps(PQ_C2), cp));
+    auto den = _mm_add_ps(_mm_set1_ps(1.0f),  _mm_mul_ps(_mm_set1_ps(PQ_C3), cp));
+    return Pow(_mm_div_ps(num, den), PQ_M2);
+}
+
+//-----------------------------------------------------------------------------
+//      4ピクセルを変換します.
+//-----------------------------------------------------------------------------
+void TonemapSSE(const Constants& c, const float* src, float* dst)
+{
+    // AoS(RGBA x 4) から SoA(R, G, B, A) に並べ替える.
+    auto r = _mm_loadu_ps(src + 0);
+    auto g = _mm_loadu_ps(src + 4);
+    auto b = _mm_loadu_ps(src + 8);
+    auto a = _mm_loadu_ps(src + 12);
+    _MM_TRANSPOSE4_PS(r, g, b, a);
+
+    auto exposure = _mm_set1_ps(c.Exposure);
+    r = ClampInput(_mm_mul_ps(r, exposure));
+    g = ClampInput(_mm_mul_ps(g, exposure));
+    b = ClampInput(_mm_mul_ps(b, exposure));
+
+    if (c.Type == TONEMAP_REINHARD)
+    {
+        r = Reinhard(r, c);
+        g = Reinhard(g, c);
+        b = Reinhard(b, c);
+    }
+    else if (c.Type == TONEMAP_GT)
+    {
+        r = GranTurismo(r, c);
+        g = GranTurismo(g, c);
+        b = GranTurismo(b, c);
+    }
+
+    if (c.ColorSpace == COLOR_SPACE_BT2100_PQ)
+    {
+        __m128 wide[3];
+        for (auto i = 0; i < 3; ++i)
+        {
+            wide[i] = _mm_add_ps(_mm_add_ps(
+                _mm_mul_ps(_mm_set1_ps(Rec709ToRec2020[i][0]), r),
+                _mm_mul_ps(_mm_set1_ps(Rec709ToRec2020[i][1]), g)),
+                _mm_mul_ps(_mm_set1_ps(Rec709ToRec2020[i][2]), b));
+        }
+
+        auto scale = _mm_set1_ps(c.PQScale);
+        r = LinearToST2084(Positive(_mm_mul_ps(wide[0], scale)));
+        g = LinearToST2084(Positive(_mm_mul_ps(wide[1], scale)));
+        b = LinearToST2084(Positive(_mm_mul_ps(wide[2], scale)));
+    }
+    else
+    {
+        auto one = _mm_set1_ps(1.0f);
+        r = Pow(_mm_min_ps(r, one), InvGamma);
+        g = Pow(_mm_min_ps(g, one), InvGamma);
+        b = Pow(_mm_min_ps(b, one), InvGamma);
+    }
+
+    _MM_TRANSPOSE4_PS(r, g, b, a);
+    _mm_storeu_ps(dst + 0,  r);
+    _mm_storeu_ps(dst + 4,  g);
+    _mm_storeu_ps(dst + 8,  b);
+    _mm_storeu_ps(dst + 12, a);
+}
+#endif
+
+//-----------------------------------------------------------------------------
+//      ジョブをワーカースレッドに分配して実行します.
+//-----------------------------------------------------------------------------
+template<typename Func>
+void ParallelFor(uint32_t jobCount, uint32_t threadCount, Func func)
+{
+    if (threadCount == 0)
+    { threadCount = std::max(1u, std::thread::hardware_concurrency()); }
+
+    threadCount = std::max(1u, std::min(threadCount, jobCount));
+
+    // ジョブはワーカースレッドが順に取りに行く.
+    std::atomic<uint32_t> next(0);
+    auto worker = [&](uint32_t threadIndex)
+    {
+        for (auto job = next.fetch_add(1); job < jobCount; job = next.fetch_add(1))
+        { func(job, threadIndex); }
+    };
+
+    std::vector<std::thread> threads;
+    threads.reserve(threadCount - 1);
+    for (auto i = 1u; i < threadCount; ++i)
+    { threads.emplace_back(worker, i); }
+
+    worker(0);
+
+    for (auto& thread : threads)
+    { thread.join(); }
+}
+
+//-----------------------------------------------------------------------------
+//      LUTの設定が正しいかどうかチェックします.
+//-----------------------------------------------------------------------------
+bool IsValidLUTDesc(const TonemapLUTDesc& desc)
+{
+    return desc.Size >= TONEMAP_LUT_MIN_SIZE
+        && desc.Size <= TONEMAP_LUT_MAX_SIZE
+        && desc.MaxLog > desc.MinLog
+        && desc.MinLog > -126.0f
+        && desc.MaxLog < std::log2(MaxInput);
+}
+
+//-----------------------------------------------------------------------------
+//      トーンマップパラメータが正しいかどうかチェックします.
+//-----------------------------------------------------------------------------
+bool IsValidParam(const TonemapParam& param)
+{ return (param.BaseLuminance > 0.0f) && (param.MaxLuminance > 0.0f); }
+
+} // namespace
+
+
+//-----------------------------------------------------------------------------
+//      1ピクセルにトーンマップと出力色空間への変換を適用します.
+//-----------------------------------------------------------------------------
+void TonemapPixel(const TonemapParam& param, const float src[4], float dst[4], float exposure)
+{
+    auto c = MakeConstants(param, exposure);
+    TonemapScalar(c, src, dst);
+}
+
+//-----------------------------------------------------------------------------
+//      RGBA32F のピクセル列にトーンマップを適用します.
+//-----------------------------------------------------------------------------
+void TonemapPixels(const TonemapParam& param, const float* pSrc, float* pDst, size_t count, float exposure)
+{
+    auto c = MakeConstants(param, exposure);
+    size_t i = 0;
+
+#if TONEMAP_USE_SSE
+    for (; i + 4 <= count; i += 4)
+    { TonemapSSE(c, pSrc + i * 4, pDst + i * 4); }
+#endif
+
+    for (; i < count; ++i)
+    { TonemapScalar(c, pSrc + i * 4, pDst + i * 4); }
+}
+
+//-----------------------------------------------------------------------------
+//      画像にトーンマップを適用します.
+//-----------------------------------------------------------------------------
+bool TonemapImage
+(
+    const FloatImage&   image,
+    const TonemapParam& param,
+    FloatImage&         result,
+    uint32_t            threadCount,
+    float               exposure
+)
+{
+    if (image.Width == 0 || image.Height == 0
+     || image.Pixels.size() < size_t(image.Width) * image.Height * 4)
+    { return false; }
+
+    if (!IsValidParam(param))
+    { return false; }
+
+    if (&result != &image)
+    {
+        result.Width  = image.Width;
+        result.Height = image.Height;
+        result.Pixels.resize(size_t(image.Width) * image.Height * 4);
+    }
+
+    // 行をまとめたタイル単位で分配する.
+    auto tileCount = (image.Height + TileRows - 1) / TileRows;
+    ParallelFor(tileCount, threadCount, [&](uint32_t tile, uint32_t)
+    {
+        auto y0     = tile * TileRows;
+        auto y1     = std::min(y0 + TileRows, image.Height);
+        auto offset = size_t(y0) * image.Width * 4;
+        TonemapPixels(
+            param,
+            image.Pixels.data() + offset,
+            result.Pixels.data() + offset,
+            size_t(y1 - y0) * image.Width,
+            exposure);
+    });
+
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+//      LUTの入力符号化の定数を求めます.
+//-----------------------------------------------------------------------------
+TonemapLUTShaper GetTonemapLUTShaper(const TonemapLUTDesc& desc)
+{
+    auto size = float(std::max(desc.Size, TONEMAP_LUT_MIN_SIZE));
+
+    TonemapLUTShaper result = {};
+    result.InvEpsilon   = std::exp2(-desc.MinLog);
+    result.InvRange     = 1.0f / std::log2(1.0f + std::exp2(desc.MaxLog - desc.MinLog));
+    result.Scale        = (size - 1.0f) / size;
+    result.Offset       = 0.5f / size;
+    return result;
+}
+
+//-----------------------------------------------------------------------------
+//      トーンマップと出力色空間への変換をLUTに焼き込みます.
+//-----------------------------------------------------------------------------
+bool BakeTonemapLUT
+(
+    const TonemapParam&     param,
+    const TonemapLUTDesc&   desc,
+    std::vector<float>&     lut,
+    uint32_t                threadCount
+)
+{
+    if (!IsValidParam(param) || !IsValidLUTDesc(desc))
+    { return false; }
+
+    auto size    = desc.Size;
+    auto shaper  = GetTonemapLUTShaper(desc);
+    auto epsilon = std::exp2(desc.MinLog);
+
+    // 格子点の入力値(符号化の逆変換).
+    std::vector<float> nodes(size);
+    for (auto i = 0u; i < size; ++i)
+    {
+        auto u = float(i) / float(size - 1);
+        nodes[i] = epsilon * (std::exp2(u / shaper.InvRange) - 1.0f);
+    }
+    nodes[0] = 0.0f;
+
+    lut.resize(size_t(size) * size * size * 4);
+
+    // G, B を固定した1行ずつ分配する.
+    ParallelFor(size * size, threadCount, [&](uint32_t row, uint32_t)
+    {
+        auto g = row % size;
+        auto b = row / size;
+        auto pDst = lut.data() + size_t(row) * size * 4;
+
+        for (auto r = 0u; r < size; ++r)
+        {
+            pDst[r * 4 + 0] = nodes[r];
+            pDst[r * 4 + 1] = nodes[g];
+            pDst[r * 4 + 2] = nodes[b];
+            pDst[r * 4 + 3] = 1.0f;
+        }
+
+        TonemapPixels(param, pDst, pDst, size);
+    });
+
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+//      LUTを引きます.
+//-----------------------------------------------------------------------------
+void SampleTonemapLUT
+(
+    const TonemapLUTDesc&   desc,
+    const float*            pLUT,
+    const float             src[4],
+    float                   dst[4],
+    float                   exposure
+)
+{
+    const float weightScale = float(1u << TONEMAP_LUT_SUBTEXEL_BITS);
+
+    auto shaper = GetTonemapLUTShaper(desc);
+    auto last   = desc.Size - 1;
+
+    uint32_t index[3];
+    float    weight[3];
+    for (auto c = 0; c < 3; ++c)
+    {
+        auto x = ClampInput(src[c] * exposure);
+        auto u = std::min(std::log2(1.0f + x * shaper.InvEpsilon) * shaper.InvRange, 1.0f);
+        auto p = u * float(last);
+
+        index [c] = std::min(uint32_t(p), last - 1);
+        weight[c] = std::round((p - float(index[c])) * weightScale) / weightScale;
+    }
+
+    auto stride = size_t(desc.Size);
+    float result[3] = {};
+    for (auto corner = 0u; corner < 8; ++corner)
+    {
+        auto dr = (corner >> 0) & 0x1;
+        auto dg = (corner >> 1) & 0x1;
+        auto db = (corner >> 2) & 0x1;
+
+        auto w = (dr ? weight[0] : 1.0f - weight[0])
+               * (dg ? weight[1] : 1.0f - weight[1])
+               * (db ? weight[2] : 1.0f - weight[2]);
+
+        auto offset = (((index[2] + db) * stride + (index[1] + dg)) * stride + (index[0] + dr)) * 4;
+        result[0] += pLUT[offset + 0] * w;
+        result[1] += pLUT[offset + 1] * w;
+        result[2] += pLUT[offset + 2] * w;
+    }
+
+    dst[0] = result[0];
+    dst[1] = result[1];
+    dst[2] = result[2];
+    dst[3] = src[3];
+}
+
+//-----------------------------------------------------------------------------
+//      LUTを解析解と比較して精度を評価します.
+//-----------------------------------------------------------------------------
+bool EvaluateTonemapLUT
+(
+    const TonemapParam&         param,
+    const TonemapLUTDesc&       desc,
+    const std::vector<float>&   lut,
+    TonemapLUTReport&           report,
+    uint32_t                    samplesPerAxis,
+    uint32_t                    threadCount
+)
+{
+    if (!IsValidParam(param) || !IsValidLUTDesc(desc) || samplesPerAxis == 0
+     || lut.size() < size_t(desc.Size) * desc.Size * desc.Size * 4)
+    { return false; }
+
+    auto shaper  = GetTonemapLUTShaper(desc);
+    auto epsilon = std::exp2(desc.MinLog);
+
+    // 符号化後の空間で等間隔に取る(セルの中心を含むよう半サンプルずらす).
+    std::vector<float> inputs(samplesPerAxis);
+    for (auto i = 0u; i < samplesPerAxis; ++i)
+    {
+        auto u = (float(i) + 0.5f) / float(samplesPerAxis);
+        inputs[i] = epsilon * (std::exp2(u / shaper.InvRange) - 1.0f);
+    }
+
+    if (threadCount == 0)
+    { threadCount = std::max(1u, std::thread::hardware_concurrency()); }
+
+    struct Result
+    {
+        double  SumError = 0.0;
+        float   MaxError = -1.0f;
+        float   Input [3] = {};
+        float   Output[3] = {};
+    };
+    std::vector<Result> results(threadCount);
+
+    // B のスライス単位で分配し, スレッドごとに集計する.
+    ParallelFor(samplesPerAxis, threadCount, [&](uint32_t b, uint32_t threadIndex)
+    {
+        auto& result = results[threadIndex];
+        for (auto g = 0u; g < samplesPerAxis; ++g)
+        {
+            for (auto r = 0u; r < samplesPerAxis; ++r)
+            {
+                const float src[4] = { inputs[r], inputs[g], inputs[b], 1.0f };
+                float expected[4];
+                float actual  [4];
+                TonemapPixel(param, src, expected);
+                SampleTonemapLUT(desc, lut.data(), src, actual);
+
+                auto error = std::max(std::max(
+                    std::abs(actual[0] - expected[0]),
+                    std::abs(actual[1] - expected[1])),
+                    std::abs(actual[2] - expected[2]));
+
+                result.SumError += error;
+                if (error > result.MaxError)
+                {
+                    result.MaxError = error;
+                    for (auto c = 0; c < 3; ++c)
+                    {
+                        result.Input [c] = src[c];
+                        result.Output[c] = expected[c];
+                    }
+                }
+            }
+        }
+    });
+
+    report = {};
+    report.SampleCount = samplesPerAxis * samplesPerAxis * samplesPerAxis;
+
+    double sumError = 0.0;
+    for (auto& result : results)
+    {
+        sumError += result.SumError;
+        if (result.MaxError > report.MaxError)
+        {
+            report.MaxError = result.MaxError;
+            for (auto c = 0; c < 3; ++c)
+            {
+                report.MaxErrorInput [c] = result.Input [c];
+                report.MaxErrorOutput[c] = result.Output[c];
+            }
+        }
+    }
+    report.MeanError = float(sumError / double(report.SampleCount));
+
+    return true;
+}
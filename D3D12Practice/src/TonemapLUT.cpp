@@ -0,0 +1,363 @@
+﻿//-----------------------------------------------------------------------------
+// File : TonemapLUT.cpp
+// Desc : Baked 3D LUT for Tonemapping.
+// Copyright(c) Pocol. All right reserved.
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------
+#include "TonemapLUT.h"
+#include "GpuHeapAllocator.h"
+#include "Logger.h"
+#include "AsyncLogger.h"
+#include <chrono>
+#include <cstring>
+
+
+namespace {
+
+//-----------------------------------------------------------------------------
+// Constant Values.
+//-----------------------------------------------------------------------------
+constexpr DXGI_FORMAT   LUTFormat       = DXGI_FORMAT_R32G32B32A32_FLOAT;   // LUTのフォーマット.
+constexpr uint32_t      LUTPixelSize    = sizeof(float) * 4;                // LUTの1要素のバイト数.
+constexpr TonemapParam  InvalidParam    = { -1, -1, 0.0f, 0.0f };           // 未生成を表すパラメータ.
+
+//-----------------------------------------------------------------------------
+//      同じパラメータかどうかチェックします.
+//-----------------------------------------------------------------------------
+bool IsSameParam(const TonemapParam& lhs, const TonemapParam& rhs)
+{
+    return lhs.Type          == rhs.Type
+        && lhs.ColorSpace    == rhs.ColorSpace
+        && lhs.BaseLuminance == rhs.BaseLuminance
+        && lhs.MaxLuminance  == rhs.MaxLuminance;
+}
+
+//-----------------------------------------------------------------------------
+//      遷移バリアを設定します.
+//-----------------------------------------------------------------------------
+D3D12_RESOURCE_BARRIER Transition(ID3D12Resource* pResource, D3D12_RESOURCE_STATES before, D3D12_RESOURCE_STATES after)
+{
+    D3D12_RESOURCE_BARRIER barrier = {};
+    barrier.Type                    = D3D12_RESOURCE_BARRIER_TYPE_TRANSITION;
+    barrier.Transition.pResource    = pResource;
+    barrier.Transition.Subresource  = D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES;
+    barrier.Transition.StateBefore  = before;
+    barrier.Transition.StateAfter   = after;
+    return barrier;
+}
+
+} // namespace
+
+
+///////////////////////////////////////////////////////////////////////////////
+// TonemapLUT class
+///////////////////////////////////////////////////////////////////////////////
+
+//-----------------------------------------------------------------------------
+//      コンストラクタです.
+//-----------------------------------------------------------------------------
+TonemapLUT::TonemapLUT()
+: m_Shaper              ()
+, m_MemoryId            (MemoryTracker::InvalidId)
+, m_Footprint           ()
+, m_pPool               (nullptr)
+, m_pHandleSRV          (nullptr)
+, m_RequestParam        ()
+, m_BakeParam           (InvalidParam)
+, m_ReadyParam          ()
+, m_Report              ()
+, m_HasRequest          (false)
+, m_Baking              (false)
+, m_Ready               (false)
+, m_FramesSinceUpload   (FrameCount)
+{ /* DO_NOTHING */ }
+
+//-----------------------------------------------------------------------------
+//      デストラクタです.
+//-----------------------------------------------------------------------------
+TonemapLUT::~TonemapLUT()
+{ Term(); }
+
+//-----------------------------------------------------------------------------
+//      初期化処理を行います.
+//-----------------------------------------------------------------------------
+bool TonemapLUT::Init(ID3D12Device* pDevice, DescriptorPool* pPoolRes, const TonemapLUTDesc& desc)
+{
+    if (pDevice == nullptr || pPoolRes == nullptr
+     || desc.Size < TONEMAP_LUT_MIN_SIZE || desc.Size > TONEMAP_LUT_MAX_SIZE)
+    {
+        ELOG("Error : Invalid Argument.");
+        return false;
+    }
+
+    m_Desc   = desc;
+    m_Shaper = GetTonemapLUTShaper(desc);
+    m_pPool  = pPoolRes;
+
+    // LUTテクスチャを生成.
+    {
+        D3D12_HEAP_PROPERTIES prop = {};
+        prop.Type                 = D3D12_HEAP_TYPE_DEFAULT;
+        prop.CPUPageProperty      = D3D12_CPU_PAGE_PROPERTY_UNKNOWN;
+        prop.MemoryPoolPreference = D3D12_MEMORY_POOL_UNKNOWN;
+        prop.CreationNodeMask     = 1;
+        prop.VisibleNodeMask      = 1;
+
+        D3D12_RESOURCE_DESC texDesc = {};
+        texDesc.Dimension           = D3D12_RESOURCE_DIMENSION_TEXTURE3D;
+        texDesc.Width               = desc.Size;
+        texDesc.Height              = desc.Size;
+        texDesc.DepthOrArraySize    = UINT16(desc.Size);
+        texDesc.MipLevels           = 1;
+        texDesc.Format              = LUTFormat;
+        texDesc.SampleDesc.Count    = 1;
+        texDesc.Layout              = D3D12_TEXTURE_LAYOUT_UNKNOWN;
+        texDesc.Flags               = D3D12_RESOURCE_FLAG_NONE;
+
+        auto hr = pDevice->CreateCommittedResource(
+            &prop,
+            D3D12_HEAP_FLAG_NONE,
+            &texDesc,
+            D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE,
+            nullptr,
+            IID_PPV_ARGS(m_pTexture.GetAddressOf()));
+        if (FAILED(hr))
+        {
+            ELOG("Error : ID3D12Device::CreateCommittedResource() Failed. retcode = 0x%x", hr);
+            return false;
+        }
+
+        // 転送バッファを生成.
+        UINT64 uploadSize = 0;
+        pDevice->GetCopyableFootprints(&texDesc, 0, 1, 0, &m_Footprint, nullptr, nullptr, &uploadSize);
+
+        prop.Type = D3D12_HEAP_TYPE_UPLOAD;
+
+        D3D12_RESOURCE_DESC bufDesc = {};
+        bufDesc.Dimension           = D3D12_RESOURCE_DIMENSION_BUFFER;
+        bufDesc.Width               = uploadSize;
+        bufDesc.Height              = 1;
+        bufDesc.DepthOrArraySize    = 1;
+        bufDesc.MipLevels           = 1;
+        bufDesc.Format              = DXGI_FORMAT_UNKNOWN;
+        bufDesc.SampleDesc.Count    = 1;
+        bufDesc.Layout              = D3D12_TEXTURE_LAYOUT_ROW_MAJOR;
+        bufDesc.Flags               = D3D12_RESOURCE_FLAG_NONE;
+
+        hr = pDevice->CreateCommittedResource(
+            &prop,
+            D3D12_HEAP_FLAG_NONE,
+            &bufDesc,
+            D3D12_RESOURCE_STATE_GENERIC_READ,
+            nullptr,
+            IID_PPV_ARGS(m_pUpload.GetAddressOf()));
+        if (FAILED(hr))
+        {
+            ELOG("Error : ID3D12Device::CreateCommittedResource() Failed. retcode = 0x%x", hr);
+            return false;
+        }
+
+        m_MemoryId = GetMemoryTracker().Add(
+            MEMORY_CATEGORY_TEXTURE,
+            MEMORY_DOMAIN_GPU,
+            GetResourceSize(m_pTexture.Get()) + GetResourceSize(m_pUpload.Get()),
+            "TonemapLUT");
+    }
+
+    // シェーダリソースビューを生成.
+    {
+        m_pHandleSRV = m_pPool->AllocHandle();
+        if (m_pHandleSRV == nullptr)
+        {
+            ELOG("Error : DescriptorPool::AllocHandle() Failed.");
+            return false;
+        }
+
+        D3D12_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
+        srvDesc.Format                      = LUTFormat;
+        srvDesc.ViewDimension               = D3D12_SRV_DIMENSION_TEXTURE3D;
+        srvDesc.Shader4ComponentMapping     = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
+        srvDesc.Texture3D.MostDetailedMip   = 0;
+        srvDesc.Texture3D.MipLevels         = 1;
+
+        pDevice->CreateShaderResourceView(m_pTexture.Get(), &srvDesc, m_pHandleSRV->HandleCPU);
+    }
+
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+//      終了処理を行います.
+//-----------------------------------------------------------------------------
+void TonemapLUT::Term()
+{
+    // 生成中のLUTの完了を待つ.
+    if (m_Bake.valid())
+    { m_Bake.wait(); }
+    m_Bake = std::future<BakeResult>();
+
+    if (m_pPool != nullptr && m_pHandleSRV != nullptr)
+    { m_pPool->FreeHandle(m_pHandleSRV); }
+
+    m_pPool      = nullptr;
+    m_pHandleSRV = nullptr;
+
+    m_pTexture.Reset();
+    m_pUpload.Reset();
+
+    GetMemoryTracker().Remove(m_MemoryId);
+    m_MemoryId = MemoryTracker::InvalidId;
+
+    m_BakeParam         = InvalidParam;
+    m_HasRequest        = false;
+    m_Baking            = false;
+    m_Ready             = false;
+    m_FramesSinceUpload = FrameCount;
+}
+
+//-----------------------------------------------------------------------------
+//      LUTの生成を要求します.
+//-----------------------------------------------------------------------------
+void TonemapLUT::Request(const TonemapParam& param)
+{
+    if (m_HasRequest && IsSameParam(m_RequestParam, param))
+    { return; }
+
+    m_RequestParam = param;
+    m_HasRequest   = true;
+}
+
+//-----------------------------------------------------------------------------
+//      生成が完了したLUTをテクスチャに転送します.
+//-----------------------------------------------------------------------------
+bool TonemapLUT::Update(ID3D12GraphicsCommandList* pCmd)
+{
+    if (m_pTexture == nullptr)
+    { return false; }
+
+    if (m_FramesSinceUpload < FrameCount)
+    { m_FramesSinceUpload++; }
+
+    auto updated = false;
+
+    // 転送バッファがGPUで使われている間は受け取らない.
+    if (m_Baking
+     && m_FramesSinceUpload >= FrameCount
+     && m_Bake.wait_for(std::chrono::seconds(0)) == std::future_status::ready)
+    {
+        auto result = m_Bake.get();
+        m_Baking = false;
+
+        if (result.Succeeded)
+        {
+            uint8_t* pDst = nullptr;
+            auto hr = m_pUpload->Map(0, nullptr, reinterpret_cast<void**>(&pDst));
+            if (SUCCEEDED(hr))
+            {
+                auto size     = m_Desc.Size;
+                auto rowBytes = size * LUTPixelSize;
+                auto pSrc     = reinterpret_cast<const uint8_t*>(result.LUT.data());
+
+                pDst += m_Footprint.Offset;
+                for (auto z = 0u; z < size; ++z)
+                {
+                    for (auto y = 0u; y < size; ++y)
+                    {
+                        auto dstOffset = (size_t(z) * size + y) * m_Footprint.Footprint.RowPitch;
+                        auto srcOffset = (size_t(z) * size + y) * rowBytes;
+                        memcpy(pDst + dstOffset, pSrc + srcOffset, rowBytes);
+                    }
+                }
+
+                m_pUpload->Unmap(0, nullptr);
+
+                auto barrier = Transition(m_pTexture.Get(), D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_COPY_DEST);
+                pCmd->ResourceBarrier(1, &barrier);
+
+                D3D12_TEXTURE_COPY_LOCATION dst = {};
+                dst.pResource        = m_pTexture.Get();
+                dst.Type             = D3D12_TEXTURE_COPY_TYPE_SUBRESOURCE_INDEX;
+                dst.SubresourceIndex = 0;
+
+                D3D12_TEXTURE_COPY_LOCATION src = {};
+                src.pResource       = m_pUpload.Get();
+                src.Type            = D3D12_TEXTURE_COPY_TYPE_PLACED_FOOTPRINT;
+                src.PlacedFootprint = m_Footprint;
+
+                pCmd->CopyTextureRegion(&dst, 0, 0, 0, &src, nullptr);
+
+                barrier = Transition(m_pTexture.Get(), D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+                pCmd->ResourceBarrier(1, &barrier);
+
+                m_ReadyParam        = result.Param;
+                m_Report            = result.Report;
+                m_Ready             = true;
+                m_FramesSinceUpload = 0;
+                updated             = true;
+            }
+            else
+            {
+                ALOG("Error : ID3D12Resource::Map() Failed. retcode = 0x%x", hr);
+            }
+        }
+        else
+        {
+            ALOG("Error : BakeTonemapLUT() Failed.");
+        }
+    }
+
+    // 最新の要求が最後に生成したものと異なれば生成を開始.
+    if (!m_Baking && m_HasRequest && !IsSameParam(m_BakeParam, m_RequestParam))
+    {
+        m_BakeParam = m_RequestParam;
+        m_Bake      = std::async(std::launch::async, &TonemapLUT::Bake, m_BakeParam, m_Desc);
+        m_Baking    = true;
+    }
+
+    return updated;
+}
+
+//-----------------------------------------------------------------------------
+//      指定パラメータのLUTが使えるかどうかチェックします.
+//-----------------------------------------------------------------------------
+bool TonemapLUT::IsReady(const TonemapParam& param) const
+{ return m_Ready && IsSameParam(m_ReadyParam, param); }
+
+//-----------------------------------------------------------------------------
+//      入力符号化の定数を取得します.
+//-----------------------------------------------------------------------------
+const TonemapLUTShaper& TonemapLUT::GetShaper() const
+{ return m_Shaper; }
+
+//-----------------------------------------------------------------------------
+//      LUTの設定を取得します.
+//-----------------------------------------------------------------------------
+const TonemapLUTDesc& TonemapLUT::GetDesc() const
+{ return m_Desc; }
+
+//-----------------------------------------------------------------------------
+//      現在のLUTの精度の評価結果を取得します.
+//-----------------------------------------------------------------------------
+const TonemapLUTReport& TonemapLUT::GetReport() const
+{ return m_Report; }
+
+//-----------------------------------------------------------------------------
+//      LUTのSRVを取得します.
+//-----------------------------------------------------------------------------
+D3D12_GPU_DESCRIPTOR_HANDLE TonemapLUT::GetHandleSRV() const
+{ return m_pHandleSRV->HandleGPU; }
+
+//-----------------------------------------------------------------------------
+//      LUTを生成します(ワーカースレッドで実行されます).
+//-----------------------------------------------------------------------------
+TonemapLUT::BakeResult TonemapLUT::Bake(TonemapParam param, TonemapLUTDesc desc)
+{
+    BakeResult result = {};
+    result.Param     = param;
+    result.Succeeded = BakeTonemapLUT(param, desc, result.LUT)
+                    && EvaluateTonemapLUT(param, desc, result.LUT, result.Report);
+    return result;
+}
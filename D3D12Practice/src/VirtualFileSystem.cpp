@@ -0,0 +1,341 @@
+﻿//-----------------------------------------------------------------------------
+// File : VirtualFileSystem.cpp
+// Desc : Virtual File System.
+// Copyright(c) Pocol. All right reserved.
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------
+#include "VirtualFileSystem.h"
+#include <algorithm>
+#include <chrono>
+
+
+///////////////////////////////////////////////////////////////////////////////
+// VirtualFileSystem class
+///////////////////////////////////////////////////////////////////////////////
+
+//-----------------------------------------------------------------------------
+//      コンストラクタです.
+//-----------------------------------------------------------------------------
+VirtualFileSystem::VirtualFileSystem()
+: m_pSnapshot(std::make_shared<Snapshot>())
+, m_WatchStop(false)
+{ /* DO_NOTHING */ }
+
+//-----------------------------------------------------------------------------
+//      デストラクタです.
+//-----------------------------------------------------------------------------
+VirtualFileSystem::~VirtualFileSystem()
+{ StopWatch(); }
+
+//-----------------------------------------------------------------------------
+//      ディレクトリをマウントします.
+//-----------------------------------------------------------------------------
+bool VirtualFileSystem::Mount(const std::filesystem::path& root, uint32_t maxDepth)
+{
+    std::error_code ec;
+    auto absolute = std::filesystem::absolute(root, ec);
+    if (ec || !std::filesystem::is_directory(absolute, ec))
+    { return false; }
+
+    MountPoint mount;
+    mount.Root     = absolute.lexically_normal();
+    mount.Key      = MakeKey(mount.Root);
+    mount.MaxDepth = maxDepth;
+
+    if (mount.Key.back() != '/')
+    { mount.Key += '/'; }
+
+    std::lock_guard<std::mutex> locker(m_UpdateMutex);
+
+    auto pCurrent = GetSnapshot();
+    for (auto& item : pCurrent->Mounts)
+    {
+        if (item.Key == mount.Key)
+        { return true; }
+    }
+
+    auto pSnapshot = std::make_shared<Snapshot>(*pCurrent);
+    pSnapshot->Mounts.push_back(mount);
+    Scan(mount, *pSnapshot);
+
+    SetSnapshot(std::move(pSnapshot));
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+//      全てのマウントを解除します.
+//-----------------------------------------------------------------------------
+void VirtualFileSystem::UnmountAll()
+{
+    std::lock_guard<std::mutex> locker(m_UpdateMutex);
+    SetSnapshot(std::make_shared<Snapshot>());
+}
+
+//-----------------------------------------------------------------------------
+//      全てのマウントポイントを走査し直します.
+//-----------------------------------------------------------------------------
+void VirtualFileSystem::Refresh()
+{
+    std::lock_guard<std::mutex> locker(m_UpdateMutex);
+
+    auto pSnapshot = std::make_shared<Snapshot>();
+    pSnapshot->Mounts = GetSnapshot()->Mounts;
+
+    for (auto& mount : pSnapshot->Mounts)
+    { Scan(mount, *pSnapshot); }
+
+    SetSnapshot(std::move(pSnapshot));
+}
+
+//-----------------------------------------------------------------------------
+//      ディレクトリの監視を開始します.
+//-----------------------------------------------------------------------------
+void VirtualFileSystem::StartWatch(uint32_t intervalMs)
+{
+    StopWatch();
+
+    m_WatchStop   = false;
+    m_WatchThread = std::thread(&VirtualFileSystem::WatchThread, this, std::max(intervalMs, 1u));
+}
+
+//-----------------------------------------------------------------------------
+//      ディレクトリの監視を終了します.
+//-----------------------------------------------------------------------------
+void VirtualFileSystem::StopWatch()
+{
+    if (!m_WatchThread.joinable())
+    { return; }
+
+    {
+        std::lock_guard<std::mutex> locker(m_WatchMutex);
+        m_WatchStop = true;
+    }
+    m_WatchCondition.notify_all();
+    m_WatchThread.join();
+}
+
+//-----------------------------------------------------------------------------
+//      ファイルパスを解決します.
+//-----------------------------------------------------------------------------
+bool VirtualFileSystem::Resolve(const std::filesystem::path& name, std::filesystem::path& result) const
+{
+    if (name.empty())
+    { return false; }
+
+    auto pSnapshot = GetSnapshot();
+    auto& files    = pSnapshot->Files;
+
+    if (name.is_absolute())
+    {
+        auto itr = files.find(MakeKey(name));
+        if (itr == files.end())
+        { return false; }
+
+        result = itr->second;
+        return true;
+    }
+
+    // 正規化した相対パスはマウントポイントのキーに連結するだけでキーになる.
+    // 親ディレクトリやルートを含む場合は連結してから正規化し直す.
+    auto relative = MakeKey(name);
+    auto concat   = !name.has_root_path() && relative.compare(0, 2, "..") != 0;
+
+    std::string key;
+    for (auto& mount : pSnapshot->Mounts)
+    {
+        if (concat)
+        { key.assign(mount.Key).append(relative); }
+        else
+        { key = MakeKey(mount.Root / name); }
+
+        auto itr = files.find(key);
+        if (itr != files.end())
+        {
+            result = itr->second;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+//-----------------------------------------------------------------------------
+//      ファイルパスを解決します(ワイド文字列版).
+//-----------------------------------------------------------------------------
+bool VirtualFileSystem::Resolve(const wchar_t* name, std::wstring& result) const
+{
+    if (name == nullptr)
+    { return false; }
+
+    std::filesystem::path path;
+    if (!Resolve(std::filesystem::path(name), path))
+    { return false; }
+
+    result = path.wstring();
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+//      ファイルパスを解決します(UTF-8版).
+//-----------------------------------------------------------------------------
+bool VirtualFileSystem::Resolve(const char* name, std::string& result) const
+{
+    if (name == nullptr)
+    { return false; }
+
+    std::filesystem::path path;
+    if (!Resolve(std::filesystem::u8path(name), path))
+    { return false; }
+
+    auto utf8 = path.u8string();
+    result.assign(utf8.begin(), utf8.end());
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+//      マウントポイント数を取得します.
+//-----------------------------------------------------------------------------
+size_t VirtualFileSystem::GetMountCount() const
+{ return GetSnapshot()->Mounts.size(); }
+
+//-----------------------------------------------------------------------------
+//      索引に登録されたファイル数を取得します.
+//-----------------------------------------------------------------------------
+size_t VirtualFileSystem::GetFileCount() const
+{ return GetSnapshot()->Files.size(); }
+
+//-----------------------------------------------------------------------------
+//      現在の索引を取得します.
+//-----------------------------------------------------------------------------
+std::shared_ptr<const VirtualFileSystem::Snapshot> VirtualFileSystem::GetSnapshot() const
+{
+    std::lock_guard<std::mutex> locker(m_Mutex);
+    return m_pSnapshot;
+}
+
+//-----------------------------------------------------------------------------
+//      索引を差し替えます.
+//-----------------------------------------------------------------------------
+void VirtualFileSystem::SetSnapshot(std::shared_ptr<const Snapshot> pSnapshot)
+{
+    std::lock_guard<std::mutex> locker(m_Mutex);
+    m_pSnapshot = std::move(pSnapshot);
+}
+
+//-----------------------------------------------------------------------------
+//      ディレクトリが変更されたかどうかを調べます.
+//-----------------------------------------------------------------------------
+bool VirtualFileSystem::IsModified(const Snapshot& snapshot)
+{
+    // ファイルの追加, 削除, 名前変更は親ディレクトリの更新時刻に反映される.
+    for (auto& item : snapshot.Directories)
+    {
+        std::error_code ec;
+        auto time = std::filesystem::last_write_time(item.Path, ec);
+        if (ec || time != item.Time)
+        { return true; }
+    }
+
+    return false;
+}
+
+//-----------------------------------------------------------------------------
+//      マウントポイントを走査して索引に追加します.
+//-----------------------------------------------------------------------------
+void VirtualFileSystem::Scan(const MountPoint& mount, Snapshot& snapshot)
+{
+    struct Item
+    {
+        std::filesystem::path   Path;
+        uint32_t                Depth;
+    };
+
+    std::vector<Item> stack;
+    stack.push_back({ mount.Root, 0 });
+
+    uint32_t count = 0;
+    while (!stack.empty() && count < MaxFilesPerMount)
+    {
+        auto item = std::move(stack.back());
+        stack.pop_back();
+
+        std::error_code ec;
+        DirectoryStamp stamp;
+        stamp.Path = item.Path;
+        stamp.Time = std::filesystem::last_write_time(item.Path, ec);
+        snapshot.Directories.push_back(stamp);
+
+        auto options = std::filesystem::directory_options::skip_permission_denied;
+        for (auto itr = std::filesystem::directory_iterator(item.Path, options, ec);
+             !ec && itr != std::filesystem::directory_iterator();
+             itr.increment(ec))
+        {
+            auto& path = itr->path();
+            auto  name = path.filename().native();
+
+            // 隠しディレクトリ(.git, .vs など)は対象外.
+            if (!name.empty() && name[0] == '.')
+            { continue; }
+
+            std::error_code ecType;
+            if (itr->is_directory(ecType))
+            {
+                if (item.Depth + 1 <= mount.MaxDepth && !itr->is_symlink(ecType))
+                { stack.push_back({ path, item.Depth + 1 }); }
+                continue;
+            }
+
+            if (!itr->is_regular_file(ecType))
+            { continue; }
+
+            snapshot.Files.emplace(MakeKey(path), path);
+            if (++count >= MaxFilesPerMount)
+            { break; }
+        }
+    }
+}
+
+//-----------------------------------------------------------------------------
+//      索引のキーを生成します.
+//-----------------------------------------------------------------------------
+std::string VirtualFileSystem::MakeKey(const std::filesystem::path& path)
+{
+    auto utf8 = path.lexically_normal().generic_u8string();
+    std::string key(utf8.begin(), utf8.end());
+
+    // 末尾の区切り文字は除く.
+    while (key.size() > 1 && key.back() == '/')
+    { key.pop_back(); }
+
+#if defined(_WIN32)
+    // Windows のファイルシステムは大文字と小文字を区別しない.
+    for (auto& c : key)
+    {
+        if ('A' <= c && c <= 'Z')
+        { c = char(c - 'A' + 'a'); }
+    }
+#endif
+
+    return key;
+}
+
+//-----------------------------------------------------------------------------
+//      監視スレッドの処理です.
+//-----------------------------------------------------------------------------
+void VirtualFileSystem::WatchThread(uint32_t intervalMs)
+{
+    for (;;)
+    {
+        {
+            std::unique_lock<std::mutex> locker(m_WatchMutex);
+            if (m_WatchCondition.wait_for(locker, std::chrono::milliseconds(intervalMs), [this]() { return m_WatchStop; }))
+            { return; }
+        }
+
+        if (IsModified(*GetSnapshot()))
+        { Refresh(); }
+    }
+}
@@ -1,9 +1,12 @@
-#if defined(DEBUG) || defined(_DEBUG) 
+﻿#if defined(DEBUG) || defined(_DEBUG) 
 #define _CRTDBG_MAP_ALLOC 
 #include <crtdbg.h> 
 #endif //defined(DEBUG) || defined(_DEBUG)
 
-#include "App.h"
+#include "SampleApp.h"
+#include "Benchmark.h"
+#include "AsyncLogger.h"
+#include <cstdio>
 
 int wmain(int argc, wchar_t** argv, wchar_t** evnp) {
 
@@ -11,7 +14,23 @@ int wmain(int argc, wchar_t** argv, wchar_t** evnp) {
 	_CrtSetDbgFlag( _CRTDBG_ALLOC_MEM_DF | _CRTDBG_LEAK_CHECK_DF ); 
 #endif//defined(DEBUG) ll defined(_DEBUG)
 
-	App app(960, 540);
+	// コマンドライン引数(-benchmark など)を読み取る
+	BenchmarkSettings benchmark;
+	if (!ParseBenchmarkArgs(argc, argv, benchmark)) {
+		printf("%s", GetBenchmarkUsage());
+		return 1;
+	}
+
+	// ベンチマークは指定解像度, 通常は 960x540 で起動
+	auto width = benchmark.Enable ? benchmark.Width : 960u;
+	auto height = benchmark.Enable ? benchmark.Height : 540u;
+
+	// 描画中のエラーログはバックグラウンドスレッドで書き出す(異常終了時も残りを書き出す)
+	GetAsyncLogger().Init("SampleApp.log");
+
+	SampleApp app(width, height, benchmark);
 	app.Run();
+
+	GetAsyncLogger().Term();
 	return 0;
-}
\ No newline at end of file
+}
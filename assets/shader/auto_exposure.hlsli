@@ -0,0 +1,50 @@
+//-----------------------------------------------------------------------------
+// File : auto_exposure.hlsli
+// Desc : Auto Exposure Common Definitions.
+// Copyright(c) Pocol. All right reserved.
+//-----------------------------------------------------------------------------
+#ifndef AUTO_EXPOSURE_HLSLI
+#define AUTO_EXPOSURE_HLSLI
+
+//-----------------------------------------------------------------------------
+// Constant Values. (AutoExposureCPU.h ƈv邱)
+//-----------------------------------------------------------------------------
+#define EXPOSURE_BIN_COUNT          256
+#define EXPOSURE_BINS_PER_OCTAVE    16
+#define EXPOSURE_BIN_SHIFT          19
+#define EXPOSURE_EV_ONE             4096
+#define EXPOSURE_RATE_SHIFT         12
+#define EXPOSURE_FLAG_ENABLE        0x1
+#define EXPOSURE_FLAG_RESET         0x2
+
+///////////////////////////////////////////////////////////////////////////////
+// ExposureState structure
+///////////////////////////////////////////////////////////////////////////////
+struct ExposureState
+{
+    int     EV;                     // ݂̘Il(Œ菬).
+    int     TargetEV;               // ڕW̘Il(Œ菬).
+    int     AverageLogLuminance;    // ϋPx log2 (Œ菬).
+    float   Exposure;               // g[}bvŏZI(= 2^EV).
+};
+
+//-----------------------------------------------------------------------------
+//      sNZ̃qXgÕrԍ߂܂.
+//-----------------------------------------------------------------------------
+uint GetExposureBin(float3 color, uint minLuminanceBits)
+{
+    // CPUQƎƈv邽, Ϙa̗Z֎~ĉZŒ肷.
+    precise float r = color.r * 0.2126f;
+    precise float g = color.g * 0.7152f;
+    precise float b = color.b * 0.0722f;
+    precise float L = (r + g) + b;
+
+    // ŏPxȉ( NaN)͐擪̃r.
+    if (!(L > asfloat(minLuminanceBits)))
+    { return 0; }
+
+    // ̃̕rbg log2 ̋敪`ߎɂȂĂ.
+    return min((asuint(L) - minLuminanceBits) >> EXPOSURE_BIN_SHIFT, EXPOSURE_BIN_COUNT - 1);
+}
+
+#endif//AUTO_EXPOSURE_HLSLI
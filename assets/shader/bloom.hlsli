@@ -0,0 +1,47 @@
+//-----------------------------------------------------------------------------
+// File : bloom.hlsli
+// Desc : Bloom Common Definitions.
+// Copyright(c) Pocol. All right reserved.
+//-----------------------------------------------------------------------------
+#ifndef BLOOM_HLSLI
+#define BLOOM_HLSLI
+
+//-----------------------------------------------------------------------------
+// Constant Values. (Bloom.cpp ƈv邱)
+//-----------------------------------------------------------------------------
+#define BLOOM_FLAG_PREFILTER    0x1     // I|ĂlKp.
+#define BLOOM_FLAG_HQ           0x2     // 13^bv̏k 3x3 eg̊g.
+#define BLOOM_FLAG_KARIS        0x4     // Karis ςł}.
+#define BLOOM_GROUP_SIZE        8       // XbhO[ṽTCY.
+
+//-----------------------------------------------------------------------------
+// Resources
+//-----------------------------------------------------------------------------
+cbuffer CbBloom : register(b0)
+{
+    uint2   DstSize;        // o͂̑傫.
+    float2  InvDstSize;     // o͂̑傫̋t.
+    float2  InvSrcSize;     // ͂̑傫̋t.
+    float   Threshold;      // l.
+    float   Knee;           // lt߂Ȃ߂炩ɂ镝.
+    float   Scatter;        // g厞ɉ̒i銄.
+    uint    Flags;          // BLOOM_FLAG ̑gݍ킹.
+    float2  SrcUVScale;     // ̗͂Lȗ̈̊(I𑜓x).
+};
+
+Texture2D<float4>   Source      : register(t0);
+SamplerState        LinearSmp   : register(s0);
+
+//-----------------------------------------------------------------------------
+//      ͂oCjAœǂݍ݂܂.
+//-----------------------------------------------------------------------------
+float3 FetchSource(float2 uv)
+{
+    // Tv[̓bvȂ̂, [̃eNZ̒SŎ~߂ĔΑȂ悤ɂ.
+    // uv ͗Lȗ̈ɑ΂WȂ̂, ~߂ĂeNX`Ŝ̍Wɒ.
+    float2 halfTexel = 0.5f * InvSrcSize;
+    uv = clamp(uv, halfTexel, 1.0f - halfTexel);
+    return Source.SampleLevel(LinearSmp, uv * SrcUVScale, 0.0f).rgb;
+}
+
+#endif // BLOOM_HLSLI
@@ -0,0 +1,98 @@
+//-----------------------------------------------------------------------------
+// File : bloom_downsample_c.hlsl
+// Desc : Bloom Downsample Compute Shader.
+// Copyright(c) Pocol. All right reserved.
+//-----------------------------------------------------------------------------
+#include "auto_exposure.hlsli"
+#include "bloom.hlsli"
+
+//-----------------------------------------------------------------------------
+// Resources
+//-----------------------------------------------------------------------------
+StructuredBuffer<ExposureState> Exposure    : register(t1);
+RWTexture2D<float3>             Dest        : register(u0);
+
+//-----------------------------------------------------------------------------
+//      Karis ς̏d݂߂܂.
+//-----------------------------------------------------------------------------
+float KarisWeight(float3 color)
+{ return 1.0f / (1.0f + dot(color, float3(0.2126f, 0.7152f, 0.0722f))); }
+
+//-----------------------------------------------------------------------------
+//      2x2 ̃O[v̕ς߂܂.
+//-----------------------------------------------------------------------------
+float3 Average(float3 a, float3 b, float3 c, float3 d, bool karis)
+{
+    if (karis)
+    {
+        float wa = KarisWeight(a);
+        float wb = KarisWeight(b);
+        float wc = KarisWeight(c);
+        float wd = KarisWeight(d);
+        return (a * wa + b * wb + c * wc + d * wd) / (wa + wb + wc + wd);
+    }
+
+    return (a + b + c + d) * 0.25f;
+}
+
+//-----------------------------------------------------------------------------
+//      lKp܂(\tgj[).
+//-----------------------------------------------------------------------------
+float3 Prefilter(float3 color)
+{
+    float brightness = max(color.r, max(color.g, color.b));
+    float soft = clamp(brightness - Threshold + Knee, 0.0f, 2.0f * Knee);
+    soft = (soft * soft) / (4.0f * Knee + 1e-5f);
+
+    float contribution = max(soft, brightness - Threshold) / max(brightness, 1e-5f);
+    return color * contribution;
+}
+
+//-----------------------------------------------------------------------------
+//      CGg[|Cgł.
+//-----------------------------------------------------------------------------
+[numthreads(BLOOM_GROUP_SIZE, BLOOM_GROUP_SIZE, 1)]
+void main(uint3 dispatchId : SV_DispatchThreadID)
+{
+    if (any(dispatchId.xy >= DstSize))
+    { return; }
+
+    float2 uv = (float2(dispatchId.xy) + 0.5f) * InvDstSize;
+    float3 color;
+
+    if (Flags & BLOOM_FLAG_HQ)
+    {
+        // 13^bv̏k(Jimenez 2014).  2x2 dăGCAVO}.
+        float2 t = InvSrcSize;
+        float3 a = FetchSource(uv + t * float2(-2.0f, -2.0f));
+        float3 b = FetchSource(uv + t * float2( 0.0f, -2.0f));
+        float3 c = FetchSource(uv + t * float2( 2.0f, -2.0f));
+        float3 d = FetchSource(uv + t * float2(-1.0f, -1.0f));
+        float3 e = FetchSource(uv + t * float2( 1.0f, -1.0f));
+        float3 f = FetchSource(uv + t * float2(-2.0f,  0.0f));
+        float3 g = FetchSource(uv);
+        float3 h = FetchSource(uv + t * float2( 2.0f,  0.0f));
+        float3 i = FetchSource(uv + t * float2(-1.0f,  1.0f));
+        float3 j = FetchSource(uv + t * float2( 1.0f,  1.0f));
+        float3 k = FetchSource(uv + t * float2(-2.0f,  2.0f));
+        float3 l = FetchSource(uv + t * float2( 0.0f,  2.0f));
+        float3 m = FetchSource(uv + t * float2( 2.0f,  2.0f));
+
+        bool karis = (Flags & BLOOM_FLAG_KARIS) != 0;
+        color  = Average(d, e, i, j, karis) * 0.5f;
+        color += Average(a, b, f, g, karis) * 0.125f;
+        color += Average(b, c, g, h, karis) * 0.125f;
+        color += Average(f, g, k, l, karis) * 0.125f;
+        color += Average(g, h, l, m, karis) * 0.125f;
+    }
+    else
+    {
+        // 2x2 ̒SoCjAœǂ߂ΔtB^ɂȂ.
+        color = FetchSource(uv);
+    }
+
+    if (Flags & BLOOM_FLAG_PREFILTER)
+    { color = Prefilter(color * Exposure[0].Exposure); }
+
+    Dest[dispatchId.xy] = color;
+}
@@ -0,0 +1,49 @@
+//-----------------------------------------------------------------------------
+// File : bloom_upsample_c.hlsl
+// Desc : Bloom Upsample Compute Shader.
+// Copyright(c) Pocol. All right reserved.
+//-----------------------------------------------------------------------------
+#include "bloom.hlsli"
+
+//-----------------------------------------------------------------------------
+// Resources
+//-----------------------------------------------------------------------------
+Texture2D<float4>       Current : register(t2);     // 傫̏k.
+RWTexture2D<float3>     Dest    : register(u0);
+
+//-----------------------------------------------------------------------------
+//      CGg[|Cgł.
+//-----------------------------------------------------------------------------
+[numthreads(BLOOM_GROUP_SIZE, BLOOM_GROUP_SIZE, 1)]
+void main(uint3 dispatchId : SV_DispatchThreadID)
+{
+    if (any(dispatchId.xy >= DstSize))
+    { return; }
+
+    float2 uv = (float2(dispatchId.xy) + 0.5f) * InvDstSize;
+    float3 lower;
+
+    if (Flags & BLOOM_FLAG_HQ)
+    {
+        // ̒ĩeNZPʂ 3x3 egtB^.
+        float2 t = InvSrcSize;
+        lower  = FetchSource(uv + t * float2(-1.0f, -1.0f));
+        lower += FetchSource(uv + t * float2( 0.0f, -1.0f)) * 2.0f;
+        lower += FetchSource(uv + t * float2( 1.0f, -1.0f));
+        lower += FetchSource(uv + t * float2(-1.0f,  0.0f)) * 2.0f;
+        lower += FetchSource(uv)                             * 4.0f;
+        lower += FetchSource(uv + t * float2( 1.0f,  0.0f)) * 2.0f;
+        lower += FetchSource(uv + t * float2(-1.0f,  1.0f));
+        lower += FetchSource(uv + t * float2( 0.0f,  1.0f)) * 2.0f;
+        lower += FetchSource(uv + t * float2( 1.0f,  1.0f));
+        lower *= 1.0f / 16.0f;
+    }
+    else
+    {
+        lower = FetchSource(uv);
+    }
+
+    // iƂ̖邳ςȂ悤`Ԃō.
+    float3 current = Current.Load(int3(dispatchId.xy, 0)).rgb;
+    Dest[dispatchId.xy] = lerp(current, lower, Scatter);
+}
@@ -0,0 +1,143 @@
+//-----------------------------------------------------------------------------
+// File : clustered_lighting.hlsli
+// Desc : Clustered Forward Lighting Common Definitions.
+// Copyright(c) Pocol. All right reserved.
+//-----------------------------------------------------------------------------
+#ifndef CLUSTERED_LIGHTING_HLSLI
+#define CLUSTERED_LIGHTING_HLSLI
+
+//-----------------------------------------------------------------------------
+// Constant Values. (LightClusterCPU.h ƈv邱)
+//-----------------------------------------------------------------------------
+#define CLUSTER_COUNT_X         16
+#define CLUSTER_COUNT_Y         9
+#define CLUSTER_COUNT_Z         24
+#define CLUSTER_MAX_LIGHTS      256
+#define CLUSTER_LIGHT_POINT     0
+#define CLUSTER_LIGHT_SPOT      1
+
+///////////////////////////////////////////////////////////////////////////////
+// ClusterLight structure
+///////////////////////////////////////////////////////////////////////////////
+struct ClusterLight
+{
+    float3  Position;       // ʒu([h).
+    float   Range;          // e͈͂̔a.
+    float3  Color;          // F.
+    float   Intensity;      // x.
+    float3  Direction;      // X|bgCǧ.
+    float   SpotCosOuter;   // X|bgCg̊O̊px̗].
+    float   SpotCosInner;   // X|bgCg̓̊px̗].
+    uint    Type;           // CLUSTER_LIGHT_POINT ܂ CLUSTER_LIGHT_SPOT.
+    float2  Reserved;       // \̈.
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// ClusterRange structure
+///////////////////////////////////////////////////////////////////////////////
+struct ClusterRange
+{
+    uint    Offset;         // CgԍXg̐擪.
+    uint    Count;          // Cg.
+};
+
+//-----------------------------------------------------------------------------
+//      [xXCXԍ߂܂.
+//-----------------------------------------------------------------------------
+uint GetClusterSlice(float depth, float nearZ, float logDepthScale, float logDepthBias)
+{
+    if (!(depth > nearZ))
+    { return 0; }
+
+    int slice = int(floor(log(depth) * logDepthScale - logDepthBias));
+    return uint(clamp(slice, 0, CLUSTER_COUNT_Z - 1));
+}
+
+//-----------------------------------------------------------------------------
+//      XCX̎O̐[x߂܂.
+//-----------------------------------------------------------------------------
+float GetClusterSliceDepth(uint slice, float nearZ, float farZ, float logDepthScale, float logDepthBias)
+{
+    if (slice == 0)
+    { return nearZ; }
+    if (slice >= CLUSTER_COUNT_Z)
+    { return farZ; }
+
+    return exp((float(slice) + logDepthBias) / logDepthScale);
+}
+
+//-----------------------------------------------------------------------------
+//      sNZʒuƐ[xNX^[ԍ߂܂.
+//
+//      pixel ̓r[|[g̍_Ƃ SV_Position.xy ł.
+//-----------------------------------------------------------------------------
+uint GetClusterIndex
+(
+    float2  pixel,
+    float   depth,
+    float2  viewportSize,
+    float   nearZ,
+    float   logDepthScale,
+    float   logDepthBias
+)
+{
+    uint2 tile = min(uint2(pixel / viewportSize * float2(CLUSTER_COUNT_X, CLUSTER_COUNT_Y)),
+                     uint2(CLUSTER_COUNT_X - 1, CLUSTER_COUNT_Y - 1));
+    uint  slice = GetClusterSlice(depth, nearZ, logDepthScale, logDepthBias);
+    return (slice * CLUSTER_COUNT_Y + tile.y) * CLUSTER_COUNT_X + tile.x;
+}
+
+//-----------------------------------------------------------------------------
+//      Cg̋E[hԂŋ߂܂.
+//-----------------------------------------------------------------------------
+void GetClusterLightSphere(ClusterLight light, out float3 center, out float radius)
+{
+    center = light.Position;
+    radius = light.Range;
+
+    if (light.Type != CLUSTER_LIGHT_SPOT)
+    { return; }
+
+    // ~͂ދ. L~͒ʂ̉~, ~͒_ƒʂ̉~ʂ鋅.
+    float cosAngle = saturate(light.SpotCosOuter);
+    float offset;
+    if (cosAngle < 0.70710678f)
+    {
+        offset = light.Range * cosAngle;
+        radius = light.Range * sqrt(1.0f - cosAngle * cosAngle);
+    }
+    else
+    {
+        offset = light.Range * 0.5f / cosAngle;
+        radius = offset;
+    }
+
+    center += light.Direction * offset;
+}
+
+//-----------------------------------------------------------------------------
+//      Cg̕ˋPx߂܂.
+//
+//      L ɂ̓Cgւ̐Kς݂̕܂. e͈͂̊Oł0Ԃ܂.
+//-----------------------------------------------------------------------------
+float3 EvaluateClusterLight(ClusterLight light, float3 worldPos, out float3 L)
+{
+    float3 toLight = light.Position - worldPos;
+    float  distSq  = dot(toLight, toLight);
+    L = toLight * rsqrt(max(distSq, 1e-8f));
+
+    // t2̌e͈͂Ŋ炩0ɂ.
+    float ratio  = distSq / (light.Range * light.Range);
+    float window = saturate(1.0f - ratio * ratio);
+    float atten  = window * window / max(distSq, 1e-4f);
+
+    if (light.Type == CLUSTER_LIGHT_SPOT)
+    {
+        float cosAngle = dot(-L, light.Direction);
+        atten *= smoothstep(light.SpotCosOuter, light.SpotCosInner, cosAngle);
+    }
+
+    return light.Color * (light.Intensity * atten);
+}
+
+#endif//CLUSTERED_LIGHTING_HLSLI
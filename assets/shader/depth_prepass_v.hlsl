@@ -0,0 +1,42 @@
+//-----------------------------------------------------------------------------
+// File : depth_prepass_v.hlsl
+// Desc : Depth Pre-Pass Vertex Shader.
+// Copyright(c) Pocol. All right reserved.
+//-----------------------------------------------------------------------------
+
+///////////////////////////////////////////////////////////////////////////////
+// VSInput structure
+///////////////////////////////////////////////////////////////////////////////
+struct VSInput
+{
+    float3 Position : POSITION;     // ʒuWł(ʒu̒_Xg[).
+};
+
+//-----------------------------------------------------------------------------
+// Resources
+//-----------------------------------------------------------------------------
+cbuffer Transform : register(b0)
+{
+    float4x4 View : packoffset(c0);     // r[sł.
+    float4x4 Proj : packoffset(c4);     // ˉesł.
+};
+
+cbuffer Mesh : register(b1)
+{
+    float4x4 World : packoffset(c0);    // [hsł.
+};
+
+//-----------------------------------------------------------------------------
+//      CGg[|Cgł.
+//-----------------------------------------------------------------------------
+float4 main(VSInput input) : SV_POSITION
+{
+    // V[̒_VF[_Ɠŕϊ, œKɂ鉉Z̕ύX precise ŋ֎~.
+    // V[ LESS_EQUAL Ŕr邽, V[̐[xȉłΕ`悳.
+    float4 localPos = float4(input.Position, 1.0f);
+    float4 worldPos = mul(World, localPos);
+    float4 viewPos  = mul(View,  worldPos);
+    precise float4 projPos = mul(Proj, viewPos);
+
+    return projPos;
+}
@@ -0,0 +1,97 @@
+//-----------------------------------------------------------------------------
+// File : exposure_adapt_c.hlsl
+// Desc : Exposure Adaptation Compute Shader.
+// Copyright(c) Pocol. All right reserved.
+//-----------------------------------------------------------------------------
+#include "auto_exposure.hlsli"
+
+//-----------------------------------------------------------------------------
+// Resources
+//-----------------------------------------------------------------------------
+cbuffer CbExposure : register(b0)
+{
+    uint    Width;              // ͉摜̉.
+    uint    Height;             // ͉摜̏c.
+    uint    MinLuminanceBits;   // qXgO̍ŏPx̃rbg.
+    uint    LowCount;           // ς珜OẪsNZ.
+    uint    HighCount;          // ςɊ܂߂閾邢̏̃sNZ.
+    int     MinLogLuminance;    // qXgO̍ŏPx log2 (Œ菬).
+    int     KeyLogValue;        // L[lƕ␳l log2 (Œ菬).
+    int     MinEV;              // Il̉(Œ菬).
+    int     MaxEV;              // Il̏(Œ菬).
+    int     RateToDark;         // Ïւ̏(Œ菬).
+    int     RateToLight;        // ւ̏(Œ菬).
+    uint    Flags;              // EXPOSURE_FLAG ̑gݍ킹.
+};
+
+RWStructuredBuffer<uint>            Histogram   : register(u0);
+RWStructuredBuffer<ExposureState>   Exposure    : register(u1);
+
+groupshared uint LocalHistogram[EXPOSURE_BIN_COUNT];
+
+//-----------------------------------------------------------------------------
+//      CGg[|Cgł.
+//-----------------------------------------------------------------------------
+[numthreads(EXPOSURE_BIN_COUNT, 1, 1)]
+void main(uint groupIndex : SV_GroupIndex)
+{
+    // ǂݎ玟̃t[̂߂ɃNAĂ.
+    LocalHistogram[groupIndex] = Histogram[groupIndex];
+    Histogram[groupIndex] = 0;
+    GroupMemoryBarrierWithGroupSync();
+
+    // 256ȓ1Xbhōs(AdaptExposure() Ɠ̐Z).
+    if (groupIndex != 0)
+    { return; }
+
+    ExposureState state = Exposure[0];
+    int target = state.TargetEV;
+
+    if (Flags & EXPOSURE_FLAG_ENABLE)
+    {
+        // ÂƖ邢Ԃ̕σr𐮐ŋ߂.
+        uint accum = 0;
+        uint count = 0;
+        uint sum   = 0;
+        for (uint i = 0; i < EXPOSURE_BIN_COUNT; ++i)
+        {
+            uint lo = max(accum, LowCount);
+            uint hi = min(accum + LocalHistogram[i], HighCount);
+            if (hi > lo)
+            {
+                count += hi - lo;
+                sum   += (hi - lo) * i;
+            }
+            accum += LocalHistogram[i];
+        }
+
+        if (count > 0)
+        {
+            // 1r = 1/16i. r̒S邽ߔr.
+            const uint scale = EXPOSURE_EV_ONE / EXPOSURE_BINS_PER_OCTAVE;
+            int averageBin = int((sum / count) * scale + ((sum % count) * scale) / count + scale / 2);
+
+            state.AverageLogLuminance = MinLogLuminance + averageBin;
+            target = KeyLogValue - state.AverageLogLuminance;
+        }
+    }
+    else
+    {
+        target = KeyLogValue;
+    }
+
+    target = clamp(target, MinEV, MaxEV);
+    state.TargetEV = target;
+
+    if (Flags & EXPOSURE_FLAG_RESET)
+    { state.EV = target; }
+    else
+    {
+        int diff = target - state.EV;
+        int rate = (diff > 0) ? RateToDark : RateToLight;
+        state.EV += (diff * rate) >> EXPOSURE_RATE_SHIFT;
+    }
+
+    state.Exposure = exp2(float(state.EV) / float(EXPOSURE_EV_ONE));
+    Exposure[0] = state;
+}
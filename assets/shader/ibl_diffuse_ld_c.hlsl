@@ -0,0 +1,37 @@
+//-----------------------------------------------------------------------------
+// File : ibl_diffuse_ld_c.hlsl
+// Desc : Diffuse LD Integration Compute Shader (One Face Per Dispatch).
+// Copyright(c) Pocol. All right reserved.
+//-----------------------------------------------------------------------------
+#include "ibl_ld.hlsli"
+
+//-----------------------------------------------------------------------------
+//      CGg[|Cgł.
+//-----------------------------------------------------------------------------
+[numthreads(IBL_LD_GROUP_SIZE, IBL_LD_GROUP_SIZE, 1)]
+void main(uint3 dispatchId : SV_DispatchThreadID)
+{
+    if (any(dispatchId.xy >= DstSize))
+    { return; }
+
+    float3 N = TexelToDirection(Face, dispatchId.xy, DstSize);
+    float3 T, B;
+    TangentBasis(N, T, B);
+
+    // RTCd݂ŏd_ITvO, o[g̐ϕ̓Tv̕ςɂȂ.
+    float3 sum = 0.0f;
+    for (uint i = 0; i < SampleCount; ++i)
+    {
+        float2 xi       = Hammersley(i, SampleCount);
+        float  phi      = 2.0f * IBL_PI * xi.x;
+        float  cosTheta = sqrt(1.0f - xi.y);
+        float  sinTheta = sqrt(xi.y);
+
+        float3 L = T * (sinTheta * cos(phi)) + B * (sinTheta * sin(phi)) + N * cosTheta;
+        float pdf = cosTheta / IBL_PI;
+
+        sum += FetchSource(L, pdf);
+    }
+
+    Dest[uint3(dispatchId.xy, Face)] = float4(sum / float(SampleCount), 1.0f);
+}
@@ -0,0 +1,83 @@
+//-----------------------------------------------------------------------------
+// File : ibl_ld.hlsli
+// Desc : IBL LD Integration Common Definitions.
+// Copyright(c) Pocol. All right reserved.
+//-----------------------------------------------------------------------------
+#ifndef IBL_LD_HLSLI
+#define IBL_LD_HLSLI
+
+//-----------------------------------------------------------------------------
+// Constant Values. (ProgressiveIBLBaker.cpp ƈv邱)
+//-----------------------------------------------------------------------------
+#define IBL_LD_GROUP_SIZE   8       // XbhO[ṽTCY.
+#define IBL_PI              3.14159265358979f
+
+//-----------------------------------------------------------------------------
+// Resources
+//-----------------------------------------------------------------------------
+cbuffer CbBakeUnit : register(b0)
+{
+    uint    Face;           // ޖʂ̔ԍ.
+    uint    DstSize;        // ރ~bv̑傫.
+    float   Roughness;      // tlX(ʔ˂̂).
+    uint    SampleCount;    // 1eNZ̃Tv.
+};
+
+TextureCube<float4>         Source      : register(t0);
+SamplerState                LinearSmp   : register(s0);
+RWTexture2DArray<float4>    Dest        : register(u0);
+
+//-----------------------------------------------------------------------------
+//      ʂƃeNZ̈ʒu߂܂.
+//-----------------------------------------------------------------------------
+float3 TexelToDirection(uint face, uint2 texel, uint size)
+{
+    float2 uv = (float2(texel) + 0.5f) / float(size) * 2.0f - 1.0f;
+
+    float3 dir;
+    switch (face)
+    {
+    case 0:  dir = float3( 1.0f, -uv.y, -uv.x); break;     // +X
+    case 1:  dir = float3(-1.0f, -uv.y,  uv.x); break;     // -X
+    case 2:  dir = float3( uv.x,  1.0f,  uv.y); break;     // +Y
+    case 3:  dir = float3( uv.x, -1.0f, -uv.y); break;     // -Y
+    case 4:  dir = float3( uv.x, -uv.y,  1.0f); break;     // +Z
+    default: dir = float3(-uv.x, -uv.y, -1.0f); break;     // -Z
+    }
+
+    return normalize(dir);
+}
+
+//-----------------------------------------------------------------------------
+//      Hammersley _߂܂.
+//-----------------------------------------------------------------------------
+float2 Hammersley(uint i, uint count)
+{ return float2(float(i) / float(count), float(reversebits(i)) * 2.3283064365386963e-10f); }
+
+//-----------------------------------------------------------------------------
+//      @ƂڋԂ̊߂܂.
+//-----------------------------------------------------------------------------
+void TangentBasis(float3 N, out float3 T, out float3 B)
+{
+    float3 up = (abs(N.z) < 0.999f) ? float3(0.0f, 0.0f, 1.0f) : float3(1.0f, 0.0f, 0.0f);
+    T = normalize(cross(up, N));
+    B = cross(N, T);
+}
+
+//-----------------------------------------------------------------------------
+//      mxɌ~bv͂ǂݍ݂܂.
+//-----------------------------------------------------------------------------
+float3 FetchSource(float3 dir, float pdf)
+{
+    uint width, height, mipCount;
+    Source.GetDimensions(0, width, height, mipCount);
+
+    // Tv1󂯎̊pƃeNZ1̗̊p̔䂩ǂރ~bv߂.
+    float saTexel  = 4.0f * IBL_PI / (6.0f * float(width) * float(width));
+    float saSample = 1.0f / (float(SampleCount) * pdf + 1e-4f);
+    float lod      = clamp(0.5f * log2(saSample / saTexel) + 1.0f, 0.0f, float(mipCount - 1));
+
+    return Source.SampleLevel(LinearSmp, dir, lod).rgb;
+}
+
+#endif // IBL_LD_HLSLI
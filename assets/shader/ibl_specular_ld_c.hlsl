@@ -0,0 +1,66 @@
+//-----------------------------------------------------------------------------
+// File : ibl_specular_ld_c.hlsl
+// Desc : Specular LD Integration Compute Shader (One Face Of One Mip Per Dispatch).
+// Copyright(c) Pocol. All right reserved.
+//-----------------------------------------------------------------------------
+#include "ibl_ld.hlsli"
+
+//-----------------------------------------------------------------------------
+//      GGX ̖@z֐ł.
+//-----------------------------------------------------------------------------
+float D_GGX(float NoH, float a2)
+{
+    float d = (NoH * a2 - NoH) * NoH + 1.0f;
+    return a2 / (IBL_PI * d * d);
+}
+
+//-----------------------------------------------------------------------------
+//      CGg[|Cgł.
+//-----------------------------------------------------------------------------
+[numthreads(IBL_LD_GROUP_SIZE, IBL_LD_GROUP_SIZE, 1)]
+void main(uint3 dispatchId : SV_DispatchThreadID)
+{
+    if (any(dispatchId.xy >= DstSize))
+    { return; }
+
+    float3 N = TexelToDirection(Face, dispatchId.xy, DstSize);
+
+    // tlX0Ȃ͂̂܂܎ʂ.
+    if (Roughness <= 0.0f)
+    {
+        Dest[uint3(dispatchId.xy, Face)] = float4(Source.SampleLevel(LinearSmp, N, 0.0f).rgb, 1.0f);
+        return;
+    }
+
+    float3 T, B;
+    TangentBasis(N, T, B);
+
+    float a  = Roughness * Roughness;
+    float a2 = a * a;
+
+    // @ƓƂ݂Ȃ GGX ŏd_ITvO(Karis 2013).
+    float3 sum    = 0.0f;
+    float  weight = 0.0f;
+    for (uint i = 0; i < SampleCount; ++i)
+    {
+        float2 xi       = Hammersley(i, SampleCount);
+        float  phi      = 2.0f * IBL_PI * xi.x;
+        float  cosTheta = sqrt((1.0f - xi.y) / (1.0f + (a2 - 1.0f) * xi.y));
+        float  sinTheta = sqrt(1.0f - cosTheta * cosTheta);
+
+        float3 H = T * (sinTheta * cos(phi)) + B * (sinTheta * sin(phi)) + N * cosTheta;
+        float3 L = 2.0f * dot(N, H) * H - N;
+
+        float NoL = saturate(dot(N, L));
+        if (NoL <= 0.0f)
+        { continue; }
+
+        // N = V Ȃ̂Ŋmx D * NoH / (4 * VoH) = D / 4.
+        float pdf = D_GGX(cosTheta, a2) * 0.25f;
+
+        sum    += FetchSource(L, pdf) * NoL;
+        weight += NoL;
+    }
+
+    Dest[uint3(dispatchId.xy, Face)] = float4(sum / max(weight, 1e-4f), 1.0f);
+}
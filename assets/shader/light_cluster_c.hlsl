@@ -0,0 +1,102 @@
+//-----------------------------------------------------------------------------
+// File : light_cluster_c.hlsl
+// Desc : Light To Cluster Assignment Compute Shader.
+// Copyright(c) Pocol. All right reserved.
+//-----------------------------------------------------------------------------
+#include "clustered_lighting.hlsli"
+
+//-----------------------------------------------------------------------------
+// Resources
+//-----------------------------------------------------------------------------
+cbuffer CbCluster : register(b0)
+{
+    float4x4    View;               // r[s.
+    float       ProjScaleX;         // ˉes _11.
+    float       ProjScaleY;         // ˉes _22.
+    float       NearZ;              // ŏ̃XCX̎O̐[x.
+    float       FarZ;               // Ō̃XCX̉̐[x.
+    float       LogDepthScale;      // [x̑ΐXCXԍւ̔{.
+    float       LogDepthBias;       // [x̑ΐXCXԍւ̃oCAX.
+    float       ViewportWidth;      // `悷鉡.
+    float       ViewportHeight;     // `悷c.
+    uint        LightCount;         // Cg.
+};
+
+StructuredBuffer<ClusterLight>      Lights          : register(t0);
+RWStructuredBuffer<ClusterRange>    ClusterRanges   : register(u0);
+RWStructuredBuffer<uint>            LightIndices    : register(u1);
+
+#define THREAD_COUNT    64
+
+groupshared uint LocalCount;
+groupshared uint LocalIndices[CLUSTER_MAX_LIGHTS];
+
+//-----------------------------------------------------------------------------
+//      CGg[|Cgł.
+//
+//      1O[v1NX^[S, SCgƃNX^[ AABB ׂ܂.
+//      Xg̓NX^[Ƃ CLUSTER_MAX_LIGHTS ̌Œ̗̈ɏ݂܂(l߂܂).
+//      𒴂͎̂Ă܂. ǂ̃Cgc邩̓Xbh̎sŌ܂, ԍł͂܂.
+//-----------------------------------------------------------------------------
+[numthreads(THREAD_COUNT, 1, 1)]
+void main(uint3 groupId : SV_GroupID, uint groupIndex : SV_GroupIndex)
+{
+    uint cluster = (groupId.z * CLUSTER_COUNT_Y + groupId.y) * CLUSTER_COUNT_X + groupId.x;
+
+    if (groupIndex == 0)
+    { LocalCount = 0; }
+
+    // NX^[ AABB (r[Ԃ x, y Ɛ[x).
+    float dn = GetClusterSliceDepth(groupId.z,     NearZ, FarZ, LogDepthScale, LogDepthBias);
+    float df = GetClusterSliceDepth(groupId.z + 1, NearZ, FarZ, LogDepthScale, LogDepthBias);
+
+    float2 ndc0 = float2(-1.0f + 2.0f * float(groupId.x)     / CLUSTER_COUNT_X,
+                          1.0f - 2.0f * float(groupId.y + 1) / CLUSTER_COUNT_Y);
+    float2 ndc1 = float2(-1.0f + 2.0f * float(groupId.x + 1) / CLUSTER_COUNT_X,
+                          1.0f - 2.0f * float(groupId.y)     / CLUSTER_COUNT_Y);
+
+    float2 invScale = 1.0f / float2(ProjScaleX, ProjScaleY);
+    float3 minBound = float3(min(ndc0 * dn, ndc0 * df) * invScale, dn);
+    float3 maxBound = float3(max(ndc1 * dn, ndc1 * df) * invScale, df);
+
+    GroupMemoryBarrierWithGroupSync();
+
+    for (uint base = 0; base < LightCount; base += THREAD_COUNT)
+    {
+        uint index = base + groupIndex;
+        if (index < LightCount)
+        {
+            float3 center;
+            float  radius;
+            GetClusterLightSphere(Lights[index], center, radius);
+
+            float3 viewPos = mul(View, float4(center, 1.0f)).xyz;
+            float3 p = float3(viewPos.xy, -viewPos.z);
+
+            float3 d = max(minBound - p, 0.0f) + max(p - maxBound, 0.0f);
+            if (radius > 0.0f && dot(d, d) <= radius * radius)
+            {
+                uint slot;
+                InterlockedAdd(LocalCount, 1, slot);
+                if (slot < CLUSTER_MAX_LIGHTS)
+                { LocalIndices[slot] = index; }
+            }
+        }
+    }
+
+    GroupMemoryBarrierWithGroupSync();
+
+    uint count  = min(LocalCount, CLUSTER_MAX_LIGHTS);
+    uint offset = cluster * CLUSTER_MAX_LIGHTS;
+
+    if (groupIndex == 0)
+    {
+        ClusterRange range;
+        range.Offset = offset;
+        range.Count  = count;
+        ClusterRanges[cluster] = range;
+    }
+
+    for (uint i = groupIndex; i < count; i += THREAD_COUNT)
+    { LightIndices[offset + i] = LocalIndices[i]; }
+}
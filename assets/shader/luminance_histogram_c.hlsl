@@ -0,0 +1,44 @@
+//-----------------------------------------------------------------------------
+// File : luminance_histogram_c.hlsl
+// Desc : Luminance Histogram Compute Shader.
+// Copyright(c) Pocol. All right reserved.
+//-----------------------------------------------------------------------------
+#include "auto_exposure.hlsli"
+
+//-----------------------------------------------------------------------------
+// Resources
+//-----------------------------------------------------------------------------
+cbuffer CbExposure : register(b0)
+{
+    uint    Width;              // ͉摜̉.
+    uint    Height;             // ͉摜̏c.
+    uint    MinLuminanceBits;   // qXgO̍ŏPx̃rbg.
+};
+
+Texture2D<float4>           SceneColor  : register(t0);
+RWStructuredBuffer<uint>    Histogram   : register(u0);
+
+groupshared uint LocalHistogram[EXPOSURE_BIN_COUNT];
+
+//-----------------------------------------------------------------------------
+//      CGg[|Cgł.
+//-----------------------------------------------------------------------------
+[numthreads(16, 16, 1)]
+void main(uint3 dispatchId : SV_DispatchThreadID, uint groupIndex : SV_GroupIndex)
+{
+    // Xbhƃr͓.
+    LocalHistogram[groupIndex] = 0;
+    GroupMemoryBarrierWithGroupSync();
+
+    if (dispatchId.x < Width && dispatchId.y < Height)
+    {
+        float3 color = SceneColor.Load(int3(dispatchId.xy, 0)).rgb;
+        InterlockedAdd(LocalHistogram[GetExposureBin(color, MinLuminanceBits)], 1);
+    }
+    GroupMemoryBarrierWithGroupSync();
+
+    // O[vŏWvĂO[oɉZ.
+    uint count = LocalHistogram[groupIndex];
+    if (count > 0)
+    { InterlockedAdd(Histogram[groupIndex], count); }
+}
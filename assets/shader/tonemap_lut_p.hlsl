@@ -0,0 +1,79 @@
+//-----------------------------------------------------------------------------
+// File : tonemap_lut_p.hlsl
+// Desc : Baked 3D LUT Tonemap Pixel Shader.
+// Copyright(c) Pocol. All right reserved.
+//-----------------------------------------------------------------------------
+#include "auto_exposure.hlsli"
+#include "upscale.hlsli"
+
+//-----------------------------------------------------------------------------
+// Constant Values. (TonemapCPU.cpp ƈv邱)
+//-----------------------------------------------------------------------------
+static const float MaxInput = 65504.0f;     // ͂̍ől.
+
+///////////////////////////////////////////////////////////////////////////////
+// VSOutput structure
+///////////////////////////////////////////////////////////////////////////////
+struct VSOutput
+{
+    float4 Position : SV_POSITION;
+    float2 TexCoord : TEXCOORD;
+};
+
+//-----------------------------------------------------------------------------
+// Resources
+//-----------------------------------------------------------------------------
+cbuffer CbTonemap : register(b0)
+{
+    int     Type;               // g[}bv^Cv(LUTɏĂݍς).
+    int     ColorSpace;         // o͐F(LUTɏĂݍς).
+    float   BaseLuminance;      // Pxl[nit](LUTɏĂݍς).
+    float   MaxLuminance;       // őPxl[nit](LUTɏĂݍς).
+    float4  LutShaper;          // ͕̒萔(TonemapLUTShaper).
+    float   BloomIntensity;     // u[̋.
+    float   Sharpness;          // g厞̃V[v̋.
+    float2  UVScale;            // V[J[̂`ς݂̗̈̊.
+    float2  InvSceneSize;       // V[J[̑傫̋t.
+};
+
+Texture2D                       ColorMap    : register(t0);
+StructuredBuffer<ExposureState> Exposure    : register(t1);
+Texture3D<float4>               TonemapLUT  : register(t2);
+Texture2D                       BloomMap    : register(t3);
+SamplerState                    ColorSmp    : register(s0);
+
+//-----------------------------------------------------------------------------
+//      u[ǂݍ݂܂.
+//-----------------------------------------------------------------------------
+float3 FetchBloom(float2 uv)
+{
+    // Tv[̓bvȂ̂, [̃eNZ̒SŎ~߂ĔΑȂ悤ɂ.
+    float2 size;
+    BloomMap.GetDimensions(size.x, size.y);
+    float2 halfTexel = 0.5f / size;
+    uv = clamp(uv, halfTexel, 1.0f - halfTexel);
+    return BloomMap.SampleLevel(ColorSmp, uv, 0.0f).rgb;
+}
+
+//-----------------------------------------------------------------------------
+//      CGg[|Cgł.
+//-----------------------------------------------------------------------------
+float4 main(VSOutput input) : SV_TARGET0
+{
+    // I𑜓xŏkĕ`V[g傷.
+    float4 result = SampleUpscaled(ColorMap, ColorSmp, input.TexCoord, UVScale, InvSceneSize, Sharpness);
+
+    // ILUT̊OŏZ.
+    float3 color = clamp(result.rgb * Exposure[0].Exposure, 0.0f, MaxInput);
+
+    // u[͘Iς݂Ȃ̂, ǏɉZ.
+    if (BloomIntensity > 0.0f)
+    { color = min(color + FetchBloom(input.TexCoord) * BloomIntensity, MaxInput); }
+
+    // log2(1 + x / ) ŕĂ, iq_̒SԔ͈͂Ɏʂ.
+    // W [0.5/N, 1 - 0.5/N] Ɏ܂̂, bṽTv[ł[Ȃ.
+    float3 u   = saturate(log2(1.0f + color * LutShaper.x) * LutShaper.y);
+    float3 uvw = u * LutShaper.z + LutShaper.w;
+
+    return float4(TonemapLUT.SampleLevel(ColorSmp, uvw, 0.0f).rgb, result.a);
+}
@@ -0,0 +1,152 @@
+//-----------------------------------------------------------------------------
+// File : tonemap_p.hlsl
+// Desc : Tonemap Pixel Shader.
+// Copyright(c) Pocol. All right reserved.
+//-----------------------------------------------------------------------------
+#include "auto_exposure.hlsli"
+#include "upscale.hlsli"
+
+//-----------------------------------------------------------------------------
+// Constant Values. (TonemapCPU.cpp ƈv邱)
+//-----------------------------------------------------------------------------
+#define TONEMAP_NONE            0
+#define TONEMAP_REINHARD        1
+#define TONEMAP_GT              2
+
+#define COLOR_SPACE_BT709       0
+#define COLOR_SPACE_BT2100_PQ   1
+
+static const float MaxInput = 65504.0f;     // ͂̍ől.
+static const float GT_A     = 1.0f;         // GTg[}bv̌X.
+static const float GT_M     = 0.22f;        // GTg[}bv̐`Ԃ̊Jn_.
+static const float GT_L     = 0.4f;         // GTg[}bv̐`Ԃ̒.
+static const float GT_C     = 1.33f;        // GTg[}bv̈Õ̋ȗ.
+static const float GT_B     = 0.0f;         // GTg[}bv̍x.
+
+// ITU-R BT.709  ITU-R BT.2020 ւ̕ϊs(ITU-R BT.2087).
+static const float3x3 Rec709ToRec2020 = {
+    0.627402f, 0.329292f, 0.043306f,
+    0.069095f, 0.919544f, 0.011360f,
+    0.016394f, 0.088028f, 0.895578f
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// VSOutput structure
+///////////////////////////////////////////////////////////////////////////////
+struct VSOutput
+{
+    float4 Position : SV_POSITION;
+    float2 TexCoord : TEXCOORD;
+};
+
+//-----------------------------------------------------------------------------
+// Resources
+//-----------------------------------------------------------------------------
+cbuffer CbTonemap : register(b0)
+{
+    int     Type;               // g[}bv^Cv.
+    int     ColorSpace;         // o͐F.
+    float   BaseLuminance;      // Pxl[nit].
+    float   MaxLuminance;       // őPxl[nit].
+    float4  LutShaper;          // ͕̒萔(̃VF[_ł͖gp).
+    float   BloomIntensity;     // u[̋.
+    float   Sharpness;          // g厞̃V[v̋.
+    float2  UVScale;            // V[J[̂`ς݂̗̈̊.
+    float2  InvSceneSize;       // V[J[̑傫̋t.
+};
+
+Texture2D                       ColorMap    : register(t0);
+StructuredBuffer<ExposureState> Exposure    : register(t1);
+Texture2D                       BloomMap    : register(t3);
+SamplerState                    ColorSmp    : register(s0);
+
+//-----------------------------------------------------------------------------
+//      u[ǂݍ݂܂.
+//-----------------------------------------------------------------------------
+float3 FetchBloom(float2 uv)
+{
+    // Tv[̓bvȂ̂, [̃eNZ̒SŎ~߂ĔΑȂ悤ɂ.
+    float2 size;
+    BloomMap.GetDimensions(size.x, size.y);
+    float2 halfTexel = 0.5f / size;
+    uv = clamp(uv, halfTexel, 1.0f - halfTexel);
+    return BloomMap.SampleLevel(ColorSmp, uv, 0.0f).rgb;
+}
+
+//-----------------------------------------------------------------------------
+//      Reinhardg[}bvł.
+//-----------------------------------------------------------------------------
+float3 Reinhard(float3 x, float k)
+{ return x * k / (x + k); }
+
+//-----------------------------------------------------------------------------
+//      GTg[}bvł(Uchimura 2017).
+//-----------------------------------------------------------------------------
+float3 GranTurismo(float3 x, float P)
+{
+    float l0 = ((P - GT_M) * GT_L) / GT_A;
+    float S0 = GT_M + l0;
+    float S1 = GT_M + GT_A * l0;
+    float C2 = (GT_A * P) / (P - S1);
+    float CP = -C2 / P;
+
+    float3 w0 = 1.0f - smoothstep(0.0f, GT_M, x);
+    float3 w2 = step(S0, x);
+    float3 w1 = 1.0f - w0 - w2;
+
+    // Õ x < m łgȂ̂, ȓ͂ŖɂȂȂ悤}.
+    float3 T = GT_M * pow(min(x, GT_M) / GT_M, GT_C) + GT_B;
+    float3 S = P - (P - S1) * exp(CP * (x - S0));
+    float3 L = GT_M + GT_A * (x - GT_M);
+
+    return T * w0 + L * w1 + S * w2;
+}
+
+//-----------------------------------------------------------------------------
+//      ST.2084 (PQ) ̓`B֐ł.
+//-----------------------------------------------------------------------------
+float3 LinearToST2084(float3 x)
+{
+    const float m1 = 2610.0f / 4096.0f / 4.0f;
+    const float m2 = 2523.0f / 4096.0f * 128.0f;
+    const float c1 = 3424.0f / 4096.0f;
+    const float c2 = 2413.0f / 4096.0f * 32.0f;
+    const float c3 = 2392.0f / 4096.0f * 32.0f;
+
+    float3 cp = pow(x, m1);
+    return pow((c1 + c2 * cp) / (1.0f + c3 * cp), m2);
+}
+
+//-----------------------------------------------------------------------------
+//      CGg[|Cgł.
+//-----------------------------------------------------------------------------
+float4 main(VSOutput input) : SV_TARGET0
+{
+    // I𑜓xŏkĕ`V[g傷.
+    float4 result = SampleUpscaled(ColorMap, ColorSmp, input.TexCoord, UVScale, InvSceneSize, Sharpness);
+
+    // IǒʂZ(CPUւ̓ǂݖ߂͍sȂ).
+    float3 color = clamp(result.rgb * Exposure[0].Exposure, 0.0f, MaxInput);
+
+    // u[͘Iς݂Ȃ̂, ǏɉZ.
+    if (BloomIntensity > 0.0f)
+    { color = min(color + FetchBloom(input.TexCoord) * BloomIntensity, MaxInput); }
+
+    float P = MaxLuminance / BaseLuminance;
+    if (Type == TONEMAP_REINHARD)
+    { color = Reinhard(color, P); }
+    else if (Type == TONEMAP_GT)
+    { color = GranTurismo(color, P); }
+
+    if (ColorSpace == COLOR_SPACE_BT2100_PQ)
+    {
+        color = mul(Rec709ToRec2020, color);
+        color = LinearToST2084(max(color * (BaseLuminance / 10000.0f), 0.0f));
+    }
+    else
+    {
+        color = pow(min(color, 1.0f), 1.0f / 2.2f);
+    }
+
+    return float4(color, result.a);
+}
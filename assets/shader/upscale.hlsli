@@ -0,0 +1,60 @@
+//-----------------------------------------------------------------------------
+// File : upscale.hlsli
+// Desc : Sharpening Upscale For Dynamic Resolution.
+// Copyright(c) Pocol. All right reserved.
+//-----------------------------------------------------------------------------
+#ifndef UPSCALE_HLSLI
+#define UPSCALE_HLSLI
+
+//-----------------------------------------------------------------------------
+// Constant Values.
+//-----------------------------------------------------------------------------
+static const float UpscaleMaxWeight = 0.2f;    // ͂̃^bv̏̕d݂̍ől.
+
+//-----------------------------------------------------------------------------
+//      ̈ꕔɕ`ꂽV[g債ēǂݍ݂܂.
+//
+//      uv          o͉ʂɑ΂W.
+//      uvScale     eNX`̂`ς݂̗̈̊.
+//      invSize     eNX`̑傫̋t.
+//      sharpness   V[v̋[0, 1](0Ȃʏ̃oCjA).
+//-----------------------------------------------------------------------------
+float4 SampleUpscaled
+(
+    Texture2D       map,
+    SamplerState    smp,
+    float2          uv,
+    float2          uvScale,
+    float2          invSize,
+    float           sharpness
+)
+{
+    // `ς݂̗̈̊O⃉bvΑȂ悤, [̃eNZ̒SŎ~߂.
+    float2 minUV = 0.5f * invSize;
+    float2 maxUV = uvScale - 0.5f * invSize;
+    float2 st    = clamp(uv * uvScale, minUV, maxUV);
+
+    float4 center = map.SampleLevel(smp, st, 0.0f);
+    if (sharpness <= 0.0f)
+    { return center; }
+
+    // \4^bvŋǏIȃRgXg𒲂, RȂƂقǋV[v(AMD CAS Ɠl).
+    float3 n = map.SampleLevel(smp, clamp(st + float2( 0.0f, -invSize.y), minUV, maxUV), 0.0f).rgb;
+    float3 s = map.SampleLevel(smp, clamp(st + float2( 0.0f,  invSize.y), minUV, maxUV), 0.0f).rgb;
+    float3 w = map.SampleLevel(smp, clamp(st + float2(-invSize.x,  0.0f), minUV, maxUV), 0.0f).rgb;
+    float3 e = map.SampleLevel(smp, clamp(st + float2( invSize.x,  0.0f), minUV, maxUV), 0.0f).rgb;
+
+    float3 minColor = min(center.rgb, min(min(n, s), min(w, e)));
+    float3 maxColor = max(center.rgb, max(max(n, s), max(w, e)));
+
+    // HDR̒lȂ̂, 邳Ɉ˂ȂŔ肷.
+    float3 amount = sqrt(saturate(minColor / max(maxColor, 1e-5f)));
+    float3 weight = -amount * (sharpness * UpscaleMaxWeight);
+
+    float3 color = (center.rgb + (n + s + w + e) * weight) / (1.0f + 4.0f * weight);
+
+    // ͈͂̔͂𒴂Ȃ悤ɂăMOh.
+    return float4(clamp(color, minColor, maxColor), center.a);
+}
+
+#endif // UPSCALE_HLSLI
@@ -43,6 +43,14 @@ project "D3D12Practice"
 		
 	}
 
+	-- Bundle every compiled shader into one indexed file mapped at startup.
+	dependson { "ShaderBundler" }
+
+	postbuildcommands
+	{
+		'"%{wks.location}bin/' .. outputdir .. '/ShaderBundler/ShaderBundler" "%{wks.location}shader_bin" "%{wks.location}shader_bin/shaders.bundle"',
+	}
+
 	filter "system:windows"
 		cppdialect "C++17"
 		staticruntime "On"
@@ -83,3 +91,839 @@ project "D3D12Practice"
    	removeflags "ExcludeFromBuild"
    	shadertype "Vertex"
 
+	filter { "files:**_c.hlsl" }
+   	removeflags "ExcludeFromBuild"
+   	shadertype "Compute"
+
+
+
+project "AssetCooker"
+	location "tools/AssetCooker"
+	kind "ConsoleApp"
+	language "C++"
+	cppdialect "C++17"
+
+	targetdir ("bin/" .. outputdir .. "/%{prj.name}")
+	objdir ("bin-int/" .. outputdir .. "/%{prj.name}")
+
+	files
+	{
+		"tools/%{prj.name}/src/**.cpp",
+		"D3D12Practice/include/CubeMapCooker.h",
+		"D3D12Practice/src/CubeMapCooker.cpp",
+		"D3D12Practice/include/TonemapCPU.h",
+		"D3D12Practice/src/TonemapCPU.cpp",
+	}
+
+	includedirs
+	{
+		"D3D12Practice/include",
+	}
+
+	filter "system:windows"
+		staticruntime "On"
+		systemversion "latest"
+
+	filter "configurations:Debug"
+		defines "VOE_DEBUG"
+		symbols "On"
+
+	filter "configurations:Release"
+		defines "VOE_RELEASE"
+		optimize "On"
+
+	filter "configurations:Dist"
+		defines "VOE_DIST"
+		optimize "On"
+
+
+
+project "ShaderBundler"
+	location "tools/ShaderBundler"
+	kind "ConsoleApp"
+	language "C++"
+	cppdialect "C++17"
+
+	targetdir ("bin/" .. outputdir .. "/%{prj.name}")
+	objdir ("bin-int/" .. outputdir .. "/%{prj.name}")
+
+	files
+	{
+		"tools/%{prj.name}/src/**.cpp",
+		"D3D12Practice/include/Hash.h",
+		"D3D12Practice/include/ShaderBundle.h",
+		"D3D12Practice/src/ShaderBundle.cpp",
+	}
+
+	includedirs
+	{
+		"D3D12Practice/include",
+	}
+
+	filter "system:windows"
+		staticruntime "On"
+		systemversion "latest"
+
+	filter "configurations:Debug"
+		defines "VOE_DEBUG"
+		symbols "On"
+
+	filter "configurations:Release"
+		defines "VOE_RELEASE"
+		optimize "On"
+
+	filter "configurations:Dist"
+		defines "VOE_DIST"
+		optimize "On"
+
+
+
+project "BenchStore"
+	location "tools/BenchStore"
+	kind "ConsoleApp"
+	language "C++"
+	cppdialect "C++17"
+
+	targetdir ("bin/" .. outputdir .. "/%{prj.name}")
+	objdir ("bin-int/" .. outputdir .. "/%{prj.name}")
+
+	files
+	{
+		"tools/%{prj.name}/src/**.cpp",
+		"D3D12Practice/include/JsonParser.h",
+	}
+
+	includedirs
+	{
+		"D3D12Practice/include",
+	}
+
+	filter "system:windows"
+		staticruntime "On"
+		systemversion "latest"
+
+	filter "configurations:Debug"
+		defines "VOE_DEBUG"
+		symbols "On"
+
+	filter "configurations:Release"
+		defines "VOE_RELEASE"
+		optimize "On"
+
+	filter "configurations:Dist"
+		defines "VOE_DIST"
+		optimize "On"
+
+
+
+project "LogBench"
+	location "tools/LogBench"
+	kind "ConsoleApp"
+	language "C++"
+	cppdialect "C++17"
+
+	targetdir ("bin/" .. outputdir .. "/%{prj.name}")
+	objdir ("bin-int/" .. outputdir .. "/%{prj.name}")
+
+	files
+	{
+		"tools/%{prj.name}/src/**.cpp",
+		"D3D12Practice/include/AsyncLogger.h",
+		"D3D12Practice/src/AsyncLogger.cpp",
+	}
+
+	includedirs
+	{
+		"D3D12Practice/include",
+	}
+
+	filter "system:windows"
+		staticruntime "On"
+		systemversion "latest"
+
+	filter "configurations:Debug"
+		defines "VOE_DEBUG"
+		symbols "On"
+
+	filter "configurations:Release"
+		defines "VOE_RELEASE"
+		optimize "On"
+
+	filter "configurations:Dist"
+		defines "VOE_DIST"
+		optimize "On"
+
+
+
+project "IBLBakeTest"
+	location "tools/IBLBakeTest"
+	kind "ConsoleApp"
+	language "C++"
+	cppdialect "C++17"
+
+	targetdir ("bin/" .. outputdir .. "/%{prj.name}")
+	objdir ("bin-int/" .. outputdir .. "/%{prj.name}")
+
+	files
+	{
+		"tools/%{prj.name}/src/**.cpp",
+		"D3D12Practice/include/IBLBakeScheduler.h",
+		"D3D12Practice/src/IBLBakeScheduler.cpp",
+	}
+
+	includedirs
+	{
+		"D3D12Practice/include",
+	}
+
+	filter "system:windows"
+		staticruntime "On"
+		systemversion "latest"
+
+	filter { "system:linux", "configurations:Debug" }
+		buildoptions { "-fsanitize=address,undefined" }
+		linkoptions { "-fsanitize=address,undefined" }
+
+	filter "configurations:Debug"
+		defines "VOE_DEBUG"
+		symbols "On"
+
+	filter "configurations:Release"
+		defines "VOE_RELEASE"
+		optimize "On"
+
+	filter "configurations:Dist"
+		defines "VOE_DIST"
+		optimize "On"
+
+
+
+project "VfsBench"
+	location "tools/VfsBench"
+	kind "ConsoleApp"
+	language "C++"
+	cppdialect "C++17"
+
+	targetdir ("bin/" .. outputdir .. "/%{prj.name}")
+	objdir ("bin-int/" .. outputdir .. "/%{prj.name}")
+
+	files
+	{
+		"tools/%{prj.name}/src/**.cpp",
+		"D3D12Practice/include/VirtualFileSystem.h",
+		"D3D12Practice/src/VirtualFileSystem.cpp",
+	}
+
+	includedirs
+	{
+		"D3D12Practice/include",
+	}
+
+	filter "system:windows"
+		staticruntime "On"
+		systemversion "latest"
+
+	filter "system:linux"
+		links { "pthread" }
+
+	filter { "system:linux", "configurations:Debug" }
+		buildoptions { "-fsanitize=address,undefined" }
+		linkoptions { "-fsanitize=address,undefined" }
+
+	filter "configurations:Debug"
+		defines "VOE_DEBUG"
+		symbols "On"
+
+	filter "configurations:Release"
+		defines "VOE_RELEASE"
+		optimize "On"
+
+	filter "configurations:Dist"
+		defines "VOE_DIST"
+		optimize "On"
+
+
+
+project "AutoExposureTest"
+	location "tools/AutoExposureTest"
+	kind "ConsoleApp"
+	language "C++"
+	cppdialect "C++17"
+
+	targetdir ("bin/" .. outputdir .. "/%{prj.name}")
+	objdir ("bin-int/" .. outputdir .. "/%{prj.name}")
+
+	files
+	{
+		"tools/%{prj.name}/src/**.cpp",
+		"D3D12Practice/include/AutoExposureCPU.h",
+		"D3D12Practice/src/AutoExposureCPU.cpp",
+	}
+
+	includedirs
+	{
+		"D3D12Practice/include",
+	}
+
+	filter "system:windows"
+		staticruntime "On"
+		systemversion "latest"
+
+	-- The reference vectors assume unfused multiply-adds, like the precise shader code.
+	filter "system:linux"
+		buildoptions { "-ffp-contract=off" }
+
+	filter { "system:linux", "configurations:Debug" }
+		buildoptions { "-fsanitize=address,undefined" }
+		linkoptions { "-fsanitize=address,undefined" }
+
+	filter "configurations:Debug"
+		defines "VOE_DEBUG"
+		symbols "On"
+
+	filter "configurations:Release"
+		defines "VOE_RELEASE"
+		optimize "On"
+
+	filter "configurations:Dist"
+		defines "VOE_DIST"
+		optimize "On"
+
+
+
+project "FrameGraphTest"
+	location "tools/FrameGraphTest"
+	kind "ConsoleApp"
+	language "C++"
+	cppdialect "C++17"
+
+	targetdir ("bin/" .. outputdir .. "/%{prj.name}")
+	objdir ("bin-int/" .. outputdir .. "/%{prj.name}")
+
+	files
+	{
+		"tools/%{prj.name}/src/**.cpp",
+		"D3D12Practice/include/FrameGraph.h",
+		"D3D12Practice/src/FrameGraph.cpp",
+	}
+
+	includedirs
+	{
+		"D3D12Practice/include",
+	}
+
+	filter "system:windows"
+		staticruntime "On"
+		systemversion "latest"
+
+	filter { "system:linux", "configurations:Debug" }
+		buildoptions { "-fsanitize=address,undefined" }
+		linkoptions { "-fsanitize=address,undefined" }
+
+	filter "configurations:Debug"
+		defines "VOE_DEBUG"
+		symbols "On"
+
+	filter "configurations:Release"
+		defines "VOE_RELEASE"
+		optimize "On"
+
+	filter "configurations:Dist"
+		defines "VOE_DIST"
+		optimize "On"
+
+
+
+project "TlsfStress"
+	location "tools/TlsfStress"
+	kind "ConsoleApp"
+	language "C++"
+	cppdialect "C++17"
+
+	targetdir ("bin/" .. outputdir .. "/%{prj.name}")
+	objdir ("bin-int/" .. outputdir .. "/%{prj.name}")
+
+	files
+	{
+		"tools/%{prj.name}/src/**.cpp",
+		"D3D12Practice/include/TlsfAllocator.h",
+		"D3D12Practice/src/TlsfAllocator.cpp",
+	}
+
+	includedirs
+	{
+		"D3D12Practice/include",
+	}
+
+	filter "system:windows"
+		staticruntime "On"
+		systemversion "latest"
+
+	filter { "system:linux", "configurations:Debug" }
+		buildoptions { "-fsanitize=address,undefined" }
+		linkoptions { "-fsanitize=address,undefined" }
+
+	filter "configurations:Debug"
+		defines "VOE_DEBUG"
+		symbols "On"
+
+	filter "configurations:Release"
+		defines "VOE_RELEASE"
+		optimize "On"
+
+	filter "configurations:Dist"
+		defines "VOE_DIST"
+		optimize "On"
+
+
+
+project "DynamicResolutionTest"
+	location "tools/DynamicResolutionTest"
+	kind "ConsoleApp"
+	language "C++"
+	cppdialect "C++17"
+
+	targetdir ("bin/" .. outputdir .. "/%{prj.name}")
+	objdir ("bin-int/" .. outputdir .. "/%{prj.name}")
+	debugdir "tools/%{prj.name}"
+
+	files
+	{
+		"tools/%{prj.name}/src/**.cpp",
+		"D3D12Practice/include/DynamicResolution.h",
+		"D3D12Practice/src/DynamicResolution.cpp",
+	}
+
+	includedirs
+	{
+		"D3D12Practice/include",
+	}
+
+	filter "system:windows"
+		staticruntime "On"
+		systemversion "latest"
+
+	filter { "system:linux", "configurations:Debug" }
+		buildoptions { "-fsanitize=address,undefined" }
+		linkoptions { "-fsanitize=address,undefined" }
+
+	filter "configurations:Debug"
+		defines "VOE_DEBUG"
+		symbols "On"
+
+	filter "configurations:Release"
+		defines "VOE_RELEASE"
+		optimize "On"
+
+	filter "configurations:Dist"
+		defines "VOE_DIST"
+		optimize "On"
+
+
+
+project "DrawListBench"
+	location "tools/DrawListBench"
+	kind "ConsoleApp"
+	language "C++"
+	cppdialect "C++17"
+
+	targetdir ("bin/" .. outputdir .. "/%{prj.name}")
+	objdir ("bin-int/" .. outputdir .. "/%{prj.name}")
+
+	files
+	{
+		"tools/%{prj.name}/src/**.cpp",
+		"D3D12Practice/include/DrawList.h",
+		"D3D12Practice/src/DrawList.cpp",
+	}
+
+	includedirs
+	{
+		"D3D12Practice/include",
+	}
+
+	filter "system:windows"
+		staticruntime "On"
+		systemversion "latest"
+
+	filter "system:linux"
+		links { "pthread" }
+
+	filter { "system:linux", "configurations:Debug" }
+		buildoptions { "-fsanitize=address,undefined" }
+		linkoptions { "-fsanitize=address,undefined" }
+
+	filter "configurations:Debug"
+		defines "VOE_DEBUG"
+		symbols "On"
+
+	filter "configurations:Release"
+		defines "VOE_RELEASE"
+		optimize "On"
+
+	filter "configurations:Dist"
+		defines "VOE_DIST"
+		optimize "On"
+
+
+
+project "LightClusterBench"
+	location "tools/LightClusterBench"
+	kind "ConsoleApp"
+	language "C++"
+	cppdialect "C++17"
+
+	targetdir ("bin/" .. outputdir .. "/%{prj.name}")
+	objdir ("bin-int/" .. outputdir .. "/%{prj.name}")
+
+	files
+	{
+		"tools/%{prj.name}/src/**.cpp",
+		"D3D12Practice/include/LightClusterCPU.h",
+		"D3D12Practice/src/LightClusterCPU.cpp",
+	}
+
+	includedirs
+	{
+		"D3D12Practice/include",
+	}
+
+	filter "system:windows"
+		staticruntime "On"
+		systemversion "latest"
+
+	filter "system:linux"
+		links { "pthread" }
+
+	filter { "system:linux", "configurations:Debug" }
+		buildoptions { "-fsanitize=address,undefined" }
+		linkoptions { "-fsanitize=address,undefined" }
+
+	filter "configurations:Debug"
+		defines "VOE_DEBUG"
+		symbols "On"
+
+	filter "configurations:Release"
+		defines "VOE_RELEASE"
+		optimize "On"
+
+	filter "configurations:Dist"
+		defines "VOE_DIST"
+		optimize "On"
+
+
+
+project "ProfilerTest"
+	location "tools/ProfilerTest"
+	kind "ConsoleApp"
+	language "C++"
+	cppdialect "C++17"
+
+	targetdir ("bin/" .. outputdir .. "/%{prj.name}")
+	objdir ("bin-int/" .. outputdir .. "/%{prj.name}")
+
+	files
+	{
+		"tools/%{prj.name}/src/**.cpp",
+		"D3D12Practice/include/JsonParser.h",
+		"D3D12Practice/include/Profiler.h",
+		"D3D12Practice/src/Profiler.cpp",
+	}
+
+	includedirs
+	{
+		"D3D12Practice/include",
+	}
+
+	filter "system:windows"
+		staticruntime "On"
+		systemversion "latest"
+
+	filter "system:linux"
+		links { "pthread" }
+
+	filter { "system:linux", "configurations:Debug" }
+		buildoptions { "-fsanitize=address,undefined" }
+		linkoptions { "-fsanitize=address,undefined" }
+
+	filter "configurations:Debug"
+		defines "VOE_DEBUG"
+		symbols "On"
+
+	filter "configurations:Release"
+		defines "VOE_RELEASE"
+		optimize "On"
+
+	filter "configurations:Dist"
+		defines "VOE_DIST"
+		optimize "On"
+
+
+
+project "FrameStatsTest"
+	location "tools/FrameStatsTest"
+	kind "ConsoleApp"
+	language "C++"
+	cppdialect "C++17"
+
+	targetdir ("bin/" .. outputdir .. "/%{prj.name}")
+	objdir ("bin-int/" .. outputdir .. "/%{prj.name}")
+
+	files
+	{
+		"tools/%{prj.name}/src/**.cpp",
+		"D3D12Practice/include/FrameStats.h",
+		"D3D12Practice/src/FrameStats.cpp",
+	}
+
+	includedirs
+	{
+		"D3D12Practice/include",
+	}
+
+	filter "system:windows"
+		staticruntime "On"
+		systemversion "latest"
+
+	filter "system:linux"
+		links { "pthread" }
+
+	filter { "system:linux", "configurations:Debug" }
+		buildoptions { "-fsanitize=address,undefined" }
+		linkoptions { "-fsanitize=address,undefined" }
+
+	filter "configurations:Debug"
+		defines "VOE_DEBUG"
+		symbols "On"
+
+	filter "configurations:Release"
+		defines "VOE_RELEASE"
+		optimize "On"
+
+	filter "configurations:Dist"
+		defines "VOE_DIST"
+		optimize "On"
+
+
+
+project "BenchmarkTest"
+	location "tools/BenchmarkTest"
+	kind "ConsoleApp"
+	language "C++"
+	cppdialect "C++17"
+
+	targetdir ("bin/" .. outputdir .. "/%{prj.name}")
+	objdir ("bin-int/" .. outputdir .. "/%{prj.name}")
+
+	files
+	{
+		"tools/%{prj.name}/src/**.cpp",
+		"D3D12Practice/include/JsonParser.h",
+		"D3D12Practice/include/Benchmark.h",
+		"D3D12Practice/src/Benchmark.cpp",
+	}
+
+	includedirs
+	{
+		"D3D12Practice/include",
+	}
+
+	filter "system:windows"
+		staticruntime "On"
+		systemversion "latest"
+
+	filter { "system:linux", "configurations:Debug" }
+		buildoptions { "-fsanitize=address,undefined" }
+		linkoptions { "-fsanitize=address,undefined" }
+
+	filter "configurations:Debug"
+		defines "VOE_DEBUG"
+		symbols "On"
+
+	filter "configurations:Release"
+		defines "VOE_RELEASE"
+		optimize "On"
+
+	filter "configurations:Dist"
+		defines "VOE_DIST"
+		optimize "On"
+
+
+
+project "FramePacerTest"
+	location "tools/FramePacerTest"
+	kind "ConsoleApp"
+	language "C++"
+	cppdialect "C++17"
+
+	targetdir ("bin/" .. outputdir .. "/%{prj.name}")
+	objdir ("bin-int/" .. outputdir .. "/%{prj.name}")
+
+	files
+	{
+		"tools/%{prj.name}/src/**.cpp",
+		"D3D12Practice/include/FramePacer.h",
+		"D3D12Practice/src/FramePacer.cpp",
+	}
+
+	includedirs
+	{
+		"D3D12Practice/include",
+	}
+
+	filter "system:windows"
+		staticruntime "On"
+		systemversion "latest"
+
+	filter { "system:linux", "configurations:Debug" }
+		buildoptions { "-fsanitize=address,undefined" }
+		linkoptions { "-fsanitize=address,undefined" }
+
+	filter "configurations:Debug"
+		defines "VOE_DEBUG"
+		symbols "On"
+
+	filter "configurations:Release"
+		defines "VOE_RELEASE"
+		optimize "On"
+
+	filter "configurations:Dist"
+		defines "VOE_DIST"
+		optimize "On"
+
+
+
+project "SpscQueueTest"
+	location "tools/SpscQueueTest"
+	kind "ConsoleApp"
+	language "C++"
+	cppdialect "C++17"
+
+	targetdir ("bin/" .. outputdir .. "/%{prj.name}")
+	objdir ("bin-int/" .. outputdir .. "/%{prj.name}")
+
+	files
+	{
+		"tools/%{prj.name}/src/**.cpp",
+		"D3D12Practice/include/SpscQueue.h",
+	}
+
+	includedirs
+	{
+		"D3D12Practice/include",
+	}
+
+	filter "system:windows"
+		staticruntime "On"
+		systemversion "latest"
+
+	filter "system:linux"
+		links { "pthread" }
+
+	filter { "system:linux", "configurations:Debug" }
+		buildoptions { "-fsanitize=address,undefined" }
+		linkoptions { "-fsanitize=address,undefined" }
+
+	filter "configurations:Debug"
+		defines "VOE_DEBUG"
+		symbols "On"
+
+	filter "configurations:Release"
+		defines "VOE_RELEASE"
+		optimize "On"
+
+	filter "configurations:Dist"
+		defines "VOE_DIST"
+		optimize "On"
+
+
+
+project "PipelineCacheTest"
+	location "tools/PipelineCacheTest"
+	kind "ConsoleApp"
+	language "C++"
+	cppdialect "C++17"
+
+	targetdir ("bin/" .. outputdir .. "/%{prj.name}")
+	objdir ("bin-int/" .. outputdir .. "/%{prj.name}")
+
+	files
+	{
+		"tools/%{prj.name}/src/**.cpp",
+		"D3D12Practice/src/PipelineStateHash.cpp",
+		"D3D12Practice/src/PipelineCacheFile.cpp",
+	}
+
+	includedirs
+	{
+		"D3D12Practice/include",
+	}
+
+	filter "system:windows"
+		staticruntime "On"
+		systemversion "latest"
+
+	filter "system:linux"
+		includedirs { "tools/%{prj.name}/shim" }
+
+	filter { "system:linux", "configurations:Debug" }
+		buildoptions { "-fsanitize=address,undefined" }
+		linkoptions { "-fsanitize=address,undefined" }
+
+	filter "configurations:Debug"
+		defines "VOE_DEBUG"
+		symbols "On"
+
+	filter "configurations:Release"
+		defines "VOE_RELEASE"
+		optimize "On"
+
+	filter "configurations:Dist"
+		defines "VOE_DIST"
+		optimize "On"
+
+
+
+project "TonemapTest"
+	location "tools/TonemapTest"
+	kind "ConsoleApp"
+	language "C++"
+	cppdialect "C++17"
+
+	targetdir ("bin/" .. outputdir .. "/%{prj.name}")
+	objdir ("bin-int/" .. outputdir .. "/%{prj.name}")
+
+	files
+	{
+		"tools/%{prj.name}/src/**.cpp",
+		"D3D12Practice/include/TonemapCPU.h",
+		"D3D12Practice/src/TonemapCPU.cpp",
+	}
+
+	includedirs
+	{
+		"D3D12Practice/include",
+	}
+
+	filter "system:windows"
+		staticruntime "On"
+		systemversion "latest"
+
+	filter "system:linux"
+		links { "pthread" }
+
+	filter { "system:linux", "configurations:Debug" }
+		buildoptions { "-fsanitize=address,undefined" }
+		linkoptions { "-fsanitize=address,undefined" }
+
+	filter "configurations:Debug"
+		defines "VOE_DEBUG"
+		symbols "On"
+
+	filter "configurations:Release"
+		defines "VOE_RELEASE"
+		optimize "On"
+
+	filter "configurations:Dist"
+		defines "VOE_DIST"
+		optimize "On"
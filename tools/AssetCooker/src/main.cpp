@@ -0,0 +1,382 @@
+﻿//-----------------------------------------------------------------------------
+// File : main.cpp
+// Desc : Asset Cooker Entry Point.
+// Copyright(c) Pocol. All right reserved.
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------
+#include <CubeMapCooker.h>
+#include <TonemapCPU.h>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+
+namespace {
+
+//-----------------------------------------------------------------------------
+//      使用方法を表示します.
+//-----------------------------------------------------------------------------
+void PrintUsage()
+{
+    printf("Usage : AssetCooker cubemap <input.dds> <output.dds> [options]\n");
+    printf("  --size <N>                    face size (default : input height)\n");
+    printf("  --mips <N>                    mip levels (default : full chain)\n");
+    printf("  --filter <bilinear|bicubic>   resampling filter (default : bilinear)\n");
+    printf("  --format <rgba16f|rgba32f>    output format (default : rgba16f)\n");
+    printf("  --threads <N>                 worker threads (default : hardware threads)\n");
+    printf("\n");
+    printf("Usage : AssetCooker tonemap <input.dds|dir> <output.dds|dir> [options]\n");
+    printf("  --type <none|reinhard|gt>     tonemap operator (default : gt)\n");
+    printf("  --colorspace <bt709|pq>       output encoding (default : bt709)\n");
+    printf("  --base <nit>                  base luminance (default : 100)\n");
+    printf("  --max <nit>                   max luminance (default : 100)\n");
+    printf("  --format <rgba16f|rgba32f>    output format (default : rgba16f)\n");
+    printf("  --threads <N>                 worker threads (default : hardware threads)\n");
+    printf("\n");
+    printf("Usage : AssetCooker tonemaplut [options]\n");
+    printf("  --type <none|reinhard|gt>     tonemap operator (default : gt)\n");
+    printf("  --colorspace <bt709|pq>       output encoding (default : bt709)\n");
+    printf("  --base <nit>                  base luminance (default : 100)\n");
+    printf("  --max <nit>                   max luminance (default : 100)\n");
+    printf("  --size <N>                    LUT size (default : 32)\n");
+    printf("  --minlog <EV>                 log2 of the linear segment width (default : -12)\n");
+    printf("  --maxlog <EV>                 log2 of the max input (default : 8)\n");
+    printf("  --samples <N>                 samples per axis for the report (default : 65)\n");
+    printf("  --threads <N>                 worker threads (default : hardware threads)\n");
+}
+
+//-----------------------------------------------------------------------------
+//      トーンマップパラメータのオプションを解析します.
+//-----------------------------------------------------------------------------
+bool ParseTonemapOption(int argc, char** argv, int& i, TonemapParam& param)
+{
+    auto hasValue = (i + 1 < argc);
+    if (!hasValue)
+    { return false; }
+
+    if (strcmp(argv[i], "--base") == 0)
+    { param.BaseLuminance = float(atof(argv[++i])); }
+    else if (strcmp(argv[i], "--max") == 0)
+    { param.MaxLuminance = float(atof(argv[++i])); }
+    else if (strcmp(argv[i], "--type") == 0)
+    {
+        ++i;
+        if (strcmp(argv[i], "none") == 0)
+        { param.Type = TONEMAP_NONE; }
+        else if (strcmp(argv[i], "reinhard") == 0)
+        { param.Type = TONEMAP_REINHARD; }
+        else
+        { param.Type = TONEMAP_GT; }
+    }
+    else if (strcmp(argv[i], "--colorspace") == 0)
+    {
+        ++i;
+        param.ColorSpace = (strcmp(argv[i], "pq") == 0) ? COLOR_SPACE_BT2100_PQ : COLOR_SPACE_BT709;
+    }
+    else
+    { return false; }
+
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+//      キューブマップを変換します.
+//-----------------------------------------------------------------------------
+int CookCubeMapCommand(int argc, char** argv)
+{
+    if (argc < 4)
+    {
+        PrintUsage();
+        return -1;
+    }
+
+    const char* inputPath  = argv[2];
+    const char* outputPath = argv[3];
+
+    CubeMapCookDesc desc = {};
+    CUBEMAP_FORMAT  format = CUBEMAP_FORMAT_RGBA16F;
+
+    for (auto i = 4; i < argc; ++i)
+    {
+        auto hasValue = (i + 1 < argc);
+
+        if (strcmp(argv[i], "--size") == 0 && hasValue)
+        { desc.FaceSize = uint32_t(atoi(argv[++i])); }
+        else if (strcmp(argv[i], "--mips") == 0 && hasValue)
+        { desc.MipLevels = uint32_t(atoi(argv[++i])); }
+        else if (strcmp(argv[i], "--threads") == 0 && hasValue)
+        { desc.ThreadCount = uint32_t(atoi(argv[++i])); }
+        else if (strcmp(argv[i], "--filter") == 0 && hasValue)
+        {
+            ++i;
+            desc.Filter = (strcmp(argv[i], "bicubic") == 0) ? CUBEMAP_FILTER_BICUBIC : CUBEMAP_FILTER_BILINEAR;
+        }
+        else if (strcmp(argv[i], "--format") == 0 && hasValue)
+        {
+            ++i;
+            format = (strcmp(argv[i], "rgba32f") == 0) ? CUBEMAP_FORMAT_RGBA32F : CUBEMAP_FORMAT_RGBA16F;
+        }
+        else
+        {
+            fprintf(stderr, "Error : Unknown option. option = %s\n", argv[i]);
+            PrintUsage();
+            return -1;
+        }
+    }
+
+    FloatImage sphereMap;
+    if (!LoadFloatDDS(inputPath, sphereMap))
+    {
+        fprintf(stderr, "Error : LoadFloatDDS() Failed. path = %s\n", inputPath);
+        return -1;
+    }
+
+    auto begin = std::chrono::steady_clock::now();
+
+    CubeMapImage cubeMap;
+    if (!CookCubeMap(sphereMap, desc, cubeMap))
+    {
+        fprintf(stderr, "Error : CookCubeMap() Failed.\n");
+        return -1;
+    }
+
+    auto end = std::chrono::steady_clock::now();
+
+    if (!SaveCubeMapDDS(outputPath, cubeMap, format))
+    {
+        fprintf(stderr, "Error : SaveCubeMapDDS() Failed. path = %s\n", outputPath);
+        return -1;
+    }
+
+    printf("%s -> %s : face = %u, mips = %u, %.2f ms\n",
+        inputPath,
+        outputPath,
+        cubeMap.FaceSize,
+        cubeMap.MipLevels,
+        std::chrono::duration<double, std::milli>(end - begin).count());
+
+    return 0;
+}
+
+//-----------------------------------------------------------------------------
+//      1枚の画像にトーンマップを適用します.
+//-----------------------------------------------------------------------------
+bool TonemapFile
+(
+    const std::filesystem::path&    inputPath,
+    const std::filesystem::path&    outputPath,
+    const TonemapParam&             param,
+    CUBEMAP_FORMAT                  format,
+    uint32_t                        threadCount,
+    double&                         pixels,
+    double&                         elapsedMs
+)
+{
+    FloatImage image;
+    if (!LoadFloatDDS(inputPath, image))
+    {
+        fprintf(stderr, "Error : LoadFloatDDS() Failed. path = %s\n", inputPath.string().c_str());
+        return false;
+    }
+
+    auto begin = std::chrono::steady_clock::now();
+
+    if (!TonemapImage(image, param, image, threadCount))
+    {
+        fprintf(stderr, "Error : TonemapImage() Failed. path = %s\n", inputPath.string().c_str());
+        return false;
+    }
+
+    auto end = std::chrono::steady_clock::now();
+
+    if (!SaveFloatDDS(outputPath, image, format))
+    {
+        fprintf(stderr, "Error : SaveFloatDDS() Failed. path = %s\n", outputPath.string().c_str());
+        return false;
+    }
+
+    pixels    += double(image.Width) * image.Height;
+    elapsedMs += std::chrono::duration<double, std::milli>(end - begin).count();
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+//      HDR画像にトーンマップを適用します.
+//-----------------------------------------------------------------------------
+int TonemapCommand(int argc, char** argv)
+{
+    if (argc < 4)
+    {
+        PrintUsage();
+        return -1;
+    }
+
+    std::filesystem::path inputPath  = argv[2];
+    std::filesystem::path outputPath = argv[3];
+
+    TonemapParam    param       = { TONEMAP_GT, COLOR_SPACE_BT709, 100.0f, 100.0f };
+    CUBEMAP_FORMAT  format      = CUBEMAP_FORMAT_RGBA16F;
+    uint32_t        threadCount = 0;
+
+    for (auto i = 4; i < argc; ++i)
+    {
+        auto hasValue = (i + 1 < argc);
+
+        if (ParseTonemapOption(argc, argv, i, param))
+        { continue; }
+        else if (strcmp(argv[i], "--threads") == 0 && hasValue)
+        { threadCount = uint32_t(atoi(argv[++i])); }
+        else if (strcmp(argv[i], "--format") == 0 && hasValue)
+        {
+            ++i;
+            format = (strcmp(argv[i], "rgba32f") == 0) ? CUBEMAP_FORMAT_RGBA32F : CUBEMAP_FORMAT_RGBA16F;
+        }
+        else
+        {
+            fprintf(stderr, "Error : Unknown option. option = %s\n", argv[i]);
+            PrintUsage();
+            return -1;
+        }
+    }
+
+    if (!(param.BaseLuminance > 0.0f) || !(param.MaxLuminance > 0.0f))
+    {
+        fprintf(stderr, "Error : Invalid luminance. base = %f, max = %f\n", param.BaseLuminance, param.MaxLuminance);
+        return -1;
+    }
+
+    auto   count     = 0u;
+    double pixels    = 0.0;
+    double elapsedMs = 0.0;
+
+    std::error_code ec;
+    if (std::filesystem::is_directory(inputPath, ec))
+    {
+        // ディレクトリ内の全てのDDSを変換.
+        std::filesystem::create_directories(outputPath, ec);
+        for (auto& item : std::filesystem::directory_iterator(inputPath, ec))
+        {
+            if (!item.is_regular_file() || item.path().extension() != ".dds")
+            { continue; }
+
+            if (!TonemapFile(item.path(), outputPath / item.path().filename(), param, format, threadCount, pixels, elapsedMs))
+            { return -1; }
+
+            count++;
+        }
+    }
+    else
+    {
+        if (!TonemapFile(inputPath, outputPath, param, format, threadCount, pixels, elapsedMs))
+        { return -1; }
+
+        count++;
+    }
+
+    printf("%s -> %s : %u images, %.2f MPixels, %.2f ms, %.1f MPixels/s\n",
+        argv[2],
+        argv[3],
+        count,
+        pixels / 1e6,
+        elapsedMs,
+        (elapsedMs > 0.0) ? pixels / (elapsedMs * 1e3) : 0.0);
+
+    return 0;
+}
+
+//-----------------------------------------------------------------------------
+//      トーンマップのLUTを生成して精度を評価します.
+//-----------------------------------------------------------------------------
+int TonemapLUTCommand(int argc, char** argv)
+{
+    TonemapParam    param          = { TONEMAP_GT, COLOR_SPACE_BT709, 100.0f, 100.0f };
+    TonemapLUTDesc  desc;
+    uint32_t        samplesPerAxis = 65;
+    uint32_t        threadCount    = 0;
+
+    for (auto i = 2; i < argc; ++i)
+    {
+        auto hasValue = (i + 1 < argc);
+
+        if (ParseTonemapOption(argc, argv, i, param))
+        { continue; }
+        else if (strcmp(argv[i], "--size") == 0 && hasValue)
+        { desc.Size = uint32_t(atoi(argv[++i])); }
+        else if (strcmp(argv[i], "--minlog") == 0 && hasValue)
+        { desc.MinLog = float(atof(argv[++i])); }
+        else if (strcmp(argv[i], "--maxlog") == 0 && hasValue)
+        { desc.MaxLog = float(atof(argv[++i])); }
+        else if (strcmp(argv[i], "--samples") == 0 && hasValue)
+        { samplesPerAxis = uint32_t(atoi(argv[++i])); }
+        else if (strcmp(argv[i], "--threads") == 0 && hasValue)
+        { threadCount = uint32_t(atoi(argv[++i])); }
+        else
+        {
+            fprintf(stderr, "Error : Unknown option. option = %s\n", argv[i]);
+            PrintUsage();
+            return -1;
+        }
+    }
+
+    std::vector<float> lut;
+
+    auto start = std::chrono::steady_clock::now();
+    if (!BakeTonemapLUT(param, desc, lut, threadCount))
+    {
+        fprintf(stderr, "Error : BakeTonemapLUT() Failed.\n");
+        return -1;
+    }
+    auto bakeMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    TonemapLUTReport report;
+    if (!EvaluateTonemapLUT(param, desc, lut, report, samplesPerAxis, threadCount))
+    {
+        fprintf(stderr, "Error : EvaluateTonemapLUT() Failed.\n");
+        return -1;
+    }
+
+    printf("LUT %u^3 (log2 %.1f .. %.1f), bake %.2f ms\n", desc.Size, desc.MinLog, desc.MaxLog, bakeMs);
+    printf("  samples    : %u\n", report.SampleCount);
+    printf("  max error  : %.6f (%.2f / 255, %.2f / 1023)\n", report.MaxError, report.MaxError * 255.0f, report.MaxError * 1023.0f);
+    printf("  mean error : %.6f (%.2f / 1023)\n", report.MeanError, report.MeanError * 1023.0f);
+    printf("  worst at   : input (%g, %g, %g) -> expected (%.5f, %.5f, %.5f)\n",
+        report.MaxErrorInput[0],
+        report.MaxErrorInput[1],
+        report.MaxErrorInput[2],
+        report.MaxErrorOutput[0],
+        report.MaxErrorOutput[1],
+        report.MaxErrorOutput[2]);
+
+    return 0;
+}
+
+} // namespace
+
+
+//-----------------------------------------------------------------------------
+//      メインエントリーポイントです.
+//-----------------------------------------------------------------------------
+int main(int argc, char** argv)
+{
+    if (argc < 2)
+    {
+        PrintUsage();
+        return -1;
+    }
+
+    if (strcmp(argv[1], "cubemap") == 0)
+    { return CookCubeMapCommand(argc, argv); }
+
+    if (strcmp(argv[1], "tonemap") == 0)
+    { return TonemapCommand(argc, argv); }
+
+    if (strcmp(argv[1], "tonemaplut") == 0)
+    { return TonemapLUTCommand(argc, argv); }
+
+    PrintUsage();
+    return -1;
+}
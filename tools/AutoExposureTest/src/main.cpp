@@ -0,0 +1,260 @@
+﻿//-----------------------------------------------------------------------------
+// File : main.cpp
+// Desc : Auto Exposure Reference Test Entry Point.
+// Copyright(c) Pocol. All right reserved.
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------
+#include "AutoExposureCPU.h"
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+
+namespace {
+
+//-----------------------------------------------------------------------------
+// Constant Values.
+//-----------------------------------------------------------------------------
+constexpr float     DeltaTime   = 1.0f / 60.0f;     // 1フレームの時間[s].
+constexpr int32_t   KeyLog      = -10133;           // log2(0.18) * 4096 の丸め.
+constexpr int32_t   MinLog      = -12 * 4096;       // 既定の最小輝度の log2 (固定小数).
+constexpr int32_t   RateToDark  = 101;              // (1 - exp(-1.5 / 60)) * 4096 の丸め.
+constexpr int32_t   RateToLight = 200;              // (1 - exp(-3.0 / 60)) * 4096 の丸め.
+
+///////////////////////////////////////////////////////////////////////////////
+// BinVector structure
+///////////////////////////////////////////////////////////////////////////////
+struct BinVector
+{
+    float       Color[3];   //!< 入力色です.
+    uint32_t    Bin;        //!< 期待するビン番号です.
+    const char* Name;       //!< 表示名です.
+};
+
+// 期待値は各演算を単精度で丸めた参照実装から求めたもの.
+// 後の2つはビンの境界のすぐ下にあり, 積和を融合すると 63 になる.
+const BinVector g_BinVectors[] = {
+    { { 0.0f, 0.0f, 0.0f },                                     0,   "black" },
+    { { -1.0f, -1.0f, -1.0f },                                  0,   "negative" },
+    { { 1e-5f, 1e-5f, 1e-5f },                                  0,   "below minimum" },
+    { { 0x1p-12f, 0x1p-12f, 0x1p-12f },                         0,   "at minimum" },
+    { { 0.18f, 0.18f, 0.18f },                                  151, "middle gray" },
+    { { 1.0f, 1.0f, 1.0f },                                     192, "white" },
+    { { 0.5f, 0.25f, 4.0f },                                    178, "colored" },
+    { { 1000.0f, 1000.0f, 1000.0f },                            255, "above maximum" },
+    { { 65504.0f, 65504.0f, 65504.0f },                         255, "half max" },
+    { { 0x1.132d9p-10f, 0x1.0454e6p-8f, 0x1.7e2b0ep-7f },       64,  "boundary (contraction sensitive) 1" },
+    { { 0x1.870d78p-8f, 0x1.396dc8p-10f, 0x1.94815ap-6f },      64,  "boundary (contraction sensitive) 2" },
+};
+
+uint32_t g_FailCount = 0;   // 失敗した確認の数.
+
+//-----------------------------------------------------------------------------
+//      確認結果を表示します.
+//-----------------------------------------------------------------------------
+void Check(bool condition, const char* name)
+{
+    printf("[%s] %s\n", condition ? "PASS" : "FAIL", name);
+    if (!condition)
+    { g_FailCount++; }
+}
+
+//-----------------------------------------------------------------------------
+//      整数を比較して結果を表示します.
+//-----------------------------------------------------------------------------
+void CheckEqual(int64_t actual, int64_t expected, const char* name)
+{
+    if (actual != expected)
+    { printf("       actual = %lld, expected = %lld\n", static_cast<long long>(actual), static_cast<long long>(expected)); }
+
+    Check(actual == expected, name);
+}
+
+//-----------------------------------------------------------------------------
+//      既定の設定で定数を生成します.
+//-----------------------------------------------------------------------------
+CbExposure MakeConstants(uint32_t width, uint32_t height, bool reset, const ExposureSettings& settings = ExposureSettings())
+{ return MakeExposureConstants(settings, width, height, DeltaTime, reset); }
+
+//-----------------------------------------------------------------------------
+//      ビンの選択を確認します.
+//-----------------------------------------------------------------------------
+void TestBinSelection()
+{
+    auto constants = MakeConstants(1, 1, true);
+
+    for (auto& vector : g_BinVectors)
+    { CheckEqual(GetExposureBin(constants, vector.Color), vector.Bin, vector.Name); }
+
+    // ヒストグラムは全ピクセルを1回ずつ数える.
+    std::vector<float> pixels;
+    for (auto& vector : g_BinVectors)
+    {
+        pixels.insert(pixels.end(), vector.Color, vector.Color + 3);
+        pixels.push_back(1.0f);
+    }
+
+    uint32_t histogram[EXPOSURE_BIN_COUNT];
+    auto count = uint32_t(sizeof(g_BinVectors) / sizeof(g_BinVectors[0]));
+    constants = MakeConstants(count, 1, true);
+    BuildExposureHistogram(constants, pixels.data(), histogram);
+
+    uint32_t total = 0;
+    for (auto value : histogram)
+    { total += value; }
+
+    CheckEqual(total, count, "histogram counts every pixel");
+    CheckEqual(histogram[0], 4, "histogram bin 0");
+    CheckEqual(histogram[255], 2, "histogram bin 255");
+}
+
+//-----------------------------------------------------------------------------
+//      固定小数の定数を確認します.
+//-----------------------------------------------------------------------------
+void TestConstants()
+{
+    ExposureSettings settings;
+    auto constants = MakeConstants(10, 1, false, settings);
+
+    CheckEqual(constants.KeyLogValue, KeyLog, "key value log2");
+    CheckEqual(constants.MinLogLuminance, MinLog, "min log luminance");
+    CheckEqual(constants.MinLuminanceBits, 0x39800000, "min luminance bits (2^-12)");
+    CheckEqual(constants.LowCount, 5, "low count");
+    CheckEqual(constants.HighCount, 9, "high count");
+    CheckEqual(constants.RateToDark, RateToDark, "rate to dark");
+    CheckEqual(constants.RateToLight, RateToLight, "rate to light");
+    CheckEqual(constants.MinEV, -8 * EXPOSURE_EV_ONE, "min ev");
+    CheckEqual(constants.MaxEV, 8 * EXPOSURE_EV_ONE, "max ev");
+}
+
+//-----------------------------------------------------------------------------
+//      平均輝度と目標露光値を確認します.
+//-----------------------------------------------------------------------------
+void TestTarget()
+{
+    uint32_t histogram[EXPOSURE_BIN_COUNT];
+
+    // 暗い側の50%と明るい側の5%を除くと, 残りはビン100だけになる.
+    {
+        memset(histogram, 0, sizeof(histogram));
+        histogram[0]   = 50;
+        histogram[100] = 45;
+        histogram[255] = 5;
+
+        ExposureState state = {};
+        AdaptExposure(MakeConstants(100, 1, true), histogram, state);
+        CheckEqual(state.AverageLogLuminance, MinLog + 100 * 256 + 128, "trimmed average");
+        CheckEqual(state.TargetEV, KeyLog - (MinLog + 100 * 256 + 128), "trimmed target");
+        CheckEqual(state.EV, state.TargetEV, "reset jumps to target");
+    }
+
+    // 除外の境界がビンの途中にかかる場合は, ピクセル単位で分ける.
+    {
+        memset(histogram, 0, sizeof(histogram));
+        histogram[10] = 3;
+        histogram[20] = 4;
+        histogram[30] = 3;
+
+        ExposureState state = {};
+        AdaptExposure(MakeConstants(10, 1, true), histogram, state);
+        CheckEqual(state.AverageLogLuminance, MinLog + 25 * 256 + 128, "partial bin average");
+        CheckEqual(state.TargetEV, 32491, "partial bin target");
+    }
+
+    // 真っ暗な画面では上限で止まる.
+    {
+        memset(histogram, 0, sizeof(histogram));
+        histogram[0] = 100;
+
+        ExposureState state = {};
+        AdaptExposure(MakeConstants(100, 1, true), histogram, state);
+        CheckEqual(state.TargetEV, 8 * EXPOSURE_EV_ONE, "target clamped to max ev");
+    }
+
+    // 無効時は補正値がそのまま露光値になる.
+    {
+        ExposureSettings settings;
+        settings.Enable       = false;
+        settings.Compensation = 1.5f;
+
+        memset(histogram, 0, sizeof(histogram));
+        ExposureState state = {};
+        AdaptExposure(MakeConstants(100, 1, true, settings), histogram, state);
+        CheckEqual(state.EV, 6144, "disabled uses compensation");
+        Check(state.Exposure == 0x1.6a09e6p+1f || state.Exposure == 0x1.6a09e8p+1f, "exposure is 2^ev");
+    }
+}
+
+//-----------------------------------------------------------------------------
+//      固定小数の順応を確認します.
+//-----------------------------------------------------------------------------
+void TestAdaptation()
+{
+    uint32_t histogram[EXPOSURE_BIN_COUNT];
+    memset(histogram, 0, sizeof(histogram));
+    histogram[192] = 100;   // 輝度 1.0.
+
+    const int32_t target = KeyLog - (MinLog + 192 * 256 + 128);
+    auto constants = MakeConstants(100, 1, false);
+
+    // 明所への順応. 算術右シフトは負の側に丸める.
+    {
+        ExposureState state = {};
+        const int32_t expected[] = { -502, -979, -1433 };
+        for (auto ev : expected)
+        {
+            AdaptExposure(constants, histogram, state);
+            CheckEqual(state.EV, ev, "adapt to light step");
+        }
+
+        for (auto i = 0; i < 2000; ++i)
+        { AdaptExposure(constants, histogram, state); }
+        CheckEqual(state.EV, target, "adapt to light reaches target exactly");
+    }
+
+    // 暗所への順応. 差が 4096 / RateToDark 未満になると止まる.
+    {
+        memset(histogram, 0, sizeof(histogram));
+        histogram[192 - 10 * 16 - 1] = 100;     // 目標が 0 付近になる明るさ.
+
+        ExposureState state = {};
+        state.EV = target;
+
+        AdaptExposure(constants, histogram, state);
+        auto darkTarget = state.TargetEV;
+        CheckEqual(darkTarget, KeyLog - (MinLog + 31 * 256 + 128), "dark target");
+        CheckEqual(state.EV, target + (((darkTarget - target) * RateToDark) >> EXPOSURE_RATE_SHIFT), "adapt to dark step");
+
+        for (auto i = 0; i < 4000; ++i)
+        { AdaptExposure(constants, histogram, state); }
+
+        auto gap = darkTarget - state.EV;
+        Check(gap >= 0 && gap * RateToDark < EXPOSURE_RATE_ONE, "adapt to dark settles within one fixed-point step");
+    }
+}
+
+} // namespace
+
+
+//-----------------------------------------------------------------------------
+//      メインエントリーポイントです.
+//-----------------------------------------------------------------------------
+int main(int, char**)
+{
+    TestBinSelection();
+    TestConstants();
+    TestTarget();
+    TestAdaptation();
+
+    if (g_FailCount > 0)
+    {
+        fprintf(stderr, "Error : %u check(s) failed.\n", g_FailCount);
+        return -1;
+    }
+
+    return 0;
+}
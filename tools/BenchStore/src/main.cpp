@@ -0,0 +1,912 @@
+﻿//-----------------------------------------------------------------------------
+// File : main.cpp
+// Desc : Benchmark Results Store Entry Point.
+// Copyright(c) Pocol. All right reserved.
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------
+#include "JsonParser.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <utility>
+#include <vector>
+
+
+namespace {
+
+//-----------------------------------------------------------------------------
+// Constant Values.
+//-----------------------------------------------------------------------------
+constexpr double DefaultThreshold   = 0.03;     // 既定の最小の変化率(これ未満は無視).
+constexpr double DefaultSigma       = 3.0;      // 既定の有意とみなす標準誤差の倍数.
+constexpr double MinNoiseRatio      = 0.005;    // ノイズとして最低限見込む値の割合.
+
+///////////////////////////////////////////////////////////////////////////////
+// Record structure
+///////////////////////////////////////////////////////////////////////////////
+struct Record
+{
+    std::string     Commit;     //!< コミットです.
+    std::string     Config;     //!< ビルド構成(Debug/Release/Dist)です.
+    std::string     Machine;    //!< 計測したマシンです.
+    double          Time;       //!< 追加した時刻(UNIX 時間)です.
+    JsonValue       Result;     //!< ベンチマーク結果です.
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// Comparison structure
+///////////////////////////////////////////////////////////////////////////////
+struct Comparison
+{
+    std::string     Name;           //!< 値の名前です.
+    const char*     Category;       //!< 分類です.
+    bool            HigherIsBetter; //!< 大きいほど良い値かどうか.
+    uint32_t        BaseCount;      //!< 基準の計測数です.
+    uint32_t        HeadCount;      //!< 比較対象の計測数です.
+    double          BaseMean;       //!< 基準の平均値です.
+    double          HeadMean;       //!< 比較対象の平均値です.
+    double          Noise;          //!< 見込んだ1回の計測のばらつき(標準偏差)です.
+    double          Change;         //!< 変化率です(正なら悪化).
+    double          Score;          //!< 悪化量を標準誤差で割った値です.
+    int             Verdict;        //!< 判定です(1:悪化, -1:改善, 0:変化無し).
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// CompareOptions structure
+///////////////////////////////////////////////////////////////////////////////
+struct CompareOptions
+{
+    std::string     Base;                           //!< 基準のコミットです(空なら直前のコミット).
+    std::string     Head;                           //!< 比較対象のコミットです.
+    std::string     Config;                         //!< ビルド構成です(空なら比較対象と同じ).
+    std::string     Machine;                        //!< マシンです(空なら比較対象と同じ).
+    double          Threshold   = DefaultThreshold; //!< 最小の変化率です.
+    double          Sigma       = DefaultSigma;     //!< 有意とみなす標準誤差の倍数です.
+    std::string     TextPath;                       //!< テキストレポートの出力先です.
+    std::string     HtmlPath;                       //!< HTML レポートの出力先です.
+};
+
+//-----------------------------------------------------------------------------
+//      使用方法を表示します.
+//-----------------------------------------------------------------------------
+void PrintUsage()
+{
+    printf("Usage : BenchStore add <store.jsonl> <result.json> --commit <id> [options]\n");
+    printf("  --config <Debug|Release|Dist>  build configuration (default : from the result)\n");
+    printf("  --machine <name>               machine name (default : host name)\n");
+    printf("\n");
+    printf("Usage : BenchStore list <store.jsonl>\n");
+    printf("\n");
+    printf("Usage : BenchStore compare <store.jsonl> --head <id> [options]\n");
+    printf("  --base <id>                    baseline commit (default : the commit stored before head)\n");
+    printf("  --config <name>                build configuration (default : head's)\n");
+    printf("  --machine <name>               machine name (default : head's)\n");
+    printf("  --threshold <ratio>            minimum relative change to report (default : 0.03)\n");
+    printf("  --sigma <N>                    required standard errors for significance (default : 3)\n");
+    printf("  --text <path>                  write the text report to a file\n");
+    printf("  --html <path>                  write the HTML report to a file\n");
+    printf("  exit code : 0 no regression, 1 regression found, -1 error.\n");
+}
+
+//-----------------------------------------------------------------------------
+//      ファイルを読み込みます.
+//-----------------------------------------------------------------------------
+bool ReadText(const char* path, std::string& result)
+{
+    std::ifstream stream(path, std::ios::binary);
+    if (!stream.is_open())
+    { return false; }
+
+    result.assign(
+        (std::istreambuf_iterator<char>(stream)),
+        std::istreambuf_iterator<char>());
+    return !stream.bad();
+}
+
+//-----------------------------------------------------------------------------
+//      ファイルに書き出します.
+//-----------------------------------------------------------------------------
+bool WriteText(const std::string& path, const std::string& text)
+{
+    std::ofstream stream(path, std::ios::binary | std::ios::trunc);
+    if (!stream.is_open())
+    { return false; }
+
+    stream.write(text.data(), std::streamsize(text.size()));
+    return stream.good();
+}
+
+//-----------------------------------------------------------------------------
+//      JSON の文字列として出力します.
+//-----------------------------------------------------------------------------
+void AppendJsonString(std::string& result, const std::string& value)
+{
+    result += '"';
+    for (auto c : value)
+    {
+        switch (c)
+        {
+        case '"':  result += "\\\""; break;
+        case '\\': result += "\\\\"; break;
+        case '\n': result += "\\n";  break;
+        case '\t': result += "\\t";  break;
+        default:
+            if (uint8_t(c) < 0x20)
+            {
+                char code[8];
+                snprintf(code, sizeof(code), "\\u%04x", uint32_t(uint8_t(c)));
+                result += code;
+            }
+            else
+            { result += c; }
+            break;
+        }
+    }
+    result += '"';
+}
+
+//-----------------------------------------------------------------------------
+//      JSON を1行で出力します.
+//-----------------------------------------------------------------------------
+void AppendJson(std::string& result, const JsonValue& value)
+{
+    switch (value.Type)
+    {
+    case JSON_TYPE_NULL:
+        result += "null";
+        break;
+
+    case JSON_TYPE_BOOL:
+        result += value.Bool ? "true" : "false";
+        break;
+
+    case JSON_TYPE_NUMBER:
+        {
+            char buffer[64];
+            snprintf(buffer, sizeof(buffer), "%.17g", std::isfinite(value.Number) ? value.Number : 0.0);
+            result += buffer;
+        }
+        break;
+
+    case JSON_TYPE_STRING:
+        AppendJsonString(result, value.String);
+        break;
+
+    case JSON_TYPE_ARRAY:
+        result += '[';
+        for (size_t i = 0; i < value.Array.size(); ++i)
+        {
+            if (i > 0)
+            { result += ','; }
+            AppendJson(result, value.Array[i]);
+        }
+        result += ']';
+        break;
+
+    case JSON_TYPE_OBJECT:
+        result += '{';
+        for (size_t i = 0; i < value.Object.size(); ++i)
+        {
+            if (i > 0)
+            { result += ','; }
+            AppendJsonString(result, value.Object[i].first);
+            result += ':';
+            AppendJson(result, value.Object[i].second);
+        }
+        result += '}';
+        break;
+    }
+}
+
+//-----------------------------------------------------------------------------
+//      HTML 用にエスケープします.
+//-----------------------------------------------------------------------------
+std::string EscapeHtml(const std::string& value)
+{
+    std::string result;
+    for (auto c : value)
+    {
+        switch (c)
+        {
+        case '&': result += "&amp;";  break;
+        case '<': result += "&lt;";   break;
+        case '>': result += "&gt;";   break;
+        case '"': result += "&quot;"; break;
+        default:  result += c;        break;
+        }
+    }
+    return result;
+}
+
+//-----------------------------------------------------------------------------
+//      オブジェクトの文字列メンバーを取得します.
+//-----------------------------------------------------------------------------
+std::string GetString(const JsonValue& value, const char* name)
+{
+    auto pMember = value.Find(name);
+    return (pMember != nullptr && pMember->Type == JSON_TYPE_STRING) ? pMember->String : std::string();
+}
+
+//-----------------------------------------------------------------------------
+//      ホスト名を取得します.
+//-----------------------------------------------------------------------------
+std::string GetHostName()
+{
+    const char* names[] = { "COMPUTERNAME", "HOSTNAME" };
+    for (auto name : names)
+    {
+        auto value = getenv(name);
+        if (value != nullptr && value[0] != '\0')
+        { return value; }
+    }
+
+    // 環境変数に無い場合(Linux の非対話シェルなど).
+    std::string hostName;
+    if (ReadText("/etc/hostname", hostName))
+    {
+        while (!hostName.empty() && (hostName.back() == '\n' || hostName.back() == '\r'))
+        { hostName.pop_back(); }
+        if (!hostName.empty())
+        { return hostName; }
+    }
+
+    return "unknown";
+}
+
+//-----------------------------------------------------------------------------
+//      ストアを読み込みます.
+//-----------------------------------------------------------------------------
+bool LoadStore(const char* path, std::vector<Record>& records)
+{
+    records.clear();
+
+    std::ifstream stream(path, std::ios::binary);
+    if (!stream.is_open())
+    { return false; }
+
+    std::string line;
+    uint32_t lineNo = 0;
+    while (std::getline(stream, line))
+    {
+        lineNo++;
+        if (line.empty() || line == "\r")
+        { continue; }
+
+        JsonValue value;
+        if (!JsonParser::Parse(line, value) || value.Type != JSON_TYPE_OBJECT)
+        {
+            // 追記の途中で中断した行などは読み飛ばす.
+            fprintf(stderr, "Warning : Broken Record Skipped. line = %u\n", lineNo);
+            continue;
+        }
+
+        Record record;
+        record.Commit  = GetString(value, "commit");
+        record.Config  = GetString(value, "config");
+        record.Machine = GetString(value, "machine");
+
+        auto pTime   = value.Find("time");
+        auto pResult = value.Find("result");
+        record.Time  = (pTime != nullptr && pTime->Type == JSON_TYPE_NUMBER) ? pTime->Number : 0.0;
+        if (pResult == nullptr || pResult->Type != JSON_TYPE_OBJECT || record.Commit.empty())
+        {
+            fprintf(stderr, "Warning : Invalid Record Skipped. line = %u\n", lineNo);
+            continue;
+        }
+
+        record.Result = *pResult;
+        records.push_back(std::move(record));
+    }
+
+    return !stream.bad();
+}
+
+//-----------------------------------------------------------------------------
+//      数値のメンバーを "a.b.c" の名前で列挙します.
+//-----------------------------------------------------------------------------
+void Flatten(const JsonValue& value, const std::string& prefix, std::vector<std::pair<std::string, double>>& result)
+{
+    if (value.Type == JSON_TYPE_NUMBER)
+    {
+        result.push_back({ prefix, value.Number });
+        return;
+    }
+
+    if (value.Type != JSON_TYPE_OBJECT)
+    { return; }
+
+    for (auto& member : value.Object)
+    { Flatten(member.second, prefix.empty() ? member.first : prefix + "." + member.first, result); }
+}
+
+//-----------------------------------------------------------------------------
+//      名前が指定の文字列で始まるかどうかチェックします.
+//-----------------------------------------------------------------------------
+bool StartsWith(const std::string& value, const char* prefix)
+{ return value.compare(0, strlen(prefix), prefix) == 0; }
+
+//-----------------------------------------------------------------------------
+//      名前が指定の文字列で終わるかどうかチェックします.
+//-----------------------------------------------------------------------------
+bool EndsWith(const std::string& value, const char* suffix)
+{
+    auto length = strlen(suffix);
+    return value.size() >= length && value.compare(value.size() - length, length, suffix) == 0;
+}
+
+//-----------------------------------------------------------------------------
+//      比較する値かどうかチェックします.
+//-----------------------------------------------------------------------------
+bool IsComparable(const std::string& name)
+{
+    // 設定は値ではなく条件. 最小・最大は1フレームで決まり揺れが大きいので使わない.
+    if (name == "version" || name.compare(0, 9, "settings.") == 0)
+    { return false; }
+
+    return !EndsWith(name, ".count") && !EndsWith(name, ".min") && !EndsWith(name, ".max");
+}
+
+//-----------------------------------------------------------------------------
+//      値の分類を取得します.
+//-----------------------------------------------------------------------------
+const char* GetCategory(const std::string& name)
+{
+    // フレーム時間は区間名で判断する(metrics.time_to_first_frame_ms も frame_ms を含む).
+    if (StartsWith(name, "cpu_frame_ms.") || StartsWith(name, "gpu_frame_ms.") || StartsWith(name, "fps."))
+    { return "frame time"; }
+    if (name.find("first_frame") != std::string::npos || name.find("startup") != std::string::npos)
+    { return "startup"; }
+    if (name.find("bytes") != std::string::npos || name.find("memory") != std::string::npos || name.find("allocations") != std::string::npos)
+    { return "memory"; }
+    if (name.find("draw") != std::string::npos)
+    { return "draws"; }
+    return "other";
+}
+
+//-----------------------------------------------------------------------------
+//      平均値と標準偏差を求めます.
+//-----------------------------------------------------------------------------
+void GetMeanAndDeviation(const std::vector<double>& values, double& mean, double& deviation)
+{
+    mean      = 0.0;
+    deviation = 0.0;
+    if (values.empty())
+    { return; }
+
+    for (auto value : values)
+    { mean += value; }
+    mean /= double(values.size());
+
+    if (values.size() < 2)
+    { return; }
+
+    double sum = 0.0;
+    for (auto value : values)
+    { sum += (value - mean) * (value - mean); }
+    deviation = sqrt(sum / double(values.size() - 1));
+}
+
+//-----------------------------------------------------------------------------
+//      指定のコミットの値を集めます.
+//-----------------------------------------------------------------------------
+std::vector<double> Collect(const std::vector<const Record*>& records, const std::string& commit, const std::string& name)
+{
+    std::vector<double> result;
+    for (auto pRecord : records)
+    {
+        if (pRecord->Commit != commit)
+        { continue; }
+
+        std::vector<std::pair<std::string, double>> values;
+        Flatten(pRecord->Result, std::string(), values);
+        for (auto& value : values)
+        {
+            if (value.first == name)
+            { result.push_back(value.second); }
+        }
+    }
+    return result;
+}
+
+//-----------------------------------------------------------------------------
+//      履歴から1回の計測のばらつきを見積もります.
+//-----------------------------------------------------------------------------
+double EstimateNoise(const std::vector<const Record*>& history, const std::vector<std::string>& commits, const std::string& name)
+{
+    // 同じコミットを複数回計測していれば, その偏差をまとめた値(プールした分散)を使う.
+    double   pooled  = 0.0;
+    uint32_t freedom = 0;
+    std::vector<double> means;
+    for (auto& commit : commits)
+    {
+        auto values = Collect(history, commit, name);
+        if (values.empty())
+        { continue; }
+
+        double mean, deviation;
+        GetMeanAndDeviation(values, mean, deviation);
+        pooled  += deviation * deviation * double(values.size() - 1);
+        freedom += uint32_t(values.size() - 1);
+        means.push_back(mean);
+    }
+
+    if (freedom > 0)
+    { return sqrt(pooled / double(freedom)); }
+
+    // 1回ずつしか無ければ, 隣り合うコミットの差の中央値から見積もる(本当の変化に引きずられにくい).
+    if (means.size() < 3)
+    { return 0.0; }
+
+    std::vector<double> diffs;
+    for (size_t i = 1; i < means.size(); ++i)
+    { diffs.push_back(fabs(means[i] - means[i - 1])); }
+
+    std::nth_element(diffs.begin(), diffs.begin() + diffs.size() / 2, diffs.end());
+
+    // 正規分布なら |差| の中央値 = 0.954 * sqrt(2) * 標準偏差.
+    return diffs[diffs.size() / 2] / (0.954 * sqrt(2.0));
+}
+
+//-----------------------------------------------------------------------------
+//      計測結果を追加します.
+//-----------------------------------------------------------------------------
+int AddCommand(int argc, char** argv)
+{
+    if (argc < 4)
+    {
+        PrintUsage();
+        return -1;
+    }
+
+    const char* storePath  = argv[2];
+    const char* resultPath = argv[3];
+
+    Record record;
+    record.Machine = GetHostName();
+
+    for (auto i = 4; i < argc; ++i)
+    {
+        auto hasValue = (i + 1 < argc);
+
+        if (strcmp(argv[i], "--commit") == 0 && hasValue)
+        { record.Commit = argv[++i]; }
+        else if (strcmp(argv[i], "--config") == 0 && hasValue)
+        { record.Config = argv[++i]; }
+        else if (strcmp(argv[i], "--machine") == 0 && hasValue)
+        { record.Machine = argv[++i]; }
+        else
+        {
+            fprintf(stderr, "Error : Unknown option. option = %s\n", argv[i]);
+            PrintUsage();
+            return -1;
+        }
+    }
+
+    if (record.Commit.empty())
+    {
+        fprintf(stderr, "Error : --commit is required.\n");
+        return -1;
+    }
+
+    std::string text;
+    if (!ReadText(resultPath, text))
+    {
+        fprintf(stderr, "Error : File Not Found. path = %s\n", resultPath);
+        return -1;
+    }
+
+    if (!JsonParser::Parse(text, record.Result) || record.Result.Type != JSON_TYPE_OBJECT)
+    {
+        fprintf(stderr, "Error : Invalid JSON. path = %s\n", resultPath);
+        return -1;
+    }
+
+    if (record.Config.empty())
+    { record.Config = GetString(record.Result, "configuration"); }
+    if (record.Config.empty())
+    { record.Config = "Release"; }
+
+    // 1行1件で追記する(既存の行は書き換えない).
+    std::string line = "{\"commit\":";
+    AppendJsonString(line, record.Commit);
+    line += ",\"config\":";
+    AppendJsonString(line, record.Config);
+    line += ",\"machine\":";
+    AppendJsonString(line, record.Machine);
+
+    char buffer[64];
+    snprintf(buffer, sizeof(buffer), ",\"time\":%lld,\"result\":", static_cast<long long>(time(nullptr)));
+    line += buffer;
+    AppendJson(line, record.Result);
+    line += "}\n";
+
+    std::ofstream stream(storePath, std::ios::binary | std::ios::app);
+    if (!stream.is_open())
+    {
+        fprintf(stderr, "Error : Store Open Failed. path = %s\n", storePath);
+        return -1;
+    }
+
+    stream.write(line.data(), std::streamsize(line.size()));
+    if (!stream.good())
+    {
+        fprintf(stderr, "Error : Store Write Failed. path = %s\n", storePath);
+        return -1;
+    }
+
+    printf("Added %s / %s / %s -> %s\n", record.Commit.c_str(), record.Config.c_str(), record.Machine.c_str(), storePath);
+    return 0;
+}
+
+//-----------------------------------------------------------------------------
+//      格納している計測結果を一覧表示します.
+//-----------------------------------------------------------------------------
+int ListCommand(int argc, char** argv)
+{
+    if (argc < 3)
+    {
+        PrintUsage();
+        return -1;
+    }
+
+    std::vector<Record> records;
+    if (!LoadStore(argv[2], records))
+    {
+        fprintf(stderr, "Error : Store Load Failed. path = %s\n", argv[2]);
+        return -1;
+    }
+
+    printf("%-5s %-16s %-8s %-16s %12s %12s\n", "#", "commit", "config", "machine", "cpu p50 ms", "gpu p50 ms");
+    for (size_t i = 0; i < records.size(); ++i)
+    {
+        auto& record = records[i];
+
+        double cpu = 0.0;
+        double gpu = 0.0;
+        std::vector<std::pair<std::string, double>> values;
+        Flatten(record.Result, std::string(), values);
+        for (auto& value : values)
+        {
+            if (value.first == "cpu_frame_ms.p50") { cpu = value.second; }
+            if (value.first == "gpu_frame_ms.p50") { gpu = value.second; }
+        }
+
+        printf("%-5zu %-16s %-8s %-16s %12.3f %12.3f\n",
+            i,
+            record.Commit.c_str(),
+            record.Config.c_str(),
+            record.Machine.c_str(),
+            cpu,
+            gpu);
+    }
+
+    return 0;
+}
+
+//-----------------------------------------------------------------------------
+//      比較結果をテキストにします.
+//-----------------------------------------------------------------------------
+std::string FormatText(const CompareOptions& options, const std::vector<Comparison>& results)
+{
+    std::string text;
+    char line[512];
+
+    snprintf(line, sizeof(line), "Benchmark Comparison : %s -> %s (%s, %s)\n",
+        options.Base.c_str(), options.Head.c_str(), options.Config.c_str(), options.Machine.c_str());
+    text += line;
+    snprintf(line, sizeof(line), "    threshold %.1f%%, %.1f sigma\n\n", options.Threshold * 100.0, options.Sigma);
+    text += line;
+    snprintf(line, sizeof(line), "%-12s %-36s %14s %14s %9s %8s  %s\n",
+        "category", "metric", "base", "head", "change", "score", "verdict");
+    text += line;
+
+    for (auto& r : results)
+    {
+        snprintf(line, sizeof(line), "%-12s %-36s %14.4f %14.4f %+8.2f%% %8.2f  %s\n",
+            r.Category,
+            r.Name.c_str(),
+            r.BaseMean,
+            r.HeadMean,
+            r.Change * 100.0,
+            r.Score,
+            (r.Verdict > 0) ? "REGRESSION" : (r.Verdict < 0) ? "improved" : "-");
+        text += line;
+    }
+
+    auto regressions = 0;
+    for (auto& r : results)
+    { regressions += (r.Verdict > 0) ? 1 : 0; }
+
+    snprintf(line, sizeof(line), "\n%d regression(s) in %zu metric(s).\n", regressions, results.size());
+    text += line;
+    return text;
+}
+
+//-----------------------------------------------------------------------------
+//      比較結果を HTML にします.
+//-----------------------------------------------------------------------------
+std::string FormatHtml(const CompareOptions& options, const std::vector<Comparison>& results)
+{
+    std::string html;
+    char line[1024];
+
+    html += "<!DOCTYPE html>\n<html><head><meta charset=\"utf-8\"><title>Benchmark Comparison</title>\n";
+    html += "<style>body{font-family:sans-serif}table{border-collapse:collapse}"
+            "td,th{border:1px solid #ccc;padding:2px 8px;text-align:right}"
+            "td.name{text-align:left}tr.bad{background:#fcc}tr.good{background:#cfc}</style>\n";
+    html += "</head><body>\n";
+    html += "<h1>Benchmark Comparison</h1>\n<p>";
+    html += EscapeHtml(options.Base) + " &rarr; " + EscapeHtml(options.Head);
+    html += " (" + EscapeHtml(options.Config) + ", " + EscapeHtml(options.Machine) + ")</p>\n";
+    snprintf(line, sizeof(line), "<p>threshold %.1f%%, %.1f sigma</p>\n", options.Threshold * 100.0, options.Sigma);
+    html += line;
+
+    html += "<table>\n<tr><th>category</th><th>metric</th><th>base</th><th>n</th><th>head</th><th>n</th>"
+            "<th>noise</th><th>change</th><th>score</th><th>verdict</th></tr>\n";
+
+    for (auto& r : results)
+    {
+        snprintf(line, sizeof(line),
+            "<tr class=\"%s\"><td class=\"name\">%s</td><td class=\"name\">%s</td><td>%.4f</td><td>%u</td>"
+            "<td>%.4f</td><td>%u</td><td>%.4f</td><td>%+.2f%%</td><td>%.2f</td><td>%s</td></tr>\n",
+            (r.Verdict > 0) ? "bad" : (r.Verdict < 0) ? "good" : "",
+            r.Category,
+            EscapeHtml(r.Name).c_str(),
+            r.BaseMean,
+            r.BaseCount,
+            r.HeadMean,
+            r.HeadCount,
+            r.Noise,
+            r.Change * 100.0,
+            r.Score,
+            (r.Verdict > 0) ? "REGRESSION" : (r.Verdict < 0) ? "improved" : "-");
+        html += line;
+    }
+
+    html += "</table>\n</body></html>\n";
+    return html;
+}
+
+//-----------------------------------------------------------------------------
+//      2つのコミットの計測結果を比較します.
+//-----------------------------------------------------------------------------
+int CompareCommand(int argc, char** argv)
+{
+    if (argc < 3)
+    {
+        PrintUsage();
+        return -1;
+    }
+
+    const char* storePath = argv[2];
+
+    CompareOptions options;
+    for (auto i = 3; i < argc; ++i)
+    {
+        auto hasValue = (i + 1 < argc);
+
+        if (strcmp(argv[i], "--base") == 0 && hasValue)
+        { options.Base = argv[++i]; }
+        else if (strcmp(argv[i], "--head") == 0 && hasValue)
+        { options.Head = argv[++i]; }
+        else if (strcmp(argv[i], "--config") == 0 && hasValue)
+        { options.Config = argv[++i]; }
+        else if (strcmp(argv[i], "--machine") == 0 && hasValue)
+        { options.Machine = argv[++i]; }
+        else if (strcmp(argv[i], "--threshold") == 0 && hasValue)
+        { options.Threshold = atof(argv[++i]); }
+        else if (strcmp(argv[i], "--sigma") == 0 && hasValue)
+        { options.Sigma = atof(argv[++i]); }
+        else if (strcmp(argv[i], "--text") == 0 && hasValue)
+        { options.TextPath = argv[++i]; }
+        else if (strcmp(argv[i], "--html") == 0 && hasValue)
+        { options.HtmlPath = argv[++i]; }
+        else
+        {
+            fprintf(stderr, "Error : Unknown option. option = %s\n", argv[i]);
+            PrintUsage();
+            return -1;
+        }
+    }
+
+    if (options.Head.empty())
+    {
+        fprintf(stderr, "Error : --head is required.\n");
+        return -1;
+    }
+
+    std::vector<Record> records;
+    if (!LoadStore(storePath, records))
+    {
+        fprintf(stderr, "Error : Store Load Failed. path = %s\n", storePath);
+        return -1;
+    }
+
+    // 構成とマシンが省略されたら, 比較対象の最後の記録に合わせる.
+    for (auto itr = records.rbegin(); itr != records.rend(); ++itr)
+    {
+        if (itr->Commit != options.Head)
+        { continue; }
+        if (options.Config.empty())  { options.Config  = itr->Config; }
+        if (options.Machine.empty()) { options.Machine = itr->Machine; }
+        break;
+    }
+
+    // 同じ構成・マシンの記録だけを使う(異なる環境の値は比べられない).
+    std::vector<const Record*> history;
+    for (auto& record : records)
+    {
+        if (record.Config == options.Config && record.Machine == options.Machine)
+        { history.push_back(&record); }
+    }
+
+    // 記録順のコミットの列(重複なし).
+    std::vector<std::string> commits;
+    for (auto pRecord : history)
+    {
+        auto found = false;
+        for (auto& commit : commits)
+        { found |= (commit == pRecord->Commit); }
+        if (!found)
+        { commits.push_back(pRecord->Commit); }
+    }
+
+    size_t headIndex = commits.size();
+    for (size_t i = 0; i < commits.size(); ++i)
+    {
+        if (commits[i] == options.Head)
+        { headIndex = i; }
+    }
+
+    if (headIndex == commits.size())
+    {
+        fprintf(stderr, "Error : Head Commit Not Found. commit = %s, config = %s, machine = %s\n",
+            options.Head.c_str(), options.Config.c_str(), options.Machine.c_str());
+        return -1;
+    }
+
+    if (options.Base.empty())
+    {
+        if (headIndex == 0)
+        {
+            fprintf(stderr, "Error : No Baseline Before Head. commit = %s\n", options.Head.c_str());
+            return -1;
+        }
+        options.Base = commits[headIndex - 1];
+    }
+
+    // 比較対象より後の記録はばらつきの見積もりに含めない.
+    std::vector<std::string> noiseCommits(commits.begin(), commits.begin() + headIndex);
+
+    // 計測条件が違えば警告する.
+    const Record* pBaseRecord = nullptr;
+    const Record* pHeadRecord = nullptr;
+    for (auto pRecord : history)
+    {
+        if (pRecord->Commit == options.Base) { pBaseRecord = pRecord; }
+        if (pRecord->Commit == options.Head) { pHeadRecord = pRecord; }
+    }
+
+    if (pBaseRecord == nullptr)
+    {
+        fprintf(stderr, "Error : Base Commit Not Found. commit = %s\n", options.Base.c_str());
+        return -1;
+    }
+
+    {
+        auto pBaseSettings = pBaseRecord->Result.Find("settings");
+        auto pHeadSettings = pHeadRecord->Result.Find("settings");
+        std::string baseText, headText;
+        if (pBaseSettings != nullptr) { AppendJson(baseText, *pBaseSettings); }
+        if (pHeadSettings != nullptr) { AppendJson(headText, *pHeadSettings); }
+        if (baseText != headText)
+        { fprintf(stderr, "Warning : Benchmark settings differ between base and head.\n"); }
+    }
+
+    // 比較する値の名前(比較対象の記録の順).
+    std::vector<std::pair<std::string, double>> headValues;
+    Flatten(pHeadRecord->Result, std::string(), headValues);
+
+    std::vector<Comparison> results;
+    for (auto& value : headValues)
+    {
+        if (!IsComparable(value.first))
+        { continue; }
+
+        auto base = Collect(history, options.Base, value.first);
+        auto head = Collect(history, options.Head, value.first);
+        if (base.empty() || head.empty())
+        { continue; }
+
+        Comparison r = {};
+        r.Name           = value.first;
+        r.Category       = GetCategory(value.first);
+        r.HigherIsBetter = (value.first.find("fps") != std::string::npos);
+        r.BaseCount      = uint32_t(base.size());
+        r.HeadCount      = uint32_t(head.size());
+
+        double baseDeviation, headDeviation;
+        GetMeanAndDeviation(base, r.BaseMean, baseDeviation);
+        GetMeanAndDeviation(head, r.HeadMean, headDeviation);
+
+        // ばらつきは履歴と今回の計測の大きい方. 値に比べて小さすぎる見積もりは使わない.
+        r.Noise = EstimateNoise(history, noiseCommits, value.first);
+        r.Noise = (headDeviation > r.Noise) ? headDeviation : r.Noise;
+        auto minNoise = MinNoiseRatio * fabs(r.BaseMean);
+        r.Noise = (r.Noise > minNoise) ? r.Noise : minNoise;
+
+        auto worse = r.HigherIsBetter ? (r.BaseMean - r.HeadMean) : (r.HeadMean - r.BaseMean);
+        r.Change = (r.BaseMean != 0.0) ? worse / fabs(r.BaseMean) : 0.0;
+
+        auto standardError = r.Noise * sqrt(1.0 / double(r.BaseCount) + 1.0 / double(r.HeadCount));
+        r.Score = (standardError > 0.0) ? worse / standardError : 0.0;
+
+        // 統計的に有意で, かつ一定以上の変化だけを報告する.
+        auto significant = (standardError > 0.0) ? (fabs(r.Score) >= options.Sigma) : (worse != 0.0);
+        auto large       = fabs(r.Change) >= options.Threshold;
+        if (significant && large)
+        { r.Verdict = (worse > 0.0) ? 1 : -1; }
+
+        results.push_back(r);
+    }
+
+    auto text = FormatText(options, results);
+    printf("%s", text.c_str());
+
+    if (!options.TextPath.empty() && !WriteText(options.TextPath, text))
+    {
+        fprintf(stderr, "Error : Report Write Failed. path = %s\n", options.TextPath.c_str());
+        return -1;
+    }
+
+    if (!options.HtmlPath.empty() && !WriteText(options.HtmlPath, FormatHtml(options, results)))
+    {
+        fprintf(stderr, "Error : Report Write Failed. path = %s\n", options.HtmlPath.c_str());
+        return -1;
+    }
+
+    for (auto& r : results)
+    {
+        if (r.Verdict > 0)
+        { return 1; }
+    }
+
+    return 0;
+}
+
+} // namespace
+
+
+//-----------------------------------------------------------------------------
+//      メインエントリーポイントです.
+//-----------------------------------------------------------------------------
+int main(int argc, char** argv)
+{
+    if (argc < 2)
+    {
+        PrintUsage();
+        return -1;
+    }
+
+    if (strcmp(argv[1], "add") == 0)
+    { return AddCommand(argc, argv); }
+
+    if (strcmp(argv[1], "list") == 0)
+    { return ListCommand(argc, argv); }
+
+    if (strcmp(argv[1], "compare") == 0)
+    { return CompareCommand(argc, argv); }
+
+    PrintUsage();
+    return -1;
+}
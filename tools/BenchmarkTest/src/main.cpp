@@ -0,0 +1,385 @@
+﻿//-----------------------------------------------------------------------------
+// File : main.cpp
+// Desc : Benchmark Runner Test Entry Point.
+// Copyright(c) Pocol. All right reserved.
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------
+#include "Benchmark.h"
+#include "JsonParser.h"
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <initializer_list>
+#include <sstream>
+#include <string>
+#include <vector>
+
+
+namespace {
+
+//-----------------------------------------------------------------------------
+// Constant Values.
+//-----------------------------------------------------------------------------
+constexpr double        Pi          = 3.14159265358979;         // 円周率.
+constexpr const char*   JsonPath    = "BenchmarkTest_result.json";
+
+uint32_t g_FailCount = 0;   // 失敗した確認の数.
+
+//-----------------------------------------------------------------------------
+//      確認結果を表示します.
+//-----------------------------------------------------------------------------
+void Check(bool condition, const char* name)
+{
+    printf("[%s] %s\n", condition ? "PASS" : "FAIL", name);
+    if (!condition)
+    { g_FailCount++; }
+}
+
+//-----------------------------------------------------------------------------
+//      コマンドライン引数を読み取ります(先頭はプログラム名).
+//-----------------------------------------------------------------------------
+bool Parse(std::initializer_list<const wchar_t*> args, BenchmarkSettings& settings)
+{
+    std::vector<std::wstring> values;
+    values.emplace_back(L"D3D12Practice");
+    for (auto arg : args)
+    { values.emplace_back(arg); }
+
+    std::vector<wchar_t*> argv;
+    for (auto& value : values)
+    { argv.push_back(&value[0]); }
+
+    return ParseBenchmarkArgs(int(argv.size()), argv.data(), settings);
+}
+
+//-----------------------------------------------------------------------------
+//      数値のメンバーが期待値と一致するかチェックします.
+//-----------------------------------------------------------------------------
+bool IsNumber(const JsonValue* pObject, const char* key, double expected, double tolerance)
+{
+    if (pObject == nullptr)
+    { return false; }
+
+    auto pValue = pObject->Find(key);
+    return pValue != nullptr
+        && pValue->Type == JSON_TYPE_NUMBER
+        && std::fabs(pValue->Number - expected) <= tolerance;
+}
+
+//-----------------------------------------------------------------------------
+//      オブジェクトが指定したキーだけを持つかチェックします.
+//-----------------------------------------------------------------------------
+bool HasKeys(const JsonValue* pObject, std::initializer_list<const char*> keys)
+{
+    if (pObject == nullptr || pObject->Type != JSON_TYPE_OBJECT || pObject->Object.size() != keys.size())
+    { return false; }
+
+    for (auto key : keys)
+    {
+        if (pObject->Find(key) == nullptr)
+        { return false; }
+    }
+
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+//      計測を最後まで進めます(CPU は 1..N [ms], GPU は奇数フレームだけ).
+//-----------------------------------------------------------------------------
+void RunFrames(Benchmark& benchmark)
+{
+    auto& settings = benchmark.GetSettings();
+    for (auto i = 0u; i < settings.WarmupFrames; ++i)
+    { benchmark.AddFrame(1000.0f, 1000.0f); }   // 計測前の値は集計に入らない.
+
+    for (auto i = 1u; i <= settings.MeasureFrames; ++i)
+    { benchmark.AddFrame(float(i), (i % 2 == 1) ? float(i) * 0.5f : -1.0f); }
+}
+
+//-----------------------------------------------------------------------------
+//      引数の読み取りのテストです.
+//-----------------------------------------------------------------------------
+void TestParseArgs()
+{
+    {
+        BenchmarkSettings settings;
+        auto ok = Parse({}, settings);
+        Check(ok && !settings.Enable && settings.Width == 1920 && settings.Height == 1080
+            && settings.WarmupFrames == 120 && settings.MeasureFrames == 600 && settings.GridSize == 4
+            && settings.Label.empty() && settings.OutputPath == "benchmark.json",
+            "args: no options keeps the defaults");
+    }
+
+    {
+        BenchmarkSettings settings;
+        auto ok = Parse({ L"-benchmark", L"-width", L"1280", L"-height", L"720", L"-warmup", L"0",
+            L"-frames", L"30", L"-grid", L"16", L"-label", L"nightly-42", L"-out", L"out/run.json" }, settings);
+        Check(ok && settings.Enable && settings.Width == 1280 && settings.Height == 720
+            && settings.WarmupFrames == 0 && settings.MeasureFrames == 30 && settings.GridSize == 16
+            && settings.Label == "nightly-42" && settings.OutputPath == "out/run.json",
+            "args: every option is read, in any order with -benchmark first");
+    }
+
+    {
+        BenchmarkSettings settings;
+        auto ok = Parse({ L"-grid", L"2", L"-benchmark" }, settings);
+        Check(ok && settings.Enable && settings.GridSize == 2, "args: -benchmark takes no value");
+    }
+
+    {
+        BenchmarkSettings settings;
+        auto ok = Parse({ L"-label", L"r\u00e9sum\u00e9" }, settings);
+        Check(ok && settings.Label == "r?sum?", "args: non-ASCII characters become '?'");
+    }
+
+    const struct { std::initializer_list<const wchar_t*> Args; const char* Name; } invalid[] = {
+        { { L"-fullscreen" },           "args: unknown option is rejected" },
+        { { L"-width" },                "args: missing value is rejected" },
+        { { L"-width", L"0" },          "args: zero width is rejected" },
+        { { L"-height", L"16385" },     "args: height above the limit is rejected" },
+        { { L"-frames", L"0" },         "args: zero measured frames is rejected" },
+        { { L"-grid", L"0" },           "args: grid 0 is rejected" },
+        { { L"-grid", L"17" },          "args: grid above MaxGridSize is rejected" },
+        { { L"-warmup", L"12x" },       "args: trailing characters are rejected" },
+        { { L"-warmup", L"" },          "args: empty number is rejected" },
+    };
+
+    for (auto& test : invalid)
+    {
+        BenchmarkSettings settings;
+        Check(!Parse(test.Args, settings), test.Name);
+    }
+}
+
+//-----------------------------------------------------------------------------
+//      状態遷移のテストです.
+//-----------------------------------------------------------------------------
+void TestStateMachine()
+{
+    Benchmark benchmark;
+    Check(benchmark.GetState() == BENCHMARK_STATE_IDLE && !benchmark.IsRunning(), "state: idle before Start");
+
+    // 開始前のフレームは何も進めない.
+    benchmark.AddFrame(1.0f, 1.0f);
+    Check(benchmark.GetState() == BENCHMARK_STATE_IDLE, "state: AddFrame before Start is ignored");
+
+    BenchmarkSettings settings;
+    settings.WarmupFrames  = 3;
+    settings.MeasureFrames = 5;
+    benchmark.Start(settings);
+
+    auto ok = (benchmark.GetState() == BENCHMARK_STATE_WARMUP);
+    for (auto i = 0u; i < settings.WarmupFrames; ++i)
+    {
+        ok = ok && benchmark.IsRunning() && benchmark.GetState() == BENCHMARK_STATE_WARMUP;
+        benchmark.AddFrame(1.0f, 1.0f);
+    }
+    Check(ok && benchmark.GetState() == BENCHMARK_STATE_MEASURE, "state: warmup lasts exactly WarmupFrames");
+
+    ok = true;
+    for (auto i = 0u; i < settings.MeasureFrames; ++i)
+    {
+        ok = ok && benchmark.GetState() == BENCHMARK_STATE_MEASURE;
+        benchmark.AddFrame(2.0f, -1.0f);
+    }
+    Check(ok && benchmark.GetState() == BENCHMARK_STATE_FINISHED && !benchmark.IsRunning(),
+        "state: measure lasts exactly MeasureFrames, then finishes");
+
+    benchmark.AddFrame(100.0f, 100.0f);
+    Check(benchmark.GetState() == BENCHMARK_STATE_FINISHED && benchmark.FormatReport().find("5 frames") != std::string::npos,
+        "state: frames after finishing are not recorded");
+
+    settings.WarmupFrames = 0;
+    benchmark.Start(settings);
+    Check(benchmark.GetState() == BENCHMARK_STATE_MEASURE, "state: zero warmup starts measuring at once");
+}
+
+//-----------------------------------------------------------------------------
+//      カメラの軌道のテストです.
+//-----------------------------------------------------------------------------
+void TestCameraPath()
+{
+    BenchmarkSettings settings;
+    settings.WarmupFrames  = 0;
+    settings.MeasureFrames = Benchmark::CameraPathFrames * 2;
+
+    Benchmark a;
+    Benchmark b;
+    Check(a.GetCameraStep().RotateH == 0.0f, "camera: no movement before Start");
+
+    a.Start(settings);
+    b.Start(settings);
+
+    // 1周で水平に 2pi 回り, 垂直とドリーは元に戻る. 2回の実行は同じ軌道をたどる.
+    auto same = true;
+    double rotateH = 0.0, rotateV = 0.0, dolly = 0.0, maxTilt = 0.0, tilt = 0.0;
+    for (auto i = 0u; i < Benchmark::CameraPathFrames; ++i)
+    {
+        auto sa = a.GetCameraStep();
+        auto sb = b.GetCameraStep();
+        same = same && memcmp(&sa, &sb, sizeof(sa)) == 0;
+
+        rotateH += sa.RotateH;
+        rotateV += sa.RotateV;
+        dolly   += sa.Dolly;
+        tilt    += sa.RotateV;
+        maxTilt = std::fmax(maxTilt, std::fabs(tilt));
+
+        a.AddFrame(16.0f, 8.0f);
+        b.AddFrame(33.0f, -1.0f);   // 計測値は軌道に影響しない.
+    }
+
+    Check(same, "camera: path depends only on the frame index");
+    Check(std::fabs(rotateH - 2.0 * Pi) < 1e-4, "camera: one orbit per CameraPathFrames");
+    Check(std::fabs(rotateV) < 1e-4 && std::fabs(dolly) < 1e-4, "camera: tilt and dolly return to the start");
+    Check(maxTilt > 0.2 && maxTilt < 0.3, "camera: tilt stays within the scripted range");
+}
+
+//-----------------------------------------------------------------------------
+//      JSON の出力のテストです.
+//-----------------------------------------------------------------------------
+void TestJson()
+{
+    BenchmarkSettings settings;
+    settings.Width         = 1280;
+    settings.Height        = 720;
+    settings.WarmupFrames  = 10;
+    settings.MeasureFrames = 100;
+    settings.GridSize      = 8;
+    settings.Label         = "a\"b\\c\td";
+
+    Benchmark benchmark;
+    benchmark.Start(settings);
+
+    // 途中で書き出したものは未完了と分かる.
+    {
+        JsonValue root;
+        auto json = benchmark.ExportJson();
+        auto ok = JsonParser::Parse(json, root);
+        auto pCompleted = root.Find("completed");
+        auto pCpu = root.Find("cpu_frame_ms");
+        Check(ok && pCompleted != nullptr && pCompleted->Type == JSON_TYPE_BOOL && !pCompleted->Bool
+            && IsNumber(pCpu, "count", 0.0, 0.0) && IsNumber(pCpu, "mean", 0.0, 0.0),
+            "json: unfinished run is valid JSON marked incomplete");
+    }
+
+    RunFrames(benchmark);
+    benchmark.SetMetric("draw_calls", 10.0);
+    benchmark.SetMetric("time_to_first_frame_ms", 1234.5);
+    benchmark.SetMetric("draw_calls", 128.0);
+
+    JsonValue root;
+    auto json = benchmark.ExportJson();
+    Check(JsonParser::Parse(json, root) && root.Type == JSON_TYPE_OBJECT, "json: output is strict JSON");
+
+    Check(HasKeys(&root, { "version", "label", "configuration", "completed", "settings",
+        "cpu_frame_ms", "gpu_frame_ms", "fps", "metrics" }), "json: top-level keys");
+
+    auto pLabel = root.Find("label");
+    auto pConfig = root.Find("configuration");
+    auto pCompleted = root.Find("completed");
+    Check(IsNumber(&root, "version", 1.0, 0.0)
+        && pLabel != nullptr && pLabel->String == "a\"b\\c d"
+        && pConfig != nullptr && pConfig->Type == JSON_TYPE_STRING && !pConfig->String.empty()
+        && pCompleted != nullptr && pCompleted->Bool,
+        "json: version, escaped label, configuration and completed");
+
+    auto pSettings = root.Find("settings");
+    Check(HasKeys(pSettings, { "width", "height", "warmup_frames", "measure_frames", "grid_size",
+        "instance_count", "camera_path_frames" })
+        && IsNumber(pSettings, "width", 1280.0, 0.0)
+        && IsNumber(pSettings, "height", 720.0, 0.0)
+        && IsNumber(pSettings, "warmup_frames", 10.0, 0.0)
+        && IsNumber(pSettings, "measure_frames", 100.0, 0.0)
+        && IsNumber(pSettings, "grid_size", 8.0, 0.0)
+        && IsNumber(pSettings, "instance_count", 64.0, 0.0)
+        && IsNumber(pSettings, "camera_path_frames", double(Benchmark::CameraPathFrames), 0.0),
+        "json: settings");
+
+    // CPU は 1..100 [ms] なので最近傍順位法の値が分かる. 計測前のフレームは入らない.
+    auto pCpu = root.Find("cpu_frame_ms");
+    Check(HasKeys(pCpu, { "count", "min", "mean", "max", "p50", "p95", "p99", "low1" })
+        && IsNumber(pCpu, "count", 100.0, 0.0)
+        && IsNumber(pCpu, "min", 1.0, 1e-4)
+        && IsNumber(pCpu, "mean", 50.5, 1e-4)
+        && IsNumber(pCpu, "max", 100.0, 1e-4)
+        && IsNumber(pCpu, "p50", 50.0, 1e-4)
+        && IsNumber(pCpu, "p95", 95.0, 1e-4)
+        && IsNumber(pCpu, "p99", 99.0, 1e-4)
+        && IsNumber(pCpu, "low1", 100.0, 1e-4),
+        "json: cpu_frame_ms statistics");
+
+    // GPU は計測値のある奇数フレームだけ(0.5, 1.5, ... 49.5).
+    auto pGpu = root.Find("gpu_frame_ms");
+    Check(HasKeys(pGpu, { "count", "min", "mean", "max", "p50", "p95", "p99", "low1" })
+        && IsNumber(pGpu, "count", 50.0, 0.0)
+        && IsNumber(pGpu, "min", 0.5, 1e-4)
+        && IsNumber(pGpu, "mean", 25.0, 1e-4)
+        && IsNumber(pGpu, "max", 49.5, 1e-4)
+        && IsNumber(pGpu, "p50", 24.5, 1e-4),
+        "json: gpu_frame_ms skips frames without a GPU time");
+
+    auto pFps = root.Find("fps");
+    Check(HasKeys(pFps, { "mean", "low1" })
+        && IsNumber(pFps, "mean", 1000.0 / 50.5, 1e-3)
+        && IsNumber(pFps, "low1", 10.0, 1e-3),
+        "json: fps from mean and 1% low");
+
+    auto pMetrics = root.Find("metrics");
+    Check(HasKeys(pMetrics, { "draw_calls", "time_to_first_frame_ms" })
+        && IsNumber(pMetrics, "draw_calls", 128.0, 0.0)
+        && IsNumber(pMetrics, "time_to_first_frame_ms", 1234.5, 0.0),
+        "json: metrics keep full precision and the last value per name");
+
+    // ファイルに書いたものは文字列と同じ.
+    remove(JsonPath);
+    auto written = benchmark.WriteJson(JsonPath);
+    std::ifstream stream(JsonPath, std::ios::binary);
+    std::stringstream text;
+    text << stream.rdbuf();
+    Check(written && text.str() == json, "json: WriteJson writes ExportJson");
+    stream.close();
+    remove(JsonPath);
+
+    Check(!benchmark.WriteJson(nullptr) && !benchmark.WriteJson("no_such_dir/result.json"),
+        "json: WriteJson fails on a bad path");
+}
+
+//-----------------------------------------------------------------------------
+//      使い方を表示します.
+//-----------------------------------------------------------------------------
+void PrintUsage()
+{ printf("Usage : BenchmarkTest\n"); }
+
+} // namespace
+
+
+//-----------------------------------------------------------------------------
+//      メインエントリーポイントです.
+//-----------------------------------------------------------------------------
+int main(int argc, char** argv)
+{
+    if (argc > 1)
+    {
+        PrintUsage();
+        return (strcmp(argv[1], "--help") == 0) ? 0 : -1;
+    }
+
+    TestParseArgs();
+    TestStateMachine();
+    TestCameraPath();
+    TestJson();
+
+    if (g_FailCount > 0)
+    {
+        fprintf(stderr, "Error : %u check(s) failed.\n", g_FailCount);
+        return -1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,229 @@
+﻿//-----------------------------------------------------------------------------
+// File : main.cpp
+// Desc : Draw List Sort Throughput Benchmark Entry Point.
+// Copyright(c) Pocol. All right reserved.
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------
+#include "DrawList.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <thread>
+#include <vector>
+
+
+namespace {
+
+//-----------------------------------------------------------------------------
+// Constant Values.
+//-----------------------------------------------------------------------------
+constexpr uint32_t      DefaultMinCount     = 10000;            // 既定の最小の描画数.
+constexpr uint32_t      DefaultMaxCount     = 1000000;          // 既定の最大の描画数.
+constexpr uint32_t      DefaultRepeat       = 5;                // 既定の計測回数(最短を採ります).
+constexpr uint32_t      PipelineCount       = 64;               // シーンのパイプライン数.
+constexpr uint32_t      MaterialCount       = 2048;             // シーンのマテリアル数.
+constexpr uint32_t      PassCount           = 3;                // シーンのパス数(プリパス, 不透明, 半透明).
+
+///////////////////////////////////////////////////////////////////////////////
+// Timer class
+///////////////////////////////////////////////////////////////////////////////
+class Timer
+{
+public:
+    Timer()
+    : m_Begin(std::chrono::steady_clock::now())
+    { /* DO_NOTHING */ }
+
+    double GetElapsedMs() const
+    { return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - m_Begin).count(); }
+
+private:
+    std::chrono::steady_clock::time_point m_Begin;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// Result structure
+///////////////////////////////////////////////////////////////////////////////
+struct Result
+{
+    double  Ms;         //!< 1回のソートの最短時間[ms]です.
+    bool    Match;      //!< std::stable_sort と同じ並びになったかどうか.
+};
+
+//-----------------------------------------------------------------------------
+//      シーンに相当するソートキーを生成します.
+//-----------------------------------------------------------------------------
+void CreateKeys(uint32_t count, std::vector<DrawPacket>& packets)
+{
+    std::mt19937 rng(count);
+    std::uniform_int_distribution<uint32_t> pipeline(0, PipelineCount - 1);
+    std::uniform_int_distribution<uint32_t> material(0, MaterialCount - 1);
+    std::uniform_int_distribution<uint32_t> pass    (0, PassCount - 1);
+    std::uniform_real_distribution<float>   depth   (0.1f, 1000.0f);
+
+    packets.resize(count);
+    for (auto i = 0u; i < count; ++i)
+    {
+        // 半透明パスだけ奥から手前に並べる(SampleApp と同じ).
+        auto p     = pass(rng);
+        auto order = (p == PassCount - 1) ? DRAW_ORDER_BACK_TO_FRONT : DRAW_ORDER_STATE;
+        packets[i].Key      = MakeDrawKey(order, p, pipeline(rng), material(rng), depth(rng));
+        packets[i].Index    = i;
+        packets[i].Reserved = 0;
+    }
+}
+
+//-----------------------------------------------------------------------------
+//      DrawList::Sort を計測します.
+//-----------------------------------------------------------------------------
+Result MeasureDrawList
+(
+    const std::vector<DrawPacket>&  packets,
+    const std::vector<DrawPacket>&  expected,
+    uint32_t                        threadCount,
+    uint32_t                        repeat
+)
+{
+    DrawList list;
+    list.Reserve(packets.size());
+
+    Result result = { 1e30, true };
+    for (auto r = 0u; r < repeat; ++r)
+    {
+        // 積み直しはフレームごとに行うものなので計測に含めない.
+        list.Clear();
+        for (auto& packet : packets)
+        { list.Push(packet.Key, packet.Index); }
+
+        Timer timer;
+        list.Sort(threadCount);
+        result.Ms = std::min(result.Ms, timer.GetElapsedMs());
+
+        auto pSorted = list.GetPackets();
+        for (size_t i = 0; i < expected.size() && result.Match; ++i)
+        { result.Match = (pSorted[i].Key == expected[i].Key && pSorted[i].Index == expected[i].Index); }
+    }
+
+    return result;
+}
+
+//-----------------------------------------------------------------------------
+//      std::stable_sort を計測し, 期待する並びを作ります.
+//-----------------------------------------------------------------------------
+Result MeasureStableSort
+(
+    const std::vector<DrawPacket>&  packets,
+    std::vector<DrawPacket>&        expected,
+    uint32_t                        repeat
+)
+{
+    Result result = { 1e30, true };
+    for (auto r = 0u; r < repeat; ++r)
+    {
+        expected = packets;
+
+        Timer timer;
+        std::stable_sort(expected.begin(), expected.end(),
+            [](const DrawPacket& lhs, const DrawPacket& rhs) { return lhs.Key < rhs.Key; });
+        result.Ms = std::min(result.Ms, timer.GetElapsedMs());
+    }
+
+    return result;
+}
+
+//-----------------------------------------------------------------------------
+//      使い方を表示します.
+//-----------------------------------------------------------------------------
+void PrintUsage()
+{
+    printf("Usage : DrawListBench [options]\n");
+    printf("    --min <n>           min draw count, multiplied by 10 (default %u)\n", DefaultMinCount);
+    printf("    --max <n>           max draw count (default %u)\n", DefaultMaxCount);
+    printf("    --threads <n>       threads for the parallel path (default hardware threads)\n");
+    printf("    --repeat <n>        sorts per measurement, fastest is reported (default %u)\n", DefaultRepeat);
+}
+
+} // namespace
+
+
+//-----------------------------------------------------------------------------
+//      メインエントリーポイントです.
+//-----------------------------------------------------------------------------
+int main(int argc, char** argv)
+{
+    auto minCount = DefaultMinCount;
+    auto maxCount = DefaultMaxCount;
+    auto repeat   = DefaultRepeat;
+    auto threads  = std::max(1u, std::thread::hardware_concurrency());
+
+    for (auto i = 1; i < argc; ++i)
+    {
+        auto hasValue = (i + 1 < argc);
+        if (strcmp(argv[i], "--min") == 0 && hasValue)
+        { minCount = uint32_t(strtoul(argv[++i], nullptr, 10)); }
+        else if (strcmp(argv[i], "--max") == 0 && hasValue)
+        { maxCount = uint32_t(strtoul(argv[++i], nullptr, 10)); }
+        else if (strcmp(argv[i], "--threads") == 0 && hasValue)
+        { threads = uint32_t(strtoul(argv[++i], nullptr, 10)); }
+        else if (strcmp(argv[i], "--repeat") == 0 && hasValue)
+        { repeat = uint32_t(strtoul(argv[++i], nullptr, 10)); }
+        else
+        {
+            PrintUsage();
+            return -1;
+        }
+    }
+
+    if (minCount < 2 || maxCount < minCount || threads == 0 || repeat == 0)
+    {
+        PrintUsage();
+        return -1;
+    }
+
+    printf("parallel threads : %u, threshold : %zu\n", threads, size_t(DrawList::ParallelThreshold));
+    printf("%10s %12s %12s %12s %12s %10s %12s %6s\n",
+        "draws", "std[ms]", "single[ms]", "parallel[ms]", "auto[ms]", "speedup", "Mdraws/s", "auto");
+
+    auto failed   = false;
+    auto hardware = std::thread::hardware_concurrency();
+
+    std::vector<DrawPacket> packets;
+    std::vector<DrawPacket> expected;
+    for (auto count = uint64_t(minCount); count <= maxCount; count *= 10)
+    {
+        CreateKeys(uint32_t(count), packets);
+
+        auto baseline  = MeasureStableSort(packets, expected, repeat);
+        auto single    = MeasureDrawList  (packets, expected, 1,       repeat);
+        auto parallel  = MeasureDrawList  (packets, expected, threads, repeat);
+        auto automatic = MeasureDrawList  (packets, expected, 0,       repeat);
+
+        // 自動選択が速い方を選んでいるかを見るため, どちらの経路になったかも出す.
+        auto best = std::min(single.Ms, parallel.Ms);
+        printf("%10llu %12.3f %12.3f %12.3f %12.3f %9.2fx %12.1f %6s\n",
+            static_cast<unsigned long long>(count),
+            baseline.Ms,
+            single.Ms,
+            parallel.Ms,
+            automatic.Ms,
+            single.Ms / parallel.Ms,
+            double(count) / (best * 1000.0),
+            (count >= DrawList::ParallelThreshold && hardware > 1) ? "par" : "single");
+
+        if (!single.Match || !parallel.Match || !automatic.Match)
+        {
+            fprintf(stderr, "Error : Sort Result Mismatch. draws = %llu, single = %d, parallel = %d, auto = %d\n",
+                static_cast<unsigned long long>(count), single.Match, parallel.Match, automatic.Match);
+            failed = true;
+        }
+    }
+
+    return failed ? -1 : 0;
+}
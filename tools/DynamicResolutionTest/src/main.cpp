@@ -0,0 +1,306 @@
+﻿//-----------------------------------------------------------------------------
+// File : main.cpp
+// Desc : Dynamic Resolution Trace Replay Test Entry Point.
+// Copyright(c) Pocol. All right reserved.
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------
+#include "DynamicResolution.h"
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+
+namespace {
+
+//-----------------------------------------------------------------------------
+// Constant Values.
+//-----------------------------------------------------------------------------
+constexpr uint32_t      FrameCount      = 2;        // 計測結果が届くまでのフレーム数(SampleApp と同じ).
+constexpr uint32_t      SettleFrames    = 20;       // 負荷の急変後, 超過を許すフレーム数.
+constexpr uint32_t      StepWindow      = 8;        // 負荷の急変を判定する区間のフレーム数.
+constexpr float         StepRatio       = 1.5f;     // 区間の平均がこの倍率を超えたら急変とします.
+constexpr const char*   TraceDirs[]     = { "traces", "tools/DynamicResolutionTest/traces" };
+
+///////////////////////////////////////////////////////////////////////////////
+// TraceFrame structure
+///////////////////////////////////////////////////////////////////////////////
+struct TraceFrame
+{
+    float   FullMs;     //!< 拡大率 1.0 でのGPUフレーム時間[ms]です.
+    float   FixedMs;    //!< 解像度に依存しない部分[ms]です.
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// Expectation structure
+///////////////////////////////////////////////////////////////////////////////
+struct Expectation
+{
+    const char* Name;               //!< トレースのファイル名です.
+    uint32_t    MaxChanges;         //!< 拡大率の変更回数の上限です.
+    float       MaxOverRate;        //!< 急変直後を除いた予算超過フレームの割合の上限です.
+    float       FinalScale;         //!< 最後の拡大率です(負なら確認しません).
+};
+
+// 既定の設定(予算 15ms, 余裕 0.85, 刻み 0.05)での期待値.
+const Expectation g_Expectations[] = {
+    { "steady_light.csv",   0,  0.00f,  1.0f },     // 余裕があれば何もしない.
+    { "spike.csv",          12, 0.02f,  1.0f },     // 重い区間で下げ, 抜けたら戻す.
+    { "ramp.csv",           16, 0.05f,  -1.0f },    // 負荷の増加に付いていく(平均が予算を超えてから下げるので僅かに超える).
+    { "alternating.csv",    0,  0.50f,  1.0f },     // 平均が予算内なら揺れない(重いフレームは個別には追わない).
+    { "hitches.csv",        0,  0.01f,  1.0f },     // 単発のヒッチでは下げない(ヒッチのフレームだけが超える).
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// ReplayResult structure
+///////////////////////////////////////////////////////////////////////////////
+struct ReplayResult
+{
+    uint32_t    Frames;         //!< フレーム数です.
+    uint32_t    OverBudget;     //!< 予算を超えたフレーム数です.
+    uint32_t    OverCounted;    //!< 急変直後を除いた予算超過フレーム数です.
+    uint32_t    Changes;        //!< 拡大率の変更回数です.
+    uint32_t    Reversals;      //!< 上げた直後に下げた(またはその逆)回数です.
+    float       MinScale;       //!< 最小の拡大率です.
+    float       FinalScale;     //!< 最後の拡大率です.
+    double      AverageMs;      //!< 平均GPUフレーム時間[ms]です.
+};
+
+//-----------------------------------------------------------------------------
+//      トレースを読み込みます.
+//-----------------------------------------------------------------------------
+bool LoadTrace(const std::string& path, std::vector<TraceFrame>& frames)
+{
+    auto pFile = fopen(path.c_str(), "r");
+    if (pFile == nullptr)
+    { return false; }
+
+    frames.clear();
+
+    char line[256];
+    while (fgets(line, sizeof(line), pFile) != nullptr)
+    {
+        // コメントと見出しは読み飛ばす.
+        if (line[0] == '#' || line[0] == 'f' || line[0] == '\n' || line[0] == '\r')
+        { continue; }
+
+        TraceFrame frame = {};
+        if (sscanf(line, "%f,%f", &frame.FullMs, &frame.FixedMs) == 2)
+        { frames.push_back(frame); }
+    }
+
+    fclose(pFile);
+    return !frames.empty();
+}
+
+//-----------------------------------------------------------------------------
+//      トレースを再生します.
+//-----------------------------------------------------------------------------
+//! @note       各フレームはその時点の拡大率で描かれ, GPU時間は解像度に依存する部分が画素数に比例するとします.
+//!             計測値は FrameCount フレーム後に Update() へ渡します(GpuTimer と同じ遅れ).
+//-----------------------------------------------------------------------------
+ReplayResult Replay(const std::vector<TraceFrame>& trace, DynamicResolution& resolution)
+{
+    auto& settings = resolution.GetSettings();
+    resolution.Reset();
+
+    ReplayResult result = {};
+    result.MinScale = resolution.GetScale();
+
+    std::vector<float> measured(trace.size(), 0.0f);
+    auto   lastDirection = 0;
+    auto   settle        = 0u;
+    double totalMs       = 0.0;
+
+    for (size_t i = 0; i < trace.size(); ++i)
+    {
+        auto before = resolution.GetScale();
+        if (i >= FrameCount)
+        { resolution.Update(measured[i - FrameCount]); }
+
+        auto scale = resolution.GetScale();
+        if (scale != before)
+        {
+            auto direction = (scale > before) ? 1 : -1;
+            if (lastDirection != 0 && direction != lastDirection)
+            { result.Reversals++; }
+            lastDirection = direction;
+            result.Changes++;
+        }
+
+        // 負荷が急に変わった直後は, 追いつくまでの超過を数えない.
+        if (i >= StepWindow && i + StepWindow <= trace.size())
+        {
+            auto before = 0.0f;
+            auto after  = 0.0f;
+            for (auto k = 0u; k < StepWindow; ++k)
+            {
+                before += trace[i - 1 - k].FullMs;
+                after  += trace[i + k].FullMs;
+            }
+
+            if (after > before * StepRatio)
+            { settle = SettleFrames; }
+        }
+
+        auto& frame = trace[i];
+        auto  ms    = frame.FixedMs + (frame.FullMs - frame.FixedMs) * scale * scale;
+        measured[i] = ms;
+        totalMs    += ms;
+
+        if (ms > settings.TargetMs)
+        {
+            result.OverBudget++;
+            if (settle == 0)
+            { result.OverCounted++; }
+        }
+
+        if (settle > 0)
+        { settle--; }
+
+        if (scale < result.MinScale)
+        { result.MinScale = scale; }
+    }
+
+    result.Frames     = uint32_t(trace.size());
+    result.FinalScale = resolution.GetScale();
+    result.AverageMs  = totalMs / double(trace.size());
+    return result;
+}
+
+//-----------------------------------------------------------------------------
+//      期待値と比べます.
+//-----------------------------------------------------------------------------
+bool Verify(const Expectation& expect, const ReplayResult& result, const DynamicResolutionSettings& settings)
+{
+    auto overRate = float(result.OverCounted) / float(result.Frames);
+    auto ok = true;
+
+    if (result.Changes > expect.MaxChanges)
+    {
+        printf("    changes %u > %u\n", result.Changes, expect.MaxChanges);
+        ok = false;
+    }
+
+    if (overRate > expect.MaxOverRate)
+    {
+        printf("    over budget rate %.3f > %.3f\n", overRate, expect.MaxOverRate);
+        ok = false;
+    }
+
+    if (expect.FinalScale >= 0.0f && result.FinalScale != expect.FinalScale)
+    {
+        printf("    final scale %.2f != %.2f\n", result.FinalScale, expect.FinalScale);
+        ok = false;
+    }
+
+    if (result.MinScale < settings.MinScale)
+    {
+        printf("    scale %.2f below minimum\n", result.MinScale);
+        ok = false;
+    }
+
+    return ok;
+}
+
+//-----------------------------------------------------------------------------
+//      使い方を表示します.
+//-----------------------------------------------------------------------------
+void PrintUsage()
+{
+    printf("Usage : DynamicResolutionTest [options]\n");
+    printf("    --traces <dir>      directory with the reference traces\n");
+    printf("    --trace <path>      replay one captured trace and print the result only\n");
+}
+
+} // namespace
+
+
+//-----------------------------------------------------------------------------
+//      メインエントリーポイントです.
+//-----------------------------------------------------------------------------
+int main(int argc, char** argv)
+{
+    std::string dir;
+    std::string single;
+
+    for (auto i = 1; i < argc; ++i)
+    {
+        auto hasValue = (i + 1 < argc);
+        if (strcmp(argv[i], "--traces") == 0 && hasValue)
+        { dir = argv[++i]; }
+        else if (strcmp(argv[i], "--trace") == 0 && hasValue)
+        { single = argv[++i]; }
+        else
+        {
+            PrintUsage();
+            return -1;
+        }
+    }
+
+    DynamicResolution resolution;
+    std::vector<TraceFrame> trace;
+
+    printf("%-20s %6s %6s %8s %8s %9s %7s %7s %8s\n",
+        "trace", "frames", "over", "counted", "changes", "reversals", "min", "final", "avg[ms]");
+
+    // 計測したトレースを1つ再生する.
+    if (!single.empty())
+    {
+        if (!LoadTrace(single, trace))
+        {
+            fprintf(stderr, "Error : Trace Load Failed. path = %s\n", single.c_str());
+            return -1;
+        }
+
+        auto result = Replay(trace, resolution);
+        printf("%-20s %6u %6u %8u %8u %9u %7.2f %7.2f %8.2f\n",
+            "(captured)", result.Frames, result.OverBudget, result.OverCounted,
+            result.Changes, result.Reversals, result.MinScale, result.FinalScale, result.AverageMs);
+        return 0;
+    }
+
+    auto failed = 0u;
+    for (auto& expect : g_Expectations)
+    {
+        auto loaded = false;
+        if (!dir.empty())
+        { loaded = LoadTrace(dir + "/" + expect.Name, trace); }
+        else
+        {
+            for (auto candidate : TraceDirs)
+            {
+                loaded = LoadTrace(std::string(candidate) + "/" + expect.Name, trace);
+                if (loaded)
+                { break; }
+            }
+        }
+
+        if (!loaded)
+        {
+            fprintf(stderr, "Error : Trace Load Failed. name = %s\n", expect.Name);
+            return -1;
+        }
+
+        auto result = Replay(trace, resolution);
+        printf("%-20s %6u %6u %8u %8u %9u %7.2f %7.2f %8.2f\n",
+            expect.Name, result.Frames, result.OverBudget, result.OverCounted,
+            result.Changes, result.Reversals, result.MinScale, result.FinalScale, result.AverageMs);
+
+        if (!Verify(expect, result, resolution.GetSettings()))
+        { failed++; }
+    }
+
+    if (failed > 0)
+    {
+        fprintf(stderr, "Error : %u trace(s) failed.\n", failed);
+        return -1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,710 @@
+﻿//-----------------------------------------------------------------------------
+// File : main.cpp
+// Desc : Frame Graph Test And Compile Benchmark Entry Point.
+// Copyright(c) Pocol. All right reserved.
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------
+#include "FrameGraph.h"
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+
+
+namespace {
+
+//-----------------------------------------------------------------------------
+// Constant Values.
+//-----------------------------------------------------------------------------
+constexpr uint32_t  DefaultIterations   = 20;                               // 既定のコンパイル回数.
+constexpr uint32_t  BenchPassCounts[]   = { 50, 100, 200, 500, 1000 };      // 計測するパス数.
+constexpr uint64_t  TargetSize          = 8ull << 20;                       // 一時リソースの既定サイズ.
+constexpr uint64_t  TargetAlignment     = 64ull << 10;                      // 一時リソースの既定アライメント.
+
+uint32_t g_FailCount = 0;   // 失敗した確認の数.
+
+//-----------------------------------------------------------------------------
+//      確認結果を表示します.
+//-----------------------------------------------------------------------------
+void Check(bool condition, const char* name)
+{
+    printf("[%s] %s\n", condition ? "PASS" : "FAIL", name);
+    if (!condition)
+    { g_FailCount++; }
+}
+
+//-----------------------------------------------------------------------------
+//      実行順の位置を取得します.
+//-----------------------------------------------------------------------------
+uint32_t FindOrder(const FrameGraph& graph, FramePassId pass)
+{
+    auto& order = graph.GetOrder();
+    for (auto i = 0u; i < order.size(); ++i)
+    {
+        if (order[i] == pass)
+        { return i; }
+    }
+
+    return FRAME_GRAPH_INVALID_ID;
+}
+
+//-----------------------------------------------------------------------------
+//      実行順のバリアから指定種類のものを数えます.
+//-----------------------------------------------------------------------------
+uint32_t CountBarriers(const FrameGraph& graph, uint32_t order, FRAME_BARRIER_TYPE type, FrameResourceId resource)
+{
+    uint32_t count = 0;
+    auto pBarriers = graph.GetBarriers(order, count);
+
+    uint32_t result = 0;
+    for (auto i = 0u; i < count; ++i)
+    {
+        if (pBarriers[i].Type == type && pBarriers[i].Resource == resource)
+        { result++; }
+    }
+
+    return result;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Declared structure
+///////////////////////////////////////////////////////////////////////////////
+//! @note       検証用に, グラフに宣言したアクセスを控えておきます.
+///////////////////////////////////////////////////////////////////////////////
+struct Declared
+{
+    struct Access
+    {
+        FrameResourceId Resource;
+        uint32_t        Usage;
+        bool            Write;
+    };
+
+    std::vector<std::vector<Access>>    Passes;         //!< パスごとのアクセスです.
+    std::vector<bool>                   SideEffects;    //!< 除去しないパスかどうか.
+};
+
+//-----------------------------------------------------------------------------
+//      コンパイル結果の不変条件を検証します.
+//-----------------------------------------------------------------------------
+//! @note       (1) 依存するパスは先に実行される.
+//!             (2) バリアを順に適用すると, 全てのアクセスが宣言した状態で行われる.
+//!             (3) 寿命の重なる一時リソースはメモリを共有しない. 配置はアライメントを満たす.
+//!             (4) 除去されたパスの書き込みは, 残ったパスから読まれない.
+//-----------------------------------------------------------------------------
+bool Validate(const FrameGraph& graph, const Declared& declared, uint32_t resourceCount, const char** ppReason)
+{
+    auto& order = graph.GetOrder();
+
+    // 各リソースの最後の書き込み(宣言順)を辿り, 読み込む側より先に実行されることを確かめる.
+    std::vector<uint32_t> lastWriter(resourceCount, FRAME_GRAPH_INVALID_ID);
+    std::vector<std::vector<uint32_t>> readers(resourceCount);
+    for (auto p = 0u; p < declared.Passes.size(); ++p)
+    {
+        for (auto& access : declared.Passes[p])
+        {
+            auto r = access.Resource;
+            auto writer = lastWriter[r];
+            if (!graph.IsCulled(p) && writer != FRAME_GRAPH_INVALID_ID)
+            {
+                if (graph.IsCulled(writer))
+                { *ppReason = "live pass depends on culled writer"; return false; }
+
+                if (FindOrder(graph, writer) >= FindOrder(graph, p))
+                { *ppReason = "read after write out of order"; return false; }
+            }
+
+            if (access.Write)
+            {
+                if (!graph.IsCulled(p))
+                {
+                    for (auto reader : readers[r])
+                    {
+                        if (!graph.IsCulled(reader) && reader != p && FindOrder(graph, reader) >= FindOrder(graph, p))
+                        { *ppReason = "write after read out of order"; return false; }
+                    }
+                }
+
+                lastWriter[r] = p;
+                readers[r].clear();
+            }
+            else
+            {
+                readers[r].push_back(p);
+            }
+        }
+    }
+
+    // バリアを再生して状態を追う.
+    std::vector<uint32_t> state(resourceCount, FRAME_USAGE_NONE);
+    std::vector<bool>     first(resourceCount, true);
+    for (auto r = 0u; r < resourceCount; ++r)
+    { state[r] = graph.GetResource(r).Imported ? graph.GetResource(r).InitialUsage : FRAME_USAGE_NONE; }
+
+    for (auto i = 0u; i <= order.size(); ++i)
+    {
+        uint32_t count = 0;
+        auto pBarriers = graph.GetBarriers(i, count);
+        for (auto b = 0u; b < count; ++b)
+        {
+            auto& barrier = pBarriers[b];
+            if (barrier.Type != FRAME_BARRIER_TRANSITION)
+            { continue; }
+
+            if (barrier.Before != state[barrier.Resource])
+            { *ppReason = "transition before-state mismatch"; return false; }
+
+            state[barrier.Resource] = barrier.After;
+        }
+
+        if (i == order.size())
+        { break; }
+
+        for (auto& access : declared.Passes[order[i]])
+        {
+            auto r = access.Resource;
+
+            // 一時リソースは最初に使う状態で始まる.
+            if (first[r] && !graph.GetResource(r).Imported)
+            { state[r] = access.Usage; }
+            first[r] = false;
+
+            auto ok = access.Write
+                ? (state[r] == access.Usage)
+                : ((state[r] & access.Usage) == access.Usage && (state[r] & ~uint32_t(FRAME_USAGE_READ_MASK)) == 0);
+            if (!ok)
+            { *ppReason = "access in wrong state"; return false; }
+        }
+    }
+
+    for (auto r = 0u; r < resourceCount; ++r)
+    {
+        auto& res = graph.GetResource(r);
+        if (res.FinalUsage != FRAME_USAGE_NONE && res.FirstOrder != FRAME_GRAPH_INVALID_ID && state[r] != res.FinalUsage)
+        { *ppReason = "final state mismatch"; return false; }
+    }
+
+    // 一時リソースの配置.
+    for (auto a = 0u; a < resourceCount; ++a)
+    {
+        auto& ra = graph.GetResource(a);
+        if (ra.Imported || ra.FirstOrder == FRAME_GRAPH_INVALID_ID)
+        { continue; }
+
+        if (ra.HeapOffset % ra.Transient.Alignment != 0)
+        { *ppReason = "misaligned transient"; return false; }
+
+        if (ra.HeapOffset + ra.Transient.Size > graph.GetStats().HeapBytes)
+        { *ppReason = "transient outside heap"; return false; }
+
+        for (auto b = a + 1; b < resourceCount; ++b)
+        {
+            auto& rb = graph.GetResource(b);
+            if (rb.Imported || rb.FirstOrder == FRAME_GRAPH_INVALID_ID)
+            { continue; }
+
+            auto lifetime = ra.FirstOrder <= rb.LastOrder && rb.FirstOrder <= ra.LastOrder;
+            auto memory   = ra.HeapOffset < rb.HeapOffset + rb.Transient.Size && rb.HeapOffset < ra.HeapOffset + ra.Transient.Size;
+            if (lifetime && memory)
+            { *ppReason = "live transients overlap in memory"; return false; }
+        }
+    }
+
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+//      宣言を控えながらグラフを組み立てる補助です.
+//-----------------------------------------------------------------------------
+class Builder
+{
+public:
+    Builder(FrameGraph& graph)
+    : m_Graph(graph)
+    { /* DO_NOTHING */ }
+
+    FramePassId Pass(const char* name)
+    {
+        m_Declared.Passes.emplace_back();
+        m_Declared.SideEffects.push_back(false);
+        return m_Graph.AddPass(name, nullptr);
+    }
+
+    void Read(FramePassId pass, FrameResourceId resource, uint32_t usage)
+    {
+        m_Graph.Read(pass, resource, usage);
+        Record(pass, resource, usage, false);
+    }
+
+    void Write(FramePassId pass, FrameResourceId resource, uint32_t usage)
+    {
+        m_Graph.Write(pass, resource, usage);
+        Record(pass, resource, usage, true);
+    }
+
+    const Declared& GetDeclared() const
+    { return m_Declared; }
+
+private:
+    FrameGraph& m_Graph;
+    Declared    m_Declared;
+
+    void Record(FramePassId pass, FrameResourceId resource, uint32_t usage, bool write)
+    {
+        // FrameGraph と同じく, 同じパスの重複アクセスはまとめる.
+        for (auto& access : m_Declared.Passes[pass])
+        {
+            if (access.Resource != resource)
+            { continue; }
+
+            if (write)
+            {
+                access.Usage = usage;
+                access.Write = true;
+            }
+            else if (!access.Write)
+            {
+                access.Usage |= usage;
+            }
+            return;
+        }
+
+        m_Declared.Passes[pass].push_back({ resource, usage, write });
+    }
+};
+
+//-----------------------------------------------------------------------------
+//      既定の一時リソースを生成します.
+//-----------------------------------------------------------------------------
+FrameResourceId CreateTarget(FrameGraph& graph, const char* name, uint64_t size = TargetSize)
+{ return graph.Create(name, { size, TargetAlignment }); }
+
+//-----------------------------------------------------------------------------
+//      使われない出力を持つパスの除去を確認します.
+//-----------------------------------------------------------------------------
+void TestCulling()
+{
+    FrameGraph graph;
+    Builder    b(graph);
+
+    auto backBuffer = graph.Import("BackBuffer", FRAME_USAGE_PRESENT, FRAME_USAGE_PRESENT);
+    auto history    = graph.Import("History", FRAME_USAGE_PIXEL_READ, FRAME_USAGE_NONE);
+    auto scene      = CreateTarget(graph, "Scene");
+    auto unused     = CreateTarget(graph, "Unused");
+    auto debug      = CreateTarget(graph, "Debug");
+
+    auto draw     = b.Pass("Draw");
+    auto orphan   = b.Pass("Orphan");
+    auto debugA   = b.Pass("DebugA");
+    auto debugB   = b.Pass("DebugB");
+    auto capture  = b.Pass("Capture");
+    auto overlay  = b.Pass("Overlay");
+    auto tonemap  = b.Pass("Tonemap");
+
+    b.Write(draw, scene, FRAME_USAGE_RENDER_TARGET);
+    b.Write(orphan, unused, FRAME_USAGE_RENDER_TARGET);         // 誰も読まない.
+    b.Write(debugA, debug, FRAME_USAGE_UNORDERED_ACCESS);       // 除去されるパスだけが読む.
+    b.Read (debugB, debug, FRAME_USAGE_PIXEL_READ);
+    b.Read (capture, scene, FRAME_USAGE_COPY_SRC);              // 副作用のある読み込みのみ.
+    graph.SetSideEffect(capture);
+    b.Write(overlay, history, FRAME_USAGE_RENDER_TARGET);       // 最終状態の無い取り込みへの書き込み.
+    b.Read (tonemap, scene, FRAME_USAGE_PIXEL_READ);
+    b.Write(tonemap, backBuffer, FRAME_USAGE_RENDER_TARGET);
+
+    Check(graph.Compile(), "culling graph compiles");
+    Check(!graph.IsCulled(draw) && !graph.IsCulled(tonemap), "passes feeding the back buffer are kept");
+    Check(graph.IsCulled(orphan), "pass with unread output is culled");
+    Check(graph.IsCulled(debugA) && graph.IsCulled(debugB), "chain without a root is culled");
+    Check(!graph.IsCulled(capture), "side-effect pass is kept");
+    Check(graph.IsCulled(overlay), "write to import without final usage is culled");
+    Check(graph.GetStats().CulledCount == 4, "culled count");
+    Check(graph.GetResource(unused).FirstOrder == FRAME_GRAPH_INVALID_ID, "culled pass resources get no lifetime");
+
+    const char* reason = "";
+    Check(Validate(graph, b.GetDeclared(), 5, &reason), "culling graph invariants");
+
+    // 読み込みの後の書き込みは順序だけで, 読む側を生かす理由にならない.
+    FrameGraph war;
+    Builder    w(war);
+    auto bb    = war.Import("BackBuffer", FRAME_USAGE_PRESENT, FRAME_USAGE_PRESENT);
+    auto buf   = CreateTarget(war, "Buffer");
+    auto init  = w.Pass("Init");
+    auto peek  = w.Pass("Peek");
+    auto final = w.Pass("Final");
+    w.Write(init, buf, FRAME_USAGE_UNORDERED_ACCESS);
+    w.Read (peek, buf, FRAME_USAGE_NON_PIXEL_READ);
+    w.Write(final, buf, FRAME_USAGE_UNORDERED_ACCESS);
+    w.Write(final, bb, FRAME_USAGE_RENDER_TARGET);
+
+    Check(war.Compile() && war.IsCulled(peek) && !war.IsCulled(init), "write-after-read alone does not keep the reader");
+}
+
+//-----------------------------------------------------------------------------
+//      実行順を確認します.
+//-----------------------------------------------------------------------------
+void TestOrdering()
+{
+    FrameGraph graph;
+    Builder    b(graph);
+
+    auto backBuffer = graph.Import("BackBuffer", FRAME_USAGE_PRESENT, FRAME_USAGE_PRESENT);
+    auto a          = CreateTarget(graph, "A");
+    auto c          = CreateTarget(graph, "C");
+
+    auto writeA  = b.Pass("WriteA");
+    auto readA   = b.Pass("ReadA");      // WriteA の直後だと待ちになる.
+    auto writeC  = b.Pass("WriteC");     // 独立.
+    auto compose = b.Pass("Compose");
+
+    b.Write(writeA, a, FRAME_USAGE_RENDER_TARGET);
+    b.Read (readA, a, FRAME_USAGE_PIXEL_READ);
+    b.Write(readA, backBuffer, FRAME_USAGE_RENDER_TARGET);
+    b.Write(writeC, c, FRAME_USAGE_RENDER_TARGET);
+    b.Read (compose, c, FRAME_USAGE_PIXEL_READ);
+    b.Write(compose, backBuffer, FRAME_USAGE_RENDER_TARGET);
+
+    Check(graph.Compile(), "ordering graph compiles");
+
+    auto& order = graph.GetOrder();
+    Check(order.size() == 4, "all passes scheduled");
+    Check(order.size() == 4 && order[0] == writeA && order[1] == writeC && order[2] == readA && order[3] == compose,
+        "independent pass is hoisted between producer and consumer");
+
+    const char* reason = "";
+    Check(Validate(graph, b.GetDeclared(), 3, &reason), "ordering graph invariants");
+
+    // 同じ条件なら宣言順.
+    FrameGraph tie;
+    auto bb = tie.Import("BackBuffer", FRAME_USAGE_PRESENT, FRAME_USAGE_PRESENT);
+    FramePassId passes[4];
+    for (auto i = 0u; i < 4; ++i)
+    {
+        passes[i] = tie.AddPass("Independent", nullptr);
+        tie.Read(passes[i], bb, FRAME_USAGE_COPY_SRC);
+        tie.SetSideEffect(passes[i]);
+    }
+
+    Check(tie.Compile() && tie.GetOrder() == std::vector<FramePassId>(passes, passes + 4), "ties keep declaration order");
+
+    // 書き込まれる前の一時リソースの読み込みは不正.
+    FrameGraph invalid;
+    auto t = CreateTarget(invalid, "T");
+    auto p = invalid.AddPass("ReadBeforeWrite", nullptr);
+    invalid.Read(p, t, FRAME_USAGE_PIXEL_READ);
+    Check(!invalid.Compile(), "read of unwritten transient fails to compile");
+}
+
+//-----------------------------------------------------------------------------
+//      バリアの導出を確認します.
+//-----------------------------------------------------------------------------
+void TestBarriers()
+{
+    FrameGraph graph;
+    Builder    b(graph);
+
+    auto backBuffer = graph.Import("BackBuffer", FRAME_USAGE_PRESENT, FRAME_USAGE_PRESENT);
+    auto scene      = CreateTarget(graph, "Scene");
+    auto buffer     = CreateTarget(graph, "Buffer");
+
+    auto draw    = b.Pass("Draw");
+    auto blurX   = b.Pass("BlurX");
+    auto blurY   = b.Pass("BlurY");
+    auto readPS  = b.Pass("ReadPS");
+    auto readCS  = b.Pass("ReadCS");
+    auto present = b.Pass("Present");
+
+    b.Write(draw, scene, FRAME_USAGE_RENDER_TARGET);
+    b.Read (blurX, scene, FRAME_USAGE_NON_PIXEL_READ);
+    b.Write(blurX, buffer, FRAME_USAGE_UNORDERED_ACCESS);
+    b.Write(blurY, buffer, FRAME_USAGE_UNORDERED_ACCESS);
+    b.Read (readPS, buffer, FRAME_USAGE_PIXEL_READ);
+    b.Read (readCS, buffer, FRAME_USAGE_NON_PIXEL_READ);
+    b.Read (present, scene, FRAME_USAGE_PIXEL_READ);
+    b.Read (present, buffer, FRAME_USAGE_PIXEL_READ);
+    b.Write(present, backBuffer, FRAME_USAGE_RENDER_TARGET);
+    graph.SetSideEffect(readCS);
+    graph.SetSideEffect(readPS);
+
+    Check(graph.Compile(), "barrier graph compiles");
+
+    const char* reason = "";
+    auto valid = Validate(graph, b.GetDeclared(), 3, &reason);
+    Check(valid, "barrier graph invariants");
+    if (!valid)
+    { printf("       %s\n%s", reason, graph.FormatReport().c_str()); }
+
+    auto oDraw  = FindOrder(graph, draw);
+    auto oBlurY = FindOrder(graph, blurY);
+    auto oFirstRead = std::min(FindOrder(graph, readPS), FindOrder(graph, readCS));
+
+    Check(CountBarriers(graph, oDraw, FRAME_BARRIER_TRANSITION, scene) == 0, "first use of transient needs no transition");
+    Check(CountBarriers(graph, oBlurY, FRAME_BARRIER_UAV, buffer) == 1, "consecutive UAV writes get a UAV barrier");
+
+    // 続く読み込みはまとめて1回で遷移する.
+    uint32_t count = 0;
+    auto pBarriers = graph.GetBarriers(oFirstRead, count);
+    auto merged = false;
+    for (auto i = 0u; i < count; ++i)
+    {
+        if (pBarriers[i].Resource == buffer && pBarriers[i].Type == FRAME_BARRIER_TRANSITION)
+        { merged = (pBarriers[i].After == (FRAME_USAGE_PIXEL_READ | FRAME_USAGE_NON_PIXEL_READ)); }
+    }
+    Check(merged, "consecutive reads merge into one transition");
+
+    auto transitions = 0u;
+    for (auto i = 0u; i <= graph.GetOrder().size(); ++i)
+    { transitions += CountBarriers(graph, i, FRAME_BARRIER_TRANSITION, buffer); }
+    Check(transitions == 2, "buffer transitions: read merge, then back to first usage");
+
+    auto end = uint32_t(graph.GetOrder().size());
+    Check(CountBarriers(graph, FindOrder(graph, present), FRAME_BARRIER_TRANSITION, backBuffer) == 1
+       && CountBarriers(graph, end, FRAME_BARRIER_TRANSITION, backBuffer) == 1, "back buffer goes to render target and back to present");
+    Check(graph.GetResource(backBuffer).EndUsage == FRAME_USAGE_PRESENT, "end usage of import");
+}
+
+//-----------------------------------------------------------------------------
+//      一時リソースのメモリ共有を確認します.
+//-----------------------------------------------------------------------------
+void TestAliasing()
+{
+    FrameGraph graph;
+    Builder    b(graph);
+
+    auto backBuffer = graph.Import("BackBuffer", FRAME_USAGE_PRESENT, FRAME_USAGE_PRESENT);
+    auto t0 = CreateTarget(graph, "T0");
+    auto t1 = CreateTarget(graph, "T1");
+    auto t2 = CreateTarget(graph, "T2");
+    auto small = graph.Create("Small", { 1000, 256 });
+
+    // T0 -> T1 -> T2 の連鎖. T0 と T2 は寿命が重ならない.
+    auto p0 = b.Pass("P0");
+    auto p1 = b.Pass("P1");
+    auto p2 = b.Pass("P2");
+    auto p3 = b.Pass("P3");
+    b.Write(p0, t0, FRAME_USAGE_RENDER_TARGET);
+    b.Write(p0, small, FRAME_USAGE_UNORDERED_ACCESS);
+    b.Read (p1, t0, FRAME_USAGE_PIXEL_READ);
+    b.Write(p1, t1, FRAME_USAGE_RENDER_TARGET);
+    b.Read (p2, t1, FRAME_USAGE_PIXEL_READ);
+    b.Write(p2, t2, FRAME_USAGE_RENDER_TARGET);
+    b.Read (p3, t2, FRAME_USAGE_PIXEL_READ);
+    b.Read (p3, small, FRAME_USAGE_PIXEL_READ);
+    b.Write(p3, backBuffer, FRAME_USAGE_RENDER_TARGET);
+
+    Check(graph.Compile(), "aliasing graph compiles");
+
+    const char* reason = "";
+    Check(Validate(graph, b.GetDeclared(), 5, &reason), "aliasing graph invariants");
+
+    auto& r0 = graph.GetResource(t0);
+    auto& r1 = graph.GetResource(t1);
+    auto& r2 = graph.GetResource(t2);
+    auto& rs = graph.GetResource(small);
+
+    Check(r0.HeapOffset == r2.HeapOffset, "disjoint lifetimes share memory");
+    Check(r0.HeapOffset != r1.HeapOffset, "overlapping lifetimes do not share memory");
+    Check(rs.HeapOffset % 256 == 0, "placement honors alignment");
+    Check(graph.GetStats().TransientBytes == 3 * TargetSize + 1000, "transient bytes");
+    Check(graph.GetStats().HeapBytes < graph.GetStats().TransientBytes, "heap is smaller than the sum");
+
+    auto o2 = FindOrder(graph, p2);
+    uint32_t count = 0;
+    auto pBarriers = graph.GetBarriers(o2, count);
+    auto aliasFirst = (count > 0 && pBarriers[0].Type == FRAME_BARRIER_ALIASING && pBarriers[0].Resource == t2);
+    Check(aliasFirst, "aliasing barrier is issued first");
+    Check(aliasFirst && pBarriers[0].Previous == t0, "aliasing barrier names the previous resource");
+    Check(CountBarriers(graph, FindOrder(graph, p1), FRAME_BARRIER_ALIASING, t1) == 0, "no aliasing barrier without shared memory");
+}
+
+//-----------------------------------------------------------------------------
+//      フレームに似た乱数のグラフを組み立てます.
+//-----------------------------------------------------------------------------
+//! @note       各パスは直近の数個の出力を読み, 1〜2個の一時リソースに書きます.
+//!             一部のパスは共有のUAVバッファに書き, 1/8 のパスは誰にも読まれません.
+//-----------------------------------------------------------------------------
+Declared BuildRandomGraph(FrameGraph& graph, uint32_t passCount, uint32_t seed, uint32_t& resourceCount)
+{
+    std::mt19937 rng(seed);
+    Builder      b(graph);
+
+    auto backBuffer = graph.Import("BackBuffer", FRAME_USAGE_PRESENT, FRAME_USAGE_PRESENT);
+    auto shared     = graph.Import("Shared", FRAME_USAGE_NON_PIXEL_READ, FRAME_USAGE_NON_PIXEL_READ);
+    std::vector<FrameResourceId> outputs;
+
+    const uint32_t readUsages[] = { FRAME_USAGE_PIXEL_READ, FRAME_USAGE_NON_PIXEL_READ, FRAME_USAGE_COPY_SRC };
+    const uint32_t writeUsages[] = { FRAME_USAGE_RENDER_TARGET, FRAME_USAGE_UNORDERED_ACCESS, FRAME_USAGE_DEPTH_WRITE };
+    const uint64_t sizes[] = { 1ull << 20, 4ull << 20, 8ull << 20, 16ull << 20, 32ull << 20 };
+
+    for (auto i = 0u; i < passCount; ++i)
+    {
+        auto pass = b.Pass("Pass");
+
+        auto reads = outputs.empty() ? 0u : rng() % 4;
+        for (auto k = 0u; k < reads; ++k)
+        {
+            auto window = std::min<size_t>(outputs.size(), 12);
+            auto res    = outputs[outputs.size() - 1 - rng() % window];
+            b.Read(pass, res, readUsages[rng() % 3]);
+        }
+
+        if (rng() % 8 == 0)
+        { b.Write(pass, shared, FRAME_USAGE_UNORDERED_ACCESS); }
+
+        auto writes = 1 + rng() % 2;
+        for (auto k = 0u; k < writes; ++k)
+        {
+            auto res = graph.Create("Target", { sizes[rng() % 5], TargetAlignment });
+            b.Write(pass, res, writeUsages[rng() % 3]);
+            if (rng() % 8 != 0)
+            { outputs.push_back(res); }
+        }
+
+        if (i + 1 == passCount)
+        {
+            for (auto k = 0u; k < 4 && k < outputs.size(); ++k)
+            { b.Read(pass, outputs[outputs.size() - 1 - k], FRAME_USAGE_PIXEL_READ); }
+            b.Write(pass, backBuffer, FRAME_USAGE_RENDER_TARGET);
+        }
+    }
+
+    // 生成した全てのリソースは1回以上書かれるので, 宣言から数を求める.
+    resourceCount = 0;
+    auto declared = b.GetDeclared();
+    for (auto& accesses : declared.Passes)
+    {
+        for (auto& access : accesses)
+        { resourceCount = std::max(resourceCount, access.Resource + 1); }
+    }
+
+    return declared;
+}
+
+//-----------------------------------------------------------------------------
+//      乱数のグラフで不変条件を確認します.
+//-----------------------------------------------------------------------------
+void TestRandomGraphs()
+{
+    auto failed = 0u;
+    const char* reason = "";
+    for (auto seed = 1u; seed <= 50; ++seed)
+    {
+        FrameGraph graph;
+        uint32_t   resourceCount = 0;
+        auto declared = BuildRandomGraph(graph, 20 + seed * 4, seed, resourceCount);
+
+        if (!graph.Compile() || !Validate(graph, declared, resourceCount, &reason))
+        {
+            if (failed == 0)
+            { printf("       seed %u : %s\n", seed, reason); }
+            failed++;
+        }
+    }
+
+    Check(failed == 0, "random graphs satisfy ordering, barrier and aliasing invariants");
+}
+
+//-----------------------------------------------------------------------------
+//      コンパイル時間を計測します.
+//-----------------------------------------------------------------------------
+void Benchmark(uint32_t iterations)
+{
+    printf("%8s %8s %8s %10s %12s %12s %12s\n",
+        "passes", "culled", "barriers", "resources", "heap/sum[%]", "build[us]", "compile[us]");
+
+    for (auto passCount : BenchPassCounts)
+    {
+        double buildUs   = 0.0;
+        double compileUs = 0.0;
+        uint32_t resourceCount = 0;
+        FrameGraph::CompileStats stats = {};
+
+        for (auto i = 0u; i < iterations; ++i)
+        {
+            FrameGraph graph;
+
+            auto t0 = std::chrono::steady_clock::now();
+            BuildRandomGraph(graph, passCount, 1234, resourceCount);
+            auto t1 = std::chrono::steady_clock::now();
+            graph.Compile();
+            auto t2 = std::chrono::steady_clock::now();
+
+            buildUs   += std::chrono::duration<double, std::micro>(t1 - t0).count();
+            compileUs += std::chrono::duration<double, std::micro>(t2 - t1).count();
+            stats = graph.GetStats();
+        }
+
+        printf("%8u %8u %8u %10u %12.1f %12.1f %12.1f\n",
+            passCount,
+            stats.CulledCount,
+            stats.BarrierCount,
+            resourceCount,
+            100.0 * double(stats.HeapBytes) / double(stats.TransientBytes),
+            buildUs / iterations,
+            compileUs / iterations);
+    }
+}
+
+//-----------------------------------------------------------------------------
+//      使い方を表示します.
+//-----------------------------------------------------------------------------
+void PrintUsage()
+{
+    printf("Usage : FrameGraphTest [options]\n");
+    printf("    --iterations <n>    compiles per benchmark size (default %u)\n", DefaultIterations);
+    printf("    --no-bench          run the tests only\n");
+}
+
+} // namespace
+
+
+//-----------------------------------------------------------------------------
+//      メインエントリーポイントです.
+//-----------------------------------------------------------------------------
+int main(int argc, char** argv)
+{
+    auto iterations = DefaultIterations;
+    auto bench      = true;
+
+    for (auto i = 1; i < argc; ++i)
+    {
+        auto hasValue = (i + 1 < argc);
+        if (strcmp(argv[i], "--iterations") == 0 && hasValue)
+        { iterations = uint32_t(strtoul(argv[++i], nullptr, 10)); }
+        else if (strcmp(argv[i], "--no-bench") == 0)
+        { bench = false; }
+        else
+        {
+            PrintUsage();
+            return -1;
+        }
+    }
+
+    if (iterations == 0)
+    {
+        PrintUsage();
+        return -1;
+    }
+
+    TestCulling();
+    TestOrdering();
+    TestBarriers();
+    TestAliasing();
+    TestRandomGraphs();
+
+    if (g_FailCount > 0)
+    {
+        fprintf(stderr, "Error : %u check(s) failed.\n", g_FailCount);
+        return -1;
+    }
+
+    if (bench)
+    { Benchmark(iterations); }
+
+    return 0;
+}
@@ -0,0 +1,398 @@
+﻿//-----------------------------------------------------------------------------
+// File : main.cpp
+// Desc : Frame Pacer Simulated Presentation Clock Test Entry Point.
+// Copyright(c) Pocol. All right reserved.
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------
+#include "FramePacer.h"
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <map>
+
+
+namespace {
+
+//-----------------------------------------------------------------------------
+// Constant Values.
+//-----------------------------------------------------------------------------
+constexpr double    RefreshMs           = 1000.0 / 60.0;    // 模擬ディスプレイのリフレッシュ間隔[ms].
+constexpr uint32_t  PresentQueueLimit   = 3;                // 表示待ちにできるフレーム数(DXGI の既定).
+constexpr uint32_t  SimulateFrames      = 600;              // 1回の模擬で描画するフレーム数.
+constexpr uint32_t  SteadyFrames        = 100;              // 定常状態として真の遅延を平均する末尾のフレーム数.
+
+uint32_t g_FailCount = 0;   // 失敗した確認の数.
+
+//-----------------------------------------------------------------------------
+//      確認結果を表示します.
+//-----------------------------------------------------------------------------
+void Check(bool condition, const char* name)
+{
+    printf("[%s] %s\n", condition ? "PASS" : "FAIL", name);
+    if (!condition)
+    { g_FailCount++; }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// PresentClock class
+///////////////////////////////////////////////////////////////////////////////
+//! @note       垂直同期ごとに表示待ちの先頭を1つ表示する模擬的なスワップチェインです.
+//!             表示するたびに待機可能オブジェクト(セマフォ)を1つ戻します.
+//!             停止区間の間は何も表示しません(ウィンドウが隠れた場合などに相当).
+///////////////////////////////////////////////////////////////////////////////
+class PresentClock
+{
+public:
+    PresentClock(uint32_t maxLatency, double stallBeginMs, double stallEndMs)
+    : m_Now             (0.0)
+    , m_NextVsync       (RefreshMs)
+    , m_Semaphore       (maxLatency)
+    , m_StallBeginMs    (stallBeginMs)
+    , m_StallEndMs      (stallEndMs)
+    , m_LastDisplayedId (0)
+    , m_LastDisplayMs   (0.0)
+    { /* DO_NOTHING */ }
+
+    double GetNow() const
+    { return m_Now; }
+
+    // 指定時刻まで進め, その間の垂直同期で表示します.
+    void AdvanceTo(double targetMs)
+    {
+        while (m_NextVsync <= targetMs)
+        {
+            auto stalled = (m_NextVsync >= m_StallBeginMs && m_NextVsync < m_StallEndMs);
+            if (!stalled && !m_Queue.empty())
+            {
+                m_LastDisplayedId = m_Queue.front();
+                m_LastDisplayMs   = m_NextVsync;
+                m_DisplayMs[m_LastDisplayedId] = m_NextVsync;
+                m_Queue.pop_front();
+                m_Semaphore++;
+            }
+            m_NextVsync += RefreshMs;
+        }
+
+        if (targetMs > m_Now)
+        { m_Now = targetMs; }
+    }
+
+    // 待機可能オブジェクトを待ちます(WaitForSingleObjectEx に相当).
+    bool Wait(double timeoutMs)
+    {
+        auto deadline = m_Now + timeoutMs;
+        while (m_Semaphore == 0 && m_NextVsync <= deadline)
+        { AdvanceTo(m_NextVsync); }
+
+        if (m_Semaphore == 0)
+        {
+            AdvanceTo(deadline);
+            return false;
+        }
+
+        m_Semaphore--;
+        return true;
+    }
+
+    // 表示待ちに積みます. 一杯なら空くまで止まります(Present に相当).
+    void Present(uint32_t presentId)
+    {
+        while (m_Queue.size() >= PresentQueueLimit)
+        { AdvanceTo(m_NextVsync); }
+
+        m_Queue.push_back(presentId);
+    }
+
+    // 最後に表示したフレームです(GetFrameStatistics に相当).
+    bool GetLastDisplayed(uint32_t& presentId, double& displayMs) const
+    {
+        presentId = m_LastDisplayedId;
+        displayMs = m_LastDisplayMs;
+        return m_LastDisplayedId != 0;
+    }
+
+    bool GetDisplayMs(uint32_t presentId, double& displayMs) const
+    {
+        auto itr = m_DisplayMs.find(presentId);
+        if (itr == m_DisplayMs.end())
+        { return false; }
+
+        displayMs = itr->second;
+        return true;
+    }
+
+private:
+    double                          m_Now;              //!< 現在時刻[ms]です.
+    double                          m_NextVsync;        //!< 次の垂直同期の時刻[ms]です.
+    uint32_t                        m_Semaphore;        //!< 待機可能オブジェクトのカウントです.
+    double                          m_StallBeginMs;     //!< 表示が止まる時刻[ms]です.
+    double                          m_StallEndMs;       //!< 表示が再開する時刻[ms]です.
+    std::deque<uint32_t>            m_Queue;            //!< 表示待ちのフレームです.
+    uint32_t                        m_LastDisplayedId;  //!< 最後に表示した通し番号です.
+    double                          m_LastDisplayMs;    //!< 最後に表示した時刻[ms]です.
+    std::map<uint32_t, double>      m_DisplayMs;        //!< 通し番号ごとの表示時刻[ms]です.
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// Scenario structure
+///////////////////////////////////////////////////////////////////////////////
+struct Scenario
+{
+    LATENCY_MODE    Mode;               //!< 遅延モードです.
+    uint32_t        MaxLatency;         //!< 最大遅延フレーム数です.
+    double          CpuMs;              //!< 1フレームの構築時間[ms]です.
+    double          StallBeginMs;       //!< 表示が止まる時刻[ms]です.
+    double          StallEndMs;         //!< 表示が再開する時刻[ms]です.
+    bool            IgnoreDebt;         //!< 持ち越しを無視して毎フレーム1回だけ待つかどうか.
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// Result structure
+///////////////////////////////////////////////////////////////////////////////
+struct Result
+{
+    double          PacerLatencyMs;     //!< FramePacer が集計した遅延[ms]です.
+    double          TrueLatencyMs;      //!< 末尾のフレームの実際の遅延の平均[ms]です.
+    uint32_t        TimeoutCount;       //!< 待ちきれなかった回数です.
+    uint32_t        MaxWaitCount;       //!< 1フレームで待った最大の回数です.
+};
+
+//-----------------------------------------------------------------------------
+//      App::RenderLoop と同じ順で FramePacer を呼び出して模擬します.
+//-----------------------------------------------------------------------------
+Result Simulate(const Scenario& scenario)
+{
+    FramePacer pacer;
+    pacer.Init(scenario.Mode, scenario.MaxLatency, false);
+
+    PresentClock clock(pacer.GetMaxLatency(), scenario.StallBeginMs, scenario.StallEndMs);
+
+    Result result = {};
+    std::map<uint32_t, double> beginMs;
+    for (auto id = 1u; id <= SimulateFrames; ++id)
+    {
+        // フレームの開始時に待つ. 持ち越した分も合わせて WaitTimeoutMs まで待つ(App::WaitFrameLatency と同じ).
+        auto count = scenario.IgnoreDebt ? (pacer.GetWaitCount() > 0 ? 1u : 0u) : pacer.GetWaitCount();
+        if (count > 0)
+        {
+            auto deadline = clock.GetNow() + double(FramePacer::WaitTimeoutMs);
+            uint32_t signaled = 0;
+            for (auto i = 0u; i < count; ++i)
+            {
+                auto remain = deadline - clock.GetNow();
+                if (clock.Wait((remain > 0.0) ? remain : 0.0))
+                { signaled++; }
+            }
+            pacer.OnWaitResult(signaled);
+            result.MaxWaitCount = (count > result.MaxWaitCount) ? count : result.MaxWaitCount;
+        }
+
+        auto begin = clock.GetNow();
+        beginMs[id] = begin;
+        clock.AdvanceTo(begin + scenario.CpuMs);
+
+        // 表示して, 最後に表示されたフレームを確認する(App::Present と同じ).
+        clock.Present(id);
+        pacer.OnPresent(id, begin);
+
+        uint32_t displayedId;
+        double   displayMs;
+        if (clock.GetLastDisplayed(displayedId, displayMs))
+        { pacer.OnDisplayed(displayedId, displayMs); }
+    }
+
+    // 末尾のフレームの実際の遅延.
+    double sum = 0.0;
+    uint32_t samples = 0;
+    for (auto id = SimulateFrames - SteadyFrames - PresentQueueLimit; id <= SimulateFrames - PresentQueueLimit; ++id)
+    {
+        double displayMs;
+        if (clock.GetDisplayMs(id, displayMs))
+        {
+            sum += displayMs - beginMs[id];
+            samples++;
+        }
+    }
+
+    result.PacerLatencyMs = pacer.GetLatencyMs();
+    result.TrueLatencyMs  = (samples > 0) ? sum / samples : 0.0;
+    result.TimeoutCount   = pacer.GetTimeoutCount();
+    return result;
+}
+
+//-----------------------------------------------------------------------------
+//      値が期待値に近いかどうかチェックします.
+//-----------------------------------------------------------------------------
+bool IsNear(double value, double expected, double tolerance)
+{ return std::fabs(value - expected) <= tolerance; }
+
+//-----------------------------------------------------------------------------
+//      設定のテストです.
+//-----------------------------------------------------------------------------
+void TestSettings()
+{
+    FramePacer pacer;
+    Check(pacer.GetMode() == LATENCY_MODE_VSYNC && pacer.GetWaitCount() == 0 && pacer.GetSyncInterval() == 1,
+        "settings: default is vsync without the waitable object");
+
+    pacer.Init(LATENCY_MODE_LOW, 0, true);
+    Check(pacer.GetMaxLatency() == 1 && pacer.UseWaitableObject() && pacer.GetSyncInterval() == 1
+        && !pacer.AllowTearing() && !pacer.UseTearing(false),
+        "settings: low latency waits, syncs to vblank and clamps max latency to 1");
+
+    pacer.Init(LATENCY_MODE_UNCAPPED, 99, true);
+    Check(pacer.GetMaxLatency() == FramePacer::MaxLatencyLimit && pacer.GetSyncInterval() == 0
+        && pacer.AllowTearing() && pacer.UseTearing(false) && !pacer.UseTearing(true),
+        "settings: uncapped uses interval 0 and tears only in windowed mode");
+
+    pacer.Init(LATENCY_MODE_UNCAPPED, 2, false);
+    Check(pacer.GetSyncInterval() == 0 && !pacer.AllowTearing() && !pacer.UseTearing(false),
+        "settings: no tearing without device support");
+}
+
+//-----------------------------------------------------------------------------
+//      待ちきれなかった分の持ち越しのテストです.
+//-----------------------------------------------------------------------------
+void TestWaitDebt()
+{
+    FramePacer pacer;
+    pacer.Init(LATENCY_MODE_LOW, 1, false);
+
+    // 最大遅延フレーム数を超えても持ち越す(止まっていた間に積んだ分をすべて返すため).
+    auto ok = (pacer.GetWaitCount() == 1);
+    pacer.OnWaitResult(0);
+    ok = ok && pacer.GetWaitCount() == 2 && pacer.GetTimeoutCount() == 1;
+    pacer.OnWaitResult(0);
+    ok = ok && pacer.GetWaitCount() == 3;
+    pacer.OnWaitResult(0);
+    Check(ok && pacer.GetWaitCount() == 4 && pacer.GetTimeoutCount() == 3,
+        "debt: each timeout adds one wait beyond MaxLatency");
+
+    pacer.OnWaitResult(1);
+    ok = (pacer.GetWaitCount() == 4 && pacer.GetTimeoutCount() == 3);
+    pacer.OnWaitResult(2);
+    ok = ok && pacer.GetWaitCount() == 3;
+    pacer.OnWaitResult(3);
+    Check(ok && pacer.GetWaitCount() == 1, "debt: late signals pay it back, partial payments carry over");
+
+    for (auto i = 0u; i < FramePacer::MaxLatencyLimit * 2; ++i)
+    { pacer.OnWaitResult(0); }
+    Check(pacer.GetWaitCount() == 1 + FramePacer::MaxLatencyLimit, "debt: capped at MaxLatencyLimit if signals never return");
+
+    pacer.Init(LATENCY_MODE_VSYNC, 2, false);
+    pacer.OnWaitResult(0);
+    Check(pacer.GetWaitCount() == 0, "debt: vsync mode never waits");
+}
+
+//-----------------------------------------------------------------------------
+//      表示の記録のテストです.
+//-----------------------------------------------------------------------------
+void TestDisplayed()
+{
+    FramePacer pacer;
+    pacer.Init(LATENCY_MODE_LOW, 1, false);
+
+    pacer.OnDisplayed(7, 100.0);
+    Check(pacer.GetLatencyMs() == 0.0, "displayed: unknown present id is ignored");
+
+    pacer.OnPresent(5, 10.0);
+    pacer.OnDisplayed(5, 5.0);
+    Check(pacer.GetLatencyMs() == 0.0, "displayed: display time before the frame began is ignored");
+
+    pacer.OnDisplayed(5, 30.0);
+    pacer.OnDisplayed(5, 50.0);
+    Check(pacer.GetLatencyMs() == 20.0, "displayed: first sample is taken as is, repeats are ignored");
+
+    pacer.OnPresent(6, 40.0);
+    pacer.OnDisplayed(6, 70.0);
+    Check(IsNear(pacer.GetLatencyMs(), 21.0, 1e-9), "displayed: later samples are smoothed by 0.1");
+
+    // 履歴を1周すると古い記録は上書きされる.
+    pacer.OnPresent(100, 0.0);
+    pacer.OnPresent(100 + FramePacer::HistorySize, 1000.0);
+    pacer.OnDisplayed(100, 2000.0);
+    Check(IsNear(pacer.GetLatencyMs(), 21.0, 1e-9), "displayed: ids overwritten after HistorySize are ignored");
+}
+
+//-----------------------------------------------------------------------------
+//      模擬的な表示クロックでのテストです.
+//-----------------------------------------------------------------------------
+void TestSimulation()
+{
+    printf("%-34s %10s %10s %9s %9s\n", "scenario", "pacer[ms]", "true[ms]", "timeouts", "maxWait");
+
+    auto run = [](const char* name, const Scenario& scenario)
+    {
+        auto r = Simulate(scenario);
+        printf("%-34s %10.2f %10.2f %9u %9u\n", name, r.PacerLatencyMs, r.TrueLatencyMs, r.TimeoutCount, r.MaxWaitCount);
+        return r;
+    };
+
+    const auto NoStall = -1.0;
+    auto low1   = run("low, latency 1, cpu 2 ms",           { LATENCY_MODE_LOW,   1,  2.0, NoStall, NoStall, false });
+    auto low2   = run("low, latency 2, cpu 2 ms",           { LATENCY_MODE_LOW,   2,  2.0, NoStall, NoStall, false });
+    auto low3   = run("low, latency 3, cpu 2 ms",           { LATENCY_MODE_LOW,   3,  2.0, NoStall, NoStall, false });
+    auto vsync  = run("vsync, cpu 2 ms",                    { LATENCY_MODE_VSYNC, 1,  2.0, NoStall, NoStall, false });
+    auto slow   = run("low, latency 1, cpu 25 ms",          { LATENCY_MODE_LOW,   1, 25.0, NoStall, NoStall, false });
+    auto stall  = run("low, latency 1, 300 ms stall",       { LATENCY_MODE_LOW,   1,  2.0, 2000.0,  2300.0,  false });
+    auto naive  = run("low, latency 1, stall, no debt",     { LATENCY_MODE_LOW,   1,  2.0, 2000.0,  2300.0,  true  });
+
+    Check(IsNear(low1.TrueLatencyMs, RefreshMs, 0.01) && IsNear(low2.TrueLatencyMs, 2.0 * RefreshMs, 0.01)
+        && IsNear(low3.TrueLatencyMs, 3.0 * RefreshMs, 0.01),
+        "sim: latency is one refresh per frame of max latency");
+    Check(low1.TimeoutCount == 0 && low2.TimeoutCount == 0 && low3.TimeoutCount == 0 && slow.TimeoutCount == 0,
+        "sim: no timeouts while the display runs");
+    // 表示待ちが一杯の間は Present で止まるので, 入力を読んだフレームの前に PresentQueueLimit 枚が並ぶ.
+    Check(IsNear(vsync.TrueLatencyMs, (PresentQueueLimit + 1) * RefreshMs, 0.01),
+        "sim: vsync without the waitable object runs PresentQueueLimit frames ahead");
+    Check(slow.TrueLatencyMs >= 25.0 && slow.TrueLatencyMs <= 25.0 + RefreshMs,
+        "sim: a CPU-bound frame waits at most one refresh for display");
+    Check(stall.TimeoutCount > 1 && stall.MaxWaitCount > 2 && IsNear(stall.TrueLatencyMs, RefreshMs, 0.01),
+        "sim: after a stall the debt is repaid and latency returns to one refresh");
+    Check(naive.TrueLatencyMs > stall.TrueLatencyMs + 0.5 * RefreshMs,
+        "sim: waiting once per frame after a stall keeps the extra latency");
+
+    auto ok = true;
+    for (auto& r : { low1, low2, low3, vsync, slow, stall })
+    { ok = ok && IsNear(r.PacerLatencyMs, r.TrueLatencyMs, 0.5); }
+    Check(ok, "sim: pacer average matches the true latency in steady state");
+}
+
+//-----------------------------------------------------------------------------
+//      使い方を表示します.
+//-----------------------------------------------------------------------------
+void PrintUsage()
+{ printf("Usage : FramePacerTest\n"); }
+
+} // namespace
+
+
+//-----------------------------------------------------------------------------
+//      メインエントリーポイントです.
+//-----------------------------------------------------------------------------
+int main(int argc, char** argv)
+{
+    if (argc > 1)
+    {
+        PrintUsage();
+        return (strcmp(argv[1], "--help") == 0) ? 0 : -1;
+    }
+
+    TestSettings();
+    TestWaitDebt();
+    TestDisplayed();
+    TestSimulation();
+
+    if (g_FailCount > 0)
+    {
+        fprintf(stderr, "Error : %u check(s) failed.\n", g_FailCount);
+        return -1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,350 @@
+﻿//-----------------------------------------------------------------------------
+// File : main.cpp
+// Desc : Frame Time Statistics Test Entry Point.
+// Copyright(c) Pocol. All right reserved.
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------
+#include "FrameStats.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+
+namespace {
+
+//-----------------------------------------------------------------------------
+// Constant Values.
+//-----------------------------------------------------------------------------
+constexpr uint32_t      RandomCases     = 500;                  // 乱数で照合する回数.
+constexpr uint32_t      StressFrames    = 2000000;              // 並行テストで記録するフレーム数.
+constexpr float         Tolerance       = 1e-4f;                // 平均の許容誤差(相対).
+constexpr const char*   CsvPath         = "FrameStatsTest.csv";
+
+uint32_t g_FailCount = 0;   // 失敗した確認の数.
+
+//-----------------------------------------------------------------------------
+//      確認結果を表示します.
+//-----------------------------------------------------------------------------
+void Check(bool condition, const char* name)
+{
+    printf("[%s] %s\n", condition ? "PASS" : "FAIL", name);
+    if (!condition)
+    { g_FailCount++; }
+}
+
+//-----------------------------------------------------------------------------
+//      相対誤差の範囲で等しいかどうか.
+//-----------------------------------------------------------------------------
+bool Near(double a, double b)
+{ return std::fabs(a - b) <= Tolerance * std::max(1.0, std::fabs(b)); }
+
+///////////////////////////////////////////////////////////////////////////////
+// Reference structure
+///////////////////////////////////////////////////////////////////////////////
+//! @note       FrameStats とは別に, 定義どおりに求めた期待値です.
+///////////////////////////////////////////////////////////////////////////////
+struct Reference
+{
+    float   MinMs;
+    float   MaxMs;
+    double  MeanMs;
+    float   P50Ms;
+    float   P95Ms;
+    float   P99Ms;
+    double  Low1Ms;     //!< 遅い方から ceil(n / 100) フレームの平均です.
+};
+
+//-----------------------------------------------------------------------------
+//      期待値を求めます(最近傍順位法: 順位 ceil(p / 100 * n) の値).
+//-----------------------------------------------------------------------------
+Reference MakeReference(std::vector<float> values)
+{
+    std::sort(values.begin(), values.end());
+    auto n = values.size();
+
+    auto percentile = [&](uint32_t p)
+    {
+        auto rank = size_t(std::ceil(double(p) * double(n) / 100.0 - 1e-9));
+        return values[std::max<size_t>(rank, 1) - 1];
+    };
+
+    Reference result;
+    result.MinMs  = values.front();
+    result.MaxMs  = values.back();
+    result.MeanMs = 0.0;
+    for (auto v : values)
+    { result.MeanMs += v; }
+    result.MeanMs /= double(n);
+    result.P50Ms  = percentile(50);
+    result.P95Ms  = percentile(95);
+    result.P99Ms  = percentile(99);
+
+    auto lowCount = size_t(std::ceil(double(n) / 100.0));
+    result.Low1Ms = 0.0;
+    for (auto i = n - lowCount; i < n; ++i)
+    { result.Low1Ms += values[i]; }
+    result.Low1Ms /= double(lowCount);
+
+    return result;
+}
+
+//-----------------------------------------------------------------------------
+//      集計結果が期待値と一致するかどうか.
+//-----------------------------------------------------------------------------
+bool Matches(const FrameStatsSummary& summary, const Reference& reference)
+{
+    return summary.MinMs == reference.MinMs
+        && summary.MaxMs == reference.MaxMs
+        && summary.P50Ms == reference.P50Ms
+        && summary.P95Ms == reference.P95Ms
+        && summary.P99Ms == reference.P99Ms
+        && Near(summary.MeanMs,  reference.MeanMs)
+        && Near(summary.MeanFps, 1000.0 / reference.MeanMs)
+        && Near(summary.Low1Fps, 1000.0 / reference.Low1Ms);
+}
+
+//-----------------------------------------------------------------------------
+//      値を記録して集計します.
+//-----------------------------------------------------------------------------
+bool Summarize(FrameStats& stats, const std::vector<float>& values, FrameStatsSummary& summary)
+{
+    stats.Reset();
+    for (auto v : values)
+    { stats.AddFrame(v, v * 0.5f, v * 0.25f); }
+
+    return stats.GetSummary(summary);
+}
+
+//-----------------------------------------------------------------------------
+//      既知の値のテストです.
+//-----------------------------------------------------------------------------
+void TestKnownVectors(FrameStats& stats)
+{
+    FrameStatsSummary summary = {};
+
+    stats.Reset();
+    Check(!stats.GetSummary(summary) && stats.GetFrameCount() == 0, "empty: no summary");
+
+    // 1フレーム.
+    Summarize(stats, { 20.0f }, summary);
+    Check(summary.SampleCount == 1 && summary.P50Ms == 20.0f && summary.P99Ms == 20.0f
+       && summary.MinMs == 20.0f && summary.MaxMs == 20.0f && summary.Low1Fps == 50.0f && summary.MeanFps == 50.0f,
+        "single frame: every statistic equals the frame");
+
+    // 1 ～ 100ms を逆順に.
+    std::vector<float> values;
+    for (auto i = 100; i >= 1; --i)
+    { values.push_back(float(i)); }
+    Summarize(stats, values, summary);
+    Check(summary.P50Ms == 50.0f && summary.P95Ms == 95.0f && summary.P99Ms == 99.0f, "1..100: p50 50, p95 95, p99 99");
+    Check(summary.MinMs == 1.0f && summary.MaxMs == 100.0f && Near(summary.MeanMs, 50.5), "1..100: min 1, max 100, mean 50.5");
+    Check(Near(summary.Low1Fps, 10.0), "1..100: 1% low is the single slowest frame (10 fps)");
+    Check(Near(summary.BuildMeanMs, 25.25) && summary.BuildMaxMs == 50.0f && Near(summary.WaitMeanMs, 12.625) && summary.WaitMaxMs == 25.0f,
+        "1..100: build and wait mean/max");
+
+    // 101フレームでは1%が2フレームになり, p99 は100番目.
+    values.push_back(101.0f);
+    Summarize(stats, values, summary);
+    Check(summary.P99Ms == 100.0f && Near(summary.Low1Fps, 1000.0 / 100.5), "1..101: p99 rank 100, 1% low averages 2 frames");
+
+    // 1 ～ 1000ms.
+    values.clear();
+    for (auto i = 1; i <= 1000; ++i)
+    { values.push_back(float(i)); }
+    std::shuffle(values.begin(), values.end(), std::mt19937(1));
+    Summarize(stats, values, summary);
+    Check(summary.P50Ms == 500.0f && summary.P95Ms == 950.0f && summary.P99Ms == 990.0f, "1..1000 shuffled: p50 500, p95 950, p99 990");
+    Check(Near(summary.Low1Fps, 1000.0 / 995.5), "1..1000 shuffled: 1% low averages the 10 slowest frames");
+
+    // 一定のフレームにヒッチが1つ.
+    values.assign(999, 16.0f);
+    values.push_back(100.0f);
+    Summarize(stats, values, summary);
+    Check(summary.P99Ms == 16.0f && summary.MaxMs == 100.0f && Near(summary.Low1Fps, 1000.0 / ((100.0 + 16.0 * 9) / 10.0)),
+        "single hitch: p99 unaffected, 1% low pulled down");
+
+    // 0ms のフレームは 0fps とする(0除算しない).
+    Summarize(stats, { 0.0f }, summary);
+    Check(summary.MeanFps == 0.0f && summary.Low1Fps == 0.0f, "zero frame time: fps reported as 0");
+}
+
+//-----------------------------------------------------------------------------
+//      ウィンドウのテストです.
+//-----------------------------------------------------------------------------
+void TestWindow(FrameStats& stats)
+{
+    stats.Reset();
+    for (auto i = 1u; i <= 1500; ++i)
+    { stats.AddFrame(float(i), 0.0f, 0.0f); }
+
+    FrameStatsSummary summary = {};
+    stats.GetSummary(summary);
+
+    std::vector<float> last;
+    for (auto i = 1500u - FrameStats::WindowSize + 1; i <= 1500; ++i)
+    { last.push_back(float(i)); }
+
+    Check(summary.FrameCount == 1500 && summary.SampleCount == FrameStats::WindowSize, "window: counts all frames, keeps WindowSize");
+    Check(Matches(summary, MakeReference(last)), "window: statistics over the most recent WindowSize frames only");
+}
+
+//-----------------------------------------------------------------------------
+//      乱数の値で定義どおりの計算と照合します.
+//-----------------------------------------------------------------------------
+void TestRandom(FrameStats& stats)
+{
+    std::mt19937 rng(44);
+    std::uniform_int_distribution<uint32_t> size(1, FrameStats::WindowSize);
+    std::lognormal_distribution<float> frameMs(2.8f, 0.3f);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+
+    auto failed = 0u;
+    for (auto c = 0u; c < RandomCases; ++c)
+    {
+        std::vector<float> values(size(rng));
+        for (auto& v : values)
+        {
+            v = frameMs(rng);
+            if (unit(rng) < 0.01f)
+            { v *= 5.0f; }  // ヒッチ.
+        }
+
+        FrameStatsSummary summary = {};
+        Summarize(stats, values, summary);
+        if (!Matches(summary, MakeReference(values)))
+        { failed++; }
+    }
+
+    char name[128];
+    snprintf(name, sizeof(name), "random: %u cases of 1..%u frames match the nearest-rank reference", RandomCases, FrameStats::WindowSize);
+    Check(failed == 0, name);
+}
+
+//-----------------------------------------------------------------------------
+//      記録と集計を別スレッドで行うテストです.
+//-----------------------------------------------------------------------------
+void TestConcurrent(FrameStats& stats)
+{
+    stats.Reset();
+
+    std::atomic<bool> done(false);
+    std::thread writer([&]()
+    {
+        // 10 ～ 20ms の範囲だけを書く.
+        for (auto i = 0u; i < StressFrames; ++i)
+        { stats.AddFrame(10.0f + float(i % 1000) * 0.01f, 1.0f, 1.0f); }
+        done.store(true);
+    });
+
+    auto reads   = 0u;
+    auto ordered = true;
+    while (!done.load())
+    {
+        FrameStatsSummary summary = {};
+        if (!stats.GetSummary(summary))
+        { continue; }
+
+        reads++;
+        ordered = ordered
+            && summary.SampleCount <= FrameStats::WindowSize
+            && summary.MinMs >= 10.0f && summary.MaxMs < 20.0f
+            && summary.MinMs <= summary.P50Ms && summary.P50Ms <= summary.P95Ms
+            && summary.P95Ms <= summary.P99Ms && summary.P99Ms <= summary.MaxMs;
+    }
+    writer.join();
+
+    Check(ordered && stats.GetFrameCount() == StressFrames, "concurrent: summaries stay ordered and in range while recording");
+    printf("       (%u summaries taken during %u frames)\n", reads, StressFrames);
+}
+
+//-----------------------------------------------------------------------------
+//      CSV と表示用文字列のテストです.
+//-----------------------------------------------------------------------------
+void TestOutput(FrameStats& stats)
+{
+    std::vector<float> values;
+    for (auto i = 1; i <= 100; ++i)
+    { values.push_back(float(i)); }
+
+    FrameStatsSummary summary = {};
+    Summarize(stats, values, summary);
+
+    Check(!stats.WriteCsv(summary), "csv: write fails before open");
+    Check(!stats.OpenCsv(nullptr), "csv: null path rejected");
+
+    auto opened  = stats.OpenCsv(CsvPath);
+    auto written = stats.WriteCsv(summary) && stats.WriteCsv(summary);
+    stats.CloseCsv();
+
+    std::ifstream stream(CsvPath);
+    std::vector<std::string> lines;
+    for (std::string line; std::getline(stream, line);)
+    { lines.push_back(line); }
+    stream.close();
+    remove(CsvPath);
+
+    auto columns = [](const std::string& line) { return 1 + std::count(line.begin(), line.end(), ','); };
+    Check(opened && written && lines.size() == 3, "csv: header and one line per write");
+    Check(lines.size() == 3 && columns(lines[0]) == 14 && columns(lines[1]) == 14
+       && lines[1].compare(0, 35, "100,100,1.000,50.500,100.000,50.000") == 0,
+        "csv: 14 columns, values in header order");
+
+    char overlay[256];
+    FrameStats::FormatOverlay(summary, overlay, sizeof(overlay));
+    Check(strstr(overlay, "(1% low 10.0)") != nullptr && strstr(overlay, "p99 99.00") != nullptr, "overlay: fps, 1% low and percentiles");
+
+    char small[8];
+    FrameStats::FormatOverlay(summary, small, sizeof(small));
+    Check(strlen(small) == sizeof(small) - 1, "overlay: truncated to the buffer");
+}
+
+//-----------------------------------------------------------------------------
+//      使い方を表示します.
+//-----------------------------------------------------------------------------
+void PrintUsage()
+{ printf("Usage : FrameStatsTest\n"); }
+
+} // namespace
+
+
+//-----------------------------------------------------------------------------
+//      メインエントリーポイントです.
+//-----------------------------------------------------------------------------
+int main(int argc, char** argv)
+{
+    if (argc > 1)
+    {
+        PrintUsage();
+        return (strcmp(argv[1], "--help") == 0) ? 0 : -1;
+    }
+
+    // 集計用の作業領域を含むので, スタックには置かない.
+    std::unique_ptr<FrameStats> stats(new FrameStats());
+
+    TestKnownVectors(*stats);
+    TestWindow      (*stats);
+    TestRandom      (*stats);
+    TestConcurrent  (*stats);
+    TestOutput      (*stats);
+
+    if (g_FailCount > 0)
+    {
+        fprintf(stderr, "Error : %u check(s) failed.\n", g_FailCount);
+        return -1;
+    }
+
+    return 0;
+}
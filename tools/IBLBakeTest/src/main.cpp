@@ -0,0 +1,328 @@
+﻿//-----------------------------------------------------------------------------
+// File : main.cpp
+// Desc : IBL Bake Scheduler Test With Simulated GPU Clock.
+// Copyright(c) Pocol. All right reserved.
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------
+#include "IBLBakeScheduler.h"
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+
+namespace {
+
+//-----------------------------------------------------------------------------
+// Constant Values.
+//-----------------------------------------------------------------------------
+constexpr uint32_t  FaceCount       = 6;        // キューブマップの面の数.
+constexpr uint32_t  MipCount        = 8;        // 鏡面反射のLD項のミップ数.
+constexpr uint32_t  FrameCount      = 2;        // フレームバッファ数(計測結果は2フレーム後に届く).
+constexpr uint32_t  BakeCount       = 12;       // 繰り返すベイクの回数.
+constexpr double    Budget          = 2.0;      // 予算[ms].
+constexpr double    Tolerance       = 0.05;     // 見積もりの許容誤差(比).
+
+///////////////////////////////////////////////////////////////////////////////
+// WORK_KIND enum
+///////////////////////////////////////////////////////////////////////////////
+enum WORK_KIND
+{
+    WORK_DFG = 0,
+    WORK_DIFFUSE_LD,
+    WORK_SPECULAR_LD,
+    WORK_KIND_COUNT,
+};
+
+// 初期見積もり(ProgressiveIBLBaker と同じ)と, 模擬GPUでの実際のコスト[ms](重み1あたり).
+constexpr double InitialCost[WORK_KIND_COUNT] = { 0.5, 0.3, 0.3 };
+constexpr double TrueCost   [WORK_KIND_COUNT] = { 0.8, 1.2, 0.9 };
+
+///////////////////////////////////////////////////////////////////////////////
+// BakeResult structure
+///////////////////////////////////////////////////////////////////////////////
+struct BakeResult
+{
+    uint32_t    Frames;             //!< ベイクにかかったフレーム数です.
+    uint32_t    OverBudgetFrames;   //!< 複数の作業を発行して予算を超えたフレーム数です.
+    double      MaxFrameMs;         //!< 1フレームの最大GPU時間[ms]です.
+    bool        InOrder;            //!< 全ての作業が積んだ順に1回ずつ発行されたかどうか.
+};
+
+uint32_t g_FailCount = 0;   // 失敗した確認の数.
+
+//-----------------------------------------------------------------------------
+//      確認結果を表示します.
+//-----------------------------------------------------------------------------
+void Check(bool condition, const char* name)
+{
+    printf("[%s] %s\n", condition ? "PASS" : "FAIL", name);
+    if (!condition)
+    { g_FailCount++; }
+}
+
+//-----------------------------------------------------------------------------
+//      ProgressiveIBLBaker と同じ順で作業を積みます.
+//-----------------------------------------------------------------------------
+std::vector<IBLBakeScheduler::WorkUnit> PushAll(IBLBakeScheduler& scheduler, bool dfg)
+{
+    std::vector<IBLBakeScheduler::WorkUnit> units;
+
+    if (dfg)
+    { units.push_back({ WORK_DFG, 0, 1.0 }); }
+
+    for (auto face = 0u; face < FaceCount; ++face)
+    { units.push_back({ WORK_DIFFUSE_LD, face, 1.0 }); }
+
+    for (auto mip = 0u; mip < MipCount; ++mip)
+    {
+        auto weight = 1.0 / double(1u << (2 * mip));
+        for (auto face = 0u; face < FaceCount; ++face)
+        { units.push_back({ WORK_SPECULAR_LD, mip * FaceCount + face, weight }); }
+    }
+
+    for (auto& unit : units)
+    { scheduler.Push(unit.Kind, unit.Index, unit.Weight); }
+
+    return units;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// SimulatedGpu class
+///////////////////////////////////////////////////////////////////////////////
+//! @note       フレーム番号ごとに計測結果を保持し, 同じ番号の次のフレームの開始時に報告します.
+///////////////////////////////////////////////////////////////////////////////
+class SimulatedGpu
+{
+public:
+    SimulatedGpu()
+    : m_FrameCounter(0)
+    {
+        for (auto i = 0u; i < FrameCount; ++i)
+        {
+            m_Measured[i] = 0.0;
+            m_Pending [i] = false;
+        }
+    }
+
+    //-------------------------------------------------------------------------
+    //! @brief      1フレーム進めます.
+    //!
+    //! @param[in]      scheduler   スケジューラです.
+    //! @param[out]     issued      発行された作業の格納先です.
+    //! @return     このフレームのGPU時間[ms]を返却します.
+    //-------------------------------------------------------------------------
+    double Step(IBLBakeScheduler& scheduler, std::vector<IBLBakeScheduler::WorkUnit>& issued)
+    {
+        auto frameIndex = m_FrameCounter % FrameCount;
+        m_FrameCounter++;
+
+        // 同じフレーム番号で前回計測した結果を報告する.
+        if (m_Pending[frameIndex])
+        {
+            scheduler.ReportFrame(frameIndex, m_Measured[frameIndex]);
+            m_Pending[frameIndex] = false;
+        }
+
+        scheduler.BeginFrame(frameIndex);
+
+        auto gpuMs = 0.0;
+        IBLBakeScheduler::WorkUnit unit;
+        while (scheduler.Next(unit))
+        {
+            issued.push_back(unit);
+            gpuMs += TrueCost[unit.Kind] * unit.Weight;
+        }
+
+        m_Measured[frameIndex] = gpuMs;
+        m_Pending [frameIndex] = true;
+        return gpuMs;
+    }
+
+private:
+    uint32_t    m_FrameCounter;
+    double      m_Measured[FrameCount];
+    bool        m_Pending [FrameCount];
+};
+
+//-----------------------------------------------------------------------------
+//      1回ベイクします.
+//-----------------------------------------------------------------------------
+BakeResult Bake(IBLBakeScheduler& scheduler, SimulatedGpu& gpu, bool dfg)
+{
+    BakeResult result = {};
+    result.InOrder = true;
+
+    scheduler.Reset();
+    auto expected = PushAll(scheduler, dfg);
+
+    std::vector<IBLBakeScheduler::WorkUnit> issued;
+    while (!scheduler.IsEmpty())
+    {
+        auto before = issued.size();
+        auto gpuMs  = gpu.Step(scheduler, issued);
+        auto count  = issued.size() - before;
+
+        result.Frames++;
+        if (gpuMs > result.MaxFrameMs)
+        { result.MaxFrameMs = gpuMs; }
+
+        if (count > 1 && gpuMs > Budget)
+        { result.OverBudgetFrames++; }
+
+        // 予算を超えるので作業を残して終えることはあっても, 何も発行しないことはない.
+        if (count == 0)
+        {
+            result.InOrder = false;
+            break;
+        }
+    }
+
+    if (issued.size() != expected.size())
+    { result.InOrder = false; }
+
+    for (size_t i = 0; i < issued.size() && i < expected.size(); ++i)
+    {
+        if (issued[i].Kind != expected[i].Kind || issued[i].Index != expected[i].Index)
+        { result.InOrder = false; }
+    }
+
+    return result;
+}
+
+//-----------------------------------------------------------------------------
+//      見積もりが実際のコストに収束したかどうか.
+//-----------------------------------------------------------------------------
+bool IsConverged(const IBLBakeScheduler& scheduler, uint32_t kind)
+{
+    auto estimate = scheduler.GetCostEstimate(kind);
+    return std::fabs(estimate - TrueCost[kind]) <= TrueCost[kind] * Tolerance;
+}
+
+//-----------------------------------------------------------------------------
+//      重複した報告と番号の合わない報告を無視するか確認します.
+//-----------------------------------------------------------------------------
+void TestStaleReport()
+{
+    IBLBakeScheduler scheduler;
+    scheduler.SetBudget(Budget);
+    scheduler.SetCostEstimate(WORK_DIFFUSE_LD, 1.0);
+
+    scheduler.Push(WORK_DIFFUSE_LD, 0);
+    scheduler.BeginFrame(1);
+
+    IBLBakeScheduler::WorkUnit unit;
+    scheduler.Next(unit);
+
+    // 同じスロットを使う別のフレーム番号は無視する.
+    scheduler.ReportFrame(1 + IBLBakeScheduler::HistorySize, 100.0);
+    Check(scheduler.GetCostEstimate(WORK_DIFFUSE_LD) == 1.0, "mismatched frame index is ignored");
+
+    scheduler.ReportFrame(1, 2.0);
+    auto once = scheduler.GetCostEstimate(WORK_DIFFUSE_LD);
+    Check(once > 1.0, "matching frame index updates estimate");
+
+    scheduler.ReportFrame(1, 100.0);
+    Check(scheduler.GetCostEstimate(WORK_DIFFUSE_LD) == once, "duplicate report is ignored");
+
+    // 何も発行していないフレームの報告は無視する.
+    scheduler.BeginFrame(2);
+    scheduler.ReportFrame(2, 100.0);
+    Check(scheduler.GetCostEstimate(WORK_DIFFUSE_LD) == once, "report for idle frame is ignored");
+}
+
+//-----------------------------------------------------------------------------
+//      重みの小さい作業がまとめて発行されるか確認します.
+//-----------------------------------------------------------------------------
+void TestWeightedPacking()
+{
+    IBLBakeScheduler scheduler;
+    scheduler.SetBudget(Budget);
+    scheduler.SetCostEstimate(WORK_SPECULAR_LD, 1.0);
+
+    // ミップ0の1面は1.0ms, ミップ2の1面は1/16ms.
+    for (auto face = 0u; face < FaceCount; ++face)
+    { scheduler.Push(WORK_SPECULAR_LD, face, 1.0); }
+    for (auto face = 0u; face < FaceCount; ++face)
+    { scheduler.Push(WORK_SPECULAR_LD, 2 * FaceCount + face, 1.0 / 16.0); }
+
+    std::vector<uint32_t> perFrame;
+    for (auto frame = 0u; !scheduler.IsEmpty(); ++frame)
+    {
+        scheduler.BeginFrame(frame);
+
+        uint32_t count = 0;
+        IBLBakeScheduler::WorkUnit unit;
+        while (scheduler.Next(unit))
+        { count++; }
+
+        perFrame.push_back(count);
+    }
+
+    // 2, 2, 2 の後に小さいミップの6面が1フレームに収まる.
+    Check(perFrame.size() == 4 && perFrame[0] == 2 && perFrame[3] == FaceCount, "small mips are packed by weight");
+}
+
+} // namespace
+
+
+//-----------------------------------------------------------------------------
+//      メインエントリーポイントです.
+//-----------------------------------------------------------------------------
+int main(int, char**)
+{
+    IBLBakeScheduler scheduler;
+    scheduler.SetBudget(Budget);
+    for (auto i = 0u; i < WORK_KIND_COUNT; ++i)
+    { scheduler.SetCostEstimate(i, InitialCost[i]); }
+
+    SimulatedGpu gpu;
+
+    printf("%6s %8s %12s %14s %10s %10s %10s\n",
+        "bake", "frames", "over budget", "max frame[ms]", "dfg[ms]", "diffuse", "specular");
+
+    BakeResult first = {};
+    BakeResult last  = {};
+    auto inOrder = true;
+
+    for (auto i = 0u; i < BakeCount; ++i)
+    {
+        // DFG項は最初の1回だけ積分する.
+        auto result = Bake(scheduler, gpu, i == 0);
+        inOrder = inOrder && result.InOrder;
+
+        printf("%6u %8u %12u %14.3f %10.3f %10.3f %10.3f\n",
+            i,
+            result.Frames,
+            result.OverBudgetFrames,
+            result.MaxFrameMs,
+            scheduler.GetCostEstimate(WORK_DFG),
+            scheduler.GetCostEstimate(WORK_DIFFUSE_LD),
+            scheduler.GetCostEstimate(WORK_SPECULAR_LD));
+
+        if (i == 0)
+        { first = result; }
+        last = result;
+    }
+
+    Check(inOrder, "every unit is issued once in push order");
+    Check(first.OverBudgetFrames > 0, "initial underestimate overruns the budget");
+    // DFG項は1回しか積分しないので, 収束を確認するのはLD項だけ.
+    Check(IsConverged(scheduler, WORK_DIFFUSE_LD), "diffuse estimate converges within 5%");
+    Check(IsConverged(scheduler, WORK_SPECULAR_LD), "specular estimate converges within 5%");
+    Check(last.OverBudgetFrames == 0, "multi-unit frames stay within budget after convergence");
+
+    TestStaleReport();
+    TestWeightedPacking();
+
+    if (g_FailCount > 0)
+    {
+        fprintf(stderr, "Error : %u check(s) failed.\n", g_FailCount);
+        return -1;
+    }
+
+    return 0;
+}
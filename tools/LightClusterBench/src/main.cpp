@@ -0,0 +1,457 @@
+﻿//-----------------------------------------------------------------------------
+// File : main.cpp
+// Desc : Clustered Light Assignment Benchmark Entry Point.
+// Copyright(c) Pocol. All right reserved.
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------
+#include "LightClusterCPU.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <thread>
+#include <vector>
+
+
+namespace {
+
+//-----------------------------------------------------------------------------
+// Constant Values.
+//-----------------------------------------------------------------------------
+constexpr uint32_t      DefaultMinCount     = 1024;             // 既定の最小のライト数.
+constexpr uint32_t      DefaultMaxCount     = 65536;            // 既定の最大のライト数.
+constexpr uint32_t      DefaultRepeat       = 20;               // 既定の計測回数(平均を採ります).
+constexpr uint32_t      DefaultVerifyMax    = 16384;            // 照合する最大のライト数.
+constexpr uint32_t      SamplesPerLight     = 32;               // 照合でライトの球の内部から採る点の数.
+constexpr uint32_t      Width               = 1920;             // 描画する横幅.
+constexpr uint32_t      Height              = 1080;             // 描画する縦幅.
+constexpr float         NearZ               = 0.1f;             // 最初のスライスの手前の深度.
+constexpr float         FarZ                = 100.0f;           // 最後のスライスの奥の深度.
+constexpr float         FovY                = 0.78539816f;      // 垂直画角(45度).
+
+///////////////////////////////////////////////////////////////////////////////
+// SCENE enum
+///////////////////////////////////////////////////////////////////////////////
+enum SCENE
+{
+    SCENE_SCATTERED = 0,    //!< SampleApp と同じく 40x10x40 の範囲にばら撒きます.
+    SCENE_DENSE,            //!< カメラの前の狭い範囲に集め, クラスターの上限を超えさせます.
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// Timer class
+///////////////////////////////////////////////////////////////////////////////
+class Timer
+{
+public:
+    Timer()
+    : m_Begin(std::chrono::steady_clock::now())
+    { /* DO_NOTHING */ }
+
+    double GetElapsedMs() const
+    { return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - m_Begin).count(); }
+
+private:
+    std::chrono::steady_clock::time_point m_Begin;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// Verify structure
+///////////////////////////////////////////////////////////////////////////////
+struct Verify
+{
+    uint64_t    Missed;     //!< 球の内部の点を含むクラスターに割り当てられなかった数です(上限に達して落ちた分は除く).
+    uint64_t    Extra;      //!< GPU版の判定(AABB の総当たり)で重ならないのに割り当てられた組の数です.
+    uint64_t    Pruned;     //!< GPU版の判定では重なるが, 射影した範囲の外なので省いた組の数です.
+    uint64_t    Unordered;  //!< 番号の小さい順に並んでいない, または上限に達したクラスターで小さい番号が残っていない数です.
+};
+
+//-----------------------------------------------------------------------------
+//      ライトを生成します.
+//-----------------------------------------------------------------------------
+void CreateLights(SCENE scene, uint32_t count, std::vector<ClusterLight>& lights)
+{
+    std::mt19937 rng(count);
+    std::uniform_real_distribution<float> u(-1.0f, 1.0f);
+
+    lights.resize(count);
+    for (auto& light : lights)
+    {
+        memset(&light, 0, sizeof(light));
+
+        if (scene == SCENE_DENSE)
+        {
+            // 視点の 4m 先の 2m 立方に集める.
+            light.Position[0] = u(rng);
+            light.Position[1] = u(rng) + 1.0f;
+            light.Position[2] = u(rng) + 1.0f;
+        }
+        else
+        {
+            light.Position[0] = u(rng) * 20.0f;
+            light.Position[1] = u(rng) * 5.0f + 1.0f;
+            light.Position[2] = u(rng) * 20.0f;
+        }
+
+        light.Range         = 0.5f + std::fabs(u(rng)) * 1.5f;
+        light.Color[0]      = 1.0f;
+        light.Color[1]      = 1.0f;
+        light.Color[2]      = 1.0f;
+        light.Intensity     = 1.0f;
+        light.Direction[1]  = -1.0f;
+        light.Type          = (rng() % 4 == 0) ? CLUSTER_LIGHT_SPOT : CLUSTER_LIGHT_POINT;
+        light.SpotCosOuter  = std::cos(0.2f + std::fabs(u(rng)));
+        light.SpotCosInner  = std::min(light.SpotCosOuter + 0.05f, 1.0f);
+    }
+}
+
+//-----------------------------------------------------------------------------
+//      定数を作ります(視点は (0, 1, 5) で -z を向きます).
+//-----------------------------------------------------------------------------
+CbCluster CreateConstants(uint32_t lightCount)
+{
+    const float view[16] = {
+        1.0f,  0.0f,  0.0f, 0.0f,
+        0.0f,  1.0f,  0.0f, 0.0f,
+        0.0f,  0.0f,  1.0f, 0.0f,
+        0.0f, -1.0f, -5.0f, 1.0f,
+    };
+
+    auto scaleY = 1.0f / std::tan(FovY * 0.5f);
+    auto scaleX = scaleY * float(Height) / float(Width);
+    return MakeClusterConstants(view, scaleX, scaleY, NearZ, FarZ, Width, Height, lightCount);
+}
+
+//-----------------------------------------------------------------------------
+//      スライスの手前の深度を求めます(clustered_lighting.hlsli と同じ).
+//-----------------------------------------------------------------------------
+float GetSliceDepth(const CbCluster& constants, uint32_t slice)
+{
+    if (slice == 0)
+    { return constants.NearZ; }
+    if (slice >= CLUSTER_COUNT_Z)
+    { return constants.FarZ; }
+
+    return std::exp((float(slice) + constants.LogDepthBias) / constants.LogDepthScale);
+}
+
+//-----------------------------------------------------------------------------
+//      ライトの境界球をビュー空間で求めます(clustered_lighting.hlsli と同じ).
+//-----------------------------------------------------------------------------
+void GetViewSphere(const CbCluster& constants, const ClusterLight& light, float center[3], float& radius)
+{
+    float world[3] = { light.Position[0], light.Position[1], light.Position[2] };
+    radius = light.Range;
+
+    if (light.Type == CLUSTER_LIGHT_SPOT)
+    {
+        auto cosAngle = std::min(std::max(light.SpotCosOuter, 0.0f), 1.0f);
+        auto offset   = 0.0f;
+        if (cosAngle < 0.70710678f)
+        {
+            offset = light.Range * cosAngle;
+            radius = light.Range * std::sqrt(1.0f - cosAngle * cosAngle);
+        }
+        else
+        {
+            offset = light.Range * 0.5f / cosAngle;
+            radius = offset;
+        }
+
+        for (auto k = 0; k < 3; ++k)
+        { world[k] += light.Direction[k] * offset; }
+    }
+
+    auto& m = constants.View;
+    center[0] =   world[0] * m[0] + world[1] * m[4] + world[2] * m[ 8] + m[12];
+    center[1] =   world[0] * m[1] + world[1] * m[5] + world[2] * m[ 9] + m[13];
+    center[2] = -(world[0] * m[2] + world[1] * m[6] + world[2] * m[10] + m[14]);
+}
+
+//-----------------------------------------------------------------------------
+//      リストにライトが含まれるかどうか.
+//-----------------------------------------------------------------------------
+bool Contains(const LightClusterCPU& cluster, uint32_t index, uint32_t light)
+{
+    auto& range = cluster.GetRanges()[index];
+    auto  pList = cluster.GetIndices() + range.Offset;
+    return std::binary_search(pList, pList + range.Count, light);
+}
+
+//-----------------------------------------------------------------------------
+//      割り当て結果を照合します.
+//-----------------------------------------------------------------------------
+Verify VerifyAssignment(const CbCluster& constants, const ClusterLight* pLights, const LightClusterCPU& cluster)
+{
+    Verify result = {};
+
+    auto pRanges  = cluster.GetRanges();
+    auto pIndices = cluster.GetIndices();
+
+    std::vector<float> spheres(size_t(constants.LightCount) * 4);
+    for (auto i = 0u; i < constants.LightCount; ++i)
+    { GetViewSphere(constants, pLights[i], &spheres[i * 4], spheres[i * 4 + 3]); }
+
+    // 各リストが昇順であること.
+    for (auto c = 0u; c < CLUSTER_COUNT; ++c)
+    {
+        for (auto k = 1u; k < pRanges[c].Count; ++k)
+        {
+            if (pIndices[pRanges[c].Offset + k - 1] >= pIndices[pRanges[c].Offset + k])
+            { result.Unordered++; }
+        }
+    }
+
+    // 球の内部の点を含むクラスターには必ず割り当てられていること.
+    // 上限に達したクラスターでは, 残した最大の番号より小さいライトが含まれていること.
+    std::mt19937 rng(constants.LightCount);
+    std::uniform_real_distribution<float> u(-1.0f, 1.0f);
+    for (auto i = 0u; i < constants.LightCount; ++i)
+    {
+        auto pSphere = &spheres[i * 4];
+        for (auto s = 0u; s < SamplesPerLight; ++s)
+        {
+            float offset[3] = { u(rng), u(rng), u(rng) };
+            if (offset[0] * offset[0] + offset[1] * offset[1] + offset[2] * offset[2] > 1.0f)
+            { continue; }
+
+            auto px = pSphere[0] + offset[0] * pSphere[3];
+            auto py = pSphere[1] + offset[1] * pSphere[3];
+            auto pd = pSphere[2] + offset[2] * pSphere[3];
+            if (!(pd > constants.NearZ) || pd >= constants.FarZ)
+            { continue; }
+
+            auto ndcX = px * constants.ProjScaleX / pd;
+            auto ndcY = py * constants.ProjScaleY / pd;
+            if (std::fabs(ndcX) >= 1.0f || std::fabs(ndcY) >= 1.0f)
+            { continue; }
+
+            auto tx    = std::min(uint32_t((ndcX + 1.0f) * 0.5f * CLUSTER_COUNT_X), CLUSTER_COUNT_X - 1);
+            auto ty    = std::min(uint32_t((1.0f - ndcY) * 0.5f * CLUSTER_COUNT_Y), CLUSTER_COUNT_Y - 1);
+            auto tz    = GetClusterSlice(constants, pd);
+            auto index = (tz * CLUSTER_COUNT_Y + ty) * CLUSTER_COUNT_X + tx;
+
+            if (Contains(cluster, index, i))
+            { continue; }
+
+            auto& range = pRanges[index];
+            if (range.Count < CLUSTER_MAX_LIGHTS)
+            { result.Missed++; }
+            else if (i < pIndices[range.Offset + range.Count - 1])
+            { result.Unordered++; }
+        }
+    }
+
+    // GPU版と同じ AABB の総当たりの判定と比べる(CPU版はその部分集合になる).
+    for (auto z = 0u; z < CLUSTER_COUNT_Z; ++z)
+    {
+        auto dn = GetSliceDepth(constants, z);
+        auto df = GetSliceDepth(constants, z + 1);
+
+        for (auto y = 0u; y < CLUSTER_COUNT_Y; ++y)
+        {
+            for (auto x = 0u; x < CLUSTER_COUNT_X; ++x)
+            {
+                float ndc0[2] = { -1.0f + 2.0f * float(x)     / CLUSTER_COUNT_X, 1.0f - 2.0f * float(y + 1) / CLUSTER_COUNT_Y };
+                float ndc1[2] = { -1.0f + 2.0f * float(x + 1) / CLUSTER_COUNT_X, 1.0f - 2.0f * float(y)     / CLUSTER_COUNT_Y };
+                float invScale[2] = { 1.0f / constants.ProjScaleX, 1.0f / constants.ProjScaleY };
+
+                float minBound[3];
+                float maxBound[3];
+                for (auto k = 0; k < 2; ++k)
+                {
+                    minBound[k] = std::min(ndc0[k] * dn, ndc0[k] * df) * invScale[k];
+                    maxBound[k] = std::max(ndc1[k] * dn, ndc1[k] * df) * invScale[k];
+                }
+                minBound[2] = dn;
+                maxBound[2] = df;
+
+                auto& range = pRanges[(z * CLUSTER_COUNT_Y + y) * CLUSTER_COUNT_X + x];
+                auto  pList = pIndices + range.Offset;
+                auto  found = 0u;
+
+                for (auto i = 0u; i < constants.LightCount; ++i)
+                {
+                    auto pSphere = &spheres[i * 4];
+                    auto distSq  = 0.0f;
+                    for (auto k = 0; k < 3; ++k)
+                    {
+                        auto d = std::max(minBound[k] - pSphere[k], 0.0f) + std::max(pSphere[k] - maxBound[k], 0.0f);
+                        distSq += d * d;
+                    }
+
+                    if (!(pSphere[3] > 0.0f && distSq <= pSphere[3] * pSphere[3]))
+                    { continue; }
+
+                    if (std::binary_search(pList, pList + range.Count, i))
+                    { found++; }
+                    else if (range.Count < CLUSTER_MAX_LIGHTS)
+                    { result.Pruned++; }
+                }
+
+                result.Extra += range.Count - found;
+            }
+        }
+    }
+
+    return result;
+}
+
+//-----------------------------------------------------------------------------
+//      使い方を表示します.
+//-----------------------------------------------------------------------------
+void PrintUsage()
+{
+    printf("Usage : LightClusterBench [options]\n");
+    printf("    --min <n>           min light count, multiplied by 4 (default %u)\n", DefaultMinCount);
+    printf("    --max <n>           max light count (default %u)\n", DefaultMaxCount);
+    printf("    --threads <n>       threads for the parallel path (default hardware threads)\n");
+    printf("    --repeat <n>        assignments per measurement, averaged (default %u)\n", DefaultRepeat);
+    printf("    --verify-max <n>    max light count to verify (default %u)\n", DefaultVerifyMax);
+}
+
+} // namespace
+
+
+//-----------------------------------------------------------------------------
+//      メインエントリーポイントです.
+//-----------------------------------------------------------------------------
+int main(int argc, char** argv)
+{
+    auto minCount  = DefaultMinCount;
+    auto maxCount  = DefaultMaxCount;
+    auto repeat    = DefaultRepeat;
+    auto verifyMax = DefaultVerifyMax;
+    auto threads   = std::max(1u, std::thread::hardware_concurrency());
+
+    for (auto i = 1; i < argc; ++i)
+    {
+        auto hasValue = (i + 1 < argc);
+        if (strcmp(argv[i], "--min") == 0 && hasValue)
+        { minCount = uint32_t(strtoul(argv[++i], nullptr, 10)); }
+        else if (strcmp(argv[i], "--max") == 0 && hasValue)
+        { maxCount = uint32_t(strtoul(argv[++i], nullptr, 10)); }
+        else if (strcmp(argv[i], "--threads") == 0 && hasValue)
+        { threads = uint32_t(strtoul(argv[++i], nullptr, 10)); }
+        else if (strcmp(argv[i], "--repeat") == 0 && hasValue)
+        { repeat = uint32_t(strtoul(argv[++i], nullptr, 10)); }
+        else if (strcmp(argv[i], "--verify-max") == 0 && hasValue)
+        { verifyMax = uint32_t(strtoul(argv[++i], nullptr, 10)); }
+        else
+        {
+            PrintUsage();
+            return -1;
+        }
+    }
+
+    if (minCount == 0 || maxCount < minCount || maxCount > CLUSTER_MAX_LIGHT_COUNT || threads == 0 || repeat == 0)
+    {
+        PrintUsage();
+        return -1;
+    }
+
+    printf("%ux%u, %ux%ux%u clusters, cap %u lights/cluster, parallel threads : %u\n",
+        Width, Height, CLUSTER_COUNT_X, CLUSTER_COUNT_Y, CLUSTER_COUNT_Z, CLUSTER_MAX_LIGHTS, threads);
+    printf("%-9s %7s %10s %12s %9s %9s %9s %9s %7s %6s %8s\n",
+        "scene", "lights", "single[ms]", "parallel[ms]", "speedup", "indices", "max/clus", "dropped", "missed", "extra", "pruned");
+
+    auto failed    = false;
+    auto maxIndices = 0u;
+
+    LightClusterCPU single;
+    LightClusterCPU parallel;
+    std::vector<ClusterLight> lights;
+
+    const SCENE   scenes[]     = { SCENE_SCATTERED, SCENE_DENSE };
+    const char*   sceneNames[] = { "scattered", "dense" };
+
+    for (auto scene : scenes)
+    {
+        for (auto count = uint64_t(minCount); count <= maxCount; count *= 4)
+        {
+            CreateLights(scene, uint32_t(count), lights);
+            auto constants = CreateConstants(uint32_t(count));
+
+            double ms[2] = {};
+            LightClusterCPU* targets[2] = { &single, &parallel };
+            uint32_t threadCounts[2] = { 1, threads };
+            for (auto t = 0; t < 2; ++t)
+            {
+                // 1回目はメモリ確保を含むので捨てる.
+                targets[t]->Assign(constants, lights.data(), threadCounts[t]);
+
+                Timer timer;
+                for (auto r = 0u; r < repeat; ++r)
+                { targets[t]->Assign(constants, lights.data(), threadCounts[t]); }
+                ms[t] = timer.GetElapsedMs() / double(repeat);
+            }
+
+            // スレッド数によらず同じ結果になること.
+            auto same = single.GetIndexCount() == parallel.GetIndexCount()
+                && single.GetDroppedCount() == parallel.GetDroppedCount()
+                && memcmp(single.GetRanges(), parallel.GetRanges(), sizeof(ClusterRange) * CLUSTER_COUNT) == 0
+                && memcmp(single.GetIndices(), parallel.GetIndices(), sizeof(uint32_t) * single.GetIndexCount()) == 0;
+
+            maxIndices = std::max(maxIndices, single.GetIndexCount());
+
+            auto maxPerCluster = 0u;
+            for (auto i = 0u; i < CLUSTER_COUNT; ++i)
+            { maxPerCluster = std::max(maxPerCluster, single.GetRanges()[i].Count); }
+
+            char missed[32] = "-";
+            char extra [32] = "-";
+            char pruned[32] = "-";
+            if (count <= verifyMax)
+            {
+                auto verify = VerifyAssignment(constants, lights.data(), single);
+                sprintf(missed, "%llu", static_cast<unsigned long long>(verify.Missed));
+                sprintf(extra,  "%llu", static_cast<unsigned long long>(verify.Extra));
+                sprintf(pruned, "%llu", static_cast<unsigned long long>(verify.Pruned));
+
+                if (verify.Missed != 0 || verify.Extra != 0 || verify.Unordered != 0)
+                {
+                    fprintf(stderr, "Error : Assignment Mismatch. scene = %s, lights = %llu, missed = %llu, extra = %llu, unordered = %llu\n",
+                        sceneNames[scene], static_cast<unsigned long long>(count),
+                        static_cast<unsigned long long>(verify.Missed),
+                        static_cast<unsigned long long>(verify.Extra),
+                        static_cast<unsigned long long>(verify.Unordered));
+                    failed = true;
+                }
+            }
+
+            printf("%-9s %7llu %10.3f %12.3f %8.2fx %9u %9u %9u %7s %6s %8s\n",
+                sceneNames[scene],
+                static_cast<unsigned long long>(count),
+                ms[0],
+                ms[1],
+                ms[0] / ms[1],
+                single.GetIndexCount(),
+                maxPerCluster,
+                single.GetDroppedCount(),
+                missed,
+                extra,
+                pruned);
+
+            if (!same)
+            {
+                fprintf(stderr, "Error : Result Depends On Thread Count. scene = %s, lights = %llu\n",
+                    sceneNames[scene], static_cast<unsigned long long>(count));
+                failed = true;
+            }
+        }
+    }
+
+    // GPU版はクラスターごとに上限分の固定領域を使う.
+    printf("index buffer : compact (CPU) %.2f MiB at most, fixed slots (GPU) %.2f MiB\n",
+        double(maxIndices) * sizeof(uint32_t) / (1024.0 * 1024.0),
+        double(CLUSTER_COUNT) * CLUSTER_MAX_LIGHTS * sizeof(uint32_t) / (1024.0 * 1024.0));
+
+    return failed ? -1 : 0;
+}
@@ -0,0 +1,209 @@
+﻿//-----------------------------------------------------------------------------
+// File : main.cpp
+// Desc : Logger Contention Benchmark Entry Point.
+// Copyright(c) Pocol. All right reserved.
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------
+#include "AsyncLogger.h"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+
+namespace {
+
+//-----------------------------------------------------------------------------
+// Constant Values.
+//-----------------------------------------------------------------------------
+constexpr uint32_t      DefaultCount        = 100000;           // 既定のスレッドあたりの呼び出し回数.
+constexpr uint32_t      DefaultMaxThreads   = 8;                // 既定の最大スレッド数.
+constexpr const char*   SyncLogPath         = "LogBench_sync.log";
+constexpr const char*   AsyncLogPath        = "LogBench_async.log";
+
+///////////////////////////////////////////////////////////////////////////////
+// SCENARIO enum
+///////////////////////////////////////////////////////////////////////////////
+enum SCENARIO
+{
+    SCENARIO_SYNC = 0,          //!< ELOG と同じく呼び出し側で整形して書き出します.
+    SCENARIO_ASYNC,             //!< ALOG で積みます(流量制限無し).
+    SCENARIO_ASYNC_LIMITED,     //!< ALOG で積みます(既定の流量制限).
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// Result structure
+///////////////////////////////////////////////////////////////////////////////
+struct Result
+{
+    double      NsPerCall;      //!< 1回の呼び出しの平均時間[ns]です.
+    uint64_t    Dropped;        //!< キューが一杯で捨てた数です.
+    uint64_t    Suppressed;     //!< 流量制限で捨てた数です.
+};
+
+FILE* g_pSyncFile = nullptr;    // 同期書き出しの出力先です.
+
+//-----------------------------------------------------------------------------
+//      1回ログを出力します.
+//-----------------------------------------------------------------------------
+void LogOnce(SCENARIO scenario, uint32_t thread, uint32_t index)
+{
+    const auto hr = static_cast<int32_t>(0x887A0005);
+
+    switch (scenario)
+    {
+    case SCENARIO_SYNC:
+        fprintf(g_pSyncFile, "[File : %s, Line : %d] Error : Present() Failed. thread = %u, frame = %u, retcode = 0x%x\n",
+            __FILE__, __LINE__, thread, index, hr);
+        break;
+
+    case SCENARIO_ASYNC:
+    case SCENARIO_ASYNC_LIMITED:
+        ALOG("Error : Present() Failed. thread = %u, frame = %u, retcode = 0x%x", thread, index, hr);
+        break;
+    }
+}
+
+//-----------------------------------------------------------------------------
+//      指定スレッド数で計測します.
+//-----------------------------------------------------------------------------
+Result Measure(SCENARIO scenario, uint32_t threadCount, uint32_t count)
+{
+    auto& logger = GetAsyncLogger();
+    logger.SetRateLimit((scenario == SCENARIO_ASYNC_LIMITED) ? uint32_t(AsyncLogger::DefaultRateLimit) : 0u);
+    logger.Flush();
+
+    auto before = logger.GetStats();
+
+    std::atomic<uint32_t>   ready   { 0 };
+    std::atomic<bool>       start   { false };
+    std::vector<double>     elapsed (threadCount, 0.0);
+    std::vector<std::thread> threads;
+
+    for (auto t = 0u; t < threadCount; ++t)
+    {
+        threads.emplace_back([&, t]()
+        {
+            // 全スレッドが揃ってから同時に始める.
+            ready.fetch_add(1);
+            while (!start.load())
+            { std::this_thread::yield(); }
+
+            auto begin = std::chrono::steady_clock::now();
+            for (auto i = 0u; i < count; ++i)
+            { LogOnce(scenario, t, i); }
+            auto end = std::chrono::steady_clock::now();
+
+            elapsed[t] = std::chrono::duration<double, std::nano>(end - begin).count();
+        });
+    }
+
+    while (ready.load() < threadCount)
+    { std::this_thread::yield(); }
+    start.store(true);
+
+    for (auto& thread : threads)
+    { thread.join(); }
+
+    logger.Flush();
+    if (g_pSyncFile != nullptr)
+    { fflush(g_pSyncFile); }
+
+    auto after = logger.GetStats();
+
+    auto total = 0.0;
+    for (auto value : elapsed)
+    { total += value; }
+
+    Result result;
+    result.NsPerCall    = total / (double(threadCount) * double(count));
+    result.Dropped      = after.Dropped    - before.Dropped;
+    result.Suppressed   = after.Suppressed - before.Suppressed;
+    return result;
+}
+
+//-----------------------------------------------------------------------------
+//      使い方を表示します.
+//-----------------------------------------------------------------------------
+void PrintUsage()
+{
+    printf("Usage : LogBench [options]\n");
+    printf("    --count <n>         calls per thread (default %u)\n", DefaultCount);
+    printf("    --threads <n>       max threads, doubled from 1 (default %u)\n", DefaultMaxThreads);
+}
+
+} // namespace
+
+
+//-----------------------------------------------------------------------------
+//      メインエントリーポイントです.
+//-----------------------------------------------------------------------------
+int main(int argc, char** argv)
+{
+    auto count      = DefaultCount;
+    auto maxThreads = DefaultMaxThreads;
+
+    for (auto i = 1; i < argc; ++i)
+    {
+        auto hasValue = (i + 1 < argc);
+        if (strcmp(argv[i], "--count") == 0 && hasValue)
+        { count = uint32_t(strtoul(argv[++i], nullptr, 10)); }
+        else if (strcmp(argv[i], "--threads") == 0 && hasValue)
+        { maxThreads = uint32_t(strtoul(argv[++i], nullptr, 10)); }
+        else
+        {
+            PrintUsage();
+            return -1;
+        }
+    }
+
+    if (count == 0 || maxThreads == 0)
+    {
+        PrintUsage();
+        return -1;
+    }
+
+    g_pSyncFile = fopen(SyncLogPath, "w");
+    if (g_pSyncFile == nullptr)
+    {
+        fprintf(stderr, "Error : File Open Failed. path = %s\n", SyncLogPath);
+        return -1;
+    }
+
+    if (!GetAsyncLogger().Init(AsyncLogPath, false, false))
+    {
+        fprintf(stderr, "Error : File Open Failed. path = %s\n", AsyncLogPath);
+        fclose(g_pSyncFile);
+        return -1;
+    }
+
+    printf("calls per thread : %u\n", count);
+    printf("%8s %12s %12s %12s %14s %12s\n",
+        "threads", "sync[ns]", "async[ns]", "dropped", "limited[ns]", "suppressed");
+
+    for (auto threads = 1u; threads <= maxThreads; threads *= 2)
+    {
+        auto sync    = Measure(SCENARIO_SYNC,          threads, count);
+        auto async   = Measure(SCENARIO_ASYNC,         threads, count);
+        auto limited = Measure(SCENARIO_ASYNC_LIMITED, threads, count);
+
+        printf("%8u %12.1f %12.1f %12llu %14.1f %12llu\n",
+            threads,
+            sync.NsPerCall,
+            async.NsPerCall,
+            static_cast<unsigned long long>(async.Dropped),
+            limited.NsPerCall,
+            static_cast<unsigned long long>(limited.Suppressed));
+    }
+
+    GetAsyncLogger().Term();
+    fclose(g_pSyncFile);
+    return 0;
+}
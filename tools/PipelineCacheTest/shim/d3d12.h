@@ -0,0 +1,406 @@
+﻿//-----------------------------------------------------------------------------
+// File : d3d12.h
+// Desc : Minimal Direct3D 12 Type Shim For Non-Windows Test Builds.
+// Copyright(c) Pocol. All right reserved.
+//-----------------------------------------------------------------------------
+#pragma once
+
+//-----------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------
+#include <cstddef>
+#include <cstdint>
+
+//-----------------------------------------------------------------------------
+// NOTE : PipelineStateHash.cpp をWindows以外でビルドするためだけの定義です.
+//        構造体のメンバー構成と型はWindows SDKのd3d12.hに合わせています.
+//        列挙値はテストで使用するものだけを定義しています.
+//-----------------------------------------------------------------------------
+#if defined(_WIN32)
+#error "Use the Windows SDK d3d12.h on Windows."
+#endif
+
+//-----------------------------------------------------------------------------
+// Type definitions.
+//-----------------------------------------------------------------------------
+typedef int             BOOL;
+typedef int             INT;
+typedef unsigned int    UINT;
+typedef uint8_t         UINT8;
+typedef uint64_t        UINT64;
+typedef float           FLOAT;
+typedef size_t          SIZE_T;
+typedef const char*     LPCSTR;
+
+struct ID3D12RootSignature;
+
+enum DXGI_FORMAT
+{
+    DXGI_FORMAT_UNKNOWN                 = 0,
+    DXGI_FORMAT_R32G32B32_FLOAT         = 6,
+    DXGI_FORMAT_R16G16B16A16_FLOAT      = 10,
+    DXGI_FORMAT_R32G32_FLOAT            = 16,
+    DXGI_FORMAT_R10G10B10A2_UNORM       = 24,
+    DXGI_FORMAT_R8G8B8A8_UNORM          = 28,
+    DXGI_FORMAT_D32_FLOAT               = 40,
+    DXGI_FORMAT_D24_UNORM_S8_UINT       = 45,
+};
+
+struct DXGI_SAMPLE_DESC
+{
+    UINT    Count;
+    UINT    Quality;
+};
+
+//-----------------------------------------------------------------------------
+// Constant Values.
+//-----------------------------------------------------------------------------
+#define D3D12_SIMULTANEOUS_RENDER_TARGET_COUNT  ( 8 )
+#define D3D12_DEFAULT_STENCIL_READ_MASK         ( 0xff )
+#define D3D12_DEFAULT_STENCIL_WRITE_MASK        ( 0xff )
+
+enum D3D12_BLEND
+{
+    D3D12_BLEND_ZERO            = 1,
+    D3D12_BLEND_ONE             = 2,
+    D3D12_BLEND_SRC_ALPHA       = 5,
+    D3D12_BLEND_INV_SRC_ALPHA   = 6,
+};
+
+enum D3D12_BLEND_OP
+{
+    D3D12_BLEND_OP_ADD          = 1,
+    D3D12_BLEND_OP_SUBTRACT     = 2,
+};
+
+enum D3D12_LOGIC_OP
+{
+    D3D12_LOGIC_OP_CLEAR        = 0,
+    D3D12_LOGIC_OP_NOOP         = 4,
+};
+
+enum D3D12_COLOR_WRITE_ENABLE
+{
+    D3D12_COLOR_WRITE_ENABLE_ALL = 15,
+};
+
+enum D3D12_FILL_MODE
+{
+    D3D12_FILL_MODE_WIREFRAME   = 2,
+    D3D12_FILL_MODE_SOLID       = 3,
+};
+
+enum D3D12_CULL_MODE
+{
+    D3D12_CULL_MODE_NONE        = 1,
+    D3D12_CULL_MODE_FRONT       = 2,
+    D3D12_CULL_MODE_BACK        = 3,
+};
+
+enum D3D12_CONSERVATIVE_RASTERIZATION_MODE
+{
+    D3D12_CONSERVATIVE_RASTERIZATION_MODE_OFF   = 0,
+    D3D12_CONSERVATIVE_RASTERIZATION_MODE_ON    = 1,
+};
+
+enum D3D12_DEPTH_WRITE_MASK
+{
+    D3D12_DEPTH_WRITE_MASK_ZERO = 0,
+    D3D12_DEPTH_WRITE_MASK_ALL  = 1,
+};
+
+enum D3D12_COMPARISON_FUNC
+{
+    D3D12_COMPARISON_FUNC_NEVER         = 1,
+    D3D12_COMPARISON_FUNC_LESS          = 2,
+    D3D12_COMPARISON_FUNC_EQUAL         = 3,
+    D3D12_COMPARISON_FUNC_LESS_EQUAL    = 4,
+    D3D12_COMPARISON_FUNC_ALWAYS        = 8,
+};
+
+enum D3D12_STENCIL_OP
+{
+    D3D12_STENCIL_OP_KEEP       = 1,
+    D3D12_STENCIL_OP_ZERO       = 2,
+    D3D12_STENCIL_OP_REPLACE    = 3,
+    D3D12_STENCIL_OP_INCR       = 7,
+};
+
+enum D3D12_INPUT_CLASSIFICATION
+{
+    D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA      = 0,
+    D3D12_INPUT_CLASSIFICATION_PER_INSTANCE_DATA    = 1,
+};
+
+enum D3D12_INDEX_BUFFER_STRIP_CUT_VALUE
+{
+    D3D12_INDEX_BUFFER_STRIP_CUT_VALUE_DISABLED     = 0,
+    D3D12_INDEX_BUFFER_STRIP_CUT_VALUE_0xFFFF       = 1,
+    D3D12_INDEX_BUFFER_STRIP_CUT_VALUE_0xFFFFFFFF   = 2,
+};
+
+enum D3D12_PRIMITIVE_TOPOLOGY_TYPE
+{
+    D3D12_PRIMITIVE_TOPOLOGY_TYPE_UNDEFINED = 0,
+    D3D12_PRIMITIVE_TOPOLOGY_TYPE_TRIANGLE  = 3,
+};
+
+enum D3D12_PIPELINE_STATE_FLAGS
+{
+    D3D12_PIPELINE_STATE_FLAG_NONE  = 0,
+};
+
+enum D3D12_ROOT_SIGNATURE_FLAGS
+{
+    D3D12_ROOT_SIGNATURE_FLAG_NONE                                  = 0,
+    D3D12_ROOT_SIGNATURE_FLAG_ALLOW_INPUT_ASSEMBLER_INPUT_LAYOUT    = 0x1,
+};
+
+enum D3D12_ROOT_PARAMETER_TYPE
+{
+    D3D12_ROOT_PARAMETER_TYPE_DESCRIPTOR_TABLE  = 0,
+    D3D12_ROOT_PARAMETER_TYPE_32BIT_CONSTANTS   = 1,
+    D3D12_ROOT_PARAMETER_TYPE_CBV               = 2,
+    D3D12_ROOT_PARAMETER_TYPE_SRV               = 3,
+    D3D12_ROOT_PARAMETER_TYPE_UAV               = 4,
+};
+
+enum D3D12_SHADER_VISIBILITY
+{
+    D3D12_SHADER_VISIBILITY_ALL     = 0,
+    D3D12_SHADER_VISIBILITY_VERTEX  = 1,
+    D3D12_SHADER_VISIBILITY_PIXEL   = 5,
+};
+
+enum D3D12_DESCRIPTOR_RANGE_TYPE
+{
+    D3D12_DESCRIPTOR_RANGE_TYPE_SRV     = 0,
+    D3D12_DESCRIPTOR_RANGE_TYPE_UAV     = 1,
+    D3D12_DESCRIPTOR_RANGE_TYPE_CBV     = 2,
+    D3D12_DESCRIPTOR_RANGE_TYPE_SAMPLER = 3,
+};
+
+enum D3D12_FILTER
+{
+    D3D12_FILTER_MIN_MAG_MIP_POINT  = 0,
+    D3D12_FILTER_MIN_MAG_MIP_LINEAR = 0x15,
+};
+
+enum D3D12_TEXTURE_ADDRESS_MODE
+{
+    D3D12_TEXTURE_ADDRESS_MODE_WRAP     = 1,
+    D3D12_TEXTURE_ADDRESS_MODE_CLAMP    = 3,
+};
+
+enum D3D12_STATIC_BORDER_COLOR
+{
+    D3D12_STATIC_BORDER_COLOR_TRANSPARENT_BLACK = 0,
+    D3D12_STATIC_BORDER_COLOR_OPAQUE_BLACK      = 1,
+};
+
+//-----------------------------------------------------------------------------
+// Structures.
+//-----------------------------------------------------------------------------
+struct D3D12_SHADER_BYTECODE
+{
+    const void* pShaderBytecode;
+    SIZE_T      BytecodeLength;
+};
+
+struct D3D12_SO_DECLARATION_ENTRY
+{
+    UINT    Stream;
+    LPCSTR  SemanticName;
+    UINT    SemanticIndex;
+    UINT8   StartComponent;
+    UINT8   ComponentCount;
+    UINT8   OutputSlot;
+};
+
+struct D3D12_STREAM_OUTPUT_DESC
+{
+    const D3D12_SO_DECLARATION_ENTRY*   pSODeclaration;
+    UINT                                NumEntries;
+    const UINT*                         pBufferStrides;
+    UINT                                NumStrides;
+    UINT                                RasterizedStream;
+};
+
+struct D3D12_RENDER_TARGET_BLEND_DESC
+{
+    BOOL            BlendEnable;
+    BOOL            LogicOpEnable;
+    D3D12_BLEND     SrcBlend;
+    D3D12_BLEND     DestBlend;
+    D3D12_BLEND_OP  BlendOp;
+    D3D12_BLEND     SrcBlendAlpha;
+    D3D12_BLEND     DestBlendAlpha;
+    D3D12_BLEND_OP  BlendOpAlpha;
+    D3D12_LOGIC_OP  LogicOp;
+    UINT8           RenderTargetWriteMask;
+};
+
+struct D3D12_BLEND_DESC
+{
+    BOOL                            AlphaToCoverageEnable;
+    BOOL                            IndependentBlendEnable;
+    D3D12_RENDER_TARGET_BLEND_DESC  RenderTarget[ 8 ];
+};
+
+struct D3D12_RASTERIZER_DESC
+{
+    D3D12_FILL_MODE                         FillMode;
+    D3D12_CULL_MODE                         CullMode;
+    BOOL                                    FrontCounterClockwise;
+    INT                                     DepthBias;
+    FLOAT                                   DepthBiasClamp;
+    FLOAT                                   SlopeScaledDepthBias;
+    BOOL                                    DepthClipEnable;
+    BOOL                                    MultisampleEnable;
+    BOOL                                    AntialiasedLineEnable;
+    UINT                                    ForcedSampleCount;
+    D3D12_CONSERVATIVE_RASTERIZATION_MODE   ConservativeRaster;
+};
+
+struct D3D12_DEPTH_STENCILOP_DESC
+{
+    D3D12_STENCIL_OP        StencilFailOp;
+    D3D12_STENCIL_OP        StencilDepthFailOp;
+    D3D12_STENCIL_OP        StencilPassOp;
+    D3D12_COMPARISON_FUNC   StencilFunc;
+};
+
+struct D3D12_DEPTH_STENCIL_DESC
+{
+    BOOL                        DepthEnable;
+    D3D12_DEPTH_WRITE_MASK      DepthWriteMask;
+    D3D12_COMPARISON_FUNC       DepthFunc;
+    BOOL                        StencilEnable;
+    UINT8                       StencilReadMask;
+    UINT8                       StencilWriteMask;
+    D3D12_DEPTH_STENCILOP_DESC  FrontFace;
+    D3D12_DEPTH_STENCILOP_DESC  BackFace;
+};
+
+struct D3D12_INPUT_ELEMENT_DESC
+{
+    LPCSTR                      SemanticName;
+    UINT                        SemanticIndex;
+    DXGI_FORMAT                 Format;
+    UINT                        InputSlot;
+    UINT                        AlignedByteOffset;
+    D3D12_INPUT_CLASSIFICATION  InputSlotClass;
+    UINT                        InstanceDataStepRate;
+};
+
+struct D3D12_INPUT_LAYOUT_DESC
+{
+    const D3D12_INPUT_ELEMENT_DESC* pInputElementDescs;
+    UINT                            NumElements;
+};
+
+struct D3D12_CACHED_PIPELINE_STATE
+{
+    const void* pCachedBlob;
+    SIZE_T      CachedBlobSizeInBytes;
+};
+
+struct D3D12_GRAPHICS_PIPELINE_STATE_DESC
+{
+    ID3D12RootSignature*                pRootSignature;
+    D3D12_SHADER_BYTECODE               VS;
+    D3D12_SHADER_BYTECODE               PS;
+    D3D12_SHADER_BYTECODE               DS;
+    D3D12_SHADER_BYTECODE               HS;
+    D3D12_SHADER_BYTECODE               GS;
+    D3D12_STREAM_OUTPUT_DESC            StreamOutput;
+    D3D12_BLEND_DESC                    BlendState;
+    UINT                                SampleMask;
+    D3D12_RASTERIZER_DESC               RasterizerState;
+    D3D12_DEPTH_STENCIL_DESC            DepthStencilState;
+    D3D12_INPUT_LAYOUT_DESC             InputLayout;
+    D3D12_INDEX_BUFFER_STRIP_CUT_VALUE  IBStripCutValue;
+    D3D12_PRIMITIVE_TOPOLOGY_TYPE       PrimitiveTopologyType;
+    UINT                                NumRenderTargets;
+    DXGI_FORMAT                         RTVFormats[ 8 ];
+    DXGI_FORMAT                         DSVFormat;
+    DXGI_SAMPLE_DESC                    SampleDesc;
+    UINT                                NodeMask;
+    D3D12_CACHED_PIPELINE_STATE         CachedPSO;
+    D3D12_PIPELINE_STATE_FLAGS          Flags;
+};
+
+struct D3D12_COMPUTE_PIPELINE_STATE_DESC
+{
+    ID3D12RootSignature*            pRootSignature;
+    D3D12_SHADER_BYTECODE           CS;
+    UINT                            NodeMask;
+    D3D12_CACHED_PIPELINE_STATE     CachedPSO;
+    D3D12_PIPELINE_STATE_FLAGS      Flags;
+};
+
+struct D3D12_DESCRIPTOR_RANGE
+{
+    D3D12_DESCRIPTOR_RANGE_TYPE RangeType;
+    UINT                        NumDescriptors;
+    UINT                        BaseShaderRegister;
+    UINT                        RegisterSpace;
+    UINT                        OffsetInDescriptorsFromTableStart;
+};
+
+struct D3D12_ROOT_DESCRIPTOR_TABLE
+{
+    UINT                            NumDescriptorRanges;
+    const D3D12_DESCRIPTOR_RANGE*   pDescriptorRanges;
+};
+
+struct D3D12_ROOT_CONSTANTS
+{
+    UINT    ShaderRegister;
+    UINT    RegisterSpace;
+    UINT    Num32BitValues;
+};
+
+struct D3D12_ROOT_DESCRIPTOR
+{
+    UINT    ShaderRegister;
+    UINT    RegisterSpace;
+};
+
+struct D3D12_ROOT_PARAMETER
+{
+    D3D12_ROOT_PARAMETER_TYPE   ParameterType;
+    union
+    {
+        D3D12_ROOT_DESCRIPTOR_TABLE DescriptorTable;
+        D3D12_ROOT_CONSTANTS        Constants;
+        D3D12_ROOT_DESCRIPTOR       Descriptor;
+    };
+    D3D12_SHADER_VISIBILITY     ShaderVisibility;
+};
+
+struct D3D12_STATIC_SAMPLER_DESC
+{
+    D3D12_FILTER                Filter;
+    D3D12_TEXTURE_ADDRESS_MODE  AddressU;
+    D3D12_TEXTURE_ADDRESS_MODE  AddressV;
+    D3D12_TEXTURE_ADDRESS_MODE  AddressW;
+    FLOAT                       MipLODBias;
+    UINT                        MaxAnisotropy;
+    D3D12_COMPARISON_FUNC       ComparisonFunc;
+    D3D12_STATIC_BORDER_COLOR   BorderColor;
+    FLOAT                       MinLOD;
+    FLOAT                       MaxLOD;
+    UINT                        ShaderRegister;
+    UINT                        RegisterSpace;
+    D3D12_SHADER_VISIBILITY     ShaderVisibility;
+};
+
+struct D3D12_ROOT_SIGNATURE_DESC
+{
+    UINT                                NumParameters;
+    const D3D12_ROOT_PARAMETER*         pParameters;
+    UINT                                NumStaticSamplers;
+    const D3D12_STATIC_SAMPLER_DESC*    pStaticSamplers;
+    D3D12_ROOT_SIGNATURE_FLAGS          Flags;
+};
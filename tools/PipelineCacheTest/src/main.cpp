@@ -0,0 +1,476 @@
+﻿//-----------------------------------------------------------------------------
+// File : main.cpp
+// Desc : Pipeline State Hash And Cache File Test Entry Point.
+// Copyright(c) Pocol. All right reserved.
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------
+#include "PipelineStateHash.h"
+#include "PipelineCacheFile.h"
+#include <climits>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <vector>
+
+
+namespace {
+
+//-----------------------------------------------------------------------------
+// Constant Values.
+//-----------------------------------------------------------------------------
+constexpr uint64_t KeyA = 0x1111;   // 1番目のエントリのキー.
+constexpr uint64_t KeyB = 0x2222;   // 2番目のエントリのキー.
+constexpr uint64_t KeyC = 0x3333;   // 3番目のエントリのキー.
+constexpr size_t   FileHeaderSize  = 16;    // ファイルヘッダのサイズ.
+constexpr size_t   EntryHeaderSize = 24;    // エントリヘッダのサイズ.
+
+uint32_t g_FailCount = 0;   // 失敗した確認の数.
+
+//-----------------------------------------------------------------------------
+//      確認結果を表示します.
+//-----------------------------------------------------------------------------
+void Check(bool condition, const char* name)
+{
+    printf("[%s] %s\n", condition ? "PASS" : "FAIL", name);
+    if (!condition)
+    { g_FailCount++; }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// PipelineFixture structure
+///////////////////////////////////////////////////////////////////////////////
+//! @note       ハッシュ計算用のパイプラインステート設定一式です.
+//!             シェーダバイトコードは実体を持つためコピーしても別バッファになります.
+///////////////////////////////////////////////////////////////////////////////
+struct PipelineFixture
+{
+    std::vector<uint8_t>                VS;
+    std::vector<uint8_t>                PS;
+    D3D12_INPUT_ELEMENT_DESC            Elements[2];
+    D3D12_GRAPHICS_PIPELINE_STATE_DESC  Desc;
+
+    PipelineFixture()
+    : VS(64)
+    , PS(96)
+    {
+        for (size_t i = 0; i < VS.size(); ++i)
+        { VS[i] = uint8_t(i * 7 + 1); }
+        for (size_t i = 0; i < PS.size(); ++i)
+        { PS[i] = uint8_t(i * 13 + 5); }
+
+        Elements[0] = { "POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 0,  D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 };
+        Elements[1] = { "TEXCOORD", 0, DXGI_FORMAT_R32G32_FLOAT,    0, 12, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 };
+
+        Desc = {};
+        Desc.VS = { VS.data(), VS.size() };
+        Desc.PS = { PS.data(), PS.size() };
+        Desc.SampleMask = UINT_MAX;
+
+        for (auto i = 0u; i < D3D12_SIMULTANEOUS_RENDER_TARGET_COUNT; ++i)
+        {
+            auto& rt = Desc.BlendState.RenderTarget[i];
+            rt.BlendEnable           = false;
+            rt.LogicOpEnable         = false;
+            rt.SrcBlend              = D3D12_BLEND_ONE;
+            rt.DestBlend             = D3D12_BLEND_ZERO;
+            rt.BlendOp               = D3D12_BLEND_OP_ADD;
+            rt.SrcBlendAlpha         = D3D12_BLEND_ONE;
+            rt.DestBlendAlpha        = D3D12_BLEND_ZERO;
+            rt.BlendOpAlpha          = D3D12_BLEND_OP_ADD;
+            rt.LogicOp               = D3D12_LOGIC_OP_NOOP;
+            rt.RenderTargetWriteMask = D3D12_COLOR_WRITE_ENABLE_ALL;
+        }
+
+        Desc.RasterizerState.FillMode        = D3D12_FILL_MODE_SOLID;
+        Desc.RasterizerState.CullMode        = D3D12_CULL_MODE_BACK;
+        Desc.RasterizerState.DepthClipEnable = true;
+
+        auto& ds = Desc.DepthStencilState;
+        ds.DepthEnable      = true;
+        ds.DepthWriteMask   = D3D12_DEPTH_WRITE_MASK_ALL;
+        ds.DepthFunc        = D3D12_COMPARISON_FUNC_LESS;
+        ds.StencilEnable    = false;
+        ds.StencilReadMask  = D3D12_DEFAULT_STENCIL_READ_MASK;
+        ds.StencilWriteMask = D3D12_DEFAULT_STENCIL_WRITE_MASK;
+        ds.FrontFace        = { D3D12_STENCIL_OP_KEEP, D3D12_STENCIL_OP_KEEP, D3D12_STENCIL_OP_KEEP, D3D12_COMPARISON_FUNC_ALWAYS };
+        ds.BackFace         = ds.FrontFace;
+
+        Desc.InputLayout           = { Elements, 2 };
+        Desc.PrimitiveTopologyType = D3D12_PRIMITIVE_TOPOLOGY_TYPE_TRIANGLE;
+        Desc.NumRenderTargets      = 1;
+        Desc.RTVFormats[0]         = DXGI_FORMAT_R10G10B10A2_UNORM;
+        Desc.DSVFormat             = DXGI_FORMAT_D32_FLOAT;
+        Desc.SampleDesc.Count      = 1;
+    }
+
+    PipelineFixture(const PipelineFixture& value)
+    : VS        (value.VS)
+    , PS        (value.PS)
+    , Desc      (value.Desc)
+    {
+        Elements[0] = value.Elements[0];
+        Elements[1] = value.Elements[1];
+        Desc.VS = { VS.data(), VS.size() };
+        Desc.PS = { PS.data(), PS.size() };
+        Desc.InputLayout.pInputElementDescs = Elements;
+    }
+
+    PipelineFixture& operator = (const PipelineFixture&) = delete;
+
+    uint64_t Hash(uint64_t rootSigHash = 0x1234) const
+    { return HashGraphicsPipelineStateDesc(Desc, rootSigHash); }
+};
+
+//-----------------------------------------------------------------------------
+//      ハッシュ値が変化しない設定を確認します.
+//-----------------------------------------------------------------------------
+void TestHashInvariance()
+{
+    PipelineFixture base;
+    auto baseHash = base.Hash();
+
+    // 同じ内容を別バッファに持つ設定は同じハッシュ値になる.
+    {
+        PipelineFixture copy(base);
+        Check(copy.Desc.VS.pShaderBytecode != base.Desc.VS.pShaderBytecode && copy.Hash() == baseHash,
+            "hash depends on bytecode contents, not pointers");
+    }
+
+    // 未使用のレンダーターゲットフォーマット.
+    {
+        PipelineFixture test(base);
+        for (auto i = 1u; i < D3D12_SIMULTANEOUS_RENDER_TARGET_COUNT; ++i)
+        { test.Desc.RTVFormats[i] = DXGI_FORMAT_R16G16B16A16_FLOAT; }
+        Check(test.Hash() == baseHash, "unused RTV formats are ignored");
+    }
+
+    // 無効なブレンドの係数.
+    {
+        PipelineFixture test(base);
+        auto& rt = test.Desc.BlendState.RenderTarget[0];
+        rt.SrcBlend       = D3D12_BLEND_SRC_ALPHA;
+        rt.DestBlend      = D3D12_BLEND_INV_SRC_ALPHA;
+        rt.BlendOp        = D3D12_BLEND_OP_SUBTRACT;
+        rt.SrcBlendAlpha  = D3D12_BLEND_ZERO;
+        rt.DestBlendAlpha = D3D12_BLEND_ONE;
+        rt.BlendOpAlpha   = D3D12_BLEND_OP_SUBTRACT;
+        rt.LogicOp        = D3D12_LOGIC_OP_CLEAR;
+        Check(test.Hash() == baseHash, "disabled blend factors are ignored");
+    }
+
+    // 独立ブレンドでない場合の2番目以降のブレンド設定.
+    {
+        PipelineFixture test(base);
+        auto& rt = test.Desc.BlendState.RenderTarget[3];
+        rt.BlendEnable           = true;
+        rt.SrcBlend              = D3D12_BLEND_SRC_ALPHA;
+        rt.RenderTargetWriteMask = 0;
+        Check(test.Hash() == baseHash, "non-independent blend ignores RenderTarget[1..7]");
+    }
+
+    // ステンシル無効時のステンシル操作.
+    {
+        PipelineFixture test(base);
+        auto& ds = test.Desc.DepthStencilState;
+        ds.StencilReadMask  = 0x0f;
+        ds.StencilWriteMask = 0xf0;
+        ds.FrontFace        = { D3D12_STENCIL_OP_REPLACE, D3D12_STENCIL_OP_INCR, D3D12_STENCIL_OP_ZERO, D3D12_COMPARISON_FUNC_EQUAL };
+        ds.BackFace         = { D3D12_STENCIL_OP_ZERO, D3D12_STENCIL_OP_REPLACE, D3D12_STENCIL_OP_INCR, D3D12_COMPARISON_FUNC_NEVER };
+        Check(test.Hash() == baseHash, "stencil ops are ignored when stencil is off");
+    }
+
+    // 深度無効時の深度比較関数.
+    {
+        PipelineFixture a(base);
+        PipelineFixture b(base);
+        a.Desc.DepthStencilState.DepthEnable = false;
+        b.Desc.DepthStencilState.DepthEnable = false;
+        b.Desc.DepthStencilState.DepthFunc   = D3D12_COMPARISON_FUNC_ALWAYS;
+        b.Desc.DepthStencilState.DepthWriteMask = D3D12_DEPTH_WRITE_MASK_ZERO;
+        Check(a.Hash() == b.Hash(), "depth func/write mask are ignored when depth is off");
+    }
+
+    // ルートシグニチャのポインタとキャッシュ済みブロブ.
+    {
+        PipelineFixture test(base);
+        static uint8_t blob[16] = {};
+        test.Desc.pRootSignature = reinterpret_cast<ID3D12RootSignature*>(blob);
+        test.Desc.CachedPSO      = { blob, sizeof(blob) };
+        Check(test.Hash() == baseHash, "pRootSignature and CachedPSO are ignored");
+    }
+}
+
+//-----------------------------------------------------------------------------
+//      ハッシュ値が変化する設定を確認します.
+//-----------------------------------------------------------------------------
+void TestHashSensitivity()
+{
+    PipelineFixture base;
+    auto baseHash = base.Hash();
+
+    {
+        PipelineFixture test(base);
+        test.VS[17] ^= 0x01;
+        Check(test.Hash() != baseHash, "hash changes when VS bytecode changes");
+    }
+
+    {
+        PipelineFixture test(base);
+        test.PS.push_back(0);
+        test.Desc.PS = { test.PS.data(), test.PS.size() };
+        Check(test.Hash() != baseHash, "hash changes when PS bytecode length changes");
+    }
+
+    Check(base.Hash(0x1235) != baseHash, "hash changes when root signature hash changes");
+
+    {
+        PipelineFixture test(base);
+        test.Desc.RTVFormats[0] = DXGI_FORMAT_R8G8B8A8_UNORM;
+        Check(test.Hash() != baseHash, "hash changes when a used RTV format changes");
+    }
+
+    {
+        PipelineFixture a(base);
+        PipelineFixture b(base);
+        a.Desc.BlendState.RenderTarget[0].BlendEnable = true;
+        b.Desc.BlendState.RenderTarget[0].BlendEnable = true;
+        b.Desc.BlendState.RenderTarget[0].SrcBlend    = D3D12_BLEND_SRC_ALPHA;
+        Check(a.Hash() != b.Hash(), "hash changes with blend factors when blend is on");
+    }
+
+    {
+        PipelineFixture a(base);
+        PipelineFixture b(base);
+        a.Desc.DepthStencilState.StencilEnable = true;
+        b.Desc.DepthStencilState.StencilEnable = true;
+        b.Desc.DepthStencilState.FrontFace.StencilPassOp = D3D12_STENCIL_OP_REPLACE;
+        Check(a.Hash() != b.Hash(), "hash changes with stencil ops when stencil is on");
+    }
+
+    // ルートシグニチャ設定.
+    D3D12_DESCRIPTOR_RANGE range = { D3D12_DESCRIPTOR_RANGE_TYPE_SRV, 1, 0, 0, 0 };
+
+    D3D12_ROOT_PARAMETER params[2] = {};
+    params[0].ParameterType             = D3D12_ROOT_PARAMETER_TYPE_CBV;
+    params[0].Descriptor                = { 0, 0 };
+    params[0].ShaderVisibility          = D3D12_SHADER_VISIBILITY_VERTEX;
+    params[1].ParameterType             = D3D12_ROOT_PARAMETER_TYPE_DESCRIPTOR_TABLE;
+    params[1].DescriptorTable           = { 1, &range };
+    params[1].ShaderVisibility          = D3D12_SHADER_VISIBILITY_PIXEL;
+
+    D3D12_STATIC_SAMPLER_DESC sampler = {};
+    sampler.Filter           = D3D12_FILTER_MIN_MAG_MIP_LINEAR;
+    sampler.AddressU         = D3D12_TEXTURE_ADDRESS_MODE_WRAP;
+    sampler.AddressV         = D3D12_TEXTURE_ADDRESS_MODE_WRAP;
+    sampler.AddressW         = D3D12_TEXTURE_ADDRESS_MODE_WRAP;
+    sampler.MaxLOD           = 1000.0f;
+    sampler.ShaderVisibility = D3D12_SHADER_VISIBILITY_PIXEL;
+
+    D3D12_ROOT_SIGNATURE_DESC rootSig = { 2, params, 1, &sampler, D3D12_ROOT_SIGNATURE_FLAG_ALLOW_INPUT_ASSEMBLER_INPUT_LAYOUT };
+    auto rootSigHash = HashRootSignatureDesc(rootSig);
+
+    range.BaseShaderRegister = 1;
+    auto rangeHash = HashRootSignatureDesc(rootSig);
+    range.BaseShaderRegister = 0;
+
+    params[0].Descriptor.ShaderRegister = 2;
+    auto paramHash = HashRootSignatureDesc(rootSig);
+    params[0].Descriptor.ShaderRegister = 0;
+
+    sampler.AddressU = D3D12_TEXTURE_ADDRESS_MODE_CLAMP;
+    auto samplerHash = HashRootSignatureDesc(rootSig);
+    sampler.AddressU = D3D12_TEXTURE_ADDRESS_MODE_WRAP;
+
+    Check(HashRootSignatureDesc(rootSig) == rootSigHash, "root signature hash is stable");
+    Check(rangeHash   != rootSigHash, "root signature hash changes with a descriptor range");
+    Check(paramHash   != rootSigHash, "root signature hash changes with a root descriptor");
+    Check(samplerHash != rootSigHash, "root signature hash changes with a static sampler");
+    Check(base.Hash(rootSigHash) != base.Hash(rangeHash), "PSO hash follows the root signature hash");
+
+    // コンピュート.
+    std::vector<uint8_t> cs(32, 0xab);
+    D3D12_COMPUTE_PIPELINE_STATE_DESC compute = {};
+    compute.CS = { cs.data(), cs.size() };
+    auto computeHash = HashComputePipelineStateDesc(compute, rootSigHash);
+    cs[31] = 0xac;
+    Check(HashComputePipelineStateDesc(compute, rootSigHash) != computeHash, "hash changes when CS bytecode changes");
+    Check(HashComputePipelineStateDesc(compute, rangeHash)   != HashComputePipelineStateDesc(compute, rootSigHash),
+        "compute hash changes when root signature hash changes");
+}
+
+//-----------------------------------------------------------------------------
+//      ファイルを読み込みます.
+//-----------------------------------------------------------------------------
+std::vector<uint8_t> ReadFile(const std::filesystem::path& path)
+{
+    std::ifstream stream(path, std::ios::binary);
+    return std::vector<uint8_t>(std::istreambuf_iterator<char>(stream), std::istreambuf_iterator<char>());
+}
+
+//-----------------------------------------------------------------------------
+//      ファイルに書き出します.
+//-----------------------------------------------------------------------------
+void WriteFile(const std::filesystem::path& path, const std::vector<uint8_t>& data)
+{
+    std::ofstream stream(path, std::ios::binary | std::ios::trunc);
+    stream.write(reinterpret_cast<const char*>(data.data()), std::streamsize(data.size()));
+}
+
+//-----------------------------------------------------------------------------
+//      エントリの内容が一致するかチェックします.
+//-----------------------------------------------------------------------------
+bool IsSameEntry(const PipelineCacheFile& cache, uint64_t key, const std::vector<uint8_t>& expected)
+{
+    auto pData = cache.Find(key);
+    return (pData != nullptr) && (*pData == expected);
+}
+
+//-----------------------------------------------------------------------------
+//      キャッシュファイルの保存と読み込みを確認します.
+//-----------------------------------------------------------------------------
+void TestCacheFile(const std::filesystem::path& dir)
+{
+    std::vector<uint8_t> dataA(100);
+    std::vector<uint8_t> dataB(37);
+    std::vector<uint8_t> dataC(250);
+    for (size_t i = 0; i < dataA.size(); ++i) { dataA[i] = uint8_t(i); }
+    for (size_t i = 0; i < dataB.size(); ++i) { dataB[i] = uint8_t(0xff - i); }
+    for (size_t i = 0; i < dataC.size(); ++i) { dataC[i] = uint8_t(i * 31); }
+
+    auto path = dir / "pso_cache.bin";
+
+    // 登録順と異なるキー順で書き出されることも確認するため逆順に登録する.
+    PipelineCacheFile cache;
+    cache.Store(KeyC, dataC.data(), dataC.size());
+    cache.Store(KeyB, dataB.data(), dataB.size());
+    cache.Store(KeyA, dataA.data(), dataA.size());
+    Check(cache.IsDirty(), "store marks the cache dirty");
+    Check(cache.Save(path), "save succeeds");
+    Check(!cache.IsDirty(), "save clears the dirty flag");
+    Check(!std::filesystem::exists(dir / "pso_cache.bin.tmp"), "save leaves no temporary file");
+
+    auto image = ReadFile(path);
+    auto expectedSize = FileHeaderSize + 3 * EntryHeaderSize + dataA.size() + dataB.size() + dataC.size();
+    Check(image.size() == expectedSize, "file size matches header + entries");
+
+    // 往復.
+    {
+        PipelineCacheFile loaded;
+        auto result = loaded.Load(path);
+        Check(result && loaded.GetCount() == 3, "load restores every entry");
+        Check(IsSameEntry(loaded, KeyA, dataA) && IsSameEntry(loaded, KeyB, dataB) && IsSameEntry(loaded, KeyC, dataC),
+            "round-tripped entries are byte-identical");
+        Check(!loaded.IsDirty(), "clean load is not dirty");
+
+        auto copyPath = dir / "pso_cache_copy.bin";
+        loaded.Save(copyPath);
+        Check(ReadFile(copyPath) == image, "save output is deterministic");
+    }
+
+    // 末尾のエントリ(キー順で最後の KeyC)の途中で切れたファイル.
+    {
+        auto truncated = image;
+        truncated.resize(image.size() - dataC.size() / 2);
+        auto truncPath = dir / "pso_cache_trunc.bin";
+        WriteFile(truncPath, truncated);
+
+        PipelineCacheFile loaded;
+        auto result = loaded.Load(truncPath);
+        Check(result && loaded.GetCount() == 2, "truncated file keeps the complete entries");
+        Check(loaded.Find(KeyC) == nullptr, "truncated entry is dropped");
+        Check(IsSameEntry(loaded, KeyA, dataA) && IsSameEntry(loaded, KeyB, dataB), "entries before the cut are intact");
+        Check(loaded.IsDirty(), "truncated file marks the cache dirty");
+    }
+
+    // エントリヘッダの途中で切れたファイル.
+    {
+        auto truncated = image;
+        truncated.resize(FileHeaderSize + EntryHeaderSize + dataA.size() + EntryHeaderSize / 2);
+        auto truncPath = dir / "pso_cache_trunc_header.bin";
+        WriteFile(truncPath, truncated);
+
+        PipelineCacheFile loaded;
+        auto result = loaded.Load(truncPath);
+        Check(result && loaded.GetCount() == 1 && IsSameEntry(loaded, KeyA, dataA), "cut inside an entry header keeps earlier entries");
+    }
+
+    // チェックサムが一致しないエントリ(KeyB のデータを1バイト壊す).
+    {
+        auto corrupted = image;
+        auto offset = FileHeaderSize + EntryHeaderSize + dataA.size() + EntryHeaderSize + 10;
+        corrupted[offset] ^= 0x5a;
+        auto badPath = dir / "pso_cache_bad.bin";
+        WriteFile(badPath, corrupted);
+
+        PipelineCacheFile loaded;
+        auto result = loaded.Load(badPath);
+        Check(result && loaded.GetCount() == 2, "bad checksum entry is dropped");
+        Check(loaded.Find(KeyB) == nullptr, "corrupted key is not found");
+        Check(IsSameEntry(loaded, KeyA, dataA) && IsSameEntry(loaded, KeyC, dataC), "entries after a bad checksum still load");
+        Check(loaded.IsDirty(), "bad checksum marks the cache dirty");
+    }
+
+    // 異なるマジック, 存在しないファイル.
+    {
+        auto wrong = image;
+        wrong[0] ^= 0xff;
+        auto wrongPath = dir / "pso_cache_magic.bin";
+        WriteFile(wrongPath, wrong);
+
+        PipelineCacheFile loaded;
+        loaded.Store(KeyA, dataA.data(), dataA.size());
+        Check(!loaded.Load(wrongPath) && loaded.GetCount() == 0, "wrong magic is rejected and clears entries");
+        Check(!loaded.Load(dir / "missing.bin"), "missing file fails to load");
+    }
+}
+
+//-----------------------------------------------------------------------------
+//      使用方法を表示します.
+//-----------------------------------------------------------------------------
+void PrintUsage()
+{ printf("Usage : PipelineCacheTest\n"); }
+
+} // namespace
+
+
+//-----------------------------------------------------------------------------
+//      メインエントリーポイントです.
+//-----------------------------------------------------------------------------
+int main(int argc, char** argv)
+{
+    if (argc > 1)
+    {
+        PrintUsage();
+        return (strcmp(argv[1], "--help") == 0) ? 0 : -1;
+    }
+
+    auto dir = std::filesystem::temp_directory_path() / "PipelineCacheTest";
+    std::error_code ec;
+    std::filesystem::remove_all(dir, ec);
+    std::filesystem::create_directories(dir, ec);
+    if (ec)
+    {
+        fprintf(stderr, "Error : create directory failed. path = %s\n", dir.string().c_str());
+        return -1;
+    }
+
+    TestHashInvariance();
+    TestHashSensitivity();
+    TestCacheFile(dir);
+
+    std::filesystem::remove_all(dir, ec);
+
+    if (g_FailCount > 0)
+    {
+        fprintf(stderr, "Error : %u check(s) failed.\n", g_FailCount);
+        return -1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,462 @@
+﻿//-----------------------------------------------------------------------------
+// File : main.cpp
+// Desc : Profiler Chrome Trace Export Test Entry Point.
+// Copyright(c) Pocol. All right reserved.
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------
+#include "Profiler.h"
+#include "JsonParser.h"
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+
+namespace {
+
+//-----------------------------------------------------------------------------
+// Constant Values.
+//-----------------------------------------------------------------------------
+constexpr uint32_t      WorkerCount     = 3;                        // スコープを積むワーカースレッド数.
+constexpr uint32_t      CaptureFrames   = 3;                        // キャプチャするフレーム数.
+constexpr const char*   TracePath       = "ProfilerTest_trace.json";
+
+uint32_t g_FailCount = 0;   // 失敗した確認の数.
+
+//-----------------------------------------------------------------------------
+//      確認結果を表示します.
+//-----------------------------------------------------------------------------
+void Check(bool condition, const char* name)
+{
+    printf("[%s] %s\n", condition ? "PASS" : "FAIL", name);
+    if (!condition)
+    { g_FailCount++; }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// TraceEvent structure
+///////////////////////////////////////////////////////////////////////////////
+struct TraceEvent
+{
+    std::string     Name;       //!< 名前です.
+    std::string     Category;   //!< 分類です.
+    double          Ts;         //!< 開始時刻[us]です.
+    double          Dur;        //!< 時間[us]です.
+    uint32_t        Tid;        //!< トラック番号です.
+    uint32_t        Frame;      //!< フレーム番号です.
+    uint32_t        Depth;      //!< 入れ子の深さです.
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// Trace structure
+///////////////////////////////////////////////////////////////////////////////
+struct Trace
+{
+    bool                                Valid = false;  //!< 形式が正しいかどうか.
+    std::vector<TraceEvent>             Events;         //!< 完了イベント(ph = X)です.
+    std::map<uint32_t, std::string>     ThreadNames;    //!< トラック名です.
+};
+
+//-----------------------------------------------------------------------------
+//      数値のメンバーを取得します.
+//-----------------------------------------------------------------------------
+bool GetNumber(const JsonValue& object, const char* key, double& result)
+{
+    auto pValue = object.Find(key);
+    if (pValue == nullptr || pValue->Type != JSON_TYPE_NUMBER)
+    { return false; }
+
+    result = pValue->Number;
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+//      文字列のメンバーを取得します.
+//-----------------------------------------------------------------------------
+bool GetString(const JsonValue& object, const char* key, std::string& result)
+{
+    auto pValue = object.Find(key);
+    if (pValue == nullptr || pValue->Type != JSON_TYPE_STRING)
+    { return false; }
+
+    result = pValue->String;
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+//      Chrome Trace 形式の JSON を読み込み, 形式を検証します.
+//-----------------------------------------------------------------------------
+Trace ParseTrace(const std::string& json)
+{
+    Trace trace;
+
+    JsonValue root;
+    if (!JsonParser::Parse(json, root) || root.Type != JSON_TYPE_OBJECT)
+    { return trace; }
+
+    std::string unit;
+    auto pEvents = root.Find("traceEvents");
+    if (!GetString(root, "displayTimeUnit", unit) || unit != "ms" || pEvents == nullptr || pEvents->Type != JSON_TYPE_ARRAY)
+    { return trace; }
+
+    for (auto& e : pEvents->Array)
+    {
+        std::string name;
+        std::string ph;
+        double pid = 0.0;
+        double tid = 0.0;
+        auto pArgs = e.Find("args");
+        if (!GetString(e, "name", name) || !GetString(e, "ph", ph) || !GetNumber(e, "pid", pid) || !GetNumber(e, "tid", tid)
+         || pArgs == nullptr || pArgs->Type != JSON_TYPE_OBJECT)
+        { return trace; }
+
+        if (ph == "M")
+        {
+            std::string value;
+            double sortIndex = 0.0;
+            if (name == "thread_name" && GetString(*pArgs, "name", value))
+            { trace.ThreadNames[uint32_t(tid)] = value; }
+            else if (!(name == "thread_sort_index" && GetNumber(*pArgs, "sort_index", sortIndex)))
+            { return trace; }
+            continue;
+        }
+
+        TraceEvent event;
+        double frame = 0.0;
+        double depth = 0.0;
+        if (ph != "X" || !GetString(e, "cat", event.Category) || !GetNumber(e, "ts", event.Ts) || !GetNumber(e, "dur", event.Dur)
+         || !GetNumber(*pArgs, "frame", frame) || !GetNumber(*pArgs, "depth", depth))
+        { return trace; }
+
+        event.Name  = name;
+        event.Tid   = uint32_t(tid);
+        event.Frame = uint32_t(frame);
+        event.Depth = uint32_t(depth);
+        trace.Events.push_back(event);
+    }
+
+    trace.Valid = true;
+    return trace;
+}
+
+//-----------------------------------------------------------------------------
+//      指定した名前のイベントを数えます.
+//-----------------------------------------------------------------------------
+uint32_t CountEvents(const Trace& trace, const char* name)
+{
+    uint32_t result = 0;
+    for (auto& e : trace.Events)
+    {
+        if (e.Name == name)
+        { result++; }
+    }
+    return result;
+}
+
+//-----------------------------------------------------------------------------
+//      時刻が進むまで待ちます(入れ子の時刻が同じにならないように).
+//-----------------------------------------------------------------------------
+void Spin()
+{
+    auto begin = Profiler::GetTimeUs();
+    while (Profiler::GetTimeUs() - begin < 5.0)
+    { /* DO_NOTHING */ }
+}
+
+//-----------------------------------------------------------------------------
+//      1フレーム分のスコープを積みます.
+//-----------------------------------------------------------------------------
+void RecordFrame(Profiler& profiler)
+{
+    ProfileScope frame(profiler, "Frame");
+    Spin();
+    {
+        ProfileScope scene(profiler, "DrawScene");
+        Spin();
+        {
+            ProfileScope inner(profiler, "Culling");
+            Spin();
+        }
+        Spin();
+    }
+    {
+        ProfileScope present(profiler, "Present");
+        Spin();
+    }
+}
+
+//-----------------------------------------------------------------------------
+//      キャプチャの範囲と入れ子のテストです.
+//-----------------------------------------------------------------------------
+void TestCapture()
+{
+    Profiler profiler;
+
+    // キャプチャしていないフレームは集計だけする.
+    profiler.BeginFrame();
+    RecordFrame(profiler);
+    Check(profiler.GetEvents().empty(), "capture: no events before StartCapture");
+
+    profiler.StartCapture(CaptureFrames);
+    Check(profiler.IsCapturing() && !profiler.HasFinishedCapture(), "capture: capturing after StartCapture");
+
+    // GPUの時刻はバックエンド無しで模擬する(CPUのフレームの後に 100us ずつ遅れて走る).
+    for (auto f = 0u; f < CaptureFrames; ++f)
+    {
+        profiler.BeginFrame();
+        auto beginUs = Profiler::GetTimeUs();
+        RecordFrame(profiler);
+        profiler.AddGpuEvent("Scene",   beginUs + 100.0, beginUs + 300.0);
+        profiler.AddGpuEvent("Tonemap", beginUs + 300.0, beginUs + 350.0);
+        profiler.AddGpuEvent("Bad",     beginUs + 400.0, beginUs + 399.0);  // 終了が開始より前は捨てる.
+    }
+
+    profiler.BeginFrame();
+    Check(!profiler.IsCapturing() && profiler.HasFinishedCapture(), "capture: finished after frame count");
+
+    RecordFrame(profiler);
+    profiler.AddGpuEvent("Scene", 0.0, 1.0);
+
+    auto events = profiler.GetEvents();
+    Check(events.size() == CaptureFrames * 6, "capture: 4 CPU + 2 GPU events per captured frame only");
+
+    auto trace = ParseTrace(profiler.ExportChromeTrace());
+    Check(trace.Valid, "export: valid JSON with trace event schema");
+    Check(trace.Events.size() == events.size(), "export: one X event per captured event");
+    Check(CountEvents(trace, "Frame") == CaptureFrames && CountEvents(trace, "Culling") == CaptureFrames, "export: every CPU scope per frame");
+    Check(CountEvents(trace, "Scene") == CaptureFrames && CountEvents(trace, "Bad") == 0, "export: GPU events, inverted range dropped");
+
+    // 時刻は最初のイベントを0とし, 全て非負.
+    auto minTs       = 1e30;
+    auto nonNegative = true;
+    for (auto& e : trace.Events)
+    {
+        minTs       = std::min(minTs, e.Ts);
+        nonNegative = nonNegative && e.Ts >= 0.0 && e.Dur >= 0.0;
+    }
+    Check(nonNegative && std::fabs(minTs) < 1e-9, "export: timestamps rebased to the first event");
+
+    // トラックと分類.
+    auto tracksOk = true;
+    for (auto& e : trace.Events)
+    {
+        auto gpu = (e.Category == "gpu");
+        tracksOk = tracksOk && (gpu == (e.Tid == Profiler::GpuTrack)) && (e.Category == "gpu" || e.Category == "cpu");
+        tracksOk = tracksOk && trace.ThreadNames.count(e.Tid) != 0;
+    }
+    Check(tracksOk, "export: GPU on GpuTrack, every track named");
+    Check(trace.ThreadNames[uint32_t(Profiler::GpuTrack)] == "GPU" && trace.ThreadNames[0] == "CPU Thread 0", "export: track names");
+
+    // 入れ子は親の時間に収まり, 深さが1つ深い.
+    auto nestingOk = true;
+    auto frameOk   = true;
+    for (auto& child : trace.Events)
+    {
+        if (child.Tid == Profiler::GpuTrack)
+        { continue; }
+
+        frameOk = frameOk && child.Frame >= 2 && child.Frame < 2 + CaptureFrames;
+        if (child.Depth == 0)
+        { continue; }
+
+        auto found = false;
+        for (auto& parent : trace.Events)
+        {
+            if (parent.Tid == child.Tid && parent.Frame == child.Frame && parent.Depth + 1 == child.Depth
+             && parent.Ts <= child.Ts + 1e-3 && child.Ts + child.Dur <= parent.Ts + parent.Dur + 1e-3)
+            {
+                found = true;
+                break;
+            }
+        }
+        nestingOk = nestingOk && found;
+    }
+    Check(nestingOk, "export: nested scopes inside their parent, depth + 1");
+    Check(frameOk, "export: frame numbers of the captured frames");
+
+    // GPUの時間はそのまま出力される.
+    auto gpuDurOk = true;
+    for (auto& e : trace.Events)
+    {
+        if (e.Name == "Scene")
+        { gpuDurOk = gpuDurOk && std::fabs(e.Dur - 200.0) < 1e-2; }
+        if (e.Name == "Tonemap")
+        { gpuDurOk = gpuDurOk && std::fabs(e.Dur - 50.0) < 1e-2; }
+    }
+    Check(gpuDurOk, "export: GPU durations preserved");
+
+    // 集計はキャプチャ外のフレームも含む.
+    auto report = profiler.FormatReport();
+    char calls[32];
+    snprintf(calls, sizeof(calls), "(%u calls)", CaptureFrames + 2);
+    Check(report.find("DrawScene") != std::string::npos && report.find(calls) != std::string::npos, "report: stats include uncaptured frames");
+
+    // ファイル出力は同じ内容.
+    auto written = profiler.WriteChromeTrace(TracePath);
+    std::ifstream stream(TracePath, std::ios::binary);
+    std::stringstream content;
+    content << stream.rdbuf();
+    Check(written && content.str() == profiler.ExportChromeTrace(), "export: WriteChromeTrace matches ExportChromeTrace");
+    stream.close();
+    remove(TracePath);
+
+    Check(!profiler.WriteChromeTrace(nullptr), "export: null path rejected");
+
+    profiler.ClearCapture();
+    Check(profiler.GetEvents().empty() && !profiler.HasFinishedCapture(), "capture: ClearCapture drops events");
+    Check(ParseTrace(profiler.ExportChromeTrace()).Valid, "export: empty capture is valid JSON");
+}
+
+//-----------------------------------------------------------------------------
+//      スコープの閉じ方のテストです.
+//-----------------------------------------------------------------------------
+void TestScopes()
+{
+    Profiler profiler;
+    profiler.StartCapture(1);
+    profiler.BeginFrame();
+
+    // 内側を閉じ忘れても外側で閉じる.
+    auto outer = profiler.BeginScope("Outer");
+    profiler.BeginScope("Leaked");
+    Spin();
+    profiler.EndScope(outer);
+    profiler.EndScope(Profiler::InvalidScope);
+    profiler.EndScope(5);
+
+    // 閉じた後は同じ深さから始まる.
+    auto next = profiler.BeginScope("Next");
+    profiler.EndScope(next);
+
+    auto events = profiler.GetEvents();
+    Check(events.size() == 2, "scope: leaked inner scope closed with its parent, invalid scopes ignored");
+    Check(next == 0 && events.size() == 2 && events[1].Name == "Next" && events[1].Depth == 0, "scope: depth restarts after unwinding");
+}
+
+//-----------------------------------------------------------------------------
+//      名前のエスケープのテストです.
+//-----------------------------------------------------------------------------
+void TestEscaping()
+{
+    const char* names[] = {
+        "Quote \"A\"",
+        "Back\\slash",
+        "Line\nBreak\tTab",
+        "Ctrl\x01\x1f",
+        "UTF-8 \xe5\xbd\xb1",
+    };
+
+    Profiler profiler;
+    profiler.StartCapture(1);
+    profiler.BeginFrame();
+    for (auto name : names)
+    {
+        auto scope = profiler.BeginScope(name);
+        profiler.EndScope(scope);
+    }
+
+    auto trace = ParseTrace(profiler.ExportChromeTrace());
+    auto ok = trace.Valid && trace.Events.size() == sizeof(names) / sizeof(names[0]);
+    for (size_t i = 0; ok && i < trace.Events.size(); ++i)
+    { ok = (trace.Events[i].Name == names[i]); }
+    Check(ok, "export: names with quotes, backslashes and control characters round-trip");
+}
+
+//-----------------------------------------------------------------------------
+//      複数スレッドのテストです.
+//-----------------------------------------------------------------------------
+void TestThreads()
+{
+    Profiler profiler;
+    profiler.StartCapture(1);
+    profiler.BeginFrame();
+
+    {
+        ProfileScope scope(profiler, "Main");
+        Spin();
+    }
+
+    std::vector<std::thread> threads;
+    for (auto t = 0u; t < WorkerCount; ++t)
+    {
+        threads.emplace_back([&profiler]()
+        {
+            for (auto i = 0; i < 100; ++i)
+            { RecordFrame(profiler); }
+        });
+    }
+
+    for (auto& thread : threads)
+    { thread.join(); }
+
+    auto trace = ParseTrace(profiler.ExportChromeTrace());
+
+    // メインスレッドは最初に記録したので0番.
+    std::map<uint32_t, uint32_t> perTrack;
+    for (auto& e : trace.Events)
+    { perTrack[e.Tid]++; }
+
+    auto ok = trace.Valid && perTrack.size() == WorkerCount + 1 && perTrack[0] == 1;
+    for (auto t = 1u; ok && t <= WorkerCount; ++t)
+    { ok = (perTrack[t] == 400) && trace.ThreadNames.count(t) != 0; }
+    Check(ok, "threads: one track per thread, no lost events");
+}
+
+//-----------------------------------------------------------------------------
+//      記録数の上限のテストです.
+//-----------------------------------------------------------------------------
+void TestEventLimit()
+{
+    Profiler profiler;
+    profiler.StartCapture(1);
+    profiler.BeginFrame();
+
+    for (size_t i = 0; i < Profiler::MaxCaptureEvents + 10; ++i)
+    { profiler.AddGpuEvent("E", double(i), double(i) + 1.0); }
+
+    Check(profiler.GetEvents().size() == Profiler::MaxCaptureEvents, "capture: stops at MaxCaptureEvents");
+}
+
+//-----------------------------------------------------------------------------
+//      使い方を表示します.
+//-----------------------------------------------------------------------------
+void PrintUsage()
+{ printf("Usage : ProfilerTest\n"); }
+
+} // namespace
+
+
+//-----------------------------------------------------------------------------
+//      メインエントリーポイントです.
+//-----------------------------------------------------------------------------
+int main(int argc, char** argv)
+{
+    if (argc > 1)
+    {
+        PrintUsage();
+        return (strcmp(argv[1], "--help") == 0) ? 0 : -1;
+    }
+
+    TestCapture();
+    TestScopes();
+    TestEscaping();
+    TestThreads();
+    TestEventLimit();
+
+    if (g_FailCount > 0)
+    {
+        fprintf(stderr, "Error : %u check(s) failed.\n", g_FailCount);
+        return -1;
+    }
+
+    return 0;
+}
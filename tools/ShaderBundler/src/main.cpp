@@ -0,0 +1,118 @@
+﻿//-----------------------------------------------------------------------------
+// File : main.cpp
+// Desc : Shader Bundler Entry Point.
+// Copyright(c) Pocol. All right reserved.
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------
+#include <ShaderBundle.h>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+
+
+namespace {
+
+//-----------------------------------------------------------------------------
+//      使用方法を表示します.
+//-----------------------------------------------------------------------------
+void PrintUsage()
+{
+    printf("Usage : ShaderBundler <shader_bin dir> <output file>\n");
+    printf("  bundles every *.cso in the directory into one indexed file.\n");
+}
+
+//-----------------------------------------------------------------------------
+//      ファイルを読み込みます.
+//-----------------------------------------------------------------------------
+bool ReadFile(const std::filesystem::path& path, std::vector<uint8_t>& result)
+{
+    std::ifstream stream(path, std::ios::binary);
+    if (!stream.is_open())
+    { return false; }
+
+    result.assign(
+        (std::istreambuf_iterator<char>(stream)),
+        std::istreambuf_iterator<char>());
+    return !stream.bad();
+}
+
+} // namespace
+
+
+//-----------------------------------------------------------------------------
+//      メインエントリーポイントです.
+//-----------------------------------------------------------------------------
+int main(int argc, char** argv)
+{
+    if (argc < 3)
+    {
+        PrintUsage();
+        return -1;
+    }
+
+    std::filesystem::path inputDir  = argv[1];
+    std::filesystem::path outputPath = argv[2];
+
+    std::error_code ec;
+    if (!std::filesystem::is_directory(inputDir, ec))
+    {
+        fprintf(stderr, "Error : Directory Not Found. path = %s\n", argv[1]);
+        return -1;
+    }
+
+    // コンパイル済みシェーダを収集.
+    std::vector<ShaderBundle::Source> sources;
+    for (auto& item : std::filesystem::directory_iterator(inputDir, ec))
+    {
+        if (!item.is_regular_file() || item.path().extension() != ".cso")
+        { continue; }
+
+        ShaderBundle::Source source;
+        source.Name = item.path().filename().string();
+        if (!ReadFile(item.path(), source.Data))
+        {
+            fprintf(stderr, "Error : ReadFile() Failed. path = %s\n", item.path().string().c_str());
+            return -1;
+        }
+
+        sources.push_back(std::move(source));
+    }
+
+    if (ec)
+    {
+        fprintf(stderr, "Error : Directory Enumeration Failed. path = %s\n", argv[1]);
+        return -1;
+    }
+
+    if (!ShaderBundle::Write(outputPath, sources))
+    {
+        fprintf(stderr, "Error : ShaderBundle::Write() Failed. path = %s\n", argv[2]);
+        return -1;
+    }
+
+    // 書き出した結果を検証.
+    ShaderBundle bundle;
+    if (!bundle.Open(outputPath) || !bundle.Verify() || bundle.GetCount() != sources.size())
+    {
+        fprintf(stderr, "Error : ShaderBundle Verification Failed. path = %s\n", argv[2]);
+        return -1;
+    }
+
+    size_t totalSize = 0;
+    for (auto& source : sources)
+    {
+        ShaderBundle::Blob blob = {};
+        if (!bundle.Find(source.Name.c_str(), blob) || blob.Size != source.Data.size())
+        {
+            fprintf(stderr, "Error : ShaderBundle Lookup Failed. name = %s\n", source.Name.c_str());
+            return -1;
+        }
+        totalSize += blob.Size;
+    }
+
+    printf("Bundled %zu shaders (%zu bytes) -> %s\n", sources.size(), totalSize, argv[2]);
+    return 0;
+}
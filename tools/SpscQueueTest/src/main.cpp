@@ -0,0 +1,290 @@
+﻿//-----------------------------------------------------------------------------
+// File : main.cpp
+// Desc : Single-Producer Single-Consumer Queue Test Entry Point.
+// Copyright(c) Pocol. All right reserved.
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------
+#include "SpscQueue.h"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+
+
+namespace {
+
+//-----------------------------------------------------------------------------
+// Constant Values.
+//-----------------------------------------------------------------------------
+constexpr uint64_t      DefaultCount    = 4000000;          // 既定の受け渡す記録の数.
+constexpr uint32_t      HandOffFrames   = 200;              // 受け渡しの模擬で取り出す回数(フレーム数).
+
+uint32_t g_FailCount = 0;   // 失敗した確認の数.
+
+//-----------------------------------------------------------------------------
+//      確認結果を表示します.
+//-----------------------------------------------------------------------------
+void Check(bool condition, const char* name)
+{
+    printf("[%s] %s\n", condition ? "PASS" : "FAIL", name);
+    if (!condition)
+    { g_FailCount++; }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Record structure
+///////////////////////////////////////////////////////////////////////////////
+//! @note       SampleApp::InputRecord と同程度の大きさの記録です.
+///////////////////////////////////////////////////////////////////////////////
+struct Record
+{
+    uint64_t    Seq;        //!< 通し番号です(1から).
+    uint32_t    Type;       //!< 種類です.
+    float       Value[4];   //!< 値です(通し番号から決まる).
+    uint32_t    Check;      //!< 内容の検査値です.
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// Timer class
+///////////////////////////////////////////////////////////////////////////////
+class Timer
+{
+public:
+    Timer()
+    : m_Begin(std::chrono::steady_clock::now())
+    { /* DO_NOTHING */ }
+
+    double GetElapsedMs() const
+    { return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - m_Begin).count(); }
+
+private:
+    std::chrono::steady_clock::time_point m_Begin;
+};
+
+//-----------------------------------------------------------------------------
+//      通し番号から記録を作ります.
+//-----------------------------------------------------------------------------
+Record MakeRecord(uint64_t seq)
+{
+    Record record = {};
+    record.Seq   = seq;
+    record.Type  = uint32_t(seq % 3);
+    for (auto i = 0; i < 4; ++i)
+    { record.Value[i] = float(seq % 1024) + float(i); }
+    record.Check = uint32_t(seq * 2654435761u) ^ record.Type;
+    return record;
+}
+
+//-----------------------------------------------------------------------------
+//      記録が通し番号どおりの内容かどうかチェックします(書きかけを読んでいないか).
+//-----------------------------------------------------------------------------
+bool IsIntact(const Record& record, uint64_t seq)
+{
+    auto expected = MakeRecord(seq);
+    return memcmp(&record, &expected, sizeof(Record)) == 0;
+}
+
+//-----------------------------------------------------------------------------
+//      満杯と空の境界のテストです.
+//-----------------------------------------------------------------------------
+template<uint32_t Size>
+void TestBoundaries(const char* name)
+{
+    SpscQueue<Record, Size> queue;
+    Record record = {};
+    char label[128];
+
+    auto ok = !queue.TryPop(record) && queue.GetCount() == 0;
+
+    // 何周かして添字の折り返しを通す.
+    uint64_t seq = 1;
+    for (auto round = 0u; round < 5; ++round)
+    {
+        for (auto i = 0u; i < Size; ++i)
+        { ok = ok && queue.TryPush(MakeRecord(seq + i)); }
+
+        ok = ok && queue.GetCount() == Size && !queue.TryPush(MakeRecord(0)) && queue.GetCount() == Size;
+
+        // 1つ空ければ1つだけ積める.
+        ok = ok && queue.TryPop(record) && IsIntact(record, seq);
+        ok = ok && queue.TryPush(MakeRecord(seq + Size)) && !queue.TryPush(MakeRecord(0));
+
+        for (auto i = 1u; i <= Size; ++i)
+        { ok = ok && queue.TryPop(record) && IsIntact(record, seq + i); }
+
+        ok = ok && !queue.TryPop(record) && queue.GetCount() == 0;
+        seq += Size + 1;
+    }
+
+    snprintf(label, sizeof(label), "bounds(%s): full rejects, empty fails, FIFO across wrap", name);
+    Check(ok && SpscQueue<Record, Size>::Capacity == Size, label);
+}
+
+//-----------------------------------------------------------------------------
+//      2スレッドでの順序と欠落のテストです.
+//-----------------------------------------------------------------------------
+void TestOrdering(uint64_t count)
+{
+    // 小さいキューで満杯と空を頻繁に起こす.
+    static SpscQueue<Record, 64> queue;
+
+    Timer timer;
+
+    std::thread producer([&]()
+    {
+        for (auto seq = uint64_t(1); seq <= count; ++seq)
+        {
+            auto record = MakeRecord(seq);
+            while (!queue.TryPush(record))
+            { std::this_thread::yield(); }
+        }
+    });
+
+    uint64_t received = 0;
+    uint64_t broken   = 0;
+    uint32_t observed = 0;
+    Record   record;
+    while (received < count)
+    {
+        auto n = queue.GetCount();
+        observed = (n > observed) ? n : observed;
+
+        if (!queue.TryPop(record))
+        {
+            std::this_thread::yield();
+            continue;
+        }
+
+        received++;
+        if (!IsIntact(record, received))
+        { broken++; }
+    }
+
+    producer.join();
+    auto elapsedMs = timer.GetElapsedMs();
+
+    printf("    %llu records in %.1f ms (%.1f M records/s), max observed count %u\n",
+        static_cast<unsigned long long>(count), elapsedMs, double(count) / (elapsedMs * 1000.0), observed);
+
+    Check(broken == 0, "ordering: every record arrives intact and in order");
+    Check(!queue.TryPop(record) && queue.GetCount() == 0, "ordering: nothing extra left after the last record");
+    Check(observed <= 64, "ordering: GetCount never exceeds Capacity while both sides run");
+}
+
+//-----------------------------------------------------------------------------
+//      メッセージ処理から描画への受け渡しを模擬したテストです.
+//-----------------------------------------------------------------------------
+void TestHandOff()
+{
+    // SampleApp と同じく, 積む側は待たずに捨て, 取り出す側はフレームの先頭でまとめて取り出す.
+    static SpscQueue<Record, 256> queue;
+
+    std::atomic<bool>     stop(false);
+    std::atomic<uint64_t> pushed(0);
+    std::atomic<uint64_t> dropped(0);
+    std::atomic<uint64_t> attempts(0);
+
+    std::thread producer([&]()
+    {
+        uint64_t seq = 0;
+        while (!stop.load())
+        {
+            ++seq;
+            if (queue.TryPush(MakeRecord(seq)))
+            { pushed.fetch_add(1, std::memory_order_relaxed); }
+            else
+            { dropped.fetch_add(1, std::memory_order_relaxed); }
+        }
+        attempts = seq;
+    });
+
+    uint64_t received = 0;
+    uint64_t last     = 0;
+    auto     ok       = true;
+    Record   record;
+    auto drain = [&]()
+    {
+        while (queue.TryPop(record))
+        {
+            ok = ok && record.Seq > last && IsIntact(record, record.Seq);
+            last = record.Seq;
+            received++;
+        }
+    };
+
+    for (auto frame = 0u; frame < HandOffFrames; ++frame)
+    {
+        drain();
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    stop = true;
+    producer.join();
+    drain();
+
+    printf("    pushed %llu, dropped %llu, received %llu\n",
+        static_cast<unsigned long long>(pushed.load()),
+        static_cast<unsigned long long>(dropped.load()),
+        static_cast<unsigned long long>(received));
+
+    Check(ok, "hand-off: drained records keep their order and contents");
+    Check(received == pushed.load() && pushed.load() + dropped.load() == attempts.load(),
+        "hand-off: every accepted record is received, rejected ones are only counted");
+}
+
+//-----------------------------------------------------------------------------
+//      使い方を表示します.
+//-----------------------------------------------------------------------------
+void PrintUsage()
+{
+    printf("Usage : SpscQueueTest [options]\n");
+    printf("    --count <n>         records passed between the two threads (default %llu)\n",
+        static_cast<unsigned long long>(DefaultCount));
+}
+
+} // namespace
+
+
+//-----------------------------------------------------------------------------
+//      メインエントリーポイントです.
+//-----------------------------------------------------------------------------
+int main(int argc, char** argv)
+{
+    auto count = DefaultCount;
+
+    for (auto i = 1; i < argc; ++i)
+    {
+        if (strcmp(argv[i], "--count") == 0 && i + 1 < argc)
+        { count = strtoull(argv[++i], nullptr, 10); }
+        else
+        {
+            PrintUsage();
+            return (strcmp(argv[i], "--help") == 0) ? 0 : -1;
+        }
+    }
+
+    if (count == 0)
+    {
+        PrintUsage();
+        return -1;
+    }
+
+    TestBoundaries<2>  ("2");
+    TestBoundaries<256>("256");
+    TestOrdering(count);
+    TestHandOff();
+
+    if (g_FailCount > 0)
+    {
+        fprintf(stderr, "Error : %u check(s) failed.\n", g_FailCount);
+        return -1;
+    }
+
+    return 0;
+}
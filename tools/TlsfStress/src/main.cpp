@@ -0,0 +1,387 @@
+﻿//-----------------------------------------------------------------------------
+// File : main.cpp
+// Desc : TLSF Allocator Random Stress Test Entry Point.
+// Copyright(c) Pocol. All right reserved.
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------
+#include "TlsfAllocator.h"
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <random>
+#include <vector>
+
+
+namespace {
+
+//-----------------------------------------------------------------------------
+// Constant Values.
+//-----------------------------------------------------------------------------
+constexpr uint32_t  DefaultOps          = 200000;           // 既定の操作回数.
+constexpr uint32_t  DefaultSeed         = 1;                // 既定の乱数の種.
+constexpr uint32_t  DefaultValidate     = 1;                // 既定の Validate() の間隔.
+constexpr uint64_t  Capacity            = 256ull << 20;     // ヒープの容量(GPUヒープ相当).
+constexpr uint64_t  Granularity         = 256;              // 確保の最小単位(定数バッファ相当).
+constexpr uint32_t  MaxAlignmentShift   = 22;               // 最大アライメントの log2 (4MB, MSAAテクスチャ相当).
+
+///////////////////////////////////////////////////////////////////////////////
+// Shadow class
+///////////////////////////////////////////////////////////////////////////////
+//! @note       確保中の領域を別に控えて, 重なりとアライメントを確かめます.
+///////////////////////////////////////////////////////////////////////////////
+class Shadow
+{
+public:
+    //-------------------------------------------------------------------------
+    //! @brief      確保した領域を追加します.
+    //!
+    //! @return     範囲外, アライメント違反, 他の領域との重なりがあれば false を返却します.
+    //-------------------------------------------------------------------------
+    bool Add(const TlsfAllocator::Allocation& allocation, uint64_t size, uint64_t alignment, const char** ppReason)
+    {
+        auto begin = allocation.Offset;
+        auto end   = allocation.Offset + allocation.Size;
+
+        if (allocation.Size < size || allocation.Size % Granularity != 0)
+        { *ppReason = "size not rounded to granularity"; return false; }
+
+        if (begin % alignment != 0)
+        { *ppReason = "misaligned offset"; return false; }
+
+        if (end > Capacity)
+        { *ppReason = "allocation outside capacity"; return false; }
+
+        auto next = m_Ranges.lower_bound(begin);
+        if (next != m_Ranges.end() && next->first < end)
+        { *ppReason = "overlaps next allocation"; return false; }
+
+        if (next != m_Ranges.begin())
+        {
+            auto prev = std::prev(next);
+            if (prev->second > begin)
+            { *ppReason = "overlaps previous allocation"; return false; }
+        }
+
+        m_Ranges.emplace(begin, end);
+        m_UsedBytes += allocation.Size;
+        return true;
+    }
+
+    //-------------------------------------------------------------------------
+    //! @brief      解放した領域を削除します.
+    //-------------------------------------------------------------------------
+    void Remove(const TlsfAllocator::Allocation& allocation)
+    {
+        m_Ranges.erase(allocation.Offset);
+        m_UsedBytes -= allocation.Size;
+    }
+
+    //-------------------------------------------------------------------------
+    //! @brief      統計が控えと一致するか確かめます.
+    //-------------------------------------------------------------------------
+    bool Match(const TlsfAllocator& allocator, const char** ppReason) const
+    {
+        auto stats = allocator.GetStats();
+        if (stats.AllocationCount != m_Ranges.size())
+        { *ppReason = "allocation count mismatch"; return false; }
+
+        if (stats.UsedBytes != m_UsedBytes)
+        { *ppReason = "used bytes mismatch"; return false; }
+
+        if (stats.UsedBytes + stats.FreeBytes != stats.Capacity)
+        { *ppReason = "used + free != capacity"; return false; }
+
+        if (stats.LargestFreeBlock > stats.FreeBytes)
+        { *ppReason = "largest free block exceeds free bytes"; return false; }
+
+        return true;
+    }
+
+private:
+    std::map<uint64_t, uint64_t>    m_Ranges;           // 開始位置から終了位置への索引.
+    uint64_t                        m_UsedBytes = 0;    // 確保中のサイズの合計.
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// Result structure
+///////////////////////////////////////////////////////////////////////////////
+struct Result
+{
+    uint32_t    Allocs;         //!< 成功した確保の数です.
+    uint32_t    Failures;       //!< 失敗した確保の数です.
+    uint32_t    Frees;          //!< 解放の数です.
+    uint32_t    PeakCount;      //!< 最大の確保中ブロック数です.
+    float       MaxFragmentation;   //!< 最大の断片化率です.
+};
+
+//-----------------------------------------------------------------------------
+//      確保するサイズを選びます(小さいものほど多い対数一様分布).
+//-----------------------------------------------------------------------------
+uint64_t PickSize(std::mt19937_64& rng)
+{
+    auto shift = 4 + rng() % 21;    // 16B ～ 16MB.
+    auto base  = 1ull << shift;
+    return base + rng() % base;
+}
+
+//-----------------------------------------------------------------------------
+//      アライメントを選びます.
+//-----------------------------------------------------------------------------
+uint64_t PickAlignment(std::mt19937_64& rng)
+{
+    // 多くは既定のアライメント, 一部は 64KB (リソース配置) と 4MB (MSAA).
+    switch (rng() % 8)
+    {
+    case 0:  return 1ull << (rng() % (MaxAlignmentShift + 1));
+    case 1:  return 64ull << 10;
+    case 2:  return 4ull << 20;
+    default: return Granularity;
+    }
+}
+
+//-----------------------------------------------------------------------------
+//      乱数で確保と解放を繰り返します.
+//-----------------------------------------------------------------------------
+bool RunRandom(uint32_t ops, uint32_t seed, uint32_t validateInterval, Result& result)
+{
+    TlsfAllocator allocator;
+    if (!allocator.Init(Capacity, Granularity))
+    {
+        fprintf(stderr, "Error : TlsfAllocator::Init() Failed.\n");
+        return false;
+    }
+
+    std::mt19937_64 rng(seed);
+    std::vector<TlsfAllocator::Allocation> live;
+    Shadow shadow;
+    const char* reason = "";
+
+    result = {};
+
+    for (auto op = 0u; op < ops; ++op)
+    {
+        // 確保と解放の比率を周期的に変えて, 満杯に近い状態と空に近い状態を行き来する.
+        auto phase     = (op / 20000) % 4;
+        auto allocRate = (phase == 0) ? 75u : (phase == 2) ? 30u : 52u;
+
+        if (live.empty() || rng() % 100 < allocRate)
+        {
+            auto size      = PickSize(rng);
+            auto alignment = PickAlignment(rng);
+
+            TlsfAllocator::Allocation allocation;
+            if (allocator.Alloc(size, alignment, allocation))
+            {
+                if (!shadow.Add(allocation, size, alignment, &reason))
+                {
+                    fprintf(stderr, "Error : op %u : %s. offset = %llu, size = %llu, alignment = %llu\n",
+                        op, reason,
+                        static_cast<unsigned long long>(allocation.Offset),
+                        static_cast<unsigned long long>(allocation.Size),
+                        static_cast<unsigned long long>(alignment));
+                    return false;
+                }
+
+                live.push_back(allocation);
+                result.Allocs++;
+            }
+            else
+            {
+                result.Failures++;
+            }
+        }
+        else
+        {
+            auto index = size_t(rng() % live.size());
+            allocator.Free(live[index]);
+            shadow.Remove(live[index]);
+
+            live[index] = live.back();
+            live.pop_back();
+            result.Frees++;
+        }
+
+        if (live.size() > result.PeakCount)
+        { result.PeakCount = uint32_t(live.size()); }
+
+        if (op % validateInterval == 0)
+        {
+            if (!allocator.Validate())
+            {
+                fprintf(stderr, "Error : op %u : Validate() Failed.\n", op);
+                return false;
+            }
+
+            if (!shadow.Match(allocator, &reason))
+            {
+                fprintf(stderr, "Error : op %u : %s.\n", op, reason);
+                return false;
+            }
+
+            auto fragmentation = allocator.GetStats().Fragmentation;
+            if (fragmentation > result.MaxFragmentation)
+            { result.MaxFragmentation = fragmentation; }
+        }
+    }
+
+    // 全て解放すれば1つの空きブロックに戻る.
+    for (auto& allocation : live)
+    {
+        allocator.Free(allocation);
+        shadow.Remove(allocation);
+    }
+
+    auto stats = allocator.GetStats();
+    if (!allocator.Validate() || !allocator.IsEmpty() || stats.FreeBlockCount != 1 || stats.LargestFreeBlock != Capacity)
+    {
+        fprintf(stderr, "Error : Heap Not Coalesced After Freeing Everything.\n");
+        return false;
+    }
+
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+//      境界条件を確認します.
+//-----------------------------------------------------------------------------
+bool RunEdgeCases()
+{
+    TlsfAllocator allocator;
+    TlsfAllocator::Allocation allocation;
+
+    if (allocator.Init(Capacity, 3) || allocator.Init(100, 256))
+    {
+        fprintf(stderr, "Error : Init() Accepted Invalid Arguments.\n");
+        return false;
+    }
+
+    if (!allocator.Init(Capacity, Granularity))
+    { return false; }
+
+    if (allocator.Alloc(Capacity + 1, Granularity, allocation)
+     || allocator.Alloc(1024, 3 * Granularity, allocation))
+    {
+        fprintf(stderr, "Error : Alloc() Accepted Invalid Arguments.\n");
+        return false;
+    }
+
+    // 0バイトは最小単位, 容量ちょうどは1回だけ入る.
+    if (!allocator.Alloc(0, 1, allocation) || allocation.Size != Granularity)
+    {
+        fprintf(stderr, "Error : Zero Sized Alloc() Failed.\n");
+        return false;
+    }
+    allocator.Free(allocation);
+
+    TlsfAllocator::Allocation whole;
+    if (!allocator.Alloc(Capacity, Granularity, whole) || whole.Offset != 0
+     || allocator.Alloc(1, 1, allocation) || !allocator.Validate())
+    {
+        fprintf(stderr, "Error : Full Capacity Alloc() Failed.\n");
+        return false;
+    }
+    allocator.Free(whole);
+
+    // 最大アライメントを要求すると先頭の詰め物は空きブロックとして残り, 解放で結合される.
+    TlsfAllocator::Allocation small;
+    TlsfAllocator::Allocation aligned;
+    if (!allocator.Alloc(Granularity, Granularity, small)
+     || !allocator.Alloc(1024, 1ull << MaxAlignmentShift, aligned)
+     || aligned.Offset % (1ull << MaxAlignmentShift) != 0
+     || allocator.GetStats().FreeBlockCount != 2
+     || !allocator.Validate())
+    {
+        fprintf(stderr, "Error : Aligned Alloc() Failed.\n");
+        return false;
+    }
+
+    allocator.Free(small);
+    allocator.Free(aligned);
+
+    // Reset() は確保中のブロックごと破棄する.
+    allocator.Alloc(4096, Granularity, allocation);
+    allocator.Reset();
+    if (!allocator.IsEmpty() || allocator.GetStats().FreeBlockCount != 1 || !allocator.Validate())
+    {
+        fprintf(stderr, "Error : Reset() Failed.\n");
+        return false;
+    }
+
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+//      使い方を表示します.
+//-----------------------------------------------------------------------------
+void PrintUsage()
+{
+    printf("Usage : TlsfStress [options]\n");
+    printf("    --ops <n>           random operations per seed (default %u)\n", DefaultOps);
+    printf("    --seed <n>          first seed (default %u)\n", DefaultSeed);
+    printf("    --seeds <n>         number of seeds (default 1)\n");
+    printf("    --validate <n>      run Validate() every n operations (default %u)\n", DefaultValidate);
+}
+
+} // namespace
+
+
+//-----------------------------------------------------------------------------
+//      メインエントリーポイントです.
+//-----------------------------------------------------------------------------
+int main(int argc, char** argv)
+{
+    auto ops       = DefaultOps;
+    auto seed      = DefaultSeed;
+    auto seedCount = 1u;
+    auto validate  = DefaultValidate;
+
+    for (auto i = 1; i < argc; ++i)
+    {
+        auto hasValue = (i + 1 < argc);
+        if (strcmp(argv[i], "--ops") == 0 && hasValue)
+        { ops = uint32_t(strtoul(argv[++i], nullptr, 10)); }
+        else if (strcmp(argv[i], "--seed") == 0 && hasValue)
+        { seed = uint32_t(strtoul(argv[++i], nullptr, 10)); }
+        else if (strcmp(argv[i], "--seeds") == 0 && hasValue)
+        { seedCount = uint32_t(strtoul(argv[++i], nullptr, 10)); }
+        else if (strcmp(argv[i], "--validate") == 0 && hasValue)
+        { validate = uint32_t(strtoul(argv[++i], nullptr, 10)); }
+        else
+        {
+            PrintUsage();
+            return -1;
+        }
+    }
+
+    if (ops == 0 || seedCount == 0 || validate == 0)
+    {
+        PrintUsage();
+        return -1;
+    }
+
+    if (!RunEdgeCases())
+    { return -1; }
+
+    printf("edge cases : ok\n");
+    printf("%8s %10s %10s %10s %8s %10s\n", "seed", "allocs", "failures", "frees", "peak", "max frag");
+
+    for (auto s = seed; s < seed + seedCount; ++s)
+    {
+        Result result;
+        if (!RunRandom(ops, s, validate, result))
+        {
+            fprintf(stderr, "Error : Stress Failed. seed = %u\n", s);
+            return -1;
+        }
+
+        printf("%8u %10u %10u %10u %8u %9.1f%%\n",
+            s, result.Allocs, result.Failures, result.Frees, result.PeakCount, result.MaxFragmentation * 100.0f);
+    }
+
+    return 0;
+}
@@ -0,0 +1,388 @@
+﻿//-----------------------------------------------------------------------------
+// File : main.cpp
+// Desc : CPU Tonemapper SSE vs Scalar Test Entry Point.
+// Copyright(c) Pocol. All right reserved.
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------
+#include "TonemapCPU.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+#include <vector>
+
+
+namespace {
+
+//-----------------------------------------------------------------------------
+// Constant Values.
+//-----------------------------------------------------------------------------
+constexpr float     Tolerance       = 2.5e-5f;  // SSE版と参照実装の許容誤差.
+constexpr float     MaxHalf         = 65504.0f; // 半精度浮動小数の最大値.
+constexpr uint32_t  SweepCount      = 4099;     // 掃引するピクセル数(4の倍数にしない).
+constexpr uint32_t  BenchWidth      = 1920;     // 計測用の画像の横幅.
+constexpr uint32_t  BenchHeight     = 1080;     // 計測用の画像の縦幅.
+constexpr uint32_t  BenchRepeat     = 5;        // 計測の繰り返し回数(最速を採る).
+
+uint32_t g_FailCount = 0;   // 失敗した確認の数.
+
+//-----------------------------------------------------------------------------
+//      確認結果を表示します.
+//-----------------------------------------------------------------------------
+void Check(bool condition, const char* name)
+{
+    printf("[%s] %s\n", condition ? "PASS" : "FAIL", name);
+    if (!condition)
+    { g_FailCount++; }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Timer class
+///////////////////////////////////////////////////////////////////////////////
+class Timer
+{
+public:
+    Timer()
+    : m_Begin(std::chrono::steady_clock::now())
+    { /* DO_NOTHING */ }
+
+    double GetElapsedMs() const
+    { return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - m_Begin).count(); }
+
+private:
+    std::chrono::steady_clock::time_point m_Begin;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// Setting structure
+///////////////////////////////////////////////////////////////////////////////
+struct Setting
+{
+    const char*     Name;           //!< 表示名です.
+    float           BaseLuminance;  //!< 基準輝度値[nit]です.
+    float           MaxLuminance;   //!< 最大輝度値[nit]です.
+    float           Exposure;       //!< 露光です.
+};
+
+const Setting g_Settings[] = {
+    { "sdr",        100.0f,  100.0f, 1.0f },
+    { "hdr1000",    100.0f, 1000.0f, 1.0f },
+    { "hdr4000",     80.0f, 4000.0f, 2.5f },
+};
+
+const char* g_TypeNames [] = { "none", "reinhard", "gt" };
+const char* g_SpaceNames[] = { "bt709", "pq" };
+
+//-----------------------------------------------------------------------------
+//      掃引用の入力を作成します.
+//-----------------------------------------------------------------------------
+std::vector<float> CreateSweep()
+{
+    // 各チャンネルを 2^-20 ~ 65504 の対数間隔で, 位相をずらして掃引する.
+    std::vector<float> result(size_t(SweepCount) * 4);
+    for (auto i = 0u; i < SweepCount; ++i)
+    {
+        auto t = float(i) / float(SweepCount - 1);
+        for (auto ch = 0u; ch < 3; ++ch)
+        {
+            auto phase = std::fmod(t + float(ch) * 0.37f, 1.0f);
+            result[i * 4 + ch] = std::exp2(-20.0f + phase * (std::log2(MaxHalf) + 20.0f));
+        }
+        result[i * 4 + 3] = t;
+    }
+
+    // 境界付近の値も含める.
+    const float edges[] = { 0.0f, 1e-30f, 0.22f, 0.5f, 1.0f, 1.5f, 10.0f, 100.0f, 1000.0f, 4096.0f, MaxHalf };
+    for (size_t i = 0; i < sizeof(edges) / sizeof(edges[0]); ++i)
+    {
+        auto index = i * 7 + 1;
+        result[index * 4 + 0] = edges[i];
+        result[index * 4 + 1] = edges[(i + 3) % 11];
+        result[index * 4 + 2] = edges[(i + 7) % 11];
+    }
+
+    return result;
+}
+
+//-----------------------------------------------------------------------------
+//      参照実装で変換します.
+//-----------------------------------------------------------------------------
+void TonemapReference(const TonemapParam& param, const float* pSrc, float* pDst, size_t count, float exposure)
+{
+    for (size_t i = 0; i < count; ++i)
+    { TonemapPixel(param, pSrc + i * 4, pDst + i * 4, exposure); }
+}
+
+//-----------------------------------------------------------------------------
+//      RGBの最大誤差を求めます. 非有限値があれば無限大を返します.
+//-----------------------------------------------------------------------------
+float MaxError(const std::vector<float>& a, const std::vector<float>& b)
+{
+    auto result = 0.0f;
+    for (size_t i = 0; i < a.size(); ++i)
+    {
+        if ((i & 3) == 3)
+        { continue; }
+        if (!std::isfinite(a[i]) || !std::isfinite(b[i]))
+        { return std::numeric_limits<float>::infinity(); }
+        result = std::max(result, std::fabs(a[i] - b[i]));
+    }
+    return result;
+}
+
+//-----------------------------------------------------------------------------
+//      アルファがそのまま出力されているかチェックします.
+//-----------------------------------------------------------------------------
+bool IsAlphaPassed(const std::vector<float>& src, const std::vector<float>& dst)
+{
+    for (size_t i = 3; i < src.size(); i += 4)
+    {
+        if (memcmp(&src[i], &dst[i], sizeof(float)) != 0)
+        { return false; }
+    }
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+//      全ての組み合わせで SSE 版と参照実装を比較します.
+//-----------------------------------------------------------------------------
+void TestAccuracy()
+{
+    auto src = CreateSweep();
+    std::vector<float> ref(src.size());
+    std::vector<float> fast(src.size());
+
+    // 奇数幅の画像にしてタイルごとの端数も通す.
+    FloatImage image;
+    image.Width  = 257;
+    image.Height = SweepCount / 257;
+    image.Pixels.assign(src.begin(), src.begin() + size_t(image.Width) * image.Height * 4);
+    std::vector<float> refImage(image.Pixels.size());
+
+    printf("%-10s %-9s %-6s %12s %12s\n", "setting", "type", "space", "pixels err", "image err");
+
+    auto worst = 0.0f;
+    auto allPassed = true;
+    auto alphaPassed = true;
+    for (auto& setting : g_Settings)
+    {
+        for (auto type = 0; type < 3; ++type)
+        {
+            for (auto space = 0; space < 2; ++space)
+            {
+                TonemapParam param = { type, space, setting.BaseLuminance, setting.MaxLuminance };
+
+                TonemapReference(param, src.data(), ref.data(), SweepCount, setting.Exposure);
+                TonemapPixels   (param, src.data(), fast.data(), SweepCount, setting.Exposure);
+                auto pixelsError = MaxError(ref, fast);
+
+                FloatImage result;
+                TonemapImage(image, param, result, 3, setting.Exposure);
+                TonemapReference(param, image.Pixels.data(), refImage.data(), size_t(image.Width) * image.Height, setting.Exposure);
+                auto imageError = MaxError(refImage, result.Pixels);
+
+                printf("%-10s %-9s %-6s %12.3e %12.3e\n", setting.Name, g_TypeNames[type], g_SpaceNames[space], pixelsError, imageError);
+
+                worst       = std::max(worst, std::max(pixelsError, imageError));
+                allPassed   = allPassed && pixelsError <= Tolerance && imageError <= Tolerance;
+                alphaPassed = alphaPassed && IsAlphaPassed(src, fast) && IsAlphaPassed(image.Pixels, result.Pixels);
+            }
+        }
+    }
+
+    printf("worst error = %.3e (tolerance %.1e)\n", worst, Tolerance);
+    Check(allPassed,   "TonemapPixels/TonemapImage match TonemapPixel for every type x color space");
+    Check(alphaPassed, "alpha is passed through bit-exact");
+
+    // 入出力が同じバッファでも結果は変わらない.
+    {
+        TonemapParam param = { TONEMAP_GT, COLOR_SPACE_BT2100_PQ, 100.0f, 1000.0f };
+        auto inplace = src;
+        TonemapPixels(param, src.data(),     fast.data(),    SweepCount);
+        TonemapPixels(param, inplace.data(), inplace.data(), SweepCount);
+        Check(memcmp(inplace.data(), fast.data(), fast.size() * sizeof(float)) == 0, "in-place conversion matches out-of-place");
+    }
+
+    // 不正な入力.
+    {
+        TonemapParam param = { TONEMAP_REINHARD, COLOR_SPACE_BT709, 100.0f, 1000.0f };
+        FloatImage empty;
+        FloatImage result;
+        FloatImage shortImage;
+        shortImage.Width  = 4;
+        shortImage.Height = 4;
+        shortImage.Pixels.resize(4 * 4 * 4 - 1);
+        TonemapParam zero = { TONEMAP_REINHARD, COLOR_SPACE_BT709, 0.0f, 1000.0f };
+        Check(!TonemapImage(empty, param, result) && !TonemapImage(shortImage, param, result) && !TonemapImage(image, zero, result),
+            "empty, short or zero-luminance input is rejected");
+    }
+}
+
+//-----------------------------------------------------------------------------
+//      非有限値と最大値の入力を確認します.
+//-----------------------------------------------------------------------------
+void TestSpecialValues()
+{
+    auto nan  = std::numeric_limits<float>::quiet_NaN();
+    auto inf  = std::numeric_limits<float>::infinity();
+
+    // 1ピクセルごとの入力. 5ピクセルにして SSE と端数の両方を通す.
+    const float inputs[][4] = {
+        { nan,      nan,      nan,      1.0f },
+        { inf,      inf,      inf,      1.0f },
+        { -inf,     -1.0f,    -0.0f,    1.0f },
+        { MaxHalf,  MaxHalf,  MaxHalf,  1.0f },
+        { 1e30f,    nan,      inf,      1.0f },
+    };
+    const float expectAs[][3] = {
+        { 0.0f,     0.0f,     0.0f     },
+        { MaxHalf,  MaxHalf,  MaxHalf  },
+        { 0.0f,     0.0f,     0.0f     },
+        { MaxHalf,  MaxHalf,  MaxHalf  },
+        { MaxHalf,  0.0f,     MaxHalf  },
+    };
+    constexpr uint32_t Count = 5;
+
+    // SSE 経路は 4 ピクセル単位なので, 同じ入力を先頭と末尾に置いた 8 ピクセルでも確認する.
+    std::vector<float> src;
+    std::vector<float> expect;
+    for (auto pass = 0; pass < 2; ++pass)
+    {
+        for (auto i = 0u; i < Count; ++i)
+        {
+            src.insert(src.end(), inputs[i], inputs[i] + 4);
+            expect.insert(expect.end(), { expectAs[i][0], expectAs[i][1], expectAs[i][2], 1.0f });
+        }
+    }
+    auto count = src.size() / 4;
+
+    auto finite   = true;
+    auto inRange  = true;
+    auto clamped  = true;
+    for (auto& setting : g_Settings)
+    {
+        for (auto type = 0; type < 3; ++type)
+        {
+            for (auto space = 0; space < 2; ++space)
+            {
+                TonemapParam param = { type, space, setting.BaseLuminance, setting.MaxLuminance };
+
+                std::vector<float> ref(src.size());
+                std::vector<float> fast(src.size());
+                std::vector<float> clampRef(src.size());
+                TonemapReference(param, src.data(),    ref.data(),      count, 1.0f);
+                TonemapPixels   (param, src.data(),    fast.data(),     count, 1.0f);
+                TonemapReference(param, expect.data(), clampRef.data(), count, 1.0f);
+
+                for (size_t i = 0; i < src.size(); ++i)
+                {
+                    if ((i & 3) == 3)
+                    { continue; }
+
+                    finite  = finite && std::isfinite(ref[i]) && std::isfinite(fast[i]);
+                    // PQ は 10000[nit] を超えると 1 を超える(シェーダと同じく UNORM への書き込みで飽和する).
+                    auto upper = (space == COLOR_SPACE_BT709) ? 1.0f : std::numeric_limits<float>::max();
+                    inRange = inRange && ref[i] >= 0.0f && ref[i] <= upper && fast[i] >= 0.0f && fast[i] <= upper;
+                    clamped = clamped && std::fabs(ref[i] - clampRef[i]) <= Tolerance && std::fabs(fast[i] - clampRef[i]) <= Tolerance;
+                }
+            }
+        }
+    }
+
+    Check(finite,  "NaN/inf/65504 inputs give finite output (scalar and SSE)");
+    Check(inRange, "NaN/inf/65504 inputs give non-negative output, BT.709 within [0, 1]");
+    Check(clamped, "NaN and -inf map to 0, +inf and 1e30 map to 65504");
+}
+
+//-----------------------------------------------------------------------------
+//      変換速度を計測します.
+//-----------------------------------------------------------------------------
+void Benchmark()
+{
+    FloatImage image;
+    image.Width  = BenchWidth;
+    image.Height = BenchHeight;
+    image.Pixels.resize(size_t(BenchWidth) * BenchHeight * 4);
+
+    // 乱数の代わりに決定的な疑似乱数で 0 ~ 64 の HDR 値を作る.
+    uint32_t state = 0x12345678u;
+    for (auto& value : image.Pixels)
+    {
+        state = state * 1664525u + 1013904223u;
+        value = float(state >> 8) / float(1u << 24) * 64.0f;
+    }
+
+    auto pixelCount = double(BenchWidth) * BenchHeight;
+    TonemapParam param = { TONEMAP_GT, COLOR_SPACE_BT2100_PQ, 100.0f, 1000.0f };
+    FloatImage result;
+    result.Width  = BenchWidth;
+    result.Height = BenchHeight;
+    result.Pixels.resize(image.Pixels.size());
+
+    auto scalarMs = 1e30;
+    auto sseMs    = 1e30;
+    auto imageMs  = 1e30;
+    for (auto i = 0u; i < BenchRepeat; ++i)
+    {
+        {
+            Timer timer;
+            TonemapReference(param, image.Pixels.data(), result.Pixels.data(), size_t(pixelCount), 1.0f);
+            scalarMs = std::min(scalarMs, timer.GetElapsedMs());
+        }
+        {
+            Timer timer;
+            TonemapPixels(param, image.Pixels.data(), result.Pixels.data(), size_t(pixelCount));
+            sseMs = std::min(sseMs, timer.GetElapsedMs());
+        }
+        {
+            Timer timer;
+            TonemapImage(image, param, result);
+            imageMs = std::min(imageMs, timer.GetElapsedMs());
+        }
+    }
+
+    printf("\n%ux%u RGBA32F, GT + PQ, best of %u\n", BenchWidth, BenchHeight, BenchRepeat);
+    printf("%-22s %10s %10s %8s\n", "method", "ms", "MP/s", "speedup");
+    printf("%-22s %10.2f %10.1f %7.2fx\n", "TonemapPixel (scalar)", scalarMs, pixelCount / scalarMs * 1e-3, 1.0);
+    printf("%-22s %10.2f %10.1f %7.2fx\n", "TonemapPixels (SSE)",   sseMs,    pixelCount / sseMs    * 1e-3, scalarMs / sseMs);
+    printf("%-22s %10.2f %10.1f %7.2fx\n", "TonemapImage (MT)",     imageMs,  pixelCount / imageMs  * 1e-3, scalarMs / imageMs);
+}
+
+//-----------------------------------------------------------------------------
+//      使用方法を表示します.
+//-----------------------------------------------------------------------------
+void PrintUsage()
+{ printf("Usage : TonemapTest\n"); }
+
+} // namespace
+
+
+//-----------------------------------------------------------------------------
+//      メインエントリーポイントです.
+//-----------------------------------------------------------------------------
+int main(int argc, char** argv)
+{
+    if (argc > 1)
+    {
+        PrintUsage();
+        return (strcmp(argv[1], "--help") == 0) ? 0 : -1;
+    }
+
+    TestAccuracy();
+    TestSpecialValues();
+    Benchmark();
+
+    if (g_FailCount > 0)
+    {
+        fprintf(stderr, "Error : %u check(s) failed.\n", g_FailCount);
+        return -1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,282 @@
+﻿//-----------------------------------------------------------------------------
+// File : main.cpp
+// Desc : Virtual File System Lookup Benchmark Entry Point.
+// Copyright(c) Pocol. All right reserved.
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------
+#include "VirtualFileSystem.h"
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+
+namespace {
+
+//-----------------------------------------------------------------------------
+// Constant Values.
+//-----------------------------------------------------------------------------
+constexpr uint32_t      DefaultCount        = 10000;            // 既定のアセット数.
+constexpr uint32_t      DefaultRepeat       = 3;                // 既定の計測回数.
+constexpr uint32_t      RootCount           = 8;                // 検索パスの数(SearchFilePath と同じ).
+constexpr uint32_t      FilesPerDirectory   = 100;              // 1ディレクトリあたりのアセット数.
+constexpr const char*   DefaultDirectory    = "VfsBench_assets";
+
+///////////////////////////////////////////////////////////////////////////////
+// Timer class
+///////////////////////////////////////////////////////////////////////////////
+class Timer
+{
+public:
+    Timer()
+    : m_Begin(std::chrono::steady_clock::now())
+    { /* DO_NOTHING */ }
+
+    double GetElapsedMs() const
+    { return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - m_Begin).count(); }
+
+private:
+    std::chrono::steady_clock::time_point m_Begin;
+};
+
+//-----------------------------------------------------------------------------
+//      アセットの相対パスを生成します.
+//-----------------------------------------------------------------------------
+std::string MakeAssetName(uint32_t index, bool exists)
+{
+    char name[128];
+    sprintf(name, "texture/d%03u/%s_%05u.dds", index / FilesPerDirectory, exists ? "asset" : "missing", index);
+    return name;
+}
+
+//-----------------------------------------------------------------------------
+//      検索パスとアセットを生成します.
+//-----------------------------------------------------------------------------
+bool CreateAssets(const std::filesystem::path& dir, uint32_t count, std::vector<std::filesystem::path>& roots)
+{
+    std::error_code ec;
+    std::filesystem::remove_all(dir, ec);
+
+    // SearchFilePath の検索順に相当する検索パス. アセットは均等に振り分ける.
+    roots.clear();
+    for (auto i = 0u; i < RootCount; ++i)
+    {
+        roots.push_back(dir / ("root" + std::to_string(i)));
+        std::filesystem::create_directories(roots.back(), ec);
+        if (ec)
+        { return false; }
+    }
+
+    for (auto i = 0u; i < count; ++i)
+    {
+        auto path = roots[i % RootCount] / std::filesystem::u8path(MakeAssetName(i, true));
+        std::filesystem::create_directories(path.parent_path(), ec);
+
+        std::ofstream stream(path, std::ios::binary);
+        if (!stream)
+        { return false; }
+    }
+
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+//      従来の SearchFilePath と同じく検索パスを順に確かめます.
+//-----------------------------------------------------------------------------
+bool Probe(const std::vector<std::filesystem::path>& roots, const std::string& name, std::filesystem::path& result)
+{
+    std::error_code ec;
+    for (auto& root : roots)
+    {
+        auto path = root / std::filesystem::u8path(name);
+        if (std::filesystem::exists(path, ec))
+        {
+            result = path;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+//-----------------------------------------------------------------------------
+//      比較用にパスを正規化します.
+//-----------------------------------------------------------------------------
+std::string Normalize(const std::filesystem::path& path)
+{ return std::filesystem::absolute(path).lexically_normal().generic_u8string(); }
+
+//-----------------------------------------------------------------------------
+//      使い方を表示します.
+//-----------------------------------------------------------------------------
+void PrintUsage()
+{
+    printf("Usage : VfsBench [options]\n");
+    printf("    --count <n>         number of assets (default %u)\n", DefaultCount);
+    printf("    --repeat <n>        lookup passes per method (default %u)\n", DefaultRepeat);
+    printf("    --dir <path>        scratch directory (default %s)\n", DefaultDirectory);
+    printf("    --keep              keep the scratch directory\n");
+}
+
+} // namespace
+
+
+//-----------------------------------------------------------------------------
+//      メインエントリーポイントです.
+//-----------------------------------------------------------------------------
+int main(int argc, char** argv)
+{
+    auto        count   = DefaultCount;
+    auto        repeat  = DefaultRepeat;
+    std::string dir     = DefaultDirectory;
+    auto        keep    = false;
+
+    for (auto i = 1; i < argc; ++i)
+    {
+        auto hasValue = (i + 1 < argc);
+        if (strcmp(argv[i], "--count") == 0 && hasValue)
+        { count = uint32_t(strtoul(argv[++i], nullptr, 10)); }
+        else if (strcmp(argv[i], "--repeat") == 0 && hasValue)
+        { repeat = uint32_t(strtoul(argv[++i], nullptr, 10)); }
+        else if (strcmp(argv[i], "--dir") == 0 && hasValue)
+        { dir = argv[++i]; }
+        else if (strcmp(argv[i], "--keep") == 0)
+        { keep = true; }
+        else
+        {
+            PrintUsage();
+            return -1;
+        }
+    }
+
+    if (count == 0 || repeat == 0 || count > VirtualFileSystem::MaxFilesPerMount)
+    {
+        PrintUsage();
+        return -1;
+    }
+
+    std::vector<std::filesystem::path> roots;
+    if (!CreateAssets(dir, count, roots))
+    {
+        fprintf(stderr, "Error : Asset Create Failed. dir = %s\n", dir.c_str());
+        return -1;
+    }
+
+    std::vector<std::string> hits;
+    std::vector<std::string> misses;
+    for (auto i = 0u; i < count; ++i)
+    {
+        hits  .push_back(MakeAssetName(i, true));
+        misses.push_back(MakeAssetName(i, false));
+    }
+
+    // 索引を作る(起動時に1回).
+    VirtualFileSystem vfs;
+    double mountMs = 0.0;
+    {
+        Timer timer;
+        for (auto& root : roots)
+        { vfs.Mount(root); }
+        mountMs = timer.GetElapsedMs();
+    }
+
+    // 両方の方法で同じファイルに解決されることを確かめる.
+    auto mismatch = 0u;
+    for (auto& name : hits)
+    {
+        std::filesystem::path probed;
+        std::string           resolved;
+        if (!Probe(roots, name, probed) || !vfs.Resolve(name.c_str(), resolved)
+         || Normalize(probed) != Normalize(std::filesystem::u8path(resolved)))
+        { mismatch++; }
+
+        // 正規化が必要な書き方でも同じファイルに解決される.
+        std::string dotted;
+        if (!vfs.Resolve(("./" + name).c_str(), dotted) || dotted != resolved)
+        { mismatch++; }
+    }
+
+    for (auto& name : misses)
+    {
+        std::string resolved;
+        if (vfs.Resolve(name.c_str(), resolved))
+        { mismatch++; }
+    }
+
+    if (mismatch > 0)
+    {
+        fprintf(stderr, "Error : Lookup Mismatch. count = %u\n", mismatch);
+        return -1;
+    }
+
+    // 計測.
+    double probeHitMs  = 0.0;
+    double probeMissMs = 0.0;
+    double vfsHitMs    = 0.0;
+    double vfsMissMs   = 0.0;
+    auto   found       = 0u;
+
+    for (auto r = 0u; r < repeat; ++r)
+    {
+        std::filesystem::path probed;
+        std::string           resolved;
+
+        {
+            Timer timer;
+            for (auto& name : hits)
+            { found += Probe(roots, name, probed) ? 1 : 0; }
+            probeHitMs += timer.GetElapsedMs();
+        }
+        {
+            Timer timer;
+            for (auto& name : misses)
+            { found += Probe(roots, name, probed) ? 1 : 0; }
+            probeMissMs += timer.GetElapsedMs();
+        }
+        {
+            Timer timer;
+            for (auto& name : hits)
+            { found += vfs.Resolve(name.c_str(), resolved) ? 1 : 0; }
+            vfsHitMs += timer.GetElapsedMs();
+        }
+        {
+            Timer timer;
+            for (auto& name : misses)
+            { found += vfs.Resolve(name.c_str(), resolved) ? 1 : 0; }
+            vfsMissMs += timer.GetElapsedMs();
+        }
+    }
+
+    auto lookups = double(count) * double(repeat);
+    printf("assets : %u, roots : %u, indexed files : %zu\n", count, RootCount, vfs.GetFileCount());
+    printf("mount (scan once)  : %10.2f ms\n", mountMs);
+    printf("%-8s %16s %16s %10s\n", "method", "hit[us/lookup]", "miss[us/lookup]", "speedup");
+    printf("%-8s %16.3f %16.3f %10s\n", "probe",
+        probeHitMs * 1000.0 / lookups, probeMissMs * 1000.0 / lookups, "");
+    printf("%-8s %16.3f %16.3f %9.1fx\n", "vfs",
+        vfsHitMs * 1000.0 / lookups, vfsMissMs * 1000.0 / lookups,
+        (probeHitMs + probeMissMs) / (vfsHitMs + vfsMissMs));
+    printf("break-even lookups : %.0f\n",
+        mountMs / ((probeHitMs - vfsHitMs) / lookups));
+
+    if (found != count * repeat * 2)
+    {
+        fprintf(stderr, "Error : Unexpected Lookup Result. found = %u\n", found);
+        return -1;
+    }
+
+    if (!keep)
+    {
+        std::error_code ec;
+        std::filesystem::remove_all(dir, ec);
+    }
+
+    return 0;
+}